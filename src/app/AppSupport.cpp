@@ -56,6 +56,15 @@ void AppSupport::handleInput(InputState& inputState)
             fpPositioner.setUpVector(glm::vec3(0.0f, 1.0f, 0.0f));
             //hmdPositioner->movement.backward_ = press;
         }
+        if (key == GLFW_KEY_F5 && action == GLFW_RELEASE) {
+            toggleCameraRecording();
+        }
+        if (key == GLFW_KEY_F6 && action == GLFW_RELEASE) {
+            startCameraPlayback(CameraPlaybackMode::RecordedSteps);
+        }
+        if (key == GLFW_KEY_F7 && action == GLFW_RELEASE) {
+            startCameraPlayback(CameraPlaybackMode::FixedStep);
+        }
         if (key == GLFW_KEY_F && action == GLFW_RELEASE) {
             if (fpPositioner.isModeFlying()) {
                 fpPositioner.setModeWalking();
@@ -69,3 +78,42 @@ void AppSupport::handleInput(InputState& inputState)
         }
     }
 }
+
+void AppSupport::toggleCameraRecording()
+{
+    if (cameraPlayback.isPlaying()) return;
+    if (!cameraRecording) {
+        cameraRecorder.clear();
+        cameraRecording = true;
+        Log("Camera recording started" << endl);
+    } else {
+        cameraRecording = false;
+        cameraRecorder.save(CAMERA_RECORDING_FILE);
+    }
+}
+
+bool AppSupport::startCameraPlayback(CameraPlaybackMode mode, double fixedDeltaSeconds)
+{
+    if (cameraRecording || activePositionerIsHMD) return false;
+    if (!cameraPlayback.load(CAMERA_RECORDING_FILE)) return false;
+    cameraPlayback.start(mode, fixedDeltaSeconds);
+    Log("Camera playback started: " << cameraPlayback.getFrames().size() << " frames, " << cameraPlayback.getDuration() << " s" << endl);
+    return true;
+}
+
+void AppSupport::updateCameraPlayback()
+{
+    // real time of the frame played by the previous step
+    if (cameraPlayback.getStepCount() > 0) {
+        cameraPlayback.addFrameTime(app_engine->gameTime.getRealTimeDelta() * 1000.0);
+    }
+    double stepSeconds;
+    if (cameraPlayback.step(fpPositioner, stepSeconds)) {
+        // next frame advances game time by the recorded (or fixed) step, so animations replay like the recording
+        app_engine->gameTime.setFixedDelta(stepSeconds);
+    } else {
+        app_engine->gameTime.setFixedDelta(0.0);
+        cameraPlayback.getStats().log();
+        cameraPlayback.writeTimings(CAMERA_TIMINGS_FILE);
+    }
+}
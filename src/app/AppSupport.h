@@ -27,6 +27,12 @@ protected:
     InputState input;
     World world;
     bool activePositionerIsHMD = false;
+    // camera session recording (F5 start/stop) and replay (F6 recorded steps, F7 fixed 60 Hz steps)
+    inline static const std::string CAMERA_RECORDING_FILE = "camera_recording.sprec";
+    inline static const std::string CAMERA_TIMINGS_FILE = "camera_timings.csv";
+    CameraRecorder cameraRecorder;
+    CameraPlayback cameraPlayback;
+    bool cameraRecording = false;
 
     void createFirstPersonCameraPositioner(const glm::vec3& pos, const glm::vec3& target, const glm::vec3& up) {
         fpPositioner.init(app_engine, pos, target, up);
@@ -72,12 +78,23 @@ protected:
     void updateCameraPositioners(double deltaSeconds) {
         if (activePositionerIsHMD) {
             hmdPositioner.updateDeltaSeconds(deltaSeconds);
+        } else if (cameraPlayback.isPlaying()) {
+            updateCameraPlayback();
         } else {
             bool followRightMousebutton = input.pressedRight || input.stillPressedRight;
             fpPositioner.update(deltaSeconds, input.pos, followRightMousebutton, firstPersonCameraAlwayUpright);
+            if (cameraRecording) {
+                cameraRecorder.record(fpPositioner, deltaSeconds, input.pos);
+            }
         }
     }
 
+    void toggleCameraRecording();
+    // replay CAMERA_RECORDING_FILE on the first person camera, returns false if there is no valid recording
+    bool startCameraPlayback(CameraPlaybackMode mode, double fixedDeltaSeconds = 1.0 / 60.0);
+    // step playback, measure previous frame. Logs and writes timings at end of recording
+    void updateCameraPlayback();
+
 	// provide input handling for regular first person and HMD cameras
     void handleInput(InputState& inputState);
     void applyViewProjection(glm::mat4& view1, glm::mat4& proj1, glm::mat4& view2, glm::mat4& proj2, glm::vec3* camPos1 = nullptr, glm::vec3* camPos2 = nullptr) {
@@ -140,6 +157,40 @@ protected:
         app_engine->eventLoop();
     }
 
+    // CPU LOD selection for all objects without GPU LOD, call after all objects were added
+    void initLodSelection() {
+        float fovy, aspect, nearz, farz;
+        camera->getProjectionParams(fovy, aspect, nearz, farz);
+        app_engine->lodSelection.setViewport(fovy, static_cast<float>(app_engine->getBackBufferExtent().height));
+        app_engine->lodSelection.registerWorldObjects();
+    }
+    // select LOD of registered objects for this frame, returns true if dynamic model UBOs were changed
+    bool updateLodSelection(FrameResources& tr) {
+        if (app_engine->lodSelection.size() == 0) return false;
+        app_engine->lodSelection.updatePerFrame(tr, camera->getPosition());
+        return true;
+    }
+
+    // advance skeletal animations and write joint palettes, returns true if dynamic model UBOs were changed
+    bool updateAnimation(FrameResources& tr, double deltaSeconds) {
+        if (app_engine->animation.size() == 0) return false;
+        app_engine->animation.updatePerFrame(tr, static_cast<float>(deltaSeconds));
+        return true;
+    }
+
+    // frustum culling, then occlusion culling against the registered occluders, for all objects of the object store.
+    // Call after object transforms of this frame were set, returns true if dynamic model UBOs were changed
+    bool updateCulling(FrameResources& tr) {
+        if (app_engine->objectStore.getComponents().size() == 0) return false;
+        glm::mat4 view1, proj1, view2, proj2;
+        applyViewProjection(view1, proj1, view2, proj2);
+        glm::mat4 viewProjLeft = proj1 * view1;
+        glm::mat4 viewProjRight = proj2 * view2;
+        app_engine->frustumCulling.updatePerFrame(tr, viewProjLeft, viewProjRight);
+        app_engine->occlusionCulling.updatePerFrame(tr, viewProjLeft, viewProjRight);
+        return true;
+    }
+
     void postUpdatePerFrame(FrameResources& tr) {
         //if (enableSound && app_engine->isDedicatedRenderUpdateThread(tr)) {
         //    engine->sound.Update(camera);
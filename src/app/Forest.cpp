@@ -49,6 +49,8 @@ void Forest::init() {
     engine->textureStore.generateBRDFLUT();
     engine->ui.setRenderFlags(UIRender_FPS | UIRender_CameraPosDir);
     engine->ui.setCameraForTracking(camera);
+    // camera position display does not need full frame rate
+    engine->ui.setUpdateRate(10.0);
 
     engine->objectStore.loadWorldCreatorInstances("forestv5_InstanceInfo.json");
     //engine->objectStore.loadWorldCreatorInstances("ObjectTest_InstanceInfo.json");
@@ -67,6 +69,8 @@ void Forest::init() {
     //object = engine->objectStore.addObject("group", "LogoBox", vec3(0.0f, 14.38f * 2.5f, 0.0f));
     object = engine->objectStore.addObject("group", "LogoBox", vec3(0.0f, 13.3f, 0.0f));
 
+    // vegetation and rocks are small and instanced many times: upload packed vertices, terrain above stays in full format
+    meshFlags.setFlag(MeshFlags::MESH_TYPE_PACKED_VERTICES);
     if (false) {
         engine->meshStore.loadMesh("Grass_C_lod_cmp.glb", "Grass_C", meshFlags);
         engine->meshStore.getMesh("Grass_C")->material.lod_category = LOD_CATEGORY_SMALL_GRASS;
@@ -115,7 +119,7 @@ void Forest::init() {
 
 
     //engine->meshStore.loadMesh("box1_cmp.glb", "Flora_1", meshFlags);
-    engine->objectStore.createGroup("flora");
+    GroupId floraGroup = engine->objectStore.createGroup("flora");
     auto wc = engine->objectStore.getWorldCreator();
     //string* limitBiomeName = new string("Acacia_A");
     string* limitBiomeName = nullptr;
@@ -125,7 +129,9 @@ void Forest::init() {
             continue;
         }
         // check if we have loaded this asset, skip otherwise:
-        MeshInfo* mesh = engine->meshStore.getMesh(biomeObject.Name);
+        // mesh id is resolved once per biome object, instances are added without string lookups
+        MeshId meshId = engine->meshStore.findMeshId(biomeObject.Name);
+        MeshInfo* mesh = engine->meshStore.getMesh(meshId);
         if (mesh == nullptr) {
             Log("WARNING: Skipping biome object " << wc->getPathInstanceName(biomeObject) << " as mesh not loaded" << endl);
             continue;
@@ -164,7 +170,7 @@ void Forest::init() {
                 float angle;
                 //MathHelper::getAxisAngleFromQuaternion(quatRotation, rotation, angle);
 
-                auto obj = engine->objectStore.addObject("flora", biomeObject.Name, pos);
+                auto obj = engine->objectStore.addObject(floraGroup, meshId, pos);
                 obj->rot() = rotation;
                 obj->useGpuLod = true;
 
@@ -237,6 +243,7 @@ void Forest::init() {
     ls.position = vec3(75.0f, 30.5f, -40.0f);
     engine->shaders.pbrShader.changeLightSource(ls.color, ls.position);
     engine->shaders.pbrShader.initialUpload();
+    initLodSelection();
 
     gatherUIDetails();
 
@@ -308,6 +315,7 @@ void Forest::prepareFrame(FrameResources* fr)
     engine->shaders.pbrShader.uploadToGPU(tr, pubo, pubo2);
 
     // we only need to update dynamic model UBOs for first few frames, afterwards they remain static
+    bool modelsChanged = tr.frameNum < 4;
     if (tr.frameNum < 4) {
         for (auto& wo : engine->objectStore.getSortedList()) {
             //Log(" adapt object " << obj.get()->objectNum << endl);
@@ -329,6 +337,12 @@ void Forest::prepareFrame(FrameResources* fr)
             if (wo->enableDebugGraphics) engine->meshStore.debugGraphics(wo, tr, modeltransform, true, false, false, false);
             engine->objectStore.stopWorking(tr, wo);
         }
+    }
+    if (updateAnimation(tr, deltaSeconds)) modelsChanged = true;
+    // objects without GPU LOD switch meshes on the CPU
+    if (updateLodSelection(tr)) modelsChanged = true;
+    if (updateCulling(tr)) modelsChanged = true;
+    if (modelsChanged) {
         engine->shaders.pbrShader.copyStagingDynamicUBO(tr);
     }
 
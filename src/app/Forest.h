@@ -19,6 +19,7 @@ public:
     bool shouldClose() override;
     void handleInput(InputState& inputState) override;
     void buildCustomUI() override;
+    size_t getCustomUIStateHash() override { return totalObjects; }
     void gatherUIDetails();
 private:
     World world;
@@ -28,10 +28,11 @@ void LandscapeDemo::run(ContinuationInfo* cont)
             .addShader(shaders.clearShader)
             .addShader(shaders.cubeShader)  // enable to render central cube with debug texture
             .addShader(shaders.billboardShader)
-            //.addShader(shaders.terrainShader)
+            .addShader(shaders.terrainShader)
             .addShader(shaders.lineShader)  // enable to see zero cross and billboard debug lines
             .addShader(shaders.pbrShader)
             ;
+        initTerrain();
         // init shaders, e.g. one-time uploads before rendering cycle starts go here
         shaders.initActiveShaders();
 
@@ -73,12 +74,51 @@ void LandscapeDemo::addRandomBillboards(vector<BillboardDef>& billboards, World
     }
 }
 
-void LandscapeDemo::init() {
+void LandscapeDemo::initTerrain() {
     // 2 square km world size
     world.setWorldSize(2048.0f, 382.0f, 2048.0f);
 
     //world.setWorldSize(10.0f, 382.0f, 10.0f);
 
+    heightmap.resetSize(1024 * 2 + 1);
+    // set height of three points at center
+    //heightmap.setHeight(4096, 4096, 0.0f);
+    //heightmap.setHeight(4095, 4096, 0.2f);
+    //heightmap.setHeight(4096, 4095, 0.3f);
+    int lastPos = 1024 * 2;
+    // down left and right corner
+    heightmap.setHeight(0, 0, 0.0f);
+    heightmap.setHeight(lastPos, 0, 300.0f);
+    // top left and right corner
+    heightmap.setHeight(0, lastPos, 10.0f);
+    heightmap.setHeight(lastPos, lastPos, 50.0f);
+    // do two iteration
+    heightmap.diamondSquare(200.0f, 0.5f);
+
+    // terrain LOD over the same heights. Heightmap row y is at world z = half world size - y (see Spatial2D::adaptLinesToWorld()),
+    // terrain rows start at min z
+    vector<vec3> points;
+    heightmap.getPoints(points);
+    int samples = lastPos + 1;
+    vector<float> heights(points.size());
+    for (auto& p : points) {
+        int x = static_cast<int>(p.x);
+        int z = lastPos - static_cast<int>(p.z);
+        heights[static_cast<size_t>(z) * samples + x] = p.y;
+    }
+    float fovy, aspect, nearz, farz;
+    camera->getProjectionParams(fovy, aspect, nearz, farz);
+    TerrainLodSettings settings;
+    settings.fovY = fovy;
+    settings.viewportHeight = static_cast<float>(engine->getBackBufferExtent().height);
+    settings.viewDistance = farz;
+    terrain.setEngine(engine);
+    float half = world.getWorldSize().x / 2.0f;
+    terrain.init(std::move(heights), samples, -half, half, settings);
+    engine->shaders.terrainShader.setTerrain(&terrain);
+}
+
+void LandscapeDemo::init() {
     engine->textureStore.loadTexture("heightbig.ktx2", "heightmap", TextureType::TEXTURE_TYPE_HEIGHT);
     //engine->textureStore.loadTexture("height.ktx2", "heightmap", TextureType::TEXTURE_TYPE_HEIGHT, TextureFlags::KEEP_DATA_BUFFER);
     // load skybox cube texture
@@ -124,20 +164,6 @@ void LandscapeDemo::init() {
     // Grid with 1m squares, floor on -10m, ceiling on 372m
     //Grid* grid = world.createWorldGrid(1.0f, 0.0f);
     //engine->shaders.lineShader.add(grid->lines);
-    Spatial2D heightmap(1024 * 2 + 1);
-    // set height of three points at center
-    //heightmap.setHeight(4096, 4096, 0.0f);
-    //heightmap.setHeight(4095, 4096, 0.2f);
-    //heightmap.setHeight(4096, 4095, 0.3f);
-    int lastPos = 1024 * 2;
-    // down left and right corner
-    heightmap.setHeight(0, 0, 0.0f);
-    heightmap.setHeight(lastPos, 0, 300.0f);
-    // top left and right corner
-    heightmap.setHeight(0, lastPos, 10.0f);
-    heightmap.setHeight(lastPos, lastPos, 50.0f);
-    // do two iteration
-    heightmap.diamondSquare(200.0f, 0.5f);
     vector<LineDef> lines;
     heightmap.getLines(lines);
     heightmap.adaptLinesToWorld(lines, world);
@@ -216,6 +242,27 @@ void LandscapeDemo::prepareFrame(FrameResources* fr)
     engine->shaders.billboardShader.uploadToGPU(tr, bubo, bubo2);
     //Util::printMatrix(bubo.proj);
 
+    // terrain: select chunks for camera, new chunks are copied by the upload commands of this frame
+    TerrainShader::UniformBufferObject tubo{};
+    TerrainShader::UniformBufferObject tubo2{};
+    tubo.model = glm::mat4(1.0f);
+    tubo2.model = glm::mat4(1.0f);
+    vec3 camPos;
+    applyViewProjection(tubo.view, tubo.proj, tubo2.view, tubo2.proj, &camPos);
+    Frustum frustum = Frustum::fromViewProjection(tubo.proj * tubo.view);
+    if (engine->isStereo()) {
+        frustum = Frustum::combine(frustum, Frustum::fromViewProjection(tubo2.proj * tubo2.view));
+    }
+    terrain.select(camPos, frustum);
+    terrain.updateChunks(fr);
+    engine->shaders.terrainShader.prepareDraw(tr);
+    engine->shaders.terrainShader.uploadToGPU(tr, tubo, tubo2);
+
+    // no PBR objects yet, culling starts working as soon as objects are added to the object store
+    if (updateCulling(tr)) {
+        engine->shaders.pbrShader.copyStagingDynamicUBO(tr);
+    }
+
     engine->shaders.clearShader.addCommandBuffers(fr, &fr->drawResults[0]); // put clear shader first
 }
 
@@ -227,6 +274,7 @@ void LandscapeDemo::drawFrame(FrameResources* fr, int topic, DrawResult* drawRes
         engine->shaders.cubeShader.addCommandBuffers(fr, drawResult);
     }
     else if (topic == 1) {
+        engine->shaders.terrainShader.addCommandBuffers(fr, drawResult);
         engine->shaders.billboardShader.addCommandBuffers(fr, drawResult);
     }
 }
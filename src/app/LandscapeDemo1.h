@@ -7,6 +7,8 @@ public:
     void run(ContinuationInfo* cont) override;
     // called from main thread
     void init();
+    // heightmap and terrain LOD, has to be done before shaders are initialized
+    void initTerrain();
     void mainThreadHook() override;
     // prepare drawing, guaranteed single thread
     void prepareFrame(FrameResources* fi) override;
@@ -22,7 +24,8 @@ public:
 private:
     void updatePerFrame(ThreadResources& tr);
     World world;
-    Spatial2D* heightmap = nullptr;
+    Spatial2D heightmap;
+    TerrainLod terrain;
     bool isSkybox = true; // set to false to have center cube instead of skybox
     bool shouldStopEngine = false;
 };
@@ -262,6 +262,14 @@ static void HelpMarker(const char* desc)
     }
 }
 
+size_t LandscapeGenerator::getCustomUIStateHash()
+{
+    size_t seed = lines.size();
+    hash_combine(seed, parameters.paramsChangedOutsideUI);
+    hash_combine(seed, std::hash<double>{}(ThemedTimer::getInstance()->getLatestTiming(TIMER_PART_GLOBAL_UPDATE)));
+    return seed;
+}
+
 void LandscapeGenerator::buildCustomUI()
 {
     if (parameters.paramsChangedOutsideUI) {
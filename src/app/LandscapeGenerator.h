@@ -21,6 +21,7 @@ public:
     void handleInput(InputState& inputState) override;
     void backgroundWork() override;
     void buildCustomUI() override;
+    size_t getCustomUIStateHash() override;
 private:
     CameraPositioner_AutoMove* autoMovePositioner;
     InputState input;
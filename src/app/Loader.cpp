@@ -292,6 +292,9 @@ void Loader::prepareFrame(FrameResources* fr)
         if (wo->enableDebugGraphics) engine->meshStore.debugGraphics(wo, tr, modeltransform, true, true, false, true);
         engine->objectStore.stopWorking(tr, wo);
     }
+    if (updateAnimation(tr, deltaSeconds)) {
+        engine->shaders.pbrShader.copyStagingDynamicUBO(tr);
+    }
     // lines
     engine->shaders.lineShader.prepareAddLines(tr);
     LineShader::UniformBufferObject lubo{};
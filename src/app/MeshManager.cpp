@@ -51,6 +51,33 @@ void MeshManager::run(ContinuationInfo* cont)
     Log("MeshManager ended" << endl);
 }
 
+int MeshManager::selectSimulatedLOD(glm::vec3 objPos)
+{
+    // objects are scaled to 1m cube diameter, see applySetupObjects
+    const float radius = 0.866f;
+    if (simLodSelection.size() == 0) {
+        uint32_t triangles[10] = {};
+        simLodSelection.addObject(objPos, radius, 10, triangles);
+        // the simulation shows the distance table as is: switch exactly at lod[i] like Util::calculateLODIndex()
+        simLodSelection.setHysteresis(0.0f);
+    }
+    simLodSelection.setObjectPosition(0, objPos);
+    float fovy, aspect, nearz, farz;
+    camera->getProjectionParams(fovy, aspect, nearz, farz);
+    float viewportHeight = static_cast<float>(engine->getBackBufferExtent().height);
+    simLodSelection.setViewport(fovy, viewportHeight);
+    // LOD i starts at distance lod[i]: the projected radius there is screen threshold i - 1
+    float pixelFactor = viewportHeight / (2.0f * tan(fovy / 2.0f));
+    vector<float> thresholds;
+    for (int i = 1; i < 10; i++) {
+        float t = radius * pixelFactor / std::max(lod[i], 0.001f);
+        thresholds.push_back(thresholds.empty() ? t : std::min(t, thresholds.back()));
+    }
+    simLodSelection.setScreenThresholds(thresholds);
+    simLodSelection.select(camera->getPosition());
+    return std::max(0, simLodSelection.getLod(0));
+}
+
 void MeshManager::init() {
     engine->sound.init(false);
 
@@ -268,7 +295,7 @@ void MeshManager::prepareFrame(FrameResources* fr)
             vec3 objPos = simObjects[0]->pos();
             //objPos.y = 0.0f; ???
             float dist = length(camPos - objPos);
-            int lodLevel = Util::calculateLODIndex(lod, dist);
+            int lodLevel = selectSimulatedLOD(objPos);
             //make object visible:
             for (int i = 0; i < 10; i++) {
                 simObjects[i]->enabled = false;
@@ -483,6 +510,13 @@ std::vector<std::string> getFilesMatchingPattern(const fs::path& folder, const s
     }
     return result;
 }
+size_t MeshManager::getCustomUIStateHash()
+{
+    size_t seed = engine->meshStore.getUsedMeshesCount();
+    hash_combine(seed, engine->meshStore.getUsedStorageSize());
+    return seed;
+}
+
 void MeshManager::buildCustomUI() {
     static bool showLineSelector = false;
     static int selectedLine = -1;
@@ -19,6 +19,7 @@ public:
     bool shouldClose() override;
     void handleInput(InputState& inputState) override;
     void buildCustomUI() override;
+    size_t getCustomUIStateHash() override;
 private:
     World world;
     WorldObject* object = nullptr; // current object which can be manipulated bu UI
@@ -62,6 +63,9 @@ private:
     float lodDistance = 0.0f; // distance for LOD simulation
     int simLODLevel = 0; // LOD level for simulation
     std::vector<WorldObject*> simObjects; // for simulating LOD
+    LodSelection simLodSelection; // LOD distances converted to screen thresholds of the 1m diameter LOD 0 object
+    // update simLodSelection thresholds from LOD distances and select for current camera position
+    int selectSimulatedLOD(glm::vec3 objPos);
     bool enableGpuLodObject = false;
     WorldObject* gpuLodObject = nullptr; // object used to test GPU LOD
 };
\ No newline at end of file
@@ -48,34 +48,44 @@ void Rocks::addRandomRocks(std::vector<WorldObject*>& rocks, World& world, MeshI
 
     unsigned long total_rocks = 10000;
     if (engine->isVR()) total_rocks /= 4; // reduce number of rocks for VR mode for performance reasons
+    float denseFactor = 8.0f;
+    if (engine->isVR()) denseFactor *= 2.0f; // reduce density for VR mode for performance reasons
+
+    // seeded Poisson disk scatter: same rocks on every run, no two rocks closer than 2m in xz
+    ScatterSettings settings;
+    settings.seed = 42;
+    settings.maxXZ = world.getWorldSize().x / 2.0f / denseFactor;
+    settings.minXZ = -settings.maxXZ;
+    ScatterLayer layer;
+    layer.radius = 2.0f;
+    vector<ScatterPoint> points;
+    PoissonScatter scatter;
+    scatter.generate(settings, { layer }, points, engine->getWorkerThreads());
+    if (points.size() > total_rocks) {
+        // thin out uniformly over the whole area: keep the points with the lowest random bits
+        nth_element(points.begin(), points.begin() + total_rocks, points.end(),
+            [](const ScatterPoint& a, const ScatterPoint& b) { return a.random < b.random; });
+        points.resize(total_rocks);
+    }
+    Log("Rocks scattered: " << points.size() << endl);
 
-    // create randomly positioned billboards for each vacXX texture we have:
-    for (unsigned long num = 0; num < total_rocks; num++) {
-        vec3 rnd = world.getRandomPos();
-        vec3 pos;
-        float denseFactor = 8.0f;
-        if (engine->isVR()) denseFactor *= 2.0f; // reduce density for VR mode for performance reasons
-        pos.x = rnd.x/denseFactor;
-        pos.y = rnd.y/denseFactor;
-        pos.z = rnd.z/denseFactor;
-        //pos.x = num * 1.0f;
-        //pos.y = 0.0f;
-        //pos.z = -300.0f;
+    for (auto& p : points) {
+        // height, scale and rotation from the per point random bits
+        ScatterRandom rnd(p.random);
+        vec3 pos = p.pos;
+        pos.y = rnd.nextFloat(0.0f, world.getWorldSize().y) / denseFactor;
 
         WorldObject* rock = engine->objectStore.addObject("group", "LogoBox", pos);
 
-        // scale between 1 and 10 meters:
-        //float scale = MathHelper::RandF(scale1m, 10.0f * scale1m);
-        float scale = MathHelper::RandF(1.0f, 3.0f);
-        //scale = 1.0f;// scale1m;
-        //scale = scale1m;
+        // scale between 1 and 3 meters:
+        float scale = rnd.nextFloat(1.0f, 3.0f);
         rock->scale() = vec3(scale);
         rock->enabled = true;
         rock->useGpuLod = true;
         vec3 rotation;
-        rotation.x = MathHelper::RandF(0.0f, PI);
-        rotation.y = MathHelper::RandF(0.0f, PI);
-        rotation.z = MathHelper::RandF(0.0f, PI);
+        rotation.x = rnd.nextFloat(0.0f, PI);
+        rotation.y = rnd.nextFloat(0.0f, PI);
+        rotation.z = rnd.nextFloat(0.0f, PI);
         rock->rot() = rotation;
         rocks.push_back(rock);
     }
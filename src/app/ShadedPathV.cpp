@@ -68,6 +68,7 @@ int mainOne(int argc, char* argv[])
         //.setEnableSound(true)
         //.setVR(true)
         //.setStereo(true)
+        //.setMultiview(true)
         .failIfNoVR(true)
         //.setSingleThreadMode(true)
         //.enableStereoPresentation()
@@ -99,6 +99,7 @@ void gltfObjectsApp::init() {
 
     //engine->shaders.lineShader.initialUpload();
     engine->shaders.pbrShader.initialUpload();
+    initLodSelection();
     // load and play music
     engine->sound.openSoundFile("power.ogg", "BACKGROUND_MUSIC", true);
     //engine->sound.playSound("BACKGROUND_MUSIC", SoundCategory::MUSIC, 1.0f, 6000);
@@ -209,6 +210,11 @@ void gltfObjectsApp::prepareFrame(FrameResources* fr)
         }
         buf->model = modeltransform;
     }
+    bool modelsChanged = updateAnimation(tr, deltaSeconds);
+    if (updateLodSelection(tr)) modelsChanged = true;
+    if (modelsChanged) {
+        engine->shaders.pbrShader.copyStagingDynamicUBO(tr);
+    }
     postUpdatePerFrame(tr);
     engine->shaders.clearShader.addCommandBuffers(fr, &fr->drawResults[0]); // put clear shader first
 }
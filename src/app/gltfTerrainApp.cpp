@@ -76,10 +76,14 @@ void gltfTerrainApp::init() {
     auto box10 = engine->objectStore.addObject("box_group", "Box10", vec3(-5.57332f, 57.3f, 3.70005));
     auto box100 = engine->objectStore.addObject("box_group", "Box100", vec3(120.57332f, 57.3f, 3.70005));
     world.transformToWorld(terrain);
+    // terrain hides objects behind hills, 16m occluder cells for the 1km world
+    world.prepareUltimateHeightmap(terrain);
+    engine->occlusionCulling.addTerrainOccluder(world, 64);
     auto p = hmdPositioner.getPosition();
 
     engine->shaders.clearShader.setClearColor(vec4(0.1f, 0.1f, 0.9f, 1.0f));
     engine->shaders.pbrShader.initialUpload();
+    initLodSelection();
     if (enableLines) {
         // Grid with 1m squares, floor on -10m, ceiling on 372m
         //Grid* grid = world.createWorldGrid(1.0f, -10.0f);
@@ -171,6 +175,12 @@ void gltfTerrainApp::prepareFrame(FrameResources* fr)
         }
         buf->model = modeltransform;
     }
+    bool modelsChanged = updateAnimation(tr, deltaSeconds);
+    if (updateLodSelection(tr)) modelsChanged = true;
+    if (updateCulling(tr)) modelsChanged = true;
+    if (modelsChanged) {
+        engine->shaders.pbrShader.copyStagingDynamicUBO(tr);
+    }
     postUpdatePerFrame(tr);
     engine->shaders.clearShader.addCommandBuffers(fr, &fr->drawResults[0]); // put clear shader first
 }
@@ -19,6 +19,7 @@ public:
     bool shouldClose() override;
     void handleInput(InputState& inputState) override;
     void buildCustomUI() override;
+    size_t getCustomUIStateHash() override { return uiVerticesTotal; }
 
 private:
     WorldObject *worldObject = nullptr;
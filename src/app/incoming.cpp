@@ -116,8 +116,18 @@ void Incoming::init() {
 
     // rocks
     engine->objectStore.createGroup(GroupRocksName, GroupRocks);
-    engine->meshStore.loadMesh("rocks_multi_cmp.glb", "Rocks");
+    engine->meshStore.loadMesh("rocks_multi_cmp.glb", "Rocks", MeshFlagsCollection(MeshFlags::MESH_TYPE_PACKED_VERTICES));
     addRandomRockFormations(RockWave::Cube, rockObjects);
+    // rocks do not move: world bounds are put into the broadphase once
+    auto& components = engine->objectStore.getComponents();
+    for (auto& wo : rockObjects) {
+        components.sync(wo->handle);
+    }
+    components.updateTransforms();
+    rockBroadphase.init(-world.getWorldSize().x / 2.0f, world.getWorldSize().x / 2.0f, 16.0f);
+    for (uint32_t i = 0; i < rockObjects.size(); i++) {
+        rockBroadphase.add(components.worldBounds()[components.indexOf(rockObjects[i]->handle)], i);
+    }
 
     // weapon
     engine->objectStore.createGroup(GroupGunName, GroupGun);
@@ -365,15 +375,18 @@ void Incoming::prepareFrame(FrameResources* fr)
             //Log("Shot weapon" << endl);
             engine->sound.playSound("SHOOT_GUN", SoundCategory::EFFECT, 300.0f);
             WorldObject* nearestShotObject = nullptr;
-            float lastDistance = 100000.0f;
-            for (auto& wo : rockObjects) {
-                if (wo-> enabled && wo->isLineIntersectingBoundingBox(shootLine.start, shootLine.end)) {
-                    float distGunRock = wo->distanceTo(finalGunPos);
-                    if ( distGunRock < lastDistance) {
-                        lastDistance = distGunRock;
-                        nearestShotObject = wo;
-                    }
-                }
+            vec3 shootDir = shootLine.end - shootLine.start;
+            float shootLength = length(shootDir);
+            float lastDistance = shootLength;
+            // rocks behind hills cannot be hit
+            HeightmapHit terrainHit;
+            if (world.intersectRay(shootLine.start, shootDir / shootLength, terrainHit, shootLength)) {
+                lastDistance = terrainHit.distance;
+            }
+            BroadphaseHit rockHit;
+            auto isEnabled = [this](uint32_t rock) { return rockObjects[rock]->enabled; };
+            if (rockBroadphase.raycast(shootLine.start, shootDir / shootLength, lastDistance, rockHit, isEnabled)) {
+                nearestShotObject = rockObjects[rockHit.userData];
             }
             if (nearestShotObject != nullptr) {
                 //Log("rock destroyed " << wo->mesh->id << endl);
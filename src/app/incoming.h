@@ -27,6 +27,7 @@ public:
     bool shouldClose() override;
     void handleInput(InputState& inputState) override;
     void buildCustomUI() override;
+    size_t getCustomUIStateHash() override { return uiVerticesTotal; }
     void addRandomRockFormations(RockWave waveName, std::vector<WorldObject*>& rockList);
     void addRandomRock(RockInfo ri, std::vector<WorldObject*>& rockList);
 
@@ -48,6 +49,7 @@ private:
     LineDef intersectTestLine;
     LineDef shootLine;
     std::vector<WorldObject*> rockObjects;
+    Broadphase rockBroadphase; // userData is index into rockObjects
 
     // game phases:
     static const int PhaseIntro = 0;
@@ -0,0 +1,262 @@
+#include "mainheader.h"
+
+using namespace std;
+using namespace glm;
+
+uint32_t Skeleton::addJoint(string name, int parentJoint, vec3 t, quat r, vec3 s, const mat4& inverseBindMatrix)
+{
+	parent.push_back(parentJoint);
+	names.push_back(name);
+	restTranslation.push_back(t);
+	restRotation.push_back(r);
+	restScale.push_back(s);
+	inverseBind.push_back(inverseBindMatrix);
+	rootTransform.push_back(mat4(1.0f));
+	return static_cast<uint32_t>(parent.size() - 1);
+}
+
+void Skeleton::finish()
+{
+	// sort by depth: parents are always evaluated before their children
+	vector<uint32_t> depth(size(), 0);
+	for (size_t j = 0; j < size(); j++) {
+		int p = parent[j];
+		while (p >= 0) {
+			depth[j]++;
+			if (depth[j] > size()) {
+				Error("Skeleton: joint hierarchy contains a cycle");
+			}
+			p = parent[p];
+		}
+	}
+	order.resize(size());
+	for (uint32_t j = 0; j < size(); j++) order[j] = j;
+	stable_sort(order.begin(), order.end(), [&depth](uint32_t a, uint32_t b) { return depth[a] < depth[b]; });
+}
+
+int AnimationSet::findClip(const string& name) const
+{
+	for (size_t i = 0; i < clips.size(); i++) {
+		if (clips[i].name == name) return static_cast<int>(i);
+	}
+	return -1;
+}
+
+void AnimationStats::log() const
+{
+	Log("Animation: " << instances << " instances, " << joints << " joints in " << milliseconds << " ms, "
+		<< jointsPerMillisecond() << " joints/ms" << endl);
+}
+
+uint32_t AnimationRuntime::addInstance(const AnimationSet* set)
+{
+	if (set == nullptr || set->skeleton.size() == 0) {
+		Error("AnimationRuntime: instance needs a skeleton");
+	}
+	if (set->skeleton.size() > MAX_NUM_JOINTS) {
+		Error("AnimationRuntime: skeleton has more than MAX_NUM_JOINTS joints");
+	}
+	Instance inst;
+	inst.set = set;
+	inst.paletteOffset = palettes.size();
+	palettes.resize(palettes.size() + set->skeleton.size(), mat4(1.0f));
+	instances.push_back(std::move(inst));
+	return static_cast<uint32_t>(instances.size() - 1);
+}
+
+void AnimationRuntime::clear()
+{
+	for (auto& inst : instances) {
+		if (inst.worldObject) inst.worldObject->animationInstance = INVALID_INSTANCE;
+	}
+	instances.clear();
+	palettes.clear();
+	stats = AnimationStats();
+}
+
+bool AnimationRuntime::setClip(uint32_t instance, const string& name, bool loop)
+{
+	Instance& inst = instances[instance];
+	inst.clip = inst.set->findClip(name);
+	inst.time = 0.0f;
+	inst.loop = loop;
+	inst.cursors.assign(inst.clip >= 0 ? inst.set->clips[inst.clip].channels.size() : 0, 0);
+	return inst.clip >= 0;
+}
+
+vec4 AnimationRuntime::sampleChannel(const AnimationChannel& ch, float t, uint32_t& cursor)
+{
+	size_t n = ch.times.size();
+	if (n == 0) return vec4(0.0f);
+	bool cubic = ch.interpolation == AnimationInterpolation::CubicSpline;
+	auto keyValue = [&](size_t k) { return cubic ? ch.values[k * 3 + 1] : ch.values[k]; };
+	if (t <= ch.times[0] || n == 1) {
+		cursor = 0;
+		return keyValue(0);
+	}
+	if (t >= ch.times[n - 1]) {
+		cursor = static_cast<uint32_t>(n - 1);
+		return keyValue(n - 1);
+	}
+	// time usually moves forward by less than one key per frame. Restart search after loop or seek
+	if (cursor >= n - 1 || ch.times[cursor] > t) {
+		cursor = static_cast<uint32_t>(upper_bound(ch.times.begin(), ch.times.end(), t) - ch.times.begin() - 1);
+	}
+	while (ch.times[cursor + 1] <= t) {
+		cursor++;
+	}
+	size_t k = cursor;
+	float t0 = ch.times[k];
+	float keyDelta = ch.times[k + 1] - t0;
+	float u = (t - t0) / keyDelta;
+	bool rotation = ch.path == AnimationPath::Rotation;
+	switch (ch.interpolation) {
+	case AnimationInterpolation::Step:
+		return ch.values[k];
+	case AnimationInterpolation::Linear:
+		if (rotation) {
+			const vec4& a = ch.values[k];
+			const vec4& b = ch.values[k + 1];
+			quat q = slerp(quat(a.w, a.x, a.y, a.z), quat(b.w, b.x, b.y, b.z), u);
+			return vec4(q.x, q.y, q.z, q.w);
+		}
+		return mix(ch.values[k], ch.values[k + 1], u);
+	case AnimationInterpolation::CubicSpline:
+	{
+		// Hermite spline as defined in glTF spec, tangents are scaled by key delta
+		float u2 = u * u;
+		float u3 = u2 * u;
+		vec4 v0 = ch.values[k * 3 + 1];
+		vec4 b0 = ch.values[k * 3 + 2];
+		vec4 a1 = ch.values[(k + 1) * 3];
+		vec4 v1 = ch.values[(k + 1) * 3 + 1];
+		vec4 r = (2.0f * u3 - 3.0f * u2 + 1.0f) * v0 + (u3 - 2.0f * u2 + u) * keyDelta * b0
+			+ (-2.0f * u3 + 3.0f * u2) * v1 + (u3 - u2) * keyDelta * a1;
+		return rotation ? normalize(r) : r;
+	}
+	}
+	return keyValue(k);
+}
+
+mat4 AnimationRuntime::composeTRS(vec3 t, quat r, vec3 s)
+{
+	mat3 rot = mat3_cast(r);
+	mat4 m;
+	m[0] = vec4(rot[0] * s.x, 0.0f);
+	m[1] = vec4(rot[1] * s.y, 0.0f);
+	m[2] = vec4(rot[2] * s.z, 0.0f);
+	m[3] = vec4(t, 1.0f);
+	return m;
+}
+
+void AnimationRuntime::evaluate(Instance& inst, float dt, Scratch& scratch)
+{
+	const Skeleton& sk = inst.set->skeleton;
+	scratch.t.assign(sk.restTranslation.begin(), sk.restTranslation.end());
+	scratch.r.assign(sk.restRotation.begin(), sk.restRotation.end());
+	scratch.s.assign(sk.restScale.begin(), sk.restScale.end());
+	scratch.global.resize(sk.size());
+	if (inst.clip >= 0) {
+		const AnimationClip& clip = inst.set->clips[inst.clip];
+		inst.time += dt * inst.speed;
+		if (inst.loop && clip.duration > 0.0f) {
+			inst.time = fmod(inst.time, clip.duration);
+			if (inst.time < 0.0f) inst.time += clip.duration;
+		} else {
+			inst.time = std::clamp(inst.time, 0.0f, clip.duration);
+		}
+		for (size_t c = 0; c < clip.channels.size(); c++) {
+			const AnimationChannel& ch = clip.channels[c];
+			vec4 v = sampleChannel(ch, inst.time, inst.cursors[c]);
+			switch (ch.path) {
+			case AnimationPath::Translation: scratch.t[ch.joint] = vec3(v); break;
+			case AnimationPath::Rotation: scratch.r[ch.joint] = quat(v.w, v.x, v.y, v.z); break;
+			case AnimationPath::Scale: scratch.s[ch.joint] = vec3(v); break;
+			}
+		}
+	}
+	// joint to model space, parents first
+	mat4* palette = palettes.data() + inst.paletteOffset;
+	for (uint32_t j : sk.order) {
+		mat4 local = composeTRS(scratch.t[j], scratch.r[j], scratch.s[j]);
+		const mat4& parentMatrix = sk.parent[j] < 0 ? sk.rootTransform[j] : scratch.global[sk.parent[j]];
+		simdMat4Mul(&parentMatrix[0][0], &local[0][0], &scratch.global[j][0][0]);
+		simdMat4Mul(&scratch.global[j][0][0], &sk.inverseBind[j][0][0], &palette[j][0][0]);
+	}
+}
+
+void AnimationRuntime::update(float dt, ThreadGroup* threads)
+{
+	auto start = chrono::high_resolution_clock::now();
+	size_t tasks = (instances.size() + INSTANCES_PER_TASK - 1) / INSTANCES_PER_TASK;
+	auto runTask = [this, dt](size_t task) {
+		Scratch scratch;
+		size_t end = std::min(instances.size(), (task + 1) * INSTANCES_PER_TASK);
+		for (size_t i = task * INSTANCES_PER_TASK; i < end; i++) {
+			evaluate(instances[i], dt, scratch);
+		}
+	};
+	if (threads != nullptr && tasks > 1) {
+		// instances only write their own palette range
+		vector<future<void>> futures;
+		futures.reserve(tasks);
+		for (size_t task = 0; task < tasks; task++) {
+			futures.push_back(threads->asyncSubmit([&runTask, task] { runTask(task); }));
+		}
+		for (auto& f : futures) {
+			f.get();
+		}
+	} else {
+		for (size_t task = 0; task < tasks; task++) {
+			runTask(task);
+		}
+	}
+	auto end = chrono::high_resolution_clock::now();
+	stats.instances = static_cast<uint32_t>(instances.size());
+	stats.joints = palettes.size();
+	stats.milliseconds = chrono::duration<double, milli>(end - start).count();
+}
+
+void AnimationRuntime::writeToModel(uint32_t instance, PBRShader::DynamicModelUBO* buf) const
+{
+	uint32_t count = getJointCount(instance);
+	memcpy(buf->jointMatrix, getPalette(instance), count * sizeof(mat4));
+	buf->jointcount = count;
+}
+
+void AnimationRuntime::registerWorldObjects()
+{
+	clear();
+	for (WorldObject* wo : engine->objectStore.getSortedList()) {
+		if (wo->mesh == nullptr || wo->mesh->animation == nullptr) continue;
+		// objects animated by application code write their own joint matrices
+		if (wo->disableSkinning || wo->isNonKeyframeAnimated) continue;
+		uint32_t index = addInstance(wo->mesh->animation.get());
+		instances[index].worldObject = wo;
+		wo->animationInstance = index;
+	}
+	// rest pose palettes for the initial model UBOs
+	update(0.0f);
+	Log("AnimationRuntime registered " << instances.size() << " animated objects, " << palettes.size() << " joints" << endl);
+}
+
+void AnimationRuntime::updatePerFrame(FrameResources& fr, float dt)
+{
+	for (uint32_t i = 0; i < instances.size(); i++) {
+		Instance& inst = instances[i];
+		if (inst.worldObject && inst.worldObject->action != inst.action) {
+			inst.action = inst.worldObject->action;
+			if (!setClip(i, inst.action)) {
+				Log("WARNING: animation clip not found: " << inst.action << endl);
+			}
+		}
+	}
+	update(dt, engine->getWorkerThreads());
+	for (uint32_t i = 0; i < instances.size(); i++) {
+		WorldObject* wo = instances[i].worldObject;
+		if (wo == nullptr || !wo->enabled) continue;
+		for (int p = 0; p < wo->primitiveCount; p++) {
+			writeToModel(i, engine->shaders.pbrShader.getAccessToModel(fr, wo->dynamicModelUBOIndex + p));
+		}
+	}
+}
@@ -0,0 +1,151 @@
+#pragma once
+
+// Skeletal animation: skeletons and clips are imported from glTF skins and animations (see gltf.cpp),
+// AnimationRuntime evaluates joint palettes for many animated objects per frame.
+// Channels are sampled with a cached keyframe cursor per instance, so normal playback does not search keys.
+// Joint matrices are combined with 4-wide SIMD (simdMat4Mul), instances are spread over the worker threads.
+
+class WorldObject;
+
+enum class AnimationPath : uint8_t {
+	Translation,
+	Rotation,
+	Scale
+};
+
+enum class AnimationInterpolation : uint8_t {
+	Step,
+	Linear,
+	CubicSpline
+};
+
+struct AnimationChannel {
+	uint32_t joint = 0; // index into skeleton joints
+	AnimationPath path = AnimationPath::Translation;
+	AnimationInterpolation interpolation = AnimationInterpolation::Linear;
+	std::vector<float> times; // key times in seconds, increasing
+	// xyz or quaternion xyzw per key. Cubic spline: in-tangent, value, out-tangent per key
+	std::vector<glm::vec4> values;
+};
+
+struct AnimationClip {
+	std::string name;
+	float duration = 0.0f;
+	std::vector<AnimationChannel> channels;
+};
+
+// joints in glTF skin order, this is the order used by vertex joint indices
+struct Skeleton {
+	std::vector<int> parent; // -1 for root joints
+	std::vector<uint32_t> order; // evaluation order, parents before children
+	std::vector<std::string> names;
+	std::vector<glm::mat4> inverseBind;
+	// rest pose, used for joints not animated by current clip
+	std::vector<glm::vec3> restTranslation;
+	std::vector<glm::quat> restRotation;
+	std::vector<glm::vec3> restScale;
+	// root joints only: inverse skinned mesh node transform * transform of non joint parent nodes
+	std::vector<glm::mat4> rootTransform;
+	size_t size() const {
+		return parent.size();
+	}
+	// add joint, parents have to be set before calling finish()
+	uint32_t addJoint(std::string name, int parentJoint, glm::vec3 t, glm::quat r, glm::vec3 s, const glm::mat4& inverseBindMatrix);
+	// calculate evaluation order
+	void finish();
+};
+
+// skeleton and all clips of one glTF skin. Shared by all meshes using the skin
+struct AnimationSet {
+	Skeleton skeleton;
+	std::vector<AnimationClip> clips;
+	// -1 if not found
+	int findClip(const std::string& name) const;
+};
+
+struct AnimationStats {
+	uint32_t instances = 0;
+	uint64_t joints = 0; // evaluated in last update
+	double milliseconds = 0.0; // duration of last update
+	double jointsPerMillisecond() const {
+		return milliseconds > 0.0 ? joints / milliseconds : 0.0;
+	}
+	void log() const;
+};
+
+class AnimationRuntime : public EngineParticipant
+{
+public:
+	static constexpr uint32_t INVALID_INSTANCE = UINT32_MAX;
+	// instances evaluated by one worker task
+	static constexpr size_t INSTANCES_PER_TASK = 32;
+
+	// instances
+	uint32_t addInstance(const AnimationSet* set);
+	void clear();
+	size_t size() const {
+		return instances.size();
+	}
+	// select clip by name and restart at time 0. Returns false if clip not found, instance stays in rest pose
+	bool setClip(uint32_t instance, const std::string& name, bool loop = true);
+	void setSpeed(uint32_t instance, float speed) {
+		instances[instance].speed = speed;
+	}
+	void setTime(uint32_t instance, float time) {
+		instances[instance].time = time;
+	}
+	float getTime(uint32_t instance) const {
+		return instances[instance].time;
+	}
+	// advance all instances by dt seconds and evaluate joint palettes, in parallel if threads are given
+	void update(float dt, ThreadGroup* threads = nullptr);
+	// joint matrices of last update, getJointCount() elements
+	const glm::mat4* getPalette(uint32_t instance) const {
+		return palettes.data() + instances[instance].paletteOffset;
+	}
+	uint32_t getJointCount(uint32_t instance) const {
+		return static_cast<uint32_t>(instances[instance].set->skeleton.size());
+	}
+	// copy only the used joint matrices into model UBO
+	void writeToModel(uint32_t instance, PBRShader::DynamicModelUBO* buf) const;
+	const AnimationStats& getStats() const {
+		return stats;
+	}
+
+	// sample channel at time t. cursor is the key index found by the last call for this channel
+	static glm::vec4 sampleChannel(const AnimationChannel& ch, float t, uint32_t& cursor);
+	// local joint matrix from translation, rotation, scale
+	static glm::mat4 composeTRS(glm::vec3 t, glm::quat r, glm::vec3 s);
+
+	// engine integration
+	// create instances for all world objects with skinned meshes, called by PBRShader::initialUpload().
+	// Clip is selected via WorldObject::setAction(), palettes start in rest pose
+	void registerWorldObjects();
+	// call from prepareFrame() (see AppSupport::updateAnimation()): advance animations and write palettes
+	// to all primitives of the objects. App has to call PBRShader::copyStagingDynamicUBO() afterwards
+	void updatePerFrame(FrameResources& fr, float dt);
+
+private:
+	struct Instance {
+		const AnimationSet* set = nullptr;
+		int clip = -1;
+		float time = 0.0f;
+		float speed = 1.0f;
+		bool loop = true;
+		std::vector<uint32_t> cursors; // one per channel of current clip
+		size_t paletteOffset = 0;
+		WorldObject* worldObject = nullptr;
+		std::string action; // action name the clip was selected for
+	};
+	// per task scratch memory for local transforms
+	struct Scratch {
+		std::vector<glm::vec3> t;
+		std::vector<glm::quat> r;
+		std::vector<glm::vec3> s;
+		std::vector<glm::mat4> global;
+	};
+	void evaluate(Instance& inst, float dt, Scratch& scratch);
+	std::vector<Instance> instances;
+	std::vector<glm::mat4> palettes; // joint matrices of all instances
+	AnimationStats stats;
+};
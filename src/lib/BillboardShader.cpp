@@ -122,9 +122,7 @@ void BillboardSubShader::initSingle(FrameResources& tr, ShaderState& shaderState
 	pipelineInfo.subpass = 0;
 	pipelineInfo.basePipelineHandle = VK_NULL_HANDLE; // Optional
 	pipelineInfo.basePipelineIndex = -1; // Optional
-	if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &graphicsPipeline) != VK_SUCCESS) {
-		Error("failed to create graphics pipeline!");
-	}
+	engine->globalRendering.pipelineCache.createGraphicsPipelineDeferred(pipelineInfo, &graphicsPipeline);
 }
 
 void BillboardShader::initialUpload()
@@ -281,7 +279,7 @@ BillboardShader::~BillboardShader()
 		sub.destroy();
 	}
 	vkDestroyBuffer(device, vertexBuffer, nullptr);
-	vkFreeMemory(device, vertexBufferMemory, nullptr);
+	engine->globalRendering.freeMemory(vertexBufferMemory);
 	vkDestroyShaderModule(device, fragShaderModule, nullptr);
 	vkDestroyShaderModule(device, vertShaderModule, nullptr);
 	vkDestroyShaderModule(device, geomShaderModule, nullptr);
@@ -304,12 +302,12 @@ void BillboardSubShader::destroy()
 	vkDestroyPipeline(device, graphicsPipeline, nullptr);
 	vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
 	vkDestroyBuffer(device, uniformBuffer, nullptr);
-	vkFreeMemory(device, uniformBufferMemory, nullptr);
+	engine->globalRendering.freeMemory(uniformBufferMemory);
 	//vkDestroyBuffer(device, trl.billboardVertexBuffer, nullptr);
 	//vkFreeMemory(device, trl.billboardVertexBufferMemory, nullptr);
 	if (engine->isStereo()) {
 		vkDestroyFramebuffer(device, framebuffer2, nullptr);
 		vkDestroyBuffer(device, uniformBuffer2, nullptr);
-		vkFreeMemory(device, uniformBufferMemory2, nullptr);
+		engine->globalRendering.freeMemory(uniformBufferMemory2);
 	}
 }
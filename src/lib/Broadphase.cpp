@@ -0,0 +1,217 @@
+#include "mainheader.h"
+
+using namespace std;
+using namespace glm;
+
+void Broadphase::init(float minXZ, float maxXZ, float cellSize)
+{
+	if (maxXZ <= minXZ || cellSize <= 0.0f) {
+		Error("Broadphase: invalid grid size");
+	}
+	this->minXZ = minXZ;
+	this->cellSize = cellSize;
+	invCellSize = 1.0f / cellSize;
+	cellsPerEdge = std::max(1, static_cast<int>(ceil((maxXZ - minXZ) / cellSize)));
+	clear();
+}
+
+void Broadphase::clear()
+{
+	cells.assign(static_cast<size_t>(cellsPerEdge) * cellsPerEdge, vector<uint32_t>());
+	proxies.clear();
+	freeProxies.clear();
+	stamp = 0;
+}
+
+uint32_t Broadphase::add(const ObjectBounds& bounds, uint32_t userData)
+{
+	if (cellsPerEdge == 0) {
+		Error("Broadphase: init() has to be called before adding objects");
+	}
+	uint32_t id;
+	if (!freeProxies.empty()) {
+		id = freeProxies.back();
+		freeProxies.pop_back();
+	} else {
+		id = static_cast<uint32_t>(proxies.size());
+		proxies.push_back(Proxy());
+	}
+	Proxy& p = proxies[id];
+	p.bounds = bounds;
+	p.userData = userData;
+	p.range = cellRange(bounds);
+	p.stamp = 0;
+	p.alive = true;
+	insertIntoCells(id, p.range);
+	return id;
+}
+
+void Broadphase::update(uint32_t proxy, const ObjectBounds& bounds)
+{
+	Proxy& p = proxies[proxy];
+	p.bounds = bounds;
+	CellRange r = cellRange(bounds);
+	if (r == p.range) return;
+	// only move between cells that differ
+	CellRange old = p.range;
+	p.range = r;
+	for (int z = old.z0; z <= old.z1; z++) {
+		for (int x = old.x0; x <= old.x1; x++) {
+			if (x >= r.x0 && x <= r.x1 && z >= r.z0 && z <= r.z1) continue;
+			removeFromCells(proxy, CellRange{ x, z, x, z });
+		}
+	}
+	for (int z = r.z0; z <= r.z1; z++) {
+		for (int x = r.x0; x <= r.x1; x++) {
+			if (x >= old.x0 && x <= old.x1 && z >= old.z0 && z <= old.z1) continue;
+			cells[static_cast<size_t>(z) * cellsPerEdge + x].push_back(proxy);
+		}
+	}
+}
+
+void Broadphase::remove(uint32_t proxy)
+{
+	Proxy& p = proxies[proxy];
+	if (!p.alive) {
+		Error("Broadphase: proxy removed twice");
+	}
+	removeFromCells(proxy, p.range);
+	p.alive = false;
+	p.range = CellRange();
+	freeProxies.push_back(proxy);
+}
+
+void Broadphase::insertIntoCells(uint32_t proxy, const CellRange& r)
+{
+	for (int z = r.z0; z <= r.z1; z++) {
+		for (int x = r.x0; x <= r.x1; x++) {
+			cells[static_cast<size_t>(z) * cellsPerEdge + x].push_back(proxy);
+		}
+	}
+}
+
+void Broadphase::removeFromCells(uint32_t proxy, const CellRange& r)
+{
+	for (int z = r.z0; z <= r.z1; z++) {
+		for (int x = r.x0; x <= r.x1; x++) {
+			auto& cell = cells[static_cast<size_t>(z) * cellsPerEdge + x];
+			auto it = find(cell.begin(), cell.end(), proxy);
+			if (it != cell.end()) {
+				*it = cell.back();
+				cell.pop_back();
+			}
+		}
+	}
+}
+
+uint32_t Broadphase::nextStamp()
+{
+	if (++stamp == 0) {
+		// wrapped around: reset all stamps
+		for (auto& p : proxies) p.stamp = 0;
+		stamp = 1;
+	}
+	return stamp;
+}
+
+bool Broadphase::intersectRayBox(const glm::vec3& origin, const glm::vec3& invDirection, float maxDistance, const ObjectBounds& box, float& t)
+{
+	float tEnter = 0.0f, tExit = maxDistance;
+	for (int axis = 0; axis < 3; axis++) {
+		if (isinf(invDirection[axis])) {
+			// parallel to slab
+			if (origin[axis] < box.min[axis] || origin[axis] > box.max[axis]) return false;
+			continue;
+		}
+		float t0 = (box.min[axis] - origin[axis]) * invDirection[axis];
+		float t1 = (box.max[axis] - origin[axis]) * invDirection[axis];
+		if (t0 > t1) std::swap(t0, t1);
+		tEnter = std::max(tEnter, t0);
+		tExit = std::min(tExit, t1);
+		if (tEnter > tExit) return false;
+	}
+	t = tEnter;
+	return true;
+}
+
+bool Broadphase::raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, BroadphaseHit& hit,
+	const std::function<bool(uint32_t)>& filter)
+{
+	hit = BroadphaseHit();
+	if (cellsPerEdge == 0) return false;
+	vec3 invDir = vec3(1.0f) / direction;
+	uint32_t visit = nextStamp();
+	// border cells reach to infinity, like the boxes clamped into them
+	int cx = cellCoord(origin.x), cz = cellCoord(origin.z);
+	auto nextBoundary = [this](int c, float o, float d, float inv) {
+		if (d > 0.0f && c < cellsPerEdge - 1) return (minXZ + (c + 1) * cellSize - o) * inv;
+		if (d < 0.0f && c > 0) return (minXZ + c * cellSize - o) * inv;
+		return numeric_limits<float>::max();
+	};
+	int stepX = direction.x > 0.0f ? 1 : -1;
+	int stepZ = direction.z > 0.0f ? 1 : -1;
+	float best = maxDistance;
+	while (true) {
+		for (uint32_t id : cells[static_cast<size_t>(cz) * cellsPerEdge + cx]) {
+			Proxy& p = proxies[id];
+			if (p.stamp == visit) continue;
+			p.stamp = visit;
+			if (filter && !filter(p.userData)) continue;
+			float t;
+			if (intersectRayBox(origin, invDir, best, p.bounds, t) && (!hit.hit || t < hit.distance)) {
+				best = t;
+				hit.hit = true;
+				hit.distance = t;
+				hit.proxy = id;
+				hit.userData = p.userData;
+			}
+		}
+		float tx = nextBoundary(cx, origin.x, direction.x, invDir.x);
+		float tz = nextBoundary(cz, origin.z, direction.z, invDir.z);
+		float tCell = std::min(tx, tz);
+		// boxes in later cells cannot be nearer
+		if (tCell >= best || tCell == numeric_limits<float>::max()) break;
+		if (tx < tz) cx += stepX;
+		else cz += stepZ;
+	}
+	return hit.hit;
+}
+
+void Broadphase::query(const ObjectBounds& bounds, std::vector<uint32_t>& result)
+{
+	result.clear();
+	if (cellsPerEdge == 0) return;
+	uint32_t visit = nextStamp();
+	CellRange r = cellRange(bounds);
+	for (int z = r.z0; z <= r.z1; z++) {
+		for (int x = r.x0; x <= r.x1; x++) {
+			for (uint32_t id : cells[static_cast<size_t>(z) * cellsPerEdge + x]) {
+				Proxy& p = proxies[id];
+				if (p.stamp == visit) continue;
+				p.stamp = visit;
+				if (overlaps(p.bounds, bounds)) result.push_back(p.userData);
+			}
+		}
+	}
+}
+
+void Broadphase::findPairs(std::vector<std::pair<uint32_t, uint32_t>>& pairs) const
+{
+	pairs.clear();
+	for (int z = 0; z < cellsPerEdge; z++) {
+		for (int x = 0; x < cellsPerEdge; x++) {
+			const auto& cell = cells[static_cast<size_t>(z) * cellsPerEdge + x];
+			for (size_t i = 0; i < cell.size(); i++) {
+				const Proxy& a = proxies[cell[i]];
+				for (size_t j = i + 1; j < cell.size(); j++) {
+					const Proxy& b = proxies[cell[j]];
+					if (!overlaps(a.bounds, b.bounds)) continue;
+					// report only from the cell holding the min corner of the overlap
+					if (cellCoord(std::max(a.bounds.min.x, b.bounds.min.x)) != x || cellCoord(std::max(a.bounds.min.z, b.bounds.min.z)) != z) continue;
+					if (cell[i] < cell[j]) pairs.emplace_back(a.userData, b.userData);
+					else pairs.emplace_back(b.userData, a.userData);
+				}
+			}
+		}
+	}
+}
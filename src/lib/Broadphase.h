@@ -0,0 +1,93 @@
+#pragma once
+
+// Broadphase for world object bounds: uniform grid over the xz plane of the world.
+// Every object (proxy) is listed in all grid cells its box overlaps. Moving an object only touches the grid
+// when its box enters or leaves a cell, otherwise just the stored box is updated, so per frame updates of many
+// moving objects are cheap. Boxes outside the grid are clamped to the border cells.
+// Queries visit only the cells they touch:
+// ray queries step through the cells along the ray (2D DDA) and stop as soon as the nearest hit is closer than
+// the next cell, pair enumeration reports every overlapping pair exactly once from the cell holding the min corner
+// of the overlap.
+// Queries use a visit stamp per proxy and must not run concurrently.
+
+struct BroadphaseHit {
+	uint32_t proxy = UINT32_MAX;
+	uint32_t userData = UINT32_MAX;
+	float distance = std::numeric_limits<float>::max(); // along ray, 0 if ray starts inside box
+	bool hit = false;
+};
+
+class Broadphase
+{
+public:
+	static constexpr uint32_t INVALID_PROXY = UINT32_MAX;
+
+	// grid covering [minXZ, maxXZ] in x and z, e.g. the world size
+	void init(float minXZ, float maxXZ, float cellSize);
+	// add box, userData is returned by queries (e.g. index into an object list). Returns proxy id
+	uint32_t add(const ObjectBounds& bounds, uint32_t userData);
+	// move or resize box of proxy
+	void update(uint32_t proxy, const ObjectBounds& bounds);
+	void remove(uint32_t proxy);
+	void clear();
+	size_t size() const {
+		return proxies.size() - freeProxies.size();
+	}
+	const ObjectBounds& getBounds(uint32_t proxy) const {
+		return proxies[proxy].bounds;
+	}
+
+	// nearest box hit by ray within maxDistance. filter(userData) can exclude proxies (e.g. disabled objects)
+	bool raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, BroadphaseHit& hit,
+		const std::function<bool(uint32_t)>& filter = nullptr);
+	// userData of all proxies overlapping box
+	void query(const ObjectBounds& bounds, std::vector<uint32_t>& result);
+	// userData pairs of overlapping boxes, each pair once with first < second proxy id
+	void findPairs(std::vector<std::pair<uint32_t, uint32_t>>& pairs) const;
+
+	// ray against box, entry distance in t (0 if origin is inside). invDirection is 1 / direction per component
+	static bool intersectRayBox(const glm::vec3& origin, const glm::vec3& invDirection, float maxDistance, const ObjectBounds& box, float& t);
+	static bool overlaps(const ObjectBounds& a, const ObjectBounds& b) {
+		return a.min.x <= b.max.x && a.max.x >= b.min.x && a.min.y <= b.max.y && a.max.y >= b.min.y && a.min.z <= b.max.z && a.max.z >= b.min.z;
+	}
+
+	int getCellsPerEdge() const {
+		return cellsPerEdge;
+	}
+	size_t getCellEntries(int x, int z) const {
+		return cells[static_cast<size_t>(z) * cellsPerEdge + x].size();
+	}
+
+private:
+	struct CellRange {
+		int x0 = 0, z0 = 0, x1 = -1, z1 = -1; // inclusive, empty if x1 < x0
+		bool operator==(const CellRange& o) const {
+			return x0 == o.x0 && z0 == o.z0 && x1 == o.x1 && z1 == o.z1;
+		}
+	};
+	struct Proxy {
+		ObjectBounds bounds;
+		uint32_t userData = 0;
+		CellRange range;
+		uint32_t stamp = 0; // last query that visited this proxy
+		bool alive = false;
+	};
+	int cellCoord(float f) const {
+		return std::clamp(static_cast<int>(std::floor((f - minXZ) * invCellSize)), 0, cellsPerEdge - 1);
+	}
+	CellRange cellRange(const ObjectBounds& b) const {
+		return CellRange{ cellCoord(b.min.x), cellCoord(b.min.z), cellCoord(b.max.x), cellCoord(b.max.z) };
+	}
+	void insertIntoCells(uint32_t proxy, const CellRange& r);
+	void removeFromCells(uint32_t proxy, const CellRange& r);
+	uint32_t nextStamp();
+
+	float minXZ = 0.0f;
+	float cellSize = 1.0f;
+	float invCellSize = 1.0f;
+	int cellsPerEdge = 0;
+	std::vector<std::vector<uint32_t>> cells; // proxy ids per cell, index z * cellsPerEdge + x
+	std::vector<Proxy> proxies;
+	std::vector<uint32_t> freeProxies;
+	uint32_t stamp = 0;
+};
@@ -221,6 +221,11 @@ public:
 		cameraPosition = pos;
 	}
 
+	// used by camera playback
+	void setOrientation(const glm::quat& ori) {
+		cameraOrientation = ori;
+	}
+
 	void setMaxSpeed(float max) {
 		maxSpeed_ = max;
 	}
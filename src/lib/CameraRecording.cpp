@@ -0,0 +1,241 @@
+#include "mainheader.h"
+
+using namespace std;
+using namespace glm;
+
+uint8_t CameraRecorder::encodeMovement(const Movement& m)
+{
+	uint8_t flags = 0;
+	if (m.forward_) flags |= CAMERA_RECORD_FORWARD;
+	if (m.backward_) flags |= CAMERA_RECORD_BACKWARD;
+	if (m.left_) flags |= CAMERA_RECORD_LEFT;
+	if (m.right_) flags |= CAMERA_RECORD_RIGHT;
+	if (m.up_) flags |= CAMERA_RECORD_UP;
+	if (m.down_) flags |= CAMERA_RECORD_DOWN;
+	if (m.fastSpeed_) flags |= CAMERA_RECORD_FAST;
+	if (m.type == MovementType::Walking) flags |= CAMERA_RECORD_WALKING;
+	return flags;
+}
+
+void CameraRecorder::decodeMovement(uint8_t flags, Movement& m)
+{
+	m.forward_ = (flags & CAMERA_RECORD_FORWARD) != 0;
+	m.backward_ = (flags & CAMERA_RECORD_BACKWARD) != 0;
+	m.left_ = (flags & CAMERA_RECORD_LEFT) != 0;
+	m.right_ = (flags & CAMERA_RECORD_RIGHT) != 0;
+	m.up_ = (flags & CAMERA_RECORD_UP) != 0;
+	m.down_ = (flags & CAMERA_RECORD_DOWN) != 0;
+	m.fastSpeed_ = (flags & CAMERA_RECORD_FAST) != 0;
+	m.type = (flags & CAMERA_RECORD_WALKING) ? MovementType::Walking : MovementType::Flying;
+}
+
+void CameraRecorder::record(const CameraPositionerInterface& positioner, double deltaSeconds, const glm::vec2& mousePos)
+{
+	CameraRecordFrame f;
+	f.deltaSeconds = static_cast<float>(deltaSeconds);
+	f.position = positioner.getPosition();
+	f.orientation = positioner.getOrientation();
+	f.mousePos = mousePos;
+	f.flags = encodeMovement(positioner.movement);
+	frames.push_back(f);
+}
+
+void CameraRecorder::serialize(std::vector<std::byte>& buffer) const
+{
+	uint64_t count = frames.size();
+	buffer.resize(sizeof(MAGIC) + sizeof(VERSION) + sizeof(count) + count * FRAME_SIZE);
+	byte* p = buffer.data();
+	auto put = [&p](const void* src, size_t size) {
+		memcpy(p, src, size);
+		p += size;
+	};
+	put(&MAGIC, sizeof(MAGIC));
+	put(&VERSION, sizeof(VERSION));
+	put(&count, sizeof(count));
+	for (auto& f : frames) {
+		// write members one by one: no padding in the file
+		put(&f.deltaSeconds, sizeof(float));
+		put(&f.position.x, 3 * sizeof(float));
+		float q[4] = { f.orientation.w, f.orientation.x, f.orientation.y, f.orientation.z };
+		put(q, sizeof(q));
+		put(&f.mousePos.x, 2 * sizeof(float));
+		put(&f.flags, 1);
+	}
+}
+
+void CameraRecorder::save(const std::string& filename) const
+{
+	vector<byte> buffer;
+	serialize(buffer);
+	ofstream out(filename, ios::out | ios::binary | ios::trunc);
+	if (!out) {
+		Error("CameraRecorder: cannot write " + filename);
+	}
+	out.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+	Log("Camera recording saved: " << filename << " " << frames.size() << " frames" << endl);
+}
+
+bool CameraPlayback::load(const std::string& filename)
+{
+	ifstream in(filename, ios::in | ios::binary | ios::ate);
+	if (!in) {
+		Log("Camera recording not found: " << filename << endl);
+		return false;
+	}
+	vector<byte> buffer(static_cast<size_t>(in.tellg()));
+	in.seekg(0);
+	in.read(reinterpret_cast<char*>(buffer.data()), buffer.size());
+	if (!deserialize(buffer)) {
+		Log("Camera recording invalid: " << filename << endl);
+		return false;
+	}
+	return true;
+}
+
+bool CameraPlayback::deserialize(const std::vector<std::byte>& buffer)
+{
+	uint64_t magic;
+	uint32_t version;
+	uint64_t count;
+	const size_t headerSize = sizeof(magic) + sizeof(version) + sizeof(count);
+	if (buffer.size() < headerSize) return false;
+	const byte* p = buffer.data();
+	auto get = [&p](void* dst, size_t size) {
+		memcpy(dst, p, size);
+		p += size;
+	};
+	get(&magic, sizeof(magic));
+	get(&version, sizeof(version));
+	get(&count, sizeof(count));
+	if (magic != CameraRecorder::MAGIC || version != CameraRecorder::VERSION) return false;
+	if (buffer.size() != headerSize + count * CameraRecorder::FRAME_SIZE) return false;
+	vector<CameraRecordFrame> recorded(count);
+	for (auto& f : recorded) {
+		get(&f.deltaSeconds, sizeof(float));
+		get(&f.position.x, 3 * sizeof(float));
+		float q[4];
+		get(q, sizeof(q));
+		f.orientation = quat(q[0], q[1], q[2], q[3]);
+		get(&f.mousePos.x, 2 * sizeof(float));
+		get(&f.flags, 1);
+	}
+	setFrames(recorded);
+	return true;
+}
+
+void CameraPlayback::setFrames(const std::vector<CameraRecordFrame>& recorded)
+{
+	frames = recorded;
+	timeline.resize(frames.size());
+	double t = 0.0;
+	for (size_t i = 0; i < frames.size(); i++) {
+		// delta of first frame leads up to it and is not part of the recording
+		if (i > 0) t += frames[i].deltaSeconds;
+		timeline[i] = t;
+	}
+	playing = false;
+}
+
+void CameraPlayback::start(CameraPlaybackMode mode, double fixedDeltaSeconds)
+{
+	if (mode == CameraPlaybackMode::FixedStep && fixedDeltaSeconds <= 0.0) {
+		Error("CameraPlayback: fixed step has to be positive");
+	}
+	this->mode = mode;
+	fixedDelta = fixedDeltaSeconds;
+	stepCount = 0;
+	frameTimes.clear();
+	playing = !frames.empty();
+}
+
+void CameraPlayback::poseAt(double t, glm::vec3& position, glm::quat& orientation, uint8_t& flags) const
+{
+	// first frame at or after t
+	size_t i = lower_bound(timeline.begin(), timeline.end(), t) - timeline.begin();
+	if (i == 0 || i >= frames.size()) {
+		const CameraRecordFrame& f = frames[i == 0 ? 0 : frames.size() - 1];
+		position = f.position;
+		orientation = f.orientation;
+		flags = f.flags;
+		return;
+	}
+	const CameraRecordFrame& a = frames[i - 1];
+	const CameraRecordFrame& b = frames[i];
+	float s = static_cast<float>((t - timeline[i - 1]) / (timeline[i] - timeline[i - 1]));
+	position = mix(a.position, b.position, s);
+	orientation = normalize(slerp(a.orientation, b.orientation, s));
+	flags = s < 0.5f ? a.flags : b.flags;
+}
+
+bool CameraPlayback::step(CameraPositioner_FirstPerson& positioner, double& deltaSeconds)
+{
+	if (!playing) return false;
+	vec3 pos;
+	quat ori;
+	uint8_t flags;
+	if (mode == CameraPlaybackMode::RecordedSteps) {
+		if (stepCount >= frames.size()) {
+			playing = false;
+			return false;
+		}
+		const CameraRecordFrame& f = frames[stepCount];
+		pos = f.position;
+		ori = f.orientation;
+		flags = f.flags;
+		deltaSeconds = f.deltaSeconds;
+	} else {
+		// multiply instead of accumulate: step n is always at the same time
+		double t = static_cast<double>(stepCount) * fixedDelta;
+		if (t > getDuration()) {
+			playing = false;
+			return false;
+		}
+		poseAt(t, pos, ori, flags);
+		deltaSeconds = fixedDelta;
+	}
+	positioner.setPosition(pos);
+	positioner.setOrientation(ori);
+	CameraRecorder::decodeMovement(flags, positioner.movement);
+	stepCount++;
+	return true;
+}
+
+CameraPlaybackStats CameraPlayback::getStats() const
+{
+	CameraPlaybackStats stats;
+	stats.frames = frameTimes.size();
+	if (frameTimes.empty()) return stats;
+	vector<double> sorted = frameTimes;
+	sort(sorted.begin(), sorted.end());
+	double sum = 0.0;
+	for (double t : sorted) sum += t;
+	auto percentile = [&sorted](double p) {
+		size_t i = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+		return sorted[i];
+	};
+	stats.averageMS = sum / sorted.size();
+	stats.p50MS = percentile(0.5);
+	stats.p95MS = percentile(0.95);
+	stats.p99MS = percentile(0.99);
+	stats.maxMS = sorted.back();
+	return stats;
+}
+
+void CameraPlaybackStats::log() const
+{
+	Log("Camera playback " << frames << " frames, avg " << averageMS << " ms p50 " << p50MS << " p95 " << p95MS
+		<< " p99 " << p99MS << " max " << maxMS << endl);
+}
+
+void CameraPlayback::writeTimings(const std::string& filename) const
+{
+	ofstream out(filename, ios::out | ios::trunc);
+	if (!out) {
+		Error("CameraPlayback: cannot write " + filename);
+	}
+	out << "frame,ms" << endl;
+	for (size_t i = 0; i < frameTimes.size(); i++) {
+		out << i << "," << frameTimes[i] << "\n";
+	}
+	Log("Camera playback timings written: " << filename << endl);
+}
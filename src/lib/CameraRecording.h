@@ -0,0 +1,120 @@
+#pragma once
+
+// Recording and replay of camera sessions for repeatable flythrough benchmarks.
+// CameraRecorder stores per frame the game time delta, camera pose, mouse position and Movement key flags.
+// Files are compact binary: magic, version, frame count, then fixed size frames.
+// CameraPlayback drives a first person positioner from a recording, either frame by frame with the recorded
+// time deltas or at a fixed timestep with poses interpolated on the recorded timeline (fixed step n is at time
+// n * step, no accumulated error). Poses are set directly instead of being simulated from the recorded keys,
+// so the camera path depends only on the file and the step mode: every run, headless or not, sees the same frames.
+// Recorded keys are copied to the positioner Movement for code that looks at them.
+// Frame times measured during playback are reported as percentiles and can be written as CSV.
+
+enum CameraRecordFlag : uint8_t {
+	CAMERA_RECORD_FORWARD = 1,
+	CAMERA_RECORD_BACKWARD = 2,
+	CAMERA_RECORD_LEFT = 4,
+	CAMERA_RECORD_RIGHT = 8,
+	CAMERA_RECORD_UP = 16,
+	CAMERA_RECORD_DOWN = 32,
+	CAMERA_RECORD_FAST = 64,
+	CAMERA_RECORD_WALKING = 128
+};
+
+struct CameraRecordFrame {
+	float deltaSeconds = 0.0f; // game time since previous frame
+	glm::vec3 position = glm::vec3(0.0f);
+	glm::quat orientation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+	glm::vec2 mousePos = glm::vec2(0.0f);
+	uint8_t flags = 0; // CameraRecordFlag bits
+};
+
+class CameraRecorder
+{
+public:
+	static constexpr uint64_t MAGIC = 0x3130434552435053ull; // "SPCREC01"
+	static constexpr uint32_t VERSION = 1;
+	// bytes per frame in file: delta, position, orientation, mouse pos, flags
+	static constexpr size_t FRAME_SIZE = 10 * sizeof(float) + 1;
+
+	// add frame after the positioner was updated with deltaSeconds
+	void record(const CameraPositionerInterface& positioner, double deltaSeconds, const glm::vec2& mousePos = glm::vec2(0.0f));
+	void clear() {
+		frames.clear();
+	}
+	const std::vector<CameraRecordFrame>& getFrames() const {
+		return frames;
+	}
+	void serialize(std::vector<std::byte>& buffer) const;
+	void save(const std::string& filename) const;
+
+	static uint8_t encodeMovement(const Movement& movement);
+	static void decodeMovement(uint8_t flags, Movement& movement);
+
+private:
+	std::vector<CameraRecordFrame> frames;
+};
+
+enum class CameraPlaybackMode {
+	RecordedSteps, // one recorded frame per step, with its recorded delta
+	FixedStep // poses interpolated at multiples of a fixed delta
+};
+
+struct CameraPlaybackStats {
+	size_t frames = 0;
+	double averageMS = 0.0;
+	double p50MS = 0.0;
+	double p95MS = 0.0;
+	double p99MS = 0.0;
+	double maxMS = 0.0;
+	void log() const;
+};
+
+class CameraPlayback
+{
+public:
+	// false if file is missing or invalid
+	bool load(const std::string& filename);
+	bool deserialize(const std::vector<std::byte>& buffer);
+	void setFrames(const std::vector<CameraRecordFrame>& recorded);
+	const std::vector<CameraRecordFrame>& getFrames() const {
+		return frames;
+	}
+	// restart from first frame, clears frame times
+	void start(CameraPlaybackMode mode, double fixedDeltaSeconds = 1.0 / 60.0);
+	void stop() {
+		playing = false;
+	}
+	bool isPlaying() const {
+		return playing;
+	}
+	// move positioner to pose of next step, deltaSeconds is the (recorded or fixed) time step.
+	// Returns false and stops at end of recording
+	bool step(CameraPositioner_FirstPerson& positioner, double& deltaSeconds);
+	uint64_t getStepCount() const {
+		return stepCount;
+	}
+	// recorded time from first to last frame
+	double getDuration() const {
+		return timeline.empty() ? 0.0 : timeline.back();
+	}
+	// pose at recorded time t, clamped to recording
+	void poseAt(double t, glm::vec3& position, glm::quat& orientation, uint8_t& flags) const;
+
+	// measured time of a played frame
+	void addFrameTime(double milliseconds) {
+		frameTimes.push_back(milliseconds);
+	}
+	CameraPlaybackStats getStats() const;
+	// CSV with one line per measured frame
+	void writeTimings(const std::string& filename) const;
+
+private:
+	std::vector<CameraRecordFrame> frames;
+	std::vector<double> timeline; // recorded time of each frame, first frame at 0
+	std::vector<double> frameTimes;
+	CameraPlaybackMode mode = CameraPlaybackMode::RecordedSteps;
+	double fixedDelta = 1.0 / 60.0;
+	uint64_t stepCount = 0;
+	bool playing = false;
+};
@@ -5,10 +5,11 @@ using namespace std;
 void CubeShader::init(ShadedPathEngine& engine, ShaderState& shaderState)
 {
 	ShaderBase::init(engine);
+	multiviewSupported = true;
 	resources.setResourceDefinition(&vulkanResourceDefinition);
 
 	// create shader modules
-	vertShaderModule = resources.createShaderModule("cube.vert.spv");
+	vertShaderModule = resources.createShaderModule(isMultiview() ? "cube_multiview.vert.spv" : "cube.vert.spv");
 	fragShaderModule = resources.createShaderModule("cube.frag.spv");
 
 	VkDeviceSize bufferSize = sizeof(Vertex) * 36;
@@ -37,11 +38,12 @@ void CubeShader::initSingle(FrameResources& tr, ShaderState& shaderState)
 
 void CubeSubShader::initSingle(FrameResources& tr, ShaderState& shaderState)
 {
-	// uniform buffer
-	cubeShader->createUniformBuffer(uniformBuffer, sizeof(CubeShader::UniformBufferObject), uniformBufferMemory);
+	// uniform buffer, multiview: one buffer for both eyes
+	auto uboSize = cubeShader->isMultiview() ? CubeShader::getMultiviewUBOSize(sizeof(CubeShader::UniformBufferObject)) : sizeof(CubeShader::UniformBufferObject);
+	cubeShader->createUniformBuffer(uniformBuffer, uboSize, uniformBufferMemory);
 	engine->util.debugNameObjectBuffer(uniformBuffer, "Cube UBO 1");
 	engine->util.debugNameObjectDeviceMemory(uniformBufferMemory, "Cube Memory 1");
-	if (engine->isStereo()) {
+	if (engine->isStereo() && !cubeShader->isMultiview()) {
 		cubeShader->createUniformBuffer(uniformBuffer2, sizeof(CubeShader::UniformBufferObject), uniformBufferMemory2);
 		engine->util.debugNameObjectBuffer(uniformBuffer2, "Cube UBO 2");
 		engine->util.debugNameObjectDeviceMemory(uniformBufferMemory2, "Cube Memory 2");
@@ -119,9 +121,7 @@ void CubeSubShader::initSingle(FrameResources& tr, ShaderState& shaderState)
 	pipelineInfo.subpass = 0;
 	pipelineInfo.basePipelineHandle = VK_NULL_HANDLE; // Optional
 	pipelineInfo.basePipelineIndex = -1; // Optional
-	if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &graphicsPipeline) != VK_SUCCESS) {
-		Error("failed to create graphics pipeline!");
-	}
+	engine->globalRendering.pipelineCache.createGraphicsPipelineDeferred(pipelineInfo, &graphicsPipeline);
 }
 
 void CubeShader::createCommandBuffer(FrameResources& tr)
@@ -139,6 +139,11 @@ void CubeSubShader::createGlobalCommandBufferAndRenderPass(FrameResources& tr)
 	handover.mvpBuffer = uniformBuffer;
 	handover.mvpBuffer2 = uniformBuffer2;
 	handover.mvpSize = sizeof(CubeShader::UniformBufferObject);
+	if (cubeShader->isMultiview()) {
+		// descriptorSet2 is still allocated in stereo mode, but never bound
+		handover.mvpBuffer2 = uniformBuffer;
+		handover.mvpSize = CubeShader::getMultiviewUBOSize(sizeof(CubeShader::UniformBufferObject));
+	}
 	handover.imageView = cubeShader->skybox->imageView;
 	handover.descriptorSet = &descriptorSet;
 	handover.descriptorSet2 = &descriptorSet2;
@@ -177,7 +182,7 @@ void CubeSubShader::createGlobalCommandBufferAndRenderPass(FrameResources& tr)
 	vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
 	recordDrawCommand(commandBuffer, tr);
 	vkCmdEndRenderPass(commandBuffer);
-	if (engine->isStereo()) {
+	if (engine->isStereo() && !cubeShader->isMultiview()) {
 		renderPassInfo.framebuffer = framebuffer2;
 		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
 		recordDrawCommand(commandBuffer, tr, true);
@@ -221,6 +226,10 @@ void CubeSubShader::recordDrawCommand(VkCommandBuffer& commandBuffer, FrameResou
 void CubeSubShader::uploadToGPU(FrameResources& tr, CubeShader::UniformBufferObject& ubo, CubeShader::UniformBufferObject& ubo2, bool outsideMode) {
 	ubo2.farFactor = ubo.farFactor = cubeShader->bloatFactor;
 	ubo2.outside = ubo.outside = outsideMode;
+	if (cubeShader->isMultiview()) {
+		cubeShader->uploadMultiviewUBO(uniformBufferMemory, &ubo, &ubo2, sizeof(ubo));
+		return;
+	}
 	// copy ubo to GPU:
 	void* data;
 	vkMapMemory(device, uniformBufferMemory, 0, sizeof(ubo), 0, &data);
@@ -257,7 +266,7 @@ CubeShader::~CubeShader()
 	vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
 	vkDestroyDescriptorPool(device, descriptorPool, nullptr);
 	vkDestroyBuffer(device, vertexBuffer, nullptr);
-	vkFreeMemory(device, vertexBufferMemory, nullptr);
+	engine->globalRendering.freeMemory(vertexBufferMemory);
 }
 
 void CubeSubShader::init(CubeShader* parent, std::string debugName) {
@@ -275,10 +284,10 @@ void CubeSubShader::destroy()
 	vkDestroyPipeline(device, graphicsPipeline, nullptr);
 	vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
 	vkDestroyBuffer(device, uniformBuffer, nullptr);
-	vkFreeMemory(device, uniformBufferMemory, nullptr);
+	engine->globalRendering.freeMemory(uniformBufferMemory);
 	if (engine->isStereo()) {
 		vkDestroyFramebuffer(device, framebuffer2, nullptr);
 		vkDestroyBuffer(device, uniformBuffer2, nullptr);
-		vkFreeMemory(device, uniformBufferMemory2, nullptr);
+		engine->globalRendering.freeMemory(uniformBufferMemory2);
 	}
 }
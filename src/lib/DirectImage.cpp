@@ -65,8 +65,10 @@ void DirectImage::copyBackbufferImage(GPUImage* gpui_source, GPUImage* gpui_targ
 
 	VkImageCopy imageCopyRegion{};
 	imageCopyRegion.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	imageCopyRegion.srcSubresource.baseArrayLayer = gpui_source->arrayLayer;
 	imageCopyRegion.srcSubresource.layerCount = 1;
 	imageCopyRegion.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	imageCopyRegion.dstSubresource.baseArrayLayer = gpui_target->arrayLayer;
 	imageCopyRegion.dstSubresource.layerCount = 1;
 	imageCopyRegion.extent.width = engine->getBackBufferExtent().width;
 	imageCopyRegion.extent.height = engine->getBackBufferExtent().height;
@@ -95,8 +97,10 @@ void DirectImage::copyBackbufferImageP(GPUImage* gpui_source, GPUImage* gpui_tar
 
 	VkImageCopy imageCopyRegion{};
 	imageCopyRegion.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	imageCopyRegion.srcSubresource.baseArrayLayer = gpui_source->arrayLayer;
 	imageCopyRegion.srcSubresource.layerCount = 1;
 	imageCopyRegion.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	imageCopyRegion.dstSubresource.baseArrayLayer = gpui_target->arrayLayer;
 	imageCopyRegion.dstSubresource.layerCount = 1;
 	imageCopyRegion.extent.width = engine->getBackBufferExtent().width;
 	imageCopyRegion.extent.height = engine->getBackBufferExtent().height;
@@ -127,7 +131,7 @@ void DirectImage::toLayout(VkImageLayout layout, VkAccessFlags2 access, VkComman
 	dstBarrier.oldLayout = gpui->layout;
 	dstBarrier.newLayout = layout;
 	dstBarrier.image = gpui->fba.image;
-	dstBarrier.subresourceRange = VkImageSubresourceRange{ VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+	dstBarrier.subresourceRange = VkImageSubresourceRange{ VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, gpui->arrayLayer, 1 };
     dstBarrier.srcStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
     dstBarrier.dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
 
@@ -153,7 +157,7 @@ void DirectImage::toLayout(VkImageLayout layout, VkPipelineStageFlags2 stage, Vk
 	dstBarrier.oldLayout = gpui->layout;
 	dstBarrier.newLayout = layout;
 	dstBarrier.image = gpui->fba.image;
-	dstBarrier.subresourceRange = VkImageSubresourceRange{ VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+	dstBarrier.subresourceRange = VkImageSubresourceRange{ VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, gpui->arrayLayer, 1 };
 	dstBarrier.srcStageMask = gpui->stage;
 	dstBarrier.dstStageMask = stage;
 
@@ -216,6 +216,16 @@ string Files::absoluteFilePath(string filename)
 	return absfile;
 }
 
+filesystem::path Files::getPipelineCacheFilePath(uint32_t vendorID, uint32_t deviceID)
+{
+	if (fxFolder.empty()) {
+		Error("shader folder not set. Call findFxFolder() first");
+	}
+	stringstream name;
+	name << "pipeline_cache_" << hex << vendorID << "_" << deviceID << ".bin";
+	return fxFolder.parent_path() / name.str();
+}
+
 void Files::initPakFiles()
 {
 	string binFile = findFile("data.pak", FileCategory::TEXTUREPAK, false);
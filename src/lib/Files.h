@@ -36,6 +36,8 @@ public:
 	void readFile(PakEntry* pakEntry, std::vector<std::byte>& buffer, FileCategory cat);
 	PakEntry* findFileInPak(std::string filename);
     std::filesystem::path getAssetFolderPath() { return assetFolder; };
+	// pipeline cache file for one GPU, stored next to the shader folder
+	std::filesystem::path getPipelineCacheFilePath(uint32_t vendorID, uint32_t deviceID);
 	//define sub folder names, all directly below asset folder
 	const std::string TEXTURE_PATH = "texture";
 	const std::string MESH_PATH = "mesh";
@@ -0,0 +1,349 @@
+#include "mainheader.h"
+
+using namespace std;
+using namespace glm;
+
+// Box test per plane with signed distance d of the box center and projected half extent e:
+// box is outside if d + e < 0 and completely inside if d >= e for all planes.
+// SIMD and scalar path use the same operation order, so both produce the same results.
+
+Frustum Frustum::fromViewProjection(const glm::mat4& m)
+{
+	Frustum f;
+	// rows of m (glm is column major)
+	vec4 r0(m[0][0], m[1][0], m[2][0], m[3][0]);
+	vec4 r1(m[0][1], m[1][1], m[2][1], m[3][1]);
+	vec4 r2(m[0][2], m[1][2], m[2][2], m[3][2]);
+	vec4 r3(m[0][3], m[1][3], m[2][3], m[3][3]);
+	f.planes[PLANE_LEFT] = r3 + r0;
+	f.planes[PLANE_RIGHT] = r3 - r0;
+	f.planes[PLANE_BOTTOM] = r3 + r1;
+	f.planes[PLANE_TOP] = r3 - r1;
+	f.planes[PLANE_NEAR] = r2; // Vulkan depth range starts at 0
+	f.planes[PLANE_FAR] = r3 - r2;
+	for (auto& p : f.planes) {
+		p /= length(vec3(p));
+	}
+	// corner index bits: x right, y top, z far
+	mat4 inv = inverse(m);
+	for (int c = 0; c < 8; c++) {
+		vec4 ndc((c & 1) ? 1.0f : -1.0f, (c & 2) ? 1.0f : -1.0f, (c & 4) ? 1.0f : 0.0f, 1.0f);
+		vec4 p = inv * ndc;
+		f.corners[c] = vec3(p) / p.w;
+	}
+	return f;
+}
+
+// intersection point of 3 planes
+static vec3 intersectPlanes(const vec4& a, const vec4& b, const vec4& c)
+{
+	vec3 na(a), nb(b), nc(c);
+	vec3 bc = cross(nb, nc);
+	return (-a.w * bc - b.w * cross(nc, na) - c.w * cross(na, nb)) / dot(na, bc);
+}
+
+Frustum Frustum::combine(const Frustum& a, const Frustum& b)
+{
+	Frustum f;
+	for (int p = 0; p < PLANE_COUNT; p++) {
+		vec3 n = vec3(a.planes[p]) + vec3(b.planes[p]);
+		float len = length(n);
+		n = len > 1e-6f ? n / len : vec3(a.planes[p]);
+		// move plane out until no corner of a or b is outside
+		float w = -numeric_limits<float>::max();
+		for (int c = 0; c < 8; c++) {
+			w = std::max(w, -dot(n, a.corners[c]));
+			w = std::max(w, -dot(n, b.corners[c]));
+		}
+		f.planes[p] = vec4(n, w);
+	}
+	for (int c = 0; c < 8; c++) {
+		f.corners[c] = intersectPlanes(f.planes[(c & 1) ? PLANE_RIGHT : PLANE_LEFT],
+			f.planes[(c & 2) ? PLANE_TOP : PLANE_BOTTOM], f.planes[(c & 4) ? PLANE_FAR : PLANE_NEAR]);
+	}
+	return f;
+}
+
+uint8_t Frustum::test(const glm::vec3& center, const glm::vec3& extent, float radius) const
+{
+	uint8_t r = CULL_VISIBLE_LEFT | CULL_INSIDE;
+	for (const auto& p : planes) {
+		float d = p.x * center.x + p.y * center.y + p.z * center.z + p.w;
+		float e = abs(p.x) * extent.x + abs(p.y) * extent.y + abs(p.z) * extent.z + radius;
+		if (d + e < 0.0f) return 0;
+		if (d < e) r &= ~CULL_INSIDE;
+	}
+	return r;
+}
+
+void FrustumCullingStats::log() const
+{
+	Log("Frustum culling: objects " << objects << " visible " << visible << " left " << visibleLeft << " right " << visibleRight
+		<< " rejected by combined frustum " << rejectedByCombined << endl);
+}
+
+void FrustumCulling::resize(size_t n)
+{
+	count = n;
+	size_t padded = simdPaddedSize(n);
+	centerX.resize(padded, 0.0f);
+	centerY.resize(padded, 0.0f);
+	centerZ.resize(padded, 0.0f);
+	extentX.resize(padded, 0.0f);
+	extentY.resize(padded, 0.0f);
+	extentZ.resize(padded, 0.0f);
+	radius.resize(padded, 0.0f);
+	result.resize(padded, 0);
+}
+
+void FrustumCulling::setBox(size_t index, const glm::vec3& min, const glm::vec3& max)
+{
+	vec3 c = (min + max) * 0.5f;
+	vec3 e = (max - min) * 0.5f;
+	centerX[index] = c.x;
+	centerY[index] = c.y;
+	centerZ[index] = c.z;
+	extentX[index] = e.x;
+	extentY[index] = e.y;
+	extentZ[index] = e.z;
+	radius[index] = 0.0f;
+}
+
+void FrustumCulling::setSphere(size_t index, const glm::vec3& center, float r)
+{
+	centerX[index] = center.x;
+	centerY[index] = center.y;
+	centerZ[index] = center.z;
+	extentX[index] = 0.0f;
+	extentY[index] = 0.0f;
+	extentZ[index] = 0.0f;
+	radius[index] = r;
+}
+
+void FrustumCulling::setAlwaysVisible(size_t index)
+{
+	// d + e is never negative, d < e for every plane: visible, never completely inside
+	setSphere(index, vec3(0.0f), numeric_limits<float>::max());
+}
+
+void FrustumCulling::setBoxes(std::span<const ObjectBounds> bounds)
+{
+	resize(bounds.size());
+	for (size_t i = 0; i < bounds.size(); i++) {
+		const ObjectBounds& b = bounds[i];
+		if (b.min == b.max) {
+			// object without mesh bounds
+			setAlwaysVisible(i);
+		} else {
+			setBox(i, b.min, b.max);
+		}
+	}
+}
+
+void FrustumCulling::PlaneBatch::set(const Frustum& f)
+{
+	for (int p = 0; p < Frustum::PLANE_COUNT; p++) {
+		const vec4& pl = f.planes[p];
+		nx[p] = Float4(pl.x);
+		ny[p] = Float4(pl.y);
+		nz[p] = Float4(pl.z);
+		w[p] = Float4(pl.w);
+		ax[p] = Float4(abs(pl.x));
+		ay[p] = Float4(abs(pl.y));
+		az[p] = Float4(abs(pl.z));
+	}
+}
+
+void FrustumCulling::cull(const Frustum& view, ThreadGroup* threads, bool useSimd)
+{
+	frustumLeft = view;
+	batchLeft.set(view);
+	run(false, threads, useSimd);
+}
+
+void FrustumCulling::cullStereo(const Frustum& left, const Frustum& right, ThreadGroup* threads, bool useSimd)
+{
+	frustumLeft = left;
+	frustumRight = right;
+	frustumCombined = Frustum::combine(left, right);
+	batchLeft.set(left);
+	batchRight.set(right);
+	batchCombined.set(frustumCombined);
+	run(true, threads, useSimd);
+}
+
+void FrustumCulling::run(bool stereo, ThreadGroup* threads, bool useSimd)
+{
+	stats = FrustumCullingStats();
+	visible.clear();
+	if (threads == nullptr || count <= PARALLEL_CHUNK_SIZE) {
+		if (useSimd) cullRangeSimd(0, count, stereo, visible, stats);
+		else cullRangeScalar(0, count, stereo, visible, stats);
+		return;
+	}
+	// each chunk collects its own visible list, lists are appended in chunk order afterwards
+	size_t chunks = (count + PARALLEL_CHUNK_SIZE - 1) / PARALLEL_CHUNK_SIZE;
+	vector<FrustumCullingStats> partial(chunks);
+	vector<vector<uint32_t>> partialVisible(chunks);
+	vector<future<void>> futures;
+	futures.reserve(chunks);
+	for (size_t c = 0; c < chunks; c++) {
+		size_t start = c * PARALLEL_CHUNK_SIZE;
+		size_t end = std::min(count, start + PARALLEL_CHUNK_SIZE);
+		futures.push_back(threads->asyncSubmit([this, start, end, stereo, useSimd, &partial, &partialVisible, c] {
+			if (useSimd) cullRangeSimd(start, end, stereo, partialVisible[c], partial[c]);
+			else cullRangeScalar(start, end, stereo, partialVisible[c], partial[c]);
+		}));
+	}
+	for (size_t c = 0; c < chunks; c++) {
+		futures[c].wait();
+		stats.add(partial[c]);
+		visible.insert(visible.end(), partialVisible[c].begin(), partialVisible[c].end());
+	}
+}
+
+void FrustumCulling::testBatch(const PlaneBatch& p, size_t i, Float4& outside, Float4& intersecting) const
+{
+	Float4 cx = Float4::load(&centerX[i]);
+	Float4 cy = Float4::load(&centerY[i]);
+	Float4 cz = Float4::load(&centerZ[i]);
+	Float4 ex = Float4::load(&extentX[i]);
+	Float4 ey = Float4::load(&extentY[i]);
+	Float4 ez = Float4::load(&extentZ[i]);
+	Float4 r = Float4::load(&radius[i]);
+	Float4 zero;
+	outside = Float4();
+	intersecting = Float4();
+	for (int k = 0; k < Frustum::PLANE_COUNT; k++) {
+		Float4 d = p.nx[k] * cx + p.ny[k] * cy + p.nz[k] * cz + p.w[k];
+		Float4 e = p.ax[k] * ex + p.ay[k] * ey + p.az[k] * ez + r;
+		outside = outside | Float4::lessThan(d + e, zero);
+		intersecting = intersecting | Float4::lessThan(d, e);
+	}
+}
+
+// start is always a multiple of SIMD_WIDTH, arrays are padded so the last batch may run past end
+void FrustumCulling::cullRangeSimd(size_t start, size_t end, bool stereo, vector<uint32_t>& vis, FrustumCullingStats& s)
+{
+	for (size_t i = start; i < end; i += SIMD_WIDTH) {
+		int lanes = static_cast<int>(std::min(end - i, (size_t)SIMD_WIDTH));
+		Float4 outside, intersecting;
+		int visibleLeft, visibleRight = 0, inside;
+		int combined = ~0;
+		if (!stereo) {
+			testBatch(batchLeft, i, outside, intersecting);
+			visibleLeft = ~Float4::moveMask(outside);
+			inside = ~Float4::moveMask(intersecting);
+		} else {
+			testBatch(batchCombined, i, outside, intersecting);
+			combined = ~Float4::moveMask(outside) & ((1 << lanes) - 1);
+			if (combined == 0) {
+				// whole batch rejected, no per eye tests
+				for (int lane = 0; lane < lanes; lane++) {
+					result[i + lane] = 0;
+				}
+				s.rejectedByCombined += lanes;
+				continue;
+			}
+			Float4 outsideRight, intersectingRight;
+			testBatch(batchLeft, i, outside, intersecting);
+			testBatch(batchRight, i, outsideRight, intersectingRight);
+			visibleLeft = combined & ~Float4::moveMask(outside);
+			visibleRight = combined & ~Float4::moveMask(outsideRight);
+			inside = ~Float4::moveMask(intersecting | intersectingRight);
+		}
+		for (int lane = 0; lane < lanes; lane++) {
+			int bit = 1 << lane;
+			if (!(combined & bit)) s.rejectedByCombined++;
+			uint8_t r = 0;
+			if (visibleLeft & bit) r |= CULL_VISIBLE_LEFT;
+			if (visibleRight & bit) r |= CULL_VISIBLE_RIGHT;
+			if (r != 0 && (inside & bit)) r |= CULL_INSIDE;
+			result[i + lane] = r;
+			if (r != 0) {
+				vis.push_back(static_cast<uint32_t>(i + lane));
+				s.visible++;
+				if (r & CULL_VISIBLE_LEFT) s.visibleLeft++;
+				if (r & CULL_VISIBLE_RIGHT) s.visibleRight++;
+			}
+		}
+	}
+	s.objects += static_cast<uint32_t>(end - start);
+}
+
+uint8_t FrustumCulling::testScalar(const Frustum& f, size_t i) const
+{
+	return f.test(vec3(centerX[i], centerY[i], centerZ[i]), vec3(extentX[i], extentY[i], extentZ[i]), radius[i]);
+}
+
+void FrustumCulling::cullRangeScalar(size_t start, size_t end, bool stereo, vector<uint32_t>& vis, FrustumCullingStats& s)
+{
+	for (size_t i = start; i < end; i++) {
+		uint8_t r;
+		if (!stereo) {
+			r = testScalar(frustumLeft, i);
+		} else if (testScalar(frustumCombined, i) == 0) {
+			s.rejectedByCombined++;
+			r = 0;
+		} else {
+			uint8_t left = testScalar(frustumLeft, i);
+			uint8_t right = testScalar(frustumRight, i);
+			r = 0;
+			if (left) r |= CULL_VISIBLE_LEFT;
+			if (right) r |= CULL_VISIBLE_RIGHT;
+			if ((left & CULL_INSIDE) && (right & CULL_INSIDE)) r |= CULL_INSIDE;
+		}
+		result[i] = r;
+		if (r != 0) {
+			vis.push_back(static_cast<uint32_t>(i));
+			s.visible++;
+			if (r & CULL_VISIBLE_LEFT) s.visibleLeft++;
+			if (r & CULL_VISIBLE_RIGHT) s.visibleRight++;
+		}
+	}
+	s.objects += static_cast<uint32_t>(end - start);
+}
+
+// call from prepareFrame(), worker threads are used for large object counts
+void FrustumCulling::updatePerFrame(FrameResources& fr, const glm::mat4& viewProjLeft, const glm::mat4& viewProjRight)
+{
+	ObjectComponentStore& components = engine->objectStore.getComponents();
+	components.syncFromWorldObjects();
+	components.updateTransforms(engine->getWorkerThreads());
+	setBoxes(components.worldBounds());
+	Frustum left = Frustum::fromViewProjection(viewProjLeft);
+	if (engine->isStereo()) {
+		cullStereo(left, Frustum::fromViewProjection(viewProjRight), engine->getWorkerThreads());
+	} else {
+		cull(left, engine->getWorkerThreads());
+	}
+	applyToModels(fr);
+}
+
+// culling uses its own flag bits, objects disabled by app code or LOD selection stay disabled
+void FrustumCulling::applyToModels(FrameResources& fr)
+{
+	ObjectComponentStore& components = engine->objectStore.getComponents();
+	if (components.size() != count) {
+		Error("FrustumCulling: objects were added or removed after culling");
+	}
+	bool stereo = engine->isStereo();
+	auto owners = components.owners();
+	auto flags = components.renderFlags();
+	for (size_t i = 0; i < count; i++) {
+		uint8_t r = result[i];
+		uint32_t f = flags[i] & ~(OBJECT_VISIBLE | OBJECT_FULLY_VISIBLE);
+		if (r != 0) f |= OBJECT_VISIBLE;
+		if (r & CULL_INSIDE) f |= OBJECT_FULLY_VISIBLE;
+		flags[i] = f;
+		WorldObject* wo = owners[i];
+		if (wo == nullptr) continue;
+		wo->visible = (r & CULL_INSIDE) ? 2 : (r != 0 ? 1 : 0);
+		bool culledLeft = (r & CULL_VISIBLE_LEFT) == 0;
+		bool culledRight = stereo && (r & CULL_VISIBLE_RIGHT) == 0;
+		for (int p = 0; p < wo->primitiveCount; p++) {
+			PBRShader::DynamicModelUBO* buf = engine->shaders.pbrShader.getAccessToModel(fr, wo->dynamicModelUBOIndex + p);
+			buf->setCulled(culledLeft, culledRight);
+		}
+	}
+}
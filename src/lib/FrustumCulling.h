@@ -0,0 +1,114 @@
+#pragma once
+
+// CPU frustum culling of world space bounding volumes (AABB or sphere), processed in SIMD batches (see SimdMath.h)
+// and spread over worker threads for large object counts.
+// Stereo: all objects are first tested against one conservative frustum enclosing both eye frustums.
+// Only objects passing this test are refined against each eye, so most invisible objects are rejected with a single test.
+// Results go to a compact list of visible objects, the render flags of ObjectComponentStore and the
+// MODEL_RENDER_FLAG_CULLED_LEFT / MODEL_RENDER_FLAG_CULLED_RIGHT bits of each DynamicModelUBO (checked in pbr.task).
+
+// result bits per object
+enum FrustumCullResult : uint8_t {
+	CULL_VISIBLE_LEFT = 1, // visible in left eye or in mono view
+	CULL_VISIBLE_RIGHT = 2, // only used for stereo
+	CULL_INSIDE = 4 // completely inside all tested frustums
+};
+
+// 6 planes, dot(plane.xyz, p) + plane.w >= 0 for points inside
+struct Frustum {
+	enum Plane { PLANE_LEFT, PLANE_RIGHT, PLANE_BOTTOM, PLANE_TOP, PLANE_NEAR, PLANE_FAR, PLANE_COUNT };
+	std::array<glm::vec4, PLANE_COUNT> planes;
+	std::array<glm::vec3, 8> corners; // world space, used to combine frustums
+	// planes from projection * view, Vulkan clip space with depth range [0,1]
+	static Frustum fromViewProjection(const glm::mat4& viewProj);
+	// conservative frustum containing a and b: plane normals are averaged, then moved out until all corners of both frustums are inside
+	static Frustum combine(const Frustum& a, const Frustum& b);
+	// scalar test of box (center, half extent) enlarged by radius, returns CULL_VISIBLE_LEFT | CULL_INSIDE bits
+	uint8_t test(const glm::vec3& center, const glm::vec3& extent, float radius = 0.0f) const;
+};
+
+struct FrustumCullingStats {
+	uint32_t objects = 0;
+	uint32_t visible = 0; // in at least one eye
+	uint32_t visibleLeft = 0;
+	uint32_t visibleRight = 0;
+	uint32_t rejectedByCombined = 0; // stereo only: culled without testing single eyes
+	void add(const FrustumCullingStats& other) {
+		objects += other.objects;
+		visible += other.visible;
+		visibleLeft += other.visibleLeft;
+		visibleRight += other.visibleRight;
+		rejectedByCombined += other.rejectedByCombined;
+	}
+	void log() const;
+};
+
+class FrustumCulling : public EngineParticipant
+{
+public:
+	// chunk size for parallel culling, multiple of SIMD_WIDTH
+	static constexpr size_t PARALLEL_CHUNK_SIZE = 4096;
+
+	// object data
+	void resize(size_t n);
+	size_t size() const {
+		return count;
+	}
+	void setBox(size_t index, const glm::vec3& min, const glm::vec3& max);
+	void setSphere(size_t index, const glm::vec3& center, float radius);
+	// object is never culled
+	void setAlwaysVisible(size_t index);
+	// set all objects from world space AABBs, degenerate boxes (min == max) are always visible
+	void setBoxes(std::span<const ObjectBounds> bounds);
+
+	// cull all objects. threads == nullptr runs on the calling thread, useSimd == false runs the scalar reference path
+	void cull(const Frustum& view, ThreadGroup* threads = nullptr, bool useSimd = true);
+	// cull against combined frustum of both eyes, then refine per eye
+	void cullStereo(const Frustum& left, const Frustum& right, ThreadGroup* threads = nullptr, bool useSimd = true);
+
+	// FrustumCullResult bits of object
+	uint8_t getResult(size_t index) const {
+		return result[index];
+	}
+	// indexes of all objects visible in at least one eye, ascending
+	const std::vector<uint32_t>& getVisible() const {
+		return visible;
+	}
+	const FrustumCullingStats& getStats() const {
+		return stats;
+	}
+
+	// engine integration
+	// cull all objects of engine object store with their component world bounds. Transforms of the components are
+	// updated from WorldObjects first. viewProjRight is ignored without stereo.
+	// Dynamic model UBOs are only changed in staging memory, app has to call PBRShader::copyStagingDynamicUBO() afterwards
+	void updatePerFrame(FrameResources& fr, const glm::mat4& viewProjLeft, const glm::mat4& viewProjRight);
+	// write current results to component render flags, WorldObject::visible and DynamicModelUBO of each primitive
+	void applyToModels(FrameResources& fr);
+
+private:
+	// planes of one frustum broadcast for SIMD batches
+	struct PlaneBatch {
+		Float4 nx[Frustum::PLANE_COUNT], ny[Frustum::PLANE_COUNT], nz[Frustum::PLANE_COUNT], w[Frustum::PLANE_COUNT];
+		Float4 ax[Frustum::PLANE_COUNT], ay[Frustum::PLANE_COUNT], az[Frustum::PLANE_COUNT]; // abs of normal
+		void set(const Frustum& f);
+	};
+	void run(bool stereo, ThreadGroup* threads, bool useSimd);
+	void testBatch(const PlaneBatch& p, size_t i, Float4& outside, Float4& intersecting) const;
+	void cullRangeSimd(size_t start, size_t end, bool stereo, std::vector<uint32_t>& vis, FrustumCullingStats& s);
+	void cullRangeScalar(size_t start, size_t end, bool stereo, std::vector<uint32_t>& vis, FrustumCullingStats& s);
+	uint8_t testScalar(const Frustum& f, size_t i) const;
+
+	// SoA object data, padded to SIMD_WIDTH. Boxes have radius 0, spheres have extent 0
+	std::vector<float> centerX, centerY, centerZ;
+	std::vector<float> extentX, extentY, extentZ;
+	std::vector<float> radius;
+	std::vector<uint8_t> result;
+	std::vector<uint32_t> visible;
+	size_t count = 0;
+
+	// per culling run
+	Frustum frustumLeft, frustumRight, frustumCombined;
+	PlaneBatch batchLeft, batchRight, batchCombined;
+	FrustumCullingStats stats;
+};
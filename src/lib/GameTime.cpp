@@ -19,9 +19,13 @@ void GameTime::init(LONGLONG gamedayFactor)
 
 void GameTime::advanceTime()
 {
-	// get time
+	advanceTime(chrono::steady_clock::now());
+}
+
+void GameTime::advanceTime(chrono::steady_clock::time_point t)
+{
 	auto old = now;
-	now = chrono::steady_clock::now();
+	now = t;
 	nanoTime = now.time_since_epoch().count();
 	chrono::system_clock::time_point nowAbs = chrono::system_clock::now();
 
@@ -33,49 +37,59 @@ void GameTime::advanceTime()
 	//Log("fraction " << hh << endl);
 	timeGameClock = fmod(timeSystemClock * gamedayFactor, 24.0);
 
-	chrono::duration<double, std::ratio<60 * 60>> myHourTick3(now - this->startTimePoint);
-	realtime = myHourTick3.count();
+	timeDelta = chrono::duration_cast<chrono::duration<double>>(now - old).count();
+	double stepSeconds = timeDelta;
+	if (fixedDelta > 0.0) {
+		clockOffsetSeconds += timeDelta - fixedDelta;
+		stepSeconds = fixedDelta;
+	}
 
-	gametime = realtime * gamedayFactor;
 	// seconds is standard - we don't need ratio
 	chrono::duration<double> mySecondsTick(now - this->startTimePoint);
-	gametimeSeconds = mySecondsTick.count() * gamedayFactor;
+	double elapsedSeconds = mySecondsTick.count() - clockOffsetSeconds;
+	realtime = elapsedSeconds / (60.0 * 60.0);
 
-	timeDelta = chrono::duration_cast<chrono::duration<double>>(now - old).count();
-	gameTimeDelta = timeDelta * gamedayFactor;
+	gametime = realtime * gamedayFactor;
+	gametimeSeconds = elapsedSeconds * gamedayFactor;
+	gameTimeDelta = stepSeconds * gamedayFactor;
+}
+
+void GameTime::setFixedDelta(double seconds)
+{
+	fixedDelta = seconds;
 }
 
-double GameTime::getTimeSystemClock()
+double GameTime::getTimeSystemClock() const
 {
 	return timeSystemClock;
 }
 
-double GameTime::getTimeGameClock()
+double GameTime::getTimeGameClock() const
 {
 	return timeGameClock;
 }
 
-double GameTime::getTime()
+double GameTime::getTime() const
 {
 	return gametime;
 }
 
-double GameTime::getTimeSeconds()
+double GameTime::getTimeSeconds() const
 {
 	return gametimeSeconds;
 }
 
-double GameTime::getTimeDelta()
+double GameTime::getTimeDelta() const
 {
 	return gameTimeDelta;
 }
 
-double GameTime::getRealTimeDelta()
+double GameTime::getRealTimeDelta() const
 {
 	return timeDelta;
 }
 
-long long GameTime::getNanoTime()
+long long GameTime::getNanoTime() const
 {
 	return nanoTime;
 }
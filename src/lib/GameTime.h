@@ -13,39 +13,44 @@ public:
 	// advances time, should be called once for every frame
 	// not thread save - be sure to call from synchronized method (usually after presenting)
 	void advanceTime();
+	// advance to given time point instead of current clock, used for fixed simulation ticks
+	void advanceTime(std::chrono::steady_clock::time_point t);
+	// advance game time by a fixed number of real seconds per advanceTime() instead of the clock delta,
+	// e.g. recorded deltas during camera playback. 0 switches back to the clock. Real time delta is still measured
+	void setFixedDelta(double seconds);
 
 	// get number of hours (and fractions) since game start (in gametime)
 	// will always increase until game stops
 	// NEVER use time values as float instead of double: precision is not enough and you will get same time value for actually different times
-	double getTime();
+	double getTime() const;
 
 	// get seconds (and fractions) since game start (in gametime)
 	// will always increase until game stops
 	// NEVER use time values as float instead of double: precision is not enough and you will get same time value for actually different times
-	double getTimeSeconds();
+	double getTimeSeconds() const;
 
 	// get seconds (and fractions) since last call to advanceTime() (in gametime)
 	// NEVER use time values as float instead of double: precision is not enough and you will get same time value for actually different times
-	double getTimeDelta();
+	double getTimeDelta() const;
 
 	// get seconds (and fractions) since last call to advanceTime() (in real time)
 	// NEVER use time values as float instead of double: precision is not enough and you will get same time value for actually different times
-	double getRealTimeDelta();
+	double getRealTimeDelta() const;
 
 	// get absolute number of hours (and fractions) of system clock (no gameday)
 	// resets every 24h real time
 	// NEVER use time values as float instead of double: precision is not enough and you will get same time value for actually different times
-	double getTimeSystemClock();
+	double getTimeSystemClock() const;
 
 	// get absolute number of hours (and fractions) of game clock
 	// resets every 24h game time
 	// NEVER use time values as float instead of double: precision is not enough and you will get same time value for actually different times
-	double getTimeGameClock();
+	double getTimeGameClock() const;
 
 	// derived from chrono::steady_clock this will be nanoseconds since epoch.
 	// should never be nagative or wrap.
 	// long long same as int64_t. Used e.g. in OpenXR.
-	long long getNanoTime();
+	long long getNanoTime() const;
 
 private:
 	// measurements:
@@ -60,6 +65,8 @@ private:
 	double realtime;
 	double timeDelta; // [s]
 	double gameTimeDelta; // [s]
+	double fixedDelta = 0.0; // [s] real time, 0 == use clock
+	double clockOffsetSeconds = 0.0; // real seconds the game clock lags behind (or runs ahead of) the clock due to fixed deltas
 	long long nanoTime; // [nanoseconds since epoch], same as int64_t. Used e.g. in OpenXR
 public:
 
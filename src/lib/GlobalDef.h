@@ -26,6 +26,7 @@ static const int MAX_COMMAND_BUFFERS_PER_DRAW = 100; // arbitrary, should be eno
 //forward
 struct WindowInfo;
 class ShadedPathEngine;
+struct SimulationSnapshot;
 
 struct InputState {
     glm::vec2 pos = glm::vec2(0.0f);
@@ -66,6 +67,7 @@ struct GPUImage {
     bool rendered = false;
     bool consumed = false;
     bool isRightEye = false;
+    uint32_t arrayLayer = 0; // layer of fba.image, right eye uses layer 1 of the shared image in multiview mode
     VkFramebuffer framebuffer = nullptr;
 };
 
@@ -89,7 +91,7 @@ struct DrawResult {
 
 // FrameResources and ThreadResources work together: FrameResources has all all global frame data
 // that is not related to multi-thread rendering (drawFrame()). ThreadResources has all thread specific data.
-// FrameResources[2] --- engine.frameInfos[2], used alternating depending on frame number
+// FrameResources[framesInFlight] --- engine.frameInfos[], used round robin depending on frame number (see setFramesInFlight())
 //    - ThreadResources[engine.numWorkerThreads] --- globalRendering.workerThreadResources[], assigned to frameInfo in preFrame()
 struct FrameResources {
     ~FrameResources();
@@ -107,7 +109,7 @@ struct FrameResources {
     //#define	THREAD_RESOURCES_MAX_COMMAND_BUFFERS 10
     //	VkCommandBuffer commandBuffers[THREAD_RESOURCES_MAX_COMMAND_BUFFERS];
     //
-    ThreadsafeWaitingQueue<unsigned long> processImageQueue;
+    SpscRingQueue<unsigned long> processImageQueue{ 4 };
     VkSemaphore imageAvailableSemaphore = nullptr;
     VkSemaphore renderFinishedSemaphore = nullptr;
     VkFence inFlightFence = nullptr;
@@ -123,7 +125,15 @@ struct FrameResources {
 
     GPUImage colorImage;
     GPUImage colorImage2;
+    // multiview: colorImage and depthImage have one layer per eye, colorImage2 and depthImageView2 refer to layer 1.
+    // Views of both layers for multiview render passes:
+    VkImageView colorImageArrayView = nullptr;
+    VkImageView depthImageArrayView = nullptr;
     VkCommandPool commandPool = nullptr;
+    // transfer commands (e.g. texture streaming) submitted before the draw commands of this frame,
+    // see GlobalRendering::getFrameUploadCommandBuffer()
+    VkCommandBuffer uploadCommandBuffer = nullptr;
+    bool uploadRecording = false;
 
     //
     //	bool threadFinished = false;
@@ -138,6 +148,12 @@ struct FrameResources {
     std::string commandBufferDebugName;
     GPUImage* renderedImage = nullptr;
     bool drawFrameDone = false;
+    // simulation state for this frame, only set if simulation thread is enabled.
+    // Interpolate render state from previousSnapshot to snapshot with snapshotAlpha
+    std::shared_ptr<const SimulationSnapshot> snapshot;
+    std::shared_ptr<const SimulationSnapshot> previousSnapshot;
+    float snapshotAlpha = 1.0f;
+    std::chrono::steady_clock::time_point frameStart; // for pipeline latency metrics
     std::vector<DrawResult> drawResults; // one result for each draw call topic
     int numCommandBuffers = 0;
 
@@ -189,7 +205,8 @@ class QueueSubmitResources
 {
 public:
     FrameResources* frameInfo = nullptr;
-    ThreadsafeWaitingQueue<unsigned long> renderThreadContinueQueue;
+    // tokens from queue submit thread to render thread, at most frames in flight - 1
+    SpscRingQueue<unsigned long> renderThreadContinueQueue{ 8 };
 };
 
 
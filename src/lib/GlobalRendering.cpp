@@ -158,6 +158,32 @@ bool GlobalRendering::checkFeatureBindless64Buffer(DeviceInfo& info)
     }
 }
 
+bool GlobalRendering::checkFeatureMultiview(DeviceInfo& info)
+{
+    VkPhysicalDeviceMultiviewFeatures multiviewFeatures{};
+    multiviewFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MULTIVIEW_FEATURES;
+    VkPhysicalDeviceFeatures2 features2{};
+    features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features2.pNext = &multiviewFeatures;
+    vkGetPhysicalDeviceFeatures2(info.device, &features2);
+    if (!multiviewFeatures.multiview) {
+        Log("device does not support multiview rendering" << endl);
+        return false;
+    }
+    if (isMeshShading()) {
+        // PBR shader uses task and mesh shaders
+        VkPhysicalDeviceMeshShaderFeaturesEXT meshFeatures{};
+        meshFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MESH_SHADER_FEATURES_EXT;
+        features2.pNext = &meshFeatures;
+        vkGetPhysicalDeviceFeatures2(info.device, &features2);
+        if (!meshFeatures.multiviewMeshShader) {
+            Log("device does not support multiview rendering with mesh shaders" << endl);
+            return false;
+        }
+    }
+    return true;
+}
+
 bool GlobalRendering::checkFeatureSwapChain(VkPhysicalDevice physDevice)
 {
     SwapChainSupportDetails swapChainSupport = querySwapChainSupport(physDevice);
@@ -237,10 +263,17 @@ void GlobalRendering::init()
         }
     }
     pickDevice();
+    // multiview is optional: fall back to one render pass per eye
+    if (engine->isMultiview() && !checkFeatureMultiview(globalDeviceInfo)) {
+        Log("WARNING: multiview not available, stereo mode renders each eye in its own render pass" << endl);
+        engine->setMultiview(false);
+    }
+    Log("Stereo rendering: " << (engine->isMultiview() ? "multiview" : (engine->isStereo() ? "one render pass per eye" : "off")) << endl);
     //checkFeatureSwapChain(physicalDevice);
     // list queue properties:
     familyIndices = findQueueFamilies(physicalDevice, true);
     createLogicalDevice();
+    pipelineCache.init(device, globalDeviceInfo.properties, engine->files.getPipelineCacheFilePath(globalDeviceInfo.properties.vendorID, globalDeviceInfo.properties.deviceID));
     createCommandPools();
     createTextureSampler();
     VkSemaphoreCreateInfo semaphoreInfo{};
@@ -264,6 +297,7 @@ void GlobalRendering::init()
 void GlobalRendering::shutdown()
 {
     samplerCache.destroy();
+    pipelineCache.destroy();
     if (queueSubmitFence != nullptr) {
         vkDestroyFence(device, queueSubmitFence, nullptr);
     }
@@ -478,12 +512,18 @@ void GlobalRendering::createLogicalDevice()
     meshFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MESH_SHADER_FEATURES_EXT;
     meshFeatures.meshShader = VK_TRUE;
     meshFeatures.taskShader = VK_TRUE;
+    meshFeatures.multiviewMeshShader = engine->isMultiview() ? VK_TRUE : VK_FALSE;
 
     VkPhysicalDevicePortabilitySubsetFeaturesKHR portability{
         .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PORTABILITY_SUBSET_FEATURES_KHR,
         .events = VK_TRUE,
     };
 
+    VkPhysicalDeviceVulkan11Features deviceFeatures11{
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_1_FEATURES,
+        .multiview = VK_TRUE,
+    };
+
     VkPhysicalDeviceVulkan12Features deviceFeatures12{
         .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
         .uniformAndStorageBuffer8BitAccess = VK_TRUE,
@@ -536,6 +576,9 @@ void GlobalRendering::createLogicalDevice()
     VkDeviceCreateInfo createInfo{};
     createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
     chainNextDeviceFeature(&createInfo, &deviceFeatures2);
+    if (engine->isMultiview()) {
+        chainNextDeviceFeature(&createInfo, &deviceFeatures11);
+    }
     chainNextDeviceFeature(&createInfo, &deviceFeatures12);
     chainNextDeviceFeature(&createInfo, &deviceFeatures13);
     if (isMeshShading()) {
@@ -721,6 +764,7 @@ void GlobalRendering::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage,
     }
 
     vkBindBufferMemory(device, buffer, bufferMemory, 0);
+    engine->memoryTracker.track(bufferMemory, getBufferMemoryTag(usage, properties), MemoryDomain::Device, memRequirements.size);
     engine->util.debugNameObjectBuffer(buffer, bufferDebugName.c_str());
     string memName = bufferDebugName + " memory";
     engine->util.debugNameObjectDeviceMemory(bufferMemory, memName.c_str());
@@ -770,7 +814,7 @@ void GlobalRendering::uploadBuffer(VkBufferUsageFlagBits usage, VkDeviceSize buf
     engine->globalRendering.copyBuffer(stagingBuffer, buffer, bufferSize, 0, queue);
 
     vkDestroyBuffer(engine->globalRendering.device, stagingBuffer, nullptr);
-    vkFreeMemory(engine->globalRendering.device, stagingBufferMemory, nullptr);
+    freeMemory(stagingBufferMemory);
     //vkDestroyBuffer(engine->global.device, buffer, nullptr);
     //vkFreeMemory(engine->global.device, bufferMemory, nullptr);
 }
@@ -796,10 +840,38 @@ uint64_t GlobalRendering::copyToGlobalBuffer(VkDeviceSize bufferSize, const void
     engine->globalRendering.copyBuffer(stagingBuffer, chunk->buffer, bufferSize, offset, queue);
 
     vkDestroyBuffer(engine->globalRendering.device, stagingBuffer, nullptr);
-    vkFreeMemory(engine->globalRendering.device, stagingBufferMemory, nullptr);
+    freeMemory(stagingBufferMemory);
     return offset;
 }
 
+void GlobalRendering::copyToGlobalBuffer(FrameResources* fr, VkDeviceSize bufferSize, const void* src, GPUMemoryChunk* chunk, const std::vector<VkBufferCopy>& regions)
+{
+    VkBuffer stagingBuffer;
+    VkDeviceMemory stagingBufferMemory;
+    createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        stagingBuffer, stagingBufferMemory, "Staging");
+
+    void* data;
+    vkMapMemory(device, stagingBufferMemory, 0, bufferSize, 0, &data);
+    memcpy(data, src, (size_t)bufferSize);
+    vkUnmapMemory(device, stagingBufferMemory);
+
+    auto commandBuffer = getFrameUploadCommandBuffer(fr);
+    vkCmdCopyBuffer(commandBuffer, stagingBuffer, chunk->buffer, static_cast<uint32_t>(regions.size()), regions.data());
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_TASK_SHADER_BIT_EXT | VK_PIPELINE_STAGE_MESH_SHADER_BIT_EXT,
+        0, 1, &barrier, 0, nullptr, 0, nullptr);
+    // staging buffer is read when this frame executes
+    destroyDeferred(fr, [this, stagingBuffer, stagingBufferMemory]() {
+        vkDestroyBuffer(device, stagingBuffer, nullptr);
+        freeMemory(stagingBufferMemory);
+    });
+}
+
 uint64_t GlobalRendering::uploadToGlobalBuffer(VkDeviceSize bufferSize, const void* src, GPUMemoryChunk* chunk, QueueSelector queue)
 {
     if (bufferSize % 4 != 0) {
@@ -893,6 +965,26 @@ VkImageView GlobalRendering::createImageView(VkImage image, VkFormat format, VkI
     return imageView;
 }
 
+VkImageView GlobalRendering::createImageViewLayers(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t baseLayer, uint32_t layerCount) {
+    VkImageViewCreateInfo viewInfo{};
+    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image = image;
+    viewInfo.viewType = layerCount == 1 ? VK_IMAGE_VIEW_TYPE_2D : VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+    viewInfo.format = format;
+    viewInfo.subresourceRange.aspectMask = aspectFlags;
+    viewInfo.subresourceRange.baseMipLevel = 0;
+    viewInfo.subresourceRange.levelCount = 1;
+    viewInfo.subresourceRange.baseArrayLayer = baseLayer;
+    viewInfo.subresourceRange.layerCount = layerCount;
+
+    VkImageView imageView;
+    if (vkCreateImageView(device, &viewInfo, nullptr, &imageView) != VK_SUCCESS) {
+        Error("failed to create layered image view!");
+    }
+
+    return imageView;
+}
+
 VkImageView GlobalRendering::createImageViewCube(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mipLevels) {
     VkImageViewCreateInfo viewInfo{};
     viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -954,6 +1046,7 @@ void GlobalRendering::createImage(uint32_t width, uint32_t height, uint32_t mipL
     }
 
     vkBindImageMemory(device, image, imageMemory, 0);
+    engine->memoryTracker.track(imageMemory, getImageMemoryTag(usage), MemoryDomain::Device, memRequirements.size);
     string memName = debugName;
     memName += "_dev_mem";
     engine->util.debugNameObjectDeviceMemory(imageMemory, memName.c_str());
@@ -1054,7 +1147,11 @@ void GlobalRendering::createCubeMapFrom2dTexture(string textureName2d, string te
     texture->vulkanTexture.viewType = VK_IMAGE_VIEW_TYPE_CUBE;
     texture->vulkanTexture.deviceMemory = attachment.memory;
     texture->isKtxCreated = false;
-    texture->imageView = createImageViewCube(texture->vulkanTexture.image, texture->vulkanTexture.imageFormat, VK_IMAGE_ASPECT_COLOR_BIT, texture->vulkanTexture.levelCount);
+    VkImageView view = createImageViewCube(texture->vulkanTexture.image, texture->vulkanTexture.imageFormat, VK_IMAGE_ASPECT_COLOR_BIT, texture->vulkanTexture.levelCount);
+    {
+        lock_guard<mutex> lock(engine->textureStore.descriptorMutex);
+        texture->imageView = view;
+    }
     engine->textureStore.setTextureActive(textureNameCube, true);
     //texture->available = true;
 }
@@ -1062,7 +1159,28 @@ void GlobalRendering::createCubeMapFrom2dTexture(string textureName2d, string te
 void GlobalRendering::destroyImage(VkImage image, VkDeviceMemory imageMemory)
 {
     vkDestroyImage(device, image, nullptr);
-    vkFreeMemory(device, imageMemory, nullptr);
+    freeMemory(imageMemory);
+}
+
+void GlobalRendering::freeMemory(VkDeviceMemory memory)
+{
+    engine->memoryTracker.untrack(memory);
+    vkFreeMemory(device, memory, nullptr);
+}
+
+MemoryTag GlobalRendering::getBufferMemoryTag(VkBufferUsageFlags usage, VkMemoryPropertyFlags properties)
+{
+    if (usage & VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT) return MemoryTag::Uniform;
+    if (usage & (VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT)) return MemoryTag::Mesh;
+    if ((usage & (VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT)) && (properties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)) return MemoryTag::Staging;
+    return MemoryTag::Other;
+}
+
+MemoryTag GlobalRendering::getImageMemoryTag(VkImageUsageFlags usage)
+{
+    if (usage & (VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT)) return MemoryTag::RenderTarget;
+    if (usage & VK_IMAGE_USAGE_SAMPLED_BIT) return MemoryTag::Texture;
+    return MemoryTag::Other;
 }
 
 void GlobalRendering::destroyImageView(VkImageView imageView)
@@ -1225,8 +1343,16 @@ void GlobalRendering::submit(FrameResources* fr)
     // wait for last submit to finish:
     vkWaitForFences(device, 1, &queueSubmitFence, VK_TRUE, UINT64_MAX);
     vkResetFences(device, 1, &queueSubmitFence);
-    // submit next frame
-    VkResult res = vkQueueSubmit(graphicsQueue, 1, &submitInfo, queueSubmitFence);
+    prepareFrameSubmit(fr);
+    // submit next frame, upload commands first: their barriers make the data visible to the draw commands
+    VkSubmitInfo submitInfos[2] = { submitInfo, submitInfo };
+    uint32_t submitCount = 1;
+    if (endFrameUploads(fr)) {
+        submitInfos[0].commandBufferCount = 1;
+        submitInfos[0].pCommandBuffers = &fr->uploadCommandBuffer;
+        submitCount = 2;
+    }
+    VkResult res = vkQueueSubmit(graphicsQueue, submitCount, &submitInfos[2 - submitCount], queueSubmitFence);
     if (res != VK_SUCCESS) {
         Log("submit failed " << res << endl);
         Error("failed to submit draw command buffer!");
@@ -1239,6 +1365,81 @@ void GlobalRendering::processImage(FrameResources* fr)
 {
 }
 
+VkCommandBuffer GlobalRendering::getFrameUploadCommandBuffer(FrameResources* fr)
+{
+    if (fr->uploadCommandBuffer == nullptr) {
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool = fr->commandPool;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandBufferCount = 1;
+        if (vkAllocateCommandBuffers(device, &allocInfo, &fr->uploadCommandBuffer) != VK_SUCCESS) {
+            Error("failed to allocate frame upload command buffer!");
+        }
+        engine->util.debugNameObjectCommandBuffer(fr->uploadCommandBuffer, engine->util.createDebugName("FrameUploadCommandBuffer_", fr->frameIndex).c_str());
+    }
+    if (!fr->uploadRecording) {
+        // last use of this command buffer was frameNum - framesInFlight, it has finished
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        if (vkBeginCommandBuffer(fr->uploadCommandBuffer, &beginInfo) != VK_SUCCESS) {
+            Error("failed to begin frame upload command buffer!");
+        }
+        fr->uploadRecording = true;
+    }
+    return fr->uploadCommandBuffer;
+}
+
+bool GlobalRendering::endFrameUploads(FrameResources* fr)
+{
+    if (!fr->uploadRecording) return false;
+    fr->uploadRecording = false;
+    if (vkEndCommandBuffer(fr->uploadCommandBuffer) != VK_SUCCESS) {
+        Error("failed to record frame upload command buffer!");
+    }
+    return true;
+}
+
+void GlobalRendering::destroyDeferred(FrameResources* fr, std::function<void()> destroy)
+{
+    lock_guard<mutex> lock(deferredMutex);
+    deferredDestroys.push_back({ fr->frameNum + engine->getFramesInFlight(), std::move(destroy) });
+}
+
+void GlobalRendering::prepareFrameSubmit(FrameResources* fr)
+{
+    {
+        lock_guard<mutex> lock(deferredMutex);
+        while (!deferredDestroys.empty() && deferredDestroys.front().releaseFrameNum <= fr->frameNum) {
+            deferredDestroys.front().destroy();
+            deferredDestroys.pop_front();
+        }
+    }
+    engine->textureResidency.updateForFrame(fr);
+}
+
+void GlobalRendering::submitFrameUploads(FrameResources* fr)
+{
+    if (!endFrameUploads(fr)) return;
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &fr->uploadCommandBuffer;
+    if (vkQueueSubmit(graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+        Error("failed to submit frame upload command buffer!");
+    }
+    vkQueueWaitIdle(graphicsQueue);
+}
+
+void GlobalRendering::releaseAllDeferred()
+{
+    for (auto& d : deferredDestroys) {
+        d.destroy();
+    }
+    deferredDestroys.clear();
+}
+
 void GlobalRendering::writeCubemapToFile(TextureInfo* cubemap, const std::string& filename) {
     // Ensure the cubemap is valid
     if (!cubemap || !cubemap->vulkanTexture.image) {
@@ -1386,7 +1587,7 @@ void GlobalRendering::writeCubemapToFile(TextureInfo* cubemap, const std::string
     // Clean up
     ktxTexture_Destroy(ktxTexture(kTexture));
     vkDestroyBuffer(engine->globalRendering.device, stagingBuffer, nullptr);
-    vkFreeMemory(engine->globalRendering.device, stagingBufferMemory, nullptr);
+    freeMemory(stagingBufferMemory);
 }
 
 void GlobalRendering::destroyImage(GPUImage* image)
@@ -140,7 +140,7 @@ public:
 				vkDestroyBuffer(device, chunk.buffer, nullptr);
 			}
 			if (chunk.memory != nullptr) {
-				vkFreeMemory(device, chunk.memory, nullptr);
+				freeMemory(chunk.memory);
 			}
         }
 		shutdown();
@@ -221,6 +221,9 @@ public:
 	uint64_t uploadToGlobalBuffer(VkDeviceSize bufferSize, const void* src, GPUMemoryChunk* chunk, QueueSelector queue = QueueSelector::GRAPHICS);
 	// Upload into pre-existing large buffer, return offset to buffer start
 	uint64_t copyToGlobalBuffer(VkDeviceSize bufferSize, const void* src, GPUMemoryChunk* chunk, uint64_t offset, QueueSelector queue = QueueSelector::GRAPHICS);
+	// Upload parts of src to scattered places of large buffer with one staging buffer, recorded into the upload commands of frame fr.
+	// regions: srcOffset into src, dstOffset into buffer. Data is visible to vertex, task and mesh shaders of this frame
+	void copyToGlobalBuffer(FrameResources* fr, VkDeviceSize bufferSize, const void* src, GPUMemoryChunk* chunk, const std::vector<VkBufferCopy>& regions);
 	// Upload index or vertex buffer
 	void uploadBuffer(VkBufferUsageFlagBits usage, VkDeviceSize bufferSize, const void* src, VkBuffer& buffer, VkDeviceMemory& bufferMemory,
 		std::string bufferDebugName, QueueSelector queue = QueueSelector::GRAPHICS, uint64_t flags = 0L );
@@ -231,6 +234,8 @@ public:
 	// images
 	VkImageView createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mipLevels);
 	VkImageView createImageViewCube(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mipLevels);
+	// view of layerCount layers starting at baseLayer, 2D array view if more than one layer. No mipmaps
+	VkImageView createImageViewLayers(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t baseLayer, uint32_t layerCount);
 	// create image and bound memory with default parameters - use layers == 6 for cube map
 	void createImage(uint32_t width, uint32_t height, uint32_t mipLevels, VkSampleCountFlagBits numSamples, VkFormat format,
 		VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory, const char* debugName, uint32_t layers = 1);
@@ -242,6 +247,11 @@ public:
 	void createCubeMapFrom2dTexture(std::string textureName2d, std::string textureNameCube);
 	void destroyImage(VkImage image, VkDeviceMemory imageMemory);
 	void destroyImageView(VkImageView imageView);
+	// free device memory and remove it from memory tracking. Use instead of vkFreeMemory()
+	void freeMemory(VkDeviceMemory memory);
+	// memory tracker tags of buffers and images created here, derived from usage
+	static MemoryTag getBufferMemoryTag(VkBufferUsageFlags usage, VkMemoryPropertyFlags properties);
+	static MemoryTag getImageMemoryTag(VkImageUsageFlags usage);
 
 	// fill in viewport and scissor and create VkPipelineViewportStateCreateInfo with them
 	void createViewportState(ShaderState &shaderState);
@@ -256,6 +266,8 @@ public:
 	VkSampler textureSampler_TEXTURE_TYPE_MIPMAP_IMAGE = nullptr;
 	VkSampler textureSampler_TEXTURE_TYPE_HEIGHT = nullptr;
 	SamplerCache samplerCache;
+	// persistent, stored next to shader folder. Use for all pipeline creation
+	PipelineCache pipelineCache;
 	//VkPhysicalDeviceProperties2 physicalDeviceProperties;
 	VkSemaphore singleTimeCommandsSemaphore = nullptr;
 	// create command pool for use outside rendering threads
@@ -327,6 +339,18 @@ public:
 	void postFrame(FrameResources* fr);
 	// submit command buffers, can only be called from queue submit thread
 	void submit(FrameResources* fr);
+	// transfer commands of this frame, submitted before the draw command buffers of the frame.
+	// Only from the thread currently owning fr: app thread while preparing the frame, then queue submit thread, see prepareFrameSubmit()
+	VkCommandBuffer getFrameUploadCommandBuffer(FrameResources* fr);
+	// destroy GPU resources replaced during this frame after all frames in flight that may use them have finished
+	void destroyDeferred(FrameResources* fr, std::function<void()> destroy);
+	// called before frame is submitted, when no earlier frame is executing on the GPU:
+	// release deferred resources of old frames and apply texture residency changes
+	void prepareFrameSubmit(FrameResources* fr);
+	// frames without command buffers (single thread mode, rendered images): submit upload commands and wait
+	void submitFrameUploads(FrameResources* fr);
+	// destroy all deferred resources, only after device wait idle
+	void releaseAllDeferred();
 	void writeCubemapToFile(TextureInfo* cubemap, const std::string& filename);
 	// get current GPU memory chunk, currently we do not allocate another one if the first is full...
     GPUMemoryChunk* getCurrentGPUMemoryChunk() {
@@ -367,6 +391,14 @@ private:
 	void consolidateCommandBuffers(CommandBufferArray& cmdBufs, FrameResources* fr);
 	// copy all cmd buffers here before calling vkQueueSubmit
 	CommandBufferArray submitCommandBuffers;
+	struct DeferredDestroy {
+		long releaseFrameNum; // first frame that may destroy the resources
+		std::function<void()> destroy;
+	};
+	std::deque<DeferredDestroy> deferredDestroys; // ordered by frame number
+	std::mutex deferredMutex; // app thread and queue submit thread add deferred destroys
+	// end recording, false if no upload commands were recorded for this frame
+	bool endFrameUploads(FrameResources* fr);
     // chain device feature structures, pNext pointer has to be directly after type
     void chainNextDeviceFeature(void* elder, void* child);
     bool isExtensionAvailable(const std::vector<const char*>& availableExtensions, const char* extensionName) {
@@ -404,6 +436,8 @@ private:
 	bool checkFeatureDescriptorIndexSize(DeviceInfo& info);
 	bool checkFeatureShaderInt64(DeviceInfo& info);
 	bool checkFeatureBindless64Buffer(DeviceInfo& info);
+	// optional feature, not part of isDeviceSuitable()
+	bool checkFeatureMultiview(DeviceInfo& info);
 	// swap chain support check, only available after real device creation, not during device selection
     bool checkFeatureSwapChain(VkPhysicalDevice physDevice);
 	// check extension support and optionally return list of supported extensions
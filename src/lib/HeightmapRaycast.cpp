@@ -0,0 +1,263 @@
+#include "mainheader.h"
+
+using namespace std;
+using namespace glm;
+
+// Node boxes are enlarged a little, so rays touching shared cell borders or the highest point of a cell are not lost
+// to rounding. This only costs a few extra cell tests, hits are always taken from the triangles.
+static constexpr float BOX_EPSILON = 1e-3f;
+
+void HeightmapRaycast::init(std::vector<float> heights, int samples, float minXZ, float maxXZ, std::vector<uint8_t> flippedCells)
+{
+	if (samples < 2 || heights.size() != static_cast<size_t>(samples) * samples) {
+		Error("HeightmapRaycast: heights have to be samples x samples values");
+	}
+	if (!flippedCells.empty() && flippedCells.size() != static_cast<size_t>(samples - 1) * (samples - 1)) {
+		Error("HeightmapRaycast: flippedCells needs one value per cell");
+	}
+	this->heights = std::move(heights);
+	this->flipped = std::move(flippedCells);
+	this->samples = samples;
+	this->minXZ = minXZ;
+	cells = samples - 1;
+	cellSize = (maxXZ - minXZ) / cells;
+
+	// level 0: one node per cell
+	levels.clear();
+	Level base;
+	base.size = cells;
+	base.minY.resize(static_cast<size_t>(cells) * cells);
+	base.maxY.resize(base.minY.size());
+	for (int z = 0; z < cells; z++) {
+		for (int x = 0; x < cells; x++) {
+			size_t s = static_cast<size_t>(z) * samples + x;
+			float h00 = this->heights[s], h10 = this->heights[s + 1];
+			float h01 = this->heights[s + samples], h11 = this->heights[s + samples + 1];
+			size_t i = static_cast<size_t>(z) * cells + x;
+			base.minY[i] = std::min(std::min(h00, h10), std::min(h01, h11));
+			base.maxY[i] = std::max(std::max(h00, h10), std::max(h01, h11));
+		}
+	}
+	levels.push_back(std::move(base));
+	// higher levels up to a single root node, odd sizes get nodes with fewer children at the border
+	while (levels.back().size > 1) {
+		const Level& below = levels.back();
+		Level l;
+		l.size = (below.size + 1) / 2;
+		l.minY.assign(static_cast<size_t>(l.size) * l.size, numeric_limits<float>::max());
+		l.maxY.assign(l.minY.size(), -numeric_limits<float>::max());
+		for (int z = 0; z < below.size; z++) {
+			for (int x = 0; x < below.size; x++) {
+				size_t from = static_cast<size_t>(z) * below.size + x;
+				size_t to = static_cast<size_t>(z / 2) * l.size + x / 2;
+				l.minY[to] = std::min(l.minY[to], below.minY[from]);
+				l.maxY[to] = std::max(l.maxY[to], below.maxY[from]);
+			}
+		}
+		levels.push_back(std::move(l));
+	}
+}
+
+void HeightmapRaycast::getCellTriangles(int x, int z, glm::vec3 tri[6]) const
+{
+	size_t s = static_cast<size_t>(z) * samples + x;
+	float x0 = minXZ + x * cellSize, x1 = minXZ + (x + 1) * cellSize;
+	float z0 = minXZ + z * cellSize, z1 = minXZ + (z + 1) * cellSize;
+	vec3 c00(x0, heights[s], z0);
+	vec3 c10(x1, heights[s + 1], z0);
+	vec3 c01(x0, heights[s + samples], z1);
+	vec3 c11(x1, heights[s + samples + 1], z1);
+	bool flip = !flipped.empty() && flipped[static_cast<size_t>(z) * cells + x];
+	if (!flip) {
+		tri[0] = c00; tri[1] = c11; tri[2] = c10;
+		tri[3] = c00; tri[4] = c01; tri[5] = c11;
+	} else {
+		tri[0] = c00; tri[1] = c01; tri[2] = c10;
+		tri[3] = c10; tri[4] = c01; tri[5] = c11;
+	}
+}
+
+bool HeightmapRaycast::intersectNode(const RayData& ray, int level, int x, int z, bool useHeights, float grow, float& tEnter, float& tExit) const
+{
+	int first = x << level, last = std::min((x + 1) << level, cells);
+	float eps = cellSize * grow;
+	float bmin[3] = { minXZ + first * cellSize - eps, 0.0f, 0.0f };
+	float bmax[3] = { minXZ + last * cellSize + eps, 0.0f, 0.0f };
+	first = z << level; last = std::min((z + 1) << level, cells);
+	bmin[2] = minXZ + first * cellSize - eps;
+	bmax[2] = minXZ + last * cellSize + eps;
+	if (useHeights) {
+		float minY = getMinHeight(level, x, z), maxY = getMaxHeight(level, x, z);
+		float epsY = BOX_EPSILON * std::max(1.0f, maxY - minY);
+		bmin[1] = minY - epsY;
+		bmax[1] = maxY + epsY;
+	}
+	tEnter = 0.0f;
+	tExit = ray.maxDistance;
+	for (int axis = 0; axis < 3; axis++) {
+		if (axis == 1 && !useHeights) continue;
+		if (ray.direction[axis] == 0.0f) {
+			// parallel to slab: inside or miss
+			if (ray.origin[axis] < bmin[axis] || ray.origin[axis] > bmax[axis]) return false;
+			continue;
+		}
+		float t0 = (bmin[axis] - ray.origin[axis]) * ray.invDirection[axis];
+		float t1 = (bmax[axis] - ray.origin[axis]) * ray.invDirection[axis];
+		if (t0 > t1) std::swap(t0, t1);
+		tEnter = std::max(tEnter, t0);
+		tExit = std::min(tExit, t1);
+		if (tEnter > tExit) return false;
+	}
+	return true;
+}
+
+// Moeller-Trumbore, both sides
+bool HeightmapRaycast::intersectCell(const RayData& ray, int x, int z, float& t, HeightmapHit& hit) const
+{
+	vec3 tri[6];
+	getCellTriangles(x, z, tri);
+	bool found = false;
+	for (int i = 0; i < 6; i += 3) {
+		vec3 e1 = tri[i + 1] - tri[i];
+		vec3 e2 = tri[i + 2] - tri[i];
+		vec3 p = cross(ray.direction, e2);
+		float det = dot(e1, p);
+		if (det == 0.0f) continue;
+		float invDet = 1.0f / det;
+		vec3 s = ray.origin - tri[i];
+		float u = dot(s, p) * invDet;
+		if (u < 0.0f || u > 1.0f) continue;
+		vec3 q = cross(s, e1);
+		float v = dot(ray.direction, q) * invDet;
+		if (v < 0.0f || u + v > 1.0f) continue;
+		float d = dot(e2, q) * invDet;
+		if (d < 0.0f || d >= t || d > ray.maxDistance) continue;
+		t = d;
+		vec3 n = normalize(cross(e1, e2));
+		hit.normal = n.y < 0.0f ? -n : n;
+		found = true;
+	}
+	return found;
+}
+
+bool HeightmapRaycast::traverse(const RayData& ray, bool anyHit, HeightmapHit& hit) const
+{
+	struct Node {
+		int level, x, z;
+		float tEnter;
+	};
+	// nearest children are pushed last, 3 siblings wait per level at most
+	Node stack[4 * 32];
+	int top = 0;
+	float tEnter, tExit;
+	int root = getLevelCount() - 1;
+	if (!intersectNode(ray, root, 0, 0, true, BOX_EPSILON, tEnter, tExit)) return false;
+	stack[top++] = { root, 0, 0, tEnter };
+	float best = numeric_limits<float>::max();
+	bool found = false;
+	while (top > 0) {
+		Node node = stack[--top];
+		if (node.tEnter >= best) continue;
+		if (node.level == 0) {
+			if (intersectCell(ray, node.x, node.z, best, hit)) {
+				found = true;
+				if (anyHit) break;
+			}
+			continue;
+		}
+		Node children[4];
+		int count = 0;
+		int level = node.level - 1;
+		int size = levels[level].size;
+		for (int c = 0; c < 4; c++) {
+			int cx = node.x * 2 + (c & 1), cz = node.z * 2 + (c >> 1);
+			if (cx >= size || cz >= size) continue;
+			if (anyHit) {
+				// segment below the lowest point of the node: blocked without looking at triangles
+				float s0, s1;
+				if (intersectNode(ray, level, cx, cz, false, -BOX_EPSILON, s0, s1)) {
+					float y = std::max(ray.origin.y + ray.direction.y * s0, ray.origin.y + ray.direction.y * s1);
+					if (y < getMinHeight(level, cx, cz)) {
+						best = s0;
+						found = true;
+						top = 0;
+						count = 0;
+						break;
+					}
+				}
+			}
+			if (!intersectNode(ray, level, cx, cz, true, BOX_EPSILON, tEnter, tExit)) continue;
+			// keep children sorted farthest first
+			int pos = count++;
+			while (pos > 0 && children[pos - 1].tEnter < tEnter) {
+				children[pos] = children[pos - 1];
+				pos--;
+			}
+			children[pos] = { level, cx, cz, tEnter };
+		}
+		for (int c = 0; c < count; c++) {
+			stack[top++] = children[c];
+		}
+		if (found && anyHit) break;
+	}
+	if (!found) return false;
+	hit.hit = true;
+	hit.distance = best;
+	hit.pos = ray.origin + ray.direction * best;
+	return true;
+}
+
+bool HeightmapRaycast::intersect(const HeightmapRay& ray, HeightmapHit& hit) const
+{
+	hit = HeightmapHit();
+	if (!isInitialized()) return false;
+	RayData r;
+	r.origin = ray.origin;
+	r.direction = ray.direction;
+	r.invDirection = vec3(1.0f) / ray.direction;
+	r.maxDistance = ray.maxDistance;
+	return traverse(r, false, hit);
+}
+
+void HeightmapRaycast::intersect(std::span<const HeightmapRay> rays, std::span<HeightmapHit> hits, ThreadGroup* threads) const
+{
+	if (hits.size() < rays.size()) {
+		Error("HeightmapRaycast: hits smaller than rays");
+	}
+	auto intersectRange = [this, rays, hits](size_t start, size_t end) {
+		for (size_t i = start; i < end; i++) {
+			intersect(rays[i], hits[i]);
+		}
+	};
+	size_t n = rays.size();
+	if (threads == nullptr || n <= PARALLEL_CHUNK_SIZE) {
+		intersectRange(0, n);
+		return;
+	}
+	size_t chunks = (n + PARALLEL_CHUNK_SIZE - 1) / PARALLEL_CHUNK_SIZE;
+	vector<future<void>> futures;
+	futures.reserve(chunks);
+	for (size_t c = 0; c < chunks; c++) {
+		size_t start = c * PARALLEL_CHUNK_SIZE;
+		size_t end = std::min(n, start + PARALLEL_CHUNK_SIZE);
+		futures.push_back(threads->asyncSubmit([&intersectRange, start, end] { intersectRange(start, end); }));
+	}
+	for (auto& f : futures) {
+		f.get();
+	}
+}
+
+bool HeightmapRaycast::isLineBlocked(const glm::vec3& from, const glm::vec3& to) const
+{
+	if (!isInitialized()) return false;
+	vec3 d = to - from;
+	float len = length(d);
+	if (len == 0.0f) return false;
+	RayData r;
+	r.origin = from;
+	r.direction = d / len;
+	r.invDirection = vec3(1.0f) / r.direction;
+	r.maxDistance = len;
+	HeightmapHit hit;
+	return traverse(r, true, hit);
+}
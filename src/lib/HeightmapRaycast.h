@@ -0,0 +1,89 @@
+#pragma once
+
+// Ray intersection with a height field.
+// Each grid cell is made of two triangles, like the terrain mesh. A min/max mip pyramid is built on top of the cells:
+// level 0 holds min and max height per cell, higher levels min and max of 2x2 nodes below. Rays walk the pyramid top down,
+// nodes are visited nearest first and skipped when the ray misses their box or a closer hit was already found,
+// so only a few cells along the ray are tested against their triangles. Results are exact against the triangles.
+// The min heights allow early out for line of sight: a segment below the lowest point of a node is blocked.
+// Runs completely on the CPU, no device needed.
+
+struct HeightmapRay {
+	glm::vec3 origin = glm::vec3(0.0f);
+	glm::vec3 direction = glm::vec3(0.0f, -1.0f, 0.0f); // normalized
+	float maxDistance = std::numeric_limits<float>::max();
+};
+
+struct HeightmapHit {
+	glm::vec3 pos = glm::vec3(0.0f);
+	glm::vec3 normal = glm::vec3(0.0f, 1.0f, 0.0f); // triangle normal, always pointing up
+	float distance = std::numeric_limits<float>::max();
+	bool hit = false;
+};
+
+class HeightmapRaycast
+{
+public:
+	// rays per task for parallel intersection
+	static constexpr size_t PARALLEL_CHUNK_SIZE = 1024;
+
+	// heights of samples x samples grid covering [minXZ, maxXZ] in x and z, index z * samples + x.
+	// Cell (x, z) is split along the diagonal from (x, z) to (x + 1, z + 1),
+	// or from (x + 1, z) to (x, z + 1) if flippedCells[z * (samples - 1) + x] is set (may be left empty)
+	void init(std::vector<float> heights, int samples, float minXZ, float maxXZ, std::vector<uint8_t> flippedCells = {});
+	bool isInitialized() const {
+		return cells > 0;
+	}
+
+	// nearest hit within ray.maxDistance, hit.hit is false if there is none
+	bool intersect(const HeightmapRay& ray, HeightmapHit& hit) const;
+	// hits[i] for rays[i], hits has to be at least as large as rays
+	void intersect(std::span<const HeightmapRay> rays, std::span<HeightmapHit> hits, ThreadGroup* threads = nullptr) const;
+	// true if the height field is between from and to (or one of them is below it)
+	bool isLineBlocked(const glm::vec3& from, const glm::vec3& to) const;
+
+	int getCells() const {
+		return cells;
+	}
+	int getLevelCount() const {
+		return static_cast<int>(levels.size());
+	}
+	// nodes per edge of level, level 0 has one node per cell
+	int getLevelSize(int level) const {
+		return levels[level].size;
+	}
+	float getMinHeight(int level, int x, int z) const {
+		return levels[level].minY[static_cast<size_t>(z) * levels[level].size + x];
+	}
+	float getMaxHeight(int level, int x, int z) const {
+		return levels[level].maxY[static_cast<size_t>(z) * levels[level].size + x];
+	}
+	// the two triangles of cell (x, z) in world coords, counter clockwise seen from above
+	void getCellTriangles(int x, int z, glm::vec3 tri[6]) const;
+
+private:
+	struct Level {
+		int size = 0;
+		std::vector<float> minY, maxY;
+	};
+	// ray in precomputed form for slab tests
+	struct RayData {
+		glm::vec3 origin, direction, invDirection;
+		float maxDistance;
+	};
+	// enter and exit distance of node box, false if missed. Without heights only the xz column is tested.
+	// grow enlarges (or shrinks if negative) the box in xz by this fraction of the cell size
+	bool intersectNode(const RayData& ray, int level, int x, int z, bool useHeights, float grow, float& tEnter, float& tExit) const;
+	// nearest triangle hit of cell closer than t, updates t and hit
+	bool intersectCell(const RayData& ray, int x, int z, float& t, HeightmapHit& hit) const;
+	// walk pyramid, stop at first hit if anyHit is set
+	bool traverse(const RayData& ray, bool anyHit, HeightmapHit& hit) const;
+
+	std::vector<float> heights;
+	std::vector<uint8_t> flipped;
+	int samples = 0;
+	int cells = 0;
+	float minXZ = 0.0f;
+	float cellSize = 0.0f;
+	std::vector<Level> levels;
+};
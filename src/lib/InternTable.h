@@ -0,0 +1,81 @@
+#pragma once
+
+// Interned ids: names of meshes, textures, object groups and sounds are resolved once at load time
+// to small typed handles. Handles index plain vectors, so per object and per frame code does
+// not hash or compare strings. String based APIs of the stores are thin wrappers around the handle APIs.
+// Ids are never reused: a name keeps its id even if the named resource is unloaded.
+
+template<typename Tag>
+struct TypedId {
+	static constexpr uint32_t INVALID = UINT32_MAX;
+	uint32_t value = INVALID;
+	bool isValid() const {
+		return value != INVALID;
+	}
+	bool operator==(const TypedId& other) const {
+		return value == other.value;
+	}
+};
+
+struct MeshIdTag;
+struct TextureIdTag;
+struct GroupIdTag;
+struct SoundIdTag;
+using MeshId = TypedId<MeshIdTag>;
+// not to be confused with TextureID (pointer to TextureInfo)
+using TextureId = TypedId<TextureIdTag>;
+using GroupId = TypedId<GroupIdTag>;
+using SoundId = TypedId<SoundIdTag>;
+
+// string <-> id table for one id type, ids are consecutive starting at 0.
+// Not thread safe, names are interned while loading
+template<typename Id>
+class InternTable
+{
+public:
+	// id of name, new id if name was not seen before
+	Id intern(std::string_view name) {
+		auto it = ids.find(name);
+		if (it != ids.end()) {
+			return Id{ it->second };
+		}
+		uint32_t value = static_cast<uint32_t>(names.size());
+		names.emplace_back(name);
+		ids.emplace(names.back(), value);
+		return Id{ value };
+	}
+	// id of name, invalid id if name was never interned
+	Id find(std::string_view name) const {
+		auto it = ids.find(name);
+		return it == ids.end() ? Id{} : Id{ it->second };
+	}
+	const std::string& name(Id id) const {
+		return names[id.value];
+	}
+	bool contains(Id id) const {
+		return id.value < names.size();
+	}
+	// number of interned names, all ids are < size()
+	size_t size() const {
+		return names.size();
+	}
+	void reserve(size_t n) {
+		names.reserve(n);
+		ids.reserve(n);
+	}
+	void clear() {
+		names.clear();
+		ids.clear();
+	}
+
+private:
+	// heterogeneous lookup: find() with string_view does not create a temporary string
+	struct NameHash {
+		using is_transparent = void;
+		size_t operator()(std::string_view s) const {
+			return std::hash<std::string_view>{}(s);
+		}
+	};
+	std::vector<std::string> names;
+	std::unordered_map<std::string, uint32_t, NameHash, std::equal_to<>> ids;
+};
@@ -5,11 +5,12 @@ using namespace std;
 void LineShader::init(ShadedPathEngine& engine, ShaderState &shaderState)
 {
 	ShaderBase::init(engine);
+	multiviewSupported = true;
 	//engine.globalUpdate.registerShader(this);
 	resources.setResourceDefinition(&vulkanResourceDefinition);
 
 	// create shader modules
-	vertShaderModule = resources.createShaderModule("line.vert.spv");
+	vertShaderModule = resources.createShaderModule(isMultiview() ? "line_multiview.vert.spv" : "line.vert.spv");
 	fragShaderModule = resources.createShaderModule("line.frag.spv");
 
 	// descriptor set layout
@@ -230,10 +231,10 @@ LineShader::~LineShader()
     auto& sub = globalUpdateLineSubShaders[0];
 	if (sub.activeUpdateElement.vertexBuffer != nullptr) {
 		vkDestroyBuffer(device, sub.activeUpdateElement.vertexBuffer, nullptr);
-		vkFreeMemory(device, sub.activeUpdateElement.vertexBufferMemory, nullptr);
+		engine->globalRendering.freeMemory(sub.activeUpdateElement.vertexBufferMemory);
 	}
 	vkDestroyBuffer(device, vertexBufferFixedGlobal, nullptr);
-	vkFreeMemory(device, vertexBufferMemoryFixedGlobal, nullptr);
+	engine->globalRendering.freeMemory(vertexBufferMemoryFixedGlobal);
 	vkDestroyShaderModule(device, fragShaderModule, nullptr);
 	vkDestroyShaderModule(device, vertShaderModule, nullptr);
 	vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
@@ -254,12 +255,13 @@ void LineSubShader::init(LineShader* parent, std::string debugName) {
 void LineSubShader::initSingle(FrameResources& tr, ShaderState& shaderState)
 {
 	frameResources = &tr;
-	// MVP uniform buffer
-	lineShader->createUniformBuffer(uniformBuffer, sizeof(LineShader::UniformBufferObject),
+	// MVP uniform buffer, multiview: one buffer for both eyes
+	auto uboSize = lineShader->isMultiview() ? LineShader::getMultiviewUBOSize(sizeof(LineShader::UniformBufferObject)) : sizeof(LineShader::UniformBufferObject);
+	lineShader->createUniformBuffer(uniformBuffer, uboSize,
 		uniformBufferMemory);
 	engine->util.debugNameObjectBuffer(uniformBuffer, "Line UBO 1");
 	engine->util.debugNameObjectDeviceMemory(uniformBufferMemory, "Line Memory 1");
-	if (engine->isStereo()) {
+	if (engine->isStereo() && !lineShader->isMultiview()) {
 		lineShader->createUniformBuffer(uniformBuffer2, sizeof(LineShader::UniformBufferObject), uniformBufferMemory2);
 		engine->util.debugNameObjectBuffer(uniformBuffer2, "Line UBO 2");
 		engine->util.debugNameObjectDeviceMemory(uniformBufferMemory2, "Line Memory 2");
@@ -268,6 +270,11 @@ void LineSubShader::initSingle(FrameResources& tr, ShaderState& shaderState)
 	handover.mvpBuffer = uniformBuffer;
 	handover.mvpBuffer2 = uniformBuffer2;
 	handover.mvpSize = sizeof(LineShader::UniformBufferObject);
+	if (lineShader->isMultiview()) {
+		// descriptorSet2 is still allocated in stereo mode, but never bound
+		handover.mvpBuffer2 = uniformBuffer;
+		handover.mvpSize = uboSize;
+	}
 	handover.imageView = nullptr;
 	handover.descriptorSet = &descriptorSet;
 	handover.descriptorSet2 = &descriptorSet2;
@@ -337,9 +344,7 @@ void LineSubShader::initSingle(FrameResources& tr, ShaderState& shaderState)
 	pipelineInfo.subpass = 0;
 	pipelineInfo.basePipelineHandle = VK_NULL_HANDLE; // Optional
 	pipelineInfo.basePipelineIndex = -1; // Optional
-	if (vkCreateGraphicsPipelines(lineShader->device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &graphicsPipeline) != VK_SUCCESS) {
-		Error("failed to create graphics pipeline!");
-	}
+	engine->globalRendering.pipelineCache.createGraphicsPipelineDeferred(pipelineInfo, &graphicsPipeline);
 }
 
 void LineSubShader::allocateCommandBuffer(FrameResources& tr, VkCommandBuffer* cmdBuferPtr, const char* debugName)
@@ -379,7 +384,7 @@ void LineSubShader::addRenderPassAndDrawCommands(FrameResources& tr, VkCommandBu
 	vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
 	recordDrawCommand(commandBuffer, tr, vertexBuffer);
 	vkCmdEndRenderPass(commandBuffer);
-	if (engine->isStereo()) {
+	if (engine->isStereo() && !lineShader->isMultiview()) {
 		renderPassInfo.framebuffer = framebuffer2;
 		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
 		recordDrawCommand(commandBuffer, tr, vertexBuffer, true);
@@ -417,6 +422,10 @@ void LineSubShader::recordDrawCommand(VkCommandBuffer& commandBuffer, FrameResou
 
 void LineSubShader::uploadToGPU(FrameResources& tr, LineShader::UniformBufferObject& ubo, LineShader::UniformBufferObject& ubo2) {
 	if (drawCount == 0) return;
+	if (lineShader->isMultiview()) {
+		lineShader->uploadMultiviewUBO(uniformBufferMemory, &ubo, &ubo2, sizeof(ubo));
+		return;
+	}
 	// copy ubo to GPU:
 	auto& device = lineShader->device;
 	void* data;
@@ -439,10 +448,10 @@ void LineSubShader::destroy() {
 	vkDestroyBuffer(*device, uniformBuffer, nullptr);
 	vkDestroyBuffer(*device, uniformBuffer2, nullptr);
     //vkFreeCommandBuffers(*device, frameResources->commandPool, 1, &commandBuffer);
-	vkFreeMemory(*device, uniformBufferMemory, nullptr);
-	vkFreeMemory(*device, uniformBufferMemory2, nullptr);
+	engine->globalRendering.freeMemory(uniformBufferMemory);
+	engine->globalRendering.freeMemory(uniformBufferMemory2);
 	vkDestroyBuffer(*device, vertexBufferLocal, nullptr);
-	vkFreeMemory(*device, vertexBufferMemoryLocal, nullptr);
+	engine->globalRendering.freeMemory(vertexBufferMemoryLocal);
 }
 
 void LineShader::applyGlobalUpdate(FrameResources& tr)
@@ -455,7 +464,7 @@ void LineShader::applyGlobalUpdate(FrameResources& tr)
 	if (sub.active && oldUpdateInUse == 0) {
 		vkDestroyBuffer(device, sub.activeUpdateElement.vertexBuffer, nullptr);
         sub.activeUpdateElement.vertexBuffer = nullptr;
-		vkFreeMemory(device, sub.activeUpdateElement.vertexBufferMemory, nullptr);
+		engine->globalRendering.freeMemory(sub.activeUpdateElement.vertexBufferMemory);
         sub.activeUpdateElement.vertexBufferMemory = nullptr;
 	}
 	// copy update element so sub shader element:
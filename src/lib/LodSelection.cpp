@@ -0,0 +1,289 @@
+#include "mainheader.h"
+
+using namespace std;
+using namespace glm;
+
+// Projected radius in pixels of a sphere with radius r at distance d is s = r * k / d
+// with k = viewportHeight / (2 * tan(fovy / 2)).
+// Threshold test s < t is done without sqrt and division as r^2 * k^2 < t^2 * d^2
+
+LodSelection::LodSelection()
+{
+	// default: roughly halve the projected size for each LOD step
+	screenThresholds = { 256.0f, 128.0f, 64.0f, 32.0f, 16.0f, 8.0f, 4.0f, 2.0f, 1.0f };
+	setViewport(glm::radians(45.0f), 1080.0f);
+}
+
+void LodSelectionStats::log() const
+{
+	Log("LOD selection: triangles " << totalTriangles << " invisible objects " << invisibleObjects << " threshold scale " << thresholdScale << endl);
+	for (int i = 0; i < MAX_LOD; i++) {
+		if (objectsPerLod[i] == 0) continue;
+		Log("  LOD " << i << ": objects " << objectsPerLod[i] << " triangles " << trianglesPerLod[i] << endl);
+	}
+}
+
+void LodSelection::resizeArrays(size_t n)
+{
+	// padded lanes have radius 0 and are never visible
+	size_t padded = simdPaddedSize(n);
+	posX.resize(padded, 0.0f);
+	posY.resize(padded, 0.0f);
+	posZ.resize(padded, 0.0f);
+	radiusSq.resize(padded, 0.0f);
+	maxLod.resize(padded, 0.0f);
+	currentLod.resize(padded, 0.0f);
+	selectedLod.resize(padded, LOD_INVISIBLE);
+	triangles.resize(padded * MAX_LOD, 0);
+	worldObjects.resize(padded, nullptr);
+}
+
+size_t LodSelection::addObject(glm::vec3 center, float radius, int lodCount, const uint32_t* trianglesPerLod, WorldObject* wo)
+{
+	if (lodCount < 1 || lodCount > MAX_LOD) {
+		Error("LodSelection: lodCount out of range");
+	}
+	size_t index = count++;
+	resizeArrays(count);
+	posX[index] = center.x;
+	posY[index] = center.y;
+	posZ[index] = center.z;
+	radiusSq[index] = radius * radius;
+	maxLod[index] = static_cast<float>(lodCount - 1);
+	currentLod[index] = 0.0f;
+	for (int i = 0; i < lodCount; i++) {
+		triangles[index * MAX_LOD + i] = trianglesPerLod[i];
+	}
+	worldObjects[index] = wo;
+	return index;
+}
+
+void LodSelection::setObjectPosition(size_t index, glm::vec3 center)
+{
+	posX[index] = center.x;
+	posY[index] = center.y;
+	posZ[index] = center.z;
+}
+
+void LodSelection::setObjectRadius(size_t index, float radius)
+{
+	radiusSq[index] = radius * radius;
+}
+
+void LodSelection::clearObjects()
+{
+	count = 0;
+	posX.clear();
+	posY.clear();
+	posZ.clear();
+	radiusSq.clear();
+	maxLod.clear();
+	currentLod.clear();
+	selectedLod.clear();
+	triangles.clear();
+	worldObjects.clear();
+	stats.clear();
+}
+
+void LodSelection::setScreenThresholds(const std::vector<float>& pixelRadius)
+{
+	if (pixelRadius.size() > MAX_LOD - 1) {
+		Error("LodSelection: too many screen thresholds");
+	}
+	for (size_t i = 1; i < pixelRadius.size(); i++) {
+		if (pixelRadius[i] > pixelRadius[i - 1]) {
+			Error("LodSelection: screen thresholds have to be descending");
+		}
+	}
+	screenThresholds = pixelRadius;
+}
+
+void LodSelection::setViewport(float fovy, float viewportHeight)
+{
+	pixelFactor = viewportHeight / (2.0f * tan(fovy / 2.0f));
+}
+
+void LodSelection::select(glm::vec3 cameraPos, ThreadGroup* threads, bool useSimd)
+{
+	stats.clear();
+	stats.thresholdScale = thresholdScale;
+	selectCameraPos = cameraPos;
+	// squared thresholds for lower and upper hysteresis band, scaled to world units via pixelFactor
+	size_t n = screenThresholds.size();
+	float k2 = pixelFactor * pixelFactor;
+	for (size_t i = 0; i < n; i++) {
+		float t = screenThresholds[i] * thresholdScale;
+		float lo = t * (1.0f - hysteresis);
+		float hi = t * (1.0f + hysteresis);
+		thresholdLowSq[i] = lo * lo / k2;
+		thresholdHighSq[i] = hi * hi / k2;
+	}
+	// cull size is scaled too, otherwise the budget could not be reached for many far away objects
+	float c = cullSize * thresholdScale;
+	cullSq = c * c / k2;
+
+	if (threads == nullptr || count <= PARALLEL_CHUNK_SIZE) {
+		if (useSimd) selectRangeSimd(0, count, stats);
+		else selectRangeScalar(0, count, stats);
+	} else {
+		size_t chunks = (count + PARALLEL_CHUNK_SIZE - 1) / PARALLEL_CHUNK_SIZE;
+		vector<LodSelectionStats> partial(chunks);
+		vector<future<void>> futures;
+		futures.reserve(chunks);
+		for (size_t c = 0; c < chunks; c++) {
+			size_t start = c * PARALLEL_CHUNK_SIZE;
+			size_t end = std::min(count, start + PARALLEL_CHUNK_SIZE);
+			futures.push_back(threads->asyncSubmit([this, start, end, useSimd, &partial, c] {
+				if (useSimd) selectRangeSimd(start, end, partial[c]);
+				else selectRangeScalar(start, end, partial[c]);
+			}));
+		}
+		for (size_t c = 0; c < chunks; c++) {
+			futures[c].wait();
+			stats.add(partial[c]);
+		}
+	}
+	adaptThresholdScale();
+}
+
+// start is always a multiple of SIMD_WIDTH, arrays are padded so the last batch may run past end
+void LodSelection::selectRangeSimd(size_t start, size_t end, LodSelectionStats& s)
+{
+	size_t n = screenThresholds.size();
+	Float4 camX(selectCameraPos.x), camY(selectCameraPos.y), camZ(selectCameraPos.z);
+	Float4 cull(cullSq);
+	for (size_t i = start; i < end; i += SIMD_WIDTH) {
+		Float4 dx = Float4::load(&posX[i]) - camX;
+		Float4 dy = Float4::load(&posY[i]) - camY;
+		Float4 dz = Float4::load(&posZ[i]) - camZ;
+		Float4 distSq = dx * dx + dy * dy + dz * dz;
+		Float4 r2 = Float4::load(&radiusSq[i]);
+		Float4 lodLow, lodHigh;
+		for (size_t t = 0; t < n; t++) {
+			lodLow = Float4::countIf(lodLow, Float4::lessThan(r2, Float4(thresholdLowSq[t]) * distSq));
+			lodHigh = Float4::countIf(lodHigh, Float4::lessThan(r2, Float4(thresholdHighSq[t]) * distSq));
+		}
+		// keep previous LOD as long as it is within the hysteresis band
+		Float4 lod = Float4::min(Float4::max(Float4::load(&currentLod[i]), lodLow), lodHigh);
+		lod = Float4::min(lod, Float4::load(&maxLod[i]));
+		lod.store(&currentLod[i]);
+		int culled = Float4::moveMask(Float4::lessThan(r2, cull * distSq));
+		for (int lane = 0; lane < SIMD_WIDTH; lane++) {
+			selectedLod[i + lane] = (culled & (1 << lane)) ? LOD_INVISIBLE : static_cast<int>(currentLod[i + lane]);
+		}
+	}
+	accumulateStats(start, end, s);
+}
+
+void LodSelection::selectRangeScalar(size_t start, size_t end, LodSelectionStats& s)
+{
+	size_t n = screenThresholds.size();
+	for (size_t i = start; i < end; i++) {
+		float dx = posX[i] - selectCameraPos.x;
+		float dy = posY[i] - selectCameraPos.y;
+		float dz = posZ[i] - selectCameraPos.z;
+		float distSq = dx * dx + dy * dy + dz * dz;
+		float r2 = radiusSq[i];
+		float lodLow = 0.0f, lodHigh = 0.0f;
+		for (size_t t = 0; t < n; t++) {
+			if (r2 < thresholdLowSq[t] * distSq) lodLow += 1.0f;
+			if (r2 < thresholdHighSq[t] * distSq) lodHigh += 1.0f;
+		}
+		float lod = std::min(std::max(currentLod[i], lodLow), lodHigh);
+		lod = std::min(lod, maxLod[i]);
+		currentLod[i] = lod;
+		selectedLod[i] = (r2 < cullSq * distSq) ? LOD_INVISIBLE : static_cast<int>(lod);
+	}
+	accumulateStats(start, end, s);
+}
+
+void LodSelection::accumulateStats(size_t start, size_t end, LodSelectionStats& s)
+{
+	for (size_t i = start; i < end; i++) {
+		int lod = selectedLod[i];
+		if (lod == LOD_INVISIBLE) {
+			s.invisibleObjects++;
+			continue;
+		}
+		uint32_t tri = triangles[i * MAX_LOD + lod];
+		s.objectsPerLod[lod]++;
+		s.trianglesPerLod[lod] += tri;
+		s.totalTriangles += tri;
+	}
+}
+
+// triangle count is roughly proportional to projected area, so scale thresholds with the square root of the overshoot.
+// relax slowly once we are clearly below budget to avoid oscillation
+void LodSelection::adaptThresholdScale()
+{
+	if (triangleBudget == 0) return;
+	if (stats.totalTriangles > triangleBudget) {
+		float overshoot = sqrt(static_cast<float>(stats.totalTriangles) / static_cast<float>(triangleBudget));
+		thresholdScale = std::min(maxThresholdScale, thresholdScale * std::clamp(overshoot, 1.05f, 2.0f));
+	} else if (stats.totalTriangles < triangleBudget * 9 / 10 && thresholdScale > 1.0f) {
+		thresholdScale = std::max(1.0f, thresholdScale * 0.95f);
+	}
+}
+
+void LodSelection::registerWorldObjects()
+{
+	clearObjects();
+	for (WorldObject* wo : engine->objectStore.getSortedList()) {
+		if (wo->useGpuLod || wo->mesh == nullptr) continue;
+		auto coll = engine->meshStore.meshCollectionStore.getMeshCollectionByIndex((int)wo->mesh->collectionStoreIndex);
+		if (coll == nullptr) continue;
+		int lodCount = std::min(coll->primMap.getMajorMeshCount(), MAX_LOD);
+		if (lodCount < 2) continue;
+		uint32_t tris[MAX_LOD] = {};
+		for (int lod = 0; lod < lodCount; lod++) {
+			for (int p = 0; p < wo->primitiveCount; p++) {
+				MeshInfo* mi = coll->getMeshInfo(lod, p);
+				if (mi == nullptr) continue;
+				size_t idx = mi->indices.size() > 0 ? mi->indices.size() : mi->outLocalIndexPrimitivesBuffer.size();
+				tris[lod] += static_cast<uint32_t>(idx / 3);
+			}
+		}
+		// conservative sphere around object origin, rotation independent
+		BoundingBox box;
+		wo->mesh->getBoundingBox(box);
+		float maxScale = std::max(wo->scale().x, std::max(wo->scale().y, wo->scale().z));
+		float radius = std::max(glm::length(box.min), glm::length(box.max)) * maxScale;
+		addObject(wo->pos(), radius, lodCount, tris, wo);
+	}
+	Log("LodSelection registered " << count << " objects for CPU LOD" << endl);
+}
+
+// call from prepareFrame(), worker threads are used for large object counts
+void LodSelection::updatePerFrame(FrameResources& fr, glm::vec3 cameraPos)
+{
+	for (size_t i = 0; i < count; i++) {
+		if (worldObjects[i]) setObjectPosition(i, worldObjects[i]->pos());
+	}
+	select(cameraPos, engine->getWorkerThreads());
+	applyToModels(fr);
+}
+
+// objects disabled by application code are left untouched
+void LodSelection::applyToModels(FrameResources& fr)
+{
+	for (size_t i = 0; i < count; i++) {
+		WorldObject* wo = worldObjects[i];
+		if (wo == nullptr || !wo->enabled) continue;
+		int lod = selectedLod[i];
+		auto coll = engine->meshStore.meshCollectionStore.getMeshCollectionByIndex((int)wo->mesh->collectionStoreIndex);
+		for (int p = 0; p < wo->primitiveCount; p++) {
+			PBRShader::DynamicModelUBO* buf = engine->shaders.pbrShader.getAccessToModel(fr, wo->dynamicModelUBOIndex + p);
+			if (lod == LOD_INVISIBLE) {
+				buf->disableRendering();
+				continue;
+			}
+			MeshInfo* mi = coll->getMeshInfo(lod, p);
+			if (mi == nullptr) {
+				buf->disableRendering();
+				continue;
+			}
+			buf->enableRendering();
+			buf->meshNumber = mi->meshNum;
+		}
+	}
+}
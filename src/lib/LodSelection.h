@@ -0,0 +1,127 @@
+#pragma once
+
+// CPU side LOD selection for all objects that do not use GPU LOD (WorldObject::useGpuLod == false).
+// LOD is chosen from the projected size of the object bounding sphere (screen-space error):
+// LOD 0 is used while the projected radius in pixels is above screen threshold 0, LOD 1 above threshold 1 and so on.
+// Hysteresis bands around each threshold prevent popping when objects move along a LOD boundary.
+// An optional triangle budget scales all thresholds adaptively from frame to frame.
+// Object data is kept in SoA arrays and processed in SIMD batches (see SimdMath.h).
+
+struct LodSelectionStats {
+	static constexpr int MAX_LOD = 10;
+	std::array<uint64_t, MAX_LOD> trianglesPerLod{};
+	std::array<uint32_t, MAX_LOD> objectsPerLod{};
+	uint32_t invisibleObjects = 0; // below cull size
+	uint64_t totalTriangles = 0;
+	float thresholdScale = 1.0f; // threshold scale used for this selection run
+	void clear() {
+		trianglesPerLod.fill(0);
+		objectsPerLod.fill(0);
+		invisibleObjects = 0;
+		totalTriangles = 0;
+	}
+	void add(const LodSelectionStats& other) {
+		for (int i = 0; i < MAX_LOD; i++) {
+			trianglesPerLod[i] += other.trianglesPerLod[i];
+			objectsPerLod[i] += other.objectsPerLod[i];
+		}
+		invisibleObjects += other.invisibleObjects;
+		totalTriangles += other.totalTriangles;
+	}
+	void log() const;
+};
+
+class LodSelection : public EngineParticipant
+{
+public:
+	static constexpr int MAX_LOD = LodSelectionStats::MAX_LOD;
+	static constexpr int LOD_INVISIBLE = -1;
+	// chunk size for parallel selection, multiple of SIMD_WIDTH
+	static constexpr size_t PARALLEL_CHUNK_SIZE = 4096;
+
+	LodSelection();
+
+	// object data
+	// add object with bounding sphere and triangle count for each of its lodCount LOD levels.
+	// returns index to be used for all other object calls
+	size_t addObject(glm::vec3 center, float radius, int lodCount, const uint32_t* trianglesPerLod, WorldObject* wo = nullptr);
+	void setObjectPosition(size_t index, glm::vec3 center);
+	void setObjectRadius(size_t index, float radius);
+	void clearObjects();
+	size_t size() const {
+		return count;
+	}
+
+	// settings
+	// screen thresholds are projected radius in pixels, descending. At most MAX_LOD - 1 values.
+	void setScreenThresholds(const std::vector<float>& pixelRadius);
+	// relative width of hysteresis band, 0.1 means +-10% around each threshold
+	void setHysteresis(float h) {
+		hysteresis = h;
+	}
+	// objects with projected radius below this pixel size are not rendered at all. 0 disables culling
+	void setCullSize(float pixelRadius) {
+		cullSize = pixelRadius;
+	}
+	// max triangles per frame. 0 means unlimited
+	void setTriangleBudget(uint64_t budget) {
+		triangleBudget = budget;
+		if (budget == 0) thresholdScale = 1.0f;
+	}
+	// vertical field of view in radians and viewport height in pixels
+	void setViewport(float fovy, float viewportHeight);
+
+	// run LOD selection for current camera position.
+	// threads == nullptr runs on the calling thread, useSimd == false runs the scalar reference path
+	void select(glm::vec3 cameraPos, ThreadGroup* threads = nullptr, bool useSimd = true);
+
+	// selected LOD of object, LOD_INVISIBLE if culled
+	int getLod(size_t index) const {
+		return selectedLod[index];
+	}
+	const LodSelectionStats& getStats() const {
+		return stats;
+	}
+	float getThresholdScale() const {
+		return thresholdScale;
+	}
+
+	// engine integration
+	// register all non GPU-LOD objects from engine object store. Objects with a single LOD are skipped.
+	void registerWorldObjects();
+	// update object positions from WorldObjects, run selection and write results to DynamicModelUBO of each primitive
+	void updatePerFrame(FrameResources& fr, glm::vec3 cameraPos);
+	// write current selection to DynamicModelUBO of each registered primitive
+	void applyToModels(FrameResources& fr);
+
+private:
+	void selectRangeSimd(size_t start, size_t end, LodSelectionStats& s);
+	void selectRangeScalar(size_t start, size_t end, LodSelectionStats& s);
+	void accumulateStats(size_t start, size_t end, LodSelectionStats& s);
+	void adaptThresholdScale();
+	void resizeArrays(size_t n);
+
+	// SoA object data, padded to SIMD_WIDTH
+	std::vector<float> posX, posY, posZ;
+	std::vector<float> radiusSq;
+	std::vector<float> maxLod; // lodCount - 1
+	std::vector<float> currentLod; // hysteresis state, kept while object is culled
+	std::vector<int> selectedLod;
+	std::vector<uint32_t> triangles; // MAX_LOD entries per object
+	std::vector<WorldObject*> worldObjects;
+	size_t count = 0;
+
+	std::vector<float> screenThresholds;
+	// per selection run, precomputed in select()
+	glm::vec3 selectCameraPos = glm::vec3(0.0f);
+	std::array<float, MAX_LOD> thresholdLowSq{};
+	std::array<float, MAX_LOD> thresholdHighSq{};
+	float cullSq = 0.0f;
+	float hysteresis = 0.1f;
+	float cullSize = 0.0f;
+	float pixelFactor = 1.0f; // viewportHeight / (2 * tan(fovy/2))
+	uint64_t triangleBudget = 0;
+	float thresholdScale = 1.0f;
+	const float maxThresholdScale = 64.0f;
+	LodSelectionStats stats;
+};
@@ -0,0 +1,163 @@
+#include "mainheader.h"
+
+using namespace std;
+
+bool MemoryTracker::add(MemoryTag tag, MemoryDomain domain, uint64_t bytes)
+{
+	MemoryTagStats& s = stats(tag, domain);
+	uint64_t before = s.currentBytes;
+	s.currentBytes += bytes;
+	s.peakBytes = std::max(s.peakBytes, s.currentBytes);
+	s.allocations++;
+	s.totalAllocations++;
+	size_t d = static_cast<size_t>(domain);
+	totals[d] += bytes;
+	peakTotals[d] = std::max(peakTotals[d], totals[d]);
+	if (s.budgetBytes == 0 || s.currentBytes <= s.budgetBytes) return true;
+	s.overBudget++;
+	if (s.budgetAction == MemoryBudgetAction::Fail) {
+		stringstream msg;
+		msg << "MemoryTracker: " << getTagName(tag) << " " << getDomainName(domain) << " memory budget of "
+			<< s.budgetBytes << " bytes exceeded: " << s.currentBytes;
+		Error(msg.str());
+	}
+	if (before <= s.budgetBytes) {
+		Log("WARNING: " << getTagName(tag) << " " << getDomainName(domain) << " memory over budget: " << s.currentBytes
+			<< " of " << s.budgetBytes << " bytes" << endl);
+	}
+	return false;
+}
+
+void MemoryTracker::remove(MemoryTag tag, MemoryDomain domain, uint64_t bytes)
+{
+	MemoryTagStats& s = stats(tag, domain);
+	if (bytes > s.currentBytes || s.allocations == 0) {
+		Error("MemoryTracker: released more memory than allocated");
+	}
+	s.currentBytes -= bytes;
+	s.allocations--;
+	totals[static_cast<size_t>(domain)] -= bytes;
+}
+
+bool MemoryTracker::allocate(MemoryTag tag, MemoryDomain domain, uint64_t bytes)
+{
+	lock_guard<mutex> lock(trackerMutex);
+	return add(tag, domain, bytes);
+}
+
+void MemoryTracker::release(MemoryTag tag, MemoryDomain domain, uint64_t bytes)
+{
+	lock_guard<mutex> lock(trackerMutex);
+	remove(tag, domain, bytes);
+}
+
+bool MemoryTracker::track(const void* key, MemoryTag tag, MemoryDomain domain, uint64_t bytes)
+{
+	lock_guard<mutex> lock(trackerMutex);
+	auto it = keyed.find(key);
+	if (it != keyed.end()) {
+		remove(it->second.tag, it->second.domain, it->second.bytes);
+		it->second = { tag, domain, bytes };
+	} else {
+		keyed[key] = { tag, domain, bytes };
+	}
+	return add(tag, domain, bytes);
+}
+
+bool MemoryTracker::untrack(const void* key)
+{
+	lock_guard<mutex> lock(trackerMutex);
+	auto it = keyed.find(key);
+	if (it == keyed.end()) return false;
+	remove(it->second.tag, it->second.domain, it->second.bytes);
+	keyed.erase(it);
+	return true;
+}
+
+bool MemoryTracker::isTracked(const void* key) const
+{
+	lock_guard<mutex> lock(trackerMutex);
+	return keyed.find(key) != keyed.end();
+}
+
+void MemoryTracker::setBudget(MemoryTag tag, MemoryDomain domain, uint64_t bytes, MemoryBudgetAction action)
+{
+	lock_guard<mutex> lock(trackerMutex);
+	MemoryTagStats& s = stats(tag, domain);
+	s.budgetBytes = bytes;
+	s.budgetAction = action;
+}
+
+MemoryTagStats MemoryTracker::getStats(MemoryTag tag, MemoryDomain domain) const
+{
+	lock_guard<mutex> lock(trackerMutex);
+	return stats(tag, domain);
+}
+
+uint64_t MemoryTracker::getTotal(MemoryDomain domain) const
+{
+	lock_guard<mutex> lock(trackerMutex);
+	return totals[static_cast<size_t>(domain)];
+}
+
+uint64_t MemoryTracker::getPeakTotal(MemoryDomain domain) const
+{
+	lock_guard<mutex> lock(trackerMutex);
+	return peakTotals[static_cast<size_t>(domain)];
+}
+
+void MemoryTracker::resetPeaks()
+{
+	lock_guard<mutex> lock(trackerMutex);
+	for (auto& s : tagStats) {
+		s.peakBytes = s.currentBytes;
+	}
+	peakTotals = totals;
+}
+
+void MemoryTracker::dump(std::ostream& out) const
+{
+	lock_guard<mutex> lock(trackerMutex);
+	for (size_t d = 0; d < DOMAIN_COUNT; d++) {
+		MemoryDomain domain = static_cast<MemoryDomain>(d);
+		out << getDomainName(domain) << " memory " << totals[d] / 1024 << " KB, peak " << peakTotals[d] / 1024 << " KB\n";
+		for (size_t t = 0; t < TAG_COUNT; t++) {
+			MemoryTag tag = static_cast<MemoryTag>(t);
+			const MemoryTagStats& s = stats(tag, domain);
+			if (s.totalAllocations == 0 && s.budgetBytes == 0) continue;
+			out << "  " << getTagName(tag) << ": " << s.currentBytes / 1024 << " KB in " << s.allocations
+				<< " allocations, peak " << s.peakBytes / 1024 << " KB";
+			if (s.budgetBytes > 0) {
+				out << ", budget " << s.budgetBytes / 1024 << " KB";
+				if (s.overBudget > 0) out << " exceeded " << s.overBudget << " times";
+			}
+			out << "\n";
+		}
+	}
+}
+
+void MemoryTracker::log() const
+{
+	stringstream s;
+	dump(s);
+	Log(s.str());
+}
+
+const char* MemoryTracker::getTagName(MemoryTag tag)
+{
+	switch (tag) {
+	case MemoryTag::Mesh: return "mesh";
+	case MemoryTag::Texture: return "texture";
+	case MemoryTag::Uniform: return "uniform";
+	case MemoryTag::Staging: return "staging";
+	case MemoryTag::RenderTarget: return "render target";
+	case MemoryTag::Audio: return "audio";
+	case MemoryTag::World: return "world";
+	default: return "other";
+	}
+}
+
+const char* MemoryTracker::getDomainName(MemoryDomain domain)
+{
+	return domain == MemoryDomain::Host ? "host" : "device";
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+// Tagged accounting of host and device memory per engine subsystem.
+// Allocations are reported with a MemoryTag and MemoryDomain, either as plain byte counts (allocate() / release())
+// or bound to a key with track() / untrack(), so code freeing the memory only needs the key
+// (e.g. a VkDeviceMemory handle or the owning object). Tracking a key again replaces its previous size,
+// which suits host containers that grow over time.
+// For each tag and domain the current bytes, high-water mark and number of live allocations are kept.
+// Optional budgets per tag and domain either log a warning when they are crossed or stop with Error().
+// GlobalRendering reports all buffers and images it creates, tagged by their usage flags.
+// All methods are thread safe.
+
+enum class MemoryTag : uint8_t {
+	Mesh, // vertex, index and meshlet data
+	Texture,
+	Uniform, // UBOs
+	Staging, // transfer buffers
+	RenderTarget, // color and depth attachments
+	Audio,
+	World, // world creator instances and other world data
+	Other,
+	Count
+};
+
+enum class MemoryDomain : uint8_t { Host, Device, Count };
+
+enum class MemoryBudgetAction : uint8_t {
+	Warn, // log once when budget is crossed
+	Fail // Error() on allocation over budget
+};
+
+struct MemoryTagStats {
+	uint64_t currentBytes = 0;
+	uint64_t peakBytes = 0;
+	uint32_t allocations = 0; // live allocations
+	uint64_t totalAllocations = 0;
+	uint64_t budgetBytes = 0; // 0: no budget
+	MemoryBudgetAction budgetAction = MemoryBudgetAction::Warn;
+	uint32_t overBudget = 0; // allocations that ended above budget
+};
+
+class MemoryTracker
+{
+public:
+	static constexpr size_t TAG_COUNT = static_cast<size_t>(MemoryTag::Count);
+	static constexpr size_t DOMAIN_COUNT = static_cast<size_t>(MemoryDomain::Count);
+
+	// returns false if the allocation is over budget (only with MemoryBudgetAction::Warn)
+	bool allocate(MemoryTag tag, MemoryDomain domain, uint64_t bytes);
+	void release(MemoryTag tag, MemoryDomain domain, uint64_t bytes);
+	// allocation bound to key, replaces size and tag if key is already tracked.
+	// Returns false if over budget, like allocate()
+	bool track(const void* key, MemoryTag tag, MemoryDomain domain, uint64_t bytes);
+	// release allocation of key, false if key is not tracked
+	bool untrack(const void* key);
+	bool isTracked(const void* key) const;
+
+	// budget in bytes for tag, 0 removes the budget
+	void setBudget(MemoryTag tag, MemoryDomain domain, uint64_t bytes, MemoryBudgetAction action = MemoryBudgetAction::Warn);
+	MemoryTagStats getStats(MemoryTag tag, MemoryDomain domain) const;
+	// sum of all tags
+	uint64_t getTotal(MemoryDomain domain) const;
+	uint64_t getPeakTotal(MemoryDomain domain) const;
+	// set high-water marks to current usage, e.g. after loading a level
+	void resetPeaks();
+
+	// one line per used tag and domain: current, peak, live allocations and budget
+	void dump(std::ostream& out) const;
+	void log() const;
+	static const char* getTagName(MemoryTag tag);
+	static const char* getDomainName(MemoryDomain domain);
+
+private:
+	struct Entry {
+		MemoryTag tag;
+		MemoryDomain domain;
+		uint64_t bytes;
+	};
+	MemoryTagStats& stats(MemoryTag tag, MemoryDomain domain) {
+		return tagStats[static_cast<size_t>(domain) * TAG_COUNT + static_cast<size_t>(tag)];
+	}
+	const MemoryTagStats& stats(MemoryTag tag, MemoryDomain domain) const {
+		return tagStats[static_cast<size_t>(domain) * TAG_COUNT + static_cast<size_t>(tag)];
+	}
+	// unlocked versions
+	bool add(MemoryTag tag, MemoryDomain domain, uint64_t bytes);
+	void remove(MemoryTag tag, MemoryDomain domain, uint64_t bytes);
+
+	mutable std::mutex trackerMutex;
+	std::array<MemoryTagStats, TAG_COUNT * DOMAIN_COUNT> tagStats;
+	std::array<uint64_t, DOMAIN_COUNT> totals{};
+	std::array<uint64_t, DOMAIN_COUNT> peakTotals{};
+	std::unordered_map<const void*, Entry> keyed;
+};
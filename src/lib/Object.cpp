@@ -30,12 +30,18 @@ static bool ok_meshid_long_format(const std::string& nom) {
 	return std::regex_match(nom, re);
 }
 
-MeshInfo* MeshStore::getMesh(string id)
+MeshInfo* MeshStore::getMesh(const string& id)
 {
-	if (meshes.find(id) == meshes.end()) {
+	return getMesh(findMeshId(id));
+}
+
+MeshInfo* MeshStore::getMesh(MeshId id)
+{
+	// also catches invalid ids
+	if (id.value >= meshById.size()) {
 		return nullptr;
 	}
-	MeshInfo*ret = &meshes[id];
+	MeshInfo*ret = meshById[id.value];
 	// simple validity check for now:
 	if (ret->id.size() > 0) {
 		// if there is no id the texture could not be loaded (wrong filename?)
@@ -68,11 +74,23 @@ MeshInfo* MeshStore::initMeshInfo(MeshCollection* coll, std::string id, int lodL
 	initialObject.flags = coll->flags;
     initialObject.meshNum = meshNumber++;
 	meshes[id] = initialObject;
-	MeshInfo* mi = &meshes[id];
+	MeshInfo* mi = registerMeshId(id);
 	coll->pushMeshInfo(mi); // <- updated
 	return mi;
 }
 
+MeshInfo* MeshStore::registerMeshId(const std::string& id)
+{
+	MeshId meshId = meshIds.intern(id);
+	if (meshId.value >= meshById.size()) {
+		meshById.resize(meshId.value + 1, nullptr);
+	}
+	// unordered_map never moves its elements, pointer stays valid
+	MeshInfo* mi = &meshes[id];
+	meshById[meshId.value] = mi;
+	return mi;
+}
+
 MeshCollection* MeshStore::loadMeshFile(string filename, string id, vector<byte>& fileBuffer, MeshFlagsCollection flags)
 {
 	if (getMesh(id) != nullptr) {
@@ -237,8 +255,15 @@ void MeshStore::uploadMesh(MeshInfo* mesh_ptr)
 	assert(mesh_ptr->vertices.size() > 0);
 	assert(mesh_ptr->indices.size() > 0);
 
-	// upload vec3 vertex buffer:
-	size_t vertexBufferSize = GlobalRendering::minAlign(mesh_ptr->vertices.size() * sizeof(PBRShader::Vertex));
+	// pack vertices if possible, otherwise upload full PBRVertex buffer:
+	PackedVertexStreams packed;
+	bool packRequested = packedVertexFormat || mesh_ptr->flags.hasFlag(MeshFlags::MESH_TYPE_PACKED_VERTICES);
+	if (packRequested && VertexCompression::canPack(mesh_ptr->vertices)) {
+		VertexCompression::encode(mesh_ptr->vertices, packed);
+	}
+	bool usePacked = packed.format & VERTEX_FORMAT_PACKED;
+	size_t vertexBufferSize = usePacked ? GlobalRendering::minAlign(packed.base.size() * sizeof(PackedVertexBase))
+		: GlobalRendering::minAlign(mesh_ptr->vertices.size() * sizeof(PBRShader::Vertex));
 	size_t globalIndexBufferSize = GlobalRendering::minAlign(mesh_ptr->outGlobalIndexBuffer.size() * sizeof(mesh_ptr->outGlobalIndexBuffer[0]));
 	size_t localIndexBufferSize = GlobalRendering::minAlign(mesh_ptr->outLocalIndexPrimitivesBuffer.size() * sizeof(mesh_ptr->outLocalIndexPrimitivesBuffer[0]));
 	size_t meshletDescBufferSize = GlobalRendering::minAlign(mesh_ptr->outMeshletDesc.size() * sizeof(PBRShader::PackedMeshletDesc));
@@ -247,8 +272,18 @@ void MeshStore::uploadMesh(MeshInfo* mesh_ptr)
         auto* mem = engine->globalRendering.getCurrentGPUMemoryChunk();
         // global storage buffer:
 		mesh_ptr->GPUMeshStorageBaseAddress = mem->address;
-		uint64_t pos = engine->globalRendering.uploadToGlobalBuffer(vertexBufferSize, mesh_ptr->vertices.data(), mem);
+		uint64_t pos = engine->globalRendering.uploadToGlobalBuffer(vertexBufferSize, usePacked ? (const void*)packed.base.data() : (const void*)mesh_ptr->vertices.data(), mem);
 		mesh_ptr->vertexOffset = pos;
+		uint64_t skinOffset = 0, colorOffset = 0;
+		if (packed.format & VERTEX_FORMAT_SKIN_STREAM) {
+			skinOffset = engine->globalRendering.uploadToGlobalBuffer(GlobalRendering::minAlign(packed.skin.size() * sizeof(PackedVertexSkin)), packed.skin.data(), mem);
+		}
+		if (packed.format & VERTEX_FORMAT_COLOR_STREAM) {
+			colorOffset = engine->globalRendering.uploadToGlobalBuffer(GlobalRendering::minAlign(packed.color.size() * sizeof(uint32_t)), packed.color.data(), mem);
+		}
+		if (usePacked) {
+			Log("Packed vertices of mesh " << mesh_ptr->id << ": " << packed.byteSize() << " bytes instead of " << mesh_ptr->vertices.size() * sizeof(PBRShader::Vertex) << endl);
+		}
 
 		pos = engine->globalRendering.uploadToGlobalBuffer(globalIndexBufferSize, mesh_ptr->outGlobalIndexBuffer.data(), mem);
 		mesh_ptr->globalIndexOffset = pos;
@@ -271,6 +306,13 @@ void MeshStore::uploadMesh(MeshInfo* mesh_ptr)
         gpuMeshInfos[index].localIndexOffset = mesh_ptr->localIndexOffset;
         gpuMeshInfos[index].meshletOffset = mesh_ptr->meshletOffset;
         gpuMeshInfos[index].meshletCount = (uint32_t)mesh_ptr->outMeshletDesc.size();
+        gpuMeshInfos[index].vertexFormat = packed.format;
+        gpuMeshInfos[index].skinOffset = skinOffset;
+        gpuMeshInfos[index].colorOffset = colorOffset;
+        for (int c = 0; c < 3; c++) {
+            gpuMeshInfos[index].quantMin[c] = packed.quantMin[c];
+            gpuMeshInfos[index].quantScale[c] = packed.quantScale[c];
+        }
         int indicesOffset = lodIndex * sizeof(GPUMeshIndex);
 		engine->globalRendering.copyToGlobalBuffer(sizeof(GPUMeshIndex), &gpuMeshIndices[lodIndex], mem, indicesOffset);
 		engine->globalRendering.copyToGlobalBuffer(sizeof(GPUMeshInfo), &gpuMeshInfos[index], mem, sizeIndices + sizeInfos);
@@ -279,6 +321,11 @@ void MeshStore::uploadMesh(MeshInfo* mesh_ptr)
 			Log(" First mesh GPUMeshInfo meshlet offset: " << std::hex << gpuMeshInfos[0].meshletOffset << std::dec << endl);
 		}
 	}
+	// host side data is kept after upload (heightmaps, debug rendering)
+	size_t hostBytes = mesh_ptr->vertices.capacity() * sizeof(PBRShader::Vertex) + mesh_ptr->indices.capacity() * sizeof(uint32_t)
+		+ mesh_ptr->meshletVertexIndices.capacity() * sizeof(uint32_t) + mesh_ptr->outMeshletDesc.capacity() * sizeof(PBRShader::PackedMeshletDesc)
+		+ mesh_ptr->outLocalIndexPrimitivesBuffer.capacity() + mesh_ptr->outGlobalIndexBuffer.capacity() * sizeof(uint32_t);
+	engine->memoryTracker.track(mesh_ptr, MemoryTag::Mesh, MemoryDomain::Host, hostBytes);
 }
 
 const vector<MeshInfo*> &MeshStore::getSortedList()
@@ -370,6 +417,10 @@ vec3& WorldObject::scale() {
 	return _scale;
 }
 
+void WorldObject::setAction(std::string name) {
+	action = name;
+}
+
 void WorldObject::calculateStandardModelTransform(glm::mat4& modelToWorld)
 {
 	auto& pos = this->pos();
@@ -407,40 +458,98 @@ void MeshInfo::getBoundingBox(BoundingBox& box)
 	boundingBoxAlreadySet = true;
 }
 
+void MeshInfo::getAnimatedBoundingBox(BoundingBox& box)
+{
+	if (animatedBoundingBoxAlreadySet) {
+		box = animatedBoundingBox;
+		return;
+	}
+	// objects with disableSkinning are drawn unskinned: rest bounds are always included
+	getBoundingBox(box);
+	if (animation != nullptr && animation->skeleton.size() > 0 && animation->skeleton.size() <= MAX_NUM_JOINTS) {
+		AnimationRuntime runtime;
+		uint32_t inst = runtime.addInstance(animation.get());
+		auto addPose = [&]() {
+			const mat4* palette = runtime.getPalette(inst);
+			uint32_t jointCount = runtime.getJointCount(inst);
+			for (auto& v : vertices) {
+				mat4 skin(0.0f);
+				for (int i = 0; i < 4; i++) {
+					if (v.weight0[i] > 0.0f && v.joint0[i] < jointCount) skin += v.weight0[i] * palette[v.joint0[i]];
+				}
+				vec3 p = vec3(skin * vec4(v.pos, 1.0f));
+				box.min = glm::min(box.min, p);
+				box.max = glm::max(box.max, p);
+			}
+		};
+		// rest pose, then evenly spaced poses of each clip including its end
+		runtime.update(0.0f);
+		addPose();
+		for (auto& clip : animation->clips) {
+			runtime.setClip(inst, clip.name, false);
+			runtime.update(0.0f);
+			addPose();
+			for (int i = 0; i < ANIMATED_BOUNDS_SAMPLES; i++) {
+				runtime.update(clip.duration / ANIMATED_BOUNDS_SAMPLES);
+				addPose();
+			}
+		}
+	}
+	animatedBoundingBox = box;
+	animatedBoundingBoxAlreadySet = true;
+}
+
 //void WorldObject::getBoundingBox(BoundingBox& box)
 //{
 //    return mesh->getBoundingBox(box);
 //}
 
-void WorldObjectStore::createGroup(string groupname, int groupId) {
-	if (groups.count(groupname) > 0) return;  // do not recreate groups
-											  //vector<WorldObject> *newGroup = groups[groupname];
-	const auto& newGroup = groups[groupname];
-    groupNames.add(groupname, groupId);
+GroupId WorldObjectStore::createGroup(const string& groupname, int groupId) {
+	GroupId group = groupIds.find(groupname);
+	if (group.isValid()) return group;  // do not recreate groups
+	group = groupIds.intern(groupname);
+	groups.emplace_back();
+	groups.back().userGroupId = groupId;
 	Log(" ---groups size " << groups.size() << endl);
-	Log(" ---newGroup vecor size " << newGroup.size() << endl);
+	return group;
 }
 
-const vector<unique_ptr<WorldObject>>* WorldObjectStore::getGroup(string groupname) {
-	if (groups.count(groupname) == 0) return nullptr;
-	return &groups[groupname];
+const vector<unique_ptr<WorldObject>>* WorldObjectStore::getGroup(const string& groupname) {
+	return getGroup(findGroup(groupname));
 }
 
-WorldObject* WorldObjectStore::addObject(string groupname, string id, vec3 pos) {
-	if (groups.count(groupname) == 0) {
+const vector<unique_ptr<WorldObject>>* WorldObjectStore::getGroup(GroupId group) {
+	if (group.value >= groups.size()) return nullptr;
+	return &groups[group.value].objects;
+}
+
+WorldObject* WorldObjectStore::addObject(const string& groupname, const string& id, vec3 pos) {
+	GroupId group = findGroup(groupname);
+	if (!group.isValid()) {
 		stringstream s;
 		s << "WorldObjectStore: trying to add object to non-existing group " << groupname << endl;
 		Error(s.str());
 	}
-	auto& grp = groups[groupname];
-	grp.push_back(unique_ptr<WorldObject>(new WorldObject()));
-	WorldObject* w = grp[grp.size() - 1].get();
-    int grpId = groupNames.get(groupname);
-	addObjectPrivate(w, id, pos, grpId);
+	return addObject(group, resolveMeshId(id), pos);
+}
+
+WorldObject* WorldObjectStore::addObject(GroupId group, MeshId meshId, vec3 pos) {
+	if (group.value >= groups.size()) {
+		Error("WorldObjectStore: trying to add object to invalid group id");
+	}
+	MeshInfo* mesh = meshStore->getMesh(meshId);
+	if (mesh == nullptr) {
+		Error("WorldObjectStore: trying to add object with invalid mesh id");
+	}
+	auto& grp = groups[group.value];
+	grp.objects.push_back(unique_ptr<WorldObject>(new WorldObject()));
+	WorldObject* w = grp.objects.back().get();
+	addObjectPrivate(w, mesh, pos, grp.userGroupId);
 	return w;
 }
 
-void WorldObjectStore::addObjectPrivate(WorldObject* w, string id, vec3 pos, int userGroupId) {
+MeshId WorldObjectStore::resolveMeshId(const string& id) {
+	string name = id;
 	if (ok_meshid_long_format(id) == false) {
 		stringstream s;
         // check if id contains '#' char - this is used to designate additional primitives
@@ -453,28 +562,72 @@ void WorldObjectStore::addObjectPrivate(WorldObject* w, string id, vec3 pos, int
 	} else {
 		// we need to check for name.0 format and rename to just 'name':
 		if (id.ends_with(".0")) {
-			id = id.substr(0, id.length() - 2);
+			name = id.substr(0, id.length() - 2);
 		}
 	}
-	MeshInfo* mesh = meshStore->getMesh(id);
-	if (mesh == nullptr) {
+	MeshId meshId = meshStore->findMeshId(name);
+	if (!meshId.isValid()) {
 		stringstream s;
-		s << "WorldObjectStore: Trying to load non-existing object " << id << endl;
+		s << "WorldObjectStore: Trying to load non-existing object " << name << endl;
 		Error(s.str());
 	}
+	return meshId;
+}
+
+void WorldObjectStore::addObjectPrivate(WorldObject* w, MeshInfo* mesh, vec3 pos, int userGroupId) {
 	w->pos() = pos;
 	w->objectStartPos = pos;
 	w->mesh = mesh;
 	w->alpha = 1.0f;
     w->userGroupId = userGroupId;
-	w->objectNum = numObjects++;
+	if (!freeObjectNums.empty()) {
+		w->objectNum = freeObjectNums.back();
+		freeObjectNums.pop_back();
+	} else {
+		w->objectNum = nextObjectNum++;
+	}
+	numObjects++;
     //Log("Added object " << id.c_str() << " at " << pos.x << " " << pos.y << " " << pos.z << " to group " << userGroupId << " with objectNum " << w->objectNum << endl);
 	if (!(w->objectNum < meshStore->engine->getMaxObjects())) {
 		Error("WorldObjectStore: too many objects, increase max objects in engine settings.");
     }
     // check for additional primitives:
 	int primCount = meshStore->countPrimitives(mesh);
-	w->dynamicModelUBOIndex = meshStore->engine->shaders.pbrShader.reserveDynamicUniformBufferSlots(primCount);
+	auto& freeSlots = freeModelUBOSlots[primCount];
+	if (!freeSlots.empty()) {
+		w->dynamicModelUBOIndex = freeSlots.back();
+		freeSlots.pop_back();
+	} else {
+		w->dynamicModelUBOIndex = meshStore->engine->shaders.pbrShader.reserveDynamicUniformBufferSlots(primCount);
+	}
+	w->handle = components.create(w);
+	components.sync(w->handle);
+	// culling flags are set on the model UBOs of all primitives: bounds have to include all of them
+	BoundingBox box;
+	meshStore->getObjectBoundingBox(mesh, box);
+	if (box.min.x <= box.max.x) {
+		components.setLocalBounds(w->handle, ObjectBounds{ box.min, box.max });
+	}
+}
+
+void WorldObjectStore::removeObject(WorldObject* wo)
+{
+	for (auto& gm : groups) {
+		auto& grp = gm.objects;
+		for (size_t i = 0; i < grp.size(); i++) {
+			if (grp[i].get() != wo) continue;
+			// only objects of this store may touch the components and free lists
+			components.remove(wo->handle);
+			freeObjectNums.push_back(wo->objectNum);
+			freeModelUBOSlots[meshStore->countPrimitives(wo->mesh)].push_back(wo->dynamicModelUBOIndex);
+			if (i != grp.size() - 1) std::swap(grp[i], grp.back());
+			grp.pop_back();
+			numObjects--;
+			sortedList.clear();
+			return;
+		}
+	}
+	Error("WorldObjectStore: object to remove not found");
 }
 
 const vector<WorldObject*>& WorldObjectStore::getSortedList()
@@ -486,7 +639,7 @@ const vector<WorldObject*>& WorldObjectStore::getSortedList()
 	sortedList.clear();
 	sortedList.reserve(numObjects);
 	for (auto& gm : groups) {
-		auto &grp = gm.second;
+		auto &grp = gm.objects;
 		for (auto &o : grp) {
 			sortedList.push_back(o.get());
 		}
@@ -1671,6 +1824,7 @@ void MeshStore::loadMeshGrid(std::string id, MeshFlagsCollection flags, std::str
 
 	meshInfo.available = true;
 	meshes[id] = std::move(meshInfo);
+	registerMeshId(id);
 	aquireMeshletData(id, id);
 }
 
@@ -1703,6 +1857,7 @@ void MeshStore::loadMeshCylinder(std::string id, MeshFlagsCollection flags, std:
 	meshInfo.available = true;
 	meshInfo.collectionStoreIndex = initMeshCollection(id, flags)->index;
 	meshes[id] = std::move(meshInfo);
+	registerMeshId(id);
 	if (flags.hasFlag(MeshFlags::MESHLET_GENERATE)) {
 		aquireMeshletData(id, id, true);
 	} else {
@@ -2066,6 +2221,17 @@ void WorldObjectStore::loadWorldCreatorInstances(std::string filename)
             instance.t.z = pos.y;
 		}
 	}
+	// parsed instance records of all tiles and the merged copies
+	size_t instanceBytes = 0;
+	for (auto& biomeObj : worldCreator.biomeObjects) {
+		for (auto& tile : biomeObj.ParsedTiles) {
+			instanceBytes += tile.instances.capacity() * sizeof(wcil::InstanceRecord);
+		}
+		if (biomeObj.MergedParsedTile) {
+			instanceBytes += biomeObj.MergedParsedTile.value().instances.capacity() * sizeof(wcil::InstanceRecord);
+		}
+	}
+	meshStore->engine->memoryTracker.track(&worldCreator, MemoryTag::World, MemoryDomain::Host, instanceBytes);
 }
 
 std::vector<MeshInfo*> MeshCollection::getMajorMeshes() const {
@@ -2182,6 +2348,19 @@ int MeshStore::countPrimitives(MeshInfo* mi) {
 	return counter;
 }
 
+void MeshStore::getObjectBoundingBox(MeshInfo* mi, BoundingBox& box) {
+	MeshInfo* current = mi;
+	while (current != nullptr) {
+		BoundingBox primBox;
+		current->getAnimatedBoundingBox(primBox);
+		box.min = glm::min(box.min, primBox.min);
+		box.max = glm::max(box.max, primBox.max);
+		if (current->gltfNextPrimitiveIndex <= 0) break;
+		auto col = meshCollectionStore.getMeshCollectionByIndex(current->collectionStoreIndex);
+		current = col->getMeshInfoAt(current->gltfNextPrimitiveIndex);
+	}
+}
+
 void MeshStore::reorderForPrimitiveBlocks(MeshCollection* coll)
 {
 	// reorder meshes in collection so that all primitives of a mesh are stored in continuous blocks
@@ -14,6 +14,7 @@ enum class MeshFlags : int {
     MESH_TYPE_LOD = 5, // mesh contains LOD levels
 	MESHLET_DEBUG_COLORS = 6, // apply vertex color to all triangles of one meshlet
     MESHLET_GENERATE = 7, // re-generate meshlet data if meshlet data file not found
+    MESH_TYPE_PACKED_VERTICES = 8, // upload vertices in packed format (see VertexCompression.h), not for terrain or other large meshes
 	MESH_TYPE_COUNT = -1 // always last
 };
 
@@ -345,6 +346,8 @@ struct MeshInfo
     int gltfNextPrimitiveIndex = -1;
 	// base transform from gltf file (default to identity)
 	glm::mat4 baseTransform = glm::mat4(1.0f);
+	// skeleton and animation clips if mesh is skinned, shared by all meshes using the same glTF skin
+	std::shared_ptr<AnimationSet> animation;
 
 	// link back to collection store
     size_t collectionStoreIndex = SIZE_MAX;
@@ -361,6 +364,11 @@ struct MeshInfo
 	// get bounding box directly from mesh data, will only be called once
     // returns BB based on actual vertex positions, no transformations applied
 	void getBoundingBox(BoundingBox& box);
+	// bounding box for culling: skinned meshes add the vertex positions of sampled poses of all animation clips
+	// to the rest bounds, meshes without animation return getBoundingBox(). Only calculated once
+	void getAnimatedBoundingBox(BoundingBox& box);
+	// poses sampled per clip for getAnimatedBoundingBox()
+	static constexpr int ANIMATED_BOUNDS_SAMPLES = 32;
 	
 	void logInfo() const {
 		Log("Mesh ID: " << id << "\n");
@@ -404,6 +412,8 @@ struct MeshInfo
 	}
 	bool boundingBoxAlreadySet = false;
 	BoundingBox boundingBox;
+	bool animatedBoundingBoxAlreadySet = false;
+	BoundingBox animatedBoundingBox;
     uint64_t GPUMeshStorageBaseAddress = 0; // base address of global mesh storage buffer on GPU
 	uint64_t meshletOffset = 0; // offset into global mesh storage buffer
 	uint64_t localIndexOffset = 0; // offset into global mesh storage buffer
@@ -447,8 +457,13 @@ struct GPUMeshInfo {
 	uint64_t globalIndexOffset = 0; // offset into global mesh storage buffer
 	uint64_t vertexOffset = 0; // offset into global mesh storage buffer
 	uint32_t meshletCount; // number of meshlets for this LOD
-	uint32_t pad0;
+	uint32_t vertexFormat = VERTEX_FORMAT_FULL; // VERTEX_FORMAT_ flags, see VertexCompression.h
+	uint64_t skinOffset = 0; // packed format only: offset of skin stream
+	uint64_t colorOffset = 0; // packed format only: offset of color stream
+	float quantMin[3] = { 0.0f, 0.0f, 0.0f }; // packed format only: position = quantMin + quantized * quantScale
+	float quantScale[3] = { 0.0f, 0.0f, 0.0f };
 };
+static_assert(sizeof(GPUMeshInfo) == 80, "GPUMeshInfo has to match std430 layout in pbr_mesh_common.glsl");
 
 // Mesh Store to organize objects loaded from gltf files.
 class MeshStore {
@@ -480,13 +495,30 @@ public:
 	const std::vector<MeshInfo*> &getSortedList();
 	// upload single model to GPU
 	void uploadMesh(MeshInfo* mesh);
+	// upload vertices of all meshes in packed format (see VertexCompression.h), default is off: single meshes opt in
+	// with MeshFlags::MESH_TYPE_PACKED_VERTICES. Positions are quantized to 16 bit of the mesh AABB, so terrain and other
+	// large meshes should stay in full format. Only affects meshes uploaded later, meshes that cannot be packed are
+	// uploaded in full format
+	void setPackedVertexFormat(bool enable) {
+		packedVertexFormat = enable;
+	}
 	// initialize MeshInfo, also add to collection. id is expected to be in collection format like myid.2
 	// myid.0 is a synonym for myid
 	MeshInfo* initMeshInfo(MeshCollection* coll, std::string id, int lodLevel);
     // initialize MeshCollection and add to store, beware of leaking pointers after collection has been added!
     MeshCollection* initMeshCollection(std::string id, MeshFlagsCollection flags = MeshFlagsCollection());
 
-	MeshInfo* getMesh(std::string id);
+	// get mesh by name, thin wrapper around findMeshId() and getMesh(MeshId)
+	MeshInfo* getMesh(const std::string& id);
+	// handle indexed lookup, nullptr for invalid ids
+	MeshInfo* getMesh(MeshId id);
+	// resolve mesh name once, invalid id if no mesh with this name is stored. No format check, see WorldObjectStore::resolveMeshId()
+	MeshId findMeshId(std::string_view id) const {
+		return meshIds.find(id);
+	}
+	const std::string& getMeshName(MeshId id) const {
+		return meshIds.name(id);
+	}
 	// to render an object using meshlets we need:
     // 1. meshlet desc buffer, most important: get global index start for each meshlet
     // 2. global index buffer, which contains indices into the global vertex buffer
@@ -545,6 +577,8 @@ public:
 	MeshCollection* getMeshCollection(MeshInfo* mi);
 	MeshCollectionStore meshCollectionStore;
 	int countPrimitives(MeshInfo* mi);
+	// union of the animated bounding boxes of the mesh and all its additional primitives (same walk as countPrimitives())
+	void getObjectBoundingBox(MeshInfo* mi, BoundingBox& box);
 	// reorder collection for blocks of (10) consecutive lod meshes
 	void reorderForPrimitiveBlocks(MeshCollection* coll);
     
@@ -558,6 +592,10 @@ private:
 	void debugGraphicsInternal(MeshInfo* primitiveMesh, WorldObject* obj, FrameResources& fr, glm::mat4 modelToWorld, bool drawBoundingBox = true, bool drawVertices = true, bool drawNormals = false, bool drawMeshletBoundingBoxes = false, glm::vec4 colorVertices = Colors::Black, glm::vec4 colorNormal = Colors::Red, glm::vec4 colorBoxes = Colors::Yellow, float normalLineLength = 0.01f);
 	MeshCollection* loadMeshFile(std::string filename, std::string id, std::vector<std::byte> &fileBuffer, MeshFlagsCollection flags);
 	std::unordered_map<std::string, MeshInfo> meshes;
+	InternTable<MeshId> meshIds;
+	std::vector<MeshInfo*> meshById; // indexed by MeshId, pointers into meshes
+	// assign id to mesh just stored in meshes
+	MeshInfo* registerMeshId(const std::string& id);
 	//std::vector<MeshCollection> meshCollections;
 	Util* util = nullptr;
 	std::vector<MeshInfo*> sortedList;
@@ -575,6 +613,7 @@ private:
     int meshNumber = 0; // count all meshes
     std::vector<GPUMeshIndex> gpuMeshIndices; // one per mesh
     std::vector<GPUMeshInfo> gpuMeshInfos; // one per LOD level of each mesh
+	bool packedVertexFormat = false;
 };
 
 // 
@@ -590,7 +629,10 @@ public:
 	bool disableSkinning = false; // set to true for animated object to use as fixed mesh
 	bool isNonKeyframeAnimated = false; // signal that poses are not interpoalted by Path, but computed outside and set in update()
 	int visible; // visible in current view frustrum: 0 == no, 1 == intersection, 2 == completely visible
+	// select animation clip by name, applied by AnimationRuntime::updatePerFrame()
 	void setAction(std::string name);
+	std::string action;
+	uint32_t animationInstance = UINT32_MAX; // index in AnimationRuntime
 	// return current bounding box by scanning all vertices, used for bone animated objects
 	// if maximise is true bounding box may increase with each call, depending on current animation
 	// (used to get max bounding box for animated objects)
@@ -622,6 +664,7 @@ public:
     // calculate standard model to world transform from pos, rot, scale and the base transform from the mesh
     void calculateStandardModelTransform(glm::mat4& modelToWorld);
     UINT dynamicModelUBOIndex = UINT_MAX; // index into per-frame dynamic model UBO array
+    ObjectHandle handle; // components of this object in WorldObjectStore::getComponents()
     int primitiveCount = 1; // number of primitives used by this object (1 for normal objects, more for objects using multiple gltf primitives)
 private:
 	glm::vec3 _pos;
@@ -645,21 +688,48 @@ public:
 	// objects
 	// add loaded object to scene
 	// remember returned ptr for single object access
-	WorldObject* addObject(std::string groupname, std::string id, glm::vec3 pos);
+	WorldObject* addObject(const std::string& groupname, const std::string& id, glm::vec3 pos);
+	// same without string lookups, for adding many objects: resolve group and mesh once
+	// with createGroup() / findGroup() and resolveMeshId()
+	WorldObject* addObject(GroupId group, MeshId mesh, glm::vec3 pos);
+	// check object id format (name or name.number, name.0 is the same as name) and get id of loaded mesh
+	MeshId resolveMeshId(const std::string& id);
 	// obbject groups: give fast access to specific objects (e.g. all worm NPCs).
 	// an int defining the group type may be given, it will be stored in each object of that group.
 	// allows for grouping obejcts more easily in application code
-	void createGroup(std::string groupname, int groupId = 0);
-	const std::vector<std::unique_ptr<WorldObject>>* getGroup(std::string groupname);
+	GroupId createGroup(const std::string& groupname, int groupId = 0);
+	// invalid id if group does not exist
+	GroupId findGroup(std::string_view groupname) const {
+		return groupIds.find(groupname);
+	}
+	const std::vector<std::unique_ptr<WorldObject>>* getGroup(const std::string& groupname);
+	const std::vector<std::unique_ptr<WorldObject>>* getGroup(GroupId group);
 	// get sorted object list (sorted by type)
 	// meshes are only resorted if one was added in the meantime
 	const std::vector<WorldObject*>& getSortedList();
+	// remove object from store and its group, the WorldObject is deleted. Order of objects in the group changes (swap-remove).
+	// Object number and dynamic model UBO slots go to free lists and are reused by the next addObject() with the same
+	// primitive count. Systems keeping WorldObject pointers or object numbers (e.g. AnimationRuntime) have to register again
+	void removeObject(WorldObject* wo);
+	// SoA component arrays of all objects, see ObjectComponents.h
+	ObjectComponentStore& getComponents() {
+		return components;
+	}
 	// clear all objects from store
 	void clear() {
+		// dynamic model UBO slots stay reserved in PBRShader, keep them for new objects
+		for (auto& gm : groups) {
+			for (auto& o : gm.objects) {
+				freeModelUBOSlots[meshStore->countPrimitives(o->mesh)].push_back(o->dynamicModelUBOIndex);
+			}
+		}
+		freeObjectNums.clear();
 		groups.clear();
-		groupNames = StringIntMap();
+		groupIds.clear();
 		sortedList.clear();
+		components.clear();
 		numObjects = 0;
+		nextObjectNum = 0;
 	}
 	// load object instances from World Creator export files.
     // both json file and csv files must be present in the same folder.
@@ -700,11 +770,19 @@ private:
 		buf->pad0 = 0;
 	}
 
-	std::unordered_map<std::string, std::vector<std::unique_ptr<WorldObject>>> groups;
-	StringIntMap groupNames;
-	void addObjectPrivate(WorldObject* w, std::string id, glm::vec3 pos, int userGroupId);
+	struct ObjectGroup {
+		std::vector<std::unique_ptr<WorldObject>> objects;
+		int userGroupId = 0;
+	};
+	std::vector<ObjectGroup> groups; // indexed by GroupId
+	InternTable<GroupId> groupIds;
+	void addObjectPrivate(WorldObject* w, MeshInfo* mesh, glm::vec3 pos, int userGroupId);
 	MeshStore *meshStore;
 	std::vector<WorldObject*> sortedList;
     UINT numObjects = 0; // count all objects
+	UINT nextObjectNum = 0;
+	std::vector<UINT> freeObjectNums; // object numbers of removed objects
+	std::unordered_map<int, std::vector<UINT>> freeModelUBOSlots; // first dynamic model UBO slot of removed objects, by primitive count
+	ObjectComponentStore components;
     WorldCreator worldCreator; // used to handle object instances as exported from World Creator
 };
\ No newline at end of file
@@ -0,0 +1,190 @@
+#include "mainheader.h"
+
+using namespace std;
+using namespace glm;
+
+ObjectHandle ObjectComponentStore::create(WorldObject* o)
+{
+	ObjectHandle h;
+	if (freeSlots.empty()) {
+		h.index = static_cast<uint32_t>(slots.size());
+		slots.push_back(Slot());
+	} else {
+		h.index = freeSlots.back();
+		freeSlots.pop_back();
+	}
+	Slot& slot = slots[h.index];
+	slot.dense = static_cast<uint32_t>(owner.size());
+	h.generation = slot.generation;
+	handle.push_back(h);
+	owner.push_back(o);
+	pos.push_back(vec3(0.0f));
+	rot.push_back(vec3(0.0f));
+	scale.push_back(vec3(1.0f));
+	model.push_back(mat4(1.0f));
+	baseTransform.push_back(nullptr);
+	localBound.push_back(ObjectBounds());
+	worldBound.push_back(ObjectBounds());
+	renderFlag.push_back(OBJECT_ENABLED);
+	lod.push_back(ObjectLodState());
+	uboIndex.push_back(UINT32_MAX);
+	return h;
+}
+
+uint32_t ObjectComponentStore::indexOf(ObjectHandle h) const
+{
+	if (!isAlive(h)) {
+		Error("ObjectComponentStore: stale or invalid object handle");
+	}
+	return slots[h.index].dense;
+}
+
+void ObjectComponentStore::remove(ObjectHandle h)
+{
+	uint32_t i = indexOf(h);
+	uint32_t last = static_cast<uint32_t>(owner.size() - 1);
+	if (i != last) {
+		handle[i] = handle[last];
+		owner[i] = owner[last];
+		pos[i] = pos[last];
+		rot[i] = rot[last];
+		scale[i] = scale[last];
+		model[i] = model[last];
+		baseTransform[i] = baseTransform[last];
+		localBound[i] = localBound[last];
+		worldBound[i] = worldBound[last];
+		renderFlag[i] = renderFlag[last];
+		lod[i] = lod[last];
+		uboIndex[i] = uboIndex[last];
+		slots[handle[i].index].dense = i;
+	}
+	handle.pop_back();
+	owner.pop_back();
+	pos.pop_back();
+	rot.pop_back();
+	scale.pop_back();
+	model.pop_back();
+	baseTransform.pop_back();
+	localBound.pop_back();
+	worldBound.pop_back();
+	renderFlag.pop_back();
+	lod.pop_back();
+	uboIndex.pop_back();
+	Slot& slot = slots[h.index];
+	slot.dense = FREE_SLOT;
+	slot.generation++;
+	freeSlots.push_back(h.index);
+}
+
+void ObjectComponentStore::clear()
+{
+	// keep generations, handles from before clear() stay invalid
+	freeSlots.clear();
+	for (uint32_t s = 0; s < slots.size(); s++) {
+		if (slots[s].dense != FREE_SLOT) {
+			slots[s].dense = FREE_SLOT;
+			slots[s].generation++;
+		}
+		freeSlots.push_back(s);
+	}
+	handle.clear();
+	owner.clear();
+	pos.clear();
+	rot.clear();
+	scale.clear();
+	model.clear();
+	baseTransform.clear();
+	localBound.clear();
+	worldBound.clear();
+	renderFlag.clear();
+	lod.clear();
+	uboIndex.clear();
+}
+
+void ObjectComponentStore::reserve(size_t n)
+{
+	slots.reserve(n);
+	handle.reserve(n);
+	owner.reserve(n);
+	pos.reserve(n);
+	rot.reserve(n);
+	scale.reserve(n);
+	model.reserve(n);
+	baseTransform.reserve(n);
+	localBound.reserve(n);
+	worldBound.reserve(n);
+	renderFlag.reserve(n);
+	lod.reserve(n);
+	uboIndex.reserve(n);
+}
+
+mat4 ObjectComponentStore::composeTransform(const vec3& p, const vec3& r, const vec3& s)
+{
+	// Rz * Ry * Rx written out, avoids three full matrix multiplications
+	float sx = sin(r.x), cx = cos(r.x);
+	float sy = sin(r.y), cy = cos(r.y);
+	float sz = sin(r.z), cz = cos(r.z);
+	mat4 m;
+	m[0] = vec4(cz * cy, sz * cy, -sy, 0.0f) * s.x;
+	m[1] = vec4(cz * sy * sx - sz * cx, sz * sy * sx + cz * cx, cy * sx, 0.0f) * s.y;
+	m[2] = vec4(cz * sy * cx + sz * sx, sz * sy * cx - cz * sx, cy * cx, 0.0f) * s.z;
+	m[3] = vec4(p, 1.0f);
+	return m;
+}
+
+ObjectBounds ObjectComponentStore::transformBounds(const mat4& m, const ObjectBounds& b)
+{
+	// transform center and project extent onto world axes
+	vec3 center = (b.min + b.max) * 0.5f;
+	vec3 extent = (b.max - b.min) * 0.5f;
+	vec3 c = vec3(m * vec4(center, 1.0f));
+	vec3 e;
+	for (int i = 0; i < 3; i++) {
+		e[i] = abs(m[0][i]) * extent.x + abs(m[1][i]) * extent.y + abs(m[2][i]) * extent.z;
+	}
+	return ObjectBounds{ c - e, c + e };
+}
+
+void ObjectComponentStore::updateRange(size_t first, size_t count)
+{
+	for (size_t i = first; i < first + count; i++) {
+		mat4 m = composeTransform(pos[i], rot[i], scale[i]);
+		if (baseTransform[i] != nullptr) {
+			mat4 full;
+			simdMat4Mul(&m[0][0], &(*baseTransform[i])[0][0], &full[0][0]);
+			m = full;
+		}
+		model[i] = m;
+		worldBound[i] = transformBounds(m, localBound[i]);
+	}
+}
+
+void ObjectComponentStore::updateTransforms(ThreadGroup* threads)
+{
+	forEachRange(threads, [this](size_t first, size_t count) { updateRange(first, count); });
+}
+
+void ObjectComponentStore::syncFromWorldObjects()
+{
+	for (size_t i = 0; i < owner.size(); i++) {
+		syncObject(i);
+	}
+}
+
+void ObjectComponentStore::syncObject(size_t i)
+{
+	WorldObject* wo = owner[i];
+	if (wo == nullptr) return;
+	pos[i] = wo->pos();
+	rot[i] = wo->rot();
+	scale[i] = wo->scale();
+	uint32_t f = renderFlag[i] & (OBJECT_VISIBLE | OBJECT_FULLY_VISIBLE);
+	if (wo->enabled) f |= OBJECT_ENABLED;
+	if (wo->enableDebugGraphics) f |= OBJECT_DEBUG_GRAPHICS;
+	if (wo->useGpuLod) f |= OBJECT_GPU_LOD;
+	renderFlag[i] = f;
+	uboIndex[i] = wo->dynamicModelUBOIndex;
+	if (wo->mesh != nullptr) {
+		baseTransform[i] = &wo->mesh->baseTransform;
+	}
+}
@@ -0,0 +1,186 @@
+#pragma once
+
+// Component storage for world objects: per object data that is touched every frame is kept in dense SoA arrays
+// (transform, bounds, render flags, LOD state, UBO index), so per frame systems walk contiguous memory
+// instead of following WorldObject pointers across the heap.
+// Objects are addressed by generational handles: removing an object moves the last object into its place
+// (swap-remove) and bumps the generation of its slot, so stale handles are detected instead of silently
+// pointing to another object. Dense indexes change on removal, handles never do.
+// WorldObjectStore registers every WorldObject here (WorldObject::handle). Code still writing WorldObject
+// fields can call syncFromWorldObjects() once per frame until it writes the arrays directly.
+
+class WorldObject;
+
+struct ObjectHandle {
+	static constexpr uint32_t INVALID_INDEX = UINT32_MAX;
+	uint32_t index = INVALID_INDEX; // slot index, not the dense index
+	uint32_t generation = 0;
+	bool isValid() const {
+		return index != INVALID_INDEX;
+	}
+	bool operator==(const ObjectHandle& other) const {
+		return index == other.index && generation == other.generation;
+	}
+};
+
+// render flags, bits of ObjectComponentStore::renderFlags()
+enum ObjectRenderFlag : uint32_t {
+	OBJECT_ENABLED = 1,
+	OBJECT_VISIBLE = 2, // intersects view frustum
+	OBJECT_FULLY_VISIBLE = 4, // completely inside view frustum
+	OBJECT_DEBUG_GRAPHICS = 8,
+	OBJECT_GPU_LOD = 16
+};
+
+struct ObjectLodState {
+	int lod = 0; // selected LOD, LodSelection::LOD_INVISIBLE if culled
+	uint32_t selectionIndex = UINT32_MAX; // index in LodSelection, UINT32_MAX if not registered
+};
+
+// axis aligned box without shader padding
+struct ObjectBounds {
+	glm::vec3 min = glm::vec3(0.0f);
+	glm::vec3 max = glm::vec3(0.0f);
+};
+
+class ObjectComponentStore
+{
+public:
+	// objects per task for parallel passes
+	static constexpr size_t PARALLEL_CHUNK_SIZE = 4096;
+
+	ObjectHandle create(WorldObject* owner = nullptr);
+	// swap-remove: last object is moved into the dense index of the removed one
+	void remove(ObjectHandle h);
+	void clear();
+	void reserve(size_t n);
+	bool isAlive(ObjectHandle h) const {
+		return h.index < slots.size() && slots[h.index].generation == h.generation && slots[h.index].dense != FREE_SLOT;
+	}
+	// dense index of object, only valid until next remove()
+	uint32_t indexOf(ObjectHandle h) const;
+	size_t size() const {
+		return owner.size();
+	}
+
+	// single object access via handle
+	glm::vec3& position(ObjectHandle h) {
+		return pos[indexOf(h)];
+	}
+	glm::vec3& rotation(ObjectHandle h) {
+		return rot[indexOf(h)];
+	}
+	glm::vec3& scaling(ObjectHandle h) {
+		return scale[indexOf(h)];
+	}
+	const glm::mat4& modelToWorld(ObjectHandle h) const {
+		return model[indexOf(h)];
+	}
+	uint32_t& flags(ObjectHandle h) {
+		return renderFlag[indexOf(h)];
+	}
+	ObjectLodState& lodState(ObjectHandle h) {
+		return lod[indexOf(h)];
+	}
+	// local bounds are in mesh space (before base transform)
+	void setLocalBounds(ObjectHandle h, const ObjectBounds& bounds) {
+		localBound[indexOf(h)] = bounds;
+	}
+	// mesh base transform applied before scale, rotation and translation. nullptr for identity. Not owned
+	void setBaseTransform(ObjectHandle h, const glm::mat4* base) {
+		baseTransform[indexOf(h)] = base;
+	}
+
+	// contiguous component arrays in dense order, for passes over all objects
+	std::span<const ObjectHandle> handles() const {
+		return handle;
+	}
+	std::span<WorldObject* const> owners() const {
+		return owner;
+	}
+	std::span<glm::vec3> positions() {
+		return pos;
+	}
+	std::span<glm::vec3> rotations() {
+		return rot;
+	}
+	std::span<glm::vec3> scales() {
+		return scale;
+	}
+	std::span<const glm::mat4> modelToWorldMatrices() const {
+		return model;
+	}
+	std::span<ObjectBounds> localBounds() {
+		return localBound;
+	}
+	std::span<const ObjectBounds> worldBounds() const {
+		return worldBound;
+	}
+	std::span<uint32_t> renderFlags() {
+		return renderFlag;
+	}
+	std::span<ObjectLodState> lodStates() {
+		return lod;
+	}
+	std::span<uint32_t> uboIndexes() {
+		return uboIndex;
+	}
+
+	// call fn(first, count) for consecutive dense ranges, spread over threads if given.
+	// Objects must not be created or removed while running
+	template<typename Fn>
+	void forEachRange(ThreadGroup* threads, Fn&& fn, size_t chunkSize = PARALLEL_CHUNK_SIZE) {
+		size_t n = size();
+		size_t tasks = (n + chunkSize - 1) / chunkSize;
+		if (threads == nullptr || tasks <= 1) {
+			if (n > 0) fn(size_t(0), n);
+			return;
+		}
+		std::vector<std::future<void>> futures;
+		futures.reserve(tasks);
+		for (size_t t = 0; t < tasks; t++) {
+			size_t first = t * chunkSize;
+			size_t count = std::min(chunkSize, n - first);
+			futures.push_back(threads->asyncSubmit([&fn, first, count] { fn(first, count); }));
+		}
+		for (auto& f : futures) {
+			f.get();
+		}
+	}
+	// calculate model to world matrices and world bounds of all objects
+	void updateTransforms(ThreadGroup* threads = nullptr);
+	// copy transform, flags, UBO index and mesh base transform from owning WorldObjects
+	void syncFromWorldObjects();
+	void sync(ObjectHandle h) {
+		syncObject(indexOf(h));
+	}
+
+	// translation * rotation (z * y * x euler angles) * scale, same as WorldObject::calculateStandardModelTransform() without base transform
+	static glm::mat4 composeTransform(const glm::vec3& p, const glm::vec3& r, const glm::vec3& s);
+	// bounds of transformed box
+	static ObjectBounds transformBounds(const glm::mat4& m, const ObjectBounds& b);
+
+private:
+	static constexpr uint32_t FREE_SLOT = UINT32_MAX;
+	struct Slot {
+		uint32_t dense = FREE_SLOT;
+		uint32_t generation = 0;
+	};
+	void updateRange(size_t first, size_t count);
+	void syncObject(size_t i);
+	std::vector<Slot> slots;
+	std::vector<uint32_t> freeSlots;
+	// components in dense order
+	std::vector<ObjectHandle> handle;
+	std::vector<WorldObject*> owner;
+	std::vector<glm::vec3> pos;
+	std::vector<glm::vec3> rot;
+	std::vector<glm::vec3> scale;
+	std::vector<glm::mat4> model;
+	std::vector<const glm::mat4*> baseTransform;
+	std::vector<ObjectBounds> localBound;
+	std::vector<ObjectBounds> worldBound;
+	std::vector<uint32_t> renderFlag;
+	std::vector<ObjectLodState> lod;
+	std::vector<uint32_t> uboIndex;
+};
@@ -0,0 +1,494 @@
+#include "mainheader.h"
+
+using namespace std;
+using namespace glm;
+
+// Depth values are NDC z (Vulkan range 0..1). Each pixel stores the nearest occluder depth,
+// higher levels the max of their 2x2 texels: the farthest occluder depth found anywhere inside the texel.
+
+void OcclusionCullingStats::log() const
+{
+	Log("Occlusion culling: tested " << tested << " occluded " << occluded << " (" << occlusionRate() * 100.0f
+		<< "%) occluder triangles " << occluderTriangles << endl);
+}
+
+void OcclusionCulling::init(int width, int height)
+{
+	if (width <= 0 || height <= 0 || width % TILE_WIDTH != 0 || height % TILE_HEIGHT != 0) {
+		Error("OcclusionCulling: depth buffer size has to be a multiple of the tile size");
+	}
+	levels.clear();
+	int w = width, h = height;
+	while (true) {
+		DepthLevel l;
+		l.width = w;
+		l.height = h;
+		l.depth.assign(static_cast<size_t>(w) * h, 1.0f);
+		levels.push_back(std::move(l));
+		if (w == 1 && h == 1) break;
+		w = (w + 1) / 2;
+		h = (h + 1) / 2;
+	}
+	tilesX = width / TILE_WIDTH;
+	tilesY = height / TILE_HEIGHT;
+	tileLevels = 0;
+	while ((TILE_WIDTH >> (tileLevels + 1)) >= 1 && (TILE_HEIGHT >> (tileLevels + 1)) >= 1 && tileLevels + 1 < getLevelCount()) {
+		tileLevels++;
+	}
+	bins.assign(static_cast<size_t>(tilesX) * tilesY, vector<uint32_t>());
+}
+
+void OcclusionCulling::addOccluder(std::span<const glm::vec3> vertices, std::span<const uint32_t> indices)
+{
+	if (indices.size() % 3 != 0) {
+		Error("OcclusionCulling: occluder index count has to be a multiple of 3");
+	}
+	uint32_t base = static_cast<uint32_t>(occluderVertices);
+	occluderVertices += vertices.size();
+	size_t padded = simdPaddedSize(occluderVertices);
+	occluderX.resize(padded, 0.0f);
+	occluderY.resize(padded, 0.0f);
+	occluderZ.resize(padded, 0.0f);
+	for (size_t i = 0; i < vertices.size(); i++) {
+		occluderX[base + i] = vertices[i].x;
+		occluderY[base + i] = vertices[i].y;
+		occluderZ[base + i] = vertices[i].z;
+	}
+	occluderIndices.reserve(occluderIndices.size() + indices.size());
+	for (uint32_t index : indices) {
+		if (index >= vertices.size()) {
+			Error("OcclusionCulling: occluder index out of range");
+		}
+		occluderIndices.push_back(base + index);
+	}
+}
+
+void OcclusionCulling::addOccluder(const MeshInfo* mesh, const glm::mat4& modelToWorld)
+{
+	if (mesh->vertices.empty() || mesh->indices.empty()) {
+		Error("OcclusionCulling: occluder mesh has no CPU side vertex data");
+	}
+	vector<vec3> world(mesh->vertices.size());
+	for (size_t i = 0; i < world.size(); i++) {
+		world[i] = vec3(modelToWorld * vec4(mesh->vertices[i].pos, 1.0f));
+	}
+	addOccluder(world, mesh->indices);
+}
+
+void OcclusionCulling::addHeightfieldOccluder(std::span<const float> heights, int samples, float minXZ, float maxXZ)
+{
+	if (samples < 2 || heights.size() != static_cast<size_t>(samples) * samples) {
+		Error("OcclusionCulling: height field needs samples x samples heights");
+	}
+	float step = (maxXZ - minXZ) / (samples - 1);
+	vector<vec3> vertices(heights.size());
+	for (int z = 0; z < samples; z++) {
+		for (int x = 0; x < samples; x++) {
+			size_t i = static_cast<size_t>(z) * samples + x;
+			vertices[i] = vec3(minXZ + x * step, heights[i], minXZ + z * step);
+		}
+	}
+	vector<uint32_t> indices;
+	indices.reserve(static_cast<size_t>(samples - 1) * (samples - 1) * 6);
+	for (int z = 0; z < samples - 1; z++) {
+		for (int x = 0; x < samples - 1; x++) {
+			uint32_t i0 = z * samples + x;
+			uint32_t i1 = i0 + 1;
+			uint32_t i2 = i0 + samples;
+			uint32_t i3 = i2 + 1;
+			indices.insert(indices.end(), { i0, i2, i1, i1, i2, i3 });
+		}
+	}
+	addOccluder(vertices, indices);
+}
+
+void OcclusionCulling::addHeightfieldEnvelopeOccluder(std::span<const float> heights, int samples, int subSamples, float minXZ, float maxXZ)
+{
+	if (subSamples < 1 || samples < 2 || (samples - 1) % subSamples != 0 || heights.size() < static_cast<size_t>(samples) * samples) {
+		Error("OcclusionCulling: invalid height field envelope resolution");
+	}
+	// lower envelope: every coarse vertex is at the lowest terrain point of the cells it belongs to,
+	// so the plane through any coarse triangle stays below the terrain of its cell
+	int cells = (samples - 1) / subSamples;
+	int coarseSamples = cells + 1;
+	vector<float> coarse(static_cast<size_t>(coarseSamples) * coarseSamples);
+	for (int z = 0; z < coarseSamples; z++) {
+		int z0 = std::max(0, (z - 1) * subSamples), z1 = std::min(samples - 1, (z + 1) * subSamples);
+		for (int x = 0; x < coarseSamples; x++) {
+			int x0 = std::max(0, (x - 1) * subSamples), x1 = std::min(samples - 1, (x + 1) * subSamples);
+			float h = numeric_limits<float>::max();
+			for (int fz = z0; fz <= z1; fz++) {
+				for (int fx = x0; fx <= x1; fx++) {
+					h = std::min(h, heights[static_cast<size_t>(fz) * samples + fx]);
+				}
+			}
+			coarse[static_cast<size_t>(z) * coarseSamples + x] = h;
+		}
+	}
+	addHeightfieldOccluder(coarse, coarseSamples, minXZ, maxXZ);
+}
+
+void OcclusionCulling::addTerrainOccluder(World& world, int cells, int subSamples)
+{
+	if (cells < 1 || subSamples < 1) {
+		Error("OcclusionCulling: invalid terrain occluder resolution");
+	}
+	float maxXZ = world.getWorldSize().x / 2.0f;
+	float minXZ = -maxXZ;
+	int fineSamples = cells * subSamples + 1;
+	float fineStep = (maxXZ - minXZ) / (fineSamples - 1);
+	vector<float> fine(static_cast<size_t>(fineSamples) * fineSamples);
+	for (int z = 0; z < fineSamples; z++) {
+		float wz = std::min(minXZ + z * fineStep, maxXZ);
+		for (int x = 0; x < fineSamples; x++) {
+			float wx = std::min(minXZ + x * fineStep, maxXZ);
+			fine[static_cast<size_t>(z) * fineSamples + x] = world.getHeightmapValue(wx, wz);
+		}
+	}
+	addHeightfieldEnvelopeOccluder(fine, fineSamples, subSamples, minXZ, maxXZ);
+}
+
+void OcclusionCulling::clearOccluders()
+{
+	occluderX.clear();
+	occluderY.clear();
+	occluderZ.clear();
+	occluderIndices.clear();
+	occluderVertices = 0;
+}
+
+void OcclusionCulling::render(const glm::mat4& viewProj, ThreadGroup* threads)
+{
+	viewProjection = viewProj;
+	stats = OcclusionCullingStats();
+	// transform occluder vertices to clip space, 4 at a time
+	const mat4& m = viewProj;
+	size_t padded = occluderX.size();
+	clipX.resize(padded);
+	clipY.resize(padded);
+	clipZ.resize(padded);
+	clipW.resize(padded);
+	for (size_t i = 0; i < padded; i += SIMD_WIDTH) {
+		Float4 x = Float4::load(&occluderX[i]);
+		Float4 y = Float4::load(&occluderY[i]);
+		Float4 z = Float4::load(&occluderZ[i]);
+		(Float4(m[0][0]) * x + Float4(m[1][0]) * y + Float4(m[2][0]) * z + Float4(m[3][0])).store(&clipX[i]);
+		(Float4(m[0][1]) * x + Float4(m[1][1]) * y + Float4(m[2][1]) * z + Float4(m[3][1])).store(&clipY[i]);
+		(Float4(m[0][2]) * x + Float4(m[1][2]) * y + Float4(m[2][2]) * z + Float4(m[3][2])).store(&clipZ[i]);
+		(Float4(m[0][3]) * x + Float4(m[1][3]) * y + Float4(m[2][3]) * z + Float4(m[3][3])).store(&clipW[i]);
+	}
+	// clip, project and bin triangles
+	triangles.clear();
+	for (auto& bin : bins) {
+		bin.clear();
+	}
+	auto vertex = [this](uint32_t i) { return vec4(clipX[i], clipY[i], clipZ[i], clipW[i]); };
+	for (size_t t = 0; t < occluderIndices.size(); t += 3) {
+		setupTriangle(vertex(occluderIndices[t]), vertex(occluderIndices[t + 1]), vertex(occluderIndices[t + 2]));
+	}
+	stats.occluderTriangles = static_cast<uint32_t>(triangles.size());
+	// rasterize tiles and build the tile part of the hierarchy
+	int tileCount = tilesX * tilesY;
+	if (threads == nullptr || tileCount <= 1) {
+		for (int tile = 0; tile < tileCount; tile++) {
+			rasterizeTile(tile);
+		}
+	} else {
+		vector<future<void>> futures;
+		futures.reserve(tileCount);
+		for (int tile = 0; tile < tileCount; tile++) {
+			futures.push_back(threads->asyncSubmit([this, tile] { rasterizeTile(tile); }));
+		}
+		for (auto& f : futures) {
+			f.get();
+		}
+	}
+	for (int level = tileLevels + 1; level < getLevelCount(); level++) {
+		buildLevel(level, 0, 0, levels[level].width, levels[level].height);
+	}
+}
+
+// clip triangle against near plane (z >= 0), the other planes are handled by the tile bounds
+void OcclusionCulling::setupTriangle(const glm::vec4& v0, const glm::vec4& v1, const glm::vec4& v2)
+{
+	// trivial reject if all vertices are outside one plane
+	if (v0.x > v0.w && v1.x > v1.w && v2.x > v2.w) return;
+	if (v0.x < -v0.w && v1.x < -v1.w && v2.x < -v2.w) return;
+	if (v0.y > v0.w && v1.y > v1.w && v2.y > v2.w) return;
+	if (v0.y < -v0.w && v1.y < -v1.w && v2.y < -v2.w) return;
+	if (v0.z > v0.w && v1.z > v1.w && v2.z > v2.w) return;
+	if (v0.z < 0.0f && v1.z < 0.0f && v2.z < 0.0f) return;
+	if (v0.z >= 0.0f && v1.z >= 0.0f && v2.z >= 0.0f) {
+		addScreenTriangle(v0, v1, v2);
+		return;
+	}
+	const vec4 in[3] = { v0, v1, v2 };
+	vec4 out[4];
+	int n = 0;
+	for (int i = 0; i < 3; i++) {
+		const vec4& a = in[i];
+		const vec4& b = in[(i + 1) % 3];
+		if (a.z >= 0.0f) out[n++] = a;
+		if ((a.z >= 0.0f) != (b.z >= 0.0f)) {
+			float t = a.z / (a.z - b.z);
+			vec4 p = a + (b - a) * t;
+			p.z = 0.0f;
+			out[n++] = p;
+		}
+	}
+	for (int i = 1; i + 1 < n; i++) {
+		addScreenTriangle(out[0], out[i], out[i + 1]);
+	}
+}
+
+void OcclusionCulling::addScreenTriangle(const glm::vec4& v0, const glm::vec4& v1, const glm::vec4& v2)
+{
+	float width = static_cast<float>(getWidth());
+	float height = static_cast<float>(getHeight());
+	vec3 p[3];
+	const vec4* v[3] = { &v0, &v1, &v2 };
+	for (int i = 0; i < 3; i++) {
+		float iw = 1.0f / v[i]->w;
+		p[i] = vec3((v[i]->x * iw * 0.5f + 0.5f) * width, (v[i]->y * iw * 0.5f + 0.5f) * height, v[i]->z * iw);
+	}
+	float area = (p[1].x - p[0].x) * (p[2].y - p[0].y) - (p[1].y - p[0].y) * (p[2].x - p[0].x);
+	if (abs(area) < 1e-6f) return;
+	if (area < 0.0f) {
+		std::swap(p[1], p[2]);
+		area = -area;
+	}
+	ScreenTriangle t;
+	// pixels with centers inside the bounding rect
+	t.minX = std::max(0, static_cast<int>(ceil(std::min({ p[0].x, p[1].x, p[2].x }) - 0.5f)));
+	t.maxX = std::min(getWidth() - 1, static_cast<int>(floor(std::max({ p[0].x, p[1].x, p[2].x }) - 0.5f)));
+	t.minY = std::max(0, static_cast<int>(ceil(std::min({ p[0].y, p[1].y, p[2].y }) - 0.5f)));
+	t.maxY = std::min(getHeight() - 1, static_cast<int>(floor(std::max({ p[0].y, p[1].y, p[2].y }) - 0.5f)));
+	if (t.minX > t.maxX || t.minY > t.maxY) return;
+	for (int e = 0; e < 3; e++) {
+		const vec3& a = p[e];
+		const vec3& b = p[(e + 1) % 3];
+		t.a[e] = a.y - b.y;
+		t.b[e] = b.x - a.x;
+		t.c[e] = (b.y - a.y) * a.x - (b.x - a.x) * a.y;
+	}
+	// barycentric weight of vertex 1 is edge 2 / area, of vertex 2 edge 0 / area
+	float dz1 = (p[1].z - p[0].z) / area;
+	float dz2 = (p[2].z - p[0].z) / area;
+	t.za = t.a[2] * dz1 + t.a[0] * dz2;
+	t.zb = t.b[2] * dz1 + t.b[0] * dz2;
+	t.zc = p[0].z + t.c[2] * dz1 + t.c[0] * dz2;
+	uint32_t index = static_cast<uint32_t>(triangles.size());
+	triangles.push_back(t);
+	for (int ty = t.minY / TILE_HEIGHT; ty <= t.maxY / TILE_HEIGHT; ty++) {
+		for (int tx = t.minX / TILE_WIDTH; tx <= t.maxX / TILE_WIDTH; tx++) {
+			bins[ty * tilesX + tx].push_back(index);
+		}
+	}
+}
+
+void OcclusionCulling::rasterizeTile(int tile)
+{
+	int x0 = (tile % tilesX) * TILE_WIDTH;
+	int y0 = (tile / tilesX) * TILE_HEIGHT;
+	DepthLevel& l = levels[0];
+	for (int y = y0; y < y0 + TILE_HEIGHT; y++) {
+		std::fill_n(&l.depth[static_cast<size_t>(y) * l.width + x0], TILE_WIDTH, 1.0f);
+	}
+	const Float4 zero(0.0f);
+	const Float4 laneOffset(0.5f, 1.5f, 2.5f, 3.5f);
+	for (uint32_t index : bins[tile]) {
+		const ScreenTriangle& t = triangles[index];
+		int xs = std::max(t.minX, x0) & ~(SIMD_WIDTH - 1);
+		int xe = std::min(t.maxX, x0 + TILE_WIDTH - 1);
+		int ys = std::max(t.minY, y0);
+		int ye = std::min(t.maxY, y0 + TILE_HEIGHT - 1);
+		Float4 step[3];
+		for (int e = 0; e < 3; e++) {
+			step[e] = Float4(t.a[e] * SIMD_WIDTH);
+		}
+		Float4 zStep(t.za * SIMD_WIDTH);
+		Float4 xc = Float4(static_cast<float>(xs)) + laneOffset;
+		for (int y = ys; y <= ye; y++) {
+			float yc = y + 0.5f;
+			Float4 e0 = Float4(t.a[0]) * xc + Float4(t.b[0] * yc + t.c[0]);
+			Float4 e1 = Float4(t.a[1]) * xc + Float4(t.b[1] * yc + t.c[1]);
+			Float4 e2 = Float4(t.a[2]) * xc + Float4(t.b[2] * yc + t.c[2]);
+			Float4 z = Float4(t.za) * xc + Float4(t.zb * yc + t.zc);
+			float* row = &l.depth[static_cast<size_t>(y) * l.width];
+			for (int x = xs; x <= xe; x += SIMD_WIDTH) {
+				Float4 outside = Float4::lessThan(e0, zero) | Float4::lessThan(e1, zero) | Float4::lessThan(e2, zero);
+				if (Float4::moveMask(outside) != 0xF) {
+					Float4 d = Float4::load(row + x);
+					Float4::select(outside, d, Float4::min(d, z)).store(row + x);
+				}
+				e0 = e0 + step[0];
+				e1 = e1 + step[1];
+				e2 = e2 + step[2];
+				z = z + zStep;
+			}
+		}
+	}
+	for (int level = 1; level <= tileLevels; level++) {
+		buildLevel(level, x0 >> level, y0 >> level, (x0 + TILE_WIDTH) >> level, (y0 + TILE_HEIGHT) >> level);
+	}
+}
+
+void OcclusionCulling::buildLevel(int level, int x0, int y0, int x1, int y1)
+{
+	const DepthLevel& src = levels[level - 1];
+	DepthLevel& dst = levels[level];
+	for (int y = y0; y < y1; y++) {
+		const float* r0 = &src.depth[static_cast<size_t>(2 * y) * src.width];
+		const float* r1 = &src.depth[static_cast<size_t>(std::min(2 * y + 1, src.height - 1)) * src.width];
+		float* out = &dst.depth[static_cast<size_t>(y) * dst.width];
+		for (int x = x0; x < x1; x++) {
+			int sx0 = 2 * x;
+			int sx1 = std::min(sx0 + 1, src.width - 1);
+			out[x] = std::max(std::max(r0[sx0], r0[sx1]), std::max(r1[sx0], r1[sx1]));
+		}
+	}
+}
+
+bool OcclusionCulling::isOccluded(const glm::vec3& min, const glm::vec3& max) const
+{
+	// corners 0..3 at min.z, 4..7 at max.z
+	const mat4& m = viewProjection;
+	const Float4 x(min.x, max.x, min.x, max.x);
+	const Float4 y(min.y, min.y, max.y, max.y);
+	float cx[8], cy[8], cz[8], cw[8];
+	for (int half = 0; half < 2; half++) {
+		Float4 z(half == 0 ? min.z : max.z);
+		(Float4(m[0][0]) * x + Float4(m[1][0]) * y + Float4(m[2][0]) * z + Float4(m[3][0])).store(cx + half * 4);
+		(Float4(m[0][1]) * x + Float4(m[1][1]) * y + Float4(m[2][1]) * z + Float4(m[3][1])).store(cy + half * 4);
+		Float4 clipZ = Float4(m[0][2]) * x + Float4(m[1][2]) * y + Float4(m[2][2]) * z + Float4(m[3][2]);
+		if (Float4::moveMask(Float4::lessThan(clipZ, Float4(0.0f))) != 0) {
+			return false; // crosses near plane
+		}
+		clipZ.store(cz + half * 4);
+		(Float4(m[0][3]) * x + Float4(m[1][3]) * y + Float4(m[2][3]) * z + Float4(m[3][3])).store(cw + half * 4);
+	}
+	float width = static_cast<float>(getWidth());
+	float height = static_cast<float>(getHeight());
+	float minX = numeric_limits<float>::max(), minY = minX, minZ = minX;
+	float maxX = -minX, maxY = -minX;
+	for (int c = 0; c < 8; c++) {
+		float iw = 1.0f / cw[c];
+		float sx = (cx[c] * iw * 0.5f + 0.5f) * width;
+		float sy = (cy[c] * iw * 0.5f + 0.5f) * height;
+		minX = std::min(minX, sx);
+		maxX = std::max(maxX, sx);
+		minY = std::min(minY, sy);
+		maxY = std::max(maxY, sy);
+		minZ = std::min(minZ, cz[c] * iw);
+	}
+	if (maxX < 0.0f || maxY < 0.0f || minX > width || minY > height) {
+		return false; // left to frustum culling
+	}
+	// all pixels touched by the screen rect plus one pixel border: occluders only cover pixel centers,
+	// an occluder edge crossing a touched pixel leaves an uncovered neighbour
+	int px0 = std::clamp(static_cast<int>(floor(minX)) - 1, 0, getWidth() - 1);
+	int px1 = std::clamp(static_cast<int>(floor(maxX)) + 1, 0, getWidth() - 1);
+	int py0 = std::clamp(static_cast<int>(floor(minY)) - 1, 0, getHeight() - 1);
+	int py1 = std::clamp(static_cast<int>(floor(maxY)) + 1, 0, getHeight() - 1);
+	// finest level where the rect covers at most 4x4 texels
+	int level = 0;
+	while (level + 1 < getLevelCount() && ((px1 >> level) - (px0 >> level) > 3 || (py1 >> level) - (py0 >> level) > 3)) {
+		level++;
+	}
+	float maxDepth = 0.0f;
+	for (int ty = py0 >> level; ty <= (py1 >> level); ty++) {
+		for (int tx = px0 >> level; tx <= (px1 >> level); tx++) {
+			maxDepth = std::max(maxDepth, getDepth(tx, ty, level));
+		}
+	}
+	return minZ > maxDepth;
+}
+
+void OcclusionCulling::testBoxes(std::span<const ObjectBounds> bounds, std::vector<uint8_t>& occluded, ThreadGroup* threads)
+{
+	size_t n = bounds.size();
+	occluded.resize(n);
+	auto testRange = [this, &bounds, &occluded](size_t start, size_t end) {
+		uint32_t count = 0;
+		for (size_t i = start; i < end; i++) {
+			bool o = isOccluded(bounds[i].min, bounds[i].max);
+			occluded[i] = o ? 1 : 0;
+			if (o) count++;
+		}
+		return count;
+	};
+	stats.tested += static_cast<uint32_t>(n);
+	if (threads == nullptr || n <= PARALLEL_CHUNK_SIZE) {
+		stats.occluded += testRange(0, n);
+		return;
+	}
+	size_t chunks = (n + PARALLEL_CHUNK_SIZE - 1) / PARALLEL_CHUNK_SIZE;
+	vector<uint32_t> partial(chunks);
+	vector<future<void>> futures;
+	futures.reserve(chunks);
+	for (size_t c = 0; c < chunks; c++) {
+		size_t start = c * PARALLEL_CHUNK_SIZE;
+		size_t end = std::min(n, start + PARALLEL_CHUNK_SIZE);
+		futures.push_back(threads->asyncSubmit([&testRange, &partial, c, start, end] { partial[c] = testRange(start, end); }));
+	}
+	for (size_t c = 0; c < chunks; c++) {
+		futures[c].get();
+		stats.occluded += partial[c];
+	}
+}
+
+// call from prepareFrame() after FrustumCulling::updatePerFrame()
+void OcclusionCulling::updatePerFrame(FrameResources& fr, const glm::mat4& viewProjLeft, const glm::mat4& viewProjRight)
+{
+	if (getOccluderTriangleCount() == 0) return;
+	FrustumCulling& frustum = engine->frustumCulling;
+	ObjectComponentStore& components = engine->objectStore.getComponents();
+	if (components.size() != frustum.size()) {
+		Error("OcclusionCulling: objects were added or removed after frustum culling");
+	}
+	auto bounds = components.worldBounds();
+	const vector<uint32_t>& visible = frustum.getVisible();
+	occludedEyes.assign(visible.size(), 0);
+	bool stereo = engine->isStereo();
+	OcclusionCullingStats total;
+	for (int eye = 0; eye < (stereo ? 2 : 1); eye++) {
+		uint8_t eyeBit = eye == 0 ? CULL_VISIBLE_LEFT : CULL_VISIBLE_RIGHT;
+		testBounds.clear();
+		testObjects.clear();
+		for (size_t v = 0; v < visible.size(); v++) {
+			if (frustum.getResult(visible[v]) & eyeBit) {
+				testBounds.push_back(bounds[visible[v]]);
+				testObjects.push_back(static_cast<uint32_t>(v));
+			}
+		}
+		render(eye == 0 ? viewProjLeft : viewProjRight, engine->getWorkerThreads());
+		testBoxes(testBounds, testResult, engine->getWorkerThreads());
+		total.add(stats);
+		total.occluderTriangles = stats.occluderTriangles;
+		for (size_t k = 0; k < testObjects.size(); k++) {
+			if (testResult[k]) occludedEyes[testObjects[k]] |= eyeBit;
+		}
+	}
+	stats = total;
+
+	// only occluded objects are changed, all others keep the state set by FrustumCulling::applyToModels()
+	auto owners = components.owners();
+	auto flags = components.renderFlags();
+	for (size_t v = 0; v < visible.size(); v++) {
+		if (occludedEyes[v] == 0) continue;
+		uint32_t i = visible[v];
+		uint8_t remaining = frustum.getResult(i) & (CULL_VISIBLE_LEFT | CULL_VISIBLE_RIGHT) & ~occludedEyes[v];
+		if (remaining == 0) {
+			flags[i] &= ~(OBJECT_VISIBLE | OBJECT_FULLY_VISIBLE);
+		}
+		WorldObject* wo = owners[i];
+		if (wo == nullptr) continue;
+		if (remaining == 0) wo->visible = 0;
+		bool culledLeft = (remaining & CULL_VISIBLE_LEFT) == 0;
+		bool culledRight = stereo && (remaining & CULL_VISIBLE_RIGHT) == 0;
+		for (int p = 0; p < wo->primitiveCount; p++) {
+			PBRShader::DynamicModelUBO* buf = engine->shaders.pbrShader.getAccessToModel(fr, wo->dynamicModelUBOIndex + p);
+			buf->setCulled(culledLeft, culledRight);
+		}
+	}
+}
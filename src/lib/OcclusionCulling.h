@@ -0,0 +1,131 @@
+#pragma once
+
+// CPU occlusion culling with a hierarchical depth buffer.
+// Large occluders (terrain from the ultimate heightmap, designated big meshes) are rasterized into a low resolution
+// depth buffer, 4 pixels per SIMD step (see SimdMath.h). The screen is divided into tiles, triangles are binned to
+// tiles and each tile is rasterized by its own worker task. A max depth mip chain is built on top, so testing an
+// object box needs only a few texel reads: the box is occluded if its nearest depth is behind the farthest
+// occluder depth of all texels covering its screen rect.
+// Runs completely on the CPU, no device needed.
+// Occluders have to be conservative: terrain is added as lower envelope of the heightmap, so it never hides objects
+// the real terrain does not hide. Occluder coverage is sampled at pixel centers, like the GPU does.
+
+class World;
+
+struct OcclusionCullingStats {
+	uint32_t occluderTriangles = 0; // rasterized triangles after near plane clipping, last render()
+	uint32_t tested = 0;
+	uint32_t occluded = 0;
+	float occlusionRate() const {
+		return tested == 0 ? 0.0f : static_cast<float>(occluded) / tested;
+	}
+	void add(const OcclusionCullingStats& other) {
+		tested += other.tested;
+		occluded += other.occluded;
+	}
+	void log() const;
+};
+
+class OcclusionCulling : public EngineParticipant
+{
+public:
+	static constexpr int TILE_WIDTH = 64; // multiple of SIMD_WIDTH
+	static constexpr int TILE_HEIGHT = 32;
+	static constexpr int DEFAULT_WIDTH = 256;
+	static constexpr int DEFAULT_HEIGHT = 128;
+	// objects per task for parallel box tests
+	static constexpr size_t PARALLEL_CHUNK_SIZE = 4096;
+
+	OcclusionCulling() {
+		init(DEFAULT_WIDTH, DEFAULT_HEIGHT);
+	}
+	// depth buffer size in pixels, multiples of TILE_WIDTH and TILE_HEIGHT
+	void init(int width, int height);
+
+	// occluders in world space, kept until clearOccluders()
+	void addOccluder(std::span<const glm::vec3> vertices, std::span<const uint32_t> indices);
+	// designated large mesh, needs CPU side vertices and indices (before upload)
+	void addOccluder(const MeshInfo* mesh, const glm::mat4& modelToWorld);
+	// height field of samples x samples heights covering the square [minXZ, maxXZ] in x and z, index z * samples + x
+	void addHeightfieldOccluder(std::span<const float> heights, int samples, float minXZ, float maxXZ);
+	// lower envelope of a fine height field (same layout as above) with (samples - 1) / subSamples quads per edge.
+	// Each coarse vertex gets the minimum height found in its adjacent cells, the coarse terrain stays below the fine one
+	void addHeightfieldEnvelopeOccluder(std::span<const float> heights, int samples, int subSamples, float minXZ, float maxXZ);
+	// terrain from World::getHeightmapValue() as cells x cells quads, sampled with subSamples per cell edge and
+	// added as lower envelope. World::prepareUltimateHeightmap() has to be called before
+	void addTerrainOccluder(World& world, int cells, int subSamples = 4);
+	void clearOccluders();
+	size_t getOccluderTriangleCount() const {
+		return occluderIndices.size() / 3;
+	}
+
+	// rasterize all occluders for this view and build the depth hierarchy. Resets stats
+	void render(const glm::mat4& viewProj, ThreadGroup* threads = nullptr);
+	// true if world space box is completely hidden by occluders of last render().
+	// Boxes crossing the near plane or outside the screen are never occluded
+	bool isOccluded(const glm::vec3& min, const glm::vec3& max) const;
+	// occluded[i] = 1 if bounds[i] is occluded. Adds to stats
+	void testBoxes(std::span<const ObjectBounds> bounds, std::vector<uint8_t>& occluded, ThreadGroup* threads = nullptr);
+
+	// depth of last render(), 0 near .. 1 far, 1 where no occluder was drawn. Higher levels hold max of 2x2 texels
+	float getDepth(int x, int y, int level = 0) const {
+		return levels[level].depth[y * levels[level].width + x];
+	}
+	int getWidth() const {
+		return levels[0].width;
+	}
+	int getHeight() const {
+		return levels[0].height;
+	}
+	int getLevelCount() const {
+		return static_cast<int>(levels.size());
+	}
+	const OcclusionCullingStats& getStats() const {
+		return stats;
+	}
+
+	// engine integration
+	// call after FrustumCulling::updatePerFrame(): objects visible there are tested against the occluders,
+	// once per eye in stereo. Occluded objects get the culled flags of FrustumCulling::applyToModels().
+	// Does nothing without occluders
+	void updatePerFrame(FrameResources& fr, const glm::mat4& viewProjLeft, const glm::mat4& viewProjRight);
+
+private:
+	struct DepthLevel {
+		int width = 0;
+		int height = 0;
+		std::vector<float> depth;
+	};
+	// screen space triangle, counter clockwise after setup
+	struct ScreenTriangle {
+		// edge functions A * x + B * y + C >= 0 inside
+		float a[3], b[3], c[3];
+		// depth plane z = za * x + zb * y + zc
+		float za, zb, zc;
+		int minX, minY, maxX, maxY; // pixel bounds, inclusive
+	};
+	void setupTriangle(const glm::vec4& v0, const glm::vec4& v1, const glm::vec4& v2);
+	void addScreenTriangle(const glm::vec4& v0, const glm::vec4& v1, const glm::vec4& v2);
+	void rasterizeTile(int tile);
+	// max of 2x2 texels of level - 1 for texel rect [x0, x1) x [y0, y1) of level
+	void buildLevel(int level, int x0, int y0, int x1, int y1);
+
+	std::vector<DepthLevel> levels;
+	int tilesX = 0, tilesY = 0;
+	int tileLevels = 0; // levels built per tile, the rest is built for the whole screen
+	// world space occluders
+	std::vector<float> occluderX, occluderY, occluderZ; // SoA, padded to SIMD_WIDTH
+	std::vector<uint32_t> occluderIndices;
+	size_t occluderVertices = 0;
+	// per render()
+	glm::mat4 viewProjection = glm::mat4(1.0f);
+	std::vector<float> clipX, clipY, clipZ, clipW; // occluder vertices in clip space
+	std::vector<ScreenTriangle> triangles;
+	std::vector<std::vector<uint32_t>> bins; // triangle indexes per tile
+	OcclusionCullingStats stats;
+	// per updatePerFrame()
+	std::vector<ObjectBounds> testBounds;
+	std::vector<uint32_t> testObjects;
+	std::vector<uint8_t> testResult;
+	std::vector<uint8_t> occludedEyes; // bit 0 left, bit 1 right
+};
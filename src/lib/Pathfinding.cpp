@@ -0,0 +1,569 @@
+#include "mainheader.h"
+
+using namespace std;
+using namespace glm;
+
+static constexpr float DIAGONAL_COST = 1.41421356f;
+
+// octile distance, exact path length on an empty grid
+static float octile(ivec2 a, ivec2 b)
+{
+	int dx = abs(a.x - b.x), dz = abs(a.y - b.y);
+	return static_cast<float>(std::max(dx, dz) - std::min(dx, dz)) + DIAGONAL_COST * std::min(dx, dz);
+}
+
+// WalkabilityGrid
+
+void WalkabilityGrid::init(std::vector<float> heights, int samples, float minXZ, float maxXZ)
+{
+	if (samples < 2 || heights.size() != static_cast<size_t>(samples) * samples) {
+		Error("WalkabilityGrid: heights have to be samples x samples values");
+	}
+	this->heights = std::move(heights);
+	this->samples = samples;
+	this->minXZ = minXZ;
+	cellSize = (maxXZ - minXZ) / (samples - 1);
+	walkable.assign(this->heights.size(), 1);
+	version++;
+}
+
+void WalkabilityGrid::initFromWorld(World& world, int s)
+{
+	float maxCoord = world.getWorldSize().x / 2.0f;
+	float minCoord = -maxCoord;
+	float step = (maxCoord - minCoord) / (s - 1);
+	vector<float> h(static_cast<size_t>(s) * s);
+	for (int z = 0; z < s; z++) {
+		float wz = std::min(minCoord + z * step, maxCoord);
+		for (int x = 0; x < s; x++) {
+			float wx = std::min(minCoord + x * step, maxCoord);
+			h[static_cast<size_t>(z) * s + x] = world.getHeightmapValue(wx, wz);
+		}
+	}
+	init(std::move(h), s, minCoord, maxCoord);
+}
+
+void WalkabilityGrid::deriveWalkability(const WalkabilitySettings& settings)
+{
+	float maxRise = tan(settings.maxSlope) * cellSize;
+	for (int z = 0; z < samples; z++) {
+		for (int x = 0; x < samples; x++) {
+			float h = getHeight(x, z);
+			bool ok = h >= settings.waterLevel;
+			if (x > 0) ok = ok && abs(getHeight(x - 1, z) - h) <= maxRise;
+			if (x < samples - 1) ok = ok && abs(getHeight(x + 1, z) - h) <= maxRise;
+			if (z > 0) ok = ok && abs(getHeight(x, z - 1) - h) <= maxRise;
+			if (z < samples - 1) ok = ok && abs(getHeight(x, z + 1) - h) <= maxRise;
+			walkable[static_cast<size_t>(z) * samples + x] = ok ? 1 : 0;
+		}
+	}
+	version++;
+}
+
+void WalkabilityGrid::addFootprint(const ObjectBounds& bounds, float margin)
+{
+	int x0 = static_cast<int>(ceil((bounds.min.x - margin - minXZ) / cellSize));
+	int x1 = static_cast<int>(floor((bounds.max.x + margin - minXZ) / cellSize));
+	int z0 = static_cast<int>(ceil((bounds.min.z - margin - minXZ) / cellSize));
+	int z1 = static_cast<int>(floor((bounds.max.z + margin - minXZ) / cellSize));
+	for (int z = std::max(0, z0); z <= std::min(samples - 1, z1); z++) {
+		for (int x = std::max(0, x0); x <= std::min(samples - 1, x1); x++) {
+			walkable[static_cast<size_t>(z) * samples + x] = 0;
+		}
+	}
+	version++;
+}
+
+void WalkabilityGrid::setWalkable(int x, int z, bool w)
+{
+	walkable[static_cast<size_t>(z) * samples + x] = w ? 1 : 0;
+	version++;
+}
+
+glm::ivec2 WalkabilityGrid::toGrid(float x, float z) const
+{
+	int gx = static_cast<int>(round((x - minXZ) / cellSize));
+	int gz = static_cast<int>(round((z - minXZ) / cellSize));
+	return ivec2(std::clamp(gx, 0, samples - 1), std::clamp(gz, 0, samples - 1));
+}
+
+// walk all cells the segment between node centers passes, through corners both side cells have to be walkable
+bool WalkabilityGrid::hasLineOfSight(glm::ivec2 a, glm::ivec2 b) const
+{
+	if (!isWalkable(a.x, a.y) || !isWalkable(b.x, b.y)) return false;
+	int dx = abs(b.x - a.x), dz = abs(b.y - a.y);
+	int sx = b.x > a.x ? 1 : -1, sz = b.y > a.y ? 1 : -1;
+	int x = a.x, z = a.y;
+	// compare crossing times of the next x and z cell borders in integer math: (2i + 1) * dz vs (2j + 1) * dx
+	int64_t i = 0, j = 0;
+	while (x != b.x || z != b.y) {
+		int64_t tx = (2 * i + 1) * static_cast<int64_t>(dz);
+		int64_t tz = (2 * j + 1) * static_cast<int64_t>(dx);
+		if (tx < tz) {
+			x += sx; i++;
+		} else if (tz < tx) {
+			z += sz; j++;
+		} else {
+			// exactly through a corner
+			if (!isWalkable(x + sx, z) || !isWalkable(x, z + sz)) return false;
+			x += sx; z += sz; i++; j++;
+		}
+		if (!isWalkable(x, z)) return false;
+	}
+	return true;
+}
+
+// HierarchicalPathfinder
+
+void PathfindingStats::log() const
+{
+	Log("Pathfinding: requests " << requests << " cache hits " << cacheHits << " failed " << failed << " expansions " << expansions << endl);
+}
+
+void HierarchicalPathfinder::init(const WalkabilityGrid* grid, int clusterSize, size_t cacheSize)
+{
+	if (grid == nullptr || grid->getSize() == 0 || clusterSize < 2) {
+		Error("HierarchicalPathfinder: invalid grid or cluster size");
+	}
+	this->grid = grid;
+	this->clusterSize = clusterSize;
+	this->cacheSize = cacheSize;
+	builtWalkable.clear();
+	rebuild();
+}
+
+HierarchicalPathfinder::Rect HierarchicalPathfinder::clusterRect(int cluster) const
+{
+	int cx = cluster % clustersPerEdge, cz = cluster / clustersPerEdge;
+	int last = grid->getSize() - 1;
+	return Rect{ cx * clusterSize, cz * clusterSize, std::min(last, (cx + 1) * clusterSize - 1), std::min(last, (cz + 1) * clusterSize - 1) };
+}
+
+int HierarchicalPathfinder::addAbstractNode(glm::ivec2 p)
+{
+	int& index = abstractIndex[gridIndex(p)];
+	if (index < 0) {
+		index = static_cast<int>(abstractNodes.size());
+		abstractNodes.push_back(AbstractNode{ p, clusterOf(p), {} });
+		clusterNodes[clusterOf(p)].push_back(index);
+	}
+	return index;
+}
+
+// entrances on the border between clusterA and clusterB (right or lower neighbour of A)
+void HierarchicalPathfinder::addEntrances(int clusterA, int clusterB, bool horizontal)
+{
+	Rect a = clusterRect(clusterA);
+	Rect b = clusterRect(clusterB);
+	int length = horizontal ? a.z1 - a.z0 + 1 : a.x1 - a.x0 + 1;
+	auto sides = [&](int i, ivec2& pa, ivec2& pb) {
+		if (horizontal) {
+			pa = ivec2(a.x1, a.z0 + i);
+			pb = ivec2(b.x0, a.z0 + i);
+		} else {
+			pa = ivec2(a.x0 + i, a.z1);
+			pb = ivec2(a.x0 + i, b.z0);
+		}
+		return grid->isWalkable(pa.x, pa.y) && grid->isWalkable(pb.x, pb.y);
+	};
+	auto connect = [this, &sides](int i) {
+		ivec2 pa, pb;
+		sides(i, pa, pb);
+		int na = addAbstractNode(pa), nb = addAbstractNode(pb);
+		abstractNodes[na].edges.push_back(Edge{ nb, 1.0f });
+		abstractNodes[nb].edges.push_back(Edge{ na, 1.0f });
+	};
+	int i = 0;
+	while (i < length) {
+		ivec2 pa, pb;
+		if (!sides(i, pa, pb)) {
+			i++;
+			continue;
+		}
+		int start = i;
+		while (i < length && sides(i, pa, pb)) i++;
+		int end = i - 1;
+		if (end - start + 1 <= MAX_SINGLE_ENTRANCE_LENGTH) {
+			connect((start + end) / 2);
+		} else {
+			connect(start);
+			connect(end);
+		}
+	}
+}
+
+void HierarchicalPathfinder::rebuild()
+{
+	int size = grid->getSize();
+	int newClustersPerEdge = (size + clusterSize - 1) / clusterSize;
+	size_t nodeCount = static_cast<size_t>(size) * size;
+	size_t clusterCount = static_cast<size_t>(newClustersPerEdge) * newClustersPerEdge;
+	// clusters with changed walkability since the last build, all of them on first build
+	vector<bool> dirty(clusterCount, true);
+	if (builtWalkable.size() == nodeCount && newClustersPerEdge == clustersPerEdge) {
+		fill(dirty.begin(), dirty.end(), false);
+		for (int z = 0; z < size; z++) {
+			for (int x = 0; x < size; x++) {
+				if ((builtWalkable[static_cast<size_t>(z) * size + x] != 0) != grid->isWalkable(x, z)) {
+					dirty[clusterOf(ivec2(x, z))] = true;
+				}
+			}
+		}
+	}
+	// keep intra cluster edges of unchanged clusters: entrance positions in cluster order and edges by local index
+	struct LocalEdge {
+		int from, to;
+		float cost;
+	};
+	struct ClusterEdges {
+		vector<ivec2> entrances;
+		vector<LocalEdge> edges;
+	};
+	vector<ClusterEdges> kept(clusterCount);
+	for (size_t c = 0; c < clusterNodes.size() && c < clusterCount; c++) {
+		if (dirty[c]) continue;
+		auto& nodes = clusterNodes[c];
+		for (int local = 0; local < static_cast<int>(nodes.size()); local++) {
+			kept[c].entrances.push_back(abstractNodes[nodes[local]].pos);
+			for (auto& e : abstractNodes[nodes[local]].edges) {
+				if (abstractNodes[e.to].cluster != static_cast<int>(c)) continue;
+				int toLocal = static_cast<int>(find(nodes.begin(), nodes.end(), e.to) - nodes.begin());
+				kept[c].edges.push_back(LocalEdge{ local, toLocal, e.cost });
+			}
+		}
+	}
+
+	clustersPerEdge = newClustersPerEdge;
+	abstractNodes.clear();
+	clusterNodes.assign(clusterCount, vector<int>());
+	abstractIndex.assign(nodeCount, -1);
+	gScore.assign(nodeCount, 0.0f);
+	parent.assign(gScore.size(), -1);
+	stamp.assign(gScore.size(), 0);
+	currentStamp = 0;
+	cache.clear();
+	cacheOrder.clear();
+	cacheVersion = grid->getVersion();
+	builtWalkable.resize(nodeCount);
+	for (int z = 0; z < size; z++) {
+		for (int x = 0; x < size; x++) {
+			builtWalkable[static_cast<size_t>(z) * size + x] = grid->isWalkable(x, z) ? 1 : 0;
+		}
+	}
+
+	// entrances only depend on the border nodes, finding them is cheap
+	for (int cz = 0; cz < clustersPerEdge; cz++) {
+		for (int cx = 0; cx < clustersPerEdge; cx++) {
+			int c = cz * clustersPerEdge + cx;
+			if (cx + 1 < clustersPerEdge) addEntrances(c, c + 1, true);
+			if (cz + 1 < clustersPerEdge) addEntrances(c, c + clustersPerEdge, false);
+		}
+	}
+	// intra cluster edges: costs between all entrances of a cluster.
+	// Searched again only if the cluster changed or a neighbour change moved its entrances
+	uint32_t reused = 0;
+	for (size_t c = 0; c < clusterNodes.size(); c++) {
+		auto& nodes = clusterNodes[c];
+		bool same = !dirty[c] && kept[c].entrances.size() == nodes.size();
+		for (size_t i = 0; same && i < nodes.size(); i++) {
+			same = abstractNodes[nodes[i]].pos == kept[c].entrances[i];
+		}
+		if (same) {
+			for (auto& e : kept[c].edges) {
+				abstractNodes[nodes[e.from]].edges.push_back(Edge{ nodes[e.to], e.cost });
+			}
+			reused++;
+			continue;
+		}
+		Rect r = clusterRect(static_cast<int>(c));
+		for (int from : nodes) {
+			search(abstractNodes[from].pos, nullptr, r, nullptr);
+			for (int to : nodes) {
+				if (to == from) continue;
+				float cost = readCost(abstractNodes[to].pos);
+				if (cost < numeric_limits<float>::max()) {
+					abstractNodes[from].edges.push_back(Edge{ to, cost });
+				}
+			}
+		}
+	}
+	reusedClusters = reused;
+}
+
+size_t HierarchicalPathfinder::getAbstractEdgeCount() const
+{
+	size_t n = 0;
+	for (auto& node : abstractNodes) n += node.edges.size();
+	return n;
+}
+
+bool HierarchicalPathfinder::search(glm::ivec2 start, const glm::ivec2* goal, const Rect& rect, std::vector<glm::ivec2>* path)
+{
+	if (++currentStamp == 0) {
+		fill(stamp.begin(), stamp.end(), 0);
+		currentStamp = 1;
+	}
+	using Entry = pair<float, int>; // f, grid index
+	priority_queue<Entry, vector<Entry>, greater<Entry>> open;
+	int size = grid->getSize();
+	int s = gridIndex(start);
+	gScore[s] = 0.0f;
+	parent[s] = -1;
+	stamp[s] = currentStamp;
+	open.push({ goal ? octile(start, *goal) : 0.0f, s });
+	int goalIndex = goal ? gridIndex(*goal) : -1;
+	static const int dirX[8] = { 1, -1, 0, 0, 1, 1, -1, -1 };
+	static const int dirZ[8] = { 0, 0, 1, -1, 1, -1, 1, -1 };
+	while (!open.empty()) {
+		auto [f, current] = open.top();
+		open.pop();
+		ivec2 p(current % size, current / size);
+		float g = gScore[current];
+		// outdated queue entry
+		if (f > g + (goal ? octile(p, *goal) : 0.0f) + 1e-4f) continue;
+		stats.expansions++;
+		if (current == goalIndex) {
+			if (path) {
+				path->clear();
+				for (int n = current; n >= 0; n = parent[n]) {
+					path->push_back(ivec2(n % size, n / size));
+				}
+				reverse(path->begin(), path->end());
+			}
+			return true;
+		}
+		for (int d = 0; d < 8; d++) {
+			int nx = p.x + dirX[d], nz = p.y + dirZ[d];
+			if (!rect.contains(nx, nz) || !grid->isWalkable(nx, nz)) continue;
+			bool diagonal = d >= 4;
+			if (diagonal && (!grid->isWalkable(p.x + dirX[d], p.y) || !grid->isWalkable(p.x, p.y + dirZ[d]))) continue;
+			int n = nz * size + nx;
+			float ng = g + (diagonal ? DIAGONAL_COST : 1.0f);
+			if (stamp[n] == currentStamp && gScore[n] <= ng) continue;
+			stamp[n] = currentStamp;
+			gScore[n] = ng;
+			parent[n] = current;
+			open.push({ ng + (goal ? octile(ivec2(nx, nz), *goal) : 0.0f), n });
+		}
+	}
+	return false;
+}
+
+float HierarchicalPathfinder::readCost(glm::ivec2 p) const
+{
+	int i = gridIndex(p);
+	return stamp[i] == currentStamp ? gScore[i] : numeric_limits<float>::max();
+}
+
+// A* on the abstract graph with start and goal temporarily connected to the entrances of their clusters
+bool HierarchicalPathfinder::findAbstractPath(glm::ivec2 start, glm::ivec2 goal, std::vector<glm::ivec2>& waypoints)
+{
+	int n = static_cast<int>(abstractNodes.size());
+	int startNode = n, goalNode = n + 1;
+	int startCluster = clusterOf(start), goalCluster = clusterOf(goal);
+	vector<Edge> startEdges;
+	search(start, nullptr, clusterRect(startCluster), nullptr);
+	for (int e : clusterNodes[startCluster]) {
+		float c = readCost(abstractNodes[e].pos);
+		if (c < numeric_limits<float>::max()) startEdges.push_back(Edge{ e, c });
+	}
+	// costs are symmetric: search from goal gives the costs of entrances to the goal
+	unordered_map<int, float> toGoal;
+	search(goal, nullptr, clusterRect(goalCluster), nullptr);
+	for (int e : clusterNodes[goalCluster]) {
+		float c = readCost(abstractNodes[e].pos);
+		if (c < numeric_limits<float>::max()) toGoal[e] = c;
+	}
+	if (startEdges.empty() || toGoal.empty()) return false;
+
+	auto position = [&](int node) {
+		return node == startNode ? start : node == goalNode ? goal : abstractNodes[node].pos;
+	};
+	vector<float> g(n + 2, numeric_limits<float>::max());
+	vector<int> from(n + 2, -1);
+	using Entry = pair<float, int>;
+	priority_queue<Entry, vector<Entry>, greater<Entry>> open;
+	g[startNode] = 0.0f;
+	open.push({ octile(start, goal), startNode });
+	while (!open.empty()) {
+		auto [f, current] = open.top();
+		open.pop();
+		if (f > g[current] + octile(position(current), goal) + 1e-4f) continue;
+		stats.expansions++;
+		if (current == goalNode) break;
+		auto relax = [&](int to, float cost) {
+			float ng = g[current] + cost;
+			if (ng >= g[to]) return;
+			g[to] = ng;
+			from[to] = current;
+			open.push({ ng + octile(position(to), goal), to });
+		};
+		if (current == startNode) {
+			for (auto& e : startEdges) relax(e.to, e.cost);
+			continue;
+		}
+		for (auto& e : abstractNodes[current].edges) relax(e.to, e.cost);
+		auto it = toGoal.find(current);
+		if (it != toGoal.end()) relax(goalNode, it->second);
+	}
+	if (from[goalNode] < 0) return false;
+	waypoints.clear();
+	for (int node = goalNode; node >= 0; node = from[node]) {
+		waypoints.push_back(position(node));
+	}
+	reverse(waypoints.begin(), waypoints.end());
+	return true;
+}
+
+bool HierarchicalPathfinder::findGridPath(glm::ivec2 start, glm::ivec2 goal, std::vector<glm::ivec2>& path, bool smooth)
+{
+	stats.requests++;
+	path.clear();
+	if (!grid->isWalkable(start.x, start.y) || !grid->isWalkable(goal.x, goal.y)) {
+		stats.failed++;
+		return false;
+	}
+	if (cacheVersion != grid->getVersion()) {
+		// walkability changed without rebuild(): entrances and cached paths may cross blocked nodes
+		rebuild();
+	}
+	uint64_t key = (static_cast<uint64_t>(gridIndex(start)) << 33) | (static_cast<uint64_t>(gridIndex(goal)) << 1) | (smooth ? 1 : 0);
+	auto cached = cache.find(key);
+	if (cached != cache.end()) {
+		stats.cacheHits++;
+		path = cached->second;
+		return true;
+	}
+
+	bool found = false;
+	if (start == goal) {
+		path.push_back(start);
+		found = true;
+	}
+	// same cluster: direct search inside it first
+	if (!found && clusterOf(start) == clusterOf(goal)) {
+		found = search(start, &goal, clusterRect(clusterOf(start)), &path);
+	}
+	vector<ivec2> waypoints;
+	if (!found && findAbstractPath(start, goal, waypoints)) {
+		// refine: every abstract step is either a border crossing or a path inside one cluster
+		path.push_back(start);
+		found = true;
+		vector<ivec2> segment;
+		for (size_t i = 0; i + 1 < waypoints.size() && found; i++) {
+			ivec2 a = waypoints[i], b = waypoints[i + 1];
+			if (a == b) continue;
+			if (clusterOf(a) != clusterOf(b)) {
+				path.push_back(b);
+				continue;
+			}
+			found = search(a, &b, clusterRect(clusterOf(a)), &segment);
+			path.insert(path.end(), segment.begin() + 1, segment.end());
+		}
+	}
+	if (!found) {
+		stats.failed++;
+		path.clear();
+		return false;
+	}
+	if (smooth) smoothPath(path);
+	if (cacheSize > 0) {
+		if (cache.size() >= cacheSize) {
+			cache.erase(cacheOrder.front());
+			cacheOrder.pop_front();
+		}
+		cache[key] = path;
+		cacheOrder.push_back(key);
+	}
+	return true;
+}
+
+bool HierarchicalPathfinder::findGridPathFlat(glm::ivec2 start, glm::ivec2 goal, std::vector<glm::ivec2>& path)
+{
+	path.clear();
+	if (!grid->isWalkable(start.x, start.y) || !grid->isWalkable(goal.x, goal.y)) return false;
+	int last = grid->getSize() - 1;
+	return search(start, &goal, Rect{ 0, 0, last, last }, &path);
+}
+
+void HierarchicalPathfinder::smoothPath(std::vector<glm::ivec2>& path) const
+{
+	if (path.size() <= 2) return;
+	vector<ivec2> result;
+	result.push_back(path[0]);
+	size_t anchor = 0;
+	while (anchor < path.size() - 1) {
+		size_t next = anchor + 1;
+		while (next + 1 < path.size() && grid->hasLineOfSight(path[anchor], path[next + 1])) next++;
+		result.push_back(path[next]);
+		anchor = next;
+	}
+	path = std::move(result);
+}
+
+float HierarchicalPathfinder::pathLength(const std::vector<glm::ivec2>& path)
+{
+	float len = 0.0f;
+	for (size_t i = 1; i < path.size(); i++) {
+		ivec2 d = path[i] - path[i - 1];
+		len += sqrt(static_cast<float>(d.x * d.x + d.y * d.y));
+	}
+	return len;
+}
+
+bool HierarchicalPathfinder::findPath(const glm::vec3& start, const glm::vec3& goal, std::vector<glm::vec3>& path)
+{
+	vector<ivec2> nodes;
+	path.clear();
+	if (!findGridPath(grid->toGrid(start.x, start.z), grid->toGrid(goal.x, goal.z), nodes)) return false;
+	for (auto& n : nodes) {
+		path.push_back(grid->toWorld(n));
+	}
+	return true;
+}
+
+// PathRequestQueue
+
+uint32_t PathRequestQueue::submit(const glm::vec3& start, const glm::vec3& goal)
+{
+	uint32_t id = nextId++;
+	Request& r = requests[id];
+	r.start = start;
+	r.goal = goal;
+	pending.push_back(id);
+	return id;
+}
+
+uint32_t PathRequestQueue::process(uint64_t expansionBudget, uint32_t maxRequests)
+{
+	uint64_t begin = pathfinder->getStats().expansions;
+	uint32_t done = 0;
+	while (!pending.empty() && done < maxRequests && pathfinder->getStats().expansions - begin < expansionBudget) {
+		uint32_t id = pending.front();
+		pending.pop_front();
+		auto it = requests.find(id);
+		if (it == requests.end()) continue; // released before processing
+		Request& r = it->second;
+		r.state = pathfinder->findPath(r.start, r.goal, r.path) ? PathRequestState::Done : PathRequestState::Failed;
+		done++;
+	}
+	return done;
+}
+
+PathRequestState PathRequestQueue::getState(uint32_t id) const
+{
+	auto it = requests.find(id);
+	if (it == requests.end()) {
+		Error("PathRequestQueue: unknown request");
+	}
+	return it->second.state;
+}
+
+const std::vector<glm::vec3>& PathRequestQueue::getPath(uint32_t id) const
+{
+	auto it = requests.find(id);
+	if (it == requests.end()) {
+		Error("PathRequestQueue: unknown request");
+	}
+	return it->second.path;
+}
@@ -0,0 +1,209 @@
+#pragma once
+
+// Walkability and route planning on the heightmap grid.
+// WalkabilityGrid has one node per heightmap sample. Nodes are blocked if the terrain is too steep towards any
+// direct neighbour, below water level or covered by an object footprint. Agents move in 8 directions, diagonal
+// moves are only allowed if both orthogonal neighbours are walkable (no corner cutting).
+// HierarchicalPathfinder plans with HPA*: the grid is split into square clusters, entrances are placed on walkable
+// border segments between neighbouring clusters and connected by precomputed costs inside each cluster.
+// A query runs A* on this small abstract graph, then refines each abstract step by A* inside one cluster
+// and smooths the result by string pulling (line of sight on the grid).
+// Found paths are cached until walkability changes, then the changed clusters are rebuilt. PathRequestQueue spreads many agent requests over
+// frames with a node expansion budget per tick, so route planning does not cause frame spikes.
+
+class World;
+
+struct WalkabilitySettings {
+	float maxSlope = glm::radians(35.0f); // steepest walkable terrain angle
+	float waterLevel = -std::numeric_limits<float>::max(); // nodes below are blocked
+};
+
+class WalkabilityGrid
+{
+public:
+	// heights of samples x samples grid covering [minXZ, maxXZ] in x and z, index z * samples + x.
+	// All nodes are walkable until deriveWalkability() is called
+	void init(std::vector<float> heights, int samples, float minXZ, float maxXZ);
+	// sample World::getHeightmapValue() on samples x samples grid over the whole world.
+	// World::prepareUltimateHeightmap() has to be called before
+	void initFromWorld(World& world, int samples);
+	// block nodes by slope and water level, removes footprints added before
+	void deriveWalkability(const WalkabilitySettings& settings);
+	// block nodes covered by box in xz, enlarged by margin (e.g. agent radius)
+	void addFootprint(const ObjectBounds& bounds, float margin = 0.0f);
+	void setWalkable(int x, int z, bool walkable);
+
+	int getSize() const {
+		return samples;
+	}
+	float getCellSize() const {
+		return cellSize;
+	}
+	bool isInside(int x, int z) const {
+		return x >= 0 && z >= 0 && x < samples && z < samples;
+	}
+	bool isWalkable(int x, int z) const {
+		return isInside(x, z) && walkable[static_cast<size_t>(z) * samples + x] != 0;
+	}
+	float getHeight(int x, int z) const {
+		return heights[static_cast<size_t>(z) * samples + x];
+	}
+	// nearest node of world pos, clamped to grid
+	glm::ivec2 toGrid(float x, float z) const;
+	glm::vec3 toWorld(glm::ivec2 node) const {
+		return glm::vec3(minXZ + node.x * cellSize, getHeight(node.x, node.y), minXZ + node.y * cellSize);
+	}
+	// true if all nodes touched by the straight line are walkable (each node covers a cell around it)
+	bool hasLineOfSight(glm::ivec2 a, glm::ivec2 b) const;
+	// incremented on every change of walkability
+	uint32_t getVersion() const {
+		return version;
+	}
+
+private:
+	std::vector<float> heights;
+	std::vector<uint8_t> walkable;
+	int samples = 0;
+	float minXZ = 0.0f;
+	float cellSize = 1.0f;
+	uint32_t version = 0;
+};
+
+struct PathfindingStats {
+	uint32_t requests = 0;
+	uint32_t cacheHits = 0;
+	uint32_t failed = 0;
+	uint64_t expansions = 0; // A* node expansions of all levels
+	void log() const;
+};
+
+class HierarchicalPathfinder
+{
+public:
+	static constexpr int DEFAULT_CLUSTER_SIZE = 16;
+	static constexpr size_t DEFAULT_CACHE_SIZE = 256;
+	// walkable border segments longer than this get two entrances (at both ends), shorter ones one in the middle
+	static constexpr int MAX_SINGLE_ENTRANCE_LENGTH = 6;
+
+	// grid has to stay alive. Builds the abstract graph
+	void init(const WalkabilityGrid* grid, int clusterSize = DEFAULT_CLUSTER_SIZE, size_t cacheSize = DEFAULT_CACHE_SIZE);
+	// rebuild abstract graph after walkability changed, clears the cache. Only clusters with changed
+	// walkability (or moved entrances) are searched again. Called by findGridPath() on a new grid version
+	void rebuild();
+
+	// smoothed path from start to goal in world coords, including both ends. False if there is no path
+	bool findPath(const glm::vec3& start, const glm::vec3& goal, std::vector<glm::vec3>& path);
+	// path of grid nodes. Without smoothing consecutive nodes are neighbours
+	bool findGridPath(glm::ivec2 start, glm::ivec2 goal, std::vector<glm::ivec2>& path, bool smooth = true);
+	// plain A* over the whole grid, optimal. Reference for tests
+	bool findGridPathFlat(glm::ivec2 start, glm::ivec2 goal, std::vector<glm::ivec2>& path);
+	// string pulling: drop nodes that can be skipped by line of sight
+	void smoothPath(std::vector<glm::ivec2>& path) const;
+	// length in grid units
+	static float pathLength(const std::vector<glm::ivec2>& path);
+
+	size_t getAbstractNodeCount() const {
+		return abstractNodes.size();
+	}
+	size_t getAbstractEdgeCount() const;
+	size_t getCachedPathCount() const {
+		return cache.size();
+	}
+	// clusters whose intra cluster edges were kept by the last rebuild()
+	uint32_t getReusedClusterCount() const {
+		return reusedClusters;
+	}
+	const PathfindingStats& getStats() const {
+		return stats;
+	}
+	void resetStats() {
+		stats = PathfindingStats();
+	}
+
+private:
+	struct Edge {
+		int to;
+		float cost;
+	};
+	struct AbstractNode {
+		glm::ivec2 pos;
+		int cluster;
+		std::vector<Edge> edges;
+	};
+	// inclusive node rect a search is restricted to
+	struct Rect {
+		int x0, z0, x1, z1;
+		bool contains(int x, int z) const {
+			return x >= x0 && x <= x1 && z >= z0 && z <= z1;
+		}
+	};
+	int clusterOf(glm::ivec2 p) const {
+		return (p.y / clusterSize) * clustersPerEdge + p.x / clusterSize;
+	}
+	Rect clusterRect(int cluster) const;
+	int gridIndex(glm::ivec2 p) const {
+		return p.y * grid->getSize() + p.x;
+	}
+	int addAbstractNode(glm::ivec2 p);
+	void addEntrances(int clusterA, int clusterB, bool horizontal);
+	// A* (or Dijkstra without goal) on the grid inside rect. Leaves g values for readCost()
+	bool search(glm::ivec2 start, const glm::ivec2* goal, const Rect& rect, std::vector<glm::ivec2>* path);
+	// cost of node found by the last search(), infinity if not reached
+	float readCost(glm::ivec2 p) const;
+	bool findAbstractPath(glm::ivec2 start, glm::ivec2 goal, std::vector<glm::ivec2>& waypoints);
+
+	const WalkabilityGrid* grid = nullptr;
+	int clusterSize = DEFAULT_CLUSTER_SIZE;
+	int clustersPerEdge = 0;
+	std::vector<AbstractNode> abstractNodes;
+	std::vector<std::vector<int>> clusterNodes; // abstract nodes per cluster
+	std::vector<int> abstractIndex; // per grid node, -1 if no abstract node
+	std::vector<uint8_t> builtWalkable; // walkability the abstract graph was built for
+	uint32_t reusedClusters = 0;
+	// grid search state, reused: entries are valid if stamp matches
+	std::vector<float> gScore;
+	std::vector<int> parent;
+	std::vector<uint32_t> stamp;
+	uint32_t currentStamp = 0;
+	// path cache, evicted in insertion order
+	size_t cacheSize = DEFAULT_CACHE_SIZE;
+	uint32_t cacheVersion = 0;
+	std::unordered_map<uint64_t, std::vector<glm::ivec2>> cache;
+	std::deque<uint64_t> cacheOrder;
+	PathfindingStats stats;
+};
+
+enum class PathRequestState { Pending, Done, Failed };
+
+class PathRequestQueue
+{
+public:
+	void init(HierarchicalPathfinder* pathfinder) {
+		this->pathfinder = pathfinder;
+	}
+	// queue request, returns id for getState() and getPath()
+	uint32_t submit(const glm::vec3& start, const glm::vec3& goal);
+	// process pending requests in submit order until expansionBudget A* expansions are used or maxRequests are done.
+	// A started request is always finished, so one request may go over the budget. Returns number of finished requests
+	uint32_t process(uint64_t expansionBudget, uint32_t maxRequests = UINT32_MAX);
+	PathRequestState getState(uint32_t id) const;
+	const std::vector<glm::vec3>& getPath(uint32_t id) const;
+	// forget finished request
+	void release(uint32_t id) {
+		requests.erase(id);
+	}
+	size_t getPendingCount() const {
+		return pending.size();
+	}
+
+private:
+	struct Request {
+		glm::vec3 start, goal;
+		PathRequestState state = PathRequestState::Pending;
+		std::vector<glm::vec3> path;
+	};
+	HierarchicalPathfinder* pathfinder = nullptr;
+	std::unordered_map<uint32_t, Request> requests;
+	std::deque<uint32_t> pending;
+	uint32_t nextId = 0;
+};
@@ -0,0 +1,266 @@
+#include "mainheader.h"
+
+using namespace std;
+
+PipelineCacheKey PipelineCacheKey::fromProperties(const VkPhysicalDeviceProperties& properties)
+{
+	PipelineCacheKey key;
+	key.vendorID = properties.vendorID;
+	key.deviceID = properties.deviceID;
+	key.driverVersion = properties.driverVersion;
+	memcpy(key.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+	return key;
+}
+
+void PipelineCacheStats::log() const
+{
+	Log("Pipeline cache: loaded " << loadedBytes << " bytes, saved " << savedBytes << " bytes, " << pipelines << " pipelines, "
+		<< deferredPipelines << " created in parallel in " << deferredMilliseconds << " ms" << endl);
+}
+
+uint64_t PipelineCache::hashData(const byte* data, size_t size)
+{
+	// FNV-1a
+	uint64_t h = 0xcbf29ce484222325ULL;
+	for (size_t i = 0; i < size; i++) {
+		h ^= static_cast<uint64_t>(data[i]);
+		h *= 0x100000001b3ULL;
+	}
+	return h;
+}
+
+vector<byte> PipelineCache::buildFile(const PipelineCacheKey& key, const byte* data, size_t size)
+{
+	FileHeader header{};
+	header.magic = FILE_MAGIC;
+	header.fileVersion = FILE_VERSION;
+	header.vendorID = key.vendorID;
+	header.deviceID = key.deviceID;
+	header.driverVersion = key.driverVersion;
+	memcpy(header.pipelineCacheUUID, key.pipelineCacheUUID, VK_UUID_SIZE);
+	header.dataSize = size;
+	header.dataHash = hashData(data, size);
+	vector<byte> file(sizeof(FileHeader) + size);
+	memcpy(file.data(), &header, sizeof(FileHeader));
+	if (size > 0) memcpy(file.data() + sizeof(FileHeader), data, size);
+	return file;
+}
+
+size_t PipelineCache::validateFile(const vector<byte>& file, const PipelineCacheKey& key, size_t& size)
+{
+	size = 0;
+	if (file.size() < sizeof(FileHeader)) return 0;
+	FileHeader header;
+	memcpy(&header, file.data(), sizeof(FileHeader));
+	if (header.magic != FILE_MAGIC || header.fileVersion != FILE_VERSION) return 0;
+	// driver version is not part of the Vulkan header, some drivers keep the cache UUID across updates
+	if (header.vendorID != key.vendorID || header.deviceID != key.deviceID || header.driverVersion != key.driverVersion) return 0;
+	if (memcmp(header.pipelineCacheUUID, key.pipelineCacheUUID, VK_UUID_SIZE) != 0) return 0;
+	if (header.dataSize != file.size() - sizeof(FileHeader)) return 0;
+	const byte* data = file.data() + sizeof(FileHeader);
+	if (header.dataHash != hashData(data, header.dataSize)) return 0;
+	// Vulkan header at start of cache data must match, too
+	VkPipelineCacheHeaderVersionOne vkHeader;
+	if (header.dataSize < sizeof(vkHeader)) return 0;
+	memcpy(&vkHeader, data, sizeof(vkHeader));
+	if (vkHeader.headerSize < sizeof(vkHeader) || vkHeader.headerSize > header.dataSize) return 0;
+	if (vkHeader.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE) return 0;
+	if (vkHeader.vendorID != key.vendorID || vkHeader.deviceID != key.deviceID) return 0;
+	if (memcmp(vkHeader.pipelineCacheUUID, key.pipelineCacheUUID, VK_UUID_SIZE) != 0) return 0;
+	size = header.dataSize;
+	return sizeof(FileHeader);
+}
+
+void PipelineCache::init(VkDevice device, const VkPhysicalDeviceProperties& properties, filesystem::path file)
+{
+	this->device = device;
+	key = PipelineCacheKey::fromProperties(properties);
+	filePath = file;
+	vector<byte> content;
+	ifstream in(filePath, ios::in | ios::binary);
+	if (in) {
+		in.seekg(0, ios::end);
+		content.resize(static_cast<size_t>(in.tellg()));
+		in.seekg(0);
+		in.read(reinterpret_cast<char*>(content.data()), content.size());
+		if (!in) content.clear();
+	}
+	size_t size = 0;
+	size_t offset = validateFile(content, key, size);
+	if (offset == 0 && !content.empty()) {
+		Log("WARNING: pipeline cache file not valid for this device or driver, starting with empty cache: " << filePath << endl);
+	}
+	VkPipelineCacheCreateInfo createInfo{};
+	createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	createInfo.initialDataSize = size;
+	createInfo.pInitialData = offset > 0 ? content.data() + offset : nullptr;
+	if (vkCreatePipelineCache(device, &createInfo, nullptr, &cache) != VK_SUCCESS) {
+		Error("failed to create pipeline cache!");
+	}
+	stats.loadedBytes = size;
+	Log("Pipeline cache " << filePath << ": " << (size > 0 ? "loaded " + to_string(size) + " bytes" : string("empty")) << endl);
+}
+
+void PipelineCache::destroy()
+{
+	if (cache == VK_NULL_HANDLE) return;
+	size_t size = 0;
+	vector<byte> data;
+	if (vkGetPipelineCacheData(device, cache, &size, nullptr) == VK_SUCCESS && size > 0) {
+		data.resize(size);
+		if (vkGetPipelineCacheData(device, cache, &size, data.data()) != VK_SUCCESS) {
+			size = 0;
+		}
+	}
+	if (size > 0) {
+		// a missing cache only costs startup time, so write errors are not fatal
+		vector<byte> file = buildFile(key, data.data(), size);
+		ofstream out(filePath, ios::out | ios::binary | ios::trunc);
+		out.write(reinterpret_cast<const char*>(file.data()), file.size());
+		if (out) {
+			stats.savedBytes = size;
+		} else {
+			Log("WARNING: could not write pipeline cache file " << filePath << endl);
+		}
+	}
+	vkDestroyPipelineCache(device, cache, nullptr);
+	cache = VK_NULL_HANDLE;
+	stats.log();
+}
+
+void PipelineCache::createGraphicsPipeline(const VkGraphicsPipelineCreateInfo& info, VkPipeline* pipeline)
+{
+	// no external synchronization needed for the cache, drivers lock internally
+	if (vkCreateGraphicsPipelines(device, cache, 1, &info, nullptr, pipeline) != VK_SUCCESS) {
+		Error("failed to create graphics pipeline!");
+	}
+	unique_lock<mutex> lock(statsMutex);
+	stats.pipelines++;
+}
+
+void PipelineCache::createGraphicsPipelineDeferred(const VkGraphicsPipelineCreateInfo& info, VkPipeline* pipeline)
+{
+	if (!deferring || !canDefer(info)) {
+		createGraphicsPipeline(info, pipeline);
+		return;
+	}
+	deferred.push_back(copyCreateInfo(info, pipeline));
+}
+
+void PipelineCache::beginDeferred()
+{
+	if (deferring) {
+		Error("PipelineCache: deferred pipeline batch already open");
+	}
+	deferring = true;
+}
+
+void PipelineCache::endDeferred(ThreadGroup* threads)
+{
+	if (!deferring) {
+		Error("PipelineCache: no deferred pipeline batch open");
+	}
+	deferring = false;
+	auto start = chrono::high_resolution_clock::now();
+	if (threads != nullptr && deferred.size() > 1) {
+		vector<future<void>> futures;
+		futures.reserve(deferred.size());
+		for (auto& d : deferred) {
+			DeferredPipeline* p = d.get();
+			futures.push_back(threads->asyncSubmit([this, p] { createGraphicsPipeline(p->info, p->pipeline); }));
+		}
+		for (auto& f : futures) {
+			f.get();
+		}
+	} else {
+		for (auto& d : deferred) {
+			createGraphicsPipeline(d->info, d->pipeline);
+		}
+	}
+	auto end = chrono::high_resolution_clock::now();
+	stats.deferredPipelines += static_cast<uint32_t>(deferred.size());
+	stats.deferredMilliseconds += chrono::duration<double, milli>(end - start).count();
+	Log("Created " << deferred.size() << " pipelines in " << chrono::duration<double, milli>(end - start).count() << " ms" << endl);
+	deferred.clear();
+}
+
+bool PipelineCache::canDefer(const VkGraphicsPipelineCreateInfo& info)
+{
+	if (info.pNext != nullptr || info.pTessellationState != nullptr) return false;
+	for (uint32_t i = 0; i < info.stageCount; i++) {
+		if (info.pStages[i].pNext != nullptr || info.pStages[i].pSpecializationInfo != nullptr) return false;
+	}
+	if (info.pVertexInputState && info.pVertexInputState->pNext) return false;
+	if (info.pInputAssemblyState && info.pInputAssemblyState->pNext) return false;
+	if (info.pViewportState && info.pViewportState->pNext) return false;
+	if (info.pRasterizationState && info.pRasterizationState->pNext) return false;
+	if (info.pMultisampleState && (info.pMultisampleState->pNext || info.pMultisampleState->pSampleMask)) return false;
+	if (info.pDepthStencilState && info.pDepthStencilState->pNext) return false;
+	if (info.pColorBlendState && info.pColorBlendState->pNext) return false;
+	if (info.pDynamicState && info.pDynamicState->pNext) return false;
+	return true;
+}
+
+unique_ptr<PipelineCache::DeferredPipeline> PipelineCache::copyCreateInfo(const VkGraphicsPipelineCreateInfo& info, VkPipeline* pipeline)
+{
+	auto d = make_unique<DeferredPipeline>();
+	d->info = info;
+	d->pipeline = pipeline;
+	d->stages.assign(info.pStages, info.pStages + info.stageCount);
+	d->entryPoints.reserve(info.stageCount);
+	for (auto& stage : d->stages) {
+		d->entryPoints.push_back(stage.pName);
+		stage.pName = d->entryPoints.back().c_str();
+	}
+	d->info.pStages = d->stages.data();
+	if (info.pVertexInputState) {
+		auto& s = *info.pVertexInputState;
+		d->vertexInput = s;
+		d->bindings.assign(s.pVertexBindingDescriptions, s.pVertexBindingDescriptions + s.vertexBindingDescriptionCount);
+		d->attributes.assign(s.pVertexAttributeDescriptions, s.pVertexAttributeDescriptions + s.vertexAttributeDescriptionCount);
+		d->vertexInput.pVertexBindingDescriptions = d->bindings.data();
+		d->vertexInput.pVertexAttributeDescriptions = d->attributes.data();
+		d->info.pVertexInputState = &d->vertexInput;
+	}
+	if (info.pInputAssemblyState) {
+		d->inputAssembly = *info.pInputAssemblyState;
+		d->info.pInputAssemblyState = &d->inputAssembly;
+	}
+	if (info.pViewportState) {
+		auto& s = *info.pViewportState;
+		d->viewportState = s;
+		// viewports and scissors may be null for dynamic viewport state
+		if (s.pViewports) d->viewports.assign(s.pViewports, s.pViewports + s.viewportCount);
+		if (s.pScissors) d->scissors.assign(s.pScissors, s.pScissors + s.scissorCount);
+		d->viewportState.pViewports = s.pViewports ? d->viewports.data() : nullptr;
+		d->viewportState.pScissors = s.pScissors ? d->scissors.data() : nullptr;
+		d->info.pViewportState = &d->viewportState;
+	}
+	if (info.pRasterizationState) {
+		d->rasterization = *info.pRasterizationState;
+		d->info.pRasterizationState = &d->rasterization;
+	}
+	if (info.pMultisampleState) {
+		d->multisample = *info.pMultisampleState;
+		d->info.pMultisampleState = &d->multisample;
+	}
+	if (info.pDepthStencilState) {
+		d->depthStencil = *info.pDepthStencilState;
+		d->info.pDepthStencilState = &d->depthStencil;
+	}
+	if (info.pColorBlendState) {
+		auto& s = *info.pColorBlendState;
+		d->colorBlend = s;
+		d->blendAttachments.assign(s.pAttachments, s.pAttachments + s.attachmentCount);
+		d->colorBlend.pAttachments = d->blendAttachments.data();
+		d->info.pColorBlendState = &d->colorBlend;
+	}
+	if (info.pDynamicState) {
+		auto& s = *info.pDynamicState;
+		d->dynamicState = s;
+		d->dynamicStates.assign(s.pDynamicStates, s.pDynamicStates + s.dynamicStateCount);
+		d->dynamicState.pDynamicStates = d->dynamicStates.data();
+		d->info.pDynamicState = &d->dynamicState;
+	}
+	return d;
+}
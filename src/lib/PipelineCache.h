@@ -0,0 +1,108 @@
+#pragma once
+
+// Persistent Vulkan pipeline cache: cache data is loaded after device creation and written back on shutdown,
+// so pipelines compiled in a previous run are not compiled again by the driver.
+// One file per GPU is stored next to the shader folder. Files written for another device or driver version
+// are detected by header validation and ignored.
+// Pipelines created while a deferred batch is open are compiled in parallel when the batch is ended
+// (used by Shaders::initActiveShaders()).
+
+class ThreadGroup;
+
+// device and driver a cache was created with
+struct PipelineCacheKey {
+	uint32_t vendorID = 0;
+	uint32_t deviceID = 0;
+	uint32_t driverVersion = 0;
+	uint8_t pipelineCacheUUID[VK_UUID_SIZE] = {};
+	static PipelineCacheKey fromProperties(const VkPhysicalDeviceProperties& properties);
+};
+
+struct PipelineCacheStats {
+	size_t loadedBytes = 0; // 0 if no valid cache file was found
+	size_t savedBytes = 0;
+	uint32_t pipelines = 0;
+	uint32_t deferredPipelines = 0; // created in parallel
+	double deferredMilliseconds = 0.0; // wall clock time of all deferred batches
+	void log() const;
+};
+
+class PipelineCache
+{
+public:
+	static constexpr uint32_t FILE_MAGIC = 0x43505053; // 'SPPC'
+	// increment if layout of FileHeader changes
+	static constexpr uint32_t FILE_VERSION = 1;
+
+	// create cache with data from file. Missing or invalid file starts with an empty cache
+	void init(VkDevice device, const VkPhysicalDeviceProperties& properties, std::filesystem::path file);
+	// write cache data to file and destroy cache. Has to be called before device is destroyed
+	void destroy();
+	VkPipelineCache get() const {
+		return cache;
+	}
+
+	// create pipeline immediately
+	void createGraphicsPipeline(const VkGraphicsPipelineCreateInfo& info, VkPipeline* pipeline);
+	// create pipeline in endDeferred() if a batch is open, immediately otherwise.
+	// If deferred, all pointers in info are copied and *pipeline is not valid before endDeferred()
+	void createGraphicsPipelineDeferred(const VkGraphicsPipelineCreateInfo& info, VkPipeline* pipeline);
+	void beginDeferred();
+	// create all deferred pipelines, in parallel if threads are given
+	void endDeferred(ThreadGroup* threads);
+	const PipelineCacheStats& getStats() const {
+		return stats;
+	}
+
+	// cache file: FileHeader followed by data of vkGetPipelineCacheData()
+	static std::vector<std::byte> buildFile(const PipelineCacheKey& key, const std::byte* data, size_t size);
+	// check file header and the Vulkan header of the contained cache data against key.
+	// returns offset of cache data in file and sets size, returns 0 if file cannot be used
+	static size_t validateFile(const std::vector<std::byte>& file, const PipelineCacheKey& key, size_t& size);
+
+private:
+	struct FileHeader {
+		uint32_t magic;
+		uint32_t fileVersion;
+		uint32_t vendorID;
+		uint32_t deviceID;
+		uint32_t driverVersion;
+		uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+		uint64_t dataSize;
+		uint64_t dataHash;
+	};
+	static uint64_t hashData(const std::byte* data, size_t size);
+	// create info with copies of all referenced state, pointers refer to the members
+	struct DeferredPipeline {
+		VkGraphicsPipelineCreateInfo info{};
+		VkPipeline* pipeline = nullptr;
+		std::vector<VkPipelineShaderStageCreateInfo> stages;
+		std::vector<std::string> entryPoints;
+		VkPipelineVertexInputStateCreateInfo vertexInput{};
+		std::vector<VkVertexInputBindingDescription> bindings;
+		std::vector<VkVertexInputAttributeDescription> attributes;
+		VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
+		VkPipelineViewportStateCreateInfo viewportState{};
+		std::vector<VkViewport> viewports;
+		std::vector<VkRect2D> scissors;
+		VkPipelineRasterizationStateCreateInfo rasterization{};
+		VkPipelineMultisampleStateCreateInfo multisample{};
+		VkPipelineDepthStencilStateCreateInfo depthStencil{};
+		VkPipelineColorBlendStateCreateInfo colorBlend{};
+		std::vector<VkPipelineColorBlendAttachmentState> blendAttachments;
+		VkPipelineDynamicStateCreateInfo dynamicState{};
+		std::vector<VkDynamicState> dynamicStates;
+	};
+	// only plain create infos without extension chains can be copied
+	static bool canDefer(const VkGraphicsPipelineCreateInfo& info);
+	static std::unique_ptr<DeferredPipeline> copyCreateInfo(const VkGraphicsPipelineCreateInfo& info, VkPipeline* pipeline);
+
+	VkDevice device = nullptr;
+	VkPipelineCache cache = VK_NULL_HANDLE;
+	PipelineCacheKey key;
+	std::filesystem::path filePath;
+	bool deferring = false;
+	std::vector<std::unique_ptr<DeferredPipeline>> deferred;
+	std::mutex statsMutex;
+	PipelineCacheStats stats;
+};
@@ -559,6 +559,7 @@ void Presentation::presentImage(FrameResources* fr, WindowInfo* winfo)
         imageBlitRegion.dstOffsets[0] = blitPosDst;
         blitSizeDst.x = winfo->width;
         imageBlitRegion.dstOffsets[1] = blitSizeDst;
+        imageBlitRegion.srcSubresource.baseArrayLayer = fr->colorImage2.arrayLayer;
         vkCmdBlitImage(
             winfo->commandBufferPresentBack,
             fr->colorImage2.fba.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
@@ -568,9 +569,10 @@ void Presentation::presentImage(FrameResources* fr, WindowInfo* winfo)
         );
     }
 
-    if (engine->shaders.uiShader.enabled) {
+    if (engine->shaders.uiShader.enabled && engine->ui.isVisible()) {
         // NEW
         // acquireCompleteInfo.semaphore = fr->imageAvailableSemaphore;
+        ThemedTimer::getInstance()->start(TIMER_PART_UI);
         engine->ui.update();
         DirectImage::toLayout(VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_READ_BIT, winfo->commandBufferPresentBack, &dstImage);
         if (dstImage.framebuffer == nullptr) {
@@ -587,6 +589,7 @@ void Presentation::presentImage(FrameResources* fr, WindowInfo* winfo)
         vkCmdBeginRenderPass(winfo->commandBufferPresentBack, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
         ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), winfo->commandBufferPresentBack);
         vkCmdEndRenderPass(winfo->commandBufferPresentBack);
+        ThemedTimer::getInstance()->stop(TIMER_PART_UI);
     }
     DirectImage::toLayout(VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, VK_PIPELINE_STAGE_2_BOTTOM_OF_PIPE_BIT, VK_ACCESS_2_MEMORY_READ_BIT, winfo->commandBufferPresentBack, &dstImage);
 
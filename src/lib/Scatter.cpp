@@ -0,0 +1,122 @@
+#include "mainheader.h"
+
+using namespace std;
+using namespace glm;
+
+void PoissonScatter::generate(const ScatterSettings& settings, const std::vector<ScatterLayer>& layers, std::vector<ScatterPoint>& points, ThreadGroup* threads)
+{
+	points.clear();
+	if (layers.empty()) return;
+	if (settings.maxXZ <= settings.minXZ) {
+		Error("PoissonScatter: invalid area");
+	}
+	float maxRadius = 0.0f;
+	for (auto& l : layers) {
+		if (l.radius <= 0.0f) Error("PoissonScatter: layer radius has to be positive");
+		maxRadius = std::max(maxRadius, l.radius);
+	}
+	minXZ = settings.minXZ;
+	maxXZ = settings.maxXZ;
+	float size = maxXZ - minXZ;
+	// tiles not smaller than the largest radius: conflicts are only possible with direct neighbours
+	tilesPerEdge = std::max(1, static_cast<int>(size / maxRadius));
+	tileSize = size / tilesPerEdge;
+	size_t tileCount = static_cast<size_t>(tilesPerEdge) * tilesPerEdge;
+	tilePoints.assign(tileCount, vector<ScatterPoint>());
+	tileRadius.assign(tileCount, vector<float>());
+	tileLayerStart.assign(tileCount, 0);
+	tileThinned.assign(tileCount, vector<vec2>());
+
+	for (uint32_t layerIndex = 0; layerIndex < layers.size(); layerIndex++) {
+		const ScatterLayer& layer = layers[layerIndex];
+		for (size_t t = 0; t < tileCount; t++) {
+			tileLayerStart[t] = tilePoints[t].size();
+			tileThinned[t].clear();
+		}
+		for (int phase = 0; phase < 4; phase++) {
+			int px = phase & 1, pz = phase >> 1;
+			vector<future<void>> futures;
+			for (int tz = pz; tz < tilesPerEdge; tz += 2) {
+				for (int tx = px; tx < tilesPerEdge; tx += 2) {
+					if (threads == nullptr) {
+						scatterTile(settings, layer, layerIndex, tx, tz);
+					} else {
+						futures.push_back(threads->asyncSubmit([this, &settings, &layer, layerIndex, tx, tz] {
+							scatterTile(settings, layer, layerIndex, tx, tz);
+						}));
+					}
+				}
+			}
+			for (auto& f : futures) {
+				f.get();
+			}
+		}
+		// collect in tile order, independent of task completion order
+		for (size_t t = 0; t < tileCount; t++) {
+			points.insert(points.end(), tilePoints[t].begin() + tileLayerStart[t], tilePoints[t].end());
+		}
+	}
+}
+
+bool PoissonScatter::isFree(const glm::vec2& p, float radius, int tx, int tz) const
+{
+	for (int z = std::max(0, tz - 1); z <= std::min(tilesPerEdge - 1, tz + 1); z++) {
+		for (int x = std::max(0, tx - 1); x <= std::min(tilesPerEdge - 1, tx + 1); x++) {
+			size_t t = static_cast<size_t>(z) * tilesPerEdge + x;
+			const auto& pts = tilePoints[t];
+			const auto& radii = tileRadius[t];
+			for (size_t i = 0; i < pts.size(); i++) {
+				float r = std::max(radius, radii[i]);
+				float dx = pts[i].pos.x - p.x, dz = pts[i].pos.z - p.y;
+				if (dx * dx + dz * dz < r * r) return false;
+			}
+			for (auto& q : tileThinned[t]) {
+				float dx = q.x - p.x, dz = q.y - p.y;
+				if (dx * dx + dz * dz < radius * radius) return false;
+			}
+		}
+	}
+	return true;
+}
+
+float PoissonScatter::slopeAt(const ScatterSettings& settings, float x, float z) const
+{
+	if (!settings.height) return 0.0f;
+	float d = settings.slopeSampleDistance;
+	float x0 = std::max(minXZ, x - d), x1 = std::min(maxXZ, x + d);
+	float z0 = std::max(minXZ, z - d), z1 = std::min(maxXZ, z + d);
+	float dhdx = (heightAt(settings, x1, z) - heightAt(settings, x0, z)) / (x1 - x0);
+	float dhdz = (heightAt(settings, x, z1) - heightAt(settings, x, z0)) / (z1 - z0);
+	return atan(sqrt(dhdx * dhdx + dhdz * dhdz));
+}
+
+void PoissonScatter::scatterTile(const ScatterSettings& settings, const ScatterLayer& layer, uint32_t layerIndex, int tx, int tz)
+{
+	size_t t = static_cast<size_t>(tz) * tilesPerEdge + tx;
+	ScatterRandom rnd(ScatterRandom::hash(ScatterRandom::hash(settings.seed, layerIndex), t));
+	float x0 = minXZ + tx * tileSize, z0 = minXZ + tz * tileSize;
+	int candidates = static_cast<int>(ceil(settings.candidatesPerArea * tileSize * tileSize / (layer.radius * layer.radius)));
+	bool masked = layer.maxSlope < radians(90.0f) || layer.minHeight > -numeric_limits<float>::max() || layer.maxHeight < numeric_limits<float>::max();
+	for (int c = 0; c < candidates; c++) {
+		// draw all random numbers of a candidate, so rejections do not shift later candidates
+		vec2 p(x0 + rnd.nextFloat() * tileSize, z0 + rnd.nextFloat() * tileSize);
+		float keep = rnd.nextFloat();
+		uint32_t bits = static_cast<uint32_t>(rnd.next());
+		// outermost tiles may reach max due to rounding
+		p.x = std::min(p.x, maxXZ);
+		p.y = std::min(p.y, maxXZ);
+		if (!isFree(p, layer.radius, tx, tz)) continue;
+		if (layer.density && keep >= layer.density(p.x, p.y)) {
+			// thinned out, but still blocks its area: density scales the point count instead of just filling more slowly
+			tileThinned[t].push_back(p);
+			continue;
+		}
+		float h = heightAt(settings, p.x, p.y);
+		if (masked) {
+			if (h < layer.minHeight || h > layer.maxHeight) continue;
+			if (slopeAt(settings, p.x, p.y) > layer.maxSlope) continue;
+		}
+		tilePoints[t].push_back(ScatterPoint{ vec3(p.x, h, p.y), layerIndex, layer.userData, bits });
+		tileRadius[t].push_back(layer.radius);
+	}
+}
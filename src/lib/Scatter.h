@@ -0,0 +1,96 @@
+#pragma once
+
+// Seeded Poisson disk scattering of objects on the terrain.
+// Points are placed by dart throwing in square tiles. Tiles are at least as large as the biggest radius and are
+// processed in 4 phases (2x2 pattern): tiles of one phase are never neighbours, so they cannot place conflicting
+// points and run in parallel. Every tile has its own random generator seeded from seed, layer and tile coords,
+// and only sees points of finished phases, so the result is bit identical for any number of threads.
+// Layers (e.g. one per mesh) are scattered one after the other, points of earlier layers block later ones:
+// two points are at least the larger of their radii apart.
+// Candidates are dropped by height and slope masks (from the height function, e.g. the ultimate heightmap)
+// and kept with the probability given by the density map. Points dropped by the density map still keep other points
+// of their layer away, so the density map thins out the saturated point set proportionally.
+
+// deterministic random numbers, same sequence on all platforms (std distributions are implementation defined)
+class ScatterRandom {
+public:
+	explicit ScatterRandom(uint64_t seed) : state(seed) {}
+	// splitmix64
+	uint64_t next() {
+		uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+		return z ^ (z >> 31);
+	}
+	// [0, 1)
+	float nextFloat() {
+		return static_cast<float>(next() >> 40) * (1.0f / 16777216.0f);
+	}
+	float nextFloat(float a, float b) {
+		return a + nextFloat() * (b - a);
+	}
+	static uint64_t hash(uint64_t a, uint64_t b) {
+		ScatterRandom r(a * 0x100000001B3ull ^ b);
+		return r.next();
+	}
+private:
+	uint64_t state;
+};
+
+struct ScatterLayer {
+	float radius = 1.0f; // min distance to other points
+	float minHeight = -std::numeric_limits<float>::max();
+	float maxHeight = std::numeric_limits<float>::max();
+	float maxSlope = glm::radians(90.0f); // terrain slope angle
+	std::function<float(float x, float z)> density = nullptr; // 0..1 at world pos, nullptr for 1 everywhere
+	uint32_t userData = 0; // copied to points, e.g. mesh id
+};
+
+struct ScatterPoint {
+	glm::vec3 pos; // y from height function
+	uint32_t layer;
+	uint32_t userData;
+	uint32_t random; // per point random bits, for deterministic scale, rotation etc.
+};
+
+struct ScatterSettings {
+	uint64_t seed = 1;
+	float minXZ = -512.0f, maxXZ = 512.0f; // scattered square
+	// height at world pos, nullptr for flat ground at 0. Called from worker threads
+	std::function<float(float x, float z)> height = nullptr;
+	float slopeSampleDistance = 1.0f; // for slope from height function
+	// dart throwing candidates per radius^2 of area, more candidates fill gaps better
+	float candidatesPerArea = 8.0f;
+};
+
+class PoissonScatter
+{
+public:
+	// scatter all layers, points are ordered by layer, tile and placement
+	void generate(const ScatterSettings& settings, const std::vector<ScatterLayer>& layers, std::vector<ScatterPoint>& points, ThreadGroup* threads = nullptr);
+
+	int getTilesPerEdge() const {
+		return tilesPerEdge;
+	}
+	float getTileSize() const {
+		return tileSize;
+	}
+
+private:
+	void scatterTile(const ScatterSettings& settings, const ScatterLayer& layer, uint32_t layerIndex, int tx, int tz);
+	bool isFree(const glm::vec2& p, float radius, int tx, int tz) const;
+	float slopeAt(const ScatterSettings& settings, float x, float z) const;
+	float heightAt(const ScatterSettings& settings, float x, float z) const {
+		return settings.height ? settings.height(x, z) : 0.0f;
+	}
+
+	int tilesPerEdge = 0;
+	float tileSize = 0.0f;
+	float minXZ = 0.0f;
+	float maxXZ = 0.0f;
+	// points per tile of all layers so far, only written by the task of the tile
+	std::vector<std::vector<ScatterPoint>> tilePoints;
+	std::vector<std::vector<float>> tileRadius; // radius per point in tilePoints
+	std::vector<size_t> tileLayerStart; // first point of current layer in tilePoints
+	std::vector<std::vector<glm::vec2>> tileThinned; // points of current layer dropped by density map
+};
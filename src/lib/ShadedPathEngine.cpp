@@ -25,6 +25,9 @@ void ShadedPathEngine::initGlobal(string appname) {
     ThemedTimer::getInstance()->create(TIMER_PART_OPENXR, 1000);
     ThemedTimer::getInstance()->create(TIMER_PART_BUFFER_COPY, 10);
     ThemedTimer::getInstance()->create(TIMER_PART_PREPARE_FRAME, 1000);
+    ThemedTimer::getInstance()->create(TIMER_PART_RECORD_COMMANDS, 1000);
+    ThemedTimer::getInstance()->create(TIMER_PART_RECORD_COMMANDS_MULTIVIEW, 1000);
+    ThemedTimer::getInstance()->create(TIMER_PART_UI, 1000);
     mainThreadInfo.name = "Main Thread";
     mainThreadInfo.category = ThreadCategory::MainThread;
     mainThreadInfo.id = this_thread::get_id();
@@ -49,10 +52,15 @@ void ShadedPathEngine::initGlobal(string appname) {
     } else {
         numWorkerThreads = 1;
     }
+    if (vrMode && framesInFlight != 2) {
+        Log("VR mode only supports 2 frames in flight, ignoring setFramesInFlight(" << framesInFlight << ")" << endl);
+        framesInFlight = 2;
+    }
+    Log("Frames in flight: " << framesInFlight << endl);
     vr.init();
     globalRendering.init();
     // init frame infos index:
-    for (int i = 0; i < 2; i++) {
+    for (int i = 0; i < framesInFlight; i++) {
         frameInfos[i].engine = this;
         frameInfos[i].frameIndex = i;
     }
@@ -75,10 +83,14 @@ ShadedPathEngine::~ShadedPathEngine()
         globalRendering.destroyImage(&img);
     }
     if (globalRendering.device) vkDeviceWaitIdle(globalRendering.device);
+    globalRendering.releaseAllDeferred();
     if (threadsWorker) delete threadsWorker;
     //if (workerFutures) delete workerFutures;
     ThemedTimer::getInstance()->logInfo(TIMER_DRAW_FRAME);
     ThemedTimer::getInstance()->logInfo(TIMER_PART_PREPARE_FRAME);
+    // compare stereo modes with setMultiview(), only the timer of the active mode has calls
+    ThemedTimer::getInstance()->logInfo(TIMER_PART_RECORD_COMMANDS);
+    ThemedTimer::getInstance()->logInfo(TIMER_PART_RECORD_COMMANDS_MULTIVIEW);
     //ThemedTimer::getInstance()->logFPS(TIMER_DRAW_FRAME);
     ThemedTimer::getInstance()->logInfo(TIMER_PRESENT_FRAME);
     ThemedTimer::getInstance()->logFPS(TIMER_PRESENT_FRAME);
@@ -88,6 +100,14 @@ ShadedPathEngine::~ShadedPathEngine()
     ThemedTimer::getInstance()->logInfo(TIMER_PART_BUFFER_COPY);
     ThemedTimer::getInstance()->logInfo(TIMER_PART_GLOBAL_UPDATE);
     ThemedTimer::getInstance()->logInfo(TIMER_PART_OPENXR);
+    // UI CPU time per frame, see UI::setUpdateRate()
+    ThemedTimer::getInstance()->logInfo(TIMER_PART_UI);
+    if (inputPacer.getStats().frames > 0) inputPacer.getStats().log("Input loop");
+    auto pipelineStats = pipelineMetrics.getStats();
+    if (pipelineStats.frames > 0) pipelineStats.log();
+    if (simulationEnabled) simulation.getStats().log();
+    // high-water marks of the whole run
+    memoryTracker.log();
 }
 
 VkExtent2D ShadedPathEngine::getBackBufferExtent()
@@ -175,7 +195,7 @@ void ShadedPathEngine::eventLoop()
         //ui.update();
         if (!singleThreadMode) {
             ThemedTimer::getInstance()->add(TIMER_INPUT_THREAD);
-            limiter.waitForLimit();
+            inputPacer.waitForNextFrame();
         } else {
             // frame generation will only be called from main thread in single thread mode
             preFrame();
@@ -203,18 +223,30 @@ void ShadedPathEngine::prepareDrawing()
     //}
     //presentation.initBackBufferPresentation();
     // check frame resources:
-    for (auto& fi : frameInfos) {
+    for (auto& fi : getFrameResources()) {
         if (fi.drawResults.size() < appDrawCalls) {
             Error("Frames have not been properly initialized. Did you forget initActiveShaders()?");
         }
         shaders.createCommandBuffers(fi);
     }
+    pipelineMetrics.reset(framesInFlight);
+    if (simulationEnabled) {
+        simulation.setTickFunction([this](const SimulationSnapshot* previous, const GameTime& gameTime) {
+            return app->simulate(previous, gameTime);
+        });
+        simulation.start(gameTime);
+    }
     if (!singleThreadMode) {
         qsr.renderThreadContinueQueue.setLoggingInfo(LOG_RENDER_CONTINUATION, "renderContinueQueue");
-        qsr.renderThreadContinueQueue.push(0);
+        // render thread may prepare up to framesInFlight - 1 frames ahead of the queue submit thread.
+        // Submit of frame n waits for frame n-1 on GPU, so frame slot n % framesInFlight is free when it is prepared again
+        for (int i = 0; i < framesInFlight - 1; i++) {
+            qsr.renderThreadContinueQueue.push(0);
+        }
         startQueueSubmitThread();
         startRenderThread();
         startUpdateThread();
+        if (simulationEnabled) startSimulationThread();
     }
     //for (ThreadResources& tr : threadResources) {
     //    shaders.createCommandBufferBackBufferImageDump(tr);
@@ -231,6 +263,15 @@ void ShadedPathEngine::startUpdateThread()
     threadsMain.addThread(ThreadCategory::DrawQueueSubmit, "background_render", runUpdateThread, this);
 }
 
+void ShadedPathEngine::startSimulationThread()
+{
+    if (!initialized) {
+        Error("cannot start simulation thread: pipeline not initialized\n");
+        return;
+    }
+    threadsMain.addThread(ThreadCategory::Simulation, "simulation", runSimulationThread, this);
+}
+
 void ShadedPathEngine::startQueueSubmitThread()
 {
     if (!initialized) {
@@ -272,30 +313,56 @@ bool ShadedPathEngine::shouldClose()
 void ShadedPathEngine::initFrame(FrameResources* fi, long frameNum)
 {
     fi->frameNum = frameNum;
+    fi->frameStart = chrono::steady_clock::now();
     ThemedTimer::getInstance()->start(TIMER_DRAW_FRAME);
 }
 
 void ShadedPathEngine::preFrame()
 {
-    // alternate frame infos:
+    // round robin frame infos:
     long frameNum = getNextFrameNumber();
-    int currentFrameInfoIndex = frameNum & 0x01;
+    int currentFrameInfoIndex = frameNum % framesInFlight;
     currentFrameInfo = &frameInfos[currentFrameInfoIndex];
-    gameTime.advanceTime();
-    fpsCounter.tick(gameTime.getRealTimeDelta(), true);
     initFrame(currentFrameInfo, frameNum);
+    if (simulationEnabled) {
+        // game time comes from simulation snapshot
+        acquireSimulationState(currentFrameInfo);
+        if (frameNum > 1) fpsCounter.tick(chrono::duration<double>(currentFrameInfo->frameStart - lastFrameStart).count(), true);
+    } else {
+        gameTime.advanceTime();
+        fpsCounter.tick(gameTime.getRealTimeDelta(), true);
+    }
+    lastFrameStart = currentFrameInfo->frameStart;
     globalRendering.preFrame(currentFrameInfo);
 
     // call app
     ThemedTimer::getInstance()->start(TIMER_PART_PREPARE_FRAME);
     app->prepareFrame(currentFrameInfo);
     ThemedTimer::getInstance()->stop(TIMER_PART_PREPARE_FRAME);
+    // camera of this frame is set: request streamed textures, residency update runs before submit
+    textureResidency.requestPerFrame();
+}
+
+void ShadedPathEngine::acquireSimulationState(FrameResources* fi)
+{
+    if (singleThreadMode) {
+        simulation.advanceTo(fi->frameStart);
+    } else if (!simulation.waitForFirstSnapshot()) {
+        Error("simulation thread did not produce first snapshot");
+    }
+    SimulationFrameState state = simulation.acquire(fi->frameStart);
+    fi->snapshot = state.current;
+    fi->previousSnapshot = state.previous ? state.previous : state.current;
+    fi->snapshotAlpha = state.alpha;
+    gameTime = state.current->gameTime;
 }
 
 void ShadedPathEngine::drawFrame()
 {
     // call app
     currentFrameInfo->drawFrameDone = false;
+    // time of all draw calls, they record and collect the command buffers of this frame
+    ThemedTimer::getInstance()->start(getRecordCommandsTimer());
     if (singleThreadMode) {
         for (int i = 0; i < appDrawCalls; i++) {
             app->drawFrame(currentFrameInfo, i, &currentFrameInfo->drawResults[i]);
@@ -314,6 +381,7 @@ void ShadedPathEngine::drawFrame()
             workerFutures[i].wait();
         }
     }
+    ThemedTimer::getInstance()->stop(getRecordCommandsTimer());
     // app work is done, we should have a bunch of uncommitted command buffers or a finished image
     currentFrameInfo->numCommandBuffers = currentFrameInfo->countCommandBuffers();
 }
@@ -326,7 +394,11 @@ void ShadedPathEngine::postFrame()
     }
     if (singleThreadMode) {
         ThemedTimer::getInstance()->stop(TIMER_DRAW_FRAME);
+        // no frame is executing on the GPU in single thread mode
+        globalRendering.prepareFrameSubmit(currentFrameInfo);
+        globalRendering.submitFrameUploads(currentFrameInfo);
         singleThreadPostFrame();
+        pipelineMetrics.frameSubmitted(currentFrameInfo->frameStart, currentFrameInfo->snapshot.get());
     } else {
         //Error("Multi thread mode not implemented");
         // do the same in multi thread mode (for now)
@@ -387,7 +459,10 @@ bool ShadedPathEngine::isDrawResultCommandBuffers(FrameResources* fi)
 void ShadedPathEngine::waitUntilShutdown()
 {
     if (!singleThreadMode) {
-        //queue.shutdown();
+        // wake threads waiting for frames, remaining frames are still processed
+        queue.shutdown();
+        qsr.renderThreadContinueQueue.shutdown();
+        backgroundThreadQueue.shutdown();
         threadsMain.join_all();
         if (threadsWorker) {
             delete threadsWorker;
@@ -427,6 +502,8 @@ void ShadedPathEngine::runQueueSubmit(ShadedPathEngine* engine_instance)
         }
         LogCondF(LOG_QUEUE, "engine received frame: " << v->frameInfo->frameNum << endl);
         if (engine_instance->isDrawResultImage(v->frameInfo)) {
+            engine_instance->globalRendering.prepareFrameSubmit(v->frameInfo);
+            engine_instance->globalRendering.submitFrameUploads(v->frameInfo);
             if (v->frameInfo->renderedImage->rendered == true) {
                 // consume rendered image
                 Log("submit thread consuming frame image " << v->frameInfo->frameNum << endl);
@@ -436,11 +513,13 @@ void ShadedPathEngine::runQueueSubmit(ShadedPathEngine* engine_instance)
                 }
                 engine_instance->imageConsumer->consume(v->frameInfo);
             }
+            engine_instance->pipelineMetrics.frameSubmitted(v->frameInfo->frameStart, v->frameInfo->snapshot.get());
         }
         else if (engine_instance->isDrawResultCommandBuffers(v->frameInfo)) {
             // submit command buffers for this frame and process finished image from last frame
             //Log("submit thread submitting frame " << v->frameInfo->frameNum << endl);
             engine_instance->globalRendering.submit(v->frameInfo);
+            engine_instance->pipelineMetrics.frameSubmitted(v->frameInfo->frameStart, v->frameInfo->snapshot.get());
             // we submitted the command buffers of the current frame,
             // this should take some time time to process, so we display the last frame in the meantime
             // basically we are 1 frame behind with rendering
@@ -450,7 +529,7 @@ void ShadedPathEngine::runQueueSubmit(ShadedPathEngine* engine_instance)
                 engine_instance->globalRendering.processImage(v->frameInfo);
                 engine_instance->app->processImage(v->frameInfo);
             } else {
-                int lastFrameIndex = (v->frameInfo->frameIndex + 1) & 0x01;
+                int lastFrameIndex = (v->frameInfo->frameIndex + engine_instance->framesInFlight - 1) % engine_instance->framesInFlight;
                 engine_instance->globalRendering.processImage(&engine_instance->frameInfos[lastFrameIndex]);
                 engine_instance->app->processImage(&engine_instance->frameInfos[lastFrameIndex]);
             }
@@ -469,7 +548,7 @@ void ShadedPathEngine::runQueueSubmit(ShadedPathEngine* engine_instance)
         // tell render thread to continue:
         //v->renderThreadContinue->test_and_set();
         //v->renderThreadContinue->notify_one();
-        v->renderThreadContinueQueue.push(0);
+        engine_instance->qsr.renderThreadContinueQueue.push(0);
     }
     // kill background thread
     engine_instance->backgroundThreadQueue.push(nullptr);
@@ -502,10 +581,11 @@ void ShadedPathEngine::runDrawFrame(ShadedPathEngine* engine_instance)
         //engine_instance->globalUpdate.doSyncedDrawingThreadMaintenance();
         //engine_instance->queue.push(tr);
         engine_instance->preFrame();
-        engine_instance->qsr.frameInfo = engine_instance->currentFrameInfo;
+        QueueSubmitResources* submitResources = &engine_instance->frameSubmits[engine_instance->currentFrameInfo->frameIndex];
+        submitResources->frameInfo = engine_instance->currentFrameInfo;
         engine_instance->drawFrame();
         engine_instance->postFrame();
-        engine_instance->queue.push(&engine_instance->qsr);
+        engine_instance->queue.push(submitResources);
 
         LogCondF(LOG_QUEUE, "pushed frame: " << endl);
 
@@ -534,4 +614,11 @@ void ShadedPathEngine::runUpdateThread(ShadedPathEngine* engine_instance)
     LogF("run Update Thread end " << endl);
     engine_instance->queueThreadFinished = true;
 
-}
\ No newline at end of file
+}
+
+void ShadedPathEngine::runSimulationThread(ShadedPathEngine* engine_instance)
+{
+    LogF("run Simulation Thread start " << endl);
+    engine_instance->simulation.runLoop([engine_instance] { return engine_instance->shouldClose(); });
+    LogF("run Simulation Thread end " << endl);
+}
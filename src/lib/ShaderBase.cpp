@@ -142,6 +142,18 @@ void ShaderBase::createRenderPassAndFramebuffer(FrameResources& tr, ShaderState
 	renderPassInfo.pSubpasses = &subpass;
 	renderPassInfo.dependencyCount = 1;
 	renderPassInfo.pDependencies = &dependency;
+	// multiview: subpass renders to both layers (eyes), gl_ViewIndex selects the eye in the shaders
+	const uint32_t viewMask = 0b11;
+	const uint32_t correlationMask = 0b11; // eyes see almost the same scene
+	VkRenderPassMultiviewCreateInfo multiviewInfo{};
+	multiviewInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_MULTIVIEW_CREATE_INFO;
+	multiviewInfo.subpassCount = 1;
+	multiviewInfo.pViewMasks = &viewMask;
+	multiviewInfo.correlationMaskCount = 1;
+	multiviewInfo.pCorrelationMasks = &correlationMask;
+	if (isMultiview()) {
+		renderPassInfo.pNext = &multiviewInfo;
+	}
 
 	if (vkCreateRenderPass(engine->globalRendering.device, &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS) {
 		Error("failed to create render pass!");
@@ -152,6 +164,10 @@ void ShaderBase::createRenderPassAndFramebuffer(FrameResources& tr, ShaderState
         Error("colorAttachment or depthImageView not initialized! We need a render surface before initializing the shaders.");
     }
 	array<VkImageView, 2> attachmentsView = { tr.colorImage.fba.view, tr.depthImageView };
+	if (isMultiview()) {
+		// one framebuffer with both layers, frameBuffer2 is not used
+		attachmentsView = { tr.colorImageArrayView, tr.depthImageArrayView };
+	}
 
 	VkFramebufferCreateInfo framebufferInfo{};
 	framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
@@ -165,7 +181,7 @@ void ShaderBase::createRenderPassAndFramebuffer(FrameResources& tr, ShaderState
 	if (vkCreateFramebuffer(engine->globalRendering.device, &framebufferInfo, nullptr, &frameBuffer) != VK_SUCCESS) {
 		Error("failed to create framebuffer!");
 	}
-	if (engine->isStereo()) {
+	if (engine->isStereo() && !isMultiview()) {
 		array<VkImageView, 2> attachmentsView2 = { tr.colorImage2.fba.view, tr.depthImageView2 };
 
 		VkFramebufferCreateInfo framebufferInfo{};
@@ -183,6 +199,16 @@ void ShaderBase::createRenderPassAndFramebuffer(FrameResources& tr, ShaderState
 	}
 }
 
+void ShaderBase::uploadMultiviewUBO(VkDeviceMemory uniformBufferMemory, const void* ubo, const void* ubo2, size_t size)
+{
+	VkDeviceSize stride = getMultiviewUBOStride(size);
+	char* data;
+	vkMapMemory(device, uniformBufferMemory, 0, stride + size, 0, (void**)&data);
+	memcpy(data, ubo, size);
+	memcpy(data + stride, ubo2, size);
+	vkUnmapMemory(device, uniformBufferMemory);
+}
+
 // may not be suitable for all shaders - single fields may simply be overwritten
 VkPipelineRasterizationStateCreateInfo ShaderBase::createStandardRasterizer() {
 	VkPipelineRasterizationStateCreateInfo rasterizer{};
@@ -134,9 +134,26 @@ public:
 	// create VertexBuffer. buffer GPU memory is mapped to uniformBufferMemory for CPU access
 	void createVertexBuffer(VkBuffer& uniformBuffer, size_t size, VkDeviceMemory& uniformBufferMemory);
 
-	// create render pass and framebuffer with respect to shader state
+	// create render pass and framebuffer with respect to shader state.
+	// In multiview mode only frameBuffer is created, it renders both eyes
 	void createRenderPassAndFramebuffer(FrameResources& tr, ShaderState shaderState, VkRenderPass& renderPass, VkFramebuffer& frameBuffer, VkFramebuffer& frameBuffer2);
 
+	// Multiview: shaders that set multiviewSupported render both eyes in one render pass.
+	// Their uniform buffer holds the UBO of both eyes, laid out like a std140 array of structs and indexed by gl_ViewIndex
+	bool isMultiview() {
+		return multiviewSupported && engine->isMultiview();
+	}
+	// offset of right eye UBO in multiview uniform buffer (std140 struct arrays have 16 byte aligned elements)
+	static VkDeviceSize getMultiviewUBOStride(size_t uboSize) {
+		return (uboSize + 15) & ~VkDeviceSize(15);
+	}
+	// size of multiview uniform buffer for both eyes
+	static VkDeviceSize getMultiviewUBOSize(size_t uboSize) {
+		return getMultiviewUBOStride(uboSize) + uboSize;
+	}
+	// copy UBOs of both eyes to multiview uniform buffer with one map
+	void uploadMultiviewUBO(VkDeviceMemory uniformBufferMemory, const void* ubo, const void* ubo2, size_t size);
+
 	void setLastShader(bool last) {
 		lastShader = last;
 	}
@@ -158,6 +175,7 @@ public:
 	GlobalRendering* global = nullptr;
 	VulkanResources resources;
 	bool wireframe = false;
+	bool multiviewSupported = false; // set by shaders that can render both eyes in one pass
 
 	VkDescriptorSetLayout descriptorSetLayout = nullptr;
 	VkDescriptorPool descriptorPool = nullptr;
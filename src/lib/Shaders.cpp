@@ -15,6 +15,11 @@ Shaders::Config& Shaders::Config::init()
 	//}
 	lastShader->setLastShader(true);
 	engine->globalRendering.createViewportState(shaderState);
+	auto start = chrono::high_resolution_clock::now();
+	// pipelines are only recorded here and compiled in parallel after all shaders are initialized.
+	// Pipeline handles are not used before command buffers are created.
+	auto& pipelineCache = engine->globalRendering.pipelineCache;
+	pipelineCache.beginDeferred();
 	for (ShaderBase* shader : shaderList) {
 		shader->init(*engine, shaderState);
 		// pipelines must be created for all FrameInfos
@@ -23,6 +28,9 @@ Shaders::Config& Shaders::Config::init()
         }
 		shader->finishInitialization(*engine, shaderState);
 	}
+	pipelineCache.endDeferred(engine->getWorkerThreads());
+	auto end = chrono::high_resolution_clock::now();
+	Log("Shader initialization took " << chrono::duration<double, milli>(end - start).count() << " ms" << endl);
 	return *this;
 }
 
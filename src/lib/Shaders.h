@@ -102,7 +102,7 @@ public:
 	PBRShader pbrShader;
 	CubeShader cubeShader;
 	BillboardShader billboardShader;
-	//TerrainShader terrainShader;
+	TerrainShader terrainShader;
 
 	// submit command buffers for current frame
 	void submitFrame(ThreadResources& tr);
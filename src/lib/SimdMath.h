@@ -0,0 +1,137 @@
+#pragma once
+/*
+ * Minimal 4-wide float vector used by CPU side batch kernels (LOD selection, culling, ...).
+ * Maps to SSE2 on x64, NEON on arm64 (Apple silicon) and plain scalar code everywhere else.
+ * Kernels work on SoA float arrays and process 4 elements per step, remaining elements
+ * have to be handled by the caller (or arrays padded to multiples of SIMD_WIDTH).
+ */
+
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__)
+#define SPE_SIMD_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__aarch64__) || defined(_M_ARM64)
+#define SPE_SIMD_NEON
+#include <arm_neon.h>
+#else
+#define SPE_SIMD_SCALAR
+#endif
+
+static constexpr int SIMD_WIDTH = 4;
+
+struct alignas(16) Float4 {
+#if defined(SPE_SIMD_SSE2)
+	__m128 v;
+	Float4() : v(_mm_setzero_ps()) {}
+	Float4(__m128 m) : v(m) {}
+	explicit Float4(float f) : v(_mm_set1_ps(f)) {}
+	Float4(float x, float y, float z, float w) : v(_mm_setr_ps(x, y, z, w)) {}
+	static Float4 load(const float* p) { return Float4(_mm_loadu_ps(p)); }
+	void store(float* p) const { _mm_storeu_ps(p, v); }
+	friend Float4 operator+(Float4 a, Float4 b) { return Float4(_mm_add_ps(a.v, b.v)); }
+	friend Float4 operator-(Float4 a, Float4 b) { return Float4(_mm_sub_ps(a.v, b.v)); }
+	friend Float4 operator*(Float4 a, Float4 b) { return Float4(_mm_mul_ps(a.v, b.v)); }
+	friend Float4 operator&(Float4 a, Float4 b) { return Float4(_mm_and_ps(a.v, b.v)); }
+	friend Float4 operator|(Float4 a, Float4 b) { return Float4(_mm_or_ps(a.v, b.v)); }
+	static Float4 min(Float4 a, Float4 b) { return Float4(_mm_min_ps(a.v, b.v)); }
+	static Float4 max(Float4 a, Float4 b) { return Float4(_mm_max_ps(a.v, b.v)); }
+	// comparisons return all-bits-set lanes for true, 0 for false
+	static Float4 lessThan(Float4 a, Float4 b) { return Float4(_mm_cmplt_ps(a.v, b.v)); }
+	static Float4 greaterThan(Float4 a, Float4 b) { return Float4(_mm_cmpgt_ps(a.v, b.v)); }
+	// bit i set if lane i of mask is true
+	static int moveMask(Float4 mask) { return _mm_movemask_ps(mask.v); }
+	// (x, y, z, w) --> (y, x, w, z), used for interleaved 2 component data like UVs
+	Float4 swapPairs() const { return Float4(_mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1))); }
+#elif defined(SPE_SIMD_NEON)
+	float32x4_t v;
+	Float4() : v(vdupq_n_f32(0.0f)) {}
+	Float4(float32x4_t m) : v(m) {}
+	explicit Float4(float f) : v(vdupq_n_f32(f)) {}
+	Float4(float x, float y, float z, float w) { float a[4] = { x, y, z, w }; v = vld1q_f32(a); }
+	static Float4 load(const float* p) { return Float4(vld1q_f32(p)); }
+	void store(float* p) const { vst1q_f32(p, v); }
+	friend Float4 operator+(Float4 a, Float4 b) { return Float4(vaddq_f32(a.v, b.v)); }
+	friend Float4 operator-(Float4 a, Float4 b) { return Float4(vsubq_f32(a.v, b.v)); }
+	friend Float4 operator*(Float4 a, Float4 b) { return Float4(vmulq_f32(a.v, b.v)); }
+	friend Float4 operator&(Float4 a, Float4 b) { return Float4(vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(a.v), vreinterpretq_u32_f32(b.v)))); }
+	friend Float4 operator|(Float4 a, Float4 b) { return Float4(vreinterpretq_f32_u32(vorrq_u32(vreinterpretq_u32_f32(a.v), vreinterpretq_u32_f32(b.v)))); }
+	static Float4 min(Float4 a, Float4 b) { return Float4(vminq_f32(a.v, b.v)); }
+	static Float4 max(Float4 a, Float4 b) { return Float4(vmaxq_f32(a.v, b.v)); }
+	static Float4 lessThan(Float4 a, Float4 b) { return Float4(vreinterpretq_f32_u32(vcltq_f32(a.v, b.v))); }
+	static Float4 greaterThan(Float4 a, Float4 b) { return Float4(vreinterpretq_f32_u32(vcgtq_f32(a.v, b.v))); }
+	static int moveMask(Float4 mask) {
+		uint32x4_t m = vshrq_n_u32(vreinterpretq_u32_f32(mask.v), 31);
+		return (int)(vgetq_lane_u32(m, 0) | (vgetq_lane_u32(m, 1) << 1) | (vgetq_lane_u32(m, 2) << 2) | (vgetq_lane_u32(m, 3) << 3));
+	}
+	Float4 swapPairs() const { return Float4(vrev64q_f32(v)); }
+#else
+	float v[4];
+	Float4() : v{ 0.0f, 0.0f, 0.0f, 0.0f } {}
+	explicit Float4(float f) : v{ f, f, f, f } {}
+	Float4(float x, float y, float z, float w) : v{ x, y, z, w } {}
+	static Float4 load(const float* p) { Float4 r; for (int i = 0; i < 4; i++) r.v[i] = p[i]; return r; }
+	void store(float* p) const { for (int i = 0; i < 4; i++) p[i] = v[i]; }
+	template<typename Op>
+	static Float4 lanes(Float4 a, Float4 b, Op op) { Float4 r; for (int i = 0; i < 4; i++) r.v[i] = op(a.v[i], b.v[i]); return r; }
+	template<typename Op>
+	static Float4 bits(Float4 a, Float4 b, Op op) {
+		Float4 r;
+		for (int i = 0; i < 4; i++) {
+			uint32_t ua, ub, ur;
+			memcpy(&ua, &a.v[i], 4); memcpy(&ub, &b.v[i], 4);
+			ur = op(ua, ub);
+			memcpy(&r.v[i], &ur, 4);
+		}
+		return r;
+	}
+	static float maskValue(bool b) { uint32_t u = b ? 0xFFFFFFFFu : 0u; float f; memcpy(&f, &u, 4); return f; }
+	friend Float4 operator+(Float4 a, Float4 b) { return lanes(a, b, [](float x, float y) { return x + y; }); }
+	friend Float4 operator-(Float4 a, Float4 b) { return lanes(a, b, [](float x, float y) { return x - y; }); }
+	friend Float4 operator*(Float4 a, Float4 b) { return lanes(a, b, [](float x, float y) { return x * y; }); }
+	friend Float4 operator&(Float4 a, Float4 b) { return bits(a, b, [](uint32_t x, uint32_t y) { return x & y; }); }
+	friend Float4 operator|(Float4 a, Float4 b) { return bits(a, b, [](uint32_t x, uint32_t y) { return x | y; }); }
+	static Float4 min(Float4 a, Float4 b) { return lanes(a, b, [](float x, float y) { return y < x ? y : x; }); }
+	static Float4 max(Float4 a, Float4 b) { return lanes(a, b, [](float x, float y) { return x < y ? y : x; }); }
+	static Float4 lessThan(Float4 a, Float4 b) { return lanes(a, b, [](float x, float y) { return maskValue(x < y); }); }
+	static Float4 greaterThan(Float4 a, Float4 b) { return lanes(a, b, [](float x, float y) { return maskValue(x > y); }); }
+	static int moveMask(Float4 mask) {
+		int r = 0;
+		for (int i = 0; i < 4; i++) { uint32_t u; memcpy(&u, &mask.v[i], 4); if (u & 0x80000000u) r |= 1 << i; }
+		return r;
+	}
+	Float4 swapPairs() const { return Float4(v[1], v[0], v[3], v[2]); }
+#endif
+	// lanes where mask is set get value a, others b
+	static Float4 select(Float4 mask, Float4 a, Float4 b) {
+#if defined(SPE_SIMD_SSE2)
+		return Float4(_mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v)));
+#elif defined(SPE_SIMD_NEON)
+		return Float4(vbslq_f32(vreinterpretq_u32_f32(mask.v), a.v, b.v));
+#else
+		Float4 r;
+		for (int i = 0; i < 4; i++) { uint32_t u; memcpy(&u, &mask.v[i], 4); r.v[i] = u ? a.v[i] : b.v[i]; }
+		return r;
+#endif
+	}
+	// add 1.0 to all lanes where mask is set. Used to count threshold crossings
+	static Float4 countIf(Float4 counter, Float4 mask) {
+		return counter + (mask & Float4(1.0f));
+	}
+};
+
+// round up element count to full SIMD batches
+inline size_t simdPaddedSize(size_t n) {
+	return (n + SIMD_WIDTH - 1) & ~(size_t)(SIMD_WIDTH - 1);
+}
+
+// out = a * b for column major 4x4 matrices (glm memory layout), out may alias a or b
+inline void simdMat4Mul(const float* a, const float* b, float* out) {
+	Float4 a0 = Float4::load(a);
+	Float4 a1 = Float4::load(a + 4);
+	Float4 a2 = Float4::load(a + 8);
+	Float4 a3 = Float4::load(a + 12);
+	for (int c = 0; c < 4; c++) {
+		const float* bc = b + c * 4;
+		Float4 r = a0 * Float4(bc[0]) + a1 * Float4(bc[1]) + a2 * Float4(bc[2]) + a3 * Float4(bc[3]);
+		r.store(out + c * 4);
+	}
+}
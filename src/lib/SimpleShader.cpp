@@ -117,9 +117,7 @@ void SimpleShader::initSingle(FrameResources& tr, ShaderState& shaderState)
 	pipelineInfo.subpass = 0;
 	pipelineInfo.basePipelineHandle = VK_NULL_HANDLE; // Optional
 	pipelineInfo.basePipelineIndex = -1; // Optional
-	if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &str.graphicsPipeline) != VK_SUCCESS) {
-		Error("failed to create graphics pipeline!");
-	}
+	engine->globalRendering.pipelineCache.createGraphicsPipelineDeferred(pipelineInfo, &str.graphicsPipeline);
 }
 
 void SimpleShader::uploadToGPU(FrameResources& tr, UniformBufferObject& ubo, UniformBufferObject& ubo2) {
@@ -220,9 +218,9 @@ SimpleShader::~SimpleShader()
 	}
     vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
 	vkDestroyBuffer(device, vertexBufferTriangle, nullptr);
-	vkFreeMemory(device, vertexBufferMemoryTriangle, nullptr);
+	engine->globalRendering.freeMemory(vertexBufferMemoryTriangle);
 	vkDestroyBuffer(device, indexBufferTriangle, nullptr);
-	vkFreeMemory(device, indexBufferMemoryTriangle, nullptr);
+	engine->globalRendering.freeMemory(indexBufferMemoryTriangle);
 	vkDestroyShaderModule(device, fragShaderModuleTriangle, nullptr);
 	vkDestroyShaderModule(device, vertShaderModuleTriangle, nullptr);
 	vkDestroyDescriptorPool(device, descriptorPool, nullptr);
@@ -236,7 +234,7 @@ void SimpleShader::destroyThreadResources(FrameResources& tr)
 	vkDestroyPipeline(device, trl.graphicsPipeline, nullptr);
 	vkDestroyPipelineLayout(device, trl.pipelineLayout, nullptr);
 	vkDestroyBuffer(device, trl.uniformBuffer, nullptr);
-	vkFreeMemory(device, trl.uniformBufferMemory, nullptr);
+	engine->globalRendering.freeMemory(trl.uniformBufferMemory);
 	if (engine->isStereo()) {
 		vkDestroyFramebuffer(device, trl.framebuffer2, nullptr);
 	}
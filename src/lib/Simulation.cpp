@@ -0,0 +1,155 @@
+#include "mainheader.h"
+
+using namespace std;
+
+void SimulationStats::log() const
+{
+	Log("Simulation: " << ticks << " ticks, " << skippedTicks << " skipped, avg tick " << (ticks > 0 ? tickMilliseconds / ticks : 0.0) << " ms" << endl);
+}
+
+void Simulation::setTickRate(double ticksPerSecond)
+{
+	if (ticksPerSecond <= 0.0) {
+		Error("Simulation: tick rate has to be positive");
+	}
+	tickRate = ticksPerSecond;
+	tickDuration = chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(1.0 / ticksPerSecond));
+}
+
+void Simulation::start(const GameTime& gameTime, chrono::steady_clock::time_point now)
+{
+	simTime = gameTime;
+	simClock = now;
+	nextTick = now;
+	tickCount = 0;
+	unique_lock<mutex> lock(monitorMutex);
+	previous = nullptr;
+	current = nullptr;
+	stats = SimulationStats();
+	started = true;
+}
+
+void Simulation::tick(chrono::steady_clock::time_point dueTime)
+{
+	auto startTime = chrono::steady_clock::now();
+	// game time moves by exactly one tick duration, independent of when the tick actually runs
+	if (tickCount > 0) simClock += tickDuration;
+	simTime.advanceTime(simClock);
+	// current is only written by this thread, no lock needed for reading
+	shared_ptr<SimulationSnapshot> s = tickFunction ? tickFunction(current.get(), simTime) : make_shared<SimulationSnapshot>();
+	if (s == nullptr) {
+		Error("Simulation: tick function returned no snapshot");
+	}
+	s->tick = tickCount++;
+	s->gameTime = simTime;
+	s->dueTime = dueTime;
+	s->created = chrono::steady_clock::now();
+	unique_lock<mutex> lock(monitorMutex);
+	previous = std::move(current);
+	current = std::move(s);
+	stats.ticks++;
+	stats.tickMilliseconds += chrono::duration<double, milli>(chrono::steady_clock::now() - startTime).count();
+	cond.notify_all();
+}
+
+uint32_t Simulation::advanceTo(chrono::steady_clock::time_point now)
+{
+	if (!started) {
+		Error("Simulation: start() has to be called before advancing");
+	}
+	if (now < nextTick) return 0;
+	uint64_t due = (now - nextTick) / tickDuration + 1;
+	if (due > MAX_CATCHUP_TICKS) {
+		// drop time we cannot catch up with instead of running late forever
+		uint64_t skip = due - MAX_CATCHUP_TICKS;
+		nextTick += tickDuration * skip;
+		unique_lock<mutex> lock(monitorMutex);
+		stats.skippedTicks += skip;
+	}
+	uint32_t executed = 0;
+	while (nextTick <= now) {
+		tick(nextTick);
+		nextTick += tickDuration;
+		executed++;
+	}
+	return executed;
+}
+
+void Simulation::runLoop(function<bool()> shouldStop)
+{
+	if (!started) {
+		Error("Simulation: start() has to be called before running simulation thread");
+	}
+	while (!shouldStop()) {
+		advanceTo(chrono::steady_clock::now());
+		this_thread::sleep_until(nextTick);
+	}
+}
+
+SimulationFrameState Simulation::acquire(chrono::steady_clock::time_point now) const
+{
+	unique_lock<mutex> lock(monitorMutex);
+	SimulationFrameState state;
+	state.previous = previous;
+	state.current = current;
+	if (current && previous) {
+		double a = chrono::duration<double>(now - current->dueTime) / chrono::duration<double>(tickDuration);
+		state.alpha = static_cast<float>(std::clamp(a, 0.0, 1.0));
+	}
+	return state;
+}
+
+bool Simulation::waitForFirstSnapshot(chrono::milliseconds timeout) const
+{
+	unique_lock<mutex> lock(monitorMutex);
+	return cond.wait_for(lock, timeout, [this] { return current != nullptr; });
+}
+
+SimulationStats Simulation::getStats() const
+{
+	unique_lock<mutex> lock(monitorMutex);
+	return stats;
+}
+
+void FramePipelineStats::log() const
+{
+	Log("Frame pipeline " << framesInFlight << " frames in flight: " << frames << " frames, " << framesPerSecond() << " fps, latency avg "
+		<< avgLatencyMilliseconds << " ms max " << maxLatencyMilliseconds << " ms, repeated snapshots " << repeatedSnapshots
+		<< " unrendered ticks " << unrenderedTicks << endl);
+}
+
+void FramePipelineMetrics::reset(int framesInFlight)
+{
+	unique_lock<mutex> lock(monitorMutex);
+	stats = FramePipelineStats();
+	stats.framesInFlight = framesInFlight;
+	latencySum = 0.0;
+	hasTick = false;
+}
+
+void FramePipelineMetrics::frameSubmitted(chrono::steady_clock::time_point frameStart, const SimulationSnapshot* snapshot, chrono::steady_clock::time_point now)
+{
+	auto origin = snapshot ? snapshot->created : frameStart;
+	double latency = chrono::duration<double, milli>(now - origin).count();
+	unique_lock<mutex> lock(monitorMutex);
+	if (stats.frames == 0) first = now;
+	stats.frames++;
+	stats.seconds = chrono::duration<double>(now - first).count();
+	latencySum += latency;
+	stats.avgLatencyMilliseconds = latencySum / stats.frames;
+	stats.maxLatencyMilliseconds = std::max(stats.maxLatencyMilliseconds, latency);
+	if (snapshot) {
+		if (hasTick) {
+			if (snapshot->tick == lastTick) stats.repeatedSnapshots++;
+			else if (snapshot->tick > lastTick + 1) stats.unrenderedTicks += snapshot->tick - lastTick - 1;
+		}
+		lastTick = snapshot->tick;
+		hasTick = true;
+	}
+}
+
+FramePipelineStats FramePipelineMetrics::getStats() const
+{
+	unique_lock<mutex> lock(monitorMutex);
+	return stats;
+}
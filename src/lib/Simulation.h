@@ -0,0 +1,117 @@
+#pragma once
+
+// Decoupled simulation: app state is advanced at a fixed tick rate on its own thread
+// (see ShadedPathEngine::enableSimulationThread()). Each tick publishes an immutable snapshot,
+// render preparation picks up the latest two snapshots for the frame it prepares.
+// Snapshots are shared_ptr: a frame keeps its snapshots alive until the frame slot is reused,
+// so the simulation thread never has to wait for rendering.
+
+// base class for app state of one simulation tick. Apps derive their own state from this.
+// Must not be changed after it was returned from the tick function
+struct SimulationSnapshot {
+	virtual ~SimulationSnapshot() {}
+	uint64_t tick = 0;
+	GameTime gameTime; // game time at this tick, advanced by exactly one tick duration per tick
+	std::chrono::steady_clock::time_point dueTime; // wall clock time this tick represents
+	std::chrono::steady_clock::time_point created; // wall clock time this tick was published
+};
+
+// snapshots for one frame: render state is interpolated from previous to current with alpha in [0,1]
+struct SimulationFrameState {
+	std::shared_ptr<const SimulationSnapshot> previous;
+	std::shared_ptr<const SimulationSnapshot> current;
+	float alpha = 1.0f;
+};
+
+struct SimulationStats {
+	uint64_t ticks = 0;
+	uint64_t skippedTicks = 0; // ticks dropped because simulation was too far behind
+	double tickMilliseconds = 0.0; // accumulated duration of tick functions
+	void log() const;
+};
+
+class Simulation
+{
+public:
+	// create app state for next tick. previous is nullptr for the first tick
+	using TickFunction = std::function<std::shared_ptr<SimulationSnapshot>(const SimulationSnapshot* previous, const GameTime& gameTime)>;
+	// if simulation falls behind more than this many ticks, the missing time is dropped
+	static constexpr uint32_t MAX_CATCHUP_TICKS = 5;
+
+	void setTickRate(double ticksPerSecond);
+	double getTickRate() const {
+		return tickRate;
+	}
+	std::chrono::steady_clock::duration getTickDuration() const {
+		return tickDuration;
+	}
+	void setTickFunction(TickFunction f) {
+		tickFunction = f;
+	}
+	// first tick is due at 'now'. gameTime is the base time all ticks are advanced from
+	void start(const GameTime& gameTime, std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now());
+	bool isStarted() const {
+		return started;
+	}
+	// run all ticks that are due at 'now'. Returns number of executed ticks
+	uint32_t advanceTo(std::chrono::steady_clock::time_point now);
+	// simulation thread: tick at fixed rate until shouldStop() returns true
+	void runLoop(std::function<bool()> shouldStop);
+
+	// latest two snapshots, alpha is the position of 'now' after the current tick. current is nullptr before first tick
+	SimulationFrameState acquire(std::chrono::steady_clock::time_point now) const;
+	// block until the first snapshot was published. Returns false on timeout
+	bool waitForFirstSnapshot(std::chrono::milliseconds timeout = std::chrono::milliseconds(3000)) const;
+	SimulationStats getStats() const;
+
+private:
+	void tick(std::chrono::steady_clock::time_point dueTime);
+	double tickRate = 60.0;
+	std::chrono::steady_clock::duration tickDuration = std::chrono::microseconds(16667);
+	TickFunction tickFunction;
+	bool started = false;
+	std::chrono::steady_clock::time_point nextTick;
+	std::chrono::steady_clock::time_point simClock; // time point of last tick without skipped ticks
+	GameTime simTime; // only used by simulation thread
+	uint64_t tickCount = 0;
+	// published state, guarded by monitorMutex
+	mutable std::mutex monitorMutex;
+	mutable std::condition_variable cond;
+	std::shared_ptr<const SimulationSnapshot> previous;
+	std::shared_ptr<const SimulationSnapshot> current;
+	SimulationStats stats;
+};
+
+// latency and throughput of the frame pipeline, measured when frames are handed to the GPU.
+// Latency is from snapshot creation (or frame start without simulation thread) to submit
+struct FramePipelineStats {
+	int framesInFlight = 0;
+	uint64_t frames = 0;
+	double seconds = 0.0; // between first and last submitted frame
+	double avgLatencyMilliseconds = 0.0;
+	double maxLatencyMilliseconds = 0.0;
+	uint64_t repeatedSnapshots = 0; // frames rendered with same tick as frame before
+	uint64_t unrenderedTicks = 0; // ticks never rendered
+	double framesPerSecond() const {
+		return seconds > 0.0 && frames > 1 ? (frames - 1) / seconds : 0.0;
+	}
+	void log() const;
+};
+
+class FramePipelineMetrics
+{
+public:
+	void reset(int framesInFlight);
+	// snapshot may be nullptr if simulation thread is not used
+	void frameSubmitted(std::chrono::steady_clock::time_point frameStart, const SimulationSnapshot* snapshot,
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now());
+	FramePipelineStats getStats() const;
+
+private:
+	mutable std::mutex monitorMutex;
+	FramePipelineStats stats;
+	double latencySum = 0.0;
+	std::chrono::steady_clock::time_point first;
+	uint64_t lastTick = 0;
+	bool hasTick = false;
+};
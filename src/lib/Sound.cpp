@@ -33,8 +33,122 @@
 
 ma_result result;
 ma_engine sound_engine;
+ma_context sound_context; // only used for null device
 
-void Sound::init(bool playJingle)
+// file access of the resource manager: paths with Sound::PAK_PREFIX are read from their window in data.pak,
+// all other paths are passed to the default vfs
+struct SoundVFS {
+	ma_vfs_callbacks cb; // has to be first, miniaudio casts the ma_vfs* to it
+	ma_default_vfs defaultVFS;
+	Files* files = nullptr;
+};
+struct SoundVFSFile {
+	std::ifstream* pak = nullptr; // nullptr if opened by default vfs
+	ma_vfs_file file = nullptr;
+	int64_t offset = 0;
+	int64_t length = 0;
+	int64_t cursor = 0;
+};
+SoundVFS sound_vfs;
+
+static ma_result soundVfsOpen(ma_vfs* pVFS, const char* pFilePath, ma_uint32 openMode, ma_vfs_file* pFile)
+{
+	SoundVFS* vfs = (SoundVFS*)pVFS;
+	const std::string& prefix = Sound::PAK_PREFIX;
+	if (strncmp(pFilePath, prefix.c_str(), prefix.size()) != 0) {
+		ma_vfs_file file;
+		ma_result r = ma_vfs_open(&vfs->defaultVFS, pFilePath, openMode, &file);
+		if (r != MA_SUCCESS) return r;
+		*pFile = new SoundVFSFile{ nullptr, file };
+		return MA_SUCCESS;
+	}
+	if (openMode & MA_OPEN_MODE_WRITE) return MA_ACCESS_DENIED;
+	PakEntry* entry = vfs->files->findFileInPak(pFilePath + prefix.size());
+	if (entry == nullptr) return MA_DOES_NOT_EXIST;
+	std::ifstream* pak = new std::ifstream(entry->pakname, std::ios::in | std::ios::binary);
+	if (!*pak) {
+		delete pak;
+		return MA_ERROR;
+	}
+	pak->seekg(entry->offset);
+	*pFile = new SoundVFSFile{ pak, nullptr, entry->offset, entry->len, 0 };
+	return MA_SUCCESS;
+}
+
+static ma_result soundVfsOpenW(ma_vfs* pVFS, const wchar_t* pFilePath, ma_uint32 openMode, ma_vfs_file* pFile)
+{
+	ma_vfs_file file;
+	ma_result r = ma_vfs_open_w(&((SoundVFS*)pVFS)->defaultVFS, pFilePath, openMode, &file);
+	if (r != MA_SUCCESS) return r;
+	*pFile = new SoundVFSFile{ nullptr, file };
+	return MA_SUCCESS;
+}
+
+static ma_result soundVfsClose(ma_vfs* pVFS, ma_vfs_file file)
+{
+	SoundVFSFile* f = (SoundVFSFile*)file;
+	ma_result r = MA_SUCCESS;
+	if (f->pak) delete f->pak;
+	else r = ma_vfs_close(&((SoundVFS*)pVFS)->defaultVFS, f->file);
+	delete f;
+	return r;
+}
+
+static ma_result soundVfsRead(ma_vfs* pVFS, ma_vfs_file file, void* pDst, size_t sizeInBytes, size_t* pBytesRead)
+{
+	SoundVFSFile* f = (SoundVFSFile*)file;
+	if (!f->pak) return ma_vfs_read(&((SoundVFS*)pVFS)->defaultVFS, f->file, pDst, sizeInBytes, pBytesRead);
+	// never read past the end of the entry
+	size_t n = static_cast<size_t>(std::min<int64_t>(sizeInBytes, f->length - f->cursor));
+	f->pak->read((char*)pDst, n);
+	n = static_cast<size_t>(f->pak->gcount());
+	f->cursor += n;
+	if (pBytesRead) *pBytesRead = n;
+	return (n == 0 && sizeInBytes > 0) ? MA_AT_END : MA_SUCCESS;
+}
+
+static ma_result soundVfsWrite(ma_vfs* pVFS, ma_vfs_file file, const void* pSrc, size_t sizeInBytes, size_t* pBytesWritten)
+{
+	SoundVFSFile* f = (SoundVFSFile*)file;
+	if (f->pak) return MA_ACCESS_DENIED;
+	return ma_vfs_write(&((SoundVFS*)pVFS)->defaultVFS, f->file, pSrc, sizeInBytes, pBytesWritten);
+}
+
+static ma_result soundVfsSeek(ma_vfs* pVFS, ma_vfs_file file, ma_int64 offset, ma_seek_origin origin)
+{
+	SoundVFSFile* f = (SoundVFSFile*)file;
+	if (!f->pak) return ma_vfs_seek(&((SoundVFS*)pVFS)->defaultVFS, f->file, offset, origin);
+	int64_t base = origin == ma_seek_origin_start ? 0 : (origin == ma_seek_origin_current ? f->cursor : f->length);
+	int64_t cursor = base + offset;
+	if (cursor < 0 || cursor > f->length) return MA_BAD_SEEK;
+	f->cursor = cursor;
+	f->pak->clear();
+	f->pak->seekg(f->offset + cursor);
+	return MA_SUCCESS;
+}
+
+static ma_result soundVfsTell(ma_vfs* pVFS, ma_vfs_file file, ma_int64* pCursor)
+{
+	SoundVFSFile* f = (SoundVFSFile*)file;
+	if (!f->pak) return ma_vfs_tell(&((SoundVFS*)pVFS)->defaultVFS, f->file, pCursor);
+	*pCursor = f->cursor;
+	return MA_SUCCESS;
+}
+
+static ma_result soundVfsInfo(ma_vfs* pVFS, ma_vfs_file file, ma_file_info* pInfo)
+{
+	SoundVFSFile* f = (SoundVFSFile*)file;
+	if (!f->pak) return ma_vfs_info(&((SoundVFS*)pVFS)->defaultVFS, f->file, pInfo);
+	pInfo->sizeInBytes = f->length;
+	return MA_SUCCESS;
+}
+
+void SoundVoiceStats::log() const
+{
+	Log("Sound voices active " << active << " virtual " << virtualised << " played " << played << " stolen " << stolen << " rejected " << rejected << std::endl);
+}
+
+void Sound::init(bool playJingle, bool nullDevice)
 {
     if (enabled || !engine.isSoundEnabled()) {
         return;
@@ -42,12 +156,35 @@ void Sound::init(bool playJingle)
 	numDoNothingFrames = 1;
 	//HRESULT hr;
 	// init minaudio high level API engine
-	result = ma_engine_init(NULL, &sound_engine);
+	sound_vfs.cb = { soundVfsOpen, soundVfsOpenW, soundVfsClose, soundVfsRead, soundVfsWrite, soundVfsSeek, soundVfsTell, soundVfsInfo };
+	ma_default_vfs_init(&sound_vfs.defaultVFS, NULL);
+	sound_vfs.files = &engine.files;
+	ma_engine_config config = ma_engine_config_init();
+	config.pResourceManagerVFS = &sound_vfs;
+	if (nullDevice) {
+		ma_backend backends[] = { ma_backend_null };
+		result = ma_context_init(backends, 1, NULL, &sound_context);
+		if (result != MA_SUCCESS) {
+			Log("Sound null device unavailable. Disabling.");
+			return;
+		}
+		nullDeviceUsed = true;
+		config.pContext = &sound_context;
+	}
+	result = ma_engine_init(&config, &sound_engine);
 	if (result != MA_SUCCESS) {
 		Log("Sound unavailable. Disabling.");
+		if (nullDeviceUsed) {
+			ma_context_uninit(&sound_context);
+			nullDeviceUsed = false;
+		}
 		return;  // Failed to initialize the engine.
 	}
 	Log("Sound initialized" << std::endl);
+	voices.resize(MAX_VOICES);
+	for (auto& v : voices) {
+		v.masound = new ma_sound;
+	}
     enabled = true;
 	if (playJingle) {
 		openSoundFile(Sound::SHADED_PATH_JINGLE_FILE, Sound::SHADED_PATH_JINGLE);
@@ -59,47 +196,80 @@ Sound::~Sound(void)
 {
 	Log("Sound d'tor" << std::endl);
 	if (!enabled) return;
-	for (auto s : sounds) {
-		ma_sound_uninit(s.second.masound);
-		delete s.second.masound;
-		s.second.masound = nullptr;
-		//if (s.second.voice) {
-		//	s.second.voice->DestroyVoice();
-		//}
-		//delete s.second.buffer.pAudioData;
+	for (auto& v : voices) {
+		if (v.active) releaseVoice(v);
+		delete v.masound;
+	}
+	for (auto& c : clips) {
+		engine.memoryTracker.untrack(c.second.get());
+		if (c.second->masound) {
+			ma_sound_uninit(c.second->masound);
+			delete c.second->masound;
+		}
 	}
 	ma_engine_uninit(&sound_engine);
+	if (nullDeviceUsed) {
+		ma_context_uninit(&sound_context);
+	}
 }
 
-void Sound::changeSound(WorldObject* wo, std::string soundId)
+void Sound::changeSound(WorldObject* wo, const std::string& soundId)
 {
 	if (!enabled) return;
-	assert(sounds.count(soundId) > 0);
-	SoundDef* sound = &sounds[soundId];
-	if (wo->playing) {
-		// TODO stop sound
+	SoundId id = findSoundId(soundId);
+	SoundDef* sound = getSoundDef(id);
+	auto it = objectVoices.find(wo);
+	if (it != objectVoices.end()) {
+		stopVoice(it->second);
 	}
 	wo->soundDef = sound;
-	playSound(soundId, SoundCategory::EFFECT);
+	glm::vec3 pos = wo->pos();
+	SoundVoiceHandle h = startVoice(id, SoundCategory::EFFECT, 1.0f, 0, 0, &pos);
+	Voice* v = getVoice(h);
+	if (v) v->wo = wo;
+	objectVoices[wo] = h;
+	wo->playing = v != nullptr;
 }
 
 void Sound::Update(Camera* camera) {
 	if (!enabled) return;
-	glm::vec3 pos(camera->getPosition());
-	glm::vec3 lookAt(camera->getLookAt());
+	Update(camera->getPosition(), camera->getLookAt());
+}
+
+void Sound::Update(const glm::vec3& pos, const glm::vec3& lookAt) {
+	if (!enabled) return;
 	// TODO do we need up vector?
 	// set listener pos
+	listenerPos = pos;
 	ma_engine_listener_set_position(&sound_engine, 0, pos.x, pos.y, pos.z);
 	ma_engine_listener_set_direction(&sound_engine, 0, lookAt.x, lookAt.y, lookAt.z);
-	// adjust sound positions
-	for (int i = 0; i < audibleWorldObjects.size(); i++) {
-		WorldObject* wo = audibleWorldObjects[i];
-		if (wo->soundDef == nullptr) {
-			continue;  // nothing to play right now
-		} else {
-			// adjust positioning
-			ma_sound_set_position(wo->soundDef->masound, wo->pos().x, wo->pos().y, wo->pos().z);
+	// adjust voice positions, only mixing voices are positioned
+	voiceStats.virtualised = 0;
+	for (auto& v : voices) {
+		if (!v.active) continue;
+		trackStreamPages(v);
+		if (v.wo) v.pos = v.wo->pos();
+		if (!v.virtualised) {
+			if (ma_sound_at_end(v.masound)) {
+				releaseVoice(v);
+				continue;
+			}
+			if (!v.positioned) continue;
+			if (!isAudible(v)) {
+				virtualiseVoice(v);
+			} else {
+				ma_sound_set_position(v.masound, v.pos.x, v.pos.y, v.pos.z);
+			}
+		} else if (isAudible(v)) {
+			if (!devirtualiseVoice(v)) continue;
+		} else if (!getSoundDef(v.sound)->loop) {
+			if (virtualCursor(v) >= getSoundDef(v.sound)->clip->frames) {
+				// finished while virtual
+				releaseVoice(v);
+				continue;
+			}
 		}
+		if (v.virtualised) voiceStats.virtualised++;
 	}
 	//Camera* cam = &xapp().camera;;
 	////HRESULT hr;
@@ -171,95 +341,403 @@ void Sound::Update(Camera* camera) {
 #define fourccDPDS 'sdpd'
 #endif
 
-void Sound::openSoundFile(std::string fileName, std::string id, bool loop)
+SoundId Sound::openSoundFile(const std::string& fileName, const std::string& id, bool loop, SoundLoadMode mode)
 {
-	if (!enabled) return;
+	SoundId soundId = soundIds.intern(id);
+	if (!enabled) return soundId;
 	//if (engine.isRendering()) {
 	//	Log("WARNING: do not load sound files during rendering!");
 	//}
+	// look in pak file first:
 	std::string binFile;
-	binFile = engine.files.findFile(fileName.c_str(), FileCategory::SOUND);
-	SoundDef sd{};
-	if (sounds.count(id) == 0) {
-		//ZeroMemory(&sd, sizeof(sd));
+	if (engine.files.findFileInPak(fileName) != nullptr) {
+		binFile = PAK_PREFIX + fileName;
 	} else {
-		sd = sounds[id];
+		binFile = engine.files.findFile(fileName.c_str(), FileCategory::SOUND);
+	}
+	SoundClip* clip = loadClip(binFile, mode);
+	SoundDef& sd = sounds[id];
+	SoundClip* oldClip = sd.clip;
+	if (oldClip != nullptr) {
+		// voices play the old clip: stop them before it is replaced
+		for (auto& v : voices) {
+			if (v.active && v.sound == soundId) releaseVoice(v);
+		}
+		oldClip->refs--;
 	}
 	sd.loop = loop;
-	sounds[id] = sd;
-	ma_sound *m = new ma_sound;
-	sounds[id].masound = m;
-	auto mas = sounds[id].masound; // mas is a ptr
-	result = ma_sound_init_from_file(&sound_engine, binFile.c_str(), NULL, NULL, NULL, mas);
-	if (result != MA_SUCCESS) {
-		Error("Could not load sound");
+	sd.clip = clip;
+	clip->refs++;
+	if (oldClip != nullptr && oldClip != clip && oldClip->refs == 0) {
+		releaseClip(oldClip);
 	}
-	return;
+	if (soundId.value >= soundById.size()) {
+		soundById.resize(soundId.value + 1, nullptr);
+	}
+	soundById[soundId.value] = &sd;
+	return soundId;
 }
 
-void Sound::playSound(std::string id, SoundCategory category, float volume, uint32_t delayMS) {
-	if (!enabled) return;
-	//result = ma_engine_play_sound(&sound_engine, "C:\\\\dev\\vulkan\\data\\sound\\Free_Test_Data_100KB_OGG.ogg", NULL);
-	//if (result != MA_SUCCESS) {
-	//	Log("Cannot play sound " << result << std::endl);
-	//}
-	assert(sounds.count(id) > 0);
-	SoundDef *sound = &sounds[id];
+SoundClip* Sound::loadClip(const std::string& path, SoundLoadMode mode)
+{
+	auto it = clips.find(path);
+	if (it != clips.end()) {
+		// first load decided decode or stream
+		return it->second.get();
+	}
+	auto start = std::chrono::high_resolution_clock::now();
+	auto clip = std::make_unique<SoundClip>();
+	clip->path = path;
+	if (mode != SoundLoadMode::DECODE) {
+		// size in the format the resource manager decodes to, without decoding
+		ma_decoder_config config = ma_decoder_config_init(ma_format_f32, 0, ma_engine_get_sample_rate(&sound_engine));
+		ma_decoder decoder;
+		if (ma_decoder_init_vfs(&sound_vfs, path.c_str(), &config, &decoder) != MA_SUCCESS) {
+			Error("Could not load sound");
+		}
+		ma_uint64 frames = 0;
+		ma_decoder_get_data_format(&decoder, NULL, &clip->channels, &clip->sampleRate, NULL, 0);
+		ma_decoder_get_length_in_pcm_frames(&decoder, &frames);
+		ma_decoder_uninit(&decoder);
+		clip->frames = frames;
+		size_t decodedSize = static_cast<size_t>(clip->frames) * clip->channels * sizeof(float);
+		clip->streamed = mode == SoundLoadMode::STREAM || decodedSize > STREAM_DECODED_SIZE;
+	}
+	if (clip->streamed) {
+		// each voice decodes into two pages, same size as allocated by the resource manager
+		clip->memoryBytes = 2 * static_cast<size_t>(MA_RESOURCE_MANAGER_PAGE_SIZE_IN_MILLISECONDS * (clip->sampleRate / 1000)) * clip->channels * sizeof(float);
+	} else {
+		clip->masound = new ma_sound;
+		result = ma_sound_init_from_file(&sound_engine, path.c_str(), MA_SOUND_FLAG_DECODE, NULL, NULL, clip->masound);
+		if (result != MA_SUCCESS) {
+			Error("Could not load sound");
+		}
+		ma_format format;
+		ma_uint64 frames = 0;
+		ma_sound_get_data_format(clip->masound, &format, &clip->channels, &clip->sampleRate, NULL, 0);
+		ma_sound_get_length_in_pcm_frames(clip->masound, &frames);
+		clip->frames = frames;
+		clip->memoryBytes = static_cast<size_t>(clip->frames) * clip->channels * ma_get_bytes_per_sample(format);
+		engine.memoryTracker.track(clip.get(), MemoryTag::Audio, MemoryDomain::Host, clip->memoryBytes);
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	clip->loadMS = std::chrono::duration<float, std::milli>(end - start).count();
+	SoundClip* c = clip.get();
+	clips[path] = std::move(clip);
+	return c;
+}
+
+void Sound::releaseClip(SoundClip* clip)
+{
+	engine.memoryTracker.untrack(clip);
+	if (clip->masound) {
+		ma_sound_uninit(clip->masound);
+		delete clip->masound;
+	}
+	std::string path = clip->path; // clip is deleted by erase()
+	clips.erase(path);
+}
+
+size_t Sound::getDecodedMemory() const
+{
+	size_t bytes = 0;
+	for (auto& c : clips) {
+		if (!c.second->streamed) bytes += c.second->memoryBytes;
+	}
+	return bytes;
+}
+
+size_t Sound::getStreamingMemory() const
+{
+	size_t bytes = 0;
+	for (auto& v : voices) {
+		if (v.active) bytes += v.streamPageBytes;
+	}
+	return bytes;
+}
+
+void Sound::logClipMemory() const
+{
+	for (auto& c : clips) {
+		const SoundClip& clip = *c.second;
+		Log("Sound clip " << clip.path << (clip.streamed ? " streamed, per voice " : " decoded ") << clip.memoryBytes / 1024 << " KB, "
+			<< clip.refs << " ids, loaded in " << clip.loadMS << " ms" << std::endl);
+	}
+	Log("Sound clips " << clips.size() << " decoded " << getDecodedMemory() / 1024 << " KB streaming " << getStreamingMemory() / 1024 << " KB" << std::endl);
+}
+
+SoundVoiceHandle Sound::playSound(const std::string& id, SoundCategory category, float volume, uint32_t delayMS, int priority) {
+	if (!enabled) return SoundVoiceHandle();
+	return playSound(findSoundId(id), category, volume, delayMS, priority);
+}
+
+SoundVoiceHandle Sound::playSound(SoundId id, SoundCategory category, float volume, uint32_t delayMS, int priority) {
+	if (!enabled) return SoundVoiceHandle();
+	return startVoice(id, category, volume, delayMS, priority, nullptr);
+}
+
+SoundVoiceHandle Sound::playSoundAt(SoundId id, const glm::vec3& pos, float volume, uint32_t delayMS, int priority) {
+	if (!enabled) return SoundVoiceHandle();
+	return startVoice(id, SoundCategory::EFFECT, volume, delayMS, priority, &pos);
+}
+
+SoundVoiceHandle Sound::startVoice(SoundId id, SoundCategory category, float volume, uint32_t delayMS, int priority, const glm::vec3* pos) {
+	SoundDef *sound = getSoundDef(id);
 	sound->category = category;
-	// Check if the sound is already playing
-	if (ma_sound_is_playing(sound->masound)) {
-		// Seek to the beginning of the sound
-		ma_sound_seek_to_pcm_frame(sound->masound, 0);
-		return;
-
-		//ma_result result = ma_sound_stop(sound->masound);
-		//if (result != MA_SUCCESS) {
-		//	Log("Cannot stop sound, error code: " << result << std::endl);
-		//}
-		//else {
-		//	Log("sound stopped\n");
-		//}
+	Voice* v = allocateVoice(id, priority);
+	if (v == nullptr) {
+		return SoundVoiceHandle();
+	}
+	SoundClip* clip = sound->clip;
+	ma_result result;
+	if (clip->streamed) {
+		// own stream per voice, first pages are decoded by the resource manager job thread
+		result = ma_sound_init_from_file(&sound_engine, clip->path.c_str(), MA_SOUND_FLAG_STREAM | MA_SOUND_FLAG_ASYNC, NULL, NULL, v->masound);
+	} else {
+		// copy shares the decoded data of the clip, only the cursor is new
+		result = ma_sound_init_copy(&sound_engine, clip->masound, 0, NULL, v->masound);
+	}
+	if (result != MA_SUCCESS) {
+		Log("Cannot create sound voice, error code: " << result << std::endl);
+		return SoundVoiceHandle();
 	}
+	v->active = true;
+	v->sound = id;
+	v->generation++;
+	v->priority = priority;
+	v->volume = volume;
+	v->positioned = pos != nullptr;
+	v->pos = pos ? *pos : glm::vec3(0.0f);
+	v->wo = nullptr;
+	v->virtualised = false;
+	v->startOrder = ++voiceStartCounter;
+	v->sampleRate = clip->sampleRate;
+	// usually still loading, then tracked by a later Update()
+	trackStreamPages(*v);
 	if (sound->loop) {
-		ma_sound_set_looping(sound->masound, true);
+		ma_sound_set_looping(v->masound, true);
 	}
+	v->startTime = ma_engine_get_time(&sound_engine);
 	if (delayMS > 0) {
 		uint32_t delaySamples = ma_engine_get_sample_rate(&sound_engine) * delayMS / 1000;
-		ma_sound_set_start_time_in_pcm_frames(sound->masound, ma_engine_get_time(&sound_engine) + delaySamples);
+		v->startTime += delaySamples;
+		ma_sound_set_start_time_in_pcm_frames(v->masound, v->startTime);
 	}
 	if (category == MUSIC) {
-		ma_sound_set_spatialization_enabled(sound->masound, false);
+		ma_sound_set_spatialization_enabled(v->masound, false);
+	} else {
+		ma_sound_set_rolloff(v->masound, sound->rolloff);
+		ma_sound_set_position(v->masound, v->pos.x, v->pos.y, v->pos.z);
+	}
+    ma_sound_set_volume(v->masound, volume);
+	voiceStats.played++;
+	voiceStats.active++;
+	SoundVoiceHandle h{ static_cast<uint32_t>(v - voices.data()), v->generation };
+	if (v->positioned && !isAudible(*v)) {
+		// start virtual, never mixed until the listener comes near
+		v->virtualised = true;
+		v->virtualCursor = 0;
+		v->virtualSince = v->startTime;
+		return h;
 	}
-    ma_sound_set_volume(sound->masound, volume);
-	ma_result result = ma_sound_start(sound->masound);
+	result = ma_sound_start(v->masound);
 	if (result != MA_SUCCESS) {
 		Log("Cannot play sound, error code: " << result << std::endl);
+	}
+	return h;
+}
+
+Sound::Voice* Sound::allocateVoice(SoundId id, int priority)
+{
+	SoundDef* sound = getSoundDef(id);
+	bool soundLimit = getActiveVoiceCount(id) >= sound->maxVoices;
+	if (!soundLimit) {
+		for (auto& v : voices) {
+			if (!v.active) return &v;
+		}
+	}
+	// steal from this sound if it reached its limit, otherwise from all sounds
+	Voice* victim = nullptr;
+	for (auto& v : voices) {
+		if (!v.active || (soundLimit && !(v.sound == id))) continue;
+		if (victim == nullptr || v.priority < victim->priority) {
+			victim = &v;
+		} else if (v.priority == victim->priority) {
+			// prefer virtual (inaudible) voices, then the oldest
+			if (v.virtualised != victim->virtualised) {
+				if (v.virtualised) victim = &v;
+			} else if (v.startOrder < victim->startOrder) {
+				victim = &v;
+			}
+		}
+	}
+	if (victim == nullptr || victim->priority > priority) {
+		voiceStats.rejected++;
+		return nullptr;
+	}
+	voiceStats.stolen++;
+	releaseVoice(*victim);
+	return victim;
+}
+
+void Sound::trackStreamPages(Voice& v)
+{
+	if (v.streamPages || !getSoundDef(v.sound)->clip->streamed) return;
+	ma_resource_manager_data_stream* stream = &v.masound->pResourceManagerDataSource->backend.stream;
+	if (ma_resource_manager_data_stream_result(stream) != MA_SUCCESS || stream->pPageData == nullptr) return;
+	const ma_decoder& decoder = stream->decoder;
+	// two pages, as allocated by the resource manager stream load job
+	v.streamPageBytes = 2 * static_cast<size_t>(MA_RESOURCE_MANAGER_PAGE_SIZE_IN_MILLISECONDS * (decoder.outputSampleRate / 1000))
+		* ma_get_bytes_per_frame(decoder.outputFormat, decoder.outputChannels);
+	v.streamPages = stream->pPageData;
+	engine.memoryTracker.track(v.streamPages, MemoryTag::Audio, MemoryDomain::Host, v.streamPageBytes);
+}
+
+void Sound::releaseVoice(Voice& v)
+{
+	if (v.streamPages) {
+		engine.memoryTracker.untrack(v.streamPages);
+		v.streamPages = nullptr;
+		v.streamPageBytes = 0;
+	}
+	ma_sound_uninit(v.masound);
+	v.active = false;
+	v.virtualised = false;
+	v.wo = nullptr;
+	voiceStats.active--;
+}
+
+uint64_t Sound::virtualCursor(const Voice& v)
+{
+	uint64_t now = ma_engine_get_time(&sound_engine);
+	// delayed voices do not advance before their start time
+	uint64_t from = std::max(v.virtualSince, v.startTime);
+	uint64_t elapsed = now > from ? now - from : 0;
+	return v.virtualCursor + elapsed * v.sampleRate / ma_engine_get_sample_rate(&sound_engine);
+}
+
+void Sound::virtualiseVoice(Voice& v)
+{
+	ma_uint64 cursor = 0;
+	ma_sound_get_cursor_in_pcm_frames(v.masound, &cursor);
+	v.virtualCursor = cursor;
+	v.virtualSince = ma_engine_get_time(&sound_engine);
+	ma_sound_stop(v.masound);
+	v.virtualised = true;
+}
+
+bool Sound::devirtualiseVoice(Voice& v)
+{
+	uint64_t cursor = virtualCursor(v);
+	uint64_t length = getSoundDef(v.sound)->clip->frames;
+	if (length > 0 && cursor >= length) {
+		if (!getSoundDef(v.sound)->loop) {
+			releaseVoice(v);
+			return false;
+		}
+		cursor %= length;
+	}
+	// stopped voices are not read by the mixing thread: seek the data source directly,
+	// ma_sound_seek_to_pcm_frame() would defer the seek until the voice is mixed again
+	ma_data_source_seek_to_pcm_frame(v.masound->pDataSource, cursor);
+	ma_sound_set_position(v.masound, v.pos.x, v.pos.y, v.pos.z);
+	uint64_t now = ma_engine_get_time(&sound_engine);
+	ma_sound_set_start_time_in_pcm_frames(v.masound, std::max(now, v.startTime));
+	ma_sound_start(v.masound);
+	v.virtualised = false;
+	return true;
+}
+
+bool Sound::isAudible(const Voice& v)
+{
+	SoundDef* sound = getSoundDef(v.sound);
+	float d = glm::distance(v.pos, listenerPos);
+	if (d > sound->maxDistance) return false;
+	// miniaudio default inverse distance model with min distance 1
+	float attenuation = d <= 1.0f ? 1.0f : 1.0f / (1.0f + sound->rolloff * (d - 1.0f));
+	return v.volume * attenuation >= INAUDIBLE_GAIN;
+}
+
+void Sound::stopVoice(SoundVoiceHandle voice)
+{
+	if (!enabled) return;
+	Voice* v = getVoice(voice);
+	if (v == nullptr) return;
+	if (!v->virtualised) ma_sound_stop(v->masound);
+	releaseVoice(*v);
+}
+
+void Sound::setVoicePosition(SoundVoiceHandle voice, const glm::vec3& pos)
+{
+	if (!enabled) return;
+	Voice* v = getVoice(voice);
+	if (v == nullptr) return;
+	// applied to miniaudio in next Update()
+	v->pos = pos;
+}
+
+void Sound::test_advanceTime(float seconds)
+{
+	if (!enabled) return;
+	// a running device would advance engine time on its own
+	ma_engine_stop(&sound_engine);
+	uint64_t frames = static_cast<uint64_t>(static_cast<double>(seconds) * ma_engine_get_sample_rate(&sound_engine));
+	ma_engine_set_time(&sound_engine, ma_engine_get_time(&sound_engine) + frames);
+}
+
+float Sound::getVoiceTime(SoundVoiceHandle voice)
+{
+	if (!enabled) return 0.0f;
+	Voice* v = getVoice(voice);
+	if (v == nullptr || v->sampleRate == 0) return 0.0f;
+	uint64_t cursor;
+	if (v->virtualised) {
+		cursor = virtualCursor(*v);
+		uint64_t length = getSoundDef(v->sound)->clip->frames;
+		if (length > 0 && getSoundDef(v->sound)->loop) cursor %= length;
 	} else {
-		//Log("Playing sound " << id << std::endl);
-	}
-	//XAUDIO2_VOICE_SENDS *sendsList = category == MUSIC ? sfxSendsListMusic : sfxSendsListEffect;
-	//hr = xaudio2->CreateSourceVoice(&sound->voice, (WAVEFORMATEX*)&sound->wfx, 0, XAUDIO2_DEFAULT_FREQ_RATIO, nullptr, sendsList, nullptr);
-	//ThrowIfFailed(hr);
-	//hr = sound->voice->SubmitSourceBuffer(&sound->buffer);
-	//ThrowIfFailed(hr);
-	//sound->voice->SetVolume(volume); // TODO cleanup
-	//hr = sound->voice->Start(0);
-	//float current_volume;
-	//sound->voice->GetVolume(&current_volume);
-	if (category == MUSIC) {
-		//sound->voice->SetVolume(current_volume/15.0f); // TODO cleanup
+		ma_uint64 c = 0;
+		ma_sound_get_cursor_in_pcm_frames(v->masound, &c);
+		cursor = c;
+	}
+	return static_cast<float>(static_cast<double>(cursor) / v->sampleRate);
+}
+
+float Sound::getSoundLength(SoundId id)
+{
+	if (!enabled) return 0.0f;
+	const SoundClip* clip = getSoundDef(id)->clip;
+	return clip->sampleRate == 0 ? 0.0f : static_cast<float>(static_cast<double>(clip->frames) / clip->sampleRate);
+}
+
+uint32_t Sound::getActiveVoiceCount(SoundId id) const
+{
+	uint32_t count = 0;
+	for (auto& v : voices) {
+		if (v.active && v.sound == id) count++;
 	}
-	//ThrowIfFailed(hr);
+	return count;
+}
+
+void Sound::setMaxVoices(SoundId id, uint32_t maxVoices)
+{
+	if (!enabled) return;
+	getSoundDef(id)->maxVoices = maxVoices;
+}
+
+void Sound::setMaxDistance(SoundId id, float maxDistance)
+{
+	if (!enabled) return;
+	getSoundDef(id)->maxDistance = maxDistance;
 }
 
-void Sound::setSoundRolloff(std::string id, float rolloff)
+void Sound::setSoundRolloff(const std::string& id, float rolloff)
 {
 	if (!enabled) return;
-	assert(sounds.count(id) > 0);
-	SoundDef* sound = &sounds[id];
-	ma_sound_set_rolloff(sound->masound, rolloff);
-	float rlf = ma_sound_get_rolloff(sound->masound);
-	Log("Sound rolloff " << rlf << std::endl);
+	SoundDef* sound = getSoundDef(findSoundId(id));
+	// used by voices started from now on
+	sound->rolloff = rolloff;
+	Log("Sound rolloff " << rolloff << std::endl);
 }
 
 void Sound::lowBackgroundMusicVolume(bool volumeDown) {
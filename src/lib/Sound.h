@@ -1,50 +1,211 @@
 #pragma once
 class WorldObject;
 
+// Sounds are played by voices: every playSound() call gets its own instance of the loaded sound,
+// so rapid calls (e.g. gun shots) overlap instead of restarting each other.
+// The voice pool has MAX_VOICES slots, each sound may use up to SoundDef::maxVoices of them.
+// If no slot is left the voice with lowest priority (then virtual before mixing, then oldest) is stolen,
+// a new voice with lower priority than all candidates is rejected.
+// Positioned voices farther than SoundDef::maxDistance from the listener or with estimated gain below
+// INAUDIBLE_GAIN are virtualised: they are stopped and no longer mixed or positioned, but their playback
+// position keeps running on the engine clock. When they become audible again they resume at that position.
+// Sound files are loaded once as clips, shared by all sound ids opened from the same file. Short clips are decoded
+// to memory once and all voices play copies of the decoded data. Long clips (decoded size above
+// STREAM_DECODED_SIZE) are streamed: every voice decodes its own small page buffer from disk or data.pak.
+
 enum SoundCategory { MUSIC, EFFECT };
 
+enum class SoundLoadMode { AUTO, DECODE, STREAM };
+
 // miniaudio forward declaration:
 struct ma_sound;
 
+// one loaded sound file, shared by all sound ids opened from it
+struct SoundClip {
+	std::string path; // file path, or pak: prefix and name in data.pak
+	bool streamed = false;
+	uint32_t refs = 0; // sound ids using this clip
+	uint64_t frames = 0; // length at engine sample rate
+	uint32_t channels = 0;
+	uint32_t sampleRate = 0;
+	size_t memoryBytes = 0; // decoded data, for streamed clips the page buffer of one voice
+	float loadMS = 0.0f;
+	// miniaudio entries:
+	ma_sound* masound = nullptr; // decoded sound, never played. Voices are copies sharing its data. nullptr if streamed
+};
+
 struct SoundDef {
 	bool loop = false;
 	SoundCategory category = SoundCategory::MUSIC;
-	// miniaudio entries:
-	ma_sound* masound = nullptr;
+	uint32_t maxVoices = 4; // concurrent instances of this sound
+	float maxDistance = 500.0f; // positioned voices farther away are virtualised
+	float rolloff = 1.0f;
+	SoundClip* clip = nullptr;
+};
+
+struct SoundVoiceHandle {
+	static constexpr uint32_t INVALID_INDEX = UINT32_MAX;
+	uint32_t index = INVALID_INDEX;
+	uint32_t generation = 0;
+	bool isValid() const {
+		return index != INVALID_INDEX;
+	}
+	bool operator==(const SoundVoiceHandle& other) const {
+		return index == other.index && generation == other.generation;
+	}
 };
 
+struct SoundVoiceStats {
+	uint32_t active = 0; // voices in use, mixing or virtual
+	uint32_t virtualised = 0; // currently virtual voices
+	uint64_t played = 0;
+	uint64_t stolen = 0;
+	uint64_t rejected = 0;
+	void log() const;
+};
 
 class Sound
 {
 public:
+	static constexpr uint32_t MAX_VOICES = 64;
+	// voices with lower estimated gain (volume and distance attenuation) are virtualised
+	static constexpr float INAUDIBLE_GAIN = 0.001f;
+	// clips with larger decoded size are streamed in SoundLoadMode::AUTO, about 11 s of 48 kHz stereo
+	static constexpr size_t STREAM_DECODED_SIZE = 4 * 1024 * 1024;
+	// path prefix for clips read from data.pak
+	inline static const std::string PAK_PREFIX = "pak:";
+
 	Sound(ShadedPathEngine& s) : engine(s) {
 		Log("Sound c'tor\n");
 	}
 	~Sound(void);
-	void init(bool playJingle = true);
+	// nullDevice: mix without audio output, e.g. for tests and headless runs
+	void init(bool playJingle = true, bool nullDevice = false);
 	void addWorldObject(WorldObject* wo);
 	std::unordered_map<std::string, SoundDef> sounds;
 	// engine jingle:
 	inline static const std::string SHADED_PATH_JINGLE_FILE = "shaded_path_jingle.ogg";
 	inline static const std::string SHADED_PATH_JINGLE = "shaded_path_jingle";
 private:
+	struct Voice {
+		ma_sound* masound = nullptr;
+		SoundId sound;
+		uint32_t generation = 0;
+		bool active = false;
+		bool positioned = false; // spatialized voice with world position, only these are virtualised
+		bool virtualised = false;
+		int priority = 0;
+		float volume = 1.0f;
+		glm::vec3 pos = glm::vec3(0.0f);
+		WorldObject* wo = nullptr; // if set, voice follows object position
+		uint32_t sampleRate = 0; // of the sound data
+		uint64_t startOrder = 0;
+		uint64_t startTime = 0; // engine time, later than start of playSound() for delayed voices
+		uint64_t virtualCursor = 0; // pcm frame (sound rate) when virtualised
+		uint64_t virtualSince = 0; // engine time when virtualised
+		void* streamPages = nullptr; // page buffer of a streamed voice, tracked once the stream job allocated it
+		size_t streamPageBytes = 0;
+	};
 	std::wstring project_filename;
 	std::vector<WorldObject*> audibleWorldObjects;  // index used instead of passing WorldObject down to sound class
+	InternTable<SoundId> soundIds;
+	std::vector<SoundDef*> soundById; // indexed by SoundId, pointers into sounds
+	SoundDef* getSoundDef(SoundId id) {
+		assert(id.value < soundById.size() && soundById[id.value] != nullptr);
+		return soundById[id.value];
+	}
+	// clip cache by path
+	std::unordered_map<std::string, std::unique_ptr<SoundClip>> clips;
+	SoundClip* loadClip(const std::string& path, SoundLoadMode mode);
+	// remove clip without sound ids from cache
+	void releaseClip(SoundClip* clip);
+	std::vector<Voice> voices; // MAX_VOICES slots
+	std::unordered_map<WorldObject*, SoundVoiceHandle> objectVoices; // voice started by changeSound()
+	uint64_t voiceStartCounter = 0;
+	SoundVoiceStats voiceStats;
+	Voice* getVoice(SoundVoiceHandle h) {
+		if (!h.isValid() || h.index >= voices.size()) return nullptr;
+		Voice& v = voices[h.index];
+		return (v.active && v.generation == h.generation) ? &v : nullptr;
+	}
+	glm::vec3 listenerPos = glm::vec3(0.0f);
+	SoundVoiceHandle startVoice(SoundId id, SoundCategory category, float volume, uint32_t delayMS, int priority, const glm::vec3* pos);
+	// free slot or stolen voice, nullptr if rejected
+	Voice* allocateVoice(SoundId id, int priority);
+	void releaseVoice(Voice& v);
+	// track page buffer of streamed voice in memory tracker, once it is allocated by the resource manager job thread
+	void trackStreamPages(Voice& v);
+	void virtualiseVoice(Voice& v);
+	// false if the voice ran out while virtual and was released
+	bool devirtualiseVoice(Voice& v);
+	// pcm frame (sound sample rate) a virtual voice would play now, may be beyond the end for non looping sounds
+	uint64_t virtualCursor(const Voice& v);
+	bool isAudible(const Voice& v);
 
 	int numDoNothingFrames = 0;
 	bool recalculateSound();
 	ShadedPathEngine& engine;
 	// only run methods if initialized - immediately return otherwise
 	bool initialized = false;
+	bool nullDeviceUsed = false;
 public:
 	// update sounds with respect to world position
 	void Update(Camera* camera);
-	void openSoundFile(std::string soundFileName, std::string id, bool loop = false);
-    // play sound with possible delay (in ms) and volume. If sound is already playing, it will be restarted
-	void playSound(std::string id, SoundCategory category = EFFECT, float volume = 1.0f, uint32_t delayMS = 0);
+	void Update(const glm::vec3& listenerPos, const glm::vec3& lookAt);
+	// returned id can be used instead of the name for playing the sound.
+	// The file is looked up in data.pak first. Opening an already loaded file only references its clip
+	SoundId openSoundFile(const std::string& soundFileName, const std::string& id, bool loop = false, SoundLoadMode mode = SoundLoadMode::AUTO);
+	// invalid id if no sound file was opened with this name
+	SoundId findSoundId(std::string_view id) const {
+		return soundIds.find(id);
+	}
+	// play sound with possible delay (in ms) and volume in a new voice. Already playing voices of this sound continue.
+	// Invalid handle if the voice was rejected (all candidate voices have higher priority)
+	SoundVoiceHandle playSound(const std::string& id, SoundCategory category = EFFECT, float volume = 1.0f, uint32_t delayMS = 0, int priority = 0);
+	SoundVoiceHandle playSound(SoundId id, SoundCategory category = EFFECT, float volume = 1.0f, uint32_t delayMS = 0, int priority = 0);
+	// play effect at world position, virtualised while out of range
+	SoundVoiceHandle playSoundAt(SoundId id, const glm::vec3& pos, float volume = 1.0f, uint32_t delayMS = 0, int priority = 0);
+	void stopVoice(SoundVoiceHandle voice);
+	void setVoicePosition(SoundVoiceHandle voice, const glm::vec3& pos);
+	// false if the voice finished, was stopped or stolen
+	bool isVoiceActive(SoundVoiceHandle voice) {
+		return getVoice(voice) != nullptr;
+	}
+	bool isVoiceVirtual(SoundVoiceHandle voice) {
+		Voice* v = getVoice(voice);
+		return v != nullptr && v->virtualised;
+	}
+	// playback position in seconds, also running for virtual voices
+	float getVoiceTime(SoundVoiceHandle voice);
+	// length in seconds
+	float getSoundLength(SoundId id);
+	const SoundClip* getClip(SoundId id) {
+		return getSoundDef(id)->clip;
+	}
+	size_t getClipCount() const {
+		return clips.size();
+	}
+	// memory of decoded clips
+	size_t getDecodedMemory() const;
+	// page buffers of active streamed voices
+	size_t getStreamingMemory() const;
+	// memory and load time per clip
+	void logClipMemory() const;
+	// voices in use by this sound
+	uint32_t getActiveVoiceCount(SoundId id) const;
+	const SoundVoiceStats& getVoiceStats() const {
+		return voiceStats;
+	}
+	// limit concurrent voices of this sound, default is 4
+	void setMaxVoices(SoundId id, uint32_t maxVoices);
+	// positioned voices farther away are virtualised
+	void setMaxDistance(SoundId id, float maxDistance);
+	// do not use - test helper method: stops mixing and moves engine time forward, virtual voices advance with it
+	void test_advanceTime(float seconds);
     // set rolloff to modify how sound fades with distance. default value is 1.0f
-    void setSoundRolloff(std::string id, float rolloff);
+    void setSoundRolloff(const std::string& id, float rolloff);
 	void lowBackgroundMusicVolume(bool volumeDown = true);
-	void changeSound(WorldObject* wo, std::string soundId);
+	// stop voice started by last changeSound() for this object and play sound following the object
+	void changeSound(WorldObject* wo, const std::string& soundId);
     bool enabled = false;
 };
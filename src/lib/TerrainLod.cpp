@@ -0,0 +1,349 @@
+#include "mainheader.h"
+
+using namespace std;
+using namespace glm;
+
+void TerrainLodStats::log() const
+{
+	Log("Terrain LOD: selected " << selected << " culled " << culled << " chunks built " << chunksBuilt
+		<< " evicted " << chunksEvicted << " uploaded bytes " << uploadedBytes << endl);
+}
+
+static bool isPowerOfTwo(int n)
+{
+	return n > 0 && (n & (n - 1)) == 0;
+}
+
+static bool boxIntersectsSphere(const vec3& min, const vec3& max, const vec3& center, float radius)
+{
+	vec3 d = glm::max(glm::max(min - center, center - max), vec3(0.0f));
+	return dot(d, d) <= radius * radius;
+}
+
+void TerrainLod::init(std::vector<float> h, int s, float minCoord, float maxCoord, const TerrainLodSettings& set)
+{
+	settings = set;
+	int cells = s - 1;
+	int chunk = settings.chunkCells;
+	if (chunk < 2 || !isPowerOfTwo(chunk)) {
+		Error("TerrainLod: chunk cells has to be a power of 2");
+	}
+	if (s < 2 || h.size() != static_cast<size_t>(s) * s || cells % chunk != 0 || !isPowerOfTwo(cells / chunk)) {
+		Error("TerrainLod: heightmap needs chunkCells * 2^n + 1 samples per edge");
+	}
+	heights = std::move(h);
+	samples = s;
+	minXZ = minCoord;
+	cellSize = (maxCoord - minCoord) / cells;
+
+	// levels and nodes, level 0 has one node per chunk
+	levels.clear();
+	nodes.clear();
+	for (int n = cells / chunk, step = 1; n >= 1; n /= 2, step *= 2) {
+		Level l;
+		l.nodesPerEdge = n;
+		l.step = step;
+		l.firstNode = static_cast<uint32_t>(nodes.size());
+		int level = static_cast<int>(levels.size());
+		for (int z = 0; z < n; z++) {
+			for (int x = 0; x < n; x++) {
+				nodes.push_back(NodeData{ 0.0f, 0.0f, level, x, z });
+			}
+		}
+		levels.push_back(l);
+	}
+	// height bounds, sample rows on node borders belong to both nodes
+	for (int z = 0; z < levels[0].nodesPerEdge; z++) {
+		for (int x = 0; x < levels[0].nodesPerEdge; x++) {
+			NodeData& n = nodes[getNodeIndex(0, x, z)];
+			n.minY = numeric_limits<float>::max();
+			n.maxY = -numeric_limits<float>::max();
+			for (int fz = z * chunk; fz <= (z + 1) * chunk; fz++) {
+				for (int fx = x * chunk; fx <= (x + 1) * chunk; fx++) {
+					n.minY = std::min(n.minY, heightAt(fx, fz));
+					n.maxY = std::max(n.maxY, heightAt(fx, fz));
+				}
+			}
+		}
+	}
+	for (int level = 1; level < getLevelCount(); level++) {
+		for (int z = 0; z < levels[level].nodesPerEdge; z++) {
+			for (int x = 0; x < levels[level].nodesPerEdge; x++) {
+				NodeData& n = nodes[getNodeIndex(level, x, z)];
+				n.minY = numeric_limits<float>::max();
+				n.maxY = -numeric_limits<float>::max();
+				for (int c = 0; c < 4; c++) {
+					const NodeData& child = nodes[getNodeIndex(level - 1, 2 * x + (c & 1), 2 * z + (c >> 1))];
+					n.minY = std::min(n.minY, child.minY);
+					n.maxY = std::max(n.maxY, child.maxY);
+				}
+			}
+		}
+	}
+	calculateErrors();
+	calculateRanges();
+
+	// shared chunk topology, quadrant by quadrant
+	chunkIndices.clear();
+	chunkIndices.reserve(static_cast<size_t>(chunk) * chunk * 6);
+	int half = chunk / 2;
+	uint32_t rowLength = chunk + 1;
+	for (int q = 0; q < 4; q++) {
+		int x0 = (q & 1) * half, z0 = (q >> 1) * half;
+		for (int z = z0; z < z0 + half; z++) {
+			for (int x = x0; x < x0 + half; x++) {
+				uint32_t i0 = z * rowLength + x;
+				uint32_t i1 = i0 + 1;
+				uint32_t i2 = i0 + rowLength;
+				uint32_t i3 = i2 + 1;
+				chunkIndices.insert(chunkIndices.end(), { i0, i2, i1, i1, i2, i3 });
+			}
+		}
+	}
+
+	selection.clear();
+	slotNode.assign(settings.cacheSlots, UINT32_MAX);
+	slotLastUsed.assign(settings.cacheSlots, 0);
+	nodeSlot.clear();
+	frame = 0;
+	storageReserved = false;
+	Log("Terrain LOD: " << samples << " x " << samples << " heightmap, " << getLevelCount() << " levels, " << nodes.size() << " nodes" << endl);
+}
+
+void TerrainLod::initFromWorld(World& world, int s, const TerrainLodSettings& set)
+{
+	float maxCoord = world.getWorldSize().x / 2.0f;
+	float minCoord = -maxCoord;
+	float step = (maxCoord - minCoord) / (s - 1);
+	vector<float> h(static_cast<size_t>(s) * s);
+	for (int z = 0; z < s; z++) {
+		float wz = std::min(minCoord + z * step, maxCoord);
+		for (int x = 0; x < s; x++) {
+			float wx = std::min(minCoord + x * step, maxCoord);
+			h[static_cast<size_t>(z) * s + x] = world.getHeightmapValue(wx, wz);
+		}
+	}
+	init(std::move(h), s, minCoord, maxCoord, set);
+}
+
+// max deviation of each level's vertex grid from the full resolution heights, using bilinear interpolation
+void TerrainLod::calculateErrors()
+{
+	int cells = samples - 1;
+	levels[0].error = 0.0f;
+	for (int level = 1; level < getLevelCount(); level++) {
+		int step = levels[level].step;
+		float inv = 1.0f / step;
+		float error = 0.0f;
+		for (int fz = 0; fz <= cells; fz++) {
+			int z0 = std::min((fz / step) * step, cells - step);
+			float v = (fz - z0) * inv;
+			for (int fx = 0; fx <= cells; fx++) {
+				int x0 = std::min((fx / step) * step, cells - step);
+				float u = (fx - x0) * inv;
+				float h0 = heightAt(x0, z0) + (heightAt(x0 + step, z0) - heightAt(x0, z0)) * u;
+				float h1 = heightAt(x0, z0 + step) + (heightAt(x0 + step, z0 + step) - heightAt(x0, z0 + step)) * u;
+				error = std::max(error, abs(heightAt(fx, fz) - (h0 + (h1 - h0) * v)));
+			}
+		}
+		levels[level].error = std::max(error, levels[level - 1].error);
+	}
+}
+
+// range of each level: at least double the previous one, and far enough that the next coarser level
+// does not exceed the allowed screen error. The top level covers everything
+void TerrainLod::calculateRanges()
+{
+	float chunkSize = settings.chunkCells * cellSize;
+	float pixelsPerUnit = settings.viewportHeight / (2.0f * tan(settings.fovY * 0.5f));
+	float range = settings.leafRange > 0.0f ? settings.leafRange : 2.5f * chunkSize;
+	for (int level = 0; level < getLevelCount(); level++) {
+		if (level > 0) {
+			range = 2.0f * levels[level - 1].range;
+		}
+		if (level + 1 < getLevelCount()) {
+			range = std::max(range, levels[level + 1].error * pixelsPerUnit / settings.maxPixelError);
+		} else {
+			range = numeric_limits<float>::max();
+		}
+		levels[level].range = range;
+	}
+}
+
+void TerrainLod::getNodeBounds(int level, int x, int z, glm::vec3& min, glm::vec3& max) const
+{
+	const NodeData& n = nodes[getNodeIndex(level, x, z)];
+	float size = settings.chunkCells * levels[level].step * cellSize;
+	min = vec3(minXZ + x * size, n.minY, minXZ + z * size);
+	max = vec3(min.x + size, n.maxY, min.z + size);
+}
+
+const std::vector<TerrainSelectedNode>& TerrainLod::select(const glm::vec3& cameraPos, const Frustum& frustum)
+{
+	selection.clear();
+	selectionCameraPos = cameraPos;
+	stats.selected = 0;
+	stats.culled = 0;
+	int top = getLevelCount() - 1;
+	selectNode(top, 0, 0, cameraPos, frustum);
+	stats.selected = static_cast<uint32_t>(selection.size());
+	return selection;
+}
+
+// returns false if node is out of its range, the parent draws this area then
+bool TerrainLod::selectNode(int level, int x, int z, const glm::vec3& cameraPos, const Frustum& frustum)
+{
+	vec3 min, max;
+	getNodeBounds(level, x, z, min, max);
+	if (!boxIntersectsSphere(min, max, cameraPos, levels[level].range)) {
+		return false;
+	}
+	if (!boxIntersectsSphere(min, max, cameraPos, settings.viewDistance)) {
+		return true;
+	}
+	if (frustum.test((min + max) * 0.5f, (max - min) * 0.5f) == 0) {
+		stats.culled++;
+		return true;
+	}
+	if (level == 0 || !boxIntersectsSphere(min, max, cameraPos, levels[level - 1].range)) {
+		addSelected(level, x, z, QUADRANT_ALL);
+		return true;
+	}
+	uint8_t quadrants = 0;
+	for (int c = 0; c < 4; c++) {
+		if (!selectNode(level - 1, 2 * x + (c & 1), 2 * z + (c >> 1), cameraPos, frustum)) {
+			quadrants |= 1 << c;
+		}
+	}
+	if (quadrants != 0) {
+		addSelected(level, x, z, quadrants);
+	}
+	return true;
+}
+
+void TerrainLod::addSelected(int level, int x, int z, uint8_t quadrants)
+{
+	TerrainSelectedNode s;
+	s.node = getNodeIndex(level, x, z);
+	s.level = level;
+	s.x = x;
+	s.z = z;
+	s.quadrants = quadrants;
+	if (level + 1 < getLevelCount()) {
+		float previous = level > 0 ? levels[level - 1].range : 0.0f;
+		s.morphEnd = levels[level].range;
+		s.morphStart = previous + (s.morphEnd - previous) * settings.morphStartRatio;
+	} else {
+		// no coarser level to morph to
+		s.morphStart = s.morphEnd = numeric_limits<float>::max();
+	}
+	getNodeBounds(level, x, z, s.min, s.max);
+	selection.push_back(s);
+}
+
+// odd vertices morph to their even neighbour with lower index: at morph factor 1 the chunk has the
+// vertex layout and triangulation of the next coarser level
+void TerrainLod::buildChunk(uint32_t node, std::vector<TerrainChunkVertex>& out) const
+{
+	const NodeData& n = nodes[node];
+	int step = levels[n.level].step;
+	int chunk = settings.chunkCells;
+	int baseX = n.x * chunk * step;
+	int baseZ = n.z * chunk * step;
+	float uvScale = 1.0f / (samples - 1);
+	float slopeScale = 1.0f / (2.0f * step * cellSize);
+	out.resize(getChunkVertexCount());
+	for (int gz = 0; gz <= chunk; gz++) {
+		for (int gx = 0; gx <= chunk; gx++) {
+			int fx = baseX + gx * step;
+			int fz = baseZ + gz * step;
+			int tx = fx - (gx & 1) * step;
+			int tz = fz - (gz & 1) * step;
+			TerrainChunkVertex& v = out[static_cast<size_t>(gz) * (chunk + 1) + gx];
+			v.pos = vec3(minXZ + fx * cellSize, heightAt(fx, fz), minXZ + fz * cellSize);
+			v.morphTargetY = heightAt(tx, tz);
+			v.morphDelta = vec2(tx - fx, tz - fz) * cellSize;
+			float dx = (heightAt(fx + step, fz) - heightAt(fx - step, fz)) * slopeScale;
+			float dz = (heightAt(fx, fz + step) - heightAt(fx, fz - step)) * slopeScale;
+			v.normal = normalize(vec3(-dx, 1.0f, -dz));
+			v.pad = 0.0f;
+			v.uv = vec2(fx, fz) * uvScale;
+		}
+	}
+}
+
+void TerrainLod::updateChunks(FrameResources* fr)
+{
+	stats.chunksBuilt = 0;
+	stats.chunksEvicted = 0;
+	stats.uploadedBytes = 0;
+	frame++;
+	size_t chunkBytes = getChunkVertexCount() * sizeof(TerrainChunkVertex);
+	uint64_t reuseFrames = settings.slotReuseFrames;
+	GPUMemoryChunk* mem = nullptr;
+	if (engine != nullptr) {
+		if (fr == nullptr) {
+			Error("TerrainLod: chunk upload needs the frame resources of the current frame");
+		}
+		reuseFrames = std::max(reuseFrames, static_cast<uint64_t>(engine->getFramesInFlight()));
+		mem = engine->globalRendering.getCurrentGPUMemoryChunk();
+		if (!storageReserved) {
+			storageOffset = engine->globalRendering.reserveInGlobalBuffer(chunkBytes * slotNode.size(), mem);
+			storageReserved = true;
+		}
+	}
+	uploadScratch.clear();
+	uploadRegions.clear();
+	// mark resident chunks first, so they are not evicted for other nodes of this frame
+	for (auto& s : selection) {
+		auto it = nodeSlot.find(s.node);
+		if (it != nodeSlot.end()) {
+			s.slot = it->second;
+			slotLastUsed[s.slot] = frame;
+		} else {
+			s.slot = UINT32_MAX;
+		}
+	}
+	for (auto& s : selection) {
+		if (s.slot != UINT32_MAX) continue;
+		// free slot or least recently used one that no frame in flight reads any more
+		uint32_t slot = UINT32_MAX;
+		uint64_t oldest = frame;
+		for (uint32_t i = 0; i < slotNode.size(); i++) {
+			if (slotNode[i] == UINT32_MAX) {
+				slot = i;
+				break;
+			}
+			if (slotLastUsed[i] + reuseFrames <= frame && slotLastUsed[i] < oldest) {
+				oldest = slotLastUsed[i];
+				slot = i;
+			}
+		}
+		if (slot == UINT32_MAX) {
+			Error("TerrainLod: chunk cache too small for selections of frames in flight, increase TerrainLodSettings::cacheSlots");
+		}
+		if (slotNode[slot] != UINT32_MAX) {
+			nodeSlot.erase(slotNode[slot]);
+			stats.chunksEvicted++;
+		}
+		slotNode[slot] = s.node;
+		slotLastUsed[slot] = frame;
+		nodeSlot[s.node] = slot;
+		s.slot = slot;
+		buildChunk(s.node, chunkScratch);
+		stats.chunksBuilt++;
+		if (mem != nullptr) {
+			VkBufferCopy region{};
+			region.srcOffset = uploadScratch.size() * sizeof(TerrainChunkVertex);
+			region.dstOffset = getSlotOffset(slot);
+			region.size = chunkBytes;
+			uploadRegions.push_back(region);
+			uploadScratch.insert(uploadScratch.end(), chunkScratch.begin(), chunkScratch.end());
+		}
+	}
+	if (!uploadRegions.empty()) {
+		VkDeviceSize bytes = uploadScratch.size() * sizeof(TerrainChunkVertex);
+		engine->globalRendering.copyToGlobalBuffer(fr, bytes, uploadScratch.data(), mem, uploadRegions);
+		stats.uploadedBytes += bytes;
+	}
+}
@@ -0,0 +1,194 @@
+#pragma once
+
+// Terrain LOD with a quadtree of chunks (CDLOD, continuous distance dependent LOD).
+// The heightmap grid is covered by a quadtree: every node is drawn as a chunk of the same number of quads,
+// so nodes on higher levels cover larger areas with coarser vertex spacing. Level 0 is the full heightmap resolution.
+// Each level has a distance range, nodes are selected per frame from the camera distance and frustum.
+// Ranges grow with the level and are pushed out further where the geometric error of a level would exceed
+// the allowed screen space error. Vertices of a chunk morph into the layout of the next coarser level when
+// approaching the end of their range (geomorphing), so neighbouring chunks of different levels match without cracks.
+// Chunk vertex data is built on the CPU for selected nodes only and streamed into fixed size slots of the
+// global mesh storage buffer with one staging copy per update, recorded into the upload commands of the frame.
+// Slots are reused least recently used first, but not before frames still in flight stopped reading them,
+// so memory and per frame cost stay constant for any heightmap resolution.
+// TerrainShader draws the selection, see LandscapeDemo1 for usage.
+
+class World;
+
+// chunk vertex as stored in the mesh storage buffer (std430 compatible)
+struct TerrainChunkVertex {
+	glm::vec3 pos; // world position
+	float morphTargetY; // height at morph target
+	glm::vec3 normal;
+	float pad = 0.0f;
+	glm::vec2 morphDelta; // xz offset to morph target, vertex is at pos + morph factor * delta
+	glm::vec2 uv; // heightmap coords 0..1
+};
+static_assert(sizeof(TerrainChunkVertex) == 48, "TerrainChunkVertex has to match std430 layout");
+
+struct TerrainLodSettings {
+	int chunkCells = 32; // quads per chunk edge, power of 2
+	float leafRange = 0.0f; // range of level 0 in world units, 0: 2.5 x chunk size of level 0
+	float morphStartRatio = 0.66f; // morphing starts at this fraction between previous and own range
+	float maxPixelError = 2.0f; // allowed screen space height error
+	float viewportHeight = 1080.0f; // in pixels, for screen error
+	float fovY = glm::radians(45.0f); // vertical field of view, for screen error
+	float viewDistance = std::numeric_limits<float>::max(); // nodes outside are not selected
+	uint32_t cacheSlots = 512; // chunks resident in mesh storage buffer
+	uint32_t slotReuseFrames = 2; // updates before a slot may be overwritten, engine frames in flight are used if larger
+};
+
+// node selected for drawing
+struct TerrainSelectedNode {
+	uint32_t node; // node index, key of chunk cache
+	int level; // 0 is finest
+	int x, z; // node coords within level
+	uint8_t quadrants; // TerrainLod::QUADRANT_ bits to draw, the other quadrants are covered by finer nodes
+	float morphStart, morphEnd; // camera distance range of morph factor 0..1
+	glm::vec3 min, max; // world bounds
+	uint32_t slot = UINT32_MAX; // chunk cache slot, set by TerrainLod::updateChunks()
+};
+
+struct TerrainLodStats {
+	uint32_t selected = 0;
+	uint32_t culled = 0; // nodes rejected by frustum
+	uint32_t chunksBuilt = 0;
+	uint32_t chunksEvicted = 0;
+	uint64_t uploadedBytes = 0;
+	void log() const;
+};
+
+class TerrainLod : public EngineParticipant
+{
+public:
+	// quadrant bits of a node, (x, z) halves
+	static constexpr uint8_t QUADRANT_00 = 1;
+	static constexpr uint8_t QUADRANT_10 = 2;
+	static constexpr uint8_t QUADRANT_01 = 4;
+	static constexpr uint8_t QUADRANT_11 = 8;
+	static constexpr uint8_t QUADRANT_ALL = 15;
+
+	// heights of samples x samples grid covering [minXZ, maxXZ] in x and z, index z * samples + x.
+	// samples - 1 has to be chunkCells * 2^n
+	void init(std::vector<float> heights, int samples, float minXZ, float maxXZ, const TerrainLodSettings& settings = TerrainLodSettings());
+	// sample World::getHeightmapValue() on samples x samples grid over the whole world.
+	// World::prepareUltimateHeightmap() has to be called before
+	void initFromWorld(World& world, int samples, const TerrainLodSettings& settings = TerrainLodSettings());
+
+	int getLevelCount() const {
+		return static_cast<int>(levels.size());
+	}
+	// nodes per edge of level
+	int getNodesPerEdge(int level) const {
+		return levels[level].nodesPerEdge;
+	}
+	uint32_t getNodeIndex(int level, int x, int z) const {
+		return levels[level].firstNode + z * levels[level].nodesPerEdge + x;
+	}
+	// camera distance up to which level is used
+	float getRange(int level) const {
+		return levels[level].range;
+	}
+	// max height deviation of level against full resolution
+	float getGeometricError(int level) const {
+		return levels[level].error;
+	}
+	// world bounds of node
+	void getNodeBounds(int level, int x, int z, glm::vec3& min, glm::vec3& max) const;
+	int getSamples() const {
+		return samples;
+	}
+	float getCellSize() const {
+		return cellSize;
+	}
+	float getSampleHeight(int x, int z) const {
+		return heights[static_cast<size_t>(z) * samples + x];
+	}
+
+	// select nodes for camera, results are valid until next select()
+	const std::vector<TerrainSelectedNode>& select(const glm::vec3& cameraPos, const Frustum& frustum);
+	const std::vector<TerrainSelectedNode>& getSelection() const {
+		return selection;
+	}
+	// camera position of last select(), morph factors of the selection are relative to it
+	const glm::vec3& getSelectionCameraPos() const {
+		return selectionCameraPos;
+	}
+	// morph factor of vertex with given camera distance, 0 own layout .. 1 layout of next coarser level
+	static float morphFactor(const TerrainSelectedNode& node, float distance) {
+		if (node.morphEnd <= node.morphStart) return 0.0f;
+		return std::clamp((distance - node.morphStart) / (node.morphEnd - node.morphStart), 0.0f, 1.0f);
+	}
+	// vertex position for morph factor, same calculation as in shader
+	static glm::vec3 morph(const TerrainChunkVertex& v, float k) {
+		return glm::vec3(v.pos.x + v.morphDelta.x * k, v.pos.y + (v.morphTargetY - v.pos.y) * k, v.pos.z + v.morphDelta.y * k);
+	}
+
+	// vertices of node chunk, (chunkCells + 1)^2 vertices, index z * (chunkCells + 1) + x
+	void buildChunk(uint32_t node, std::vector<TerrainChunkVertex>& out) const;
+	// triangle list shared by all chunks, ordered by quadrant: quadrant q uses indices [q * n / 4, (q + 1) * n / 4)
+	const std::vector<uint32_t>& getChunkIndices() const {
+		return chunkIndices;
+	}
+	size_t getChunkVertexCount() const {
+		return static_cast<size_t>(settings.chunkCells + 1) * (settings.chunkCells + 1);
+	}
+
+	// assign cache slots to selected nodes and build chunks not yet resident. Call once per frame.
+	// With engine set, new chunks are copied into the mesh storage buffer by the upload commands of frame fr
+	void updateChunks(FrameResources* fr = nullptr);
+	// offset of slot in global mesh storage buffer, valid after first updateChunks() with engine set
+	uint64_t getSlotOffset(uint32_t slot) const {
+		return storageOffset + slot * getChunkVertexCount() * sizeof(TerrainChunkVertex);
+	}
+	uint32_t getResidentChunkCount() const {
+		return static_cast<uint32_t>(nodeSlot.size());
+	}
+	const TerrainLodStats& getStats() const {
+		return stats;
+	}
+
+private:
+	struct Level {
+		int nodesPerEdge = 0;
+		int step = 0; // heightmap samples between chunk vertices
+		uint32_t firstNode = 0;
+		float range = 0.0f;
+		float error = 0.0f;
+	};
+	struct NodeData {
+		float minY, maxY;
+		int level, x, z;
+	};
+	bool selectNode(int level, int x, int z, const glm::vec3& cameraPos, const Frustum& frustum);
+	void addSelected(int level, int x, int z, uint8_t quadrants);
+	void calculateErrors();
+	void calculateRanges();
+	float heightAt(int x, int z) const {
+		x = std::clamp(x, 0, samples - 1);
+		z = std::clamp(z, 0, samples - 1);
+		return heights[static_cast<size_t>(z) * samples + x];
+	}
+
+	TerrainLodSettings settings;
+	std::vector<float> heights;
+	int samples = 0;
+	float minXZ = 0.0f;
+	float cellSize = 0.0f;
+	std::vector<Level> levels;
+	std::vector<NodeData> nodes;
+	std::vector<uint32_t> chunkIndices;
+	std::vector<TerrainSelectedNode> selection;
+	glm::vec3 selectionCameraPos = glm::vec3(0.0f);
+	TerrainLodStats stats;
+	// chunk cache
+	std::vector<uint32_t> slotNode; // UINT32_MAX for free slots
+	std::vector<uint64_t> slotLastUsed; // frame of last use
+	std::unordered_map<uint32_t, uint32_t> nodeSlot;
+	uint64_t frame = 0;
+	uint64_t storageOffset = 0;
+	bool storageReserved = false;
+	std::vector<TerrainChunkVertex> chunkScratch;
+	std::vector<TerrainChunkVertex> uploadScratch; // all chunks built in one update
+	std::vector<VkBufferCopy> uploadRegions;
+};
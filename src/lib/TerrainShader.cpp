@@ -1,47 +1,292 @@
-// Destructor
-TerrainShader::~TerrainShader() {
-    // Cleanup resources
-    // Note: Actual resource cleanup will depend on your application's lifecycle and Vulkan setup
+#include "mainheader.h"
+
+using namespace std;
+
+void TerrainShader::init(ShadedPathEngine& engine, ShaderState &shaderState)
+{
+	ShaderBase::init(engine);
+	resources.setResourceDefinition(&vulkanResourceDefinition);
+	if (terrain == nullptr) {
+		Error("TerrainShader: app did not set terrain");
+	}
+
+	// create shader modules
+	vertShaderModule = resources.createShaderModule("terrain.vert.spv");
+	engine.util.debugNameObjectShaderModule(vertShaderModule, "Terrain Vert Shader");
+	fragShaderModule = resources.createShaderModule("terrain.frag.spv");
+	engine.util.debugNameObjectShaderModule(fragShaderModule, "Terrain Frag Shader");
+
+	// index buffer shared by all chunks
+	auto& indices = terrain->getChunkIndices();
+	VkDeviceSize bufferSize = sizeof(indices[0]) * indices.size();
+	resources.createIndexBufferStatic(bufferSize, indices.data(), indexBuffer, indexBufferMemory);
+
+	// descriptor
+	resources.createDescriptorSetResources(descriptorSetLayout, descriptorPool, this, 1);
+
+	// push constants
+	pushConstantRanges.push_back(terrainPushConstantRange);
+
+	int fl = engine.getFramesInFlight();
+	for (int i = 0; i < fl; i++) {
+		TerrainSubShader sub;
+		sub.init(this, "TerrainSubShader");
+		sub.setVertShaderModule(vertShaderModule);
+		sub.setFragShaderModule(fragShaderModule);
+		sub.setVulkanResources(&resources);
+		globalSubShaders.push_back(sub);
+	}
 }
 
-void TerrainShader::init(ShadedPathEngine& engine, ShaderState &shaderState) {
-    // Initialize shader resources (e.g., load shaders, create pipeline)
-    // This is a placeholder for your shader initialization logic
-    std::cout << "Initializing TerrainShader resources" << std::endl;
+void TerrainShader::initSingle(FrameResources& tr, ShaderState& shaderState)
+{
+	TerrainSubShader& sub = globalSubShaders[tr.frameIndex];
+	sub.initSingle(tr, shaderState);
+}
+
+void TerrainSubShader::initSingle(FrameResources& tr, ShaderState& shaderState)
+{
+	frameResources = &tr;
+	// uniform buffers for MVP
+	terrainShader->createUniformBuffer(uniformBuffer, sizeof(TerrainShader::UniformBufferObject), uniformBufferMemory);
+	engine->util.debugNameObjectBuffer(uniformBuffer, "Terrain Uniform Buffer");
+	if (engine->isStereo()) {
+		terrainShader->createUniformBuffer(uniformBuffer2, sizeof(TerrainShader::UniformBufferObject), uniformBufferMemory2);
+		engine->util.debugNameObjectBuffer(uniformBuffer2, "Terrain Uniform Stereo Buffer");
+	}
+
+	VulkanHandoverResources handover{};
+	handover.mvpBuffer = uniformBuffer;
+	handover.mvpBuffer2 = uniformBuffer2;
+	handover.mvpSize = sizeof(TerrainShader::UniformBufferObject);
+	handover.imageView = nullptr;
+	handover.descriptorSet = &descriptorSet;
+	handover.descriptorSet2 = &descriptorSet2;
+	handover.shader = terrainShader;
+	vulkanResources->createThreadResources(handover);
+
+	terrainShader->createRenderPassAndFramebuffer(tr, shaderState, renderPass, framebuffer, framebuffer2);
+
+	// create shader stage
+	auto vertShaderStageInfo = engine->shaders.createVertexShaderCreateInfo(vertShaderModule);
+	auto fragShaderStageInfo = engine->shaders.createFragmentShaderCreateInfo(fragShaderModule);
+	VkPipelineShaderStageCreateInfo shaderStages[] = { vertShaderStageInfo, fragShaderStageInfo };
+
+	// vertex input: none, vertices are read from chunk slots in terrain.vert
+	VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
+	vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+
+	// input assembly
+	VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
+	inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+	inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+	inputAssembly.primitiveRestartEnable = VK_FALSE;
+
+	// viewport and scissors
+	VkPipelineViewportStateCreateInfo viewportState = shaderState.viewportState;
+
+	// rasterizer
+	auto rasterizer = terrainShader->createStandardRasterizer();
+
+	// multisampling
+	auto multisampling = terrainShader->createStandardMultisampling();
+
+	// standard color blending (disabled)
+	VkPipelineColorBlendAttachmentState colorBlendAttachment;
+	auto colorBlending = terrainShader->createStandardColorBlending(colorBlendAttachment);
+
+	// pipeline layout
+	vulkanResources->createPipelineLayout(&pipelineLayout, terrainShader);
+
+	// depth stencil
+	auto depthStencil = terrainShader->createStandardDepthStencil();
+
+	// create pipeline
+	VkGraphicsPipelineCreateInfo pipelineInfo{};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+	pipelineInfo.stageCount = static_cast<uint32_t>(size(shaderStages));
+	pipelineInfo.pStages = shaderStages;
+	pipelineInfo.pNext = nullptr;
+	pipelineInfo.pVertexInputState = &vertexInputInfo;
+	pipelineInfo.pInputAssemblyState = &inputAssembly;
+	pipelineInfo.pViewportState = &viewportState;
+	pipelineInfo.pRasterizationState = &rasterizer;
+	pipelineInfo.pMultisampleState = &multisampling;
+	pipelineInfo.pDepthStencilState = &depthStencil;
+	pipelineInfo.pColorBlendState = &colorBlending;
+	pipelineInfo.pDynamicState = nullptr; // Optional
+	pipelineInfo.layout = pipelineLayout;
+	pipelineInfo.renderPass = renderPass;
+	pipelineInfo.subpass = 0;
+	pipelineInfo.basePipelineHandle = VK_NULL_HANDLE; // Optional
+	pipelineInfo.basePipelineIndex = -1; // Optional
+	engine->globalRendering.pipelineCache.createGraphicsPipelineDeferred(pipelineInfo, &graphicsPipeline);
+}
+
+void TerrainShader::createCommandBuffer(FrameResources& tr)
+{
+	TerrainSubShader& sub = globalSubShaders[tr.frameIndex];
+	auto name = engine->util.createDebugName("TERRAIN COMMAND BUFFER", tr.frameIndex);
+	sub.allocateCommandBuffer(tr, &sub.commandBuffer, name.c_str());
+}
+
+void TerrainShader::prepareDraw(FrameResources& tr)
+{
+	if (!enabled) return;
+	TerrainSubShader& sub = globalSubShaders[tr.frameIndex];
+	sub.addRenderPassAndDrawCommands(tr, &sub.commandBuffer);
+}
+
+void TerrainSubShader::allocateCommandBuffer(FrameResources& tr, VkCommandBuffer* cmdBufferPtr, const char* debugName)
+{
+	VkCommandBufferAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocInfo.commandPool = tr.commandPool;
+	allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocInfo.commandBufferCount = (uint32_t)1;
+
+	if (vkAllocateCommandBuffers(device, &allocInfo, cmdBufferPtr) != VK_SUCCESS) {
+		Error("failed to allocate command buffers!");
+	}
+	engine->util.debugNameObjectCommandBuffer(*cmdBufferPtr, debugName);
+}
+
+void TerrainSubShader::addRenderPassAndDrawCommands(FrameResources& tr, VkCommandBuffer* cmdBufferPtr)
+{
+	VkCommandBuffer& commandBuffer = *cmdBufferPtr;
+	VkCommandBufferBeginInfo beginInfo{};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = 0; // Optional
+	beginInfo.pInheritanceInfo = nullptr; // Optional
+
+	if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+		Error("failed to begin recording terrain command buffer!");
+	}
+	VkRenderPassBeginInfo renderPassInfo{};
+	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+	renderPassInfo.renderPass = renderPass;
+	renderPassInfo.framebuffer = framebuffer;
+	renderPassInfo.renderArea.offset = { 0, 0 };
+	renderPassInfo.renderArea.extent = engine->getBackBufferExtent();
+
+	renderPassInfo.clearValueCount = 0;
+
+	vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+	recordDrawCommand(commandBuffer, tr);
+	vkCmdEndRenderPass(commandBuffer);
+	if (engine->isStereo()) {
+		renderPassInfo.framebuffer = framebuffer2;
+		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+		recordDrawCommand(commandBuffer, tr, true);
+		vkCmdEndRenderPass(commandBuffer);
+	}
+	if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+		Error("failed to record terrain command buffer!");
+	}
+}
+
+void TerrainSubShader::recordDrawCommand(VkCommandBuffer& commandBuffer, FrameResources& tr, bool isRightEye)
+{
+	TerrainLod* terrain = terrainShader->terrain;
+	auto& selection = terrain->getSelection();
+	if (selection.empty()) return;
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
+	vkCmdBindIndexBuffer(commandBuffer, terrainShader->indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+
+	// bind descriptor sets:
+	if (!isRightEye) {
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSet, 0, nullptr);
+	} else {
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSet2, 0, nullptr);
+	}
+
+	// one draw per selected quadrant range, quadrant q uses indices [q * n / 4, (q + 1) * n / 4)
+	uint32_t quadrantIndexCount = static_cast<uint32_t>(terrain->getChunkIndices().size() / 4);
+	uint64_t storageAddress = engine->globalRendering.getCurrentGPUMemoryChunk()->address;
+	TerrainPushConstants pushConstants;
+	pushConstants.cameraPos = terrain->getSelectionCameraPos();
+	for (auto& s : selection) {
+		if (s.slot == UINT32_MAX) {
+			Error("TerrainShader: selection has no chunk slots, TerrainLod::updateChunks() not called");
+		}
+		pushConstants.chunkAddress = storageAddress + terrain->getSlotOffset(s.slot);
+		pushConstants.morphStart = s.morphStart;
+		pushConstants.morphEnd = s.morphEnd;
+		vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(TerrainPushConstants), &pushConstants);
+		if (s.quadrants == TerrainLod::QUADRANT_ALL) {
+			vkCmdDrawIndexed(commandBuffer, quadrantIndexCount * 4, 1, 0, 0, 0);
+			continue;
+		}
+		for (uint32_t q = 0; q < 4; q++) {
+			if (s.quadrants & (1 << q)) {
+				vkCmdDrawIndexed(commandBuffer, quadrantIndexCount, 1, q * quadrantIndexCount, 0, 0);
+			}
+		}
+	}
 }
 
-void TerrainShader::initSingle(ThreadResources& tr, ShaderState& shaderState) {
-    // Initialize thread-specific resources
-    // This is a placeholder for thread-specific initialization logic
-    std::cout << "Initializing TerrainShader thread-specific resources" << std::endl;
+void TerrainShader::uploadToGPU(FrameResources& tr, UniformBufferObject& ubo, UniformBufferObject& ubo2) {
+	if (!enabled) return;
+	auto& sub = globalSubShaders[tr.frameIndex];
+	sub.uploadToGPU(tr, ubo, ubo2);
 }
 
-void TerrainShader::finishInitialization(ShadedPathEngine& engine, ShaderState& shaderState) {
-    // Finalize initialization (e.g., create descriptor sets)
-    // This is a placeholder for final initialization steps
-    std::cout << "Finalizing TerrainShader initialization" << std::endl;
+void TerrainSubShader::uploadToGPU(FrameResources& tr, TerrainShader::UniformBufferObject& ubo, TerrainShader::UniformBufferObject& ubo2) {
+	// copy ubo to GPU:
+	void* data;
+	vkMapMemory(device, uniformBufferMemory, 0, sizeof(ubo), 0, &data);
+	memcpy(data, &ubo, sizeof(ubo));
+	vkUnmapMemory(device, uniformBufferMemory);
+	if (engine->isStereo()) {
+		vkMapMemory(device, uniformBufferMemory2, 0, sizeof(ubo2), 0, &data);
+		memcpy(data, &ubo2, sizeof(ubo2));
+		vkUnmapMemory(device, uniformBufferMemory2);
+	}
 }
 
-void TerrainShader::createCommandBuffer(ThreadResources& tr) {
-    // Create command buffer for rendering
-    // This is a placeholder for command buffer creation logic
-    std::cout << "Creating TerrainShader command buffer" << std::endl;
+void TerrainShader::addCommandBuffers(FrameResources* fr, DrawResult* drawResult) {
+	if (!enabled) return;
+	int index = drawResult->getNextFreeCommandBufferIndex();
+	auto& sub = globalSubShaders[fr->frameIndex];
+	drawResult->commandBuffers[index++] = sub.commandBuffer;
 }
 
-void TerrainShader::addCurrentCommandBuffer(ThreadResources& tr) {
-    // Add command buffer to the rendering queue
-    // This is a placeholder for adding the command buffer to the queue
-    std::cout << "Adding TerrainShader command buffer to the queue" << std::endl;
+TerrainShader::~TerrainShader()
+{
+	Log("TerrainShader destructor\n");
+	if (!enabled) {
+		return;
+	}
+	for (TerrainSubShader& sub : globalSubShaders) {
+		sub.destroy();
+	}
+	vkDestroyBuffer(device, indexBuffer, nullptr);
+	engine->globalRendering.freeMemory(indexBufferMemory);
+	vkDestroyShaderModule(device, fragShaderModule, nullptr);
+	vkDestroyShaderModule(device, vertShaderModule, nullptr);
+	vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
+	vkDestroyDescriptorPool(device, descriptorPool, nullptr);
 }
 
-void TerrainShader::destroyThreadResources(ThreadResources& tr) {
-    // Destroy thread-specific resources
-    // This is a placeholder for thread-specific resource cleanup
-    std::cout << "Destroying TerrainShader thread-specific resources" << std::endl;
+void TerrainSubShader::init(TerrainShader* parent, std::string debugName) {
+	terrainShader = parent;
+	name = debugName;
+	engine = terrainShader->engine;
+	device = engine->globalRendering.device;
+	Log("TerrainSubShader init: " << debugName.c_str() << std::endl);
 }
 
-void TerrainShader::recordDrawCommand(VkCommandBuffer& commandBuffer, ThreadResources& tr, VkBuffer vertexBuffer, bool isRightEye) {
-    // Record commands for drawing the terrain
-    // This is a placeholder for the draw command recording logic
-    std::cout << "Recording draw commands for TerrainShader" << std::endl;
+void TerrainSubShader::destroy()
+{
+	vkDestroyFramebuffer(device, framebuffer, nullptr);
+	vkDestroyRenderPass(device, renderPass, nullptr);
+	vkDestroyPipeline(device, graphicsPipeline, nullptr);
+	vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+	vkDestroyBuffer(device, uniformBuffer, nullptr);
+	engine->globalRendering.freeMemory(uniformBufferMemory);
+	if (engine->isStereo()) {
+		vkDestroyFramebuffer(device, framebuffer2, nullptr);
+		vkDestroyBuffer(device, uniformBuffer2, nullptr);
+		engine->globalRendering.freeMemory(uniformBufferMemory2);
+	}
 }
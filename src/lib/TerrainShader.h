@@ -1,94 +1,116 @@
 #pragma once
-// TODO: currently not in use!!!!
-// TerrainShader - draw terrain using heightmaps and textures
-// stages: VertexShader --> TessellationControlShader (optional) --> TessellationEvaluationShader (optional) --> GeometryShader (optional) --> FragmentShader
-// This is a basic structure. Implement tessellation or geometry shaders as needed for your terrain rendering technique.
+// Terrain - draw the chunks selected by TerrainLod
+// stages: VertexShader --> FragmentShader
+// Chunk vertices are read from their TerrainLod cache slot in the global mesh storage buffer via buffer device address,
+// so the pipeline has no vertex input. All chunks share one static index buffer, quadrants covered by finer nodes are skipped.
+// Draw commands are recorded every frame from the current TerrainLod selection.
 
-// TerrainVertex is used in application code to define the terrain mesh AND directly used as Vertex definition
-struct TerrainVertex {
-    glm::vec3 pos; // Position of the vertex
-    glm::vec3 normal; // Normal vector for lighting
-    glm::vec2 texCoords; // Texture coordinates
+// make sure to match the push_constant layout in terrain.vert
+struct TerrainPushConstants {
+	uint64_t chunkAddress = 0; // device address of chunk slot in global mesh storage buffer
+	float morphStart = 0.0f; // camera distance range of morph factor 0..1, see TerrainSelectedNode
+	float morphEnd = 0.0f;
+	glm::vec3 cameraPos = glm::vec3(0.0f); // camera used for TerrainLod::select()
+	float pad = 0.0f;
 };
 
-// Uniform buffer object for terrain shader
-struct TerrainUniformBufferObject {
-    glm::mat4 model;
-    glm::mat4 view;
-    glm::mat4 proj;
+const VkPushConstantRange terrainPushConstantRange = {
+	VK_SHADER_STAGE_VERTEX_BIT, // stageFlags
+	0, // offset
+	sizeof(TerrainPushConstants) // size
 };
 
+// forward
+class TerrainSubShader;
+class TerrainLod;
+
 class TerrainShader : public ShaderBase {
 public:
-    std::vector<VulkanResourceElement> vulkanResourceDefinition = {
-        { VulkanResourceType::MVPBuffer },
-        { VulkanResourceType::GlobalTextureSet }, // Assuming terrain uses a global texture set
-        { VulkanResourceType::VertexBufferStatic } // Static vertex buffer for terrain mesh
-    };
-
-    // Define terrain vertex layout
-    typedef TerrainVertex Vertex;
+	std::vector<TerrainSubShader> globalSubShaders;
 
-    static VkVertexInputBindingDescription getBindingDescription() {
-        VkVertexInputBindingDescription bindingDescription{};
-        bindingDescription.binding = 0;
-        bindingDescription.stride = sizeof(Vertex);
-        bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-        return bindingDescription;
-    }
+	std::vector<VulkanResourceElement> vulkanResourceDefinition = {
+		{ VulkanResourceType::MVPBuffer },
+		{ VulkanResourceType::IndexBufferStatic }
+	};
 
-    // Get static std::array of attribute descriptions
-    static std::array<VkVertexInputAttributeDescription, 3> getAttributeDescriptions() {
-        std::array<VkVertexInputAttributeDescription, 3> attributeDescriptions{};
-        // layout(location = 0) in vec3 inPosition;
-        attributeDescriptions[0].binding = 0;
-        attributeDescriptions[0].location = 0;
-        attributeDescriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
-        attributeDescriptions[0].offset = offsetof(Vertex, pos);
-        // layout(location = 1) in vec3 inNormal;
-        attributeDescriptions[1].binding = 0;
-        attributeDescriptions[1].location = 1;
-        attributeDescriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;
-        attributeDescriptions[1].offset = offsetof(Vertex, normal);
-        // layout(location = 2) in vec2 inTexCoords;
-        attributeDescriptions[2].binding = 0;
-        attributeDescriptions[2].location = 2;
-        attributeDescriptions[2].format = VK_FORMAT_R32G32_SFLOAT;
-        attributeDescriptions[2].offset = offsetof(Vertex, texCoords);
-        return attributeDescriptions;
-    }
+	struct UniformBufferObject {
+		glm::mat4 model;
+		glm::mat4 view;
+		glm::mat4 proj;
+	};
 
-    virtual ~TerrainShader() override;
-    virtual void init(ShadedPathEngine& engine, ShaderState &shaderState) override;
-    virtual void initSingle(FrameResources& tr, ShaderState& shaderState) override;
-    virtual void finishInitialization(ShadedPathEngine& engine, ShaderState& shaderState) override;
-    virtual void createCommandBuffer(FrameResources& tr) override;
-    virtual void destroyThreadResources(FrameResources& tr) override;
+	virtual ~TerrainShader() override;
+	// shader initialization, end result is a graphics pipeline for each FrameResources instance
+	virtual void init(ShadedPathEngine& engine, ShaderState &shaderState) override;
+	// thread resources initialization
+	virtual void initSingle(FrameResources& tr, ShaderState& shaderState) override;
+	virtual void createCommandBuffer(FrameResources& tr) override;
+	virtual void addCommandBuffers(FrameResources* fr, DrawResult* drawResult) override;
 
-    // Additional methods specific to terrain rendering can be added here
+	// terrain to draw, has to be initialized before shaders are initialized
+	void setTerrain(TerrainLod* t) {
+		terrain = t;
+	}
+	// record draw commands for the current selection of the terrain. Call once per frame after TerrainLod::updateChunks()
+	void prepareDraw(FrameResources& tr);
+	// per frame update of UBO / MVP
+	void uploadToGPU(FrameResources& tr, UniformBufferObject& ubo, UniformBufferObject& ubo2);
 
+	TerrainLod* terrain = nullptr;
+	// chunk topology from TerrainLod::getChunkIndices() (one buffer for all threads)
+	VkBuffer indexBuffer = nullptr;
 private:
-    void recordDrawCommand(VkCommandBuffer& commandBuffer, ThreadResources& tr, VkBuffer vertexBuffer, bool isRightEye = false);
+	VkDeviceMemory indexBufferMemory = nullptr;
+	VkShaderModule vertShaderModule = nullptr;
+	VkShaderModule fragShaderModule = nullptr;
+};
 
-    TerrainUniformBufferObject ubo = {};
-    bool disabled = false;
+/*
+ * TerrainSubShader includes everything for one shader invocation.
+ * One sub shader per frame in flight, command buffer is re-recorded every frame
+ */
+class TerrainSubShader {
+public:
+	void init(TerrainShader* parent, std::string debugName);
+	void setVertShaderModule(VkShaderModule sm) {
+		vertShaderModule = sm;
+	}
+	void setFragShaderModule(VkShaderModule sm) {
+		fragShaderModule = sm;
+	}
+	void initSingle(FrameResources& tr, ShaderState& shaderState);
+	void setVulkanResources(VulkanResources* vr) {
+		vulkanResources = vr;
+	}
 
-    // Vertex buffer for terrain mesh (one buffer for all threads)
-    VkBuffer vertexBuffer = nullptr;
-    VkDeviceMemory vertexBufferMemory = nullptr;
-    VkShaderModule vertShaderModule = nullptr;
-    VkShaderModule fragShaderModule = nullptr;
-    // Add tessellation and geometry shader modules as needed
-};
+	void allocateCommandBuffer(FrameResources& tr, VkCommandBuffer* cmdBufferPtr, const char* debugName);
+	void addRenderPassAndDrawCommands(FrameResources& tr, VkCommandBuffer* cmdBufferPtr);
+	void recordDrawCommand(VkCommandBuffer& commandBuffer, FrameResources& tr, bool isRightEye = false);
+	// per frame update of UBO / MVP
+	void uploadToGPU(FrameResources& tr, TerrainShader::UniformBufferObject& ubo, TerrainShader::UniformBufferObject& ubo2);
 
-struct TerrainThreadResources : ShaderThreadResources {
-    // Similar to BillboardThreadResources, adjust as necessary for terrain rendering
-    VkFramebuffer framebuffer = nullptr;
-    VkRenderPass renderPass = nullptr;
-    VkPipelineLayout pipelineLayout = nullptr;
-    VkPipeline graphicsPipeline = nullptr;
-    VkCommandBuffer commandBuffer = nullptr;
-    VkBuffer uniformBuffer = nullptr;
-    VkDeviceMemory uniformBufferMemory = nullptr;
-    VkDescriptorSet descriptorSet = nullptr;
+	void destroy();
+	VkFramebuffer framebuffer = nullptr;
+	VkFramebuffer framebuffer2 = nullptr;
+	VkRenderPass renderPass = nullptr;
+	VkPipelineLayout pipelineLayout = nullptr;
+	VkPipeline graphicsPipeline = nullptr;
+	VkCommandBuffer commandBuffer = nullptr;
+	// MVP buffer
+	VkBuffer uniformBuffer = nullptr;
+	VkBuffer uniformBuffer2 = nullptr;
+	// MVP buffer device memory
+	VkDeviceMemory uniformBufferMemory = nullptr;
+	VkDeviceMemory uniformBufferMemory2 = nullptr;
+	VkDescriptorSet descriptorSet = nullptr;
+	VkDescriptorSet descriptorSet2 = nullptr;
+private:
+	TerrainShader* terrainShader = nullptr;
+	VulkanResources* vulkanResources = nullptr;
+	std::string name;
+	VkShaderModule vertShaderModule = nullptr;
+	VkShaderModule fragShaderModule = nullptr;
+	ShadedPathEngine* engine = nullptr;
+	VkDevice device = nullptr;
+	FrameResources* frameResources = nullptr;
 };
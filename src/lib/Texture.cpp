@@ -17,24 +17,88 @@ void TextureStore::init(ShadedPathEngine* engine, size_t maxTextures) {
 	}
 }
 
-TextureInfo* TextureStore::getTextureByIndex(uint32_t index)
+uint32_t DescriptorSlots::allocate()
 {
-	auto& allTex = getTexturesMap();
-	for (auto& tex : allTex) {
-		auto& ti = tex.second;
-		if (ti.isAvailable()) {
-            if (ti.index == index) {
-                return getTexture(ti.id);
-            }
+	uint32_t slot;
+	if (freeList.empty()) {
+		slot = size();
+		used.push_back(1);
+		dirty.push_back(0);
+	} else {
+		slot = freeList.back();
+		freeList.pop_back();
+		used[slot] = 1;
+	}
+	numUsed++;
+	markDirty(slot);
+	return slot;
+}
+
+void DescriptorSlots::release(uint32_t slot)
+{
+	if (!isUsed(slot)) {
+		Error("DescriptorSlots: releasing unused slot");
+	}
+	used[slot] = 0;
+	numUsed--;
+	freeList.push_back(slot);
+	markDirty(slot);
+}
+
+void DescriptorSlots::markDirty(uint32_t slot)
+{
+	if (slot >= size()) {
+		Error("DescriptorSlots: slot out of range");
+	}
+	if (dirty[slot]) return;
+	dirty[slot] = 1;
+	dirtyList.push_back(slot);
+}
+
+void DescriptorSlots::markAllDirty()
+{
+	for (uint32_t slot = 0; slot < size(); slot++) {
+		markDirty(slot);
+	}
+}
+
+vector<DescriptorSlots::Range> DescriptorSlots::takeDirtyRanges(uint32_t maxGap)
+{
+	vector<Range> ranges;
+	sort(dirtyList.begin(), dirtyList.end());
+	for (uint32_t slot : dirtyList) {
+		dirty[slot] = 0;
+		if (!ranges.empty() && slot - (ranges.back().first + ranges.back().count) <= maxGap) {
+			ranges.back().count = slot - ranges.back().first + 1;
+		} else {
+			ranges.push_back({ slot, 1 });
 		}
 	}
+	dirtyList.clear();
+	return ranges;
+}
+
+TextureInfo* TextureStore::getTextureByIndex(uint32_t index)
+{
+	if (index < slots.size() && slots[index] != nullptr && slots[index]->isAvailable()) {
+		return slots[index];
+	}
     Error("Texture not found by index");
     return nullptr; // keep compiler happy
 }
 
-TextureInfo* TextureStore::getTexture(string id)
+TextureInfo* TextureStore::getTexture(const string& id)
+{
+	return getTexture(findTextureId(id));
+}
+
+TextureInfo* TextureStore::getTexture(TextureId id)
 {
-	TextureInfo* ret = &textures[id];
+	// also catches invalid ids
+	if (id.value >= textureById.size() || textureById[id.value] == nullptr) {
+		Error("Requested texture not available");
+	}
+	TextureInfo* ret = textureById[id.value];
 	// simple validity check for now:
 	if (ret->id.size() > 0) {
 		// if there is no id the texture could not be loaded (wrong filename?)
@@ -71,6 +135,13 @@ void TextureStore::loadTexture(string filename, string id, TextureType type, Tex
 
 	ktxTexture* kTexture;
 	createKTXFromMemory((const ktx_uint8_t*)file_buffer.data(), static_cast<int>(file_buffer.size()), &kTexture);
+	texture->flags = flags;
+	if (isStreamable(kTexture, texture)) {
+		// texture store owns ktx data now
+		createStreamedTexture(kTexture, texture);
+		setTextureActive(texture->id, true);
+		return;
+	}
 	createVulkanTextureFromKTKTexture(kTexture, texture);
 	setTextureActive(texture->id, true);
 	if (hasFlag(flags, TextureFlags::KEEP_DATA_BUFFER)) {
@@ -87,6 +158,7 @@ void TextureStore::loadTexture(string filename, string id, TextureType type, Tex
 		float* floatData = (float*)data;
 		texture->float_buffer.insert(texture->float_buffer.end(), floatData, floatData + (size / sizeof(float)));
 		Log("size float: " << texture->float_buffer.size() << endl);
+		engine->memoryTracker.track(&texture->float_buffer, MemoryTag::Texture, MemoryDomain::Host, texture->float_buffer.size() * sizeof(float));
 		//for (int i = 0; i < size / 4; i++) {
 		//	Log("floatData: " << floatData[i] << endl);
 		//}
@@ -105,21 +177,28 @@ void TextureStore::createKTXFromMemory(const unsigned char* data, int size, ktxT
 
 }
 
+void TextureStore::transcodeIfNeeded(ktxTexture* kTexture)
+{
+	if (kTexture->classId != class_id::ktxTexture2_c) return;
+	ktxTexture2* t2 = (ktxTexture2*)(kTexture);
+	bool needTranscoding = ktxTexture2_NeedsTranscoding(t2);
+	if (needTranscoding) {
+		auto ktxresult = ktxTexture2_TranscodeBasis(t2, KTX_TTF_BC7_RGBA, 0);
+		if (ktxresult != KTX_SUCCESS) {
+			Log("ERROR: in ktxTexture2_TranscodeBasis " << ktxresult);
+			Error("Could not uncompress texture");
+		}
+		needTranscoding = ktxTexture2_NeedsTranscoding(t2);
+		assert(needTranscoding == false);
+	}
+}
+
 void TextureStore::createVulkanTextureFromKTKTexture(ktxTexture* kTexture, TextureInfo* texture)
 {
 	if (kTexture->classId == class_id::ktxTexture2_c) {
 		// for KTX 2 handling
 		ktxTexture2* t2 = (ktxTexture2*)(kTexture);
-		bool needTranscoding = ktxTexture2_NeedsTranscoding(t2);
-		if (needTranscoding) {
-			auto ktxresult = ktxTexture2_TranscodeBasis(t2, KTX_TTF_BC7_RGBA, 0);
-			if (ktxresult != KTX_SUCCESS) {
-				Log("ERROR: in ktxTexture2_TranscodeBasis " << ktxresult);
-				Error("Could not uncompress texture");
-			}
-			needTranscoding = ktxTexture2_NeedsTranscoding(t2);
-			assert(needTranscoding == false);
-		}
+		transcodeIfNeeded(kTexture);
 		auto format = ktxTexture_GetVkFormat(kTexture);
 		// we should have VK_FORMAT_BC7_UNORM_BLOCK = 145 or VK_FORMAT_BC7_SRGB_BLOCK = 146,
 		Log("format: " << format << endl);
@@ -128,6 +207,7 @@ void TextureStore::createVulkanTextureFromKTKTexture(ktxTexture* kTexture, Textu
 			Log("ERROR: in ktxTexture2_VkUploadEx " << ktxresult);
 			Error("Could not upload texture to GPU ktxTexture2_VkUploadEx");
 		}
+		trackKTXTexture(texture);
 		if (texture->type == TextureType::TEXTURE_TYPE_MIPMAP_IMAGE && texture->vulkanTexture.levelCount < 2) {
 			stringstream s;
 			s << "Cannot load TEXTURE_TYPE_MIPMAP_IMAGE texture without mipmaps " << texture->filename << endl;
@@ -138,10 +218,15 @@ void TextureStore::createVulkanTextureFromKTKTexture(ktxTexture* kTexture, Textu
 			Error(s.str());
 		}
 		// create image view and sampler:
+		VkImageView view;
 		if (kTexture->isCubemap) {
-			texture->imageView = engine->globalRendering.createImageViewCube(texture->vulkanTexture.image, format, VK_IMAGE_ASPECT_COLOR_BIT, texture->vulkanTexture.levelCount);
+			view = engine->globalRendering.createImageViewCube(texture->vulkanTexture.image, format, VK_IMAGE_ASPECT_COLOR_BIT, texture->vulkanTexture.levelCount);
 		} else {
-			texture->imageView = engine->globalRendering.createImageView(texture->vulkanTexture.image, format, VK_IMAGE_ASPECT_COLOR_BIT, texture->vulkanTexture.levelCount);
+			view = engine->globalRendering.createImageView(texture->vulkanTexture.image, format, VK_IMAGE_ASPECT_COLOR_BIT, texture->vulkanTexture.levelCount);
+		}
+		{
+			lock_guard<mutex> lock(descriptorMutex);
+			texture->imageView = view;
 		}
         //setTextureActive(texture->id, true);
 		return;
@@ -154,17 +239,29 @@ void TextureStore::createVulkanTextureFromKTKTexture(ktxTexture* kTexture, Textu
 			Log("ERROR: in ktxTexture_VkUploadEx " << ktxresult);
 			Error("Could not upload texture to GPU ktxTexture_VkUploadEx");
 		}
+		trackKTXTexture(texture);
 		// create image view and sampler:
+		VkImageView view;
 		if (kTexture->isCubemap) {
-			texture->imageView = engine->globalRendering.createImageViewCube(texture->vulkanTexture.image, format, VK_IMAGE_ASPECT_COLOR_BIT, texture->vulkanTexture.levelCount);
+			view = engine->globalRendering.createImageViewCube(texture->vulkanTexture.image, format, VK_IMAGE_ASPECT_COLOR_BIT, texture->vulkanTexture.levelCount);
 		} else {
 			//texture->imageView = engine->globalRendering.createImageView(texture->vulkanTexture.image, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_ASPECT_COLOR_BIT, texture->vulkanTexture.levelCount);
-			texture->imageView = engine->globalRendering.createImageView(texture->vulkanTexture.image, format, VK_IMAGE_ASPECT_COLOR_BIT, texture->vulkanTexture.levelCount);
+			view = engine->globalRendering.createImageView(texture->vulkanTexture.image, format, VK_IMAGE_ASPECT_COLOR_BIT, texture->vulkanTexture.levelCount);
 		}
+		lock_guard<mutex> lock(descriptorMutex);
+		texture->imageView = view;
 		//setTextureActive(texture->id, true);
 	}
 }
 
+void TextureStore::trackKTXTexture(TextureInfo* texture)
+{
+	// ktx allocates the image memory itself
+	VkMemoryRequirements memRequirements;
+	vkGetImageMemoryRequirements(engine->globalRendering.device, texture->vulkanTexture.image, &memRequirements);
+	engine->memoryTracker.track(texture->vulkanTexture.deviceMemory, MemoryTag::Texture, MemoryDomain::Device, memRequirements.size);
+}
+
 TextureInfo* TextureStore::createTextureSlot(string textureName)
 {
 	// make sure we do not already have this texture stored:
@@ -193,11 +290,205 @@ TextureInfo* TextureStore::internalCreateTextureSlot(string id)
 	initialTexture.id = id;
 	textures[id] = initialTexture;
 	TextureInfo* texture = &textures[id];
+	TextureId textureId = textureIds.intern(id);
+	if (textureId.value >= textureById.size()) {
+		textureById.resize(textureId.value + 1, nullptr);
+	}
+	textureById[textureId.value] = texture;
 	checkStoreSize();
-	texture->index = static_cast<uint32_t>(textures.size()-1);
+	lock_guard<mutex> lock(descriptorMutex);
+	texture->index = descriptorSlots.allocate();
+	slots.resize(descriptorSlots.size(), nullptr);
+	slots[texture->index] = texture;
 	return texture;
 }
 
+void TextureStore::unloadTexture(string id)
+{
+	auto it = textures.find(id);
+	if (it == textures.end()) {
+		Error("Texture not found");
+	}
+	TextureInfo* texture = &it->second;
+	// GPU may still use the texture in frames in flight
+	vkDeviceWaitIdle(engine->globalRendering.device);
+	engine->textureResidency.removeTexture(texture->index);
+	{
+		lock_guard<mutex> lock(descriptorMutex);
+		destroyGPUTexture(texture);
+		slots[texture->index] = nullptr;
+		descriptorSlots.release(texture->index);
+	}
+	if (texture->streamSource) {
+		engine->memoryTracker.untrack(texture->streamSource);
+		ktxTexture_Destroy(texture->streamSource);
+	}
+	engine->memoryTracker.untrack(&texture->float_buffer);
+	// keep id, a texture loaded later with same name gets it again
+	textureById[findTextureId(id).value] = nullptr;
+	textures.erase(it);
+	VulkanResources::updateDescriptorSetForTextures(engine);
+}
+
+void TextureStore::destroyGPUTexture(TextureInfo* texture)
+{
+	destroyGPUImage(texture->vulkanTexture, texture->imageView, texture->isKtxCreated);
+	texture->imageView = nullptr;
+	texture->vulkanTexture.image = nullptr;
+	texture->vulkanTexture.deviceMemory = nullptr;
+}
+
+void TextureStore::destroyGPUImage(ktxVulkanTexture& vulkanTexture, VkImageView imageView, bool isKtxCreated)
+{
+	auto& device = engine->globalRendering.device;
+	if (imageView) {
+		vkDestroyImageView(device, imageView, nullptr);
+	}
+	if (vulkanTexture.image == nullptr) return;
+	if (isKtxCreated) {
+		engine->memoryTracker.untrack(vulkanTexture.deviceMemory);
+		ktxVulkanTexture_Destruct(&vulkanTexture, device, nullptr);
+	} else {
+		vkDestroyImage(device, vulkanTexture.image, nullptr);
+		engine->globalRendering.freeMemory(vulkanTexture.deviceMemory);
+	}
+}
+
+bool TextureStore::isStreamable(ktxTexture* kTexture, TextureInfo* texture)
+{
+	if (!engine->textureResidency.isEnabled()) return false;
+	if (texture->type == TextureType::TEXTURE_TYPE_HEIGHT || texture->hasFlag(TextureFlags::KEEP_DATA_BUFFER)) return false;
+	return kTexture->numLevels > 1 && !kTexture->isCubemap && !kTexture->isArray && kTexture->numDimensions == 2
+		&& kTexture->numFaces == 1 && kTexture->numLayers == 1;
+}
+
+void TextureStore::createStreamedTexture(ktxTexture* kTexture, TextureInfo* texture)
+{
+	transcodeIfNeeded(kTexture);
+	texture->streamSource = kTexture;
+	engine->memoryTracker.track(kTexture, MemoryTag::Texture, MemoryDomain::Host, ktxTexture_GetDataSize(kTexture));
+	vector<uint64_t> mipBytes(kTexture->numLevels);
+	for (uint32_t m = 0; m < kTexture->numLevels; m++) {
+		mipBytes[m] = ktxTexture_GetImageSize(kTexture, m);
+	}
+	uint32_t tailMip = engine->textureResidency.addTexture(texture->index, kTexture->baseWidth, kTexture->baseHeight, mipBytes);
+	uploadMipRange(texture, tailMip);
+}
+
+void TextureStore::setResidentMips(uint32_t textureIndex, uint32_t firstMip)
+{
+	TextureInfo* texture;
+	{
+		// slots may be resized by texture loads in the app thread
+		lock_guard<mutex> lock(descriptorMutex);
+		texture = getTextureByIndex(textureIndex);
+	}
+	if (texture->streamSource == nullptr) {
+		Error("Texture residency change for texture without stream source");
+	}
+	uploadMipRange(texture, firstMip, residencyFrame);
+	lock_guard<mutex> lock(descriptorMutex);
+	descriptorSlots.markDirty(textureIndex);
+}
+
+void TextureStore::commitResidencyChanges()
+{
+	// image views of all changed textures have been replaced.
+	// Called from queue submit thread before submit, no frame using the old views is executing any more.
+	// Descriptor writes are serialized with the app thread by descriptorMutex
+	VulkanResources::updateDescriptorSetForTextures(engine);
+}
+
+void TextureStore::uploadMipRange(TextureInfo* texture, uint32_t firstMip, FrameResources* fr)
+{
+	auto& gr = engine->globalRendering;
+	ktxTexture* kTexture = texture->streamSource;
+	VkFormat format = ktxTexture_GetVkFormat(kTexture);
+	uint32_t levels = kTexture->numLevels - firstMip;
+	uint32_t width = std::max(kTexture->baseWidth >> firstMip, 1u);
+	uint32_t height = std::max(kTexture->baseHeight >> firstMip, 1u);
+
+	// copy all needed levels into one staging buffer, level offsets aligned for block compressed formats
+	vector<VkBufferImageCopy> regions(levels);
+	VkDeviceSize stagingSize = 0;
+	for (uint32_t i = 0; i < levels; i++) {
+		stagingSize = (stagingSize + 15) & ~VkDeviceSize(15);
+		VkBufferImageCopy& r = regions[i];
+		r = {};
+		r.bufferOffset = stagingSize;
+		r.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, i, 0, 1 };
+		r.imageExtent = { std::max(width >> i, 1u), std::max(height >> i, 1u), 1 };
+		stagingSize += ktxTexture_GetImageSize(kTexture, firstMip + i);
+	}
+	VkBuffer stagingBuffer;
+	VkDeviceMemory stagingMemory;
+	gr.createBuffer(stagingSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingMemory, "texture streaming staging buffer");
+	uint8_t* mapped;
+	vkMapMemory(gr.device, stagingMemory, 0, stagingSize, 0, (void**)&mapped);
+	for (uint32_t i = 0; i < levels; i++) {
+		ktx_size_t offset;
+		ktxTexture_GetImageOffset(kTexture, firstMip + i, 0, 0, &offset);
+		memcpy(mapped + regions[i].bufferOffset, ktxTexture_GetData(kTexture) + offset, ktxTexture_GetImageSize(kTexture, firstMip + i));
+	}
+	vkUnmapMemory(gr.device, stagingMemory);
+
+	VkImage image;
+	VkDeviceMemory imageMemory;
+	gr.createImage(width, height, levels, VK_SAMPLE_COUNT_1_BIT, format, VK_IMAGE_TILING_OPTIMAL,
+		VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		image, imageMemory, texture->id.c_str());
+
+	auto cmd = fr ? gr.getFrameUploadCommandBuffer(fr) : gr.beginSingleTimeCommands(true);
+	VkImageMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.srcAccessMask = 0;
+	barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = image;
+	barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, levels, 0, 1 };
+	vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+	vkCmdCopyBufferToImage(cmd, stagingBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, levels, regions.data());
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+	// the other thread may write descriptors from image views of this texture
+	lock_guard<mutex> lock(descriptorMutex);
+	if (fr) {
+		// old image may still be used by frames in flight, staging buffer is used by this frame
+		ktxVulkanTexture oldTexture = texture->vulkanTexture;
+		VkImageView oldView = texture->imageView;
+		bool oldKtx = texture->isKtxCreated;
+		gr.destroyDeferred(fr, [this, oldTexture, oldView, oldKtx, stagingBuffer, stagingMemory]() mutable {
+			destroyGPUImage(oldTexture, oldView, oldKtx);
+			vkDestroyBuffer(engine->globalRendering.device, stagingBuffer, nullptr);
+			engine->globalRendering.freeMemory(stagingMemory);
+		});
+	} else {
+		// waits for queue idle: old image is not in use any more after this
+		gr.endSingleTimeCommands(cmd, true);
+		vkDestroyBuffer(gr.device, stagingBuffer, nullptr);
+		gr.freeMemory(stagingMemory);
+		destroyGPUTexture(texture);
+	}
+	texture->isKtxCreated = false;
+	texture->vulkanTexture.image = image;
+	texture->vulkanTexture.deviceMemory = imageMemory;
+	texture->vulkanTexture.imageFormat = format;
+	texture->vulkanTexture.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	texture->vulkanTexture.width = width;
+	texture->vulkanTexture.height = height;
+	texture->vulkanTexture.depth = 1;
+	texture->vulkanTexture.levelCount = levels;
+	texture->vulkanTexture.layerCount = 1;
+	texture->imageView = gr.createImageView(image, format, VK_IMAGE_ASPECT_COLOR_BIT, levels);
+	texture->residentMip = firstMip;
+}
+
 // brdflut, Irradiance and PrefilteredEnv generation taken from:
 // https://github.com/SaschaWillems/Vulkan-glTF-PBR/blob/master/src/main.cpp
 
@@ -253,7 +544,11 @@ void TextureStore::generateCubemaps(std::string skyboxTexture, int32_t dimIrradi
 			cubemap->vulkanTexture.width = dim;
 			cubemap->vulkanTexture.levelCount = numMips;
 			cubemap->isKtxCreated = false;
-			cubemap->imageView = global.createImageView(cubemap->vulkanTexture.image, cubemap->vulkanTexture.imageFormat, VK_IMAGE_ASPECT_COLOR_BIT, 1);
+			{
+				VkImageView view = global.createImageView(cubemap->vulkanTexture.image, cubemap->vulkanTexture.imageFormat, VK_IMAGE_ASPECT_COLOR_BIT, 1);
+				lock_guard<mutex> lock(descriptorMutex);
+				cubemap->imageView = view;
+			}
 
 			// Sampler
 			VkSamplerCreateInfo samplerCI{};
@@ -361,6 +656,7 @@ void TextureStore::generateCubemaps(std::string skyboxTexture, int32_t dimIrradi
 			if (vkBindImageMemory(device, offscreen.image, offscreen.memory, 0) != VK_SUCCESS) {
                 Error("Cannot bind offscreen image memory in cubemap generation");
             }
+			engine->memoryTracker.track(offscreen.memory, MemoryTag::RenderTarget, MemoryDomain::Device, memReqs.size);
 
 			// View
 			VkImageViewCreateInfo viewCI{};
@@ -591,9 +887,7 @@ void TextureStore::generateCubemaps(std::string skyboxTexture, int32_t dimIrradi
 		// Look-up-table (from BRDF) pipeline		
 		shaderStages = { vertShaderModuleInfo, fragShaderModuleInfo };
 		VkPipeline pipeline;
-        if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineCI, nullptr, &pipeline) != VK_SUCCESS) {
-            Error("Cannot create graphics pipeline in cubemap generation");
-        }
+        engine->globalRendering.pipelineCache.createGraphicsPipeline(pipelineCI, &pipeline);
 		for (auto shaderStage : shaderStages) {
 			vkDestroyShaderModule(device, shaderStage.module, nullptr);
 		}
@@ -794,7 +1088,7 @@ void TextureStore::generateCubemaps(std::string skyboxTexture, int32_t dimIrradi
         //vkDestroySampler(device, cubemapSampler, nullptr); // destroyed in sampler cache
 		vkDestroyRenderPass(device, renderpass, nullptr);
 		vkDestroyFramebuffer(device, offscreen.framebuffer, nullptr);
-		vkFreeMemory(device, offscreen.memory, nullptr);
+		global.freeMemory(offscreen.memory);
 		vkDestroyImageView(device, offscreen.view, nullptr);
 		vkDestroyImage(device, offscreen.image, nullptr);
 		vkDestroyDescriptorPool(device, descriptorpool, nullptr);
@@ -836,7 +1130,11 @@ void TextureStore::generateBRDFLUT()
 	ti->vulkanTexture.width = dim;
 	ti->vulkanTexture.levelCount = 1;
 	ti->isKtxCreated = false;
-	ti->imageView = global.createImageView(ti->vulkanTexture.image, ti->vulkanTexture.imageFormat, VK_IMAGE_ASPECT_COLOR_BIT, 1);
+	{
+		VkImageView view = global.createImageView(ti->vulkanTexture.image, ti->vulkanTexture.imageFormat, VK_IMAGE_ASPECT_COLOR_BIT, 1);
+		lock_guard<mutex> lock(descriptorMutex);
+		ti->imageView = view;
+	}
 
 	// Sampler
 	VkSamplerCreateInfo samplerCI{};
@@ -1019,9 +1317,7 @@ void TextureStore::generateBRDFLUT()
 	// Look-up-table (from BRDF) pipeline		
 	shaderStages = { vertShaderModuleInfo, fragShaderModuleInfo };
 	VkPipeline pipeline;
-	if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineCI, nullptr, &pipeline) != VK_SUCCESS) {
-		Error("Cannot create pipeline in BRDFLUT generation");
-	}
+	engine->globalRendering.pipelineCache.createGraphicsPipeline(pipelineCI, &pipeline);
 	for (auto shaderStage : shaderStages) {
 		vkDestroyShaderModule(device, shaderStage.module, nullptr);
 	}
@@ -1090,8 +1386,12 @@ void TextureStore::setTextureActive(std::string id, bool active)
 {
     auto ti = textures.find(id);
     if (ti != textures.end()) {
-        ti->second.available = active;
-		// recreate texture pool descriptor set
+		{
+			lock_guard<mutex> lock(descriptorMutex);
+			ti->second.available = active;
+			descriptorSlots.markDirty(ti->second.index);
+		}
+		// write changed descriptors
 		VulkanResources::updateDescriptorSetForTextures(engine);
 		//Log("tex added and descriptor set updated: " << ti->second.id.c_str() << " index: " << ti->second.index << endl);
 		return;
@@ -1105,13 +1405,19 @@ TextureStore::~TextureStore()
 	for (auto& tex : textures) {
 		auto &ti = tex.second;
 		Log("Texture found: " << ti.id.c_str() << " " << ti.filename.c_str() << " " << ti.vulkanTexture.deviceMemory << endl);
+		if (ti.streamSource) {
+			engine->memoryTracker.untrack(ti.streamSource);
+			ktxTexture_Destroy(ti.streamSource);
+		}
+		engine->memoryTracker.untrack(&ti.float_buffer);
 		if (ti.isAvailable()) {
 			vkDestroyImageView(engine->globalRendering.device, tex.second.imageView, nullptr);
 			if (ti.isKtxCreated) {
+				engine->memoryTracker.untrack(ti.vulkanTexture.deviceMemory);
 				ktxVulkanTexture_Destruct(&ti.vulkanTexture, engine->globalRendering.device, nullptr);
 			} else {
 				vkDestroyImage(device, ti.vulkanTexture.image, nullptr);
-				vkFreeMemory(device, ti.vulkanTexture.deviceMemory, nullptr);
+				engine->globalRendering.freeMemory(ti.vulkanTexture.deviceMemory);
 			}
 		}
 	}
@@ -76,6 +76,9 @@ struct TextureInfo
     VkSampler sampler = nullptr; // for texture type gltf we use the sampler directly
 	std::vector<float> float_buffer;
     TextureFlags flags = TextureFlags::NONE;
+	// streamed textures keep their ktx data to upload mip levels on demand (see TextureResidency)
+	ktxTexture* streamSource = nullptr;
+	uint32_t residentMip = 0; // finest mip level currently on GPU
     bool hasFlag(TextureFlags flag) const {
         return ::hasFlag(flags, flag);
     }
@@ -86,8 +89,48 @@ private:
 };
 typedef ::TextureInfo* TextureID;
 
+// slot bookkeeping for the bindless texture descriptor array: slots of unloaded textures are recycled via free list,
+// changed slots are collected as dirty ranges so descriptor updates only write what changed
+class DescriptorSlots
+{
+public:
+	struct Range {
+		uint32_t first = 0;
+		uint32_t count = 0;
+	};
+	// reuse slots of released entries first to keep descriptor array dense
+	uint32_t allocate();
+	// slot is marked dirty, descriptor has to be replaced by a valid one
+	void release(uint32_t slot);
+	void markDirty(uint32_t slot);
+	void markAllDirty();
+	bool isUsed(uint32_t slot) const {
+		return slot < used.size() && used[slot];
+	}
+	// number of slots (highest allocated slot + 1), free slots included
+	uint32_t size() const {
+		return static_cast<uint32_t>(used.size());
+	}
+	uint32_t usedCount() const {
+		return numUsed;
+	}
+	bool hasDirty() const {
+		return !dirtyList.empty();
+	}
+	// sorted dirty ranges, clears dirty state. Ranges separated by up to maxGap clean slots are joined
+	// into one range: rewriting a few unchanged descriptors is cheaper than an additional write
+	std::vector<Range> takeDirtyRanges(uint32_t maxGap = 0);
+private:
+	std::vector<uint8_t> used;
+	std::vector<uint8_t> dirty;
+	std::vector<uint32_t> dirtyList; // unsorted, no duplicates
+	std::vector<uint32_t> freeList;
+	uint32_t numUsed = 0;
+};
+
 // Texture Store. Textures have to be added during init phase, otherwise they will not be accessible by shaders
-class TextureStore {
+// If texture residency is enabled, mipmapped 2D textures are streamed: only the mip tail is uploaded on load
+class TextureStore : public TextureResidencyDevice {
 public:
 	// max number of textures usable in engine is 1 million.
 	// Do not confuse with maxTextures (actual max texture count) which is set by app at startup
@@ -114,9 +157,36 @@ public:
         return static_cast<int>(textures.size());
     }
 	// get texture by name
-	::TextureInfo* getTexture(std::string id);
+	::TextureInfo* getTexture(const std::string& id);
+	// handle indexed lookup, Error if texture is not available
+	::TextureInfo* getTexture(TextureId id);
+	// resolve texture name once, invalid id if no texture with this name was created
+	TextureId findTextureId(std::string_view id) const {
+		return textureIds.find(id);
+	}
 	// get texture by index to global descriptor table (== index)
 	::TextureInfo* getTextureByIndex(uint32_t index);
+	// number of used descriptor slots (highest index + 1), free slots of unloaded textures included
+	uint32_t getSlotCount() {
+		return static_cast<uint32_t>(slots.size());
+	}
+	// texture in descriptor slot, nullptr for free slots
+	::TextureInfo* getTextureInSlot(uint32_t index) {
+		return slots[index];
+	}
+	// descriptor slots changed since last call, see VulkanResources::updateDescriptorSetForTextures()
+	std::vector<DescriptorSlots::Range> takeDirtyDescriptorRanges(uint32_t maxGap) {
+		return descriptorSlots.takeDirtyRanges(maxGap);
+	}
+	void markDescriptorDirty(uint32_t index) {
+		descriptorSlots.markDirty(index);
+	}
+	void markAllDescriptorsDirty() {
+		descriptorSlots.markAllDirty();
+	}
+	// destroy texture and free its slot for reuse by next created texture.
+	// Application has to make sure that no material references the texture any more
+	void unloadTexture(std::string id);
 	// create texture slot for named texture
 	::TextureInfo* createTextureSlot(std::string id);
 	// create texture id and slot for mesh texture with index
@@ -127,6 +197,17 @@ public:
 	// only ktx files are allowed with mipmaps already created.
 	void createVulkanTextureFromKTKTexture(ktxTexture* ktxTexture, ::TextureInfo* textureInfo);
 	void destroyKTXIntermediate(ktxTexture* ktxTex);
+	// true if texture will be streamed by texture residency
+	bool isStreamable(ktxTexture* ktxTexture, ::TextureInfo* textureInfo);
+	// upload mip tail of texture and register with texture residency. Takes ownership of ktxTexture
+	void createStreamedTexture(ktxTexture* ktxTexture, ::TextureInfo* textureInfo);
+	// TextureResidencyDevice: recreate GPU image with mip levels [firstMip, last level]
+	void setResidentMips(uint32_t textureIndex, uint32_t firstMip) override;
+	void commitResidencyChanges() override;
+	// frame whose upload command buffer receives residency uploads, set by TextureResidency::updateForFrame()
+	void setResidencyFrame(FrameResources* fr) {
+		residencyFrame = fr;
+	}
 	// Generate a BRDF integration map storing roughness/NdotV as a look-up-table
 	// BRDF stands for Bidirectional Reflectance Distribution Function
 	void generateBRDFLUT();
@@ -142,10 +223,17 @@ public:
 	VkDescriptorSetLayout layout = nullptr;
 	VkDescriptorPool pool = nullptr;
 	VkDescriptorSet descriptorSet = nullptr;
+	// image view written to free slots, all free slots are rewritten if it changes
+	VkImageView descriptorFillView = nullptr;
+	// guards descriptor slots, image views of textures in slots and writes to descriptorSet.
+	// Textures are loaded, activated and unloaded by the app thread, residency changes are applied by the queue submit thread
+	std::mutex descriptorMutex;
 	// activate / deactivate texture
     void setTextureActive(std::string id, bool active);
 private:
 	std::unordered_map<std::string, ::TextureInfo> textures;
+	InternTable<TextureId> textureIds;
+	std::vector<::TextureInfo*> textureById; // indexed by TextureId, nullptr for unloaded textures
 	ShadedPathEngine* engine = nullptr;
 	Util* util = nullptr;
 	ktxVulkanDeviceInfo vdi = {};
@@ -154,6 +242,19 @@ private:
 	void checkStoreSize();
 	// all creation methods have to call this internally:
 	::TextureInfo* internalCreateTextureSlot(std::string id);
+	std::vector<::TextureInfo*> slots; // texture for each descriptor index, nullptr for free slots
+	DescriptorSlots descriptorSlots;
+	// transcode basis compressed KTX2 textures to BC7
+	void transcodeIfNeeded(ktxTexture* kTexture);
+	// create GPU image from mip levels [firstMip, last level] of stream source, replaces current image.
+	// Without frame the upload is synchronous (load time), otherwise it is recorded into the upload command buffer
+	// of the frame and the old image is destroyed after all frames in flight have finished
+	void uploadMipRange(::TextureInfo* texture, uint32_t firstMip, FrameResources* fr = nullptr);
+	void destroyGPUTexture(::TextureInfo* texture);
+	void destroyGPUImage(ktxVulkanTexture& vulkanTexture, VkImageView imageView, bool isKtxCreated);
+	FrameResources* residencyFrame = nullptr;
+	// report image memory allocated by ktx upload to memory tracker
+	void trackKTXTexture(::TextureInfo* texture);
 };
 
 // vertex def for cubemaps calculation
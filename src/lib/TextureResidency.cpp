@@ -0,0 +1,259 @@
+#include "mainheader.h"
+
+using namespace std;
+using namespace glm;
+
+void TextureResidencyStats::log() const
+{
+	Log("Texture residency: " << residentBytes / (1024 * 1024) << " MB of " << budgetBytes / (1024 * 1024) << " MB budget resident, "
+		<< requestedBytes / (1024 * 1024) << " MB requested. textures " << streamedTextures << " satisfied " << satisfiedTextures
+		<< " starved " << starvedTextures << endl);
+	Log("  total mip upgrades " << mipUpgrades << " (" << uploadedBytes / (1024 * 1024) << " MB) mip evictions " << mipEvictions << endl);
+}
+
+TextureResidency::TextureResidency()
+{
+	setViewport(glm::radians(45.0f), 1080.0f);
+}
+
+void TextureResidency::setViewport(float fovy, float viewportHeight)
+{
+	pixelFactor = viewportHeight / (2.0f * tan(fovy * 0.5f));
+}
+
+uint32_t TextureResidency::addTexture(uint32_t textureIndex, uint32_t width, uint32_t height, const vector<uint64_t>& mipBytes)
+{
+	lock_guard<mutex> lock(residencyMutex);
+	if (entryIndex.find(textureIndex) != entryIndex.end()) {
+		Error("TextureResidency: texture already registered");
+	}
+	if (mipBytes.empty()) {
+		Error("TextureResidency: texture without mip levels");
+	}
+	Entry e;
+	e.textureIndex = textureIndex;
+	e.maxSize = std::max(width, height);
+	uint32_t levels = static_cast<uint32_t>(mipBytes.size());
+	e.bytesFrom.resize(levels + 1, 0);
+	for (uint32_t m = levels; m > 0; m--) {
+		e.bytesFrom[m - 1] = e.bytesFrom[m] + mipBytes[m - 1];
+	}
+	e.tailMip = 0;
+	while (e.tailMip + 1 < levels && (e.maxSize >> e.tailMip) > MIN_RESIDENT_SIZE) {
+		e.tailMip++;
+	}
+	e.residentMip = e.tailMip;
+	e.desiredMip = e.tailMip;
+	residentBytes += e.bytesAt(e.residentMip);
+	entryIndex[textureIndex] = entries.size();
+	entries.push_back(std::move(e));
+	return entries.back().tailMip;
+}
+
+void TextureResidency::removeTexture(uint32_t textureIndex)
+{
+	lock_guard<mutex> lock(residencyMutex);
+	auto it = entryIndex.find(textureIndex);
+	if (it == entryIndex.end()) return;
+	size_t i = it->second;
+	residentBytes -= entries[i].bytesAt(entries[i].residentMip);
+	entryIndex.erase(it);
+	if (i != entries.size() - 1) {
+		entries[i] = std::move(entries.back());
+		entryIndex[entries[i].textureIndex] = i;
+	}
+	entries.pop_back();
+}
+
+void TextureResidency::requestTexture(uint32_t textureIndex, float screenSize, float distance)
+{
+	lock_guard<mutex> lock(residencyMutex);
+	requestTextureUnlocked(textureIndex, screenSize, distance);
+}
+
+void TextureResidency::requestTextureUnlocked(uint32_t textureIndex, float screenSize, float distance)
+{
+	auto it = entryIndex.find(textureIndex);
+	if (it == entryIndex.end()) return; // not streamed
+	Entry& e = entries[it->second];
+	if (e.lastRequested != updateCounter) {
+		e.lastRequested = updateCounter;
+		e.screenSize = 0.0f;
+		e.distance = FLT_MAX;
+	}
+	e.screenSize = std::max(e.screenSize, screenSize);
+	e.distance = std::min(e.distance, distance);
+}
+
+uint32_t TextureResidency::mipForScreenSize(const Entry& e, float screenSize) const
+{
+	// one texel per pixel: each mip level halves the texture size
+	if (screenSize <= 0.0f) return e.tailMip;
+	float ratio = static_cast<float>(e.maxSize) / screenSize;
+	if (ratio <= 1.0f) return 0;
+	uint32_t mip = static_cast<uint32_t>(floor(log2(ratio)));
+	return std::min(mip, e.tailMip);
+}
+
+uint32_t TextureResidency::getResidentMip(uint32_t textureIndex) const
+{
+	auto it = entryIndex.find(textureIndex);
+	if (it == entryIndex.end()) return 0;
+	return entries[it->second].residentMip;
+}
+
+uint32_t TextureResidency::getDesiredMip(uint32_t textureIndex) const
+{
+	auto it = entryIndex.find(textureIndex);
+	if (it == entryIndex.end()) return 0;
+	return entries[it->second].desiredMip;
+}
+
+void TextureResidency::applyChange(TextureResidencyDevice& device, Entry& e, uint32_t mip)
+{
+	if (mip == e.residentMip) return;
+	if (mip < e.residentMip) {
+		stats.mipUpgrades += e.residentMip - mip;
+		stats.uploadedBytes += e.bytesAt(mip) - e.bytesAt(e.residentMip);
+	} else {
+		stats.mipEvictions += mip - e.residentMip;
+	}
+	residentBytes = residentBytes - e.bytesAt(e.residentMip) + e.bytesAt(mip);
+	e.residentMip = mip;
+	device.setResidentMips(e.textureIndex, mip);
+	deviceChanges++;
+}
+
+bool TextureResidency::makeRoom(TextureResidencyDevice& device, uint64_t needed, const Entry* forEntry, vector<size_t>& victims, size_t& nextVictim)
+{
+	uint64_t freed = 0;
+	while (freed < needed && nextVictim < victims.size()) {
+		Entry& v = entries[victims[nextVictim]];
+		if (forEntry) {
+			// victims are sorted: once a victim is as useful as the request, all following ones are too
+			bool lessUseful = v.lastRequested < forEntry->lastRequested || v.screenSize < forEntry->screenSize;
+			if (!lessUseful) return false;
+		}
+		// release finest mips first, only as many as needed
+		uint32_t target = v.residentMip;
+		while (target < v.desiredMip && freed + v.bytesAt(v.residentMip) - v.bytesAt(target) < needed) {
+			target++;
+		}
+		freed += v.bytesAt(v.residentMip) - v.bytesAt(target);
+		applyChange(device, v, target);
+		if (v.residentMip >= v.desiredMip) {
+			nextVictim++;
+		}
+	}
+	return freed >= needed;
+}
+
+uint32_t TextureResidency::update(TextureResidencyDevice& device)
+{
+	lock_guard<mutex> lock(residencyMutex);
+	stats.requestedBytes = 0;
+	stats.starvedTextures = 0;
+	vector<size_t> upgrades;
+	vector<size_t> victims;
+	for (size_t i = 0; i < entries.size(); i++) {
+		Entry& e = entries[i];
+		// textures without request since last update only need their mip tail
+		bool requested = e.lastRequested == updateCounter;
+		e.desiredMip = requested ? mipForScreenSize(e, e.screenSize) : e.tailMip;
+		stats.requestedBytes += e.bytesAt(e.desiredMip);
+		if (e.desiredMip < e.residentMip) upgrades.push_back(i);
+		else if (e.desiredMip > e.residentMip) victims.push_back(i);
+	}
+	// most useful upgrades first: large on screen, then near
+	sort(upgrades.begin(), upgrades.end(), [this](size_t a, size_t b) {
+		const Entry& ea = entries[a];
+		const Entry& eb = entries[b];
+		if (ea.screenSize != eb.screenSize) return ea.screenSize > eb.screenSize;
+		return ea.distance < eb.distance;
+	});
+	// surplus mips are released in order: not requested for the longest time, then smallest on screen
+	sort(victims.begin(), victims.end(), [this](size_t a, size_t b) {
+		const Entry& ea = entries[a];
+		const Entry& eb = entries[b];
+		if (ea.lastRequested != eb.lastRequested) return ea.lastRequested < eb.lastRequested;
+		return ea.screenSize < eb.screenSize;
+	});
+
+	deviceChanges = 0;
+	uint32_t upgraded = 0;
+	size_t nextVictim = 0;
+	for (size_t i : upgrades) {
+		Entry& e = entries[i];
+		if (upgraded >= maxChangesPerUpdate) {
+			stats.starvedTextures++;
+			continue;
+		}
+		uint64_t needed = e.bytesAt(e.desiredMip) - e.bytesAt(e.residentMip);
+		if (residentBytes + needed > budget) {
+			makeRoom(device, residentBytes + needed - budget, &e, victims, nextVictim);
+		}
+		// finest mip that fits into the budget
+		uint32_t target = e.desiredMip;
+		while (target < e.residentMip && residentBytes + e.bytesAt(target) - e.bytesAt(e.residentMip) > budget) {
+			target++;
+		}
+		if (target != e.desiredMip) stats.starvedTextures++;
+		if (target < e.residentMip) {
+			applyChange(device, e, target);
+			upgraded++;
+		}
+	}
+	// budget may have been lowered: release surplus even without upgrades
+	if (residentBytes > budget) {
+		makeRoom(device, residentBytes - budget, nullptr, victims, nextVictim);
+	}
+	if (deviceChanges > 0) {
+		device.commitResidencyChanges();
+	}
+
+	stats.budgetBytes = budget;
+	stats.residentBytes = residentBytes;
+	stats.streamedTextures = static_cast<uint32_t>(entries.size());
+	stats.satisfiedTextures = 0;
+	for (auto& e : entries) {
+		if (e.residentMip <= e.desiredMip) stats.satisfiedTextures++;
+	}
+	updateCounter++;
+	return deviceChanges;
+}
+
+void TextureResidency::requestFromWorldObjects(glm::vec3 cameraPos)
+{
+	lock_guard<mutex> lock(residencyMutex);
+	for (WorldObject* wo : engine->objectStore.getSortedList()) {
+		if (wo->mesh == nullptr || !wo->enabled) continue;
+		// conservative sphere around object origin, same as in LodSelection
+		BoundingBox box;
+		wo->mesh->getBoundingBox(box);
+		float maxScale = std::max(wo->scale().x, std::max(wo->scale().y, wo->scale().z));
+		float radius = std::max(glm::length(box.min), glm::length(box.max)) * maxScale;
+		float distance = std::max(glm::length(wo->pos() - cameraPos) - radius, 0.01f);
+		float screenSize = 2.0f * radius * pixelFactor / distance;
+		MeshInfo* mi = engine->meshStore.getNextPrimitiveMeshForObject(wo, nullptr);
+		while (mi != nullptr) {
+			for (::TextureInfo* t : { mi->baseColorTexture, mi->metallicRoughnessTexture, mi->normalTexture, mi->occlusionTexture, mi->emissiveTexture }) {
+				if (t) requestTextureUnlocked(t->index, screenSize, distance);
+			}
+			mi = engine->meshStore.getNextPrimitiveMeshForObject(wo, mi);
+		}
+	}
+}
+
+void TextureResidency::requestPerFrame()
+{
+	if (!isEnabled() || camera == nullptr) return;
+	requestFromWorldObjects(camera->getPosition());
+}
+
+void TextureResidency::updateForFrame(FrameResources* fr)
+{
+	if (!isEnabled()) return;
+	engine->textureStore.setResidencyFrame(fr);
+	update(engine->textureStore);
+	engine->textureStore.setResidencyFrame(nullptr);
+}
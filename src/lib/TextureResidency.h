@@ -0,0 +1,128 @@
+#pragma once
+
+// Texture residency: keeps GPU memory of streamed textures within a budget.
+// Streamed textures start with their mip tail (all levels up to MIN_RESIDENT_SIZE) and finer levels are
+// uploaded on demand, driven by the screen size of the objects using them.
+// If the budget is exceeded, surplus mips of the least useful textures (not requested recently, small on screen)
+// are released again. Mip tails are never released, so texture indexes in materials stay valid.
+// All decisions are made here on the CPU, the actual GPU work is done by a TextureResidencyDevice
+// (TextureStore for real rendering, a simulated device for tests).
+// In the engine, requests are collected on the render thread (requestPerFrame()) and the update runs on the
+// queue submit thread (updateForFrame()) while no earlier frame is executing on the GPU.
+// Uploads are recorded into the upload command buffer of that frame, replaced images are destroyed deferred.
+
+struct TextureResidencyStats {
+	uint64_t budgetBytes = 0;
+	uint64_t residentBytes = 0;
+	uint64_t requestedBytes = 0; // bytes needed to satisfy all current requests
+	uint32_t streamedTextures = 0;
+	uint32_t satisfiedTextures = 0; // textures with all requested mips resident
+	uint32_t starvedTextures = 0; // requests that could not be satisfied in last update because of budget
+	// cumulative counters
+	uint64_t uploadedBytes = 0;
+	uint32_t mipUpgrades = 0;
+	uint32_t mipEvictions = 0;
+	void log() const;
+};
+
+class Camera;
+
+class TextureResidencyDevice {
+public:
+	virtual ~TextureResidencyDevice() {}
+	// make mip levels [firstMip, last level] of texture resident. Levels before firstMip are released
+	virtual void setResidentMips(uint32_t textureIndex, uint32_t firstMip) = 0;
+	// called once after all changes of one update (e.g. descriptor update)
+	virtual void commitResidencyChanges() {}
+};
+
+class TextureResidency : public EngineParticipant
+{
+public:
+	// mip levels with width and height up to this size are always resident
+	static constexpr uint32_t MIN_RESIDENT_SIZE = 128;
+
+	TextureResidency();
+
+	// GPU memory budget for streamed textures in bytes, 0 disables streaming (all textures are loaded completely)
+	void setBudget(uint64_t bytes) {
+		budget = bytes;
+	}
+	bool isEnabled() const {
+		return budget > 0;
+	}
+	// limit number of upgraded textures per update to spread upload work over frames
+	void setMaxChangesPerUpdate(uint32_t n) {
+		maxChangesPerUpdate = n;
+	}
+	// vertical field of view in radians and viewport height in pixels, used to calculate screen size of objects
+	void setViewport(float fovy, float viewportHeight);
+
+	// register streamed texture with byte size of each mip level (level 0 first).
+	// returns first mip level that has to be made resident initially (mip tail)
+	uint32_t addTexture(uint32_t textureIndex, uint32_t width, uint32_t height, const std::vector<uint64_t>& mipBytes);
+	void removeTexture(uint32_t textureIndex);
+	bool isStreamed(uint32_t textureIndex) const {
+		return entryIndex.find(textureIndex) != entryIndex.end();
+	}
+	// report texture usage for next update. screenSize is the size in pixels of the textured object on screen.
+	// multiple requests for the same texture keep the largest screen size
+	void requestTexture(uint32_t textureIndex, float screenSize, float distance);
+	// decide mip changes for current requests and apply them to device. Returns number of device changes
+	uint32_t update(TextureResidencyDevice& device);
+
+	uint32_t getResidentMip(uint32_t textureIndex) const;
+	uint32_t getDesiredMip(uint32_t textureIndex) const;
+	const TextureResidencyStats& getStats() const {
+		return stats;
+	}
+
+	// engine integration
+	// request all textures of objects in engine object store, screen size from bounding sphere and camera distance
+	void requestFromWorldObjects(glm::vec3 cameraPos);
+	// camera for screen size of objects, no textures are requested without camera
+	void setCamera(const Camera* camera) {
+		this->camera = camera;
+	}
+	// called by engine on render thread after app prepareFrame(): request textures of all objects seen from camera
+	void requestPerFrame();
+	// called by engine on queue submit thread before frame is submitted: update residency via engine texture store,
+	// uploads are recorded into the upload command buffer of the frame
+	void updateForFrame(FrameResources* fr);
+
+private:
+	struct Entry {
+		uint32_t textureIndex = 0;
+		uint32_t maxSize = 0; // max(width, height) of level 0
+		std::vector<uint64_t> bytesFrom; // bytesFrom[m]: size of levels m..last
+		uint32_t tailMip = 0;
+		uint32_t residentMip = 0;
+		uint32_t desiredMip = 0;
+		float screenSize = 0.0f; // largest requested screen size since last update
+		float distance = 0.0f; // smallest requested distance since last update
+		uint64_t lastRequested = 0; // update counter
+		uint64_t bytesAt(uint32_t mip) const {
+			return bytesFrom[mip];
+		}
+	};
+	void requestTextureUnlocked(uint32_t textureIndex, float screenSize, float distance);
+	// change resident mip and keep byte accounting
+	void applyChange(TextureResidencyDevice& device, Entry& e, uint32_t mip);
+	// mip needed for screen size
+	uint32_t mipForScreenSize(const Entry& e, float screenSize) const;
+	// release surplus mips until needed bytes are free. Only entries less useful than 'forEntry' are touched
+	bool makeRoom(TextureResidencyDevice& device, uint64_t needed, const Entry* forEntry, std::vector<size_t>& victims, size_t& nextVictim);
+
+	std::vector<Entry> entries;
+	std::unordered_map<uint32_t, size_t> entryIndex; // texture index -> entries index
+	uint64_t budget = 0;
+	uint64_t residentBytes = 0;
+	uint64_t updateCounter = 1;
+	uint32_t maxChangesPerUpdate = 16;
+	uint32_t deviceChanges = 0; // in current update
+	float pixelFactor = 1.0f; // viewportHeight / (2 * tan(fovy/2))
+	const Camera* camera = nullptr;
+	// requests come from render thread, updates from queue submit thread
+	std::mutex residencyMutex;
+	TextureResidencyStats stats;
+};
@@ -17,16 +17,19 @@ FrameResources::~FrameResources() {
     if (presentFence) vkDestroyFence(device, presentFence, nullptr);
     if (inFlightFence) vkDestroyFence(device, inFlightFence, nullptr);
     if (uiRenderFinished) vkDestroyEvent(device, uiRenderFinished, nullptr);
-    if (colorImage.fba.memory) vkFreeMemory(device, colorImage.fba.memory, nullptr);
-    if (depthImageMemory) vkFreeMemory(device, depthImageMemory, nullptr);
+    if (colorImage.fba.memory) global.freeMemory(colorImage.fba.memory);
+    if (depthImageMemory) global.freeMemory(depthImageMemory);
     if (colorImage.fba.view) vkDestroyImageView(device, colorImage.fba.view, nullptr);
     if (depthImageView) vkDestroyImageView(device, depthImageView, nullptr);
     if (commandPool) vkDestroyCommandPool(device, commandPool, nullptr);
+    if (colorImageArrayView) vkDestroyImageView(device, colorImageArrayView, nullptr);
+    if (depthImageArrayView) vkDestroyImageView(device, depthImageArrayView, nullptr);
     if (engine && engine->isStereo()) {
-        if (colorImage2.fba.image) vkDestroyImage(device, colorImage2.fba.image, nullptr);
+        // shared with colorImage in multiview mode
+        if (colorImage2.fba.image && colorImage2.fba.image != colorImage.fba.image) vkDestroyImage(device, colorImage2.fba.image, nullptr);
         if (depthImage2) vkDestroyImage(device, depthImage2, nullptr);
-        if (colorImage2.fba.memory) vkFreeMemory(device, colorImage2.fba.memory, nullptr);
-        if (depthImageMemory2) vkFreeMemory(device, depthImageMemory2, nullptr);
+        if (colorImage2.fba.memory) global.freeMemory(colorImage2.fba.memory);
+        if (depthImageMemory2) global.freeMemory(depthImageMemory2);
         if (colorImage2.fba.view) vkDestroyImageView(device, colorImage2.fba.view, nullptr);
         if (depthImageView2) vkDestroyImageView(device, depthImageView2, nullptr);
     }
@@ -97,8 +100,10 @@ void FrameResources::createBackBufferImage()
     auto& global = engine->globalRendering;
     // Color attachment
     auto name = engine->util.createDebugName("FrameInfo BackBufferImage", frameIndex);
+    // multiview: one image with a layer for each eye
+    uint32_t layers = engine->isMultiview() ? 2 : 1;
     global.createImage(engine->getBackBufferExtent().width, engine->getBackBufferExtent().height, 1, VK_SAMPLE_COUNT_1_BIT, global.ImageFormat, VK_IMAGE_TILING_OPTIMAL,
-        VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, colorImage.fba.image, colorImage.fba.memory, name.c_str());
+        VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, colorImage.fba.image, colorImage.fba.memory, name.c_str(), layers);
     colorImage.fba.view = global.createImageView(colorImage.fba.image, global.ImageFormat, VK_IMAGE_ASPECT_COLOR_BIT, 1);
     colorImage.width = engine->getBackBufferExtent().width;
     colorImage.height = engine->getBackBufferExtent().height;
@@ -106,11 +111,19 @@ void FrameResources::createBackBufferImage()
     colorImage.layout = VK_IMAGE_LAYOUT_UNDEFINED;
     colorImage.rendered = false;
     colorImage.consumed = false;
-    if (engine->isStereo()) {
+    if (engine->isMultiview()) {
+        // right eye is layer 1 of the same image, memory is owned by colorImage
+        colorImage2.fba.image = colorImage.fba.image;
+        colorImage2.fba.view = global.createImageViewLayers(colorImage.fba.image, global.ImageFormat, VK_IMAGE_ASPECT_COLOR_BIT, 1, 1);
+        colorImage2.arrayLayer = 1;
+        colorImageArrayView = global.createImageViewLayers(colorImage.fba.image, global.ImageFormat, VK_IMAGE_ASPECT_COLOR_BIT, 0, 2);
+    } else if (engine->isStereo()) {
         auto name = engine->util.createDebugName("FrameInfo Stereo BackBufferImage", frameIndex);
         global.createImage(engine->getBackBufferExtent().width, engine->getBackBufferExtent().height, 1, VK_SAMPLE_COUNT_1_BIT, global.ImageFormat, VK_IMAGE_TILING_OPTIMAL,
             VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, colorImage2.fba.image, colorImage2.fba.memory, name.c_str());
         colorImage2.fba.view = global.createImageView(colorImage2.fba.image, global.ImageFormat, VK_IMAGE_ASPECT_COLOR_BIT, 1);
+    }
+    if (engine->isStereo()) {
         colorImage2.width = engine->getBackBufferExtent().width;
         colorImage2.height = engine->getBackBufferExtent().height;
         colorImage2.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
@@ -126,10 +139,15 @@ void FrameResources::createDepthResources()
     VkFormat depthFormat = engine->globalRendering.depthFormat;
 
     auto name = engine->util.createDebugName("FrameInfo DepthImage_", frameIndex);
+    uint32_t layers = engine->isMultiview() ? 2 : 1;
     engine->globalRendering.createImage(engine->getBackBufferExtent().width, engine->getBackBufferExtent().height, 1, VK_SAMPLE_COUNT_1_BIT, depthFormat, VK_IMAGE_TILING_OPTIMAL,
-        VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, depthImage, depthImageMemory, name.c_str());
+        VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, depthImage, depthImageMemory, name.c_str(), layers);
     depthImageView = engine->globalRendering.createImageView(depthImage, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT, 1);
-    if (engine->isStereo()) {
+    if (engine->isMultiview()) {
+        // depthImage2 stays nullptr, right eye only has its view of layer 1
+        depthImageView2 = engine->globalRendering.createImageViewLayers(depthImage, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT, 1, 1);
+        depthImageArrayView = engine->globalRendering.createImageViewLayers(depthImage, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT, 0, 2);
+    } else if (engine->isStereo()) {
         auto name = engine->util.createDebugName("FrameInfo Stereo DepthImage_", frameIndex);
         engine->globalRendering.createImage(engine->getBackBufferExtent().width, engine->getBackBufferExtent().height, 1, VK_SAMPLE_COUNT_1_BIT, depthFormat, VK_IMAGE_TILING_OPTIMAL,
             VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, depthImage2, depthImageMemory2, name.c_str());
@@ -264,20 +282,20 @@ ThreadResources::~ThreadResources()
     vkDestroyCommandPool(device, commandPool, nullptr);
     vkDestroyImageView(device, depthImageView, nullptr);
     vkDestroyImage(device, depthImage, nullptr);
-    vkFreeMemory(device, depthImageMemory, nullptr);
+    engine->globalRendering.freeMemory(depthImageMemory);
     vkDestroyImageView(device, imageDumpAttachment.view, nullptr);
     vkDestroyImage(device, imageDumpAttachment.image, nullptr);
-    vkFreeMemory(device, imageDumpAttachment.memory, nullptr);
+    engine->globalRendering.freeMemory(imageDumpAttachment.memory);
     vkDestroyImageView(device, colorAttachment.view, nullptr);
     vkDestroyImage(device, colorAttachment.image, nullptr);
-    vkFreeMemory(device, colorAttachment.memory, nullptr);
+    engine->globalRendering.freeMemory(colorAttachment.memory);
     if (engine->isStereo()) {
         vkDestroyImageView(device, depthImageView2, nullptr);
         vkDestroyImage(device, depthImage2, nullptr);
-        vkFreeMemory(device, depthImageMemory2, nullptr);
+        engine->globalRendering.freeMemory(depthImageMemory2);
         vkDestroyImageView(device, colorAttachment2.view, nullptr);
         vkDestroyImage(device, colorAttachment2.image, nullptr);
-        vkFreeMemory(device, colorAttachment2.memory, nullptr);
+        engine->globalRendering.freeMemory(colorAttachment2.memory);
     }
     Log("ThreadResource destructed: " << this << endl);
 };
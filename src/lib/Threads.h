@@ -234,54 +234,36 @@ public:
 
 
 // queue for syncing render and queue submit threads:
+// also used for background thread requests, which can come from any thread
 class RenderQueue {
 public:
-	// wait until next frame has finished rendering
+	// wait until next frame has finished rendering, nullptr after shutdown
 	QueueSubmitResources* pop() {
-		std::unique_lock<std::mutex> lock(monitorMutex);
-		while (myqueue.empty()) {
-			cond.wait_for(lock, std::chrono::milliseconds(3000));
-			LogCondF(LOG_QUEUE, "RenderQueue wait suspended\n");
-			if (in_shutdown) {
-				LogCondF(LOG_QUEUE, "RenderQueue shutdown in pop\n");
-				cond.notify_all();
-				return nullptr;
-			}
+		auto frame = queue.pop();
+		if (!frame) {
+			LogCondF(LOG_QUEUE, "RenderQueue shutdown in pop\n");
+			return nullptr;
 		}
-		assert(myqueue.empty() == false);
-		QueueSubmitResources* frame = myqueue.front();
-		myqueue.pop();
-		cond.notify_one();
-		return frame;
+		return *frame;
 	}
 
 	// push finished frame
 	void push(QueueSubmitResources* frame) {
-		std::unique_lock<std::mutex> lock(monitorMutex);
-		if (in_shutdown) {
-			//throw "RenderQueue shutdown in push";
+		if (!queue.push(frame)) {
 			LogCondF(LOG_QUEUE, "RenderQueue shutdown in push\n");
-			return;
 		}
-		myqueue.push(frame);
-		LogCondF(LOG_QUEUE, "RenderQueue length " << myqueue.size() << std::endl);
-		cond.notify_one();
 	}
 
 	void shutdown() {
-		in_shutdown = true;
-		cond.notify_all();
+		queue.close();
 	}
 
 	size_t size() {
-		return myqueue.size();
+		return queue.size();
 	}
 
 private:
-	std::queue<QueueSubmitResources*> myqueue;
-	std::mutex monitorMutex;
-	std::condition_variable cond;
-	bool in_shutdown{ false };
+	MpmcRingQueue<QueueSubmitResources*> queue{ 8 };
 };
 
 // allow update thread to wait for render threads having adopted resource switches
@@ -12,6 +12,8 @@ enum class ThreadCategory {
 	DrawQueueSubmit,
     // after queue submit finished rendering we can process the image
     ProcessImage,
+	// fixed rate app simulation, see ShadedPathEngine::enableSimulationThread()
+	Simulation,
 	// main thread
 	MainThread
 };
@@ -39,6 +41,8 @@ public:
 			return "GlobalUpdate";
 		case ThreadCategory::DrawQueueSubmit:
 			return "DrawQueueSubmit";
+		case ThreadCategory::Simulation:
+			return "Simulation";
 		case ThreadCategory::MainThread:
 			return "MainThread";
 		default:
@@ -52,36 +56,114 @@ public:
 
 };
 
-// limit running thread to max calls per second
-// thread will sleep when called too often
-// calling rarely will not be changed
-class ThreadLimiter {
+struct FramePacerStats {
+	// upper bounds of wakeup error buckets in microseconds, last bucket is open
+	static constexpr std::array<long long, 9> BUCKET_LIMITS = { 10, 25, 50, 100, 250, 500, 1000, 2000, 4000 };
+	uint64_t frames = 0;
+	uint64_t missedDeadlines = 0; // caller arrived after the deadline, frames are skipped to stay on the deadline grid
+	double maxErrorMicros = 0.0;
+	double sumErrorMicros = 0.0;
+	std::array<uint64_t, BUCKET_LIMITS.size() + 1> histogram{}; // wakeup error after deadline
+	double overshootEstimateMicros = 0.0; // current estimate of OS sleep overshoot
+	double avgErrorMicros() const {
+		return frames > 0 ? sumErrorMicros / frames : 0.0;
+	}
+	// upper bound of the bucket containing the given fraction of frames, -1 for the open last bucket
+	long long percentileMicros(double fraction) const {
+		uint64_t needed = static_cast<uint64_t>(std::ceil(fraction * frames));
+		uint64_t count = 0;
+		for (size_t i = 0; i < BUCKET_LIMITS.size(); i++) {
+			count += histogram[i];
+			if (count >= needed) return BUCKET_LIMITS[i];
+		}
+		return -1;
+	}
+	void log(const std::string& name) const {
+		Log(name << " pacing: " << frames << " frames, missed deadlines " << missedDeadlines << ", wakeup error avg " << avgErrorMicros()
+			<< " us max " << maxErrorMicros << " us, sleep overshoot estimate " << overshootEstimateMicros << " us" << std::endl);
+		std::stringstream h;
+		for (size_t i = 0; i < histogram.size(); i++) {
+			if (i < BUCKET_LIMITS.size()) h << " <" << BUCKET_LIMITS[i] << ":" << histogram[i];
+			else h << " >=" << BUCKET_LIMITS.back() << ":" << histogram[i];
+		}
+		Log("  error histogram [us]" << h.str() << std::endl);
+	}
+};
+
+// pace a loop to a fixed rate with absolute deadlines on a steady grid (no drift from work or wakeup time).
+// Sleeps until shortly before the deadline and spins for the rest. Sleep is ended early by the
+// OS overshoot estimate, which adapts to the observed wakeup delays of this thread
+class FramePacer {
 public:
-	ThreadLimiter(float limit) {
-		this->limit = limit;
-		this->limitMicro = 1000000L / (long long)limit;
-		Log("limit: " << limitMicro << std::endl);
-		lastCallTime = std::chrono::high_resolution_clock::now();
-	}
-	void waitForLimit() {
-		auto now = std::chrono::high_resolution_clock::now();
-		long long length = std::chrono::duration_cast<std::chrono::microseconds>(now - lastCallTime).count();
-		if (length < limitMicro) {
-			// we are above threshold: sleep for the remaining milliseconds
-			unsigned long d = (unsigned long)(limitMicro - length) / 1000; // sleep time in millis
-			//Log(" limit length duration " << limitMicro << " " << length << " " << d << endl);
-			std::this_thread::sleep_for(std::chrono::milliseconds(d));
-		}
-		else {
-			// sleep at least 2ms to give other update threads a chance
-			std::this_thread::sleep_for(std::chrono::milliseconds(2));
-		}
-		lastCallTime = now;// chrono::high_resolution_clock::now();
-	};
+	// minimum spin time before deadline in addition to overshoot estimate
+	static constexpr std::chrono::microseconds SPIN_MARGIN{ 100 };
+
+	FramePacer(double ratePerSecond) {
+		setRate(ratePerSecond);
+	}
+	// e.g. 60, 90, 120 or 144. Restarts the deadline grid
+	void setRate(double ratePerSecond) {
+		if (ratePerSecond <= 0.0) Error("FramePacer: rate has to be positive");
+		rate = ratePerSecond;
+		period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / ratePerSecond));
+		started = false;
+	}
+	double getRate() const {
+		return rate;
+	}
+	// block until next deadline. First call only starts the grid
+	void waitForNextFrame() {
+		auto now = std::chrono::steady_clock::now();
+		if (!started) {
+			started = true;
+			nextDeadline = now + period;
+			return;
+		}
+		if (now > nextDeadline) {
+			// too late for this deadline: skip to next one on the grid instead of shifting the grid
+			auto late = now - nextDeadline;
+			uint64_t skipped = late / period + 1;
+			stats.missedDeadlines += skipped;
+			nextDeadline += period * skipped;
+		}
+		auto sleepUntil = nextDeadline - overshootEstimate - SPIN_MARGIN;
+		if (now < sleepUntil) {
+			std::this_thread::sleep_until(sleepUntil);
+			auto overshoot = std::chrono::steady_clock::now() - sleepUntil;
+			// react quickly to longer wakeup delays, relax slowly
+			auto diff = overshoot - overshootEstimate;
+			overshootEstimate += diff > std::chrono::steady_clock::duration::zero() ? diff / 4 : diff / 64;
+			if (overshootEstimate > period / 2) overshootEstimate = period / 2;
+		}
+		while ((now = std::chrono::steady_clock::now()) < nextDeadline) {
+			std::this_thread::yield();
+		}
+		record(now - nextDeadline);
+		nextDeadline += period;
+	}
+	const FramePacerStats& getStats() {
+		stats.overshootEstimateMicros = std::chrono::duration<double, std::micro>(overshootEstimate).count();
+		return stats;
+	}
+	void resetStats() {
+		stats = FramePacerStats();
+	}
 private:
-	long long limitMicro;
-	float limit;
-	std::chrono::high_resolution_clock::time_point lastCallTime;
+	void record(std::chrono::steady_clock::duration error) {
+		double micros = std::chrono::duration<double, std::micro>(error).count();
+		stats.frames++;
+		stats.sumErrorMicros += micros;
+		stats.maxErrorMicros = std::max(stats.maxErrorMicros, micros);
+		size_t bucket = 0;
+		while (bucket < FramePacerStats::BUCKET_LIMITS.size() && micros >= FramePacerStats::BUCKET_LIMITS[bucket]) bucket++;
+		stats.histogram[bucket]++;
+	}
+	double rate = 60.0;
+	std::chrono::steady_clock::duration period;
+	std::chrono::steady_clock::duration overshootEstimate = std::chrono::microseconds(500);
+	std::chrono::steady_clock::time_point nextDeadline;
+	bool started = false;
+	FramePacerStats stats;
 };
 
 template<typename T>
@@ -162,7 +244,271 @@ public:
 	}
 };
 
+// Bounded lock-free ring queues (SpscRingQueue, MpmcRingQueue) with same interface as ThreadsafeWaitingQueue.
+// Waiting threads block with std::atomic wait/notify (futex on Linux, WaitOnAddress on Windows), no timed polling.
+// After close() push fails and pop returns remaining items, then std::nullopt.
+// Only close after producers are done or items pushed concurrently to close() may not be delivered.
+// Derived classes implement non-blocking tryPush(), tryPop() and approxSize()
+template<typename Derived, typename T>
+class BlockingRingQueue {
+public:
+	BlockingRingQueue(const BlockingRingQueue&) = delete;
+	BlockingRingQueue& operator=(const BlockingRingQueue&) = delete;
+	BlockingRingQueue() = default;
+
+	// set and enable logging info (to be called before any push/pop operation
+	void setLoggingInfo(bool enable, std::string name) {
+		logEnable = enable;
+		logName = name;
+	}
+
+	// block while queue is full. Returns false if queue is closed
+	bool push(const T& item) {
+		while (true) {
+			uint32_t e = popEvents.load(std::memory_order_acquire);
+			if (closed.load(std::memory_order_acquire)) {
+				LogCondF(logEnable, logName + " closed in push\n");
+				return false;
+			}
+			if (derived().tryPush(item)) {
+				signal(pushEvents, pushWaiters, false);
+				LogCondF(logEnable, logName + " length " << size() << std::endl);
+				return true;
+			}
+			waitFor(popEvents, popWaiters, e);
+		}
+	}
+
+	// wait until item available, if nothing is returned queue is closed
+	std::optional<T> pop() {
+		T item;
+		if (!waitForItem(item)) {
+			return std::nullopt;
+		}
+		signal(popEvents, popWaiters, false);
+		return item;
+	}
+
+	// push items, blocks while queue is full. Returns number of pushed items, less than count only if queue was closed
+	size_t pushBatch(const T* items, size_t count) {
+		size_t pushed = 0;
+		while (pushed < count) {
+			uint32_t e = popEvents.load(std::memory_order_acquire);
+			if (closed.load(std::memory_order_acquire)) break;
+			size_t n = 0;
+			while (pushed < count && derived().tryPush(items[pushed])) {
+				pushed++;
+				n++;
+			}
+			if (n > 0) {
+				signal(pushEvents, pushWaiters, n > 1);
+			} else {
+				waitFor(popEvents, popWaiters, e);
+			}
+		}
+		return pushed;
+	}
+
+	// wait for at least one item, then pop up to maxCount items without waiting.
+	// Returns number of items, 0 if queue is closed and empty
+	size_t popBatch(T* out, size_t maxCount) {
+		if (maxCount == 0 || !waitForItem(out[0])) {
+			return 0;
+		}
+		size_t n = 1;
+		while (n < maxCount && derived().tryPop(out[n])) {
+			n++;
+		}
+		signal(popEvents, popWaiters, n > 1);
+		return n;
+	}
+
+	// wake all waiting threads, further pushes fail
+	void close() {
+		closed.store(true, std::memory_order_seq_cst);
+		pushEvents.fetch_add(1, std::memory_order_seq_cst);
+		pushEvents.notify_all();
+		popEvents.fetch_add(1, std::memory_order_seq_cst);
+		popEvents.notify_all();
+	}
+	// same as close(), ThreadsafeWaitingQueue interface
+	void shutdown() {
+		close();
+	}
+	bool isClosed() const {
+		return closed.load(std::memory_order_acquire);
+	}
+	// may be outdated immediately if other threads are active
+	size_t size() const {
+		return static_cast<const Derived*>(this)->approxSize();
+	}
+
+protected:
+	static size_t roundCapacity(size_t capacity) {
+		size_t c = 2;
+		while (c < capacity) c <<= 1;
+		return c;
+	}
+
+private:
+	Derived& derived() {
+		return *static_cast<Derived*>(this);
+	}
+	bool waitForItem(T& item) {
+		while (true) {
+			uint32_t e = pushEvents.load(std::memory_order_acquire);
+			if (derived().tryPop(item)) {
+				return true;
+			}
+			if (closed.load(std::memory_order_acquire)) {
+				// items pushed before close are still delivered
+				if (derived().tryPop(item)) return true;
+				LogCondF(logEnable, logName + " closed in pop\n");
+				return false;
+			}
+			waitFor(pushEvents, pushWaiters, e);
+		}
+	}
+	// notify only if a thread is waiting: seq_cst increment / waiter check here and
+	// waiter registration / event recheck in waitFor() cannot both miss each other
+	static void signal(std::atomic<uint32_t>& events, std::atomic<uint32_t>& waiters, bool all) {
+		events.fetch_add(1, std::memory_order_seq_cst);
+		if (waiters.load(std::memory_order_seq_cst) > 0) {
+			if (all) events.notify_all();
+			else events.notify_one();
+		}
+	}
+	static void waitFor(std::atomic<uint32_t>& events, std::atomic<uint32_t>& waiters, uint32_t seen) {
+		// short spin first: the other side is usually just about to push / pop
+		for (int i = 0; i < SPIN_COUNT; i++) {
+			if (events.load(std::memory_order_acquire) != seen) return;
+			std::this_thread::yield();
+		}
+		waiters.fetch_add(1, std::memory_order_seq_cst);
+		if (events.load(std::memory_order_seq_cst) == seen) {
+			events.wait(seen, std::memory_order_acquire);
+		}
+		waiters.fetch_sub(1, std::memory_order_relaxed);
+	}
+	static constexpr int SPIN_COUNT = 16;
+	// event counters to wait on, changed after every push / pop and on close
+	alignas(64) std::atomic<uint32_t> pushEvents{ 0 };
+	alignas(64) std::atomic<uint32_t> popEvents{ 0 };
+	std::atomic<uint32_t> pushWaiters{ 0 };
+	std::atomic<uint32_t> popWaiters{ 0 };
+	std::atomic<bool> closed{ false };
+	bool logEnable = false;
+	std::string logName = "n/a";
+};
+
+// single producer, single consumer bounded ring queue. Capacity is rounded up to power of 2
+template<typename T>
+class SpscRingQueue : public BlockingRingQueue<SpscRingQueue<T>, T> {
+public:
+	explicit SpscRingQueue(size_t capacity = 64) {
+		buffer.resize(this->roundCapacity(capacity));
+		mask = buffer.size() - 1;
+	}
+	size_t capacity() const {
+		return buffer.size();
+	}
+	// producer thread only
+	bool tryPush(const T& item) {
+		size_t t = tail.load(std::memory_order_relaxed);
+		if (t - head.load(std::memory_order_acquire) == buffer.size()) {
+			return false;
+		}
+		buffer[t & mask] = item;
+		tail.store(t + 1, std::memory_order_release);
+		return true;
+	}
+	// consumer thread only
+	bool tryPop(T& item) {
+		size_t h = head.load(std::memory_order_relaxed);
+		if (h == tail.load(std::memory_order_acquire)) {
+			return false;
+		}
+		item = std::move(buffer[h & mask]);
+		head.store(h + 1, std::memory_order_release);
+		return true;
+	}
+	size_t approxSize() const {
+		return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+	}
+private:
+	std::vector<T> buffer;
+	size_t mask = 0;
+	alignas(64) std::atomic<size_t> head{ 0 }; // next index to pop
+	alignas(64) std::atomic<size_t> tail{ 0 }; // next index to push
+};
 
+// multi producer, multi consumer bounded ring queue (sequence number per cell, see Vyukov's bounded MPMC queue).
+// Capacity is rounded up to power of 2
+template<typename T>
+class MpmcRingQueue : public BlockingRingQueue<MpmcRingQueue<T>, T> {
+public:
+	explicit MpmcRingQueue(size_t capacity = 64) : cells(this->roundCapacity(capacity)) {
+		mask = cells.size() - 1;
+		for (size_t i = 0; i < cells.size(); i++) {
+			cells[i].sequence.store(i, std::memory_order_relaxed);
+		}
+	}
+	size_t capacity() const {
+		return cells.size();
+	}
+	bool tryPush(const T& item) {
+		size_t pos = enqueuePos.load(std::memory_order_relaxed);
+		while (true) {
+			Cell& cell = cells[pos & mask];
+			size_t seq = cell.sequence.load(std::memory_order_acquire);
+			intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+			if (diff == 0) {
+				if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+					cell.data = item;
+					cell.sequence.store(pos + 1, std::memory_order_release);
+					return true;
+				}
+			} else if (diff < 0) {
+				return false; // full
+			} else {
+				pos = enqueuePos.load(std::memory_order_relaxed);
+			}
+		}
+	}
+	bool tryPop(T& item) {
+		size_t pos = dequeuePos.load(std::memory_order_relaxed);
+		while (true) {
+			Cell& cell = cells[pos & mask];
+			size_t seq = cell.sequence.load(std::memory_order_acquire);
+			intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+			if (diff == 0) {
+				if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+					item = std::move(cell.data);
+					cell.sequence.store(pos + mask + 1, std::memory_order_release);
+					return true;
+				}
+			} else if (diff < 0) {
+				return false; // empty
+			} else {
+				pos = dequeuePos.load(std::memory_order_relaxed);
+			}
+		}
+	}
+	size_t approxSize() const {
+		size_t e = enqueuePos.load(std::memory_order_acquire);
+		size_t d = dequeuePos.load(std::memory_order_acquire);
+		return e > d ? e - d : 0;
+	}
+private:
+	struct Cell {
+		std::atomic<size_t> sequence;
+		T data;
+	};
+	std::vector<Cell> cells;
+	size_t mask = 0;
+	alignas(64) std::atomic<size_t> enqueuePos{ 0 };
+	alignas(64) std::atomic<size_t> dequeuePos{ 0 };
+};
 
 // producer thread creates datatransfer data to be picked up by another thread
 // and wait until the other thread has completed working with the data
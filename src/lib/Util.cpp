@@ -1229,7 +1229,7 @@ void Util::logGPUStructuresMarkdown(std::string filename)
     
     md << "### Infos Array (`baseAddressInfos`)\n";
     md << "- **Address:** 0x" << std::hex << engine->shaders.pbrShader.pushConstants.baseAddressInfos << std::dec << "\n";
-    md << "- **Element Type:** `GPUMeshInfo` (40 bytes each)\n";
+    md << "- **Element Type:** `GPUMeshInfo` (" << sizeof(GPUMeshInfo) << " bytes each)\n";
     md << "- **Array Size:** " << gpuMeshInfos.size() << " elements\n";
     md << "- **Total Size:** " << (gpuMeshInfos.size() * sizeof(GPUMeshInfo)) << " bytes\n";
     md << "- **Purpose:** Contains offsets into global buffer for vertices, indices, and meshlets\n";
@@ -881,6 +881,7 @@ bool VR::RenderLayerCopyRenderedImage(RenderLayerInfo& renderLayerInfo, WindowIn
             //Log("VR mode blit back image num " << tr->frameNum << " swap idx " << renderLayerInfo.colorImageIndex << endl)
             // i == 0 is left eye. colorImageIndex is the swapchain image index we are currently working on
             auto srcImage = i == 0 ? tr->colorImage.fba.image : tr->colorImage2.fba.image;
+            imageBlitRegion.srcSubresource.baseArrayLayer = i == 0 ? tr->colorImage.arrayLayer : tr->colorImage2.arrayLayer;
             auto destImage = GetSwapchainImage(colorSwapchainInfo.swapchain, renderLayerInfo.colorImageIndex);
             //Log("Blitting from " << srcImage << " to image " << destImage << endl);
             VkImageMemoryBarrier imageBarrier;
@@ -0,0 +1,185 @@
+#include "mainheader.h"
+
+using namespace std;
+using namespace glm;
+
+static inline float signNotZero(float f)
+{
+	return f >= 0.0f ? 1.0f : -1.0f;
+}
+
+vec2 VertexCompression::octEncode(vec3 n)
+{
+	float l1 = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+	if (l1 == 0.0f) {
+		return vec2(0.0f);
+	}
+	vec2 e(n.x / l1, n.y / l1);
+	if (n.z < 0.0f) {
+		// fold lower hemisphere over the diagonals
+		e = vec2((1.0f - std::abs(e.y)) * signNotZero(e.x), (1.0f - std::abs(e.x)) * signNotZero(e.y));
+	}
+	return e;
+}
+
+vec3 VertexCompression::octDecode(vec2 e)
+{
+	// same as octDecode() in pbr_mesh_common.glsl
+	vec3 n(e.x, e.y, 1.0f - std::abs(e.x) - std::abs(e.y));
+	float t = std::max(-n.z, 0.0f);
+	n.x += n.x >= 0.0f ? -t : t;
+	n.y += n.y >= 0.0f ? -t : t;
+	return normalize(n);
+}
+
+static inline float snorm8ToFloat(int q)
+{
+	return std::max((float)q / 127.0f, -1.0f);
+}
+
+static inline uint32_t snorm8Bits(int q)
+{
+	return (uint32_t)(uint8_t)(int8_t)q;
+}
+
+uint32_t VertexCompression::packNormal(vec3 n)
+{
+	if (length2(n) == 0.0f) {
+		return 0;
+	}
+	n = normalize(n);
+	vec2 e = octEncode(n);
+	// try all 4 neighbouring grid points, plain rounding is not always the closest normal
+	int x0 = (int)std::floor(e.x * 127.0f);
+	int y0 = (int)std::floor(e.y * 127.0f);
+	int bestX = 0, bestY = 0;
+	float bestDot = -2.0f;
+	for (int dx = 0; dx < 2; dx++) {
+		for (int dy = 0; dy < 2; dy++) {
+			int qx = std::clamp(x0 + dx, -127, 127);
+			int qy = std::clamp(y0 + dy, -127, 127);
+			float d = dot(octDecode(vec2(snorm8ToFloat(qx), snorm8ToFloat(qy))), n);
+			if (d > bestDot) {
+				bestDot = d;
+				bestX = qx;
+				bestY = qy;
+			}
+		}
+	}
+	return snorm8Bits(bestX) | (snorm8Bits(bestY) << 8);
+}
+
+vec3 VertexCompression::unpackNormal(uint32_t packed)
+{
+	int qx = (int8_t)(packed & 0xFF);
+	int qy = (int8_t)((packed >> 8) & 0xFF);
+	return octDecode(vec2(snorm8ToFloat(qx), snorm8ToFloat(qy)));
+}
+
+bool VertexCompression::canPack(const vector<PBRShader::Vertex>& verts)
+{
+	for (auto& v : verts) {
+		if (std::abs(v.uv0.x) > MAX_PACKED_UV || std::abs(v.uv0.y) > MAX_PACKED_UV || std::abs(v.uv1.x) > MAX_PACKED_UV || std::abs(v.uv1.y) > MAX_PACKED_UV) {
+			return false;
+		}
+		if (v.joint0.x > MAX_PACKED_JOINT || v.joint0.y > MAX_PACKED_JOINT || v.joint0.z > MAX_PACKED_JOINT || v.joint0.w > MAX_PACKED_JOINT) {
+			return false;
+		}
+		if (!std::isfinite(v.pos.x) || !std::isfinite(v.pos.y) || !std::isfinite(v.pos.z)) {
+			return false;
+		}
+	}
+	return !verts.empty();
+}
+
+// quantize weights to unorm8 with sum exactly 255 (largest remainder method)
+static uint32_t packWeights(vec4 w)
+{
+	float sum = w.x + w.y + w.z + w.w;
+	if (sum <= 0.0f) {
+		return 0;
+	}
+	float scaled[4];
+	int q[4];
+	int total = 0;
+	for (int i = 0; i < 4; i++) {
+		scaled[i] = std::max(w[i], 0.0f) / sum * 255.0f;
+		q[i] = (int)std::floor(scaled[i]);
+		total += q[i];
+	}
+	while (total < 255) {
+		int best = 0;
+		for (int i = 1; i < 4; i++) {
+			if (scaled[i] - q[i] > scaled[best] - q[best]) best = i;
+		}
+		q[best]++;
+		scaled[best] -= 1.0f; // do not pick same component again before the others
+		total++;
+	}
+	return (uint32_t)q[0] | ((uint32_t)q[1] << 8) | ((uint32_t)q[2] << 16) | ((uint32_t)q[3] << 24);
+}
+
+void VertexCompression::encode(const vector<PBRShader::Vertex>& verts, PackedVertexStreams& out)
+{
+	out.format = VERTEX_FORMAT_PACKED;
+	out.base.clear();
+	out.skin.clear();
+	out.color.clear();
+	vec3 bbMin(FLT_MAX), bbMax(-FLT_MAX);
+	bool needSkin = false;
+	bool needColor = false;
+	for (auto& v : verts) {
+		bbMin = glm::min(bbMin, v.pos);
+		bbMax = glm::max(bbMax, v.pos);
+		if (v.weight0 != vec4(0.0f)) needSkin = true;
+		if (v.color != vec4(1.0f)) needColor = true;
+	}
+	if (verts.empty()) {
+		bbMin = bbMax = vec3(0.0f);
+	}
+	out.quantMin = bbMin;
+	out.quantScale = (bbMax - bbMin) / 65535.0f;
+	if (needSkin) out.format |= VERTEX_FORMAT_SKIN_STREAM;
+	if (needColor) out.format |= VERTEX_FORMAT_COLOR_STREAM;
+
+	out.base.resize(verts.size());
+	if (needSkin) out.skin.resize(verts.size());
+	if (needColor) out.color.resize(verts.size());
+	for (size_t i = 0; i < verts.size(); i++) {
+		const PBRShader::Vertex& v = verts[i];
+		uint32_t q[3];
+		for (int c = 0; c < 3; c++) {
+			float s = out.quantScale[c];
+			float f = s > 0.0f ? (v.pos[c] - out.quantMin[c]) / s : 0.0f;
+			q[c] = (uint32_t)std::clamp(f + 0.5f, 0.0f, 65535.0f);
+		}
+		PackedVertexBase& b = out.base[i];
+		b.posXY = q[0] | (q[1] << 16);
+		b.posZNormal = q[2] | (packNormal(v.normal) << 16);
+		b.uv0 = packHalf2x16(v.uv0);
+		b.uv1 = packHalf2x16(v.uv1);
+		if (needSkin) {
+			out.skin[i].joints = v.joint0.x | (v.joint0.y << 8) | (v.joint0.z << 16) | (v.joint0.w << 24);
+			out.skin[i].weights = packWeights(v.weight0);
+		}
+		if (needColor) {
+			out.color[i] = packUnorm4x8(v.color);
+		}
+	}
+}
+
+PBRShader::Vertex VertexCompression::decode(const PackedVertexStreams& streams, size_t index)
+{
+	const PackedVertexBase& b = streams.base[index];
+	vec3 q((float)(b.posXY & 0xFFFF), (float)(b.posXY >> 16), (float)(b.posZNormal & 0xFFFF));
+	PBRShader::Vertex v(streams.quantMin + q * streams.quantScale, unpackNormal(b.posZNormal >> 16), unpackHalf2x16(b.uv0), unpackHalf2x16(b.uv1));
+	if (streams.format & VERTEX_FORMAT_SKIN_STREAM) {
+		const PackedVertexSkin& s = streams.skin[index];
+		v.joint0 = uvec4(s.joints & 0xFF, (s.joints >> 8) & 0xFF, (s.joints >> 16) & 0xFF, s.joints >> 24);
+		v.weight0 = unpackUnorm4x8(s.weights);
+	}
+	if (streams.format & VERTEX_FORMAT_COLOR_STREAM) {
+		v.color = unpackUnorm4x8(streams.color[index]);
+	}
+	return v;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+// Packed vertex format for mesh shader rendering. PBRVertex uses 112 bytes per vertex, packed vertices use:
+// - base stream, 16 bytes: position quantized to 16 bit per axis against the mesh AABB,
+//   octahedral encoded normal (2 x snorm8), uv0 and uv1 as half floats
+// - skin stream, 8 bytes, optional: 4 joint indices as u8, 4 weights as unorm8
+// - color stream, 4 bytes, optional: rgba as unorm8
+// Optional streams are only written if a mesh needs them, so static meshes without vertex colors use 16 bytes per vertex.
+// Layout has to match unpackVertex() in shader/pbr_mesh_common.glsl
+
+struct PackedVertexBase {
+	uint32_t posXY; // x in low 16 bits
+	uint32_t posZNormal; // z in low 16 bits, octahedral normal snorm8 x / y in bits 16..23 / 24..31
+	uint32_t uv0; // packHalf2x16
+	uint32_t uv1; // packHalf2x16
+};
+
+struct PackedVertexSkin {
+	uint32_t joints; // 4 x u8, joint 0 in low byte
+	uint32_t weights; // packUnorm4x8, sum of weights is exactly 255
+};
+
+// all streams of one mesh
+struct PackedVertexStreams {
+	uint32_t format = VERTEX_FORMAT_FULL; // VERTEX_FORMAT_ flags
+	glm::vec3 quantMin = glm::vec3(0.0f);
+	glm::vec3 quantScale = glm::vec3(0.0f); // AABB extent / 65535
+	std::vector<PackedVertexBase> base;
+	std::vector<PackedVertexSkin> skin;
+	std::vector<uint32_t> color; // packUnorm4x8
+	size_t byteSize() const {
+		return base.size() * sizeof(PackedVertexBase) + skin.size() * sizeof(PackedVertexSkin) + color.size() * sizeof(uint32_t);
+	}
+};
+
+class VertexCompression {
+public:
+	// half floats lose too much precision for larger values, meshes with UVs outside [-MAX_PACKED_UV, MAX_PACKED_UV] are not packed
+	static constexpr float MAX_PACKED_UV = 8.0f;
+	// joint indices are stored in 8 bits
+	static constexpr uint32_t MAX_PACKED_JOINT = 255;
+
+	// check if vertices can be packed without exceeding the error bounds below
+	static bool canPack(const std::vector<PBRShader::Vertex>& verts);
+	// encode vertices. Skin and color streams are only created if any vertex has weights or a color other than white.
+	// Max errors after decode: position AABB extent / 131070 per axis, normal 1 degree,
+	// uv relative 2^-11, weights 1/255, color 1/510
+	static void encode(const std::vector<PBRShader::Vertex>& verts, PackedVertexStreams& out);
+	// decode single vertex, same as in mesh shader
+	static PBRShader::Vertex decode(const PackedVertexStreams& streams, size_t index);
+
+	// octahedral mapping of unit vector to [-1, 1]^2 and back
+	static glm::vec2 octEncode(glm::vec3 n);
+	static glm::vec3 octDecode(glm::vec2 e);
+	// octahedral normal quantized to 2 x snorm8, rounding is chosen to minimize angular error
+	static uint32_t packNormal(glm::vec3 n);
+	static glm::vec3 unpackNormal(uint32_t packed);
+};
@@ -0,0 +1,275 @@
+#include "mainheader.h"
+
+using namespace std;
+using namespace glm;
+
+size_t AccessorView::componentSize(AccessorComponentType t)
+{
+	switch (t) {
+	case AccessorComponentType::Byte:
+	case AccessorComponentType::UnsignedByte:
+		return 1;
+	case AccessorComponentType::Short:
+	case AccessorComponentType::UnsignedShort:
+		return 2;
+	case AccessorComponentType::UnsignedInt:
+	case AccessorComponentType::Float:
+		return 4;
+	}
+	return 0;
+}
+
+UVTransform UVTransform::fromKHR(glm::vec2 offset, glm::vec2 scale, float rotation)
+{
+	// rotation as in KHR_texture_transform spec: (c*u - s*v, s*u + c*v) applied after scale
+	UVTransform t;
+	t.present = true;
+	float c = cos(rotation);
+	float s = sin(rotation);
+	t.col0 = glm::vec2(c, s) * scale.x;
+	t.col1 = glm::vec2(-s, c) * scale.y;
+	t.offset = offset;
+	return t;
+}
+
+// component conversion, normalisation as in glTF spec
+template<typename T, bool Normalized>
+static inline float convertComponent(const uint8_t* src)
+{
+	T v;
+	memcpy(&v, src, sizeof(T));
+	if constexpr (!Normalized || std::is_same_v<T, float>) {
+		return static_cast<float>(v);
+	} else if constexpr (std::is_signed_v<T>) {
+		return std::max(static_cast<float>(v) / static_cast<float>(std::numeric_limits<T>::max()), -1.0f);
+	} else {
+		return static_cast<float>(v) / static_cast<float>(std::numeric_limits<T>::max());
+	}
+}
+
+template<typename T, bool Normalized>
+static void decodeTyped(const uint8_t* base, size_t stride, size_t count, int numComponents, float* out, int outComponents)
+{
+	int n = std::min(numComponents, outComponents);
+	for (size_t i = 0; i < count; i++) {
+		const uint8_t* elem = base + i * stride;
+		float* o = out + i * outComponents;
+		for (int c = 0; c < n; c++) {
+			o[c] = convertComponent<T, Normalized>(elem + c * sizeof(T));
+		}
+	}
+}
+
+template<bool Normalized>
+static void decodeDispatch(AccessorComponentType type, const uint8_t* base, size_t stride, size_t count, int numComponents, float* out, int outComponents)
+{
+	switch (type) {
+	case AccessorComponentType::Float: decodeTyped<float, false>(base, stride, count, numComponents, out, outComponents); break;
+	case AccessorComponentType::UnsignedByte: decodeTyped<uint8_t, Normalized>(base, stride, count, numComponents, out, outComponents); break;
+	case AccessorComponentType::Byte: decodeTyped<int8_t, Normalized>(base, stride, count, numComponents, out, outComponents); break;
+	case AccessorComponentType::UnsignedShort: decodeTyped<uint16_t, Normalized>(base, stride, count, numComponents, out, outComponents); break;
+	case AccessorComponentType::Short: decodeTyped<int16_t, Normalized>(base, stride, count, numComponents, out, outComponents); break;
+	case AccessorComponentType::UnsignedInt: decodeTyped<uint32_t, false>(base, stride, count, numComponents, out, outComponents); break;
+	}
+}
+
+static inline size_t readIndex(const uint8_t* data, AccessorComponentType type, size_t i)
+{
+	switch (type) {
+	case AccessorComponentType::UnsignedByte:
+		return data[i];
+	case AccessorComponentType::UnsignedShort: {
+		uint16_t v;
+		memcpy(&v, data + i * 2, 2);
+		return v;
+	}
+	default: {
+		uint32_t v;
+		memcpy(&v, data + i * 4, 4);
+		return v;
+	}
+	}
+}
+
+void VertexDecode::decodeFloats(const AccessorView& view, size_t first, size_t count, float* out, int outComponents, float fill)
+{
+	if (first + count > view.count) {
+		Error("VertexDecode: accessor range out of bounds");
+	}
+	// sparse accessor without bufferView starts with zeros, missing components get fill value
+	int present = std::min(outComponents, view.numComponents);
+	int firstFilled = view.data == nullptr ? 0 : present;
+	if (firstFilled < outComponents) {
+		for (size_t i = 0; i < count; i++) {
+			for (int c = firstFilled; c < outComponents; c++) {
+				out[i * outComponents + c] = c < present ? 0.0f : fill;
+			}
+		}
+	}
+	size_t stride = view.elementStride();
+	if (view.data != nullptr) {
+		const uint8_t* base = view.data + first * stride;
+		if (view.componentType == AccessorComponentType::Float && view.numComponents == outComponents && stride == sizeof(float) * outComponents) {
+			// tightly packed floats: plain copy
+			memcpy(out, base, count * stride);
+		} else if (view.normalized) {
+			decodeDispatch<true>(view.componentType, base, stride, count, view.numComponents, out, outComponents);
+		} else {
+			decodeDispatch<false>(view.componentType, base, stride, count, view.numComponents, out, outComponents);
+		}
+	}
+	if (view.sparseCount == 0) return;
+	// sparse indices are strictly increasing: binary search first one in range
+	size_t lo = 0, hi = view.sparseCount;
+	while (lo < hi) {
+		size_t mid = (lo + hi) / 2;
+		if (readIndex(view.sparseIndices, view.sparseIndexType, mid) < first) lo = mid + 1;
+		else hi = mid;
+	}
+	size_t valueStride = AccessorView::componentSize(view.componentType) * view.numComponents;
+	for (size_t s = lo; s < view.sparseCount; s++) {
+		size_t target = readIndex(view.sparseIndices, view.sparseIndexType, s);
+		if (target >= first + count) break;
+		float* o = out + (target - first) * outComponents;
+		const uint8_t* src = view.sparseValues + s * valueStride;
+		if (view.normalized) decodeDispatch<true>(view.componentType, src, valueStride, 1, view.numComponents, o, outComponents);
+		else decodeDispatch<false>(view.componentType, src, valueStride, 1, view.numComponents, o, outComponents);
+	}
+}
+
+void VertexDecode::decodePrimitive(const PrimitiveDecodeInput& in, std::vector<PBRShader::Vertex>& verts)
+{
+	if (!in.position.isValid()) {
+		Error("VertexDecode: primitive without positions");
+	}
+	size_t vertexCount = in.position.count;
+	size_t vertexStart = verts.size();
+	verts.resize(vertexStart + vertexCount, PBRShader::Vertex(glm::vec3(0.0f), glm::vec3(0.0f), glm::vec2(0.0f)));
+
+	// staging arrays for one batch. positions and normals use 4 floats per vertex for SIMD loads
+	alignas(16) float pos[BATCH_SIZE * 4];
+	alignas(16) float nrm[BATCH_SIZE * 4];
+	alignas(16) float uv[2][BATCH_SIZE * 2];
+	alignas(16) float col[BATCH_SIZE * 4];
+	alignas(16) float jnt[BATCH_SIZE * 4];
+	alignas(16) float wgt[BATCH_SIZE * 4];
+	bool skinned = in.joints.isValid() && in.weights.isValid();
+	const AccessorView* uvViews[2] = { &in.uv0, &in.uv1 };
+
+	// transform columns, normal matrix is inverse transpose of upper 3x3
+	Float4 m0, m1, m2, m3, n0, n1, n2;
+	if (in.bakeTransform) {
+		const glm::mat4& w = *in.bakeTransform;
+		m0 = Float4(w[0][0], w[0][1], w[0][2], 0.0f);
+		m1 = Float4(w[1][0], w[1][1], w[1][2], 0.0f);
+		m2 = Float4(w[2][0], w[2][1], w[2][2], 0.0f);
+		m3 = Float4(w[3][0], w[3][1], w[3][2], 0.0f);
+		glm::mat3 nm = glm::transpose(glm::inverse(glm::mat3(w)));
+		n0 = Float4(nm[0][0], nm[0][1], nm[0][2], 0.0f);
+		n1 = Float4(nm[1][0], nm[1][1], nm[1][2], 0.0f);
+		n2 = Float4(nm[2][0], nm[2][1], nm[2][2], 0.0f);
+	}
+	// UV transform on 2 interleaved UVs per Float4: (u0 v0 u1 v1)
+	Float4 uvA[2], uvB[2], uvO[2];
+	for (int set = 0; set < 2; set++) {
+		const UVTransform& t = in.uvTransform[set];
+		uvA[set] = Float4(t.col0.x, t.col1.y, t.col0.x, t.col1.y);
+		uvB[set] = Float4(t.col1.x, t.col0.y, t.col1.x, t.col0.y);
+		uvO[set] = Float4(t.offset.x, t.offset.y, t.offset.x, t.offset.y);
+	}
+
+	for (size_t first = 0; first < vertexCount; first += BATCH_SIZE) {
+		size_t n = std::min(BATCH_SIZE, vertexCount - first);
+		decodeFloats(in.position, first, n, pos, 4);
+		if (in.normal.isValid()) decodeFloats(in.normal, first, n, nrm, 4);
+		else std::fill(nrm, nrm + n * 4, 0.0f);
+		for (int set = 0; set < 2; set++) {
+			if (uvViews[set]->isValid()) decodeFloats(*uvViews[set], first, n, uv[set], 2);
+			else std::fill(uv[set], uv[set] + n * 2, 0.0f);
+		}
+		if (in.color.isValid()) decodeFloats(in.color, first, n, col, 4, 1.0f);
+		else std::fill(col, col + n * 4, 1.0f);
+		if (skinned) {
+			// joint indices are small integers, exact as float
+			decodeFloats(in.joints, first, n, jnt, 4);
+			decodeFloats(in.weights, first, n, wgt, 4);
+		}
+
+		if (in.bakeTransform) {
+			for (size_t i = 0; i < n; i++) {
+				float* p = pos + i * 4;
+				Float4 r = m0 * Float4(p[0]) + m1 * Float4(p[1]) + m2 * Float4(p[2]) + m3;
+				r.store(p);
+				float* q = nrm + i * 4;
+				Float4 rn = n0 * Float4(q[0]) + n1 * Float4(q[1]) + n2 * Float4(q[2]);
+				rn.store(q);
+			}
+		}
+		for (int set = 0; set < 2; set++) {
+			if (!in.uvTransform[set].present || !uvViews[set]->isValid()) continue;
+			// n * 2 floats, process pairs of UVs. Odd tail handled scalar
+			size_t floats = n * 2;
+			size_t i = 0;
+			for (; i + 4 <= floats; i += 4) {
+				Float4 l = Float4::load(uv[set] + i);
+				Float4 r = uvA[set] * l + uvB[set] * l.swapPairs() + uvO[set];
+				r.store(uv[set] + i);
+			}
+			for (; i < floats; i += 2) {
+				glm::vec2 t = in.uvTransform[set].apply(glm::vec2(uv[set][i], uv[set][i + 1]));
+				uv[set][i] = t.x;
+				uv[set][i + 1] = t.y;
+			}
+		}
+
+		// interleave
+		PBRShader::Vertex* out = verts.data() + vertexStart + first;
+		for (size_t i = 0; i < n; i++) {
+			PBRShader::Vertex& v = out[i];
+			v.pos = glm::vec3(pos[i * 4], pos[i * 4 + 1], pos[i * 4 + 2]);
+			glm::vec3 normal(nrm[i * 4], nrm[i * 4 + 1], nrm[i * 4 + 2]);
+			if (in.bakeTransform && glm::length2(normal) > 0.0f) {
+				normal = glm::normalize(normal);
+			}
+			v.normal = normal;
+			v.uv0 = glm::vec2(uv[0][i * 2], uv[0][i * 2 + 1]);
+			v.uv1 = glm::vec2(uv[1][i * 2], uv[1][i * 2 + 1]);
+			v.color = glm::vec4(col[i * 4], col[i * 4 + 1], col[i * 4 + 2], col[i * 4 + 3]);
+			if (skinned) {
+				v.joint0 = glm::uvec4(jnt[i * 4], jnt[i * 4 + 1], jnt[i * 4 + 2], jnt[i * 4 + 3]);
+				v.weight0 = glm::vec4(wgt[i * 4], wgt[i * 4 + 1], wgt[i * 4 + 2], wgt[i * 4 + 3]);
+			}
+		}
+	}
+}
+
+void VertexDecode::decodeIndices(const AccessorView& view, uint32_t vertexStart, std::vector<uint32_t>& indices)
+{
+	size_t start = indices.size();
+	indices.resize(start + view.count);
+	uint32_t* out = indices.data() + start;
+	size_t stride = view.elementStride();
+	switch (view.componentType) {
+	case AccessorComponentType::UnsignedInt:
+		for (size_t i = 0; i < view.count; i++) {
+			uint32_t v;
+			memcpy(&v, view.data + i * stride, 4);
+			out[i] = v + vertexStart;
+		}
+		break;
+	case AccessorComponentType::UnsignedShort:
+		for (size_t i = 0; i < view.count; i++) {
+			uint16_t v;
+			memcpy(&v, view.data + i * stride, 2);
+			out[i] = v + vertexStart;
+		}
+		break;
+	case AccessorComponentType::UnsignedByte:
+		for (size_t i = 0; i < view.count; i++) {
+			out[i] = view.data[i * stride] + vertexStart;
+		}
+		break;
+	default:
+		Error("Index component type not supported!");
+	}
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+// Typed decoding of glTF accessor data into PBRShader::Vertex.
+// Works on raw buffer pointers only: gltf.cpp fills AccessorView from the tinygltf model,
+// so decoding can be tested and benchmarked without glTF files.
+
+// glTF component types (same values as in GL and tinygltf)
+enum class AccessorComponentType : int {
+	Byte = 5120,
+	UnsignedByte = 5121,
+	Short = 5122,
+	UnsignedShort = 5123,
+	UnsignedInt = 5125,
+	Float = 5126
+};
+
+// view of one accessor: count elements of numComponents components each.
+// sparse accessors substitute sparseCount elements after reading the (optional) dense data
+struct AccessorView {
+	const uint8_t* data = nullptr; // first element, nullptr means all zeros (sparse accessor without bufferView)
+	size_t count = 0;
+	AccessorComponentType componentType = AccessorComponentType::Float;
+	int numComponents = 0;
+	size_t byteStride = 0; // 0 means tightly packed
+	bool normalized = false;
+	size_t sparseCount = 0;
+	const uint8_t* sparseIndices = nullptr; // strictly increasing, as required by glTF spec
+	AccessorComponentType sparseIndexType = AccessorComponentType::UnsignedInt;
+	const uint8_t* sparseValues = nullptr; // tightly packed, same component type as accessor
+
+	bool isValid() const {
+		return count > 0 && numComponents > 0;
+	}
+	size_t elementStride() const {
+		return byteStride ? byteStride : componentSize(componentType) * numComponents;
+	}
+	static size_t componentSize(AccessorComponentType t);
+};
+
+// KHR_texture_transform (scale -> rotate -> translate) combined into one 2x3 matrix
+struct UVTransform {
+	bool present = false;
+	glm::vec2 col0 = glm::vec2(1.0f, 0.0f);
+	glm::vec2 col1 = glm::vec2(0.0f, 1.0f);
+	glm::vec2 offset = glm::vec2(0.0f);
+	static UVTransform fromKHR(glm::vec2 offset, glm::vec2 scale, float rotation);
+	glm::vec2 apply(glm::vec2 uv) const {
+		return col0 * uv.x + col1 * uv.y + offset;
+	}
+};
+
+// all attributes of one primitive. Attributes that are not valid get default values
+struct PrimitiveDecodeInput {
+	AccessorView position;
+	AccessorView normal;
+	AccessorView uv0;
+	AccessorView uv1;
+	AccessorView color; // vec3 or vec4, alpha defaults to 1
+	AccessorView joints; // JOINTS_0, unsigned byte or short
+	AccessorView weights; // WEIGHTS_0, float or normalized
+	UVTransform uvTransform[2];
+	const glm::mat4* bakeTransform = nullptr; // optional world transform for positions and normals
+};
+
+class VertexDecode {
+public:
+	// vertices are decoded in batches small enough to stay in L1 cache
+	static constexpr size_t BATCH_SIZE = 256;
+
+	// decode elements [first, first + count) to float, outComponents per element.
+	// components not present in the accessor are set to fill
+	static void decodeFloats(const AccessorView& view, size_t first, size_t count, float* out, int outComponents, float fill = 0.0f);
+	// decode attributes, interleave, apply UV transforms and bake transform in one pass. Vertices are appended to verts
+	static void decodePrimitive(const PrimitiveDecodeInput& in, std::vector<PBRShader::Vertex>& verts);
+	// append indices with vertexStart added
+	static void decodeIndices(const AccessorView& view, uint32_t vertexStart, std::vector<uint32_t>& indices);
+};
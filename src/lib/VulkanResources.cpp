@@ -391,54 +391,79 @@ void VulkanResources::createDescriptorSetResourcesForTextures()
 }
 
 void VulkanResources::updateDescriptorSetForTextures(ShadedPathEngine* engine) {
-    if (engine->textureStore.pool == nullptr) Error("Adding textures requires initialized engine and shaders! Move to app.init()");
-    if (engine->textureStore.descriptorSet == nullptr) {
+    auto& store = engine->textureStore;
+    if (store.pool == nullptr) Error("Adding textures requires initialized engine and shaders! Move to app.init()");
+    // called by the app thread (texture load / unload) and the queue submit thread (texture residency)
+    lock_guard<mutex> lock(store.descriptorMutex);
+    if (store.descriptorSet == nullptr) {
         // create DescriptorSet
         VkDescriptorSetAllocateInfo allocInfo{};
         allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-        allocInfo.descriptorPool = engine->textureStore.pool;
+        allocInfo.descriptorPool = store.pool;
         allocInfo.descriptorSetCount = 1;
-        allocInfo.pSetLayouts = &engine->textureStore.layout;
-        VkResult res = vkAllocateDescriptorSets(engine->globalRendering.device, &allocInfo, &engine->textureStore.descriptorSet);
+        allocInfo.pSetLayouts = &store.layout;
+        VkResult res = vkAllocateDescriptorSets(engine->globalRendering.device, &allocInfo, &store.descriptorSet);
         if (res != VK_SUCCESS) {
             Error("failed to allocate descriptor sets!");
         }
+        store.markAllDescriptorsDirty();
     }
 
-    // iterate over all textures and write descriptor sets
-    // use empty local vectors
-    size_t numTextures = engine->textureStore.getTexturesMap().size();
-    vector<VkDescriptorImageInfo> imageInfos(numTextures);
-    vector<VkWriteDescriptorSet> descriptorSets;
-
-    TextureInfo* lastTexture = nullptr;
-    for (auto& texMapEntry : engine->textureStore.getTexturesMap()) {
-        auto& tex = texMapEntry.second;
-        //Log("tex: " << tex.id.c_str() << " index: " << tex.index << " ");
+    // only slots changed since last update are written (set is update after bind, so this is allowed while frames are in flight).
+    // slots of unloaded or not yet loaded textures are filled with another valid texture
+    uint32_t numSlots = store.getSlotCount();
+    TextureInfo* fill = nullptr;
+    for (uint32_t i = 0; i < numSlots && fill == nullptr; i++) {
+        TextureInfo* tex = store.getTextureInSlot(i);
+        if (tex != nullptr && tex->imageView != nullptr) fill = tex;
+    }
+    // no valid texture yet: keep dirty slots for next update
+    if (fill == nullptr) return;
+    if (fill->imageView != store.descriptorFillView) {
+        // fill texture changed (unloaded or new image view): filled slots reference the old view
+        store.descriptorFillView = fill->imageView;
+        for (uint32_t i = 0; i < numSlots; i++) {
+            TextureInfo* tex = store.getTextureInSlot(i);
+            if (tex == nullptr || tex->imageView == nullptr) store.markDescriptorDirty(i);
+        }
+    }
+    auto imageInfoFor = [engine](TextureInfo* tex) {
         VkDescriptorImageInfo imageInfo{};
         imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        imageInfo.imageView = tex.imageView;
-        //imageInfo.sampler = engine->globalRendering.textureSampler[(int)tex.type];
-        if (tex.type == TextureType::TEXTURE_TYPE_GLTF) {
-            imageInfo.sampler = tex.sampler;
-            //Log("using glTF sampler\n");
+        imageInfo.imageView = tex->imageView;
+        if (tex->type == TextureType::TEXTURE_TYPE_GLTF) {
+            imageInfo.sampler = tex->sampler;
         } else {
             imageInfo.sampler = engine->globalRendering.textureSampler_TEXTURE_TYPE_MIPMAP_IMAGE;
-            //Log("using default sampler\n");
         }
-        imageInfos[tex.index] = imageInfo;
-        lastTexture = (TextureInfo*) &tex;
+        return imageInfo;
+    };
+    VkDescriptorImageInfo fillInfo = imageInfoFor(fill);
+    auto ranges = store.takeDirtyDescriptorRanges(DESCRIPTOR_RANGE_MERGE_GAP);
+    if (ranges.empty()) return;
+    // image infos of all ranges in one array, offsets are stable after resize
+    size_t total = 0;
+    for (auto& r : ranges) total += r.count;
+    vector<VkDescriptorImageInfo> imageInfos(total);
+    vector<VkWriteDescriptorSet> descriptorSets;
+    descriptorSets.reserve(ranges.size());
+    size_t pos = 0;
+    for (auto& r : ranges) {
+        for (uint32_t i = 0; i < r.count; i++) {
+            TextureInfo* tex = store.getTextureInSlot(r.first + i);
+            imageInfos[pos + i] = (tex != nullptr && tex->imageView != nullptr) ? imageInfoFor(tex) : fillInfo;
+        }
+        VkWriteDescriptorSet descSet{};
+        descSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descSet.dstSet = store.descriptorSet;
+        descSet.dstBinding = 0;
+        descSet.dstArrayElement = r.first;
+        descSet.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        descSet.descriptorCount = r.count;
+        descSet.pImageInfo = &imageInfos[pos];
+        descriptorSets.push_back(descSet);
+        pos += r.count;
     }
-    VkWriteDescriptorSet descSet{};
-    descSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-    descSet.dstSet = engine->textureStore.descriptorSet;
-    descSet.dstBinding = 0;
-    descSet.dstArrayElement = 0;
-    descSet.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    descSet.descriptorCount = static_cast<uint32_t>(imageInfos.size());
-    descSet.pImageInfo = &imageInfos[0];
-
-    descriptorSets.push_back(descSet);
     vkUpdateDescriptorSets(engine->globalRendering.device, static_cast<uint32_t>(descriptorSets.size()), descriptorSets.data(), 0, nullptr);
 }
 
@@ -106,7 +106,9 @@ public:
 	void addGeometryShaderStageToMVPBuffer() {
 		this->addGeomShaderStageToMVP = true;
 	}
-    // update texture descriptors, after a texture has been added or removed
+	// dirty texture descriptor ranges closer than this are written with one VkWriteDescriptorSet
+	static constexpr uint32_t DESCRIPTOR_RANGE_MERGE_GAP = 8;
+    // update texture descriptors of slots changed since last call, after textures have been added, removed or changed
 	static void updateDescriptorSetForTextures(ShadedPathEngine* engine);
 
 private:
@@ -489,6 +489,7 @@ void World::prepareUltimateHeightmap(WorldObject* terrain)
         i++;
     }
 	ultHeightInfo.terrain = terrain;
+	prepareRaycast(ultHeightInfo);
 
 	// test border cases:
 	bool testing = false;
@@ -504,3 +505,69 @@ void World::prepareUltimateHeightmap(WorldObject* terrain)
 		Log("hwc: " << hwc << std::endl);
 	}
 }
+
+// collect grid heights and the diagonal of each square from the terrain triangles
+void World::prepareRaycast(UltimateHeightmapInfo& info)
+{
+	WorldObject* terrain = info.terrain;
+	int cells = static_cast<int>(info.squaresPerLine);
+	int samples = cells + 1;
+	float gridMin = info.gridIndex.front();
+	float spacing = (info.gridIndex.back() - gridMin) / cells;
+	auto gridCoord = [gridMin, spacing, cells](float f) {
+		return std::clamp(static_cast<int>(std::round((f - gridMin) / spacing)), 0, cells);
+	};
+	std::vector<float> heights(static_cast<size_t>(samples) * samples, 0.0f);
+	std::vector<uint8_t> flipped(static_cast<size_t>(cells) * cells, 0);
+	size_t indexCount = terrain->mesh->indices.size();
+	for (size_t i = 0; i + 6 <= indexCount; i += 6) {
+		int gx[6], gz[6];
+		for (int k = 0; k < 6; k++) {
+			vec3& v = terrain->mesh->vertices[terrain->mesh->indices[i + k]].pos;
+			gx[k] = gridCoord(v.x);
+			gz[k] = gridCoord(v.z);
+			heights[static_cast<size_t>(gz[k]) * samples + gx[k]] = v.y;
+		}
+		int x = std::min({ gx[0], gx[1], gx[2] });
+		int z = std::min({ gz[0], gz[1], gz[2] });
+		if (x >= cells || z >= cells) continue;
+		// the diagonal is the edge shared by both triangles: flipped if its corners are (x + 1, z) and (x, z + 1)
+		int sharedAntiDiagonal = 0;
+		for (int a = 0; a < 3; a++) {
+			for (int b = 3; b < 6; b++) {
+				if (gx[a] == gx[b] && gz[a] == gz[b] && gx[a] - x != gz[a] - z) sharedAntiDiagonal++;
+			}
+		}
+		flipped[static_cast<size_t>(z) * cells + x] = sharedAntiDiagonal == 2 ? 1 : 0;
+	}
+	float offset = -sizex / 2.0f; // mesh coords to world coords, see getHeightmapValue()
+	raycast.init(std::move(heights), samples, gridMin + offset, info.gridIndex.back() + offset, std::move(flipped));
+}
+
+bool World::intersectRay(const glm::vec3& origin, const glm::vec3& direction, HeightmapHit& hit, float maxDistance)
+{
+	if (!raycast.isInitialized()) {
+		Error("World::intersectRay: prepareUltimateHeightmap() has to be called before");
+	}
+	HeightmapRay ray;
+	ray.origin = origin;
+	ray.direction = direction;
+	ray.maxDistance = maxDistance;
+	return raycast.intersect(ray, hit);
+}
+
+void World::intersectRays(std::span<const HeightmapRay> rays, std::span<HeightmapHit> hits, ThreadGroup* threads)
+{
+	if (!raycast.isInitialized()) {
+		Error("World::intersectRays: prepareUltimateHeightmap() has to be called before");
+	}
+	raycast.intersect(rays, hits, threads);
+}
+
+bool World::isLineOfSightBlocked(const glm::vec3& from, const glm::vec3& to)
+{
+	if (!raycast.isInitialized()) {
+		Error("World::isLineOfSightBlocked: prepareUltimateHeightmap() has to be called before");
+	}
+	return raycast.isLineBlocked(from, to);
+}
@@ -47,6 +47,18 @@ public:
 	// same precision as terrain data. Constant run time.
 	float getHeightmapValue(float x, float z);
 
+    // nearest intersection of ray with the terrain of the ultimate heightmap, direction has to be normalized.
+	// Walks a min/max mip pyramid of the terrain grid, exact against the terrain triangles.
+	// prepareUltimateHeightmap() has to be called before
+	bool intersectRay(const glm::vec3& origin, const glm::vec3& direction, HeightmapHit& hit, float maxDistance = std::numeric_limits<float>::max());
+	// batched version of intersectRay(), hits[i] for rays[i]
+	void intersectRays(std::span<const HeightmapRay> rays, std::span<HeightmapHit> hits, ThreadGroup* threads = nullptr);
+	// true if terrain is between the two points
+	bool isLineOfSightBlocked(const glm::vec3& from, const glm::vec3& to);
+	const HeightmapRaycast& getHeightmapRaycast() const {
+		return raycast;
+	}
+
     // check if point is inside triangle, use with care: a point on or close to border line may erroneously return false
 	bool isPointInTriangle(const glm::vec3& p, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c);
 	Path paths;
@@ -66,5 +78,8 @@ private:
     // the other three vertices of the triangle are then at index +1, +2 and +3
 	size_t getSquareIndex(UltimateHeightmapInfo& info, int x, int z);
 	size_t getTriangleIndex(UltimateHeightmapInfo& info, float x, float z);
+	// build raycast pyramid from terrain triangles
+	void prepareRaycast(UltimateHeightmapInfo& info);
+	HeightmapRaycast raycast;
 };
 
@@ -57,10 +57,16 @@ bool LoadImageDataKTX(Image* image, const int image_idx, std::string* err,
     auto* coll = userData->collection;
 	auto* texture = userData->engine->textureStore.createTextureSlotForMesh(coll->getMeshInfoAt(coll->meshCount()-1), image_idx);
     //texture->type = TextureType::TEXTURE_TYPE_GLTF;
-	userData->engine->textureStore.createVulkanTextureFromKTKTexture(kTexture, texture);
+	auto& store = userData->engine->textureStore;
+	if (store.isStreamable(kTexture, texture)) {
+		// texture store keeps ktx data for mip streaming
+		store.createStreamedTexture(kTexture, texture);
+	} else {
+		store.createVulkanTextureFromKTKTexture(kTexture, texture);
+		//userData->engine->textureStore.destroyKTXIntermediate(kTexture);
+		ktxTexture_Destroy(kTexture);
+	}
 	userData->collection->textureInfos[image_idx] = texture;
-	//userData->engine->textureStore.destroyKTXIntermediate(kTexture);
-	ktxTexture_Destroy(kTexture);
 	return true;
 }
 
@@ -150,18 +156,6 @@ static inline int ResolveTexCoordUsed(const int tiTexCoord, const KHRTextureTran
 	return (t.texCoordOverride >= 0) ? t.texCoordOverride : tiTexCoord;
 }
 
-static inline glm::vec2 ApplyTransformToUV(glm::vec2 uv, const KHRTextureTransform& t) {
-	// Spec order: scale -> rotate -> translate, pivot at origin.
-	uv *= t.scale;
-	if (t.rotation != 0.0f) {
-		float c = std::cos(t.rotation);
-		float s = std::sin(t.rotation);
-		uv = glm::vec2(c * uv.x - s * uv.y, s * uv.x + c * uv.y);
-	}
-	uv += t.offset;
-	return uv;
-}
-
 static inline bool NearlyEqual(float a, float b, float eps = 1e-6f) {
 	return std::abs(a - b) <= eps;
 }
@@ -175,139 +169,87 @@ static bool SameTransform(const KHRTextureTransform& a, const KHRTextureTransfor
 		a.texCoordOverride == b.texCoordOverride;
 }
 
-static void ApplyTransformToMeshUVChannel(std::vector<PBRShader::Vertex>& verts, int uvSet, const KHRTextureTransform& t) {
-	if (!t.present) return;
-	if (uvSet < 0) return;
-	for (auto& v : verts) {
-		if (uvSet == 0) {
-			v.uv0 = ApplyTransformToUV(v.uv0, t);
-		}
-		else if (uvSet == 1) {
-			v.uv1 = ApplyTransformToUV(v.uv1, t);
-		}
-		else {
-			// Only TEXCOORD_0 and TEXCOORD_1 are supported by current vertex format.
-			// Silently ignore higher channels.
-		}
-	}
-}
-
-static inline float DecodeComponent(int componentType, bool normalized, const void* src)
-{
-	switch (componentType) {
-	case TINYGLTF_COMPONENT_TYPE_FLOAT: {
-		float v;
-		std::memcpy(&v, src, sizeof(float));
-		return v;
-	}
-	case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE: {
-		uint8_t v;
-		std::memcpy(&v, src, 1);
-		return normalized ? (float)v / 255.0f : (float)v;
-	}
-	case TINYGLTF_COMPONENT_TYPE_BYTE: {
-		int8_t v;
-		std::memcpy(&v, src, 1);
-		if (normalized) {
-			// Map to [-1,1]
-			return std::max(-1.0f, (float)v / 127.0f);
+// Bake transforms into vertex UVs per channel (only TEXCOORD_0 and TEXCOORD_1 supported).
+// If multiple textures require different transforms on the same UV set, the first one wins.
+// Warnings are only logged if requested, as vertex decoding runs on worker threads
+static void ResolveUVSetTransforms(const tinygltf::Material& mat, std::optional<KHRTextureTransform> perSet[2], bool logConflicts) {
+	// works for TextureInfo, NormalTextureInfo and OcclusionTextureInfo
+	auto consider = [&](const auto& ti, const char* usage) {
+		if (ti.index < 0) return;
+		KHRTextureTransform t = ParseKHRTextureTransform(ti.extensions);
+		int tc = ResolveTexCoordUsed(ti.texCoord, t);
+		if (tc < 0 || tc > 1 || !t.present) return;
+		if (!perSet[tc].has_value()) {
+			perSet[tc] = t;
 		}
-		return (float)v;
-	}
-	case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: {
-		uint16_t v;
-		std::memcpy(&v, src, 2);
-		return normalized ? (float)v / 65535.0f : (float)v;
-	}
-	case TINYGLTF_COMPONENT_TYPE_SHORT: {
-		int16_t v;
-		std::memcpy(&v, src, 2);
-		if (normalized) {
-			return std::max(-1.0f, (float)v / 32767.0f);
+		else if (!SameTransform(perSet[tc].value(), t) && logConflicts) {
+			Log(std::string("WARNING: Different KHR_texture_transform for UV set ") + std::to_string(tc) +
+				" between textures; keeping first and ignoring '" + usage + "' transform\n");
 		}
-		return (float)v;
-	}
-	case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT: {
-		uint32_t v;
-		std::memcpy(&v, src, 4);
-		return (float)v; // POSITION should not be UINT normally, but handle generically.
-	}
-	default:
-		Log("Unsupported vertex componentType: " << componentType << "\n");
-		return 0.0f;
-	}
+		};
+	consider(mat.pbrMetallicRoughness.baseColorTexture, "baseColor");
+	consider(mat.pbrMetallicRoughness.metallicRoughnessTexture, "metallicRoughness");
+	consider(mat.normalTexture, "normal");
+	consider(mat.occlusionTexture, "occlusion");
+	consider(mat.emissiveTexture, "emissive");
 }
 
-void extractVertexAttribute(const tinygltf::Model& model, const tinygltf::Primitive& primitive, const std::string& attributeName, std::vector<float>& outData, int& stride) {
-	outData.clear();
-	stride = 0;
-
-	auto it = primitive.attributes.find(attributeName);
-	if (it == primitive.attributes.end()) return;
-
-	const tinygltf::Accessor& accessor = model.accessors[it->second];
-	if (accessor.bufferView < 0) {
-		Log("Accessor bufferView < 0 for attribute " << attributeName << "\n");
-		return;
-	}
-
-	const tinygltf::BufferView& bufferView = model.bufferViews[accessor.bufferView];
-	const tinygltf::Buffer& buffer = model.buffers[bufferView.buffer];
-
+// typed view into accessor data, including sparse substitution. Invalid view if attribute is missing
+static AccessorView GetAccessorView(const tinygltf::Model& model, int accessorIndex, const char* name) {
+	AccessorView view;
+	if (accessorIndex < 0) return view;
+	const tinygltf::Accessor& accessor = model.accessors[accessorIndex];
 	const size_t numComponents = tinygltf::GetNumComponentsInType(accessor.type);
 	if (numComponents == 0) {
-		Log("Invalid accessor.type for attribute " << attributeName << "\n");
-		return;
+		Log("Invalid accessor.type for attribute " << name << "\n");
+		return view;
 	}
-
-	// Bytes per single component.
-	int componentSize = 0;
-	switch (accessor.componentType) {
-	case TINYGLTF_COMPONENT_TYPE_FLOAT:          componentSize = 4; break;
-	case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
-	case TINYGLTF_COMPONENT_TYPE_BYTE:           componentSize = 1; break;
-	case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
-	case TINYGLTF_COMPONENT_TYPE_SHORT:          componentSize = 2; break;
-	case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:   componentSize = 4; break;
-	default:
+	view.componentType = static_cast<AccessorComponentType>(accessor.componentType);
+	if (AccessorView::componentSize(view.componentType) == 0) {
 		Log("Unsupported vertex componentType: " << accessor.componentType << "\n");
-		return;
-	}
-
-	// Byte stride between consecutive vertices in the buffer.
-	const int byteStride = accessor.ByteStride(bufferView) > 0
-		? accessor.ByteStride(bufferView)
-		: int(numComponents) * componentSize;
-
-	if (byteStride < componentSize * int(numComponents)) {
-		// Spec allows >= packed size. Anything smaller is invalid.
-		Log("Invalid byteStride (" << byteStride << ") for attribute " << attributeName << "\n");
-		return;
-	}
-
-	const size_t start = bufferView.byteOffset + accessor.byteOffset;
-	// Last vertex must fit: start + (count-1)*byteStride + packedSize
-	const size_t packedSize = numComponents * size_t(componentSize);
-	const size_t lastByte = start + (accessor.count ? (accessor.count - 1) * size_t(byteStride) : 0) + packedSize;
-	if (lastByte > buffer.data.size()) {
-		Log("Buffer overrun risk while reading attribute " << attributeName << "\n");
-		return;
-	}
-
-	const unsigned char* basePtr = reinterpret_cast<const unsigned char*>(buffer.data.data() + start);
-
-	outData.resize(accessor.count * numComponents);
-	stride = int(numComponents); // number of float components per vertex
-
-	for (size_t i = 0; i < accessor.count; ++i) {
-		const unsigned char* elem = basePtr + i * byteStride;
-		// Components in the attribute are ALWAYS tightly packed starting at elem,
-		// even if vertex is interleaved (extra bytes follow after the attribute data).
-		for (size_t c = 0; c < numComponents; ++c) {
-			const void* compSrc = elem + c * componentSize;
-			outData[i * numComponents + c] = DecodeComponent(accessor.componentType, accessor.normalized, compSrc);
+		return view;
+	}
+	view.numComponents = static_cast<int>(numComponents);
+	view.normalized = accessor.normalized;
+	if (accessor.bufferView >= 0) {
+		const tinygltf::BufferView& bufferView = model.bufferViews[accessor.bufferView];
+		const tinygltf::Buffer& buffer = model.buffers[bufferView.buffer];
+		int byteStride = accessor.ByteStride(bufferView);
+		view.byteStride = byteStride > 0 ? byteStride : 0;
+		const size_t start = bufferView.byteOffset + accessor.byteOffset;
+		// Last element must fit: start + (count-1)*byteStride + packedSize
+		const size_t packedSize = numComponents * AccessorView::componentSize(view.componentType);
+		if (view.elementStride() < packedSize) {
+			Log("Invalid byteStride (" << byteStride << ") for attribute " << name << "\n");
+			return AccessorView();
 		}
-	}
+		const size_t lastByte = start + (accessor.count ? (accessor.count - 1) * view.elementStride() : 0) + packedSize;
+		if (lastByte > buffer.data.size()) {
+			Log("Buffer overrun risk while reading attribute " << name << "\n");
+			return AccessorView();
+		}
+		view.data = buffer.data.data() + start;
+	}
+	if (accessor.sparse.isSparse) {
+		auto& sparse = accessor.sparse;
+		const tinygltf::BufferView& indexView = model.bufferViews[sparse.indices.bufferView];
+		const tinygltf::BufferView& valueView = model.bufferViews[sparse.values.bufferView];
+		view.sparseCount = sparse.count;
+		view.sparseIndexType = static_cast<AccessorComponentType>(sparse.indices.componentType);
+		view.sparseIndices = model.buffers[indexView.buffer].data.data() + indexView.byteOffset + sparse.indices.byteOffset;
+		view.sparseValues = model.buffers[valueView.buffer].data.data() + valueView.byteOffset + sparse.values.byteOffset;
+	} else if (accessor.bufferView < 0) {
+		Log("Accessor bufferView < 0 for attribute " << name << "\n");
+		return AccessorView();
+	}
+	view.count = accessor.count;
+	return view;
+}
+
+static AccessorView GetAttributeView(const tinygltf::Model& model, const tinygltf::Primitive& primitive, const std::string& attributeName) {
+	auto it = primitive.attributes.find(attributeName);
+	if (it == primitive.attributes.end()) return AccessorView();
+	return GetAccessorView(model, it->second, attributeName.c_str());
 }
 
 void glTF::loadVertices(tinygltf::Model& model, MeshInfo* mesh, std::vector<PBRShader::Vertex>& verts, std::vector<uint32_t>& indexBuffer, int gltfMeshIndex, int primitiveIndex) {
@@ -331,104 +273,39 @@ void glTF::loadVertices(tinygltf::Model& model, MeshInfo* mesh, std::vector<PBRS
 				Error("Cannot parse mesh without indices");
 			}
 
-			// Extract positions
-			std::vector<float> positions;
-			int posStride;
-			extractVertexAttribute(model, primitive, "POSITION", positions, posStride);
-
-			// Extract colors
-			std::vector<float> colors;
-			int colorStride;
-			extractVertexAttribute(model, primitive, "COLOR_0", colors, colorStride);
-
-			// Extract texture coordinates
-			std::vector<float> texCoords;
-			int texCoordStride;
-			extractVertexAttribute(model, primitive, "TEXCOORD_0", texCoords, texCoordStride);
-
-			// Extract 2nd texture coordinates
-			std::vector<float> texCoords2;
-			int texCoordStride2;
-			extractVertexAttribute(model, primitive, "TEXCOORD_1", texCoords2, texCoordStride2);
-
-			// Extract normals
-			std::vector<float> normals;
-			int normalStride;
-			extractVertexAttribute(model, primitive, "NORMAL", normals, normalStride);
-
-            // Populate vertices, all floats are auto initialized to 0.0f
-			for (size_t v = 0; v < positions.size() / posStride; v++) {
-				PBRShader::Vertex vert{};
-				vert.pos = glm::vec3(positions[v * posStride], positions[v * posStride + 1], positions[v * posStride + 2]);
-
-				if (!colors.empty()) {
-				// Access components safely: COLOR_0 may be vec3 or vec4. If alpha not present, default to 1.0f.
-				float cr = 0.0f, cg = 0.0f, cb = 0.0f, ca = 1.0f;
-				int base = static_cast<int>(v) * colorStride;
-				if (colorStride > 0) cr = colors[base + 0];
-				if (colorStride > 1) cg = colors[base + 1];
-				if (colorStride > 2) cb = colors[base + 2];
-				if (colorStride > 3) ca = colors[base + 3];
-				vert.color = glm::vec4(cr, cg, cb, ca);
-				}
-				else {
-					vert.color = glm::vec4(1.0f); // Default to white if no color attribute
-				}
-
-				if (!texCoords.empty()) {
-					vert.uv0 = glm::vec2(texCoords[v * texCoordStride], texCoords[v * texCoordStride + 1]);
-				}
-				if (!texCoords2.empty()) {
-					vert.uv1 = glm::vec2(texCoords2[v * texCoordStride2], texCoords2[v * texCoordStride2 + 1]);
+			// typed views into gltf buffers, decoded and interleaved in one pass
+			PrimitiveDecodeInput in;
+			in.position = GetAttributeView(model, primitive, "POSITION");
+			in.normal = GetAttributeView(model, primitive, "NORMAL");
+			in.uv0 = GetAttributeView(model, primitive, "TEXCOORD_0");
+			in.uv1 = GetAttributeView(model, primitive, "TEXCOORD_1");
+			in.color = GetAttributeView(model, primitive, "COLOR_0");
+			in.joints = GetAttributeView(model, primitive, "JOINTS_0");
+			in.weights = GetAttributeView(model, primitive, "WEIGHTS_0");
+			// KHR_texture_transform is applied during decoding
+			if (primitive.material >= 0) {
+				std::optional<KHRTextureTransform> perSet[2];
+				ResolveUVSetTransforms(model.materials[primitive.material], perSet, false);
+				for (int set = 0; set < 2; set++) {
+					if (perSet[set].has_value()) {
+						auto& t = perSet[set].value();
+						in.uvTransform[set] = UVTransform::fromKHR(t.offset, t.scale, t.rotation);
+					}
 				}
-				if (!normals.empty()) {
-                    vert.normal = glm::vec3(normals[v * normalStride], normals[v * normalStride + 1], normals[v * normalStride + 2]);
-                }
-
-				verts.push_back(vert);
 			}
+			VertexDecode::decodePrimitive(in, verts);
 
 			// Parse indices
-			const tinygltf::Accessor& accessor = model.accessors[primitive.indices];
-			const tinygltf::BufferView& bufferView = model.bufferViews[accessor.bufferView];
-			const tinygltf::Buffer& buffer = model.buffers[bufferView.buffer];
-
-			uint32_t indexCount = static_cast<uint32_t>(accessor.count);
-			const void* dataPtr = &(buffer.data[accessor.byteOffset + bufferView.byteOffset]);
-
-			switch (accessor.componentType) {
-			case TINYGLTF_PARAMETER_TYPE_UNSIGNED_INT: {
-				const uint32_t* buf = static_cast<const uint32_t*>(dataPtr);
-				for (size_t index = 0; index < accessor.count; index++) {
-					indexBuffer.push_back(buf[index] + vertexStart);
-				}
-				break;
-			}
-			case TINYGLTF_PARAMETER_TYPE_UNSIGNED_SHORT: {
-				const uint16_t* buf = static_cast<const uint16_t*>(dataPtr);
-				for (size_t index = 0; index < accessor.count; index++) {
-					indexBuffer.push_back(buf[index] + vertexStart);
-				}
-				break;
+			AccessorView indexView = GetAccessorView(model, primitive.indices, "indices");
+			if (!indexView.isValid() || indexView.data == nullptr) {
+				Error("Cannot parse mesh indices");
 			}
-			case TINYGLTF_PARAMETER_TYPE_UNSIGNED_BYTE: {
-				const uint8_t* buf = static_cast<const uint8_t*>(dataPtr);
-				for (size_t index = 0; index < accessor.count; index++) {
-					indexBuffer.push_back(buf[index] + vertexStart);
-				}
-				break;
-			}
-			default:
-				Error("Index component type not supported!");
-			}
-
-			Log("Verts loaded: " << verts.size() << endl);
-			Log("Indices loaded: " << indexBuffer.size() << endl);
+			VertexDecode::decodeIndices(indexView, vertexStart, indexBuffer);
 			assert(indexBuffer.size() % 3 == 0); // Ensure triangles
 
 			if (mesh->flags.hasFlag(MeshFlags::MESH_TYPE_FLIP_WINDING_ORDER)) {
 				// Flip winding order
-				for (size_t i = 0; i < indexBuffer.size(); i += 3) {
+				for (size_t i = indexStart; i < indexBuffer.size(); i += 3) {
 					std::swap(indexBuffer[i], indexBuffer[i + 2]);
 				}
 			}
@@ -542,32 +419,10 @@ void glTF::prepareTexturesAndMaterials(tinygltf::Model& model, MeshCollection* c
 		tcEmi = ResolveTexCoordUsed(mat.emissiveTexture.texCoord, tfEmi);
 	}
 
-	// Bake transforms into vertex UVs per channel (only TEXCOORD_0 and TEXCOORD_1 supported).
-	// If multiple textures require different transforms on the same UV set, the first one wins; a warning is logged.
-	std::optional<KHRTextureTransform> perSet[2];
-
-	auto consider = [&](int tc, const KHRTextureTransform& t, const char* usage) {
-		if (tc < 0 || tc > 1 || !t.present) return;
-		if (!perSet[tc].has_value()) {
-			perSet[tc] = t;
-		}
-		else if (!SameTransform(perSet[tc].value(), t)) {
-			Log(std::string("WARNING: Different KHR_texture_transform for UV set ") + std::to_string(tc) +
-				" between textures; keeping first and ignoring '" + usage + "' transform\n");
-		}
-		};
-
-	consider(tcBase, tfBase, "baseColor");
-	consider(tcMR, tfMR, "metallicRoughness");
-	consider(tcNormal, tfNormal, "normal");
-	consider(tcOcc, tfOcc, "occlusion");
-	consider(tcEmi, tfEmi, "emissive");
-
-	if (perSet[0].has_value()) {
-		ApplyTransformToMeshUVChannel(mesh->vertices, 0, perSet[0].value());
-	}
-	if (perSet[1].has_value()) {
-		ApplyTransformToMeshUVChannel(mesh->vertices, 1, perSet[1].value());
+	// UV transforms were already baked into vertices during decoding, only report conflicting transforms here
+	{
+		std::optional<KHRTextureTransform> perSet[2];
+		ResolveUVSetTransforms(mat, perSet, true);
 	}
 
 	// Now bind textures and pass the correct (possibly overridden) texCoord to TextureInfo
@@ -857,6 +712,138 @@ void glTF::collectBaseTransform(tinygltf::Model& model, MeshInfo* mesh)
 	// mesh->baseTransform = glm::mat4(1.0f);
 }
 
+static std::unordered_map<int, int> BuildParentMap(const tinygltf::Model& model) {
+	std::unordered_map<int, int> parentOf;
+	for (int i = 0; i < static_cast<int>(model.nodes.size()); ++i) {
+		for (int c : model.nodes[i].children) {
+			parentOf[c] = i;
+		}
+	}
+	return parentOf;
+}
+
+static glm::mat4 ComputeWorldMatrixForNode(const tinygltf::Model& model, const std::unordered_map<int, int>& parentOf, int node) {
+	glm::mat4 world(1.0f);
+	while (node >= 0) {
+		world = BuildLocalNodeMatrix(model.nodes[node]) * world;
+		auto it = parentOf.find(node);
+		node = it == parentOf.end() ? -1 : it->second;
+	}
+	return world;
+}
+
+// rest pose of joint node as translation, rotation, scale
+static void GetNodeTRS(const tinygltf::Node& node, glm::vec3& t, glm::quat& r, glm::vec3& s) {
+	t = glm::vec3(0.0f);
+	r = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+	s = glm::vec3(1.0f);
+	if (node.matrix.size() == 16) {
+		// decompose, joint matrices must not contain shear
+		glm::mat4 m = BuildLocalNodeMatrix(node);
+		t = glm::vec3(m[3]);
+		s = glm::vec3(glm::length(glm::vec3(m[0])), glm::length(glm::vec3(m[1])), glm::length(glm::vec3(m[2])));
+		glm::mat3 rot(glm::vec3(m[0]) / s.x, glm::vec3(m[1]) / s.y, glm::vec3(m[2]) / s.z);
+		r = glm::quat_cast(rot);
+		return;
+	}
+	if (node.translation.size() == 3) t = glm::vec3(node.translation[0], node.translation[1], node.translation[2]);
+	if (node.rotation.size() == 4) r = glm::quat((float)node.rotation[3], (float)node.rotation[0], (float)node.rotation[1], (float)node.rotation[2]);
+	if (node.scale.size() == 3) s = glm::vec3(node.scale[0], node.scale[1], node.scale[2]);
+}
+
+static shared_ptr<AnimationSet> LoadSkin(const tinygltf::Model& model, const std::unordered_map<int, int>& parentOf, int skinIndex, int meshNode) {
+	const tinygltf::Skin& skin = model.skins[skinIndex];
+	auto set = make_shared<AnimationSet>();
+	Skeleton& sk = set->skeleton;
+	std::unordered_map<int, int> nodeToJoint;
+	for (int j = 0; j < (int)skin.joints.size(); j++) {
+		nodeToJoint[skin.joints[j]] = j;
+	}
+	vector<float> ibm(skin.joints.size() * 16, 0.0f);
+	AccessorView ibmView = GetAccessorView(model, skin.inverseBindMatrices, "inverseBindMatrices");
+	if (ibmView.isValid() && ibmView.count >= skin.joints.size()) {
+		VertexDecode::decodeFloats(ibmView, 0, skin.joints.size(), ibm.data(), 16);
+	} else {
+		// no inverse bind matrices: identity as defined in glTF spec
+		for (size_t j = 0; j < skin.joints.size(); j++) {
+			for (int d = 0; d < 4; d++) ibm[j * 16 + d * 5] = 1.0f;
+		}
+	}
+	glm::mat4 meshInverse = glm::inverse(ComputeWorldMatrixForNode(model, parentOf, meshNode));
+	for (int j = 0; j < (int)skin.joints.size(); j++) {
+		int node = skin.joints[j];
+		auto p = parentOf.find(node);
+		auto parentJoint = p == parentOf.end() ? nodeToJoint.end() : nodeToJoint.find(p->second);
+		glm::vec3 t, s;
+		glm::quat r;
+		GetNodeTRS(model.nodes[node], t, r, s);
+		glm::mat4 inverseBind;
+		memcpy(&inverseBind[0][0], ibm.data() + j * 16, sizeof(glm::mat4));
+		sk.addJoint(model.nodes[node].name, parentJoint == nodeToJoint.end() ? -1 : parentJoint->second, t, r, s, inverseBind);
+		if (sk.parent[j] < 0) {
+			// non joint parents are not animated
+			glm::mat4 parentWorld = p == parentOf.end() ? glm::mat4(1.0f) : ComputeWorldMatrixForNode(model, parentOf, p->second);
+			sk.rootTransform[j] = meshInverse * parentWorld;
+		}
+	}
+	sk.finish();
+
+	for (auto& anim : model.animations) {
+		AnimationClip clip;
+		clip.name = anim.name.empty() ? "Animation" + to_string(set->clips.size()) : anim.name;
+		for (auto& channel : anim.channels) {
+			auto joint = nodeToJoint.find(channel.target_node);
+			if (joint == nodeToJoint.end()) continue; // other skin or not a joint
+			AnimationChannel ch;
+			ch.joint = joint->second;
+			if (channel.target_path == "translation") ch.path = AnimationPath::Translation;
+			else if (channel.target_path == "rotation") ch.path = AnimationPath::Rotation;
+			else if (channel.target_path == "scale") ch.path = AnimationPath::Scale;
+			else continue; // morph target weights are not supported
+			const tinygltf::AnimationSampler& sampler = anim.samplers[channel.sampler];
+			if (sampler.interpolation == "STEP") ch.interpolation = AnimationInterpolation::Step;
+			else if (sampler.interpolation == "CUBICSPLINE") ch.interpolation = AnimationInterpolation::CubicSpline;
+			else ch.interpolation = AnimationInterpolation::Linear;
+			AccessorView input = GetAccessorView(model, sampler.input, "animation input");
+			AccessorView output = GetAccessorView(model, sampler.output, "animation output");
+			size_t valuesPerKey = ch.interpolation == AnimationInterpolation::CubicSpline ? 3 : 1;
+			if (!input.isValid() || !output.isValid() || input.count == 0 || output.count != input.count * valuesPerKey) {
+				Log("WARNING: skipping invalid animation channel in " << clip.name << endl);
+				continue;
+			}
+			ch.times.resize(input.count);
+			VertexDecode::decodeFloats(input, 0, input.count, ch.times.data(), 1);
+			ch.values.resize(output.count);
+			VertexDecode::decodeFloats(output, 0, output.count, &ch.values[0].x, 4);
+			clip.duration = std::max(clip.duration, ch.times.back());
+			clip.channels.push_back(std::move(ch));
+		}
+		if (!clip.channels.empty()) {
+			set->clips.push_back(std::move(clip));
+		}
+	}
+	return set;
+}
+
+void glTF::loadSkinsAndAnimations(tinygltf::Model& model, MeshCollection* coll)
+{
+	if (model.skins.empty()) return;
+	auto parentOf = BuildParentMap(model);
+	for (int n = 0; n < (int)model.nodes.size(); n++) {
+		const tinygltf::Node& node = model.nodes[n];
+		if (node.mesh < 0 || node.skin < 0) continue;
+		if (model.skins[node.skin].joints.size() > MAX_NUM_JOINTS) {
+			Log("WARNING: skin " << node.skin << " has more than " << MAX_NUM_JOINTS << " joints, mesh is rendered in bind pose" << endl);
+			continue;
+		}
+		shared_ptr<AnimationSet> set = LoadSkin(model, parentOf, node.skin, n);
+		Log("Skin " << node.skin << ": " << set->skeleton.size() << " joints, " << set->clips.size() << " animation clips" << endl);
+		for (auto* mi : *coll) {
+			if (mi->gltfMeshIndex == node.mesh) mi->animation = set;
+		}
+	}
+}
+
 // TODO: change this mess to a 2-pass system where first all meshes parsed and sorted, then in a 2nd pass added to mesh store
 void glTF::load(const unsigned char* data, int size, MeshCollection* coll, string filename)
 {
@@ -867,13 +854,20 @@ void glTF::load(const unsigned char* data, int size, MeshCollection* coll, strin
 	// at this point all textures of gltf file are loaded. info: mesh->textureInfos[]
 	// vertices/indexes are not yet copied from gltf to our buffers
 	Log("Meshes in " << filename.c_str() << endl);
+    // 1) create one MeshInfo per primitive so e.g. trunk and foliage can be separate.
+    //    mesh store is not thread safe, so this is done serially
+    struct PrimitiveJob {
+        MeshInfo* mesh;
+        int meshIndex;
+        int prim;
+    };
+    vector<PrimitiveJob> jobs;
     // Iterate over meshes by index so we can assign the correct gltf mesh index
     for (int meshIndex = 0; meshIndex < (int)model.meshes.size(); ++meshIndex) {
         auto& m = model.meshes[meshIndex];
         Log("  " << m.name.c_str() << endl);
         MeshInfo* mesh = nullptr;
 
-        // For each primitive in the glTF mesh, create a MeshInfo entry so e.g. trunk and foliage can be separate
         for (int prim = 0; prim < (int)m.primitives.size(); ++prim) {
             if (meshIndex > 0 || prim > 0) {
                 // create unique id using meshIndex and primitive
@@ -889,21 +883,46 @@ void glTF::load(const unsigned char* data, int size, MeshCollection* coll, strin
             mesh->gltfMeshIndex = meshIndex;
             mesh->gltfPrimitiveIndex = prim;
             mesh->name = m.name;
+            jobs.push_back({ mesh, meshIndex, prim });
+        }
+    }
 
-            // 1) Load geometry first (creates uv0/uv1 on vertices)
-            loadVertices(model, mesh, mesh->vertices, mesh->indices, meshIndex, prim);
+    // 2) Load geometry (creates uv0/uv1 on vertices with KHR_texture_transform applied).
+    //    Primitives only write to their own MeshInfo, so they are decoded in parallel on the worker threads
+    ThreadGroup* workers = engine->getWorkerThreads();
+    if (workers != nullptr && jobs.size() > 1) {
+        vector<future<void>> futures;
+        futures.reserve(jobs.size());
+        for (auto& job : jobs) {
+            futures.push_back(workers->asyncSubmit([this, &model, job] {
+                loadVertices(model, job.mesh, job.mesh->vertices, job.mesh->indices, job.meshIndex, job.prim);
+            }));
+        }
+        for (auto& f : futures) {
+            f.get();
+        }
+    } else {
+        for (auto& job : jobs) {
+            loadVertices(model, job.mesh, job.mesh->vertices, job.mesh->indices, job.meshIndex, job.prim);
+        }
+    }
 
-            // 2) Then prepare textures and materials, which will parse KHR_texture_transform
-            //    and bake transforms into mesh->vertices.uv0/uv1.
-            prepareTexturesAndMaterials(model, coll, meshIndex, prim, mesh);
+    for (auto& job : jobs) {
+        MeshInfo* mesh = job.mesh;
+        Log("Verts loaded: " << mesh->vertices.size() << endl);
+        Log("Indices loaded: " << mesh->indices.size() << endl);
 
-            // 3) Collect node transform
-            collectBaseTransform(model, mesh);
+        // 3) Then prepare textures and materials (texture store and sampler cache are not thread safe)
+        prepareTexturesAndMaterials(model, coll, job.meshIndex, job.prim, mesh);
 
-            // set default lod category (should be overwritten in app code after mesh loading or per object)
-            mesh->material.lod_category = LOD_CATEGORY_GENERAL;
-        }
+        // 4) Collect node transform
+        collectBaseTransform(model, mesh);
+
+        // set default lod category (should be overwritten in app code after mesh loading or per object)
+        mesh->material.lod_category = LOD_CATEGORY_GENERAL;
     }
+	// skins and animations of skinned meshes
+	loadSkinsAndAnimations(model, coll);
 	// reorder collection for blocks of (10) lod meshes for one primitive
 	engine->meshStore.reorderForPrimitiveBlocks(coll);
     // set collection indices for each meshinfo contained in the collection:
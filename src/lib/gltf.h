@@ -39,6 +39,8 @@ private:
 	void validateModel(tinygltf::Model& model, MeshCollection* mesh);
 	// collect scale and rotation info from gltf nodes hierarchy and store in MeshInfo
 	void collectBaseTransform(tinygltf::Model& model, MeshInfo *mesh);
+	// import skins and their animations, AnimationSet is attached to all meshes of a skinned node
+	void loadSkinsAndAnimations(tinygltf::Model& model, MeshCollection* coll);
 	ShadedPathEngine* engine = nullptr;
 
 	//VkSamplerAddressMode getVkWrapMode(int32_t wrapMode)
@@ -5,12 +5,13 @@ using namespace std;
 void PBRShader::init(ShadedPathEngine& engine, ShaderState& shaderState)
 {
 	ShaderBase::init(engine);
+	multiviewSupported = true;
 	resources.setResourceDefinition(&vulkanResourceDefinition);
 
-	// create shader modules
-	taskShaderModule = resources.createShaderModule("pbr.task.spv");
-	meshShaderModule = resources.createShaderModule("pbr.mesh.spv");
-	fragShaderModule = resources.createShaderModule("pbr.frag.spv");
+	// create shader modules, multiview variants are compiled from the same sources with MULTIVIEW defined
+	taskShaderModule = resources.createShaderModule(isMultiview() ? "pbr_multiview.task.spv" : "pbr.task.spv");
+	meshShaderModule = resources.createShaderModule(isMultiview() ? "pbr_multiview.mesh.spv" : "pbr.mesh.spv");
+	fragShaderModule = resources.createShaderModule(isMultiview() ? "pbr_multiview.frag.spv" : "pbr.frag.spv");
 
 	// descriptor set (dynamic UBO - one large set, bind one for each object during command creation)
 	resources.createDescriptorSetResources(descriptorSetLayout, descriptorPool, this, 1);
@@ -50,6 +51,8 @@ void PBRShader::initialUpload(bool listUploadedMeshes)
 	for (auto meshptr : list) {
 		engine->meshStore.uploadMesh(meshptr);
 	}
+	// skinned objects get joint palettes in prefillModelParameters() and AnimationRuntime::updatePerFrame()
+	engine->animation.registerWorldObjects();
 	if (listUploadedMeshes) {
 		Log("" << list.size() << " uploaded meshes:\n");
 		int i = 0;
@@ -99,7 +102,12 @@ void PBRShader::prefillModelParametersSingleMesh(FrameResources& fr, MeshInfo* m
 		//ind.emissive = 3;
 	}
 	buf->indexes = ind;
-	buf->jointcount = 0;
+	if (obj->animationInstance != AnimationRuntime::INVALID_INSTANCE) {
+		// pose of registration until AnimationRuntime::updatePerFrame() runs
+		engine->animation.writeToModel(obj->animationInstance, buf);
+	} else {
+		buf->jointcount = 0;
+	}
 	shaderValuesParams params;
 	params.prefilteredCubeMipLevels = tiPrefileterdEnv->vulkanTexture.levelCount;
 	//params.lightDir = glm::vec4(
@@ -122,9 +130,9 @@ void PBRShader::prefillModelParametersSingleMesh(FrameResources& fr, MeshInfo* m
 	buf->material.irradiance = tiIrradiance->index;
 	buf->material.envcube = tiPrefileterdEnv->index;
 	//buf->material.texCoordSets.specularGlossiness = 27;
-	// calc and set bounding box from mesh data
+	// calc and set bounding box from mesh data, skinned meshes include their animation extent
 	BoundingBox box;
-	mi->getBoundingBox(box);
+	mi->getAnimatedBoundingBox(box);
 	buf->boundingBox = box;
 	if (obj->useGpuLod) {
 		buf->enableGpuLodRendering();
@@ -162,7 +170,10 @@ void PBRShader::prefillModelParameters(FrameResources& fr)
 void PBRShader::createCommandBuffer(FrameResources& tr)
 {
 	PBRSubShader& sub = globalSubShaders[tr.frameIndex];
+	// PBR command buffers are recorded once, not per frame in drawFrame(): time them with the other recordings
+	ThemedTimer::getInstance()->start(engine->getRecordCommandsTimer());
 	sub.createGlobalCommandBufferAndRenderPass(tr);
+	ThemedTimer::getInstance()->stop(engine->getRecordCommandsTimer());
 }
 
 void PBRShader::addCommandBuffers(FrameResources* fr, DrawResult* drawResult) {
@@ -177,6 +188,8 @@ void PBRShader::uploadToGPU(FrameResources& fr, UniformBufferObject& ubo, Unifor
     }
     ubo.frameNum = static_cast<uint32_t>(fr.frameNum);
     ubo2.frameNum = ubo.frameNum;
+    ubo.eye = 0;
+    ubo2.eye = 1;
 	auto& sub = globalSubShaders[fr.frameIndex];
     sub.uploadToGPU(fr, ubo, ubo2);
 }
@@ -271,11 +284,12 @@ void PBRSubShader::createDeviceLocalDynamicUBO() {
 void PBRSubShader::initSingle(FrameResources& tr, ShaderState& shaderState)
 {
     frameResources = &tr;
-    // MVP uniform buffer
-    pbrShader->createUniformBuffer(uniformBuffer, sizeof(PBRShader::UniformBufferObject), uniformBufferMemory);
+    // MVP uniform buffer, multiview: one buffer for both eyes
+    auto uboSize = pbrShader->isMultiview() ? PBRShader::getMultiviewUBOSize(sizeof(PBRShader::UniformBufferObject)) : sizeof(PBRShader::UniformBufferObject);
+    pbrShader->createUniformBuffer(uniformBuffer, uboSize, uniformBufferMemory);
     engine->util.debugNameObjectBuffer(uniformBuffer, "PBR UBO 1");
     engine->util.debugNameObjectDeviceMemory(uniformBufferMemory, "PBR Memory 1");
-    if (engine->isStereo()) {
+    if (engine->isStereo() && !pbrShader->isMultiview()) {
         pbrShader->createUniformBuffer(uniformBuffer2, sizeof(PBRShader::UniformBufferObject), uniformBufferMemory2);
         engine->util.debugNameObjectBuffer(uniformBuffer2, "PBR UBO 2");
         engine->util.debugNameObjectDeviceMemory(uniformBufferMemory2, "PBR Memory 2");
@@ -302,6 +316,11 @@ void PBRSubShader::initSingle(FrameResources& tr, ShaderState& shaderState)
     handover.mvpBuffer = uniformBuffer;
     handover.mvpBuffer2 = uniformBuffer2;
     handover.mvpSize = sizeof(PBRShader::UniformBufferObject);
+    if (pbrShader->isMultiview()) {
+        // descriptorSet2 is still allocated in stereo mode, but never bound
+        handover.mvpBuffer2 = uniformBuffer;
+        handover.mvpSize = PBRShader::getMultiviewUBOSize(sizeof(PBRShader::UniformBufferObject));
+    }
     handover.imageView = nullptr;
     handover.descriptorSet = &descriptorSet;
     handover.descriptorSet2 = &descriptorSet2;
@@ -381,9 +400,7 @@ void PBRSubShader::initSingle(FrameResources& tr, ShaderState& shaderState)
 	pipelineInfo.subpass = 0;
 	pipelineInfo.basePipelineHandle = VK_NULL_HANDLE; // Optional
 	pipelineInfo.basePipelineIndex = -1; // Optional
-	if (vkCreateGraphicsPipelines(pbrShader->device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &graphicsPipeline) != VK_SUCCESS) {
-		Error("failed to create graphics pipeline!");
-	}
+	engine->globalRendering.pipelineCache.createGraphicsPipelineDeferred(pipelineInfo, &graphicsPipeline);
 }
 
 void PBRSubShader::allocateCommandBuffer(FrameResources& tr, VkCommandBuffer* cmdBufferPtr, const char* debugName)
@@ -458,7 +475,8 @@ void PBRSubShader::createGlobalCommandBufferAndRenderPass(FrameResources& tr, bo
 		recordDrawCommand(commandBuffer, tr, obj, false, update);
 	}
 	vkCmdEndRenderPass(commandBuffer);
-	if (engine->isStereo()) {
+	// multiview renders both eyes in the first render pass
+	if (engine->isStereo() && !pbrShader->isMultiview()) {
 		renderPassInfo.framebuffer = framebuffer2;
 		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
 		for (auto obj : objs) {
@@ -472,6 +490,10 @@ void PBRSubShader::createGlobalCommandBufferAndRenderPass(FrameResources& tr, bo
 }
 
 void PBRSubShader::uploadToGPU(FrameResources& tr, PBRShader::UniformBufferObject& ubo, PBRShader::UniformBufferObject& ubo2) {
+	if (pbrShader->isMultiview()) {
+		pbrShader->uploadMultiviewUBO(uniformBufferMemory, &ubo, &ubo2, sizeof(ubo));
+		return;
+	}
 	// copy ubo to GPU:
 	void* data;
 	if (true) {
@@ -579,19 +601,21 @@ void PBRSubShader::destroy()
 	vkDestroyPipeline(device, graphicsPipeline, nullptr);
 	vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
 	vkDestroyBuffer(device, uniformBuffer, nullptr);
-	vkFreeMemory(device, uniformBufferMemory, nullptr);
+	engine->globalRendering.freeMemory(uniformBufferMemory);
 	vkDestroyBuffer(device, dynamicUniformBuffer, nullptr);
-	vkFreeMemory(device, dynamicUniformBufferMemory, nullptr);
-	if (engine->isStereo()) {
+	engine->globalRendering.freeMemory(dynamicUniformBufferMemory);
+	if (engine->isStereo() && !pbrShader->isMultiview()) {
 		vkDestroyFramebuffer(device, framebuffer2, nullptr);
 		vkDestroyBuffer(device, uniformBuffer2, nullptr);
-		vkFreeMemory(device, uniformBufferMemory2, nullptr);
+		engine->globalRendering.freeMemory(uniformBufferMemory2);
 	}
 }
 
 void PBRShader::recreateGlobalCommandBuffers()
 {
-	for (auto& fi : engine->frameInfos) {
+	for (auto& fi : engine->getFrameResources()) {
+		ThemedTimer::getInstance()->start(engine->getRecordCommandsTimer());
 		globalSubShaders[fi.frameIndex].createGlobalCommandBufferAndRenderPass(fi, true);
+		ThemedTimer::getInstance()->stop(engine->getRecordCommandsTimer());
 	}
 }
@@ -48,13 +48,14 @@ public:
 		int type; // 0=directional, 1=point, 2=spot
 	};
 
+	// ubo in pbr_mesh_common.glsl, EyeUBO for multiview where the buffer holds both eyes
 	struct UniformBufferObject {
 		glm::mat4 model;
 		glm::mat4 view;
 		glm::mat4 proj;
 		glm::vec4 baseColor = glm::vec4(1.0f);
 		uint32_t frameNum;      // new: current frame number
-		uint32_t pad0;          // pad to 16-byte multiple if desired (optional)
+		uint32_t eye;           // 0 == left eye or mono, 1 == right eye. Set in uploadToGPU()
 		uint32_t pad1;          // pad to 16-byte multiple if desired (optional)
 		uint32_t pad2;          // pad to 16-byte multiple if desired (optional)
 		glm::vec3 camPos = glm::vec3(std::numeric_limits<double>::quiet_NaN()); // signal that this is not set
@@ -109,6 +110,9 @@ public:
     static const unsigned int MODEL_RENDER_FLAG_USE_VERTEX_COLORS = 1; // use vertex colors only, no textures
 	static const unsigned int MODEL_RENDER_FLAG_DISABLE = 2; // disable rendering of this object for this frame
 	static const unsigned int MODEL_RENDER_FLAG_GPU_LOD = 4; // enable GPU LOD object manipulation
+	// set by FrustumCulling, independent of MODEL_RENDER_FLAG_DISABLE
+	static const unsigned int MODEL_RENDER_FLAG_CULLED_LEFT = 8; // outside left eye (or mono) frustum
+	static const unsigned int MODEL_RENDER_FLAG_CULLED_RIGHT = 16; // outside right eye frustum
 	// the dynamic uniform buffer is peramnently mapped to CPU memory for fast updates
     // TODO: major cleanup needed: move fixed values to material and redesign dynamic UBO to only contain per-frame changing values
 	struct alignas(16) DynamicModelUBO {
@@ -138,6 +142,11 @@ public:
 		void disableGpuLodRendering() {
 			flags &= ~MODEL_RENDER_FLAG_GPU_LOD;
 		}
+		void setCulled(bool culledLeft, bool culledRight) {
+			flags &= ~(MODEL_RENDER_FLAG_CULLED_LEFT | MODEL_RENDER_FLAG_CULLED_RIGHT);
+			if (culledLeft) flags |= MODEL_RENDER_FLAG_CULLED_LEFT;
+			if (culledRight) flags |= MODEL_RENDER_FLAG_CULLED_RIGHT;
+		}
         // since we allocate arrays of DynamicModelUBO we need an init function to set default values
 		void init() {
 			objPos = glm::vec3(std::numeric_limits<double>::quiet_NaN()); // signal that this is not set
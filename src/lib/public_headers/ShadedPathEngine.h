@@ -19,6 +19,10 @@ public:
     // allow the app to prepafe frame data in thread safe manner
     // called before rendering each frame, from main render thread
     virtual void prepareFrame(FrameResources* fi) {};
+    // only with simulation thread enabled: advance app state by one fixed tick, called from simulation thread.
+    // Return a new snapshot (derived from SimulationSnapshot) with all state prepareFrame() needs,
+    // previous must not be changed. prepareFrame() finds the snapshots in fi->snapshot and fi->previousSnapshot
+    virtual std::shared_ptr<SimulationSnapshot> simulate(const SimulationSnapshot* previous, const GameTime& gameTime) { return std::make_shared<SimulationSnapshot>(); };
     // draw Frame depending on topic. is in range 0..appDrawCalls-1
     // each topic will be called in parallel threads
     virtual void drawFrame(FrameResources* fi, int topic, DrawResult* drawResult) {};
@@ -27,6 +31,8 @@ public:
     // process finished frame: dump to file, copy to window, etc.
     virtual void processImage(FrameResources* fi) {};
     virtual void buildCustomUI() {};
+    // hash of the values shown in buildCustomUI(), UI is only rebuilt when it changes or on input
+    virtual size_t getCustomUIStateHash() { return 0; };
     virtual bool shouldClose() { return true; };
     bool isCLITool = false;
 protected:
@@ -51,9 +57,14 @@ public:
         vr(this),
         objectStore(&meshStore),
         sound(*this),
-        limiter(60.0f)
+        inputPacer(60.0)
     {
         Log("Engine c'tor\n");
+        lodSelection.setEngine(this);
+        frustumCulling.setEngine(this);
+        occlusionCulling.setEngine(this);
+        textureResidency.setEngine(this);
+        animation.setEngine(this);
 #if defined (USE_FIXED_PHYSICAL_DEVICE_INDEX)
         Log("override device selection to device " << PHYSICAL_DEVICE_INDEX << std::endl);
         setFixedPhysicalDeviceIndex(PHYSICAL_DEVICE_INDEX);
@@ -79,6 +90,10 @@ public:
     // 2 images for left and right eye will be displayed in main window.
     // auto-enabled in VR mode
     ShadedPathEngine& setStereo(bool enable) { fii(); stereoMode = enable; return *this; }
+    // render both eyes of stereo mode in one render pass with multiview (VK_KHR_multiview, core in Vulkan 1.1)
+    // instead of one render pass per eye. Falls back to one pass per eye if the device does not support multiview.
+    // Shaders without multiview support still render each eye separately
+    ShadedPathEngine& setMultiview(bool enable) { fii(); multiviewMode = enable; return *this; }
     ShadedPathEngine& setEnableSound(bool enable) { fii(); enableSound = enable; return *this; }
     // default is multi thread mode - use this for all in one single thread
     // will disable render threads and global update thread
@@ -102,6 +117,14 @@ public:
     ShadedPathEngine& setMaxMeshes(uint64_t mm) { fii(); MaxMeshes = mm; return *this; }
     // set mesh storage size in GB
     ShadedPathEngine& setMeshStorageSizeGB(float sizeGB) { fii(); meshStorageSize = 1024*1024*1024 * sizeGB; return *this; }
+    // number of frames that can be prepared before the oldest one has to be finished on GPU (2 to MAX_FRAMES_IN_FLIGHT).
+    // More frames increase throughput if frame preparation and GPU work vary, but add latency
+    ShadedPathEngine& setFramesInFlight(int n) { fii(); if (n < 2 || n > MAX_FRAMES_IN_FLIGHT) Error("frames in flight out of range"); framesInFlight = n; return *this; }
+    // rate of main thread input loop in multi thread mode (default 60), e.g. 90, 120 or 144 to match HMD or monitor
+    ShadedPathEngine& setInputRate(double ratePerSecond) { inputPacer.setRate(ratePerSecond); return *this; }
+    // run app simulation (ShadedPathApplication::simulate()) at fixed tick rate in its own thread,
+    // overlapping with frame preparation and submit. In single thread mode due ticks are run before each frame
+    ShadedPathEngine& enableSimulationThread(double ticksPerSecond) { fii(); simulationEnabled = true; simulation.setTickRate(ticksPerSecond); return *this; }
 
     // getters
     bool isDebugWindowPosition() { return debugWindowPosition; }
@@ -112,11 +135,13 @@ public:
     bool isEnforceVR() { return vrEnforce; }
     bool isSoundEnabled() { return enableSound; }
     bool isGlobalWireframeEnabled() { return globalWireframe; }
+    bool isSimulationThreadEnabled() { return simulationEnabled; }
 
     bool isMainThread();
     void log_current_thread();
     ThreadInfo mainThreadInfo;
 
+    static constexpr int MAX_FRAMES_IN_FLIGHT = 4;
     const static std::string engineName;
     const static std::string engineVersion;
     const static uint32_t engineVersionInt;
@@ -162,6 +187,15 @@ public:
         return stereoPresentation;
     }
 
+    // stereo mode with both eyes in one render pass, see setMultiview()
+    bool isMultiview() {
+        return multiviewMode && stereoMode;
+    }
+    // ThemedTimer name for command buffer recording, one timer per stereo mode to compare runs with and without multiview
+    const char* getRecordCommandsTimer() {
+        return isMultiview() ? TIMER_PART_RECORD_COMMANDS_MULTIVIEW : TIMER_PART_RECORD_COMMANDS;
+    }
+
     bool isMeshShading() {
         return meshShaderEnabled;
     }
@@ -248,18 +282,26 @@ public:
     void initGlobal(std::string appname = "");
 
     PreStart preStart; // early initialization
+    MemoryTracker memoryTracker; // host and device memory per subsystem, before all members that report to it
     GlobalRendering globalRendering;
     Shaders shaders;
     Util util;
     VR vr;
 //private:
     // need to insert here for proper destruction order
-    std::array<FrameResources, 2> frameInfos; // only 2 frame infos needed for alternating during draw calls, initialized in initGlobal()
+    std::array<FrameResources, MAX_FRAMES_IN_FLIGHT> frameInfos; // first getFramesInFlight() are used round robin during draw calls, initialized in initGlobal()
 public:
     TextureStore textureStore;
+    TextureResidency textureResidency; // VRAM budget and mip streaming for textures
     MeshStore meshStore;
     WorldObjectStore objectStore;
+    LodSelection lodSelection; // CPU LOD for objects not using GPU LOD
+    FrustumCulling frustumCulling; // CPU culling of all objects, mono or both stereo eyes
+    OcclusionCulling occlusionCulling; // CPU occlusion culling of frustum culling results against terrain and large occluders
+    AnimationRuntime animation; // joint palettes of skinned objects
     Sound sound;
+    Simulation simulation; // fixed tick app simulation, see enableSimulationThread()
+    FramePipelineMetrics pipelineMetrics; // latency and throughput of submitted frames
 
     // non-Vulkan members
     Files files;
@@ -276,10 +318,11 @@ public:
     bool presentationMode = true; // get rid of this later
     int numWorkerThreads = 0;
     int getFramesInFlight() {
-        return numWorkerThreads; // 1 for  single thread mode, 2 or more for multi
+        return framesInFlight;
     }
-    std::array<FrameResources,2>& getFrameResources() {
-        return frameInfos;
+    // the used frame resources, getFramesInFlight() elements
+    std::span<FrameResources> getFrameResources() {
+        return std::span<FrameResources>(frameInfos.data(), framesInFlight);
     }
     // unsafe check if background thread is available - you still must do a reservation
     bool isBackgroundThreadAvailable() {
@@ -310,6 +353,8 @@ private:
     bool stereoMode = false;
     bool globalWireframe = false; // everything relying on ShaderBase::createStandardRasterizer() will have wireframe enabled
     bool meshShaderEnabled = false; // enable mesh shaders, if supported by GPU
+    bool simulationEnabled = false;
+    int framesInFlight = 2;
     ImageConsumer* imageConsumer = nullptr;
     ImageConsumerNullify imageConsumerNullify;
     // We have to set max number of objects, as dynamic uniform buffers have to be allocated (one entry for each object in a large buffer)
@@ -335,6 +380,7 @@ private:
     bool vrMode = false;
     bool vrEnforce = false;
     bool stereoPresentation = false;
+    bool multiviewMode = false;
     //bool meshShaderEnabled = false;
     bool singleQueueMode = false;
     int fixedPhysicalDeviceIndex = -1;
@@ -349,7 +395,8 @@ private:
     RenderQueue backgroundThreadQueue;
     std::atomic<bool> backgroundThreadAvailable = true;
     bool queueThreadFinished = false;
-    QueueSubmitResources qsr;
+    QueueSubmitResources qsr; // render thread continuation, one token for each frame that may be prepared ahead of submit
+    std::array<QueueSubmitResources, MAX_FRAMES_IN_FLIGHT> frameSubmits; // frames handed to queue submit thread
     QueueSubmitResources backRes;
 
     //std::future<void>* workerFutures = nullptr;
@@ -392,11 +439,16 @@ private:
     // VR system drawings (like SteamVR desk) are ok, so for debugging we can see different movement of e.g. our drawings and the SteamVR desk
     static void runQueueSubmit(ShadedPathEngine* engine_instance);
     static void runUpdateThread(ShadedPathEngine* engine_instance);
-    ThreadLimiter limiter;
+    static void runSimulationThread(ShadedPathEngine* engine_instance);
+    FramePacer inputPacer; // paces main thread input loop in multi thread mode
     void startRenderThread();
     void startQueueSubmitThread();
     // global update thread for shuffling data to GPU in the background
     void startUpdateThread();
+    void startSimulationThread();
+    // take latest simulation snapshots for current frame
+    void acquireSimulationState(FrameResources* fi);
+    std::chrono::steady_clock::time_point lastFrameStart;
     std::vector<WindowInfo*> windowInfos;
     ContinuationInfo* continuationInfo = nullptr;
     // fail if initialized. Util method for checking failing if engine is already initialized
@@ -23,6 +23,9 @@
 #define TIMER_PART_GLOBAL_UPDATE "PartGlobalUpdate"
 #define TIMER_PART_PREPARE_FRAME "PartPrepareFrame"
 #define TIMER_PART_OPENXR "PartOpenXR"
+#define TIMER_PART_RECORD_COMMANDS "PartRecordCommands"
+#define TIMER_PART_RECORD_COMMANDS_MULTIVIEW "PartRecordCommandsMultiview"
+#define TIMER_PART_UI "PartUI"
 
 // Windows headers
 #if defined(_WIN64)
@@ -48,6 +51,7 @@
 #include <atomic>
 #include <mutex>
 #include <queue>
+#include <deque>
 #include <array>
 #include <functional>
 #include <regex>
@@ -57,6 +61,7 @@
 #include <unordered_set>
 #include <initializer_list>
 #include <ranges>
+#include <span>
 //using namespace std;
 
 // headers for used libraries
@@ -321,18 +326,25 @@ double static const PI_quarter = PI / 4.0;
 
 #include "shader/common_cpp_shader.h"
 #include "Threads_independent.h"
+#include "SimdMath.h"
 #include "EngineParticipant.h"
 #include "GlobalDef.h"
+#include "InternTable.h"
 #include "Presentation.h"
 #include "DirectImage.h"
 #include "Files.h"
 #include "GameTime.h"
+#include "Simulation.h"
+#include "MemoryTracker.h"
 #include "Util.h"
+#include "TextureResidency.h"
 #include "Texture.h"
+#include "PipelineCache.h"
 #include "GlobalRendering.h"
 #include "Threads.h"
 #include "ImageConsumer.h"
 #include "Camera.h"
+#include "CameraRecording.h"
 #include "VR.h"
 #include "VulkanResources.h"
 #include "ShaderBase.h"
@@ -343,8 +355,20 @@ double static const PI_quarter = PI / 4.0;
 #include "CubeShader.h"
 #include "BillboardShader.h"
 #include "TerrainShader.h"
+#include "VertexDecode.h"
+#include "VertexCompression.h"
+#include "Animation.h"
 #include "gltf.h"
+#include "ObjectComponents.h"
 #include "Object.h"
+#include "LodSelection.h"
+#include "FrustumCulling.h"
+#include "OcclusionCulling.h"
+#include "TerrainLod.h"
+#include "HeightmapRaycast.h"
+#include "Broadphase.h"
+#include "Scatter.h"
+#include "Pathfinding.h"
 #include "Sound.h"
 #include "ui.h"
 #include "UIShader.h"
@@ -35,6 +35,12 @@
 #define LOD_CATEGORY_SIMPLE_STONE 2
 #define LOD_CATEGORY_INVISIBLE 100 // used to mark objects too far away to render
 
+// GPUMeshInfo.vertexFormat, see VertexCompression.h:
+#define VERTEX_FORMAT_FULL 0 // PBRVertex
+#define VERTEX_FORMAT_PACKED 1 // packed base stream
+#define VERTEX_FORMAT_SKIN_STREAM 2 // packed joints and weights
+#define VERTEX_FORMAT_COLOR_STREAM 4 // packed vertex colors
+
 
 #ifdef __cplusplus
 struct PBRVertex {
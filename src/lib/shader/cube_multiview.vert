@@ -0,0 +1,58 @@
+#version 460
+#extension GL_EXT_multiview : enable
+
+// multiview variant of cube.vert: both eyes in one render pass, UBO of each eye selected by gl_ViewIndex
+
+struct EyeUBO {
+    mat4 model;
+    mat4 view;
+    mat4 proj;
+	float bloat;
+	bool outside;
+};
+
+layout(binding = 0) uniform UniformBufferObject {
+    EyeUBO eye[2];
+} ubos;
+
+layout(location = 0) in vec3 inPosition;
+layout (location=0) out vec3 dir;
+
+const vec3 pos[8] = vec3[8](
+	vec3(-1.0,-1.0, 1.0),
+	vec3( 1.0,-1.0, 1.0),
+	vec3( 1.0, 1.0, 1.0),
+	vec3(-1.0, 1.0, 1.0),
+
+	vec3(-1.0,-1.0,-1.0),
+	vec3( 1.0,-1.0,-1.0),
+	vec3( 1.0, 1.0,-1.0),
+	vec3(-1.0, 1.0,-1.0)
+);
+
+const int indices[36] = int[36](
+	// front
+	0, 2, 1, 2, 0, 3,
+	// right
+	1, 6, 5, 6, 1, 2,
+	// back
+	7, 5, 6, 5, 7, 4,
+	// left
+	4, 3, 0, 3, 4, 7,
+	// bottom
+	4, 1, 5, 1, 4, 0,
+	// top
+	3, 6, 2, 6, 3, 7
+);
+
+void main()
+{
+	EyeUBO ubo = ubos.eye[gl_ViewIndex];
+	int idx = indices[gl_VertexIndex];
+	gl_Position = ubo.proj * ubo.view * vec4(ubo.bloat * pos[idx], 1.0);
+	vec3 updown = pos[idx].xyz;
+	if (ubo.outside) {
+		updown.y *= -1;
+	}
+	dir = updown.xyz;
+}
@@ -0,0 +1,25 @@
+#version 450
+#extension GL_EXT_multiview : enable
+
+// multiview variant of line.vert: both eyes in one render pass, UBO of each eye selected by gl_ViewIndex
+
+struct EyeUBO {
+    mat4 model;
+    mat4 view;
+    mat4 proj;
+};
+
+layout(binding = 0) uniform UniformBufferObject {
+    EyeUBO eye[2];
+} ubos;
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inColor;
+
+layout(location = 0) out vec3 fragColor;
+
+void main() {
+    EyeUBO ubo = ubos.eye[gl_ViewIndex];
+    gl_Position = ubo.proj * ubo.view * ubo.model * vec4(inPosition, 1.0);
+    fragColor = inColor;
+}
@@ -5,6 +5,9 @@
 #extension GL_EXT_buffer_reference : require
 #extension GL_EXT_buffer_reference_uvec2 : require
 #extension GL_EXT_shader_explicit_arithmetic_types_int64 : require
+#if defined(MULTIVIEW)
+#extension GL_EXT_multiview : require
+#endif
 #extension GL_EXT_nonuniform_qualifier : require
 
 
@@ -5,6 +5,9 @@
 #extension GL_EXT_buffer_reference : require
 #extension GL_EXT_buffer_reference_uvec2 : require
 #extension GL_EXT_shader_explicit_arithmetic_types_int64 : require
+#if defined(MULTIVIEW)
+#extension GL_EXT_multiview : require
+#endif
 
 layout (location = 0) in vec3 inPos;
 layout (location = 1) in vec3 inNormal;
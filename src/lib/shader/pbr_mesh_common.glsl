@@ -12,7 +12,11 @@ struct GPUMeshInfo {
 	uint64_t globalIndexOffset; // offset into global mesh storage buffer
 	uint64_t vertexOffset; // offset into global mesh storage buffer
     uint meshletCount; // number of meshlets for this LOD
-    uint pad0;
+    uint vertexFormat; // VERTEX_FORMAT_ flags, see common_cpp_shader.h
+    uint64_t skinOffset; // packed format only: offset of skin stream
+    uint64_t colorOffset; // packed format only: offset of color stream
+    float quantMin[3]; // packed format only: position = quantMin + quantized * quantScale
+    float quantScale[3];
 };
 
 
@@ -97,6 +101,8 @@ const uint MODEL_RENDER_FLAG_NONE              = 0u;
 const uint MODEL_RENDER_FLAG_USE_VERTEX_COLORS = 1u << 0; // 1
 const uint MODEL_RENDER_FLAG_DISABLE           = 1u << 1; // 2
 const uint MODEL_RENDER_FLAG_GPU_LOD           = 1u << 2; // 4, enable GPU LOD object manipulation
+const uint MODEL_RENDER_FLAG_CULLED_LEFT       = 1u << 3; // 8, outside left eye (or mono) frustum, see FrustumCulling.h
+const uint MODEL_RENDER_FLAG_CULLED_RIGHT      = 1u << 4; // 16, outside right eye frustum
 // info for this model instance
 // see 	struct PBRTextureIndexes and struct DynamicModelUBO in pbrShader.h
 // one element of the large object material buffer (descriptor updated for each model group before rendering)
@@ -116,23 +122,57 @@ layout (binding = 1) uniform UboInstance {
     uint meshNumber;
 } model_ubo;
 
+#if defined(MULTIVIEW)
+// multiview variants (compiled with -DMULTIVIEW, see SHADER_VARIANTS in src/app/CMakeLists.txt) render both eyes
+// in one render pass: the buffer holds the UBO of both eyes and gl_ViewIndex selects the eye
+struct EyeUBO {
+    mat4 model;
+    mat4 view;
+    mat4 proj;
+    vec4 baseColor;
+	uint frameNum;
+	uint eye;
+	uint pad1;
+	uint pad2;
+    vec3 camPos;
+};
+
+layout(binding = 0) uniform UniformBufferObject {
+    EyeUBO eyes[2];
+} ubos;
+#define ubo ubos.eyes[gl_ViewIndex]
+#else
 layout(binding = 0) uniform UniformBufferObject {
     mat4 model;
     mat4 view;
     mat4 proj;
     vec4 baseColor;
 	uint frameNum;      // new: current frame number
-	uint pad0;          // pad to 16-byte multiple if desired (optional)
+	uint eye;           // 0 == left eye or mono, 1 == right eye
 	uint pad1;          // pad to 16-byte multiple if desired (optional)
 	uint pad2;          // pad to 16-byte multiple if desired (optional)
     vec3 camPos;
 } ubo;
+#endif
 
 
 layout(buffer_reference, std430) buffer VertexBuffer {
     PBRVertex vertex[];
 };
 
+// packed vertex streams, see VertexCompression.h
+layout(buffer_reference, std430) buffer PackedVertexBaseBuffer {
+    uvec4 vertex[];
+};
+
+layout(buffer_reference, std430) buffer PackedVertexSkinBuffer {
+    uvec2 vertex[];
+};
+
+layout(buffer_reference, std430) buffer PackedVertexColorBuffer {
+    uint vertex[];
+};
+
 layout(buffer_reference, std430) buffer MeshletDescs {
     uvec4 packedMeshlets[];
 };
@@ -174,6 +214,40 @@ struct TaskPayload {
 
 // utility functions
 
+// octahedral normal decoding, same as VertexCompression::octDecode()
+vec3 octDecode(vec2 e) {
+    vec3 n = vec3(e.x, e.y, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+
+// decode packed vertex, same as VertexCompression::decode()
+PBRVertex unpackVertex(GPUMeshInfo info, uint64_t baseAddress, uint index) {
+    PBRVertex v;
+    uvec4 b = PackedVertexBaseBuffer(baseAddress + info.vertexOffset).vertex[index];
+    vec3 q = vec3(float(b.x & 0xFFFFu), float(b.x >> 16), float(b.y & 0xFFFFu));
+    v.position = vec3(info.quantMin[0], info.quantMin[1], info.quantMin[2]) + q * vec3(info.quantScale[0], info.quantScale[1], info.quantScale[2]);
+    v.pad0 = 0.0;
+    v.normal = octDecode(unpackSnorm4x8(b.y).zw);
+    v.pad1 = 0.0;
+    v.uv0 = unpackHalf2x16(b.z);
+    v.uv1 = unpackHalf2x16(b.w);
+    v.joint0 = uvec4(0);
+    v.weight0 = vec4(0.0);
+    v.color0 = vec4(1.0);
+    if ((info.vertexFormat & VERTEX_FORMAT_SKIN_STREAM) != 0) {
+        uvec2 s = PackedVertexSkinBuffer(baseAddress + info.skinOffset).vertex[index];
+        v.joint0 = uvec4(s.x & 0xFFu, (s.x >> 8) & 0xFFu, (s.x >> 16) & 0xFFu, s.x >> 24);
+        v.weight0 = unpackUnorm4x8(s.y);
+    }
+    if ((info.vertexFormat & VERTEX_FORMAT_COLOR_STREAM) != 0) {
+        v.color0 = unpackUnorm4x8(PackedVertexColorBuffer(baseAddress + info.colorOffset).vertex[index]);
+    }
+    return v;
+}
+
 // check if object AABB is completely outside view frustrum
 bool isOutsideView(BoundingBox bb, mat4 mvp) {
     vec3 aabbMin = bb.min;
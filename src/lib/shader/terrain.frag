@@ -0,0 +1,16 @@
+#version 450
+
+layout(location = 0) in vec3 inNormal;
+layout(location = 1) in float inHeight;
+
+layout(location = 0) out vec4 outColor;
+
+const vec3 lightDir = normalize(vec3(0.4, 1.0, 0.3));
+
+void main() {
+    // simple height bands: grass, rock, snow
+    vec3 color = mix(vec3(0.25, 0.4, 0.15), vec3(0.45, 0.4, 0.35), smoothstep(60.0, 160.0, inHeight));
+    color = mix(color, vec3(0.9), smoothstep(220.0, 280.0, inHeight));
+    float diffuse = max(dot(normalize(inNormal), lightDir), 0.0);
+    outColor = vec4(color * (0.3 + 0.7 * diffuse), 1.0);
+}
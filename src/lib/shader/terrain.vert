@@ -0,0 +1,48 @@
+#version 460
+#extension GL_EXT_buffer_reference : require
+#extension GL_EXT_shader_explicit_arithmetic_types_int64 : require
+
+layout(binding = 0) uniform UniformBufferObject {
+    mat4 model;
+    mat4 view;
+    mat4 proj;
+} ubo;
+
+// sync with TerrainChunkVertex in TerrainLod.h
+struct TerrainChunkVertex {
+    vec3 pos;
+    float morphTargetY;
+    vec3 normal;
+    float pad;
+    vec2 morphDelta;
+    vec2 uv;
+};
+
+layout(buffer_reference, std430) readonly buffer ChunkVertexBuffer {
+    TerrainChunkVertex vertex[];
+};
+
+// sync with TerrainPushConstants in TerrainShader.h
+layout(push_constant) uniform TerrainPushConstants {
+    uint64_t chunkAddress; // chunk slot in global mesh storage buffer
+    float morphStart;
+    float morphEnd;
+    vec3 cameraPos;
+    float pad;
+} push;
+
+layout(location = 0) out vec3 outNormal;
+layout(location = 1) out float outHeight;
+
+void main() {
+    TerrainChunkVertex v = ChunkVertexBuffer(push.chunkAddress).vertex[gl_VertexIndex];
+    // same as TerrainLod::morphFactor() and TerrainLod::morph()
+    float k = 0.0;
+    if (push.morphEnd > push.morphStart) {
+        k = clamp((length(v.pos - push.cameraPos) - push.morphStart) / (push.morphEnd - push.morphStart), 0.0, 1.0);
+    }
+    vec3 pos = vec3(v.pos.x + v.morphDelta.x * k, v.pos.y + (v.morphTargetY - v.pos.y) * k, v.pos.z + v.morphDelta.y * k);
+    gl_Position = ubo.proj * ubo.view * ubo.model * vec4(pos, 1.0);
+    outNormal = v.normal;
+    outHeight = pos.y;
+}
@@ -1,4 +1,5 @@
 #include "mainheader.h"
+#include "imgui/imgui_internal.h"
 
 using namespace std;
 
@@ -97,7 +98,7 @@ void UI::init(ShadedPathEngine* engine)
     init_info.Device = engine->globalRendering.device;
     init_info.QueueFamily = engine->globalRendering.familyIndices.graphicsFamily.value();
     init_info.Queue = engine->globalRendering.graphicsQueue;
-    init_info.PipelineCache = VK_NULL_HANDLE;
+    init_info.PipelineCache = engine->globalRendering.pipelineCache.get();
     init_info.DescriptorPool = g_DescriptorPool;
     init_info.Allocator = nullptr;
     init_info.MinImageCount = winfo->imageCount - 1;
@@ -113,11 +114,67 @@ void UI::init(ShadedPathEngine* engine)
     //engine->globalRendering.endSingleTimeCommands(command_buffer);
 }
 
+bool UIFrameCache::needsRebuild(double now, size_t stateHash)
+{
+    ImGuiContext& g = *ImGui::GetCurrentContext();
+    bool input = g.InputEventsQueue.Size > 0 || g.IO.WantCaptureMouse || g.IO.WantTextInput;
+    bool changed = !valid || stateHash != lastHash;
+    bool due = !valid || now - lastRebuild >= updateInterval;
+    bool settle = settleFrames > 0;
+    if (valid && !input && !settle && !(changed && due)) {
+        reuses++;
+        return false;
+    }
+    settleFrames = (input || (changed && due)) ? 1 : 0;
+    valid = true;
+    lastHash = stateHash;
+    lastRebuild = now;
+    rebuilds++;
+    return true;
+}
+
+size_t UI::computeStateHash()
+{
+    size_t seed = 0;
+    auto add = [&seed](float v) { hash_combine(seed, std::hash<float>{}(v)); };
+    WindowInfo* winfo = engine->presentation.windowInfo;
+    hash_combine(seed, renderFlags);
+    hash_combine(seed, winfo->width);
+    hash_combine(seed, winfo->height);
+    if (hasRenderFlag(UIRenderFlags::UIRender_FPS)) {
+        hash_combine(seed, std::hash<string>{}(engine->fpsCounter.getFPSAsString()));
+    }
+    // mouse position is part of ImGui input state
+    if (hasRenderFlag(UIRenderFlags::UIRender_CameraPosDir) && cameraForTracking) {
+        auto p = cameraForTracking->getPosition();
+        auto l = cameraForTracking->getLookAt();
+        add(p.x); add(p.y); add(p.z);
+        add(l.x); add(l.y); add(l.z);
+    }
+    if (hasRenderFlag(UIRenderFlags::UIRender_Memory)) {
+        for (size_t d = 0; d < MemoryTracker::DOMAIN_COUNT; d++) {
+            MemoryDomain domain = static_cast<MemoryDomain>(d);
+            for (size_t t = 0; t < MemoryTracker::TAG_COUNT; t++) {
+                MemoryTagStats s = engine->memoryTracker.getStats(static_cast<MemoryTag>(t), domain);
+                // same resolution as displayed
+                hash_combine(seed, s.currentBytes / (100 * 1024));
+                hash_combine(seed, s.peakBytes / (100 * 1024));
+            }
+        }
+    }
+    hash_combine(seed, engine->app->getCustomUIStateHash());
+    return seed;
+}
+
 void UI::update()
 {
-    if (!enabled)
+    if (!isVisible())
         return;
     unique_lock<mutex> lock(monitorMutex);
+    if (!frameCache.needsRebuild(glfwGetTime(), computeStateHash())) {
+        // draw data of last frame is still valid
+        return;
+    }
     beginFrame();
     //ImGui::ShowDemoWindow();
     buildUI();
@@ -211,6 +268,21 @@ void UI::buildUI()
                     Error("cameraForTracking not set in UI class");
                 }
             }
+            if (hasRenderFlag(UIRenderFlags::UIRender_Memory)) {
+                ImGui::Separator();
+                for (size_t d = 0; d < MemoryTracker::DOMAIN_COUNT; d++) {
+                    MemoryDomain domain = static_cast<MemoryDomain>(d);
+                    const float mb = 1024.0f * 1024.0f;
+                    ImGui::Text("%s memory: %.1f MB (peak %.1f MB)", MemoryTracker::getDomainName(domain),
+                        engine->memoryTracker.getTotal(domain) / mb, engine->memoryTracker.getPeakTotal(domain) / mb);
+                    for (size_t t = 0; t < MemoryTracker::TAG_COUNT; t++) {
+                        MemoryTag tag = static_cast<MemoryTag>(t);
+                        MemoryTagStats s = engine->memoryTracker.getStats(tag, domain);
+                        if (s.totalAllocations == 0) continue;
+                        ImGui::Text("  %s: %.1f MB (peak %.1f MB)", MemoryTracker::getTagName(tag), s.currentBytes / mb, s.peakBytes / mb);
+                    }
+                }
+            }
             engine->app->buildCustomUI();
             if (ImGui::BeginPopupContextWindow())
             {
@@ -234,6 +306,7 @@ UI::~UI()
 {
     if (!enabled)
         return;
+    Log("UI frames rebuilt: " << frameCache.getRebuildCount() << " reused: " << frameCache.getReuseCount() << endl);
     ImGui_ImplVulkan_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
@@ -7,6 +7,46 @@ enum UIRenderFlags {
 	UIRender_FPS = 0x01,
 	UIRender_CameraPosDir = 0x02,
 	UIRender_MouseTracking = 0x04,
+	UIRender_Memory = 0x08,
+};
+
+// Change detection for the Dear ImGui frame: a new frame is only built if input events are pending,
+// the mouse is over a UI window or the displayed values changed (state hash).
+// Otherwise the draw data of the last ImGui::Render() is drawn again.
+// Value changes are limited to the update interval, input is handled immediately.
+// Only needs an ImGui context, no platform or renderer backend
+class UIFrameCache
+{
+public:
+	// minimum seconds between rebuilds for changed values, 0: rebuild every frame with changes
+	void setUpdateInterval(double seconds) {
+		updateInterval = seconds;
+	}
+	double getUpdateInterval() const {
+		return updateInterval;
+	}
+	// true if the ImGui frame has to be built again, counts rebuilt and reused frames.
+	// now: time in seconds, stateHash: hash of all displayed values
+	bool needsRebuild(double now, size_t stateHash);
+	// force rebuild of next frame
+	void invalidate() {
+		valid = false;
+	}
+	uint64_t getRebuildCount() const {
+		return rebuilds;
+	}
+	uint64_t getReuseCount() const {
+		return reuses;
+	}
+private:
+	bool valid = false;
+	size_t lastHash = 0;
+	double lastRebuild = 0.0;
+	double updateInterval = 0.0;
+	// ImGui needs one more frame after changes, e.g. for auto resized windows
+	int settleFrames = 0;
+	uint64_t rebuilds = 0;
+	uint64_t reuses = 0;
 };
 
 // UI class abtraction for Dear ImGui
@@ -30,6 +70,19 @@ public:
 	void setRenderFlags(unsigned int flags) {
 		renderFlags = flags;
 	}
+	// rebuild UI at most this many times per second if only displayed values change (e.g. camera position),
+	// input is always handled immediately. 0: no limit
+	void setUpdateRate(double updatesPerSecond) {
+		frameCache.setUpdateInterval(updatesPerSecond > 0.0 ? 1.0 / updatesPerSecond : 0.0);
+	}
+	// hidden UI is neither built nor rendered
+	void setVisible(bool visible) {
+		this->visible = visible;
+		frameCache.invalidate();
+	}
+	bool isVisible() {
+		return enabled && visible;
+	}
 	bool hasRenderFlag(UIRenderFlags flag) const {
 		return (renderFlags & flag) != 0;
 	}
@@ -47,7 +100,11 @@ private:
 	void beginFrame();
 	void buildUI();
 	void endFrame();
+	// hash of all values displayed by buildUI()
+	size_t computeStateHash();
 	std::atomic<bool> enabled = false;
+	std::atomic<bool> visible = true;
+	UIFrameCache frameCache;
 	ShadedPathEngine* engine = nullptr;
 	VkDescriptorPool g_DescriptorPool = VK_NULL_HANDLE;
 	mutable std::mutex monitorMutex;
@@ -353,6 +353,25 @@ TEST_F(EngineTest, Alignment) {
     Log("Test end. (Should appear after destructor log)\n");
 }
 
+// camera playback drives game time with recorded deltas, real time delta is still measured
+TEST(Timer, GameTimeFixedDelta) {
+    GameTime gameTime;
+    gameTime.init(GameTime::GAMEDAY_REALTIME);
+    auto t = chrono::steady_clock::now();
+    gameTime.advanceTime(t);
+    double start = gameTime.getTimeSeconds();
+    gameTime.setFixedDelta(0.5);
+    gameTime.advanceTime(t + chrono::seconds(2));
+    EXPECT_NEAR(0.5, gameTime.getTimeDelta(), 1e-9);
+    EXPECT_NEAR(2.0, gameTime.getRealTimeDelta(), 1e-9);
+    EXPECT_NEAR(start + 0.5, gameTime.getTimeSeconds(), 1e-6);
+    // back to the clock: game time continues from where the fixed steps left it
+    gameTime.setFixedDelta(0.0);
+    gameTime.advanceTime(t + chrono::seconds(3));
+    EXPECT_NEAR(1.0, gameTime.getTimeDelta(), 1e-9);
+    EXPECT_NEAR(start + 1.5, gameTime.getTimeSeconds(), 1e-6);
+}
+
 TEST(Timer, Average) {
     ThemedTimer::getInstance()->create("AVG", 10);
     auto td = ThemedTimer::getInstance()->test_add("AVG", 3);
@@ -962,6 +981,15 @@ TEST_F(MeshStoreTestDynamic, LoadMultiPrimitiveMesh) {
 
         WorldObject* object = engine->objectStore.addObject("group", "Sample", vec3(-0.2f, 0.2f, 0.2f));
         EXPECT_TRUE(object != nullptr);
+        // culling bounds of the object include all primitives
+        auto& components = engine->objectStore.getComponents();
+        const ObjectBounds& bounds = components.localBounds()[components.indexOf(object->handle)];
+        engine->objectStore.forEachAdditionalPrimitiveMesh(object, [&](MeshInfo* prim) {
+            BoundingBox primBox;
+            prim->getBoundingBox(primBox);
+            EXPECT_TRUE(glm::all(glm::lessThanEqual(bounds.min, primBox.min)));
+            EXPECT_TRUE(glm::all(glm::greaterThanEqual(bounds.max, primBox.max)));
+        });
         MeshCollection* coll = engine->meshStore.getMeshCollection(object->mesh);
         coll->logLodMeshes();
         bool lodCompatible = engine->meshStore.isGPULodCompatible(object);
@@ -983,6 +1011,2777 @@ TEST_F(MeshStoreTestDynamic, LoadMultiPrimitiveMesh) {
     }
 }
 
+// synthetic scene: rows of identical objects moving away from camera along z
+TEST(LodSelection, SyntheticScene) {
+    const uint32_t tris[5] = { 10000, 5000, 2500, 1200, 600 };
+    const int numObjects = 10003; // not a multiple of SIMD width
+    auto fillScene = [&](LodSelection& sel) {
+        for (int i = 0; i < numObjects; i++) {
+            sel.addObject(vec3((float)(i % 7), 0.0f, 1.0f + (float)i * 0.5f), 1.0f, 5, tris);
+        }
+        sel.setCullSize(0.5f);
+    };
+    LodSelection simd, scalar;
+    fillScene(simd);
+    fillScene(scalar);
+    ThreadGroup threads(4);
+    simd.select(vec3(0.0f), &threads);
+    scalar.select(vec3(0.0f), nullptr, false);
+    // SIMD and scalar reference have to agree, LOD must not decrease with distance
+    int last = 0;
+    for (size_t i = 0; i < simd.size(); i++) {
+        EXPECT_EQ(scalar.getLod(i), simd.getLod(i));
+        int lod = simd.getLod(i) == LodSelection::LOD_INVISIBLE ? LodSelection::MAX_LOD : simd.getLod(i);
+        if (i % 7 == 0) {
+            EXPECT_GE(lod, last);
+            last = lod;
+        }
+    }
+    EXPECT_EQ(0, simd.getLod(0));
+    EXPECT_EQ(LodSelection::LOD_INVISIBLE, simd.getLod(numObjects - 1));
+    auto& stats = simd.getStats();
+    uint32_t counted = stats.invisibleObjects;
+    for (auto c : stats.objectsPerLod) counted += c;
+    EXPECT_EQ((uint32_t)numObjects, counted);
+    EXPECT_EQ(stats.totalTriangles, scalar.getStats().totalTriangles);
+
+    // hysteresis: small camera movement around a LOD boundary must not change selection
+    LodSelection hyst;
+    hyst.addObject(vec3(0.0f), 1.0f, 5, tris);
+    hyst.setHysteresis(0.2f);
+    // find distance where LOD switches from 0 to 1
+    float switchDist = 0.0f;
+    for (float d = 1.0f; d < 100.0f; d += 0.01f) {
+        hyst.select(vec3(0.0f, 0.0f, d));
+        if (hyst.getLod(0) == 1) {
+            switchDist = d;
+            break;
+        }
+    }
+    ASSERT_GT(switchDist, 0.0f);
+    for (int i = 0; i < 20; i++) {
+        float jitter = (i % 2 == 0) ? -0.05f : 0.05f;
+        hyst.select(vec3(0.0f, 0.0f, switchDist * (1.0f + jitter)));
+        EXPECT_EQ(1, hyst.getLod(0));
+    }
+    // moving clearly closer switches back
+    hyst.select(vec3(0.0f, 0.0f, switchDist * 0.5f));
+    EXPECT_EQ(0, hyst.getLod(0));
+
+    // triangle budget: thresholds adapt until budget is met
+    uint64_t unlimited = simd.getStats().totalTriangles;
+    uint64_t budget = unlimited / 4;
+    simd.setTriangleBudget(budget);
+    for (int frame = 0; frame < 60; frame++) {
+        simd.select(vec3(0.0f), &threads);
+    }
+    EXPECT_LE(simd.getStats().totalTriangles, budget);
+    EXPECT_GT(simd.getThresholdScale(), 1.0f);
+    simd.getStats().log();
+}
+
+// distance table converted to screen thresholds (see MeshManager::selectSimulatedLOD) selects the same LOD as Util::calculateLODIndex
+TEST(LodSelection, MatchesDistanceTable) {
+    const float lod[10] = { 0.0f, 1.0f, 5.0f, 10.0f, 15.0f, 25.0f, 30.0f, 50.0f, 70.0f, 150.0f };
+    const float radius = 0.866f;
+    const float fovy = glm::radians(45.0f);
+    const float viewportHeight = 1080.0f;
+    const uint32_t tris[10] = {};
+    LodSelection sel;
+    sel.addObject(vec3(0.0f), radius, 10, tris);
+    sel.setHysteresis(0.0f);
+    sel.setViewport(fovy, viewportHeight);
+    float pixelFactor = viewportHeight / (2.0f * tan(fovy / 2.0f));
+    vector<float> thresholds;
+    for (int i = 1; i < 10; i++) {
+        thresholds.push_back(radius * pixelFactor / lod[i]);
+    }
+    sel.setScreenThresholds(thresholds);
+    // stay clear of the exact switch distances, rounding may go either way there
+    for (float d = 0.1f; d < 200.0f; d *= 1.013f) {
+        sel.select(vec3(0.0f, 0.0f, d));
+        EXPECT_EQ(Util::calculateLODIndex(lod, d), sel.getLod(0)) << "distance " << d;
+    }
+}
+
+TEST(VertexDecode, TypedAccessors) {
+    // normalized u8 UVs, 2 components
+    uint8_t uvData[] = { 0, 255, 51, 102 };
+    AccessorView uvView;
+    uvView.data = uvData;
+    uvView.count = 2;
+    uvView.componentType = AccessorComponentType::UnsignedByte;
+    uvView.numComponents = 2;
+    uvView.normalized = true;
+    float uv[4];
+    VertexDecode::decodeFloats(uvView, 0, 2, uv, 2);
+    EXPECT_FLOAT_EQ(0.0f, uv[0]);
+    EXPECT_FLOAT_EQ(1.0f, uv[1]);
+    EXPECT_FLOAT_EQ(0.2f, uv[2]);
+    EXPECT_FLOAT_EQ(0.4f, uv[3]);
+
+    // normalized i16 is clamped to -1
+    int16_t nData[] = { -32768, 32767, 0 };
+    AccessorView nView;
+    nView.data = reinterpret_cast<const uint8_t*>(nData);
+    nView.count = 1;
+    nView.componentType = AccessorComponentType::Short;
+    nView.numComponents = 3;
+    nView.normalized = true;
+    float n[4];
+    VertexDecode::decodeFloats(nView, 0, 1, n, 4, 7.0f);
+    EXPECT_FLOAT_EQ(-1.0f, n[0]);
+    EXPECT_FLOAT_EQ(1.0f, n[1]);
+    EXPECT_FLOAT_EQ(0.0f, n[2]);
+    EXPECT_FLOAT_EQ(7.0f, n[3]); // fill value for missing component
+
+    // interleaved float positions (pos + 1 float padding) and u16 normalized vec3 colors,
+    // more vertices than one batch, odd count
+    const size_t count = VertexDecode::BATCH_SIZE + 45;
+    vector<float> interleaved(count * 4);
+    vector<uint16_t> colors(count * 3);
+    for (size_t i = 0; i < count; i++) {
+        interleaved[i * 4 + 0] = (float)i;
+        interleaved[i * 4 + 1] = (float)i * 2.0f;
+        interleaved[i * 4 + 2] = -(float)i;
+        interleaved[i * 4 + 3] = 99.0f;
+        colors[i * 3 + 0] = 65535;
+        colors[i * 3 + 1] = 0;
+        colors[i * 3 + 2] = 65535;
+    }
+    vector<float> uvs(count * 2);
+    for (size_t i = 0; i < count * 2; i++) uvs[i] = (float)(i % 17) * 0.1f;
+    PrimitiveDecodeInput in;
+    in.position.data = reinterpret_cast<const uint8_t*>(interleaved.data());
+    in.position.count = count;
+    in.position.numComponents = 3;
+    in.position.byteStride = 4 * sizeof(float);
+    in.color.data = reinterpret_cast<const uint8_t*>(colors.data());
+    in.color.count = count;
+    in.color.componentType = AccessorComponentType::UnsignedShort;
+    in.color.numComponents = 3;
+    in.color.normalized = true;
+    in.uv0.data = reinterpret_cast<const uint8_t*>(uvs.data());
+    in.uv0.count = count;
+    in.uv0.numComponents = 2;
+    in.uvTransform[0] = UVTransform::fromKHR(vec2(0.5f, 0.25f), vec2(2.0f, 3.0f), (float)PI_half);
+    // sparse: replace positions 1 and 200 with u8 indices
+    uint8_t sparseIndices[] = { 1, 200 };
+    float sparseValues[] = { 10.0f, 11.0f, 12.0f, 20.0f, 21.0f, 22.0f };
+    in.position.sparseCount = 2;
+    in.position.sparseIndices = sparseIndices;
+    in.position.sparseIndexType = AccessorComponentType::UnsignedByte;
+    in.position.sparseValues = reinterpret_cast<const uint8_t*>(sparseValues);
+    vector<PBRShader::Vertex> verts;
+    VertexDecode::decodePrimitive(in, verts);
+    ASSERT_EQ(count, verts.size());
+    EXPECT_EQ(vec3(2.0f, 4.0f, -2.0f), verts[2].pos);
+    EXPECT_EQ(vec3(10.0f, 11.0f, 12.0f), verts[1].pos);
+    EXPECT_EQ(vec3(20.0f, 21.0f, 22.0f), verts[200].pos);
+    EXPECT_EQ(vec3(count - 1.0f, (count - 1) * 2.0f, -(count - 1.0f)), verts[count - 1].pos);
+    EXPECT_EQ(vec4(1.0f, 0.0f, 1.0f, 1.0f), verts[count - 1].color);
+    for (size_t i = 0; i < count; i++) {
+        vec2 expected = in.uvTransform[0].apply(vec2(uvs[i * 2], uvs[i * 2 + 1]));
+        // KHR order: scale, then rotate, then offset
+        vec2 scaled = vec2(uvs[i * 2] * 2.0f, uvs[i * 2 + 1] * 3.0f);
+        vec2 khr = vec2(-scaled.y, scaled.x) + vec2(0.5f, 0.25f);
+        EXPECT_NEAR(expected.x, verts[i].uv0.x, 1e-5f);
+        EXPECT_NEAR(expected.y, verts[i].uv0.y, 1e-5f);
+        EXPECT_NEAR(khr.x, verts[i].uv0.x, 1e-5f);
+        EXPECT_NEAR(khr.y, verts[i].uv0.y, 1e-5f);
+        EXPECT_EQ(vec2(0.0f), verts[i].uv1);
+    }
+
+    // sparse accessor without buffer view starts with zeros
+    AccessorView sparseOnly = in.position;
+    sparseOnly.data = nullptr;
+    sparseOnly.byteStride = 0;
+    vector<float> out(count * 3);
+    VertexDecode::decodeFloats(sparseOnly, 0, count, out.data(), 3);
+    EXPECT_FLOAT_EQ(0.0f, out[0]);
+    EXPECT_FLOAT_EQ(10.0f, out[3]);
+    EXPECT_FLOAT_EQ(22.0f, out[200 * 3 + 2]);
+}
+
+// load throughput over all sample .glb files, timing is logged
+TEST_F(MeshStoreTestDynamic, LoadThroughput) {
+    {
+        ShadedPathEngine my_engine;
+        static ShadedPathEngine* engine = &my_engine;
+        minimalEngineInitialization(engine, 1000);
+        engine->files.findAssetFolder("test_samples");
+        vector<filesystem::path> files;
+        for (auto& entry : filesystem::directory_iterator(engine->files.getAssetFolderPath() / "mesh")) {
+            if (entry.path().extension() == ".glb") files.push_back(entry.path());
+        }
+        ASSERT_FALSE(files.empty());
+        const int runs = 5;
+        uintmax_t bytes = 0;
+        size_t vertices = 0;
+        int idCounter = 0;
+        auto start = chrono::high_resolution_clock::now();
+        for (int run = 0; run < runs; run++) {
+            for (auto& f : files) {
+                string id = "Bench" + to_string(idCounter++);
+                string name = f.filename().string();
+                if (name.find("lod") != string::npos) engine->meshStore.loadMeshLod(name, id);
+                else engine->meshStore.loadMesh(name, id);
+                bytes += filesystem::file_size(f);
+                for (auto* mi : *engine->meshStore.getMeshCollection(id)) {
+                    vertices += mi->vertices.size();
+                }
+            }
+        }
+        auto end = chrono::high_resolution_clock::now();
+        double seconds = chrono::duration<double>(end - start).count();
+        EXPECT_GT(vertices, 0);
+        Log("glTF load throughput: " << files.size() << " files x " << runs << " runs in " << seconds << " s, "
+            << (bytes / (1024.0 * 1024.0)) / seconds << " MB/s, " << vertices / seconds << " vertices/s" << endl);
+    }
+}
+
+// packed vertex format: encode / decode has to stay within documented error bounds
+TEST(VertexCompression, ErrorBounds) {
+    srand(42);
+    vector<PBRShader::Vertex> verts;
+    const vec3 bbMin(-3.0f, 0.0f, -250.0f);
+    const vec3 bbMax(5.0f, 0.5f, 250.0f);
+    for (int i = 0; i < 5000; i++) {
+        vec3 pos(MathHelper::RandF(bbMin.x, bbMax.x), MathHelper::RandF(bbMin.y, bbMax.y), MathHelper::RandF(bbMin.z, bbMax.z));
+        vec3 normal(MathHelper::RandF(-1.0f, 1.0f), MathHelper::RandF(-1.0f, 1.0f), MathHelper::RandF(-1.0f, 1.0f));
+        if (length(normal) < 0.01f) normal = vec3(0.0f, 1.0f, 0.0f);
+        vec2 uv0(MathHelper::RandF(0.0f, 1.0f), MathHelper::RandF(-8.0f, 8.0f));
+        vec2 uv1(MathHelper::RandF(0.0f, 2.0f), MathHelper::RandF(0.0f, 2.0f));
+        verts.push_back(PBRShader::Vertex(pos, normalize(normal), uv0, uv1));
+    }
+    // axis aligned normals are exact
+    verts.push_back(PBRShader::Vertex(bbMin, vec3(0.0f, 0.0f, -1.0f), vec2(0.0f)));
+    verts.push_back(PBRShader::Vertex(bbMax, vec3(1.0f, 0.0f, 0.0f), vec2(1.0f)));
+    ASSERT_TRUE(VertexCompression::canPack(verts));
+
+    PackedVertexStreams packed;
+    VertexCompression::encode(verts, packed);
+    // static mesh without vertex colors: base stream only
+    EXPECT_EQ(VERTEX_FORMAT_PACKED, packed.format);
+    EXPECT_EQ(verts.size() * 16, packed.byteSize());
+    vec3 posBound = (bbMax - bbMin) / 131070.0f + vec3(1e-4f);
+    float cosBound = cos(radians(1.0f));
+    float maxAngle = 0.0f;
+    for (size_t i = 0; i < verts.size(); i++) {
+        PBRShader::Vertex d = VertexCompression::decode(packed, i);
+        const PBRShader::Vertex& v = verts[i];
+        EXPECT_NEAR(v.pos.x, d.pos.x, posBound.x);
+        EXPECT_NEAR(v.pos.y, d.pos.y, posBound.y);
+        EXPECT_NEAR(v.pos.z, d.pos.z, posBound.z);
+        float c = dot(v.normal, d.normal);
+        EXPECT_GE(c, cosBound);
+        maxAngle = std::max(maxAngle, degrees(acos(std::min(c, 1.0f))));
+        // half floats: relative 2^-11, absolute 2^-24 near zero (subnormals)
+        for (int c = 0; c < 2; c++) {
+            EXPECT_LE(abs(v.uv0[c] - d.uv0[c]), abs(v.uv0[c]) * exp2(-11.0f) + exp2(-24.0f));
+            EXPECT_LE(abs(v.uv1[c] - d.uv1[c]), abs(v.uv1[c]) * exp2(-11.0f) + exp2(-24.0f));
+        }
+        EXPECT_EQ(vec4(1.0f), d.color);
+    }
+    EXPECT_EQ(vec3(0.0f, 0.0f, -1.0f), VertexCompression::decode(packed, verts.size() - 2).normal);
+    EXPECT_EQ(vec3(1.0f, 0.0f, 0.0f), VertexCompression::decode(packed, verts.size() - 1).normal);
+    Log("packed vertices: " << packed.byteSize() << " bytes instead of " << verts.size() * sizeof(PBRShader::Vertex)
+        << ", max normal error " << maxAngle << " degrees" << endl);
+
+    // skinned and colored vertices get optional streams, weights are renormalized
+    vector<PBRShader::Vertex> skinned;
+    skinned.push_back(PBRShader::Vertex(vec3(0.0f), vec3(0.0f, 1.0f, 0.0f), vec2(0.0f), vec2(0.0f), uvec4(1, 2, 200, 255), vec4(0.5f, 0.25f, 0.125f, 0.125f), vec4(1.0f, 0.5f, 0.0f, 1.0f)));
+    skinned.push_back(PBRShader::Vertex(vec3(1.0f), vec3(0.0f, 1.0f, 0.0f), vec2(0.0f), vec2(0.0f), uvec4(7, 0, 0, 0), vec4(1.0f / 3.0f, 1.0f / 3.0f, 1.0f / 3.0f, 0.0f), vec4(0.2f)));
+    ASSERT_TRUE(VertexCompression::canPack(skinned));
+    VertexCompression::encode(skinned, packed);
+    EXPECT_EQ(VERTEX_FORMAT_PACKED | VERTEX_FORMAT_SKIN_STREAM | VERTEX_FORMAT_COLOR_STREAM, packed.format);
+    EXPECT_EQ(skinned.size() * (16 + 8 + 4), packed.byteSize());
+    for (size_t i = 0; i < skinned.size(); i++) {
+        PBRShader::Vertex d = VertexCompression::decode(packed, i);
+        EXPECT_EQ(skinned[i].joint0, d.joint0);
+        float sum = 0.0f;
+        for (int c = 0; c < 4; c++) {
+            EXPECT_NEAR(skinned[i].weight0[c], d.weight0[c], 1.0f / 255.0f);
+            EXPECT_NEAR(skinned[i].color[c], d.color[c], 0.5f / 255.0f + 1e-6f);
+            sum += d.weight0[c];
+        }
+        EXPECT_NEAR(1.0f, sum, 1e-5f);
+    }
+
+    // out of range values are rejected
+    skinned[0].joint0.x = 256;
+    EXPECT_FALSE(VertexCompression::canPack(skinned));
+    verts[0].uv0.x = 9.0f;
+    EXPECT_FALSE(VertexCompression::canPack(verts));
+}
+
+// glTF meshes loaded with MESH_TYPE_PACKED_VERTICES: every LOD / primitive round trips within the documented bounds of its own AABB
+TEST_F(MeshStoreTestDynamic, PackedVerticesRoundTrip) {
+    ShadedPathEngine my_engine;
+    static ShadedPathEngine* engine = &my_engine;
+    minimalEngineInitialization(engine, 50);
+    engine->files.findAssetFolder("test_samples");
+    engine->meshStore.loadMeshLod("test_multi_prim_lod_cmp.glb", "Sample", MeshFlagsCollection(MeshFlags::MESH_TYPE_PACKED_VERTICES));
+    auto mc = engine->meshStore.getMeshCollection("Sample");
+    ASSERT_TRUE(mc->flags.hasFlag(MeshFlags::MESH_TYPE_PACKED_VERTICES));
+    float cosBound = cos(radians(1.0f));
+    int meshCount = 0;
+    for (MeshInfo* mi : *mc) {
+        ASSERT_TRUE(mi->flags.hasFlag(MeshFlags::MESH_TYPE_PACKED_VERTICES));
+        ASSERT_TRUE(VertexCompression::canPack(mi->vertices));
+        BoundingBox box;
+        mi->getBoundingBox(box);
+        vec3 posBound = (box.max - box.min) / 131070.0f + vec3(1e-5f);
+        PackedVertexStreams packed;
+        VertexCompression::encode(mi->vertices, packed);
+        EXPECT_TRUE(packed.format & VERTEX_FORMAT_PACKED);
+        EXPECT_LT(packed.byteSize(), mi->vertices.size() * sizeof(PBRShader::Vertex));
+        for (size_t i = 0; i < mi->vertices.size(); i++) {
+            PBRShader::Vertex d = VertexCompression::decode(packed, i);
+            const PBRShader::Vertex& v = mi->vertices[i];
+            EXPECT_TRUE(glm::all(glm::lessThanEqual(abs(v.pos - d.pos), posBound)));
+            EXPECT_GE(dot(v.normal, d.normal), cosBound);
+            for (int c = 0; c < 2; c++) {
+                EXPECT_LE(abs(v.uv0[c] - d.uv0[c]), abs(v.uv0[c]) * exp2(-11.0f) + exp2(-24.0f));
+            }
+        }
+        meshCount++;
+    }
+    EXPECT_GT(meshCount, 0);
+}
+
+// records resident mips like TextureStore would, without GPU
+class SimulatedResidencyDevice : public TextureResidencyDevice {
+public:
+    std::vector<uint64_t> mipBytes;
+    std::unordered_map<uint32_t, uint32_t> residentMip;
+    uint32_t commits = 0;
+    uint64_t residentBytes() {
+        uint64_t sum = 0;
+        for (auto& r : residentMip) {
+            for (size_t m = r.second; m < mipBytes.size(); m++) sum += mipBytes[m];
+        }
+        return sum;
+    }
+    void setResidentMips(uint32_t textureIndex, uint32_t firstMip) override {
+        residentMip[textureIndex] = firstMip;
+    }
+    void commitResidencyChanges() override {
+        commits++;
+    }
+};
+
+TEST(TextureResidency, SimulatedDevice) {
+    SimulatedResidencyDevice dev;
+    // 1024 x 1024 RGBA8 with 11 mip levels
+    for (uint32_t m = 0; m < 11; m++) {
+        uint64_t size = 1024 >> m;
+        dev.mipBytes.push_back(size * size * 4);
+    }
+    auto bytesFrom = [&](uint32_t mip) {
+        uint64_t sum = 0;
+        for (size_t m = mip; m < dev.mipBytes.size(); m++) sum += dev.mipBytes[m];
+        return sum;
+    };
+    TextureResidency res;
+    for (uint32_t i = 0; i < 4; i++) {
+        uint32_t tail = res.addTexture(i, 1024, 1024, dev.mipBytes);
+        EXPECT_EQ(3, tail); // 128 x 128
+        dev.residentMip[i] = tail;
+    }
+    uint64_t tails = 4 * bytesFrom(3);
+    // room for one full texture and one texture up to mip 1
+    res.setBudget(tails + (bytesFrom(0) - bytesFrom(3)) + (bytesFrom(1) - bytesFrom(3)));
+
+    // two full screen requests, nearer one wins
+    res.requestTexture(0, 1024.0f, 1.0f);
+    res.requestTexture(1, 1024.0f, 2.0f);
+    res.update(dev);
+    EXPECT_EQ(0, res.getResidentMip(0));
+    EXPECT_EQ(1, res.getResidentMip(1));
+    EXPECT_EQ(3, res.getResidentMip(2));
+    EXPECT_EQ(1, res.getStats().starvedTextures);
+    EXPECT_EQ(dev.residentBytes(), res.getStats().residentBytes);
+    EXPECT_LE(res.getStats().residentBytes, res.getStats().budgetBytes);
+    EXPECT_EQ(1, dev.commits);
+
+    // texture 0 not used any more: its finest mip is evicted for texture 1
+    res.requestTexture(1, 1024.0f, 2.0f);
+    res.update(dev);
+    EXPECT_EQ(1, res.getResidentMip(0));
+    EXPECT_EQ(0, res.getResidentMip(1));
+    EXPECT_EQ(0, res.getStats().starvedTextures);
+    EXPECT_EQ(dev.residentBytes(), res.getStats().residentBytes);
+    EXPECT_LE(res.getStats().residentBytes, res.getStats().budgetBytes);
+
+    // upgrades are spread over updates
+    res.setBudget(bytesFrom(0) * 4);
+    res.setMaxChangesPerUpdate(1);
+    for (int frame = 0; frame < 2; frame++) {
+        res.requestTexture(2, 256.0f, 5.0f);
+        res.requestTexture(3, 300.0f, 5.0f);
+        res.update(dev);
+        if (frame == 0) {
+            EXPECT_EQ(1, res.getResidentMip(3)); // larger on screen first, 1024 / 300 texels per pixel
+            EXPECT_EQ(3, res.getResidentMip(2));
+            EXPECT_EQ(1, res.getStats().starvedTextures);
+        }
+    }
+    EXPECT_EQ(2, res.getResidentMip(2));
+    EXPECT_EQ(2, res.getDesiredMip(2));
+    EXPECT_EQ(0, res.getStats().starvedTextures);
+
+    // lowered budget releases everything down to the mip tails
+    res.setBudget(tails);
+    res.update(dev);
+    for (uint32_t i = 0; i < 4; i++) {
+        EXPECT_EQ(3, res.getResidentMip(i));
+        EXPECT_EQ(3, dev.residentMip[i]);
+    }
+    auto& stats = res.getStats();
+    EXPECT_EQ(tails, stats.residentBytes);
+    EXPECT_EQ(4, stats.streamedTextures);
+    EXPECT_EQ(4, stats.satisfiedTextures);
+    EXPECT_EQ(stats.mipUpgrades, stats.mipEvictions); // everything back at tail
+    EXPECT_GT(stats.uploadedBytes, bytesFrom(0));
+
+    res.removeTexture(3);
+    EXPECT_FALSE(res.isStreamed(3));
+    res.update(dev);
+    EXPECT_EQ(3 * bytesFrom(3), res.getStats().residentBytes);
+}
+
+// chain root -> upper -> lower, stored child first to check evaluation order
+static void makeTestSkeleton(AnimationSet& set) {
+    Skeleton& sk = set.skeleton;
+    quat noRot(1.0f, 0.0f, 0.0f, 0.0f);
+    sk.addJoint("lower", 2, vec3(0.0f, 1.0f, 0.0f), noRot, vec3(1.0f), inverse(translate(mat4(1.0f), vec3(0.0f, 2.0f, 0.0f))));
+    sk.addJoint("root", -1, vec3(0.0f), noRot, vec3(1.0f), mat4(1.0f));
+    sk.addJoint("upper", 1, vec3(0.0f, 1.0f, 0.0f), noRot, vec3(1.0f), inverse(translate(mat4(1.0f), vec3(0.0f, 1.0f, 0.0f))));
+    sk.finish();
+    AnimationClip clip;
+    clip.name = "wave";
+    clip.duration = 2.0f;
+    AnimationChannel rot;
+    rot.joint = 1;
+    rot.path = AnimationPath::Rotation;
+    rot.times = { 0.0f, 1.0f, 2.0f };
+    for (float deg : { 0.0f, 90.0f, 180.0f }) {
+        quat q = angleAxis(radians(deg), vec3(0.0f, 1.0f, 0.0f));
+        rot.values.push_back(vec4(q.x, q.y, q.z, q.w));
+    }
+    AnimationChannel step;
+    step.joint = 2;
+    step.path = AnimationPath::Translation;
+    step.interpolation = AnimationInterpolation::Step;
+    step.times = { 0.0f, 1.0f };
+    step.values = { vec4(0.0f, 1.0f, 0.0f, 0.0f), vec4(0.0f, 2.0f, 0.0f, 0.0f) };
+    AnimationChannel cubic;
+    cubic.joint = 0;
+    cubic.path = AnimationPath::Scale;
+    cubic.interpolation = AnimationInterpolation::CubicSpline;
+    cubic.times = { 0.0f, 2.0f };
+    // in-tangent, value, out-tangent
+    cubic.values = { vec4(0.0f), vec4(1.0f, 1.0f, 1.0f, 0.0f), vec4(0.0f), vec4(0.0f), vec4(2.0f, 2.0f, 2.0f, 0.0f), vec4(0.0f) };
+    clip.channels = { rot, step, cubic };
+    set.clips.push_back(clip);
+}
+
+// reference implementation with plain glm and key search for every sample
+static void referencePalette(const AnimationSet& set, float time, vector<mat4>& palette) {
+    const Skeleton& sk = set.skeleton;
+    vector<mat4> global(sk.size());
+    palette.resize(sk.size());
+    vector<vec3> t = sk.restTranslation, s = sk.restScale;
+    vector<quat> r = sk.restRotation;
+    for (auto& ch : set.clips[0].channels) {
+        uint32_t fresh = UINT32_MAX;
+        vec4 v = AnimationRuntime::sampleChannel(ch, time, fresh);
+        if (ch.path == AnimationPath::Translation) t[ch.joint] = vec3(v);
+        else if (ch.path == AnimationPath::Rotation) r[ch.joint] = quat(v.w, v.x, v.y, v.z);
+        else s[ch.joint] = vec3(v);
+    }
+    for (uint32_t j : sk.order) {
+        mat4 local = translate(mat4(1.0f), t[j]) * mat4_cast(r[j]) * scale(mat4(1.0f), s[j]);
+        global[j] = (sk.parent[j] < 0 ? sk.rootTransform[j] : global[sk.parent[j]]) * local;
+        palette[j] = global[j] * sk.inverseBind[j];
+    }
+}
+
+TEST(Animation, JointPalette) {
+    AnimationSet set;
+    makeTestSkeleton(set);
+    EXPECT_EQ(1u, set.skeleton.order[0]);
+    EXPECT_EQ(0u, set.skeleton.order[2]);
+    auto maxDiff = [](const mat4& a, const mat4& b) {
+        float d = 0.0f;
+        for (int c = 0; c < 4; c++) for (int r = 0; r < 4; r++) d = std::max(d, std::abs(a[c][r] - b[c][r]));
+        return d;
+    };
+
+    // rest pose: inverse bind matrices cancel joint transforms
+    AnimationRuntime runtime;
+    uint32_t inst = runtime.addInstance(&set);
+    uint32_t other = runtime.addInstance(&set);
+    runtime.update(0.5f);
+    for (uint32_t j = 0; j < runtime.getJointCount(inst); j++) {
+        EXPECT_LT(maxDiff(mat4(1.0f), runtime.getPalette(inst)[j]), 1e-6f);
+    }
+    EXPECT_FALSE(runtime.setClip(other, "missing"));
+    EXPECT_TRUE(runtime.setClip(inst, "wave"));
+
+    // interpolation modes
+    auto& channels = set.clips[0].channels;
+    uint32_t cursor = 0;
+    vec4 q = AnimationRuntime::sampleChannel(channels[0], 0.5f, cursor);
+    EXPECT_NEAR(std::cos(radians(22.5f)), q.w, 1e-5f);
+    EXPECT_EQ(0.0f, AnimationRuntime::sampleChannel(channels[1], 0.99f, cursor).y - 1.0f);
+    EXPECT_EQ(2.0f, AnimationRuntime::sampleChannel(channels[1], 1.0f, cursor).y);
+    EXPECT_NEAR(1.5f, AnimationRuntime::sampleChannel(channels[2], 1.0f, cursor).x, 1e-6f);
+
+    // cached cursors have to give the same result as a full search, also across loop restarts
+    for (int frame = 0; frame < 100; frame++) {
+        runtime.update(0.07f);
+        vector<mat4> ref;
+        referencePalette(set, runtime.getTime(inst), ref);
+        for (uint32_t j = 0; j < runtime.getJointCount(inst); j++) {
+            EXPECT_LT(maxDiff(ref[j], runtime.getPalette(inst)[j]), 1e-5f);
+        }
+        EXPECT_LE(runtime.getTime(inst), 2.0f);
+    }
+
+    // parallel evaluation gives identical palettes
+    AnimationRuntime serial, parallel;
+    srand(42);
+    for (int i = 0; i < 1000; i++) {
+        float speed = MathHelper::RandF(0.5f, 2.0f);
+        for (AnimationRuntime* rt : { &serial, &parallel }) {
+            uint32_t n = rt->addInstance(&set);
+            rt->setClip(n, "wave");
+            rt->setSpeed(n, speed);
+        }
+    }
+    ThreadGroup threads(4);
+    for (int frame = 0; frame < 10; frame++) {
+        serial.update(1.0f / 60.0f);
+        parallel.update(1.0f / 60.0f, &threads);
+    }
+    for (uint32_t i = 0; i < serial.size(); i++) {
+        for (uint32_t j = 0; j < serial.getJointCount(i); j++) {
+            EXPECT_EQ(serial.getPalette(i)[j], parallel.getPalette(i)[j]);
+        }
+    }
+}
+
+// culling bounds of skinned meshes have to contain every animated pose, not only the rest pose
+TEST(Animation, AnimatedBoundingBox) {
+    auto set = make_shared<AnimationSet>();
+    makeTestSkeleton(*set);
+    MeshInfo mi;
+    // vertices along the bone chain, each bound to one joint
+    for (uint32_t j = 0; j < 3; j++) {
+        PBRShader::Vertex v(vec3(0.5f, (float)j, 0.0f), vec3(0.0f, 1.0f, 0.0f), vec2(0.0f), vec2(0.0f), uvec4(j, 0, 0, 0), vec4(1.0f, 0.0f, 0.0f, 0.0f), vec4(1.0f));
+        mi.vertices.push_back(v);
+    }
+    BoundingBox rest;
+    mi.getBoundingBox(rest);
+    // without animation both boxes are the same
+    BoundingBox box;
+    mi.getAnimatedBoundingBox(box);
+    EXPECT_EQ(rest.min, box.min);
+    EXPECT_EQ(rest.max, box.max);
+
+    MeshInfo skinned;
+    skinned.vertices = mi.vertices;
+    skinned.animation = set;
+    BoundingBox animated;
+    skinned.getAnimatedBoundingBox(animated);
+    EXPECT_TRUE(glm::all(glm::lessThanEqual(animated.min, rest.min)));
+    EXPECT_TRUE(glm::all(glm::greaterThanEqual(animated.max, rest.max)));
+    // rotation around y swings the vertices to negative x
+    EXPECT_LT(animated.min.x, 0.0f);
+    AnimationRuntime runtime;
+    uint32_t inst = runtime.addInstance(set.get());
+    runtime.setClip(inst, "wave");
+    for (int frame = 0; frame < 200; frame++) {
+        runtime.update(0.013f);
+        const mat4* palette = runtime.getPalette(inst);
+        for (auto& v : skinned.vertices) {
+            vec3 p = vec3(palette[v.joint0.x] * vec4(v.pos, 1.0f));
+            // poses between two samples may move slightly outside
+            EXPECT_TRUE(glm::all(glm::lessThanEqual(animated.min - vec3(0.05f), p)));
+            EXPECT_TRUE(glm::all(glm::greaterThanEqual(animated.max + vec3(0.05f), p)));
+        }
+    }
+}
+
+// joint palette throughput for a crowd of characters with 64 animated joints each
+TEST(Animation, CrowdBenchmark) {
+    AnimationSet set;
+    Skeleton& sk = set.skeleton;
+    const int joints = 64;
+    const int keys = 30;
+    AnimationClip clip;
+    clip.name = "walk";
+    clip.duration = 1.0f;
+    srand(42);
+    for (int j = 0; j < joints; j++) {
+        // 4 limbs of 16 joints below root
+        int parent = j == 0 ? -1 : (j % 16 == 1 ? 0 : j - 1);
+        sk.addJoint("j" + to_string(j), parent, vec3(0.0f, 0.1f, 0.0f), quat(1.0f, 0.0f, 0.0f, 0.0f), vec3(1.0f), mat4(1.0f));
+        AnimationChannel ch;
+        ch.joint = j;
+        ch.path = AnimationPath::Rotation;
+        for (int k = 0; k < keys; k++) {
+            ch.times.push_back(k / float(keys - 1));
+            quat q = angleAxis(MathHelper::RandF(-0.5f, 0.5f), normalize(vec3(MathHelper::RandF(-1.0f, 1.0f), 1.0f, MathHelper::RandF(-1.0f, 1.0f))));
+            ch.values.push_back(vec4(q.x, q.y, q.z, q.w));
+        }
+        clip.channels.push_back(ch);
+    }
+    sk.finish();
+    set.clips.push_back(clip);
+
+    const int characters = 2000;
+    AnimationRuntime runtime;
+    for (int i = 0; i < characters; i++) {
+        uint32_t n = runtime.addInstance(&set);
+        runtime.setClip(n, "walk");
+        runtime.setTime(n, MathHelper::RandF(0.0f, 1.0f));
+    }
+    ThreadGroup threads(4);
+    for (ThreadGroup* t : { (ThreadGroup*)nullptr, &threads }) {
+        runtime.update(1.0f / 90.0f, t); // warm up
+        double ms = 0.0;
+        const int frames = 20;
+        for (int frame = 0; frame < frames; frame++) {
+            runtime.update(1.0f / 90.0f, t);
+            ms += runtime.getStats().milliseconds;
+        }
+        EXPECT_EQ((uint64_t)characters * joints, runtime.getStats().joints);
+        Log("Animation crowd " << (t ? "parallel" : "single thread") << ": " << characters << " characters x " << joints << " joints, "
+            << ms / frames << " ms per frame, " << (double)characters * joints * frames / ms << " joints/ms" << endl);
+    }
+}
+
+TEST(Simulation, FixedTicksAndSnapshots) {
+    struct CounterSnapshot : SimulationSnapshot {
+        int counter = 0;
+    };
+    GameTime gameTime;
+    gameTime.init(GameTime::GAMEDAY_REALTIME);
+    Simulation sim;
+    sim.setTickRate(100.0);
+    sim.setTickFunction([](const SimulationSnapshot* previous, const GameTime& gt) {
+        auto s = make_shared<CounterSnapshot>();
+        s->counter = previous ? static_cast<const CounterSnapshot*>(previous)->counter + 1 : 0;
+        return s;
+    });
+    auto start = chrono::steady_clock::now();
+    sim.start(gameTime, start);
+    EXPECT_EQ(nullptr, sim.acquire(start).current);
+    // ticks at 0, 10, 20, 30 ms
+    EXPECT_EQ(4u, sim.advanceTo(start + chrono::milliseconds(35)));
+    EXPECT_EQ(0u, sim.advanceTo(start + chrono::milliseconds(39)));
+    SimulationFrameState state = sim.acquire(start + chrono::milliseconds(35));
+    auto held = static_pointer_cast<const CounterSnapshot>(state.current);
+    EXPECT_EQ(3u, held->tick);
+    EXPECT_EQ(3, held->counter);
+    EXPECT_EQ(2u, state.previous->tick);
+    EXPECT_NEAR(0.5f, state.alpha, 1e-3f);
+    // game time advances by exactly one tick duration
+    EXPECT_NEAR(0.01, held->gameTime.getTimeDelta(), 1e-6);
+    EXPECT_NEAR(0.01, held->gameTime.getTimeSeconds() - state.previous->gameTime.getTimeSeconds(), 1e-6);
+
+    // snapshots held by a frame stay unchanged while simulation continues
+    EXPECT_EQ(1u, sim.advanceTo(start + chrono::milliseconds(40)));
+    EXPECT_EQ(3, held->counter);
+    EXPECT_EQ(4u, sim.acquire(start + chrono::milliseconds(40)).current->tick);
+
+    // falling far behind drops time instead of running all missed ticks
+    EXPECT_EQ(Simulation::MAX_CATCHUP_TICKS, sim.advanceTo(start + chrono::seconds(1)));
+    SimulationStats stats = sim.getStats();
+    EXPECT_EQ(5u + Simulation::MAX_CATCHUP_TICKS, stats.ticks);
+    EXPECT_EQ(101u - stats.ticks, stats.skippedTicks);
+
+    // pipeline metrics: frames rendered with ticks 3, 3, 6
+    FramePipelineMetrics metrics;
+    metrics.reset(3);
+    SimulationSnapshot a, b;
+    a.tick = 3;
+    b.tick = 6;
+    a.created = b.created = start;
+    metrics.frameSubmitted(start, &a, start + chrono::milliseconds(5));
+    metrics.frameSubmitted(start, &a, start + chrono::milliseconds(10));
+    metrics.frameSubmitted(start, &b, start + chrono::milliseconds(20));
+    FramePipelineStats ps = metrics.getStats();
+    EXPECT_EQ(3, ps.framesInFlight);
+    EXPECT_EQ(3u, ps.frames);
+    EXPECT_EQ(1u, ps.repeatedSnapshots);
+    EXPECT_EQ(2u, ps.unrenderedTicks);
+    EXPECT_NEAR(35.0 / 3.0, ps.avgLatencyMilliseconds, 1e-6);
+    EXPECT_NEAR(20.0, ps.maxLatencyMilliseconds, 1e-6);
+    EXPECT_NEAR(2.0 / 0.015, ps.framesPerSecond(), 1e-3);
+}
+
+// CPU model of the engine frame pipeline for each frames in flight setting: simulation thread at 120 Hz,
+// render thread preparing frames and queue submit thread waiting for the previous frame on a simulated GPU.
+// Uses the same continuation scheme as ShadedPathEngine: framesInFlight - 1 tokens for the render thread
+TEST(Simulation, FramesInFlightBenchmark) {
+    struct Frame {
+        chrono::steady_clock::time_point start;
+        shared_ptr<const SimulationSnapshot> snapshot;
+        int workMicros = 0;
+    };
+    auto busy = [](int micros) {
+        auto end = chrono::steady_clock::now() + chrono::microseconds(micros);
+        while (chrono::steady_clock::now() < end);
+    };
+    const int frames = 120;
+    for (int framesInFlight = 2; framesInFlight <= ShadedPathEngine::MAX_FRAMES_IN_FLIGHT; framesInFlight++) {
+        GameTime gameTime;
+        gameTime.init(GameTime::GAMEDAY_REALTIME);
+        Simulation sim;
+        sim.setTickRate(120.0);
+        sim.start(gameTime);
+        atomic<bool> stop = false;
+        thread simThread([&] { sim.runLoop([&] { return stop.load(); }); });
+        FramePipelineMetrics metrics;
+        metrics.reset(framesInFlight);
+        array<Frame, ShadedPathEngine::MAX_FRAMES_IN_FLIGHT> slots;
+        ThreadsafeWaitingQueue<unsigned long> continueQueue;
+        ThreadsafeWaitingQueue<int> submitQueue;
+        for (int i = 0; i < framesInFlight - 1; i++) {
+            continueQueue.push(0);
+        }
+        thread submitThread([&] {
+            auto gpuFree = chrono::steady_clock::now();
+            for (int n = 0; n < frames; n++) {
+                Frame& f = slots[*submitQueue.pop()];
+                // submit waits for previous frame on GPU, GPU time varies like preparation time
+                this_thread::sleep_until(gpuFree);
+                auto now = chrono::steady_clock::now();
+                gpuFree = now + chrono::microseconds(f.workMicros);
+                metrics.frameSubmitted(f.start, f.snapshot.get(), now);
+                continueQueue.push(0);
+            }
+        });
+        EXPECT_TRUE(sim.waitForFirstSnapshot());
+        for (int n = 0; n < frames; n++) {
+            continueQueue.pop();
+            int slot = n % framesInFlight;
+            Frame& f = slots[slot];
+            f.start = chrono::steady_clock::now();
+            f.snapshot = sim.acquire(f.start).current;
+            f.workMicros = (n % 4 == 0) ? 6000 : 2000;
+            busy(f.workMicros);
+            submitQueue.push(slot);
+        }
+        submitThread.join();
+        stop = true;
+        simThread.join();
+        FramePipelineStats stats = metrics.getStats();
+        stats.log();
+        sim.getStats().log();
+        EXPECT_EQ((uint64_t)frames, stats.frames);
+        EXPECT_GT(stats.framesPerSecond(), 0.0);
+        EXPECT_GT(stats.avgLatencyMilliseconds, 0.0);
+    }
+}
+
+// measures wakeup error distribution of the frame pacer for typical monitor and HMD rates.
+// Bounds are loose to not fail on loaded build machines, the histogram is in the log
+TEST(FramePacer, JitterDistribution) {
+    for (double rate : { 90.0, 120.0, 144.0 }) {
+        FramePacer pacer(rate);
+        const int frames = static_cast<int>(rate / 2); // 0.5 s
+        pacer.waitForNextFrame(); // start grid
+        auto start = chrono::steady_clock::now();
+        for (int i = 0; i < frames; i++) {
+            pacer.waitForNextFrame();
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        const FramePacerStats& stats = pacer.getStats();
+        stats.log(to_string((int)rate) + " Hz");
+        // every call ends on a deadline, late calls skip late / period + 1 deadlines of the grid
+        EXPECT_EQ((uint64_t)frames, stats.frames);
+        // absolute deadlines: no accumulated drift over the whole run
+        double periods = static_cast<double>(stats.frames + stats.missedDeadlines);
+        EXPECT_NEAR(periods / rate, seconds, 0.1 * frames / rate);
+        // half of the frames wake up within 1 ms after deadline
+        long long median = stats.percentileMicros(0.5);
+        EXPECT_TRUE(median > 0 && median <= 1000);
+    }
+
+    // one overlong frame skips one deadline but keeps the grid
+    FramePacer pacer(100.0);
+    pacer.waitForNextFrame();
+    auto start = chrono::steady_clock::now();
+    pacer.waitForNextFrame();
+    this_thread::sleep_for(chrono::milliseconds(15));
+    pacer.waitForNextFrame();
+    pacer.waitForNextFrame();
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    EXPECT_EQ(1u, pacer.getStats().missedDeadlines);
+    EXPECT_EQ(3u, pacer.getStats().frames);
+    EXPECT_NEAR(40.0, ms, 5.0);
+}
+
+TEST(RingQueue, CloseAndBatch) {
+    SpscRingQueue<int> spsc(5);
+    EXPECT_EQ(8u, spsc.capacity());
+    for (int i = 0; i < 8; i++) {
+        EXPECT_TRUE(spsc.tryPush(i));
+    }
+    EXPECT_FALSE(spsc.tryPush(8));
+    EXPECT_EQ(8u, spsc.size());
+    int out[16];
+    EXPECT_EQ(3u, spsc.popBatch(out, 3));
+    EXPECT_EQ(0, out[0]);
+    EXPECT_EQ(2, out[2]);
+    int more[] = { 8, 9, 10 };
+    EXPECT_EQ(3u, spsc.pushBatch(more, 3));
+    EXPECT_EQ(8u, spsc.popBatch(out, 16));
+    EXPECT_EQ(3, out[0]);
+    EXPECT_EQ(10, out[7]);
+
+    // close: remaining items are delivered, then nullopt. Waiting consumer is woken up
+    MpmcRingQueue<int> mpmc(4);
+    mpmc.push(1);
+    thread consumer([&] {
+        EXPECT_EQ(1, *mpmc.pop());
+        EXPECT_FALSE(mpmc.pop().has_value());
+    });
+    this_thread::sleep_for(chrono::milliseconds(20));
+    mpmc.close();
+    consumer.join();
+    EXPECT_FALSE(mpmc.push(2));
+    EXPECT_TRUE(mpmc.isClosed());
+    EXPECT_EQ(0u, mpmc.popBatch(out, 4));
+}
+
+// throughput under contention and ping-pong latency of the ring queues compared to ThreadsafeWaitingQueue
+template<typename Q>
+static double queueThroughput(Q& q, int producers, int consumers, int itemsPerProducer, uint64_t& sum)
+{
+    atomic<uint64_t> total = 0;
+    auto start = chrono::steady_clock::now();
+    vector<thread> threads;
+    for (int p = 0; p < producers; p++) {
+        threads.emplace_back([&q, itemsPerProducer] {
+            for (int i = 1; i <= itemsPerProducer; i++) q.push(i);
+        });
+    }
+    int itemsPerConsumer = itemsPerProducer * producers / consumers;
+    for (int c = 0; c < consumers; c++) {
+        threads.emplace_back([&q, &total, itemsPerConsumer] {
+            uint64_t local = 0;
+            for (int i = 0; i < itemsPerConsumer; i++) local += *q.pop();
+            total += local;
+        });
+    }
+    for (auto& t : threads) t.join();
+    sum = total;
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    return itemsPerProducer * producers / ms;
+}
+
+template<typename Q>
+static double queueRoundTripMicros(Q& ping, Q& pong, int roundTrips)
+{
+    thread echo([&] {
+        for (int i = 0; i < roundTrips; i++) pong.push(*ping.pop());
+    });
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < roundTrips; i++) {
+        ping.push(i);
+        pong.pop();
+    }
+    double us = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+    echo.join();
+    return us / roundTrips;
+}
+
+TEST(RingQueue, Benchmark) {
+    const int items = 200000;
+    const uint64_t expected = (uint64_t)items * (items + 1) / 2;
+    uint64_t sum = 0;
+    {
+        ThreadsafeWaitingQueue<int> q;
+        double old = queueThroughput(q, 1, 1, items, sum);
+        EXPECT_EQ(expected, sum);
+        SpscRingQueue<int> r(1024);
+        double ring = queueThroughput(r, 1, 1, items, sum);
+        EXPECT_EQ(expected, sum);
+        Log("Queue 1 producer 1 consumer: ThreadsafeWaitingQueue " << old << " items/ms, SpscRingQueue " << ring << " items/ms" << endl);
+    }
+    {
+        ThreadsafeWaitingQueue<int> q;
+        double old = queueThroughput(q, 4, 4, items / 4, sum);
+        EXPECT_EQ(4 * (uint64_t)(items / 4) * (items / 4 + 1) / 2, sum);
+        MpmcRingQueue<int> r(1024);
+        double ring = queueThroughput(r, 4, 4, items / 4, sum);
+        EXPECT_EQ(4 * (uint64_t)(items / 4) * (items / 4 + 1) / 2, sum);
+        Log("Queue 4 producers 4 consumers: ThreadsafeWaitingQueue " << old << " items/ms, MpmcRingQueue " << ring << " items/ms" << endl);
+    }
+    {
+        const int roundTrips = 20000;
+        ThreadsafeWaitingQueue<int> ping, pong;
+        double old = queueRoundTripMicros(ping, pong, roundTrips);
+        SpscRingQueue<int> rping(8), rpong(8);
+        double ring = queueRoundTripMicros(rping, rpong, roundTrips);
+        Log("Queue round trip latency: ThreadsafeWaitingQueue " << old << " us, SpscRingQueue " << ring << " us" << endl);
+        EXPECT_GT(ring, 0.0);
+    }
+}
+
+// cache data as written by vkGetPipelineCacheData(): Vulkan header followed by driver data
+static vector<byte> makePipelineCacheData(const PipelineCacheKey& key, size_t size) {
+    vector<byte> data(size);
+    for (size_t i = 0; i < size; i++) data[i] = static_cast<byte>(i * 7);
+    VkPipelineCacheHeaderVersionOne header{};
+    header.headerSize = sizeof(header);
+    header.headerVersion = VK_PIPELINE_CACHE_HEADER_VERSION_ONE;
+    header.vendorID = key.vendorID;
+    header.deviceID = key.deviceID;
+    memcpy(header.pipelineCacheUUID, key.pipelineCacheUUID, VK_UUID_SIZE);
+    memcpy(data.data(), &header, sizeof(header));
+    return data;
+}
+
+TEST(PipelineCache, FileValidation) {
+    PipelineCacheKey key;
+    key.vendorID = 0x10de;
+    key.deviceID = 0x2684;
+    key.driverVersion = 0x84a0c000;
+    for (uint8_t i = 0; i < VK_UUID_SIZE; i++) key.pipelineCacheUUID[i] = i + 1;
+    auto data = makePipelineCacheData(key, 1000);
+    auto file = PipelineCache::buildFile(key, data.data(), data.size());
+    size_t size = 0;
+    size_t offset = PipelineCache::validateFile(file, key, size);
+    ASSERT_GT(offset, 0);
+    EXPECT_EQ(size, data.size());
+    EXPECT_EQ(memcmp(file.data() + offset, data.data(), size), 0);
+
+    // other driver version
+    PipelineCacheKey other = key;
+    other.driverVersion++;
+    EXPECT_EQ(PipelineCache::validateFile(file, other, size), 0);
+    EXPECT_EQ(size, 0);
+    // other device
+    other = key;
+    other.pipelineCacheUUID[3] ^= 0xff;
+    EXPECT_EQ(PipelineCache::validateFile(file, other, size), 0);
+    other = key;
+    other.deviceID++;
+    EXPECT_EQ(PipelineCache::validateFile(file, other, size), 0);
+    // truncated or corrupted file
+    vector<byte> broken(file.begin(), file.end() - 1);
+    EXPECT_EQ(PipelineCache::validateFile(broken, key, size), 0);
+    broken = file;
+    broken.back() ^= byte{ 1 };
+    EXPECT_EQ(PipelineCache::validateFile(broken, key, size), 0);
+    EXPECT_EQ(PipelineCache::validateFile(vector<byte>(), key, size), 0);
+    // Vulkan header written by another device
+    other = key;
+    other.vendorID = 0x1002;
+    auto otherData = makePipelineCacheData(other, 1000);
+    file = PipelineCache::buildFile(key, otherData.data(), otherData.size());
+    EXPECT_EQ(PipelineCache::validateFile(file, key, size), 0);
+    // data too small for Vulkan header
+    file = PipelineCache::buildFile(key, data.data(), 8);
+    EXPECT_EQ(PipelineCache::validateFile(file, key, size), 0);
+}
+
+TEST(TextureStore, DescriptorSlots) {
+    DescriptorSlots slots;
+    for (uint32_t i = 0; i < 10; i++) {
+        EXPECT_EQ(slots.allocate(), i);
+    }
+    auto ranges = slots.takeDirtyRanges();
+    ASSERT_EQ(ranges.size(), 1);
+    EXPECT_EQ(ranges[0].first, 0);
+    EXPECT_EQ(ranges[0].count, 10);
+    EXPECT_FALSE(slots.hasDirty());
+    EXPECT_TRUE(slots.takeDirtyRanges().empty());
+
+    // released slots have to be rewritten and are reused, last released first
+    slots.release(7);
+    slots.release(3);
+    slots.markDirty(5);
+    slots.markDirty(5);
+    EXPECT_EQ(slots.usedCount(), 8);
+    EXPECT_FALSE(slots.isUsed(3));
+    ranges = slots.takeDirtyRanges();
+    ASSERT_EQ(ranges.size(), 3);
+    EXPECT_EQ(ranges[0].first, 3);
+    EXPECT_EQ(ranges[1].first, 5);
+    EXPECT_EQ(ranges[2].first, 7);
+    EXPECT_EQ(ranges[2].count, 1);
+    EXPECT_EQ(slots.allocate(), 3);
+    EXPECT_EQ(slots.allocate(), 7);
+    EXPECT_EQ(slots.allocate(), 10);
+    EXPECT_EQ(slots.size(), 11);
+    // small gaps are merged
+    ranges = slots.takeDirtyRanges(2);
+    ASSERT_EQ(ranges.size(), 2);
+    EXPECT_EQ(ranges[0].first, 3);
+    EXPECT_EQ(ranges[0].count, 1);
+    EXPECT_EQ(ranges[1].first, 7);
+    EXPECT_EQ(ranges[1].count, 4);
+
+    // single changes in a large store only write the changed descriptors
+    DescriptorSlots large;
+    for (uint32_t i = 0; i < 10000; i++) large.allocate();
+    large.takeDirtyRanges();
+    for (uint32_t slot : { 9000u, 17u, 4711u, 18u, 9999u }) large.markDirty(slot);
+    ranges = large.takeDirtyRanges();
+    uint32_t written = 0;
+    for (auto& r : ranges) written += r.count;
+    EXPECT_EQ(ranges.size(), 4);
+    EXPECT_EQ(written, 5);
+    large.markAllDirty();
+    ranges = large.takeDirtyRanges();
+    ASSERT_EQ(ranges.size(), 1);
+    EXPECT_EQ(ranges[0].count, 10000);
+}
+
+TEST(ObjectComponents, HandlesAndSwapRemove) {
+    ObjectComponentStore store;
+    vector<ObjectHandle> h;
+    for (int i = 0; i < 5; i++) {
+        h.push_back(store.create());
+        store.position(h[i]) = vec3((float)i, 0.0f, 0.0f);
+    }
+    EXPECT_EQ(store.size(), 5);
+    // removing object 1 moves last object into its dense index
+    store.remove(h[1]);
+    EXPECT_EQ(store.size(), 4);
+    EXPECT_FALSE(store.isAlive(h[1]));
+    EXPECT_TRUE(store.isAlive(h[4]));
+    EXPECT_EQ(store.indexOf(h[4]), 1);
+    EXPECT_EQ(store.position(h[4]).x, 4.0f);
+    EXPECT_EQ(store.positions()[1].x, 4.0f);
+    EXPECT_TRUE(store.handles()[1] == h[4]);
+    for (int i : { 0, 2, 3, 4 }) {
+        EXPECT_EQ(store.position(h[i]).x, (float)i);
+    }
+    // slot is reused with new generation, old handle stays invalid
+    ObjectHandle reused = store.create();
+    EXPECT_EQ(reused.index, h[1].index);
+    EXPECT_NE(reused.generation, h[1].generation);
+    EXPECT_FALSE(store.isAlive(h[1]));
+    EXPECT_TRUE(store.isAlive(reused));
+    // remove last object
+    store.remove(reused);
+    store.remove(h[0]);
+    EXPECT_EQ(store.size(), 3);
+    for (int i : { 2, 3, 4 }) {
+        EXPECT_EQ(store.position(h[i]).x, (float)i);
+    }
+    store.clear();
+    EXPECT_EQ(store.size(), 0);
+    EXPECT_FALSE(store.isAlive(h[2]));
+
+    // transforms match WorldObject calculation (without mesh base transform)
+    ObjectHandle o = store.create();
+    vec3 p(1.0f, 2.0f, 3.0f), r(0.3f, -1.1f, 2.0f), sc(2.0f, 0.5f, 1.5f);
+    store.position(o) = p;
+    store.rotation(o) = r;
+    store.scaling(o) = sc;
+    store.setLocalBounds(o, ObjectBounds{ vec3(-1.0f), vec3(1.0f) });
+    store.updateTransforms();
+    mat4 expected = translate(mat4(1.0f), p) * rotate(mat4(1.0f), r.z, vec3(0.0f, 0.0f, 1.0f)) * rotate(mat4(1.0f), r.y, vec3(0.0f, 1.0f, 0.0f))
+        * rotate(mat4(1.0f), r.x, vec3(1.0f, 0.0f, 0.0f)) * scale(mat4(1.0f), sc);
+    const mat4& m = store.modelToWorld(o);
+    for (int c = 0; c < 4; c++) for (int i = 0; i < 4; i++) {
+        EXPECT_NEAR(m[c][i], expected[c][i], 1e-5f);
+    }
+    // world bounds contain all transformed corners
+    const ObjectBounds& wb = store.worldBounds()[store.indexOf(o)];
+    for (int corner = 0; corner < 8; corner++) {
+        vec3 v((corner & 1) ? 1.0f : -1.0f, (corner & 2) ? 1.0f : -1.0f, (corner & 4) ? 1.0f : -1.0f);
+        vec3 w = vec3(m * vec4(v, 1.0f));
+        for (int i = 0; i < 3; i++) {
+            EXPECT_LE(wb.min[i], w[i] + 1e-4f);
+            EXPECT_GE(wb.max[i], w[i] - 1e-4f);
+        }
+    }
+}
+
+TEST(ObjectComponents, TransformBenchmark) {
+    const size_t n = 1000000;
+    auto dist = [] { return MathHelper::RandF(-100.0f, 100.0f); };
+    ObjectComponentStore store;
+    store.reserve(n);
+    for (size_t i = 0; i < n; i++) {
+        ObjectHandle h = store.create();
+        store.position(h) = vec3(dist(), dist(), dist());
+        store.rotation(h) = vec3(dist(), dist(), dist()) * 0.01f;
+        store.setLocalBounds(h, ObjectBounds{ vec3(-1.0f), vec3(1.0f) });
+    }
+    // previous layout: separate heap objects visited through a pointer list
+    vector<unique_ptr<WorldObject>> objects;
+    vector<WorldObject*> list;
+    objects.reserve(n);
+    for (size_t i = 0; i < n; i++) {
+        objects.push_back(make_unique<WorldObject>());
+        objects.back()->pos() = store.positions()[i];
+        objects.back()->rot() = store.rotations()[i];
+    }
+    // objects of many groups are not visited in allocation order
+    for (size_t i = 0; i < n; i++) {
+        list.push_back(objects[(i * 7919) % n].get());
+    }
+    auto measure = [](auto&& pass) {
+        double best = numeric_limits<double>::max();
+        for (int run = 0; run < 3; run++) {
+            auto start = chrono::high_resolution_clock::now();
+            pass();
+            best = std::min(best, chrono::duration<double, milli>(chrono::high_resolution_clock::now() - start).count());
+        }
+        return best;
+    };
+    ObjectBounds unit{ vec3(-1.0f), vec3(1.0f) };
+    double aos = measure([&] {
+        for (WorldObject* wo : list) {
+            mat4 m = ObjectComponentStore::composeTransform(wo->pos(), wo->rot(), wo->scale());
+            ObjectBounds b = ObjectComponentStore::transformBounds(m, unit);
+            wo->perFrameBB.min = b.min;
+            wo->perFrameBB.max = b.max;
+        }
+    });
+    double soa = measure([&] { store.updateTransforms(); });
+    ThreadGroup threads(4);
+    double soaParallel = measure([&] { store.updateTransforms(&threads); });
+    Log("Transform update of " << n << " objects: WorldObject pointers " << aos << " ms, SoA " << soa << " ms, SoA 4 threads " << soaParallel << " ms" << endl);
+    // spot check results
+    for (size_t i = 0; i < n; i += 99991) {
+        mat4 m = ObjectComponentStore::composeTransform(store.positions()[i], store.rotations()[i], vec3(1.0f));
+        EXPECT_NEAR(store.modelToWorldMatrices()[i][3][0], m[3][0], 1e-4f);
+        EXPECT_NEAR(store.worldBounds()[i].max.y, ObjectComponentStore::transformBounds(m, unit).max.y, 1e-4f);
+    }
+    EXPECT_GT(soa, 0.0);
+}
+
+TEST(InternTable, TypedIds) {
+    InternTable<MeshId> meshIds;
+    MeshId a = meshIds.intern("Rock_A");
+    MeshId b = meshIds.intern("Rock_B");
+    EXPECT_EQ(a.value, 0u);
+    EXPECT_EQ(b.value, 1u);
+    EXPECT_EQ(meshIds.intern("Rock_A"), a);
+    EXPECT_EQ(meshIds.find(string_view("Rock_B")), b);
+    EXPECT_FALSE(meshIds.find("Rock_C").isValid());
+    EXPECT_EQ(meshIds.name(b), "Rock_B");
+    EXPECT_EQ(meshIds.size(), 2u);
+    EXPECT_TRUE(meshIds.contains(a));
+    EXPECT_FALSE(meshIds.contains(MeshId{}));
+    // names stay valid after growing the table
+    for (int i = 0; i < 1000; i++) {
+        meshIds.intern("mesh_" + to_string(i));
+    }
+    EXPECT_EQ(meshIds.name(a), "Rock_A");
+    EXPECT_EQ(meshIds.find("mesh_999").value, 1001u);
+    // id spaces are separate types
+    static_assert(!is_same_v<MeshId, TextureId>);
+    static_assert(!is_same_v<GroupId, SoundId>);
+    meshIds.clear();
+    EXPECT_FALSE(meshIds.find("Rock_A").isValid());
+}
+
+// adding many objects (e.g. World Creator instances) through the real WorldObjectStore::addObject() path:
+// group and mesh names looked up for each object against ids resolved once
+TEST_F(MeshStoreTestDynamic, AddObjectBenchmark) {
+    {
+        const size_t n = 5000;
+        ShadedPathEngine my_engine;
+        static ShadedPathEngine* engine = &my_engine;
+        // both passes reuse the same object numbers and model UBO slots after clear()
+        engine->setMaxObjects(n);
+        minimalEngineInitialization(engine, 50);
+        engine->files.findAssetFolder("test_samples");
+        engine->meshStore.loadMeshLod("test_multi_prim_lod_cmp.glb", "Sample");
+        vector<vec3> positions(n);
+        for (auto& pos : positions) {
+            pos = vec3(MathHelper::RandF(0.0f, 1024.0f), MathHelper::RandF(0.0f, 50.0f), MathHelper::RandF(0.0f, 1024.0f));
+        }
+
+        engine->objectStore.createGroup("flora", 3);
+        auto start = chrono::high_resolution_clock::now();
+        for (const vec3& pos : positions) {
+            engine->objectStore.addObject("flora", "Sample", pos);
+        }
+        double stringMillis = chrono::duration<double, milli>(chrono::high_resolution_clock::now() - start).count();
+        const auto* byString = engine->objectStore.getGroup("flora");
+        ASSERT_EQ(byString->size(), n);
+        MeshInfo* mesh = byString->back()->mesh;
+        vec3 lastPos = byString->back()->pos();
+        EXPECT_EQ(byString->back()->userGroupId, 3);
+
+        engine->objectStore.clear();
+        GroupId flora = engine->objectStore.createGroup("flora", 3);
+        start = chrono::high_resolution_clock::now();
+        MeshId meshId = engine->objectStore.resolveMeshId("Sample");
+        for (const vec3& pos : positions) {
+            engine->objectStore.addObject(flora, meshId, pos);
+        }
+        double internedMillis = chrono::duration<double, milli>(chrono::high_resolution_clock::now() - start).count();
+        Log("WorldObjectStore::addObject() of " << n << " objects: string lookups " << stringMillis << " ms, interned ids " << internedMillis << " ms" << endl);
+
+        const auto* byId = engine->objectStore.getGroup(flora);
+        ASSERT_EQ(byId->size(), n);
+        EXPECT_EQ(byId->back()->mesh, mesh);
+        EXPECT_EQ(byId->back()->pos(), lastPos);
+        EXPECT_EQ(byId->back()->userGroupId, 3);
+        EXPECT_EQ(engine->objectStore.getComponents().size(), n);
+    }
+}
+
+// random boxes (and some spheres) around the origin, camera looks along -z
+static void fillCullingScene(FrustumCulling& culling, size_t n, bool withSpheres) {
+    culling.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        vec3 c(MathHelper::RandF(-500.0f, 500.0f), MathHelper::RandF(-50.0f, 50.0f), MathHelper::RandF(-500.0f, 500.0f));
+        if (withSpheres && i % 5 == 0) {
+            culling.setSphere(i, c, MathHelper::RandF(0.2f, 4.0f));
+        } else {
+            vec3 e(MathHelper::RandF(0.2f, 4.0f), MathHelper::RandF(0.2f, 4.0f), MathHelper::RandF(0.2f, 4.0f));
+            culling.setBox(i, c - e, c + e);
+        }
+    }
+}
+
+static mat4 cullingViewProjection(vec3 eye, float yaw) {
+    mat4 proj = glm::perspective(glm::radians(90.0f), 16.0f / 9.0f, 0.1f, 300.0f);
+    proj[1][1] *= -1; // Vulkan
+    vec3 dir(sin(yaw), 0.0f, -cos(yaw));
+    return proj * glm::lookAt(eye, eye + dir, vec3(0.0f, 1.0f, 0.0f));
+}
+
+TEST(FrustumCulling, ScalarReference) {
+    const size_t n = 100000;
+    FrustumCulling simd, scalar, threaded;
+    fillCullingScene(simd, n, true);
+    mat4 vp = cullingViewProjection(vec3(0.0f, 2.0f, 0.0f), 0.3f);
+    Frustum view = Frustum::fromViewProjection(vp);
+    scalar = simd;
+    threaded = simd;
+    simd.cull(view);
+    scalar.cull(view, nullptr, false);
+    ThreadGroup threads(4);
+    threaded.cull(view, &threads);
+    size_t mismatch = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (simd.getResult(i) != scalar.getResult(i)) mismatch++;
+        ASSERT_EQ(simd.getResult(i), threaded.getResult(i));
+    }
+    // both paths use the same operations, only compiler contraction to FMA could change boundary cases
+    EXPECT_LE(mismatch, n / 10000);
+    EXPECT_EQ(simd.getVisible(), threaded.getVisible());
+    EXPECT_TRUE(std::is_sorted(simd.getVisible().begin(), simd.getVisible().end()));
+    EXPECT_EQ(simd.getStats().visible, simd.getVisible().size());
+    EXPECT_GT(simd.getStats().visible, 0u);
+    EXPECT_LT(simd.getStats().visible, n / 2);
+
+    // boxes against clip space corners, independent of plane extraction
+    auto outsideClip = [&](vec3 mn, vec3 mx) {
+        vec4 clip[8];
+        for (int c = 0; c < 8; c++) {
+            clip[c] = vp * vec4((c & 1) ? mx.x : mn.x, (c & 2) ? mx.y : mn.y, (c & 4) ? mx.z : mn.z, 1.0f);
+        }
+        for (int plane = 0; plane < 6; plane++) {
+            bool allOut = true;
+            for (int c = 0; c < 8 && allOut; c++) {
+                const vec4& p = clip[c];
+                float v = plane == 0 ? p.w + p.x : plane == 1 ? p.w - p.x : plane == 2 ? p.w + p.y : plane == 3 ? p.w - p.y : plane == 4 ? p.z : p.w - p.z;
+                allOut = v < 0.0f;
+            }
+            if (allOut) return true;
+        }
+        return false;
+    };
+    FrustumCulling check;
+    size_t clipMismatch = 0;
+    for (size_t i = 0; i < 20000; i++) {
+        vec3 c(MathHelper::RandF(-500.0f, 500.0f), MathHelper::RandF(-50.0f, 50.0f), MathHelper::RandF(-500.0f, 500.0f));
+        vec3 e(MathHelper::RandF(0.2f, 4.0f), MathHelper::RandF(0.2f, 4.0f), MathHelper::RandF(0.2f, 4.0f));
+        check.resize(1);
+        check.setBox(0, c - e, c + e);
+        check.cull(view);
+        bool visible = check.getResult(0) != 0;
+        if (visible == outsideClip(c - e, c + e)) clipMismatch++;
+    }
+    EXPECT_LE(clipMismatch, 2u);
+
+    // stereo: combined frustum must not reject anything an eye sees, refinement equals single eye culling
+    mat4 vpLeft = cullingViewProjection(vec3(-0.032f, 2.0f, 0.0f), 0.3f + 0.02f);
+    mat4 vpRight = cullingViewProjection(vec3(0.032f, 2.0f, 0.0f), 0.3f - 0.02f);
+    Frustum left = Frustum::fromViewProjection(vpLeft);
+    Frustum right = Frustum::fromViewProjection(vpRight);
+    FrustumCulling stereo = simd, monoLeft = simd, monoRight = simd, stereoScalar = simd;
+    stereo.cullStereo(left, right, &threads);
+    stereoScalar.cullStereo(left, right, nullptr, false);
+    monoLeft.cull(left);
+    monoRight.cull(right);
+    mismatch = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint8_t r = stereo.getResult(i);
+        ASSERT_EQ((r & CULL_VISIBLE_LEFT) != 0, monoLeft.getResult(i) != 0);
+        ASSERT_EQ((r & CULL_VISIBLE_RIGHT) != 0, monoRight.getResult(i) != 0);
+        bool inside = (monoLeft.getResult(i) & CULL_INSIDE) && (monoRight.getResult(i) & CULL_INSIDE);
+        ASSERT_EQ((r & CULL_INSIDE) != 0, inside);
+        if (r != stereoScalar.getResult(i)) mismatch++;
+    }
+    EXPECT_LE(mismatch, n / 10000);
+    const auto& st = stereo.getStats();
+    EXPECT_GT(st.rejectedByCombined, (n - st.visible) * 9 / 10);
+    EXPECT_EQ(st.rejectedByCombined, stereoScalar.getStats().rejectedByCombined);
+    // corners of both eyes are inside the combined frustum
+    Frustum combined = Frustum::combine(left, right);
+    for (int c = 0; c < 8; c++) {
+        EXPECT_NE(0, combined.test(left.corners[c], vec3(0.0f), 1e-3f));
+        EXPECT_NE(0, combined.test(right.corners[c], vec3(0.0f), 1e-3f));
+    }
+
+    // objects without bounds are never culled
+    FrustumCulling always;
+    always.resize(1);
+    always.setAlwaysVisible(0);
+    always.cullStereo(left, right);
+    EXPECT_EQ(CULL_VISIBLE_LEFT | CULL_VISIBLE_RIGHT, always.getResult(0));
+}
+
+TEST(FrustumCulling, Benchmark) {
+    const size_t n = 1000000;
+    FrustumCulling culling;
+    fillCullingScene(culling, n, false);
+    Frustum view = Frustum::fromViewProjection(cullingViewProjection(vec3(0.0f, 2.0f, 0.0f), 0.0f));
+    Frustum left = Frustum::fromViewProjection(cullingViewProjection(vec3(-0.032f, 2.0f, 0.0f), 0.0f));
+    Frustum right = Frustum::fromViewProjection(cullingViewProjection(vec3(0.032f, 2.0f, 0.0f), 0.0f));
+    ThreadGroup threads(4);
+    auto measure = [](auto&& pass) {
+        double best = numeric_limits<double>::max();
+        for (int run = 0; run < 3; run++) {
+            auto start = chrono::high_resolution_clock::now();
+            pass();
+            best = std::min(best, chrono::duration<double, milli>(chrono::high_resolution_clock::now() - start).count());
+        }
+        return best;
+    };
+    double scalar = measure([&] { culling.cull(view, nullptr, false); });
+    double simd = measure([&] { culling.cull(view); });
+    double simdThreads = measure([&] { culling.cull(view, &threads); });
+    double stereoSeparate = measure([&] { culling.cull(left); culling.cull(right); });
+    double stereo = measure([&] { culling.cullStereo(left, right); });
+    double stereoThreads = measure([&] { culling.cullStereo(left, right, &threads); });
+    culling.getStats().log();
+    Log("Frustum culling of " << n << " objects (objects per ms): scalar " << n / scalar << ", SIMD " << n / simd
+        << ", SIMD 4 threads " << n / simdThreads << endl);
+    Log("Stereo: both eyes separately " << n / stereoSeparate << ", combined frustum " << n / stereo
+        << ", combined 4 threads " << n / stereoThreads << endl);
+    EXPECT_GT(culling.getStats().rejectedByCombined, 0u);
+}
+
+// triangulated height field like OcclusionCulling::addHeightfieldOccluder()
+struct OcclusionTestTerrain {
+    static constexpr int SAMPLES = 129;
+    static constexpr float MIN_XZ = -512.0f;
+    static constexpr float MAX_XZ = 512.0f;
+    vector<float> heights;
+    OcclusionTestTerrain() {
+        heights.resize(SAMPLES * SAMPLES);
+        float step = (MAX_XZ - MIN_XZ) / (SAMPLES - 1);
+        for (int z = 0; z < SAMPLES; z++) {
+            for (int x = 0; x < SAMPLES; x++) {
+                float wx = MIN_XZ + x * step, wz = MIN_XZ + z * step;
+                // ridge along x at z = -100 and a single hill in the east
+                float ridge = 40.0f * exp(-pow((wz + 100.0f) / 30.0f, 2.0f));
+                float hill = 60.0f * exp(-(pow(wx - 250.0f, 2.0f) + pow(wz - 150.0f, 2.0f)) / 3000.0f);
+                heights[z * SAMPLES + x] = ridge + hill + MathHelper::RandF(0.0f, 1.0f);
+            }
+        }
+    }
+    float height(float wx, float wz) const {
+        float step = (MAX_XZ - MIN_XZ) / (SAMPLES - 1);
+        float fx = (wx - MIN_XZ) / step, fz = (wz - MIN_XZ) / step;
+        int x = std::clamp((int)fx, 0, SAMPLES - 2), z = std::clamp((int)fz, 0, SAMPLES - 2);
+        float u = fx - x, v = fz - z;
+        float h00 = heights[z * SAMPLES + x], h10 = heights[z * SAMPLES + x + 1];
+        float h01 = heights[(z + 1) * SAMPLES + x], h11 = heights[(z + 1) * SAMPLES + x + 1];
+        if (u + v <= 1.0f) return h00 + u * (h10 - h00) + v * (h01 - h00);
+        return h11 + (1.0f - u) * (h01 - h11) + (1.0f - v) * (h10 - h11);
+    }
+    // true if terrain is between eye and p
+    bool blocked(vec3 eye, vec3 p) const {
+        for (int i = 1; i < 256; i++) {
+            vec3 s = eye + (p - eye) * (i / 256.0f);
+            if (s.y < height(s.x, s.z)) return true;
+        }
+        return false;
+    }
+};
+
+TEST(OcclusionCulling, TerrainPoses) {
+    OcclusionTestTerrain terrain;
+    OcclusionCulling culling, threaded;
+    culling.addHeightfieldOccluder(terrain.heights, OcclusionTestTerrain::SAMPLES, OcclusionTestTerrain::MIN_XZ, OcclusionTestTerrain::MAX_XZ);
+    threaded = culling;
+    EXPECT_EQ(128u * 128u * 2u, culling.getOccluderTriangleCount());
+    // objects standing on the terrain
+    const size_t n = 20000;
+    vector<ObjectBounds> bounds(n);
+    for (auto& b : bounds) {
+        float x = MathHelper::RandF(-450.0f, 450.0f), z = MathHelper::RandF(-450.0f, 450.0f);
+        float size = MathHelper::RandF(0.5f, 3.0f);
+        float y = terrain.height(x, z);
+        b.min = vec3(x - size, y, z - size);
+        b.max = vec3(x + size, y + 2.0f * size, z + size);
+    }
+    struct Pose {
+        vec3 eye;
+        vec3 target;
+    };
+    vector<Pose> poses = {
+        { vec3(0.0f, 0.0f, 50.0f), vec3(0.0f, 0.0f, -400.0f) },   // looking over the ridge
+        { vec3(0.0f, 0.0f, -60.0f), vec3(0.0f, 0.0f, -400.0f) },   // on the slope of the ridge
+        { vec3(0.0f, 0.0f, 150.0f), vec3(400.0f, 0.0f, 150.0f) },  // towards the hill
+        { vec3(0.0f, 150.0f, 300.0f), vec3(0.0f, 0.0f, -300.0f) }, // high above, little occlusion
+    };
+    ThreadGroup threads(4);
+    vector<uint8_t> occluded, occludedThreaded;
+    for (auto& pose : poses) {
+        vec3 eye = pose.eye;
+        eye.y += terrain.height(eye.x, eye.z) + 1.8f;
+        mat4 proj = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+        proj[1][1] *= -1;
+        mat4 vp = proj * glm::lookAt(eye, pose.target, vec3(0.0f, 1.0f, 0.0f));
+        auto start = chrono::high_resolution_clock::now();
+        culling.render(vp);
+        culling.testBoxes(bounds, occluded);
+        double ms = chrono::duration<double, milli>(chrono::high_resolution_clock::now() - start).count();
+        threaded.render(vp, &threads);
+        threaded.testBoxes(bounds, occludedThreaded, &threads);
+        EXPECT_EQ(occluded, occludedThreaded);
+        culling.getStats().log();
+        Log("  pose eye " << eye.x << " " << eye.y << " " << eye.z << ": " << ms << " ms" << endl);
+        EXPECT_EQ(n, culling.getStats().tested);
+        // every occluded object has to be hidden by the real terrain
+        size_t wrong = 0;
+        for (size_t i = 0; i < n; i++) {
+            if (!occluded[i]) continue;
+            const ObjectBounds& b = bounds[i];
+            bool hidden = terrain.blocked(eye, (b.min + b.max) * 0.5f);
+            for (int c = 0; c < 8 && hidden; c++) {
+                vec3 p((c & 1) ? b.max.x : b.min.x, (c & 2) ? b.max.y : b.min.y, (c & 4) ? b.max.z : b.min.z);
+                hidden = terrain.blocked(eye, p);
+            }
+            if (!hidden) wrong++;
+        }
+        // coverage is sampled at pixel centers, a few objects just behind silhouettes may be hidden too early
+        EXPECT_LE(wrong, culling.getStats().occluded / 100 + 1);
+        // depth hierarchy holds the max of its children
+        for (int level = 1, w = culling.getWidth(), h = culling.getHeight(); level < culling.getLevelCount(); level++) {
+            for (int y = 0; y < h; y++) {
+                for (int x = 0; x < w; x++) {
+                    ASSERT_GE(culling.getDepth(x / 2, y / 2, level), culling.getDepth(x, y, level - 1));
+                }
+            }
+            w = (w + 1) / 2;
+            h = (h + 1) / 2;
+        }
+    }
+    // behind the ridge most objects are hidden, from high above only few
+    culling.render(glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 1000.0f)
+        * glm::lookAt(vec3(0.0f, terrain.height(0.0f, 50.0f) + 1.8f, 50.0f), vec3(0.0f, 0.0f, -400.0f), vec3(0.0f, 1.0f, 0.0f)));
+    culling.testBoxes(bounds, occluded);
+    EXPECT_GT(culling.getStats().occlusionRate(), 0.2f);
+}
+
+// addTerrainOccluder() adds the lower envelope: nothing visible over or beside the real ridge may be culled
+TEST(OcclusionCulling, TerrainEnvelopeConservative) {
+    OcclusionTestTerrain terrain;
+    OcclusionCulling envelope, full;
+    envelope.addHeightfieldEnvelopeOccluder(terrain.heights, OcclusionTestTerrain::SAMPLES, 4, OcclusionTestTerrain::MIN_XZ, OcclusionTestTerrain::MAX_XZ);
+    full.addHeightfieldOccluder(terrain.heights, OcclusionTestTerrain::SAMPLES, OcclusionTestTerrain::MIN_XZ, OcclusionTestTerrain::MAX_XZ);
+    EXPECT_EQ(32u * 32u * 2u, envelope.getOccluderTriangleCount());
+    // objects on and behind the ridge, some of them tall enough to be seen over the crest
+    const size_t n = 20000;
+    vector<ObjectBounds> bounds(n);
+    for (auto& b : bounds) {
+        float x = MathHelper::RandF(-300.0f, 300.0f), z = MathHelper::RandF(-400.0f, -60.0f);
+        float size = MathHelper::RandF(0.5f, 3.0f);
+        float tall = MathHelper::RandF(0.0f, 1.0f) < 0.3f ? MathHelper::RandF(10.0f, 60.0f) : 2.0f * size;
+        float y = terrain.height(x, z);
+        b.min = vec3(x - size, y, z - size);
+        b.max = vec3(x + size, y + tall, z + size);
+    }
+    vector<vec3> eyes = { vec3(100.0f, 20.0f, 80.0f), vec3(0.0f, 0.0f, 0.0f), vec3(0.0f, 0.0f, 50.0f) };
+    vector<uint8_t> occluded, occludedFull;
+    for (vec3 eye : eyes) {
+        eye.y += terrain.height(eye.x, eye.z) + 1.8f;
+        mat4 proj = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+        proj[1][1] *= -1;
+        mat4 vp = proj * glm::lookAt(eye, vec3(eye.x, 0.0f, -400.0f), vec3(0.0f, 1.0f, 0.0f));
+        envelope.render(vp);
+        envelope.testBoxes(bounds, occluded);
+        full.render(vp);
+        full.testBoxes(bounds, occludedFull);
+        envelope.getStats().log();
+        size_t visible = 0, visibleCulled = 0, notInFull = 0;
+        for (size_t i = 0; i < n; i++) {
+            const ObjectBounds& b = bounds[i];
+            bool hidden = terrain.blocked(eye, (b.min + b.max) * 0.5f);
+            for (int c = 0; c < 8 && hidden; c++) {
+                vec3 p((c & 1) ? b.max.x : b.min.x, (c & 2) ? b.max.y : b.min.y, (c & 4) ? b.max.z : b.min.z);
+                hidden = terrain.blocked(eye, p);
+            }
+            if (!hidden) {
+                visible++;
+                if (occluded[i]) visibleCulled++;
+            }
+            if (occluded[i] && !occludedFull[i]) notInFull++;
+        }
+        Log("  eye " << eye.x << " " << eye.y << " " << eye.z << ": " << visible << " visible" << endl);
+        EXPECT_GT(visible, 0u);
+        EXPECT_EQ(0u, visibleCulled);
+        // the envelope is below the full height field, so it can only hide less
+        EXPECT_EQ(0u, notInFull);
+    }
+    // still useful: from the valley floor (last eye) the lowered ridge hides many objects behind it
+    EXPECT_GT(envelope.getStats().occlusionRate(), 0.2f);
+}
+
+TEST(OcclusionCulling, Occluders) {
+    // wall 200 x 100 at z = -50
+    vector<vec3> wall = { vec3(-100.0f, 0.0f, -50.0f), vec3(100.0f, 0.0f, -50.0f), vec3(100.0f, 100.0f, -50.0f), vec3(-100.0f, 100.0f, -50.0f) };
+    vector<uint32_t> indices = { 0, 1, 2, 0, 2, 3 };
+    OcclusionCulling culling;
+    culling.addOccluder(wall, indices);
+    mat4 proj = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+    mat4 vp = proj * glm::lookAt(vec3(0.0f, 10.0f, 0.0f), vec3(0.0f, 10.0f, -1.0f), vec3(0.0f, 1.0f, 0.0f));
+    culling.render(vp);
+    EXPECT_TRUE(culling.isOccluded(vec3(-5.0f, 0.0f, -90.0f), vec3(5.0f, 10.0f, -80.0f)));
+    // in front of the wall, crossing the wall, beside and above the wall
+    EXPECT_FALSE(culling.isOccluded(vec3(-5.0f, 0.0f, -30.0f), vec3(5.0f, 10.0f, -20.0f)));
+    EXPECT_FALSE(culling.isOccluded(vec3(-5.0f, 0.0f, -60.0f), vec3(5.0f, 10.0f, -40.0f)));
+    EXPECT_FALSE(culling.isOccluded(vec3(110.0f, 0.0f, -90.0f), vec3(130.0f, 10.0f, -80.0f)));
+    EXPECT_FALSE(culling.isOccluded(vec3(-5.0f, 200.0f, -200.0f), vec3(5.0f, 210.0f, -190.0f)));
+    // crossing the near plane or behind the camera
+    EXPECT_FALSE(culling.isOccluded(vec3(-1.0f, 9.0f, -1.0f), vec3(1.0f, 11.0f, 1.0f)));
+    EXPECT_FALSE(culling.isOccluded(vec3(-5.0f, 0.0f, 80.0f), vec3(5.0f, 10.0f, 90.0f)));
+    // wall partly behind the camera is clipped at the near plane and still occludes
+    OcclusionCulling side;
+    vector<vec3> longWall = { vec3(-10.0f, 0.0f, 100.0f), vec3(-10.0f, 0.0f, -300.0f), vec3(-10.0f, 100.0f, -300.0f), vec3(-10.0f, 100.0f, 100.0f) };
+    side.addOccluder(longWall, indices);
+    side.render(proj * glm::lookAt(vec3(0.0f, 10.0f, 0.0f), vec3(-20.0f, 10.0f, -20.0f), vec3(0.0f, 1.0f, 0.0f)));
+    EXPECT_TRUE(side.isOccluded(vec3(-40.0f, 5.0f, -30.0f), vec3(-30.0f, 15.0f, -20.0f)));
+    EXPECT_FALSE(side.isOccluded(vec3(-5.0f, 5.0f, -30.0f), vec3(-2.0f, 15.0f, -20.0f)));
+    // camera close to the wall
+    culling.render(proj * glm::lookAt(vec3(0.0f, 10.0f, -49.0f), vec3(0.0f, 10.0f, -50.0f), vec3(0.0f, 1.0f, 0.0f)));
+    EXPECT_TRUE(culling.isOccluded(vec3(-5.0f, 5.0f, -90.0f), vec3(5.0f, 15.0f, -80.0f)));
+    culling.clearOccluders();
+    culling.render(vp);
+    EXPECT_FALSE(culling.isOccluded(vec3(-5.0f, 0.0f, -90.0f), vec3(5.0f, 10.0f, -80.0f)));
+    EXPECT_EQ(0u, culling.getStats().occluderTriangles);
+}
+
+// rolling hills over a 2048 x 2048 world, optionally with detail that only high resolution heightmaps resolve
+static vector<float> terrainLodHeights(int samples, bool detail) {
+    vector<float> h(samples * samples);
+    float step = 2048.0f / (samples - 1);
+    for (int z = 0; z < samples; z++) {
+        for (int x = 0; x < samples; x++) {
+            float wx = -1024.0f + x * step, wz = -1024.0f + z * step;
+            h[z * samples + x] = 100.0f * sin(wx * 0.01f) * cos(wz * 0.013f) + 20.0f * sin(wx * 0.07f + wz * 0.05f);
+            if (detail) h[z * samples + x] += 3.0f * sin(wx * 0.5f) * sin(wz * 0.45f);
+        }
+    }
+    return h;
+}
+
+// frustum that contains everything
+static Frustum terrainLodFullFrustum() {
+    Frustum f;
+    for (auto& p : f.planes) p = vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    return f;
+}
+
+TEST(TerrainLod, BuildChunks) {
+    TerrainLod terrain;
+    terrain.init(terrainLodHeights(513, true), 513, -1024.0f, 1024.0f);
+    // 16 x 16 chunks of 32 quads on level 0
+    ASSERT_EQ(5, terrain.getLevelCount());
+    EXPECT_EQ(16, terrain.getNodesPerEdge(0));
+    EXPECT_EQ(1, terrain.getNodesPerEdge(4));
+    EXPECT_FLOAT_EQ(4.0f, terrain.getCellSize());
+    // errors grow with level, ranges at least double and respect the screen error of the next level
+    EXPECT_EQ(0.0f, terrain.getGeometricError(0));
+    for (int level = 1; level < terrain.getLevelCount(); level++) {
+        EXPECT_GE(terrain.getGeometricError(level), terrain.getGeometricError(level - 1));
+        EXPECT_GE(terrain.getRange(level), 2.0f * terrain.getRange(level - 1));
+        float pixelsPerUnit = 1080.0f / (2.0f * tan(glm::radians(45.0f) * 0.5f));
+        EXPECT_GE(terrain.getRange(level - 1) * 1.0001f, terrain.getGeometricError(level) * pixelsPerUnit / 2.0f);
+    }
+    EXPECT_GT(terrain.getGeometricError(1), 0.0f);
+    // node bounds contain all heights
+    vec3 min, max;
+    terrain.getNodeBounds(4, 0, 0, min, max);
+    EXPECT_FLOAT_EQ(-1024.0f, min.x);
+    EXPECT_FLOAT_EQ(1024.0f, max.z);
+    for (int z = 0; z < 513; z += 7) {
+        for (int x = 0; x < 513; x += 5) {
+            ASSERT_GE(terrain.getSampleHeight(x, z), min.y);
+            ASSERT_LE(terrain.getSampleHeight(x, z), max.y);
+        }
+    }
+    // shared topology, split into quadrants
+    const auto& indices = terrain.getChunkIndices();
+    EXPECT_EQ(32u * 32u * 6u, indices.size());
+    for (uint32_t i : indices) ASSERT_LT(i, terrain.getChunkVertexCount());
+    // level 2 chunk: every 4th sample, morphed layout is the level 3 grid
+    vector<TerrainChunkVertex> chunk;
+    terrain.buildChunk(terrain.getNodeIndex(2, 1, 2), chunk);
+    ASSERT_EQ(33u * 33u, chunk.size());
+    for (int gz = 0; gz <= 32; gz++) {
+        for (int gx = 0; gx <= 32; gx++) {
+            const TerrainChunkVertex& v = chunk[gz * 33 + gx];
+            int fx = 32 * 4 + gx * 4, fz = 2 * 32 * 4 + gz * 4;
+            ASSERT_FLOAT_EQ(terrain.getSampleHeight(fx, fz), v.pos.y);
+            ASSERT_NEAR(-1024.0f + fx * 4.0f, v.pos.x, 1e-3f);
+            EXPECT_GT(v.normal.y, 0.0f);
+            EXPECT_EQ(TerrainLod::morph(v, 0.0f), v.pos);
+            vec3 m = TerrainLod::morph(v, 1.0f);
+            // on the coarse grid with coarse heights
+            int mx = (int)round((m.x + 1024.0f) / 4.0f), mz = (int)round((m.z + 1024.0f) / 4.0f);
+            ASSERT_EQ(0, mx % 8);
+            ASSERT_EQ(0, mz % 8);
+            ASSERT_NEAR(terrain.getSampleHeight(mx, mz), m.y, 1e-4f);
+            if (gx % 2 == 0 && gz % 2 == 0) {
+                ASSERT_EQ(v.pos, m);
+            }
+        }
+    }
+}
+
+TEST(TerrainLod, Selection) {
+    TerrainLod terrain;
+    TerrainLodSettings settings;
+    settings.cacheSlots = 256;
+    terrain.init(terrainLodHeights(513, false), 513, -1024.0f, 1024.0f, settings);
+    Frustum all = terrainLodFullFrustum();
+    int leafs = terrain.getNodesPerEdge(0);
+    vector<vec3> cameras = { vec3(0.0f, 0.0f, 0.0f), vec3(-900.0f, 0.0f, 700.0f), vec3(300.0f, 0.0f, -1000.0f), vec3(1000.0f, 0.0f, 1000.0f) };
+    uint32_t maxSelected = 0;
+    for (vec3 cam : cameras) {
+        cam.y = terrain.getSampleHeight((int)((cam.x + 1024.0f) / 4.0f), (int)((cam.z + 1024.0f) / 4.0f)) + 2.0f;
+        const auto& sel = terrain.select(cam, all);
+        maxSelected = std::max(maxSelected, (uint32_t)sel.size());
+        // every level 0 area is covered exactly once
+        vector<int> level(leafs * leafs, -1), owner(leafs * leafs, -1);
+        for (int s = 0; s < (int)sel.size(); s++) {
+            const auto& n = sel[s];
+            int span = 1 << n.level;
+            for (int q = 0; q < 4; q++) {
+                if (!(n.quadrants & (1 << q))) continue;
+                int half = n.level == 0 ? 1 : span / 2;
+                int x0 = n.x * span + (n.level == 0 ? 0 : (q & 1) * half), z0 = n.z * span + (n.level == 0 ? 0 : (q >> 1) * half);
+                for (int z = z0; z < z0 + half; z++) {
+                    for (int x = x0; x < x0 + half; x++) {
+                        ASSERT_EQ(-1, level[z * leafs + x]);
+                        level[z * leafs + x] = n.level;
+                        owner[z * leafs + x] = s;
+                    }
+                }
+                if (n.level == 0) break;
+            }
+            EXPECT_LT(n.morphStart, n.morphEnd);
+        }
+        for (int l : level) ASSERT_GE(l, 0);
+        // neighbours differ by at most one level, finer chunk is fully morphed on the shared edge
+        vector<TerrainChunkVertex> chunk;
+        for (int z = 0; z < leafs; z++) {
+            for (int x = 0; x < leafs; x++) {
+                for (int d = 0; d < 2; d++) {
+                    int nx = x + (d == 0), nz = z + (d == 1);
+                    if (nx >= leafs || nz >= leafs) continue;
+                    int a = z * leafs + x, b = nz * leafs + nx;
+                    ASSERT_LE(abs(level[a] - level[b]), 1);
+                    if (level[a] == level[b]) continue;
+                    const auto& fine = sel[level[a] < level[b] ? owner[a] : owner[b]];
+                    terrain.buildChunk(fine.node, chunk);
+                    // edge between leaf cells a and b
+                    float leafSize = 32.0f * 4.0f;
+                    float ex = -1024.0f + nx * leafSize, ez = -1024.0f + nz * leafSize;
+                    for (const auto& v : chunk) {
+                        bool onEdge = d == 0 ? (abs(v.pos.x - ex) < 0.01f && v.pos.z >= ez - 0.01f && v.pos.z <= ez + leafSize + 0.01f)
+                            : (abs(v.pos.z - ez) < 0.01f && v.pos.x >= ex - 0.01f && v.pos.x <= ex + leafSize + 0.01f);
+                        if (!onEdge) continue;
+                        ASSERT_FLOAT_EQ(1.0f, TerrainLod::morphFactor(fine, length(v.pos - cam)));
+                    }
+                }
+            }
+        }
+        // finest level around the camera
+        int cx = std::clamp((int)((cam.x + 1024.0f) / 128.0f), 0, leafs - 1), cz = std::clamp((int)((cam.z + 1024.0f) / 128.0f), 0, leafs - 1);
+        EXPECT_EQ(0, level[cz * leafs + cx]);
+        // chunk cache: second frame with same selection builds nothing
+        terrain.updateChunks();
+        for (const auto& n : sel) ASSERT_LT(n.slot, settings.cacheSlots);
+        terrain.updateChunks();
+        EXPECT_EQ(0u, terrain.getStats().chunksBuilt);
+        EXPECT_LE(terrain.getResidentChunkCount(), settings.cacheSlots);
+    }
+    EXPECT_GT(terrain.getStats().chunksEvicted + terrain.getResidentChunkCount(), 0u);
+
+    // view frustum removes chunks behind the camera
+    vec3 cam(0.0f, terrain.getSampleHeight(256, 256) + 2.0f, 0.0f);
+    size_t allCount = terrain.select(cam, all).size();
+    mat4 proj = glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 5000.0f);
+    Frustum view = Frustum::fromViewProjection(proj * glm::lookAt(cam, cam + vec3(0.0f, 0.0f, -1.0f), vec3(0.0f, 1.0f, 0.0f)));
+    size_t viewCount = terrain.select(cam, view).size();
+    EXPECT_LT(viewCount, allCount);
+    EXPECT_GT(terrain.getStats().culled, 0u);
+    for (const auto& n : terrain.getSelection()) {
+        EXPECT_NE(0, view.test((n.min + n.max) * 0.5f, (n.max - n.min) * 0.5f));
+    }
+
+    // 16x heightmap resolution of the same terrain: more levels, but about the same number of chunks per frame
+    TerrainLod fine;
+    fine.init(terrainLodHeights(2049, false), 2049, -1024.0f, 1024.0f, settings);
+    EXPECT_EQ(7, fine.getLevelCount());
+    size_t fineCount = fine.select(cam, view).size();
+    Log("Terrain LOD chunks in view: 513 heightmap " << viewCount << ", 2049 heightmap " << fineCount << ", max all around " << maxSelected << endl);
+    EXPECT_LE(fineCount, viewCount * 2);
+}
+
+// chunk slots read by frames in flight are not overwritten: a slot is rebuilt at least slotReuseFrames updates after its last use
+TEST(TerrainLod, DelayedSlotReuse) {
+    TerrainLodSettings settings;
+    settings.slotReuseFrames = 3;
+    vector<float> heights = terrainLodHeights(513, false);
+    Frustum all = terrainLodFullFrustum();
+    // camera flies diagonally over the terrain
+    vector<vec3> path;
+    for (int i = 0; i <= 200; i++) {
+        float t = -1000.0f + 10.0f * i;
+        path.push_back(vec3(t, 50.0f, t * 0.8f));
+    }
+    TerrainLod probe;
+    probe.init(heights, 513, -1024.0f, 1024.0f, settings);
+    // just enough for the selections of the frames that may still read their slots:
+    // max number of different nodes within slotReuseFrames consecutive frames
+    vector<vector<uint32_t>> selected;
+    size_t maxWindow = 0;
+    for (vec3 cam : path) {
+        selected.emplace_back();
+        for (const auto& n : probe.select(cam, all)) selected.back().push_back(n.node);
+        unordered_set<uint32_t> window;
+        for (size_t i = selected.size() - std::min(selected.size(), (size_t)settings.slotReuseFrames); i < selected.size(); i++) {
+            window.insert(selected[i].begin(), selected[i].end());
+        }
+        maxWindow = std::max(maxWindow, window.size());
+    }
+    settings.cacheSlots = static_cast<uint32_t>(maxWindow);
+    TerrainLod terrain;
+    terrain.init(heights, 513, -1024.0f, 1024.0f, settings);
+    vector<uint32_t> slotNode(settings.cacheSlots, UINT32_MAX);
+    vector<int> slotLastUsed(settings.cacheSlots, -1);
+    uint32_t evicted = 0;
+    for (int frame = 0; frame < (int)path.size(); frame++) {
+        terrain.select(path[frame], all);
+        terrain.updateChunks();
+        evicted += terrain.getStats().chunksEvicted;
+        for (const auto& n : terrain.getSelection()) {
+            ASSERT_LT(n.slot, settings.cacheSlots);
+            if (slotNode[n.slot] != n.node && slotLastUsed[n.slot] >= 0) {
+                EXPECT_GE(frame - slotLastUsed[n.slot], (int)settings.slotReuseFrames);
+            }
+            slotNode[n.slot] = n.node;
+        }
+        for (const auto& n : terrain.getSelection()) slotLastUsed[n.slot] = frame;
+    }
+    EXPECT_GT(evicted, 0u);
+}
+
+// hills with noise on a 1024 x 1024 grid, every third cell with flipped diagonal
+struct RaycastTestTerrain {
+    int samples;
+    float minXZ = -512.0f, maxXZ = 512.0f;
+    vector<float> heights;
+    vector<uint8_t> flipped;
+    RaycastTestTerrain(int samples) : samples(samples) {
+        heights.resize(samples * samples);
+        float step = (maxXZ - minXZ) / (samples - 1);
+        for (int z = 0; z < samples; z++) {
+            for (int x = 0; x < samples; x++) {
+                float wx = minXZ + x * step, wz = minXZ + z * step;
+                heights[z * samples + x] = 50.0f * sin(wx * 0.01f) * cos(wz * 0.013f) + MathHelper::RandF(0.0f, 4.0f);
+            }
+        }
+        flipped.resize((samples - 1) * (samples - 1));
+        for (size_t i = 0; i < flipped.size(); i++) flipped[i] = i % 3 == 0 ? 1 : 0;
+    }
+    // nearest hit by testing every triangle: ray - plane intersection and point in triangle in xz
+    bool bruteForce(const HeightmapRaycast& raycast, const HeightmapRay& ray, float& distance, vec3& normal) const {
+        distance = numeric_limits<float>::max();
+        for (int z = 0; z < samples - 1; z++) {
+            for (int x = 0; x < samples - 1; x++) {
+                vec3 tri[6];
+                raycast.getCellTriangles(x, z, tri);
+                for (int i = 0; i < 6; i += 3) {
+                    vec3 n = normalize(cross(tri[i + 1] - tri[i], tri[i + 2] - tri[i]));
+                    float denom = dot(ray.direction, n);
+                    if (abs(denom) < 1e-8f) continue;
+                    float t = dot(tri[i] - ray.origin, n) / denom;
+                    if (t < 0.0f || t > ray.maxDistance || t >= distance) continue;
+                    vec3 p = ray.origin + ray.direction * t;
+                    auto side = [&p](const vec3& a, const vec3& b) { return (b.x - a.x) * (p.z - a.z) - (b.z - a.z) * (p.x - a.x); };
+                    float s0 = side(tri[i], tri[i + 1]), s1 = side(tri[i + 1], tri[i + 2]), s2 = side(tri[i + 2], tri[i]);
+                    const float eps = 1e-4f;
+                    if ((s0 >= -eps && s1 >= -eps && s2 >= -eps) || (s0 <= eps && s1 <= eps && s2 <= eps)) {
+                        distance = t;
+                        normal = n.y < 0.0f ? -n : n;
+                    }
+                }
+            }
+        }
+        return distance != numeric_limits<float>::max();
+    }
+    float surface(const HeightmapRaycast& raycast, float wx, float wz) const {
+        HeightmapRay down;
+        down.origin = vec3(wx, 10000.0f, wz);
+        HeightmapHit hit;
+        raycast.intersect(down, hit);
+        return hit.pos.y;
+    }
+    HeightmapRay randomRay(const HeightmapRaycast& raycast) const {
+        HeightmapRay ray;
+        float wx = MathHelper::RandF(minXZ * 1.2f, maxXZ * 1.2f), wz = MathHelper::RandF(minXZ * 1.2f, maxXZ * 1.2f);
+        float above = MathHelper::RandF(0.5f, 100.0f);
+        ray.origin = vec3(wx, 60.0f + above, wz);
+        if (abs(wx) < maxXZ && abs(wz) < maxXZ) ray.origin.y = surface(raycast, wx, wz) + above;
+        // mostly flat rays, some straight down or exactly horizontal
+        vec3 d(MathHelper::RandF(-1.0f, 1.0f), MathHelper::RandF(-0.4f, 0.1f), MathHelper::RandF(-1.0f, 1.0f));
+        int kind = static_cast<int>(MathHelper::RandF(0.0f, 10.0f));
+        if (kind == 0) d = vec3(0.0f, -1.0f, 0.0f);
+        if (kind == 1) d.y = 0.0f;
+        if (kind == 2) d.x = 0.0f;
+        ray.direction = normalize(d);
+        ray.maxDistance = MathHelper::RandF(50.0f, 2000.0f);
+        return ray;
+    }
+};
+
+TEST(HeightmapRaycast, BruteForce) {
+    RaycastTestTerrain terrain(65);
+    HeightmapRaycast raycast;
+    raycast.init(terrain.heights, terrain.samples, terrain.minXZ, terrain.maxXZ, terrain.flipped);
+    EXPECT_EQ(64, raycast.getCells());
+    EXPECT_EQ(7, raycast.getLevelCount());
+    EXPECT_EQ(1, raycast.getLevelSize(6));
+    // pyramid: root holds overall min and max
+    float minH = *min_element(terrain.heights.begin(), terrain.heights.end());
+    float maxH = *max_element(terrain.heights.begin(), terrain.heights.end());
+    EXPECT_EQ(minH, raycast.getMinHeight(6, 0, 0));
+    EXPECT_EQ(maxH, raycast.getMaxHeight(6, 0, 0));
+
+    int hits = 0;
+    for (int i = 0; i < 3000; i++) {
+        HeightmapRay ray = terrain.randomRay(raycast);
+        HeightmapHit hit;
+        float distance;
+        vec3 normal;
+        bool expected = terrain.bruteForce(raycast, ray, distance, normal);
+        bool found = raycast.intersect(ray, hit);
+        ASSERT_EQ(expected, found) << "ray " << i;
+        EXPECT_EQ(found, hit.hit);
+        if (!found) continue;
+        hits++;
+        EXPECT_NEAR(distance, hit.distance, 1e-3f * std::max(1.0f, distance)) << "ray " << i;
+        EXPECT_GT(dot(normal, hit.normal), 0.999f) << "ray " << i;
+        EXPECT_GT(hit.normal.y, 0.0f);
+        vec3 expectedPos = ray.origin + ray.direction * distance;
+        EXPECT_LT(length(expectedPos - hit.pos), 1e-2f);
+    }
+    EXPECT_GT(hits, 1000);
+
+    // line of sight between points above the terrain
+    for (int i = 0; i < 1000; i++) {
+        vec3 from = terrain.randomRay(raycast).origin, to = terrain.randomRay(raycast).origin;
+        from.x = std::clamp(from.x, -500.0f, 500.0f); from.z = std::clamp(from.z, -500.0f, 500.0f);
+        to.x = std::clamp(to.x, -500.0f, 500.0f); to.z = std::clamp(to.z, -500.0f, 500.0f);
+        from.y = terrain.surface(raycast, from.x, from.z) + 1.0f;
+        to.y = terrain.surface(raycast, to.x, to.z) + 1.0f;
+        HeightmapRay ray;
+        ray.origin = from;
+        ray.direction = normalize(to - from);
+        ray.maxDistance = length(to - from);
+        float distance;
+        vec3 normal;
+        EXPECT_EQ(terrain.bruteForce(raycast, ray, distance, normal), raycast.isLineBlocked(from, to)) << "line " << i;
+    }
+
+    // batched version gives the same results
+    vector<HeightmapRay> rays(5000);
+    for (auto& r : rays) r = terrain.randomRay(raycast);
+    vector<HeightmapHit> batch(rays.size());
+    ThreadGroup threads(4);
+    raycast.intersect(rays, batch, &threads);
+    for (size_t i = 0; i < rays.size(); i++) {
+        HeightmapHit single;
+        raycast.intersect(rays[i], single);
+        ASSERT_EQ(single.hit, batch[i].hit);
+        EXPECT_EQ(single.distance, batch[i].distance);
+    }
+}
+
+TEST(HeightmapRaycast, Benchmark) {
+    RaycastTestTerrain terrain(1025);
+    HeightmapRaycast raycast;
+    raycast.init(terrain.heights, terrain.samples, terrain.minXZ, terrain.maxXZ);
+    vector<HeightmapRay> rays(200000);
+    for (auto& r : rays) r = terrain.randomRay(raycast);
+    vector<HeightmapHit> hits(rays.size());
+    ThreadGroup threads(4);
+    auto measure = [](auto&& pass) {
+        double best = numeric_limits<double>::max();
+        for (int run = 0; run < 3; run++) {
+            auto start = chrono::high_resolution_clock::now();
+            pass();
+            best = std::min(best, chrono::duration<double>(chrono::high_resolution_clock::now() - start).count());
+        }
+        return best;
+    };
+    double single = measure([&] { raycast.intersect(rays, hits); });
+    double batched = measure([&] { raycast.intersect(rays, hits, &threads); });
+    size_t hitCount = count_if(hits.begin(), hits.end(), [](const HeightmapHit& h) { return h.hit; });
+    Log("Heightmap raycast on 1024 x 1024 cells (rays per second): single thread " << (size_t)(rays.size() / single)
+        << ", 4 threads " << (size_t)(rays.size() / batched) << ", hits " << hitCount << endl);
+    EXPECT_GT(hitCount, 0u);
+}
+
+static ObjectBounds broadphaseRandomBox(float worldHalf, float maxSize) {
+    vec3 c(MathHelper::RandF(-worldHalf, worldHalf), MathHelper::RandF(0.0f, 50.0f), MathHelper::RandF(-worldHalf, worldHalf));
+    vec3 e(MathHelper::RandF(0.1f, maxSize), MathHelper::RandF(0.1f, maxSize), MathHelper::RandF(0.1f, maxSize));
+    return ObjectBounds{ c - e, c + e };
+}
+
+TEST(Broadphase, BruteForce) {
+    const int n = 2000;
+    Broadphase broadphase;
+    broadphase.init(-512.0f, 512.0f, 16.0f);
+    EXPECT_EQ(64, broadphase.getCellsPerEdge());
+    // some objects outside the grid are clamped to border cells
+    vector<ObjectBounds> boxes(n);
+    vector<uint32_t> proxies(n);
+    vector<bool> alive(n, true);
+    for (int i = 0; i < n; i++) {
+        boxes[i] = broadphaseRandomBox(600.0f, 12.0f);
+        proxies[i] = broadphase.add(boxes[i], i);
+    }
+    auto bruteForceRay = [&](const vec3& o, const vec3& d, float maxDistance, const std::function<bool(uint32_t)>& filter) {
+        BroadphaseHit best;
+        vec3 inv = vec3(1.0f) / d;
+        for (int i = 0; i < n; i++) {
+            float t;
+            if (!alive[i] || (filter && !filter(i))) continue;
+            if (Broadphase::intersectRayBox(o, inv, maxDistance, boxes[i], t) && t < best.distance) {
+                best.hit = true;
+                best.distance = t;
+                best.userData = i;
+            }
+        }
+        return best;
+    };
+    auto checkAll = [&]() {
+        // pairs
+        vector<pair<uint32_t, uint32_t>> pairs;
+        broadphase.findPairs(pairs);
+        set<pair<uint32_t, uint32_t>> found;
+        for (auto p : pairs) {
+            if (p.first > p.second) std::swap(p.first, p.second);
+            EXPECT_TRUE(found.insert(p).second) << "pair reported twice";
+        }
+        size_t expectedPairs = 0;
+        for (int i = 0; i < n; i++) {
+            for (int j = i + 1; j < n; j++) {
+                if (!alive[i] || !alive[j] || !Broadphase::overlaps(boxes[i], boxes[j])) continue;
+                expectedPairs++;
+                EXPECT_TRUE(found.count({ (uint32_t)i, (uint32_t)j })) << "missing pair " << i << " " << j;
+            }
+        }
+        EXPECT_EQ(expectedPairs, found.size());
+        // rays, every second one skips odd objects
+        for (int r = 0; r < 500; r++) {
+            vec3 o(MathHelper::RandF(-700.0f, 700.0f), MathHelper::RandF(0.0f, 60.0f), MathHelper::RandF(-700.0f, 700.0f));
+            vec3 d = normalize(vec3(MathHelper::RandF(-1.0f, 1.0f), MathHelper::RandF(-0.1f, 0.1f), MathHelper::RandF(-1.0f, 1.0f)));
+            if (r % 10 == 0) d = vec3(1.0f, 0.0f, 0.0f);
+            float maxDistance = r % 3 == 0 ? numeric_limits<float>::max() : MathHelper::RandF(10.0f, 800.0f);
+            std::function<bool(uint32_t)> filter = nullptr;
+            if (r % 2) filter = [](uint32_t i) { return i % 2 == 0; };
+            BroadphaseHit expected = bruteForceRay(o, d, maxDistance, filter), hit;
+            ASSERT_EQ(expected.hit, broadphase.raycast(o, d, maxDistance, hit, filter)) << "ray " << r;
+            if (expected.hit) {
+                EXPECT_EQ(expected.distance, hit.distance);
+                EXPECT_TRUE(alive[hit.userData]);
+            }
+        }
+        // box queries
+        for (int q = 0; q < 100; q++) {
+            ObjectBounds box = broadphaseRandomBox(600.0f, 40.0f);
+            vector<uint32_t> result;
+            broadphase.query(box, result);
+            size_t expected = 0;
+            for (int i = 0; i < n; i++) {
+                if (alive[i] && Broadphase::overlaps(boxes[i], box)) expected++;
+            }
+            EXPECT_EQ(expected, result.size());
+        }
+    };
+    checkAll();
+
+    // move all objects a little, some far, remove and add some
+    for (int i = 0; i < n; i++) {
+        vec3 delta = i % 10 == 0 ? vec3(MathHelper::RandF(-300.0f, 300.0f), 0.0f, MathHelper::RandF(-300.0f, 300.0f))
+            : vec3(MathHelper::RandF(-5.0f, 5.0f), 0.0f, MathHelper::RandF(-5.0f, 5.0f));
+        boxes[i].min += delta;
+        boxes[i].max += delta;
+        broadphase.update(proxies[i], boxes[i]);
+    }
+    for (int i = 0; i < n; i += 7) {
+        broadphase.remove(proxies[i]);
+        alive[i] = false;
+    }
+    for (int i = 0; i < n; i += 14) {
+        boxes[i] = broadphaseRandomBox(600.0f, 12.0f);
+        proxies[i] = broadphase.add(boxes[i], i);
+        alive[i] = true;
+    }
+    EXPECT_EQ((size_t)count(alive.begin(), alive.end(), true), broadphase.size());
+    checkAll();
+}
+
+TEST(Broadphase, Benchmark) {
+    const int n = 100000;
+    const float worldHalf = 1024.0f;
+    Broadphase broadphase;
+    broadphase.init(-worldHalf, worldHalf, 16.0f);
+    vector<ObjectBounds> boxes(n);
+    vector<vec3> velocity(n);
+    vector<uint32_t> proxies(n);
+    for (int i = 0; i < n; i++) {
+        boxes[i] = broadphaseRandomBox(worldHalf, 1.5f);
+        velocity[i] = vec3(MathHelper::RandF(-10.0f, 10.0f), 0.0f, MathHelper::RandF(-10.0f, 10.0f));
+        proxies[i] = broadphase.add(boxes[i], i);
+    }
+    const int frames = 10, raysPerFrame = 1000;
+    const float dt = 1.0f / 60.0f;
+    double updateMs = 0.0, pairsMs = 0.0, raysMs = 0.0, bruteRaysMs = 0.0;
+    size_t pairCount = 0, hits = 0;
+    vector<pair<uint32_t, uint32_t>> pairs;
+    for (int f = 0; f < frames; f++) {
+        auto start = chrono::high_resolution_clock::now();
+        for (int i = 0; i < n; i++) {
+            vec3 d = velocity[i] * dt;
+            boxes[i].min += d;
+            boxes[i].max += d;
+            broadphase.update(proxies[i], boxes[i]);
+        }
+        auto updated = chrono::high_resolution_clock::now();
+        broadphase.findPairs(pairs);
+        pairCount += pairs.size();
+        auto paired = chrono::high_resolution_clock::now();
+        vector<vec3> origins(raysPerFrame), dirs(raysPerFrame);
+        for (int r = 0; r < raysPerFrame; r++) {
+            origins[r] = vec3(MathHelper::RandF(-worldHalf, worldHalf), 25.0f, MathHelper::RandF(-worldHalf, worldHalf));
+            dirs[r] = normalize(vec3(MathHelper::RandF(-1.0f, 1.0f), 0.0f, MathHelper::RandF(-1.0f, 1.0f)));
+        }
+        auto raysStart = chrono::high_resolution_clock::now();
+        for (int r = 0; r < raysPerFrame; r++) {
+            BroadphaseHit hit;
+            if (broadphase.raycast(origins[r], dirs[r], 2000.0f, hit)) hits++;
+        }
+        auto raysEnd = chrono::high_resolution_clock::now();
+        // linear loop over all objects, like before the broadphase. Only a few rays, it is slow
+        for (int r = 0; r < 10; r++) {
+            vec3 inv = vec3(1.0f) / dirs[r];
+            float best = numeric_limits<float>::max(), t;
+            for (int i = 0; i < n; i++) {
+                if (Broadphase::intersectRayBox(origins[r], inv, 2000.0f, boxes[i], t)) best = std::min(best, t);
+            }
+            BroadphaseHit hit;
+            broadphase.raycast(origins[r], dirs[r], 2000.0f, hit);
+            EXPECT_EQ(best, hit.distance);
+        }
+        auto bruteEnd = chrono::high_resolution_clock::now();
+        updateMs += chrono::duration<double, milli>(updated - start).count();
+        pairsMs += chrono::duration<double, milli>(paired - updated).count();
+        raysMs += chrono::duration<double, milli>(raysEnd - raysStart).count();
+        bruteRaysMs += chrono::duration<double, milli>(bruteEnd - raysEnd).count();
+    }
+    Log("Broadphase with " << n << " moving objects, per frame: update " << updateMs / frames << " ms, pairs " << pairsMs / frames
+        << " ms (" << pairCount / frames << " pairs), " << raysPerFrame << " rays " << raysMs / frames << " ms" << endl);
+    Log("Nearest hit per ray: broadphase " << raysMs / (frames * raysPerFrame) << " ms, linear loop " << bruteRaysMs / (frames * 10) << " ms" << endl);
+    EXPECT_GT(hits, 0u);
+}
+
+// hills for scatter tests, up to 60m high
+static float scatterTestHeight(float x, float z) {
+    return 30.0f + 30.0f * sin(x * 0.02f) * cos(z * 0.015f);
+}
+
+static void scatterTestLayers(ScatterSettings& settings, vector<ScatterLayer>& layers) {
+    settings.seed = 1234;
+    settings.minXZ = -256.0f;
+    settings.maxXZ = 256.0f;
+    settings.height = scatterTestHeight;
+    // big rocks below 40m on gentle slopes, small rocks everywhere except the east half with density falling off to the north
+    ScatterLayer big;
+    big.radius = 12.0f;
+    big.maxHeight = 40.0f;
+    big.maxSlope = radians(25.0f);
+    big.userData = 7;
+    ScatterLayer small;
+    small.radius = 3.0f;
+    small.density = [](float x, float z) { return x > 0.0f ? 0.0f : std::clamp((z + 256.0f) / 512.0f, 0.0f, 1.0f); };
+    small.userData = 8;
+    layers = { big, small };
+}
+
+TEST(PoissonScatter, MinimumDistance) {
+    ScatterSettings settings;
+    vector<ScatterLayer> layers;
+    scatterTestLayers(settings, layers);
+    vector<ScatterPoint> points;
+    PoissonScatter scatter;
+    ThreadGroup threads(4);
+    scatter.generate(settings, layers, points, &threads);
+    EXPECT_GE(scatter.getTileSize(), 12.0f);
+    size_t counts[2] = { 0, 0 };
+    size_t southSmall = 0, northSmall = 0;
+    for (size_t i = 0; i < points.size(); i++) {
+        const ScatterPoint& p = points[i];
+        ASSERT_LT(p.layer, 2u);
+        counts[p.layer]++;
+        EXPECT_EQ(layers[p.layer].userData, p.userData);
+        EXPECT_GE(p.pos.x, settings.minXZ);
+        EXPECT_LE(p.pos.x, settings.maxXZ);
+        EXPECT_GE(p.pos.z, settings.minXZ);
+        EXPECT_LE(p.pos.z, settings.maxXZ);
+        EXPECT_EQ(scatterTestHeight(p.pos.x, p.pos.z), p.pos.y);
+        if (p.layer == 0) {
+            EXPECT_LE(p.pos.y, 40.0f);
+            // slope by central differences like the scatter
+            float dx = (scatterTestHeight(p.pos.x + 1.0f, p.pos.z) - scatterTestHeight(p.pos.x - 1.0f, p.pos.z)) / 2.0f;
+            float dz = (scatterTestHeight(p.pos.x, p.pos.z + 1.0f) - scatterTestHeight(p.pos.x, p.pos.z - 1.0f)) / 2.0f;
+            EXPECT_LE(atan(sqrt(dx * dx + dz * dz)), radians(25.0f) + 1e-3f);
+        } else {
+            EXPECT_LE(p.pos.x, 0.0f);
+            if (p.pos.z < -128.0f) southSmall++;
+            if (p.pos.z > 128.0f) northSmall++;
+        }
+        // minimum distance against all other points
+        for (size_t j = i + 1; j < points.size(); j++) {
+            float r = std::max(layers[p.layer].radius, layers[points[j].layer].radius);
+            float d = length(vec2(p.pos.x - points[j].pos.x, p.pos.z - points[j].pos.z));
+            ASSERT_GE(d, r) << "points " << i << " " << j;
+        }
+    }
+    Log("Poisson scatter: " << counts[0] << " big, " << counts[1] << " small points" << endl);
+    EXPECT_GT(counts[0], 50u);
+    EXPECT_GT(counts[1], 500u);
+    // density 0.75 .. 1 in the north, 0 .. 0.25 in the south
+    EXPECT_GT(northSmall, southSmall * 2);
+}
+
+TEST(PoissonScatter, Determinism) {
+    ScatterSettings settings;
+    vector<ScatterLayer> layers;
+    scatterTestLayers(settings, layers);
+    PoissonScatter scatter;
+    vector<ScatterPoint> reference;
+    scatter.generate(settings, layers, reference);
+    ASSERT_FALSE(reference.empty());
+    for (int threadCount : { 1, 2, 7 }) {
+        ThreadGroup threads(threadCount);
+        for (int run = 0; run < 2; run++) {
+            vector<ScatterPoint> points;
+            scatter.generate(settings, layers, points, &threads);
+            ASSERT_EQ(reference.size(), points.size()) << threadCount << " threads";
+            EXPECT_EQ(0, memcmp(reference.data(), points.data(), points.size() * sizeof(ScatterPoint))) << threadCount << " threads";
+        }
+    }
+    // other code using rand() does not change the result
+    srand(99);
+    MathHelper::RandF();
+    vector<ScatterPoint> points;
+    scatter.generate(settings, layers, points);
+    ASSERT_EQ(reference.size(), points.size());
+    EXPECT_EQ(0, memcmp(reference.data(), points.data(), points.size() * sizeof(ScatterPoint)));
+    // another seed gives another result
+    settings.seed = 4321;
+    scatter.generate(settings, layers, points);
+    EXPECT_FALSE(points.size() == reference.size() && memcmp(reference.data(), points.data(), points.size() * sizeof(ScatterPoint)) == 0);
+}
+
+// 257 x 257 samples over 512m: hills with a steep ridge along x = 0, open only between z = 100 and z = 140,
+// a lake in the south east and a walled off plateau in the north west
+static WalkabilityGrid pathfindingTestGrid() {
+    const int samples = 257;
+    vector<float> h(samples * samples);
+    for (int z = 0; z < samples; z++) {
+        for (int x = 0; x < samples; x++) {
+            float wx = -256.0f + x * 2.0f, wz = -256.0f + z * 2.0f;
+            float height = 20.0f + 5.0f * sin(wx * 0.03f) * cos(wz * 0.02f);
+            if (abs(wx) < 6.0f && (wz < 100.0f || wz > 140.0f)) height += 40.0f;
+            if (wx < -150.0f && wz > 150.0f && (wx > -156.0f || wz < 156.0f)) height += 50.0f;
+            h[z * samples + x] = height;
+        }
+    }
+    WalkabilityGrid grid;
+    grid.init(h, samples, -256.0f, 256.0f);
+    WalkabilitySettings settings;
+    settings.maxSlope = radians(40.0f);
+    settings.waterLevel = 0.0f;
+    grid.deriveWalkability(settings);
+    return grid;
+}
+
+// consecutive nodes are neighbours, walkable and without corner cutting
+static bool isValidGridPath(const WalkabilityGrid& grid, const vector<ivec2>& path) {
+    for (size_t i = 0; i < path.size(); i++) {
+        if (!grid.isWalkable(path[i].x, path[i].y)) return false;
+        if (i == 0) continue;
+        ivec2 d = path[i] - path[i - 1];
+        if (abs(d.x) > 1 || abs(d.y) > 1 || d == ivec2(0)) return false;
+        if (d.x != 0 && d.y != 0 && (!grid.isWalkable(path[i - 1].x + d.x, path[i - 1].y) || !grid.isWalkable(path[i - 1].x, path[i - 1].y + d.y))) return false;
+    }
+    return true;
+}
+
+TEST(Pathfinding, Walkability) {
+    WalkabilityGrid grid = pathfindingTestGrid();
+    EXPECT_EQ(257, grid.getSize());
+    EXPECT_FLOAT_EQ(2.0f, grid.getCellSize());
+    EXPECT_EQ(ivec2(128, 128), grid.toGrid(0.3f, -0.6f));
+    EXPECT_EQ(ivec2(0, 256), grid.toGrid(-1000.0f, 1000.0f));
+    // ridge flanks are too steep, the ridge top is flat and walkable, the gap is open
+    ivec2 flank = grid.toGrid(-6.0f, 0.0f), top = grid.toGrid(0.0f, 0.0f), gap = grid.toGrid(0.0f, 120.0f);
+    EXPECT_FALSE(grid.isWalkable(flank.x, flank.y));
+    EXPECT_TRUE(grid.isWalkable(top.x, top.y));
+    EXPECT_TRUE(grid.isWalkable(gap.x, gap.y));
+    // water
+    WalkabilitySettings settings;
+    settings.waterLevel = 22.0f;
+    WalkabilityGrid wet = pathfindingTestGrid();
+    wet.deriveWalkability(settings);
+    int dry = 0, below = 0;
+    for (int z = 0; z < wet.getSize(); z++) {
+        for (int x = 0; x < wet.getSize(); x++) {
+            if (wet.getHeight(x, z) < 22.0f) {
+                below++;
+                EXPECT_FALSE(wet.isWalkable(x, z));
+            } else if (wet.isWalkable(x, z)) {
+                dry++;
+            }
+        }
+    }
+    EXPECT_GT(below, 1000);
+    EXPECT_GT(dry, 1000);
+    // footprint with margin
+    uint32_t version = grid.getVersion();
+    grid.addFootprint(ObjectBounds{ vec3(50.0f, 0.0f, 50.0f), vec3(60.0f, 10.0f, 54.0f) }, 2.0f);
+    EXPECT_GT(grid.getVersion(), version);
+    ivec2 inside = grid.toGrid(48.0f, 56.0f), outside = grid.toGrid(46.0f, 56.0f);
+    EXPECT_FALSE(grid.isWalkable(inside.x, inside.y));
+    EXPECT_TRUE(grid.isWalkable(outside.x, outside.y));
+    // line of sight
+    EXPECT_TRUE(grid.hasLineOfSight(grid.toGrid(-100.0f, -100.0f), grid.toGrid(-20.0f, -50.0f)));
+    EXPECT_FALSE(grid.hasLineOfSight(grid.toGrid(-100.0f, -100.0f), grid.toGrid(100.0f, -100.0f)));
+}
+
+TEST(Pathfinding, HierarchicalAStar) {
+    WalkabilityGrid grid = pathfindingTestGrid();
+    HierarchicalPathfinder pathfinder;
+    pathfinder.init(&grid, 16);
+    EXPECT_GT(pathfinder.getAbstractNodeCount(), 100u);
+    EXPECT_GT(pathfinder.getAbstractEdgeCount(), pathfinder.getAbstractNodeCount());
+
+    // across the ridge: has to go through the gap
+    ivec2 start = grid.toGrid(-100.0f, -100.0f), goal = grid.toGrid(100.0f, -100.0f);
+    vector<ivec2> path, flat;
+    ASSERT_TRUE(pathfinder.findGridPath(start, goal, path, false));
+    ASSERT_TRUE(isValidGridPath(grid, path));
+    EXPECT_EQ(start, path.front());
+    EXPECT_EQ(goal, path.back());
+    bool throughGap = false;
+    for (auto& p : path) {
+        if (p.x == 128) throughGap = grid.toWorld(p).z > 98.0f && grid.toWorld(p).z < 142.0f;
+    }
+    EXPECT_TRUE(throughGap);
+    ASSERT_TRUE(pathfinder.findGridPathFlat(start, goal, flat));
+    ASSERT_TRUE(isValidGridPath(grid, flat));
+    float optimal = HierarchicalPathfinder::pathLength(flat);
+    EXPECT_GE(HierarchicalPathfinder::pathLength(path), optimal - 1e-3f);
+    EXPECT_LE(HierarchicalPathfinder::pathLength(path), optimal * 1.15f);
+
+    // random queries against plain A*
+    pathfinder.resetStats();
+    uint64_t flatExpansions = 0;
+    int found = 0;
+    for (int i = 0; i < 200; i++) {
+        ivec2 a((int)MathHelper::RandF(0.0f, 256.99f), (int)MathHelper::RandF(0.0f, 256.99f));
+        ivec2 b((int)MathHelper::RandF(0.0f, 256.99f), (int)MathHelper::RandF(0.0f, 256.99f));
+        uint64_t before = pathfinder.getStats().expansions;
+        bool reference = pathfinder.findGridPathFlat(a, b, flat);
+        flatExpansions += pathfinder.getStats().expansions - before;
+        ASSERT_EQ(reference, pathfinder.findGridPath(a, b, path, false)) << "query " << i;
+        if (!reference) continue;
+        found++;
+        ASSERT_TRUE(isValidGridPath(grid, path));
+        EXPECT_LE(HierarchicalPathfinder::pathLength(path), HierarchicalPathfinder::pathLength(flat) * 1.25f + 2.0f) << "query " << i;
+        // smoothed: straight segments with line of sight, never longer
+        vector<ivec2> smooth = path;
+        pathfinder.smoothPath(smooth);
+        EXPECT_EQ(path.front(), smooth.front());
+        EXPECT_EQ(path.back(), smooth.back());
+        EXPECT_LE(smooth.size(), path.size());
+        EXPECT_LE(HierarchicalPathfinder::pathLength(smooth), HierarchicalPathfinder::pathLength(path) + 1e-3f);
+        for (size_t s = 1; s < smooth.size(); s++) {
+            EXPECT_TRUE(grid.hasLineOfSight(smooth[s - 1], smooth[s]));
+        }
+    }
+    EXPECT_GT(found, 100);
+    Log("A* node expansions for 200 queries: HPA* " << pathfinder.getStats().expansions - flatExpansions << ", plain A* " << flatExpansions << endl);
+
+    // walled plateau cannot be reached
+    EXPECT_FALSE(pathfinder.findGridPath(start, grid.toGrid(-200.0f, 200.0f), path));
+    EXPECT_TRUE(path.empty());
+    // world coords, smoothed, heights from the grid
+    vector<vec3> world;
+    ASSERT_TRUE(pathfinder.findPath(vec3(-100.0f, 0.0f, -100.0f), vec3(100.0f, 0.0f, -100.0f), world));
+    EXPECT_GE(world.size(), 3u);
+    EXPECT_FLOAT_EQ(grid.getHeight(start.x, start.y), world.front().y);
+}
+
+TEST(Pathfinding, CacheAndRequestBudget) {
+    WalkabilityGrid grid = pathfindingTestGrid();
+    HierarchicalPathfinder pathfinder;
+    pathfinder.init(&grid, 16, 8);
+    ivec2 start = grid.toGrid(-100.0f, -100.0f), goal = grid.toGrid(100.0f, -100.0f);
+    vector<ivec2> first, second;
+    ASSERT_TRUE(pathfinder.findGridPath(start, goal, first));
+    uint64_t expansions = pathfinder.getStats().expansions;
+    ASSERT_TRUE(pathfinder.findGridPath(start, goal, second));
+    EXPECT_EQ(1u, pathfinder.getStats().cacheHits);
+    EXPECT_EQ(expansions, pathfinder.getStats().expansions);
+    EXPECT_EQ(first, second);
+    // cache is bounded
+    for (int i = 0; i < 20; i++) {
+        pathfinder.findGridPath(start, ivec2(100 + i, 40), first);
+    }
+    EXPECT_EQ(8u, pathfinder.getCachedPathCount());
+    // changed walkability invalidates: block the gap, the ridge cannot be crossed any more
+    for (int z = 0; z < grid.getSize(); z++) {
+        grid.setWalkable(128, z, false);
+    }
+    EXPECT_FALSE(pathfinder.findGridPath(start, goal, first));
+    EXPECT_EQ(0u, pathfinder.getCachedPathCount());
+    // only clusters touched by the wall were searched again, the graph matches a full build
+    EXPECT_GT(pathfinder.getReusedClusterCount(), 0u);
+    HierarchicalPathfinder fresh;
+    fresh.init(&grid, 16, 8);
+    EXPECT_EQ(fresh.getAbstractNodeCount(), pathfinder.getAbstractNodeCount());
+    EXPECT_EQ(fresh.getAbstractEdgeCount(), pathfinder.getAbstractEdgeCount());
+    pathfinder.rebuild();
+    EXPECT_FALSE(pathfinder.findGridPath(start, goal, first));
+    EXPECT_EQ(0u, pathfinder.getCachedPathCount());
+    for (int z = 0; z < grid.getSize(); z++) {
+        grid.setWalkable(128, z, true);
+    }
+    grid.deriveWalkability(WalkabilitySettings{ radians(40.0f), 0.0f });
+    pathfinder.rebuild();
+
+    // many agents: requests are spread over ticks by the expansion budget
+    PathRequestQueue queue;
+    queue.init(&pathfinder);
+    vector<uint32_t> ids;
+    for (int i = 0; i < 100; i++) {
+        vec3 a(MathHelper::RandF(-250.0f, -10.0f), 0.0f, MathHelper::RandF(-250.0f, 250.0f));
+        vec3 b(MathHelper::RandF(10.0f, 250.0f), 0.0f, MathHelper::RandF(-250.0f, 250.0f));
+        ids.push_back(queue.submit(a, b));
+    }
+    const uint64_t budget = 2000;
+    int ticks = 0;
+    uint64_t maxTick = 0;
+    while (queue.getPendingCount() > 0) {
+        uint64_t before = pathfinder.getStats().expansions;
+        uint32_t done = queue.process(budget);
+        EXPECT_GE(done, 1u);
+        maxTick = std::max(maxTick, pathfinder.getStats().expansions - before);
+        ticks++;
+        ASSERT_LT(ticks, 1000);
+    }
+    Log("Path requests: 100 in " << ticks << " ticks, max expansions per tick " << maxTick << endl);
+    EXPECT_GT(ticks, 1);
+    int done = 0;
+    for (uint32_t id : ids) {
+        EXPECT_NE(PathRequestState::Pending, queue.getState(id));
+        if (queue.getState(id) == PathRequestState::Done) {
+            done++;
+            EXPECT_GE(queue.getPath(id).size(), 2u);
+        }
+        queue.release(id);
+    }
+    EXPECT_GT(done, 50);
+    // maxRequests limits requests per tick too
+    for (int i = 0; i < 5; i++) queue.submit(vec3(-100.0f, 0.0f, -100.0f), vec3(-90.0f, 0.0f, -90.0f + i));
+    EXPECT_EQ(2u, queue.process(numeric_limits<uint64_t>::max(), 2));
+    EXPECT_EQ(3u, queue.getPendingCount());
+}
+
+// sound voices mixed by miniaudio's null device, no audio hardware needed
+TEST(Sound, VoicePool) {
+    ShadedPathEngine engine;
+    engine.setEnableSound(true);
+    Sound& sound = engine.sound;
+    sound.init(false, true);
+    ASSERT_TRUE(sound.enabled);
+    SoundId id = sound.openSoundFile(Sound::SHADED_PATH_JINGLE_FILE, Sound::SHADED_PATH_JINGLE, true);
+    sound.setMaxVoices(id, 3);
+    sound.setMaxDistance(id, 100.0f);
+    vec3 near(5.0f, 0.0f, 0.0f), far(500.0f, 0.0f, 0.0f);
+    sound.Update(vec3(0.0f), vec3(0.0f, 0.0f, 1.0f));
+
+    // rapid calls overlap instead of restarting each other
+    SoundVoiceHandle a = sound.playSoundAt(id, near);
+    SoundVoiceHandle b = sound.playSoundAt(id, near);
+    SoundVoiceHandle c = sound.playSoundAt(id, near);
+    EXPECT_EQ(3u, sound.getActiveVoiceCount(id));
+    EXPECT_TRUE(sound.isVoiceActive(a) && sound.isVoiceActive(b) && sound.isVoiceActive(c));
+
+    // limit reached: equal priority steals the oldest, higher priority steals lower, lower priority is rejected
+    SoundVoiceHandle d = sound.playSoundAt(id, near);
+    EXPECT_FALSE(sound.isVoiceActive(a));
+    EXPECT_TRUE(sound.isVoiceActive(d));
+    SoundVoiceHandle important = sound.playSoundAt(id, near, 1.0f, 0, 5);
+    EXPECT_FALSE(sound.isVoiceActive(b));
+    EXPECT_TRUE(sound.isVoiceActive(important));
+    SoundVoiceHandle rejected = sound.playSoundAt(id, near, 1.0f, 0, -1);
+    EXPECT_FALSE(rejected.isValid());
+    EXPECT_EQ(3u, sound.getActiveVoiceCount(id));
+    EXPECT_EQ(2u, sound.getVoiceStats().stolen);
+    EXPECT_EQ(1u, sound.getVoiceStats().rejected);
+
+    // voices out of range are virtual: not mixed, but the playback position keeps running
+    sound.stopVoice(c);
+    EXPECT_FALSE(sound.isVoiceActive(c));
+    SoundVoiceHandle distant = sound.playSoundAt(id, far);
+    EXPECT_TRUE(sound.isVoiceVirtual(distant));
+    // engine time only moves explicitly from here on
+    sound.test_advanceTime(0.1f);
+    float t0 = sound.getVoiceTime(important);
+    sound.setVoicePosition(important, far);
+    sound.Update(vec3(0.0f), vec3(0.0f, 0.0f, 1.0f));
+    EXPECT_TRUE(sound.isVoiceVirtual(important));
+    EXPECT_EQ(2u, sound.getVoiceStats().virtualised);
+    sound.test_advanceTime(0.3f);
+    sound.setVoicePosition(important, near);
+    sound.Update(vec3(0.0f), vec3(0.0f, 0.0f, 1.0f));
+    EXPECT_FALSE(sound.isVoiceVirtual(important));
+    EXPECT_TRUE(sound.isVoiceVirtual(distant));
+    float length = sound.getSoundLength(id);
+    ASSERT_GT(length, 1.0f);
+    float advanced = fmod(sound.getVoiceTime(important) - t0 + length, length);
+    Log("Voice advanced " << advanced << " s while virtual, sound length " << length << " s" << endl);
+    EXPECT_NEAR(0.3f, advanced, 0.01f);
+    sound.getVoiceStats().log();
+}
+
+// many sound ids sharing one clip: decoded once, long clips streamed per voice
+TEST(Sound, ClipCache) {
+    ShadedPathEngine engine;
+    engine.setEnableSound(true);
+    Sound& sound = engine.sound;
+    sound.init(false, true);
+    ASSERT_TRUE(sound.enabled);
+    const int ids = 500;
+    auto start = chrono::high_resolution_clock::now();
+    SoundId first = sound.openSoundFile(Sound::SHADED_PATH_JINGLE_FILE, "clip_0");
+    auto firstLoaded = chrono::high_resolution_clock::now();
+    for (int i = 1; i < ids; i++) {
+        sound.openSoundFile(Sound::SHADED_PATH_JINGLE_FILE, "clip_" + to_string(i));
+    }
+    auto end = chrono::high_resolution_clock::now();
+    EXPECT_EQ(1u, sound.getClipCount());
+    const SoundClip* clip = sound.getClip(first);
+    EXPECT_FALSE(clip->streamed);
+    EXPECT_EQ(ids, (int)clip->refs);
+    EXPECT_EQ(clip->frames * clip->channels * sizeof(float), clip->memoryBytes);
+    EXPECT_EQ(clip->memoryBytes, sound.getDecodedMemory());
+    double firstMS = chrono::duration<double, milli>(firstLoaded - start).count();
+    double moreMS = chrono::duration<double, milli>(end - firstLoaded).count();
+    Log("First load " << firstMS << " ms, " << ids - 1 << " more ids " << moreMS << " ms, decoded "
+        << sound.getDecodedMemory() / 1024 << " KB instead of " << ids * clip->memoryBytes / 1024 << " KB" << endl);
+
+    // voices of different ids play the shared data
+    for (int i = 0; i < 8; i++) {
+        EXPECT_TRUE(sound.playSound("clip_" + to_string(i)).isValid());
+    }
+    EXPECT_EQ(clip->memoryBytes, sound.getDecodedMemory());
+    EXPECT_EQ(0u, sound.getStreamingMemory());
+
+    // streamed clip: only the page buffers of playing voices are resident
+    SoundId music = sound.openSoundFile("loading_music.ogg", "music", true, SoundLoadMode::STREAM);
+    const SoundClip* musicClip = sound.getClip(music);
+    EXPECT_TRUE(musicClip->streamed);
+    EXPECT_EQ(nullptr, musicClip->masound);
+    SoundVoiceHandle m0 = sound.playSound(music, SoundCategory::MUSIC);
+    SoundVoiceHandle m1 = sound.playSound(music, SoundCategory::MUSIC);
+    EXPECT_LT(musicClip->memoryBytes, musicClip->frames * musicClip->channels * sizeof(float));
+    this_thread::sleep_for(chrono::milliseconds(300));
+    EXPECT_GT(sound.getVoiceTime(m0), 0.1f);
+    EXPECT_GT(sound.getVoiceTime(m1), 0.1f);
+    // page buffers are tracked once the streams are loaded
+    sound.Update(vec3(0.0f), vec3(0.0f, 0.0f, 1.0f));
+    EXPECT_EQ(2 * musicClip->memoryBytes, sound.getStreamingMemory());
+    sound.logClipMemory();
+
+    // clip without sound ids is removed from the cache, voices release their page buffers
+    size_t pageBytes = musicClip->memoryBytes;
+    uint64_t hostBytes = engine.memoryTracker.getTotal(MemoryDomain::Host);
+    sound.openSoundFile(Sound::SHADED_PATH_JINGLE_FILE, "music");
+    EXPECT_FALSE(sound.isVoiceActive(m0));
+    EXPECT_FALSE(sound.isVoiceActive(m1));
+    EXPECT_EQ(1u, sound.getClipCount());
+    EXPECT_EQ(0u, sound.getStreamingMemory());
+    EXPECT_EQ(hostBytes - 2 * pageBytes, engine.memoryTracker.getTotal(MemoryDomain::Host));
+}
+
+// scripted flight with uneven frame times, recorded and replayed from the serialized file
+TEST(CameraRecording, DeterministicReplay) {
+    CameraPositioner_FirstPerson fp;
+    fp.init(nullptr, vec3(0.0f, 10.0f, 10.0f), vec3(0.0f), vec3(0.0f, 1.0f, 0.0f));
+    CameraRecorder recorder;
+    for (int i = 0; i < 600; i++) {
+        double delta = (i % 7 == 0) ? 1.0 / 30.0 : 1.0 / 90.0 + (i % 3) * 0.001;
+        fp.movement.forward_ = (i / 100) % 2 == 0;
+        fp.movement.right_ = (i / 150) % 2 == 1;
+        fp.movement.up_ = i > 300 && i < 400;
+        fp.movement.fastSpeed_ = i > 500;
+        vec2 mouse(0.001f * i, 0.0005f * i);
+        fp.update(delta, mouse, i > 200, true);
+        recorder.record(fp, delta, mouse);
+    }
+    vector<byte> file;
+    recorder.serialize(file);
+    EXPECT_EQ(sizeof(uint64_t) * 2 + sizeof(uint32_t) + 600 * CameraRecorder::FRAME_SIZE, file.size());
+    CameraPlayback playback;
+    ASSERT_TRUE(playback.deserialize(file));
+    ASSERT_EQ(recorder.getFrames().size(), playback.getFrames().size());
+    vector<byte> truncated(file.begin(), file.end() - 1);
+    CameraPlayback invalid;
+    EXPECT_FALSE(invalid.deserialize(truncated));
+
+    // recorded steps: exact poses, keys and deltas
+    CameraPositioner_FirstPerson replay;
+    playback.start(CameraPlaybackMode::RecordedSteps);
+    double delta;
+    size_t steps = 0;
+    while (playback.step(replay, delta)) {
+        const CameraRecordFrame& f = recorder.getFrames()[steps];
+        EXPECT_EQ(f.position, replay.getPosition());
+        EXPECT_EQ(f.orientation, replay.getOrientation());
+        EXPECT_EQ(f.deltaSeconds, (float)delta);
+        EXPECT_EQ(f.flags, CameraRecorder::encodeMovement(replay.movement));
+        steps++;
+    }
+    EXPECT_EQ(600u, steps);
+
+    // fixed steps: same path on every run, independent of recorded frame times
+    auto runFixed = [&playback](vector<vec3>& path) {
+        CameraPositioner_FirstPerson cam;
+        double d;
+        playback.start(CameraPlaybackMode::FixedStep, 1.0 / 60.0);
+        while (playback.step(cam, d)) {
+            path.push_back(cam.getPosition());
+        }
+    };
+    vector<vec3> path1, path2;
+    runFixed(path1);
+    runFixed(path2);
+    EXPECT_EQ(path1, path2);
+    EXPECT_EQ(static_cast<size_t>(playback.getDuration() * 60.0) + 1, path1.size());
+    EXPECT_EQ(recorder.getFrames().front().position, path1.front());
+    EXPECT_LT(distance(recorder.getFrames().back().position, path1.back()), 0.1f);
+
+    // frame time report
+    for (int i = 1; i <= 100; i++) {
+        playback.addFrameTime(static_cast<double>(i));
+    }
+    CameraPlaybackStats stats = playback.getStats();
+    EXPECT_EQ(100u, stats.frames);
+    EXPECT_DOUBLE_EQ(50.5, stats.averageMS);
+    EXPECT_DOUBLE_EQ(100.0, stats.maxMS);
+    EXPECT_LE(stats.p50MS, stats.p95MS);
+    EXPECT_LE(stats.p95MS, stats.p99MS);
+    stats.log();
+}
+
+// tagged accounting with keyed allocations, high-water marks and budgets
+TEST(MemoryTracker, TagsPeaksBudgets) {
+    MemoryTracker tracker;
+    int meshKey = 0, textureKey = 0;
+    EXPECT_TRUE(tracker.allocate(MemoryTag::Staging, MemoryDomain::Device, 1000));
+    EXPECT_TRUE(tracker.track(&meshKey, MemoryTag::Mesh, MemoryDomain::Host, 4000));
+    EXPECT_TRUE(tracker.track(&textureKey, MemoryTag::Texture, MemoryDomain::Device, 8000));
+    EXPECT_EQ(9000u, tracker.getTotal(MemoryDomain::Device));
+    EXPECT_EQ(4000u, tracker.getTotal(MemoryDomain::Host));
+
+    // tracking a key again replaces its size
+    EXPECT_TRUE(tracker.track(&meshKey, MemoryTag::Mesh, MemoryDomain::Host, 6000));
+    MemoryTagStats s = tracker.getStats(MemoryTag::Mesh, MemoryDomain::Host);
+    EXPECT_EQ(6000u, s.currentBytes);
+    EXPECT_EQ(6000u, s.peakBytes);
+    EXPECT_EQ(1u, s.allocations);
+    EXPECT_EQ(2u, s.totalAllocations);
+
+    // high-water marks stay after release until reset
+    tracker.release(MemoryTag::Staging, MemoryDomain::Device, 1000);
+    EXPECT_TRUE(tracker.untrack(&textureKey));
+    EXPECT_FALSE(tracker.untrack(&textureKey));
+    EXPECT_FALSE(tracker.isTracked(&textureKey));
+    EXPECT_TRUE(tracker.isTracked(&meshKey));
+    s = tracker.getStats(MemoryTag::Texture, MemoryDomain::Device);
+    EXPECT_EQ(0u, s.currentBytes);
+    EXPECT_EQ(8000u, s.peakBytes);
+    EXPECT_EQ(0u, tracker.getTotal(MemoryDomain::Device));
+    EXPECT_EQ(9000u, tracker.getPeakTotal(MemoryDomain::Device));
+    tracker.resetPeaks();
+    EXPECT_EQ(0u, tracker.getStats(MemoryTag::Texture, MemoryDomain::Device).peakBytes);
+    EXPECT_EQ(0u, tracker.getPeakTotal(MemoryDomain::Device));
+    EXPECT_EQ(6000u, tracker.getPeakTotal(MemoryDomain::Host));
+
+    // warning budget: allocations over budget are reported, but done
+    tracker.setBudget(MemoryTag::Audio, MemoryDomain::Host, 10000);
+    EXPECT_TRUE(tracker.allocate(MemoryTag::Audio, MemoryDomain::Host, 6000));
+    EXPECT_FALSE(tracker.allocate(MemoryTag::Audio, MemoryDomain::Host, 6000));
+    EXPECT_FALSE(tracker.allocate(MemoryTag::Audio, MemoryDomain::Host, 1));
+    s = tracker.getStats(MemoryTag::Audio, MemoryDomain::Host);
+    EXPECT_EQ(12001u, s.currentBytes);
+    EXPECT_EQ(2u, s.overBudget);
+    tracker.release(MemoryTag::Audio, MemoryDomain::Host, 6000);
+    tracker.release(MemoryTag::Audio, MemoryDomain::Host, 1);
+    EXPECT_TRUE(tracker.allocate(MemoryTag::Audio, MemoryDomain::Host, 1000));
+
+    // concurrent allocations from several threads
+    vector<thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&tracker]() {
+            for (int i = 0; i < 1000; i++) {
+                tracker.allocate(MemoryTag::World, MemoryDomain::Host, 16);
+                if (i % 2) tracker.release(MemoryTag::World, MemoryDomain::Host, 16);
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+    s = tracker.getStats(MemoryTag::World, MemoryDomain::Host);
+    EXPECT_EQ(4u * 500u * 16u, s.currentBytes);
+    EXPECT_EQ(2000u, s.allocations);
+    EXPECT_EQ(4000u, s.totalAllocations);
+
+    stringstream dump;
+    tracker.dump(dump);
+    EXPECT_NE(string::npos, dump.str().find("mesh"));
+    EXPECT_NE(string::npos, dump.str().find("budget"));
+    EXPECT_EQ(string::npos, dump.str().find("render target"));
+    tracker.log();
+}
+
+TEST_F(EngineTest, MultiviewSelection) {
+    // per eye UBOs of multiview shaders are std140 array elements, 16 byte aligned
+    EXPECT_EQ(192u, ShaderBase::getMultiviewUBOStride(sizeof(LineShader::UniformBufferObject)));
+    EXPECT_EQ(208u, ShaderBase::getMultiviewUBOStride(sizeof(CubeShader::UniformBufferObject)));
+    EXPECT_EQ(192u + sizeof(LineShader::UniformBufferObject), ShaderBase::getMultiviewUBOSize(sizeof(LineShader::UniformBufferObject)));
+    {
+        ShadedPathEngine engine;
+        engine.setSingleThreadMode(true);
+        engine.setMultiview(true);
+        EXPECT_FALSE(engine.isMultiview()); // only used in stereo mode
+        engine.setStereo(true);
+        EXPECT_TRUE(engine.isMultiview());
+        engine.initGlobal();
+        // still set if the device supports multiview, otherwise engine falls back to one render pass per eye
+        bool multiview = engine.isMultiview();
+        Log("Multiview after device selection: " << multiview << endl);
+        EXPECT_TRUE(engine.isStereo());
+    }
+    LogfileScanner log;
+    EXPECT_GT(log.searchForLine("Stereo rendering: "), -1);
+}
+
+TEST(UI, FrameCache) {
+    // ImGui null backend: no platform or renderer, draw data is only checked on CPU side
+    ImGui::CreateContext();
+    ImGuiIO& io = ImGui::GetIO();
+    io.BackendFlags |= ImGuiBackendFlags_RendererHasTextures;
+    io.IniFilename = nullptr;
+    io.DisplaySize = ImVec2(800, 600);
+    UIFrameCache cache;
+    cache.setUpdateInterval(0.1);
+    int value = 0;
+    auto frame = [&](double now) {
+        if (!cache.needsRebuild(now, std::hash<int>{}(value))) {
+            return false;
+        }
+        io.DeltaTime = 1.0f / 60.0f;
+        ImGui::NewFrame();
+        ImGui::Begin("Cached", nullptr, ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoSavedSettings);
+        ImGui::Text("Value: %d", value);
+        ImGui::End();
+        ImGui::Render();
+        return true;
+    };
+    // first frame and one settle frame are built, then draw data is reused
+    EXPECT_TRUE(frame(0.0));
+    EXPECT_TRUE(frame(0.01));
+    EXPECT_FALSE(frame(0.02));
+    EXPECT_FALSE(frame(0.03));
+    ImDrawData* drawData = ImGui::GetDrawData();
+    ASSERT_NE(nullptr, drawData);
+    EXPECT_TRUE(drawData->Valid);
+    int vertices = drawData->TotalVtxCount;
+    EXPECT_GT(vertices, 0);
+
+    // changed value waits for update interval
+    value = 12345;
+    EXPECT_FALSE(frame(0.05));
+    EXPECT_EQ(vertices, ImGui::GetDrawData()->TotalVtxCount);
+    EXPECT_TRUE(frame(0.12));
+    EXPECT_TRUE(frame(0.13));
+    EXPECT_FALSE(frame(0.14));
+    EXPECT_GT(ImGui::GetDrawData()->TotalVtxCount, vertices);
+
+    // input is handled without waiting
+    io.AddMousePosEvent(700.0f, 500.0f);
+    EXPECT_TRUE(frame(0.15));
+    EXPECT_TRUE(frame(0.16));
+    EXPECT_FALSE(frame(0.17));
+    EXPECT_EQ(6u, cache.getRebuildCount());
+    EXPECT_EQ(5u, cache.getReuseCount());
+
+    // no update interval: every value change is built immediately
+    cache.setUpdateInterval(0.0);
+    value = 1;
+    EXPECT_TRUE(frame(0.18));
+    EXPECT_TRUE(frame(0.19));
+    EXPECT_FALSE(frame(0.20));
+    cache.invalidate();
+    EXPECT_TRUE(frame(0.21));
+    ImGui::DestroyContext();
+}
+
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     // enable single tests